@@ -35,6 +35,10 @@ ifeq ($(__CONFIG_OS_FREERTOS), y)
 #   - 80203: FreeRTOS 8.2.3
 #   - 100201: FreeRTOS 10.2.1
 __CONFIG_OS_FREERTOS_VER ?= 80203
+
+# thread run time stats and scheduler trace, hooked into FreeRTOS built from
+# source (__CONFIG_ROM_FREERTOS=n)
+__CONFIG_OS_TRACE ?= n
 endif
 
 # LiteOS
@@ -50,6 +54,12 @@ __CONFIG_LWIP_V1 ?= y
 #   - 0x02100000: mbed TLS 2.16.0
 __CONFIG_MBEDTLS_VER ?= 0x02100000
 
+# mbed TLS AES/GCM on the crypto engine (mbed TLS 2.16.0 only, needs CE)
+__CONFIG_MBEDTLS_CE_ALT ?= n
+
+# mbed TLS ECDHE-ECDSA key exchange on secp256r1 (mbed TLS 2.16.0 only)
+__CONFIG_MBEDTLS_ECDHE_ECDSA ?= n
+
 # mbuf implementation mode
 #   - mode 0: continuous memory allocated from heap
 #   - mode 1: continuous memory allocated from lwip pbuf
@@ -152,6 +162,10 @@ __CONFIG_SECURE_BOOT ?= n
 # power manager
 __CONFIG_PM ?= y
 
+# pm idle governor, QoS requests and cpu clock scaling, hooked into the
+# tickless idle of FreeRTOS built from source (__CONFIG_ROM_FREERTOS=n)
+__CONFIG_PM_IDLE ?= n
+
 # OTA
 __CONFIG_OTA ?= n
 
@@ -172,6 +186,17 @@ __CONFIG_XPLAYER ?= n
 __CONFIG_JPEG ?= n
 __CONFIG_JPEG_SHARE_64K ?= n
 
+# audio equalizer, y to use the fixed-point EQ built from src/audio/eq,
+# n to use the prebuilt floating-point libeq.a. The fixed-point one is not
+# verified against libeq output yet.
+__CONFIG_AUDIO_EQ_FIXED ?= n
+
+# boot and runtime timeline profiler, see include/util/timeline.h
+__CONFIG_TIMELINE ?= n
+
+# FatFS write-back sector cache with read-ahead under the SD and RAM disks
+__CONFIG_FATFS_BLKCACHE ?= y
+
 # mix sram/psram heap manager
 ifeq ($(__CONFIG_MALLOC_USE_STDLIB), y)
   ifeq ($(__CONFIG_PSRAM), y)
@@ -233,6 +258,7 @@ __CONFIG_LMAC_HEAP_MODE ?= 0
 __CONFIG_CEDARX_HEAP_MODE ?= 1
 __CONFIG_AUDIO_HEAP_MODE ?= 1
 __CONFIG_CODEC_HEAP_MODE ?= 1
+__CONFIG_FATFS_HEAP_MODE ?= 1
 else
 __CONFIG_MBUF_HEAP_MODE := 0
 __CONFIG_MBEDTLS_HEAP_MODE := 0
@@ -245,6 +271,7 @@ __CONFIG_LMAC_HEAP_MODE := 0
 __CONFIG_CEDARX_HEAP_MODE := 0
 __CONFIG_AUDIO_HEAP_MODE := 0
 __CONFIG_CODEC_HEAP_MODE := 0
+__CONFIG_FATFS_HEAP_MODE := 0
 endif
 
 ifeq ($(__CONFIG_PSRAM), y)
@@ -290,6 +317,9 @@ endif
 ifeq ($(__CONFIG_OS_FREERTOS), y)
   CONFIG_SYMBOLS += -D__CONFIG_OS_FREERTOS
   CONFIG_SYMBOLS += -D__CONFIG_OS_FREERTOS_VER=$(__CONFIG_OS_FREERTOS_VER)
+  ifeq ($(__CONFIG_OS_TRACE), y)
+    CONFIG_SYMBOLS += -D__CONFIG_OS_TRACE
+  endif
 endif
 
 ifeq ($(__CONFIG_OS_LITEOS), y)
@@ -302,6 +332,14 @@ endif
 
 CONFIG_SYMBOLS += -D__CONFIG_MBEDTLS_VER=$(__CONFIG_MBEDTLS_VER)
 
+ifeq ($(__CONFIG_MBEDTLS_CE_ALT), y)
+  CONFIG_SYMBOLS += -D__CONFIG_MBEDTLS_CE_ALT
+endif
+
+ifeq ($(__CONFIG_MBEDTLS_ECDHE_ECDSA), y)
+  CONFIG_SYMBOLS += -D__CONFIG_MBEDTLS_ECDHE_ECDSA
+endif
+
 CONFIG_SYMBOLS += -D__CONFIG_MBUF_IMPL_MODE=$(__CONFIG_MBUF_IMPL_MODE)
 
 ifeq ($(__CONFIG_WLAN), y)
@@ -399,6 +437,9 @@ endif
 
 ifeq ($(__CONFIG_PM), y)
   CONFIG_SYMBOLS += -D__CONFIG_PM
+  ifeq ($(__CONFIG_PM_IDLE), y)
+    CONFIG_SYMBOLS += -D__CONFIG_PM_IDLE
+  endif
 endif
 
 ifeq ($(__CONFIG_OTA), y)
@@ -432,6 +473,14 @@ ifeq ($(__CONFIG_JPEG_SHARE_64K), y)
   CONFIG_SYMBOLS += -D__CONFIG_JPEG_SHARE_64K
 endif
 
+ifeq ($(__CONFIG_FATFS_BLKCACHE), y)
+  CONFIG_SYMBOLS += -D__CONFIG_FATFS_BLKCACHE
+endif
+
+ifeq ($(__CONFIG_TIMELINE), y)
+  CONFIG_SYMBOLS += -D__CONFIG_TIMELINE
+endif
+
 ifeq ($(__CONFIG_MIX_HEAP_MANAGE), y)
   CONFIG_SYMBOLS += -D__CONFIG_MIX_HEAP_MANAGE
 endif
@@ -450,6 +499,7 @@ CONFIG_SYMBOLS += -D__CONFIG_LMAC_HEAP_MODE=$(__CONFIG_LMAC_HEAP_MODE)
 CONFIG_SYMBOLS += -D__CONFIG_CEDARX_HEAP_MODE=$(__CONFIG_CEDARX_HEAP_MODE)
 CONFIG_SYMBOLS += -D__CONFIG_AUDIO_HEAP_MODE=$(__CONFIG_AUDIO_HEAP_MODE)
 CONFIG_SYMBOLS += -D__CONFIG_CODEC_HEAP_MODE=$(__CONFIG_CODEC_HEAP_MODE)
+CONFIG_SYMBOLS += -D__CONFIG_FATFS_HEAP_MODE=$(__CONFIG_FATFS_HEAP_MODE)
 
 ifeq ($(__CONFIG_PSRAM_ALL_CACHEABLE), y)
   CONFIG_SYMBOLS += -D__CONFIG_PSRAM_ALL_CACHEABLE
@@ -57,6 +57,18 @@ extern s32 at_queue_init(void *buf, s32 size, at_queue_callback_t cb);
 extern AT_QUEUE_ERROR_CODE at_queue_get(u8 *element);
 extern AT_QUEUE_ERROR_CODE at_queue_peek(u8 *element);
 
+/*
+ * Bulk access for data mode. at_queue_get_span() returns the number of
+ * contiguous bytes readable at *span (refilling the queue from the source
+ * when it is empty, 0 if nothing arrived), at_queue_consume() drops bytes
+ * from the head once they have been used. at_queue_read() copies up to
+ * @size bytes and returns the number copied, it stops early when the
+ * source has no more data.
+ */
+extern s32 at_queue_get_span(u8 **span);
+extern void at_queue_consume(s32 len);
+extern s32 at_queue_read(u8 *buf, s32 size);
+
 #ifdef __cplusplus
 }
 #endif
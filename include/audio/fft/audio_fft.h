@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _AUDIO_FFT_H_
+#define _AUDIO_FFT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed-point FFT, Q15 and Q31.
+ *
+ * Decimation in frequency with radix-4 butterflies (radix-2^2, so the
+ * output is in plain bit-reversed order) and one radix-2 stage when log2(N)
+ * is odd. Each stage scales by its radix, the result is X[k] / N. Twiddle
+ * and bit-reverse tables are generated by audio_fft_create() for one size.
+ *
+ * Complex data is interleaved re, im. A real plan of N points runs an N/2
+ * complex FFT on the even/odd samples and splits the result, its output
+ * holds the N/2 + 1 bins of the half spectrum packed in N values:
+ *   { X[0].re, X[N/2].re, X[1].re, X[1].im, ..., X[N/2-1].re, X[N/2-1].im }
+ */
+
+#define AUDIO_FFT_MIN_POINTS		4
+#define AUDIO_FFT_MAX_POINTS		4096	/* complex, twice that for real */
+
+/* audio_fft_create() flags */
+#define AUDIO_FFT_REAL			(1U << 0)	/* real input */
+#define AUDIO_FFT_Q15			(1U << 1)	/* build the Q15 tables */
+#define AUDIO_FFT_Q31			(1U << 2)	/* build the Q31 tables */
+
+/* audio_fft_db() result for a zero power */
+#define AUDIO_FFT_DB_FLOOR		(-200 * 256)
+
+typedef struct audio_fft audio_fft_t;
+
+/**
+ * @brief Create a FFT plan
+ * @param[in] points Transform size, power of 2
+ * @param[in] flags AUDIO_FFT_REAL, and AUDIO_FFT_Q15 and/or AUDIO_FFT_Q31
+ *                  for the arithmetic to be used
+ * @return Pointer to the plan, NULL on invalid size or no memory
+ */
+audio_fft_t *audio_fft_create(uint32_t points, uint32_t flags);
+
+void audio_fft_destroy(audio_fft_t *fft);
+
+/* Number of spectrum bins: N for a complex plan, N/2 + 1 for a real one */
+uint32_t audio_fft_bins(audio_fft_t *fft);
+
+/**
+ * @brief Forward transform in place
+ * @param[in,out] data N complex values (complex plan) or N real samples
+ *                     (real plan, packed spectrum on return)
+ *
+ * @note Complex input must stay within the unit circle (|x| <= 1.0), real
+ *       input may use the full range.
+ */
+void audio_fft_q15(audio_fft_t *fft, int16_t *data);
+void audio_fft_q31(audio_fft_t *fft, int32_t *data);
+
+/**
+ * @brief Power of each bin, re^2 + im^2
+ * @param[in] spec Output of audio_fft_q15() / audio_fft_q31()
+ * @param[out] power audio_fft_bins() values, Q30 / Q62
+ */
+void audio_fft_power_q15(audio_fft_t *fft, const int16_t *spec, uint32_t *power);
+void audio_fft_power_q31(audio_fft_t *fft, const int32_t *spec, uint64_t *power);
+
+/**
+ * @brief 10 * log10(power / 2^frac_bits), integer only
+ * @return dB in Q8 (1/256 dB), within 0.01 dB, AUDIO_FFT_DB_FLOOR for 0
+ *
+ * @note Magnitude dB (20 * log10(|X|)) is the dB of the power.
+ */
+int32_t audio_fft_db(uint64_t power, uint32_t frac_bits);
+
+/* Magnitude of a bin from its power, floor(sqrt(power)) */
+uint32_t audio_fft_mag(uint64_t power);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AUDIO_FFT_H_ */
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _AUDIO_RESAMPLE_H_
+#define _AUDIO_RESAMPLE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Windowed-sinc polyphase sample rate converter for interleaved 16-bit PCM.
+ *
+ * The ratio out_rate/in_rate is reduced to L/M, the prototype filter is
+ * designed for the L-times upsampled rate and split into L phases, one per
+ * output position between two input samples. All tables are generated by
+ * audio_resample_create(), processing only uses integer arithmetic.
+ */
+
+/* Largest number of phases (L after reduction) */
+#define AUDIO_RESAMPLE_MAX_PHASES	512
+
+/*
+ * Taps per phase when upsampling, scaled by M/L when downsampling.
+ * The coefficient table takes L * taps * 2 bytes, eg. 28 KB for 16k->44.1k
+ * with 32 taps.
+ */
+#if (__CONFIG_AUDIO_HEAP_MODE == 1)
+#define AUDIO_RESAMPLE_TAPS		32
+#else
+#define AUDIO_RESAMPLE_TAPS		16
+#endif
+
+typedef struct audio_resample audio_resample_t;
+
+/**
+ * @brief Create a resampler
+ * @param[in] in_rate Input sample rate in Hz
+ * @param[in] out_rate Output sample rate in Hz
+ * @param[in] channels 1 or 2, samples are interleaved
+ * @return Pointer to the resampler, NULL if the ratio is not supported
+ *         (more than AUDIO_RESAMPLE_MAX_PHASES phases) or on no memory
+ */
+audio_resample_t *audio_resample_create(uint32_t in_rate, uint32_t out_rate,
+                                        uint8_t channels);
+
+void audio_resample_destroy(audio_resample_t *rs);
+
+/* Clear the history, eg. after a seek */
+void audio_resample_reset(audio_resample_t *rs);
+
+/* Largest number of frames audio_resample_process() may output for @in_frames */
+uint32_t audio_resample_out_frames(audio_resample_t *rs, uint32_t in_frames);
+
+/**
+ * @brief Convert a block of samples
+ * @param[in] in Interleaved input samples
+ * @param[in] in_frames Number of input frames, all of them are consumed
+ * @param[out] out Interleaved output samples, room for at least
+ *                 audio_resample_out_frames(rs, in_frames) frames
+ * @return Number of frames written to @out
+ *
+ * @note The stream state is kept between calls, blocks of any size can be
+ *       passed. The filter delays the signal by about AUDIO_RESAMPLE_TAPS/2
+ *       samples of the lower of the two rates.
+ */
+uint32_t audio_resample_process(audio_resample_t *rs, const int16_t *in,
+                                uint32_t in_frames, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AUDIO_RESAMPLE_H_ */
@@ -72,6 +72,9 @@ typedef struct cJSON
 
     /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
     char *string;
+
+    /* Hash index of an object's members, only set by cJSON_ParseInSitu and dropped when the members change. */
+    struct cjson_index *index;
 } cJSON;
 
 typedef struct cJSON_Hooks
@@ -157,6 +160,15 @@ The item->next and ->prev pointers are always zero on return from Duplicate. */
 /* If you supply a ptr in return_parse_end and parsing fails, then return_parse_end will contain a pointer to the error. If not, then cJSON_GetErrorPtr() does the job. */
 extern cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, int require_null_terminated);
 
+/* Objects parsed by cJSON_ParseInSitu with at least this many members get a hash index for cJSON_GetObjectItem. */
+#define CJSON_INDEX_MIN 8
+/* Parse without any allocation: all items are placed in the size bytes at buffer, and strings are unescaped in place
+ * inside value and point into it. Returns NULL on parse error or when the buffer is too small (about 40 bytes per
+ * item on 32-bit targets, plus the indexes); used, if not NULL, receives the bytes consumed. The tree must be treated as read only
+ * and must not be passed to cJSON_Delete: it is gone when buffer or value is released or reused. Adding, detaching or replacing
+ * members of an object drops its index, lookups then walk the members. */
+extern cJSON *cJSON_ParseInSitu(char *value, void *buffer, size_t size, size_t *used);
+
 extern void cJSON_Minify(char *json);
 
 /* Macros for creating things quickly. */
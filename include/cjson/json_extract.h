@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _JSON_EXTRACT_H_
+#define _JSON_EXTRACT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Streaming JSON field extractor.
+ *
+ * Pulls a few values out of a JSON document in one pass, without building
+ * a tree and without any heap. The document can be passed at once or fed
+ * in pieces as it arrives. Each wanted value is named by a path of object
+ * keys and array indexes, eg. "data.resources.mqtt.host", "params.list[2]"
+ * or "params.list.2". Keys are matched case sensitively, or ignoring ASCII
+ * case like cJSON_GetObjectItem() when the field sets JSON_EXTRACT_NOCASE.
+ *
+ * Strings are stored unescaped, numbers and literals as written, objects
+ * and arrays as their raw text. Values longer than the field buffer are
+ * truncated and flagged.
+ */
+
+#define JSON_EXTRACT_DEPTH_MAX		16	/* nesting levels */
+#define JSON_EXTRACT_KEY_MAX		32	/* longest key a path can match */
+#define JSON_EXTRACT_LITERAL_MAX	32	/* longest number */
+
+typedef enum {
+	JSON_EXTRACT_NONE = 0,
+	JSON_EXTRACT_STRING,
+	JSON_EXTRACT_NUMBER,
+	JSON_EXTRACT_TRUE,
+	JSON_EXTRACT_FALSE,
+	JSON_EXTRACT_NULL,
+	JSON_EXTRACT_OBJECT,
+	JSON_EXTRACT_ARRAY,
+} json_extract_type;
+
+/* json_extract_field.flags */
+#define JSON_EXTRACT_FOUND		(1 << 0)
+#define JSON_EXTRACT_TRUNCATED		(1 << 1)
+#define JSON_EXTRACT_NOCASE		(1 << 7)	/* set by the caller */
+
+typedef struct {
+	const char *path;	/* in: path of the value */
+	char *buf;		/* in: where to store the value, NUL terminated */
+	uint16_t size;		/* in: size of buf */
+	uint16_t len;		/* out: bytes stored, without the NUL */
+	uint8_t type;		/* out: json_extract_type */
+	uint8_t flags;		/* in: NOCASE, out: FOUND/TRUNCATED */
+	/* private */
+	uint8_t nseg;
+	uint8_t matched;	/* path segments matched by the current position */
+	uint8_t capture;	/* depth + 1 of the value being stored, 0 if none */
+} json_extract_field;
+
+/* json_extract_feed() return values */
+#define JSON_EXTRACT_MORE		0	/* need more input */
+#define JSON_EXTRACT_DONE		1	/* all fields found or document ended */
+#define JSON_EXTRACT_ERROR		(-1)	/* syntax error or limit exceeded */
+
+typedef struct {
+	json_extract_field *fields;
+	uint8_t nfields;
+	uint8_t remain;		/* fields not found yet */
+	uint8_t state;
+	uint8_t ret_state;	/* state to resume after a string */
+	uint8_t depth;
+	uint8_t key_len;
+	uint8_t lit_len;
+	uint8_t hex_len;
+	uint8_t raw;		/* fields storing an object/array */
+	uint8_t copy;		/* fields storing a string */
+	uint16_t hex;		/* \u escape being decoded */
+	uint16_t surrogate;	/* pending high surrogate */
+	uint32_t stack;		/* bit n set: level n is an array */
+	uint16_t index[JSON_EXTRACT_DEPTH_MAX];
+	char key[JSON_EXTRACT_KEY_MAX];
+	char lit[JSON_EXTRACT_LITERAL_MAX];
+} json_extract_t;
+
+/**
+ * @brief Start a new document
+ * @param[in] ctx Extractor state, usually on the stack
+ * @param[in] fields Values to extract, path/buf/size set by the caller
+ * @param[in] nfields Number of fields, at most 255
+ */
+void json_extract_init(json_extract_t *ctx, json_extract_field *fields, int nfields);
+
+/**
+ * @brief Feed the next piece of the document
+ * @return JSON_EXTRACT_MORE, JSON_EXTRACT_DONE or JSON_EXTRACT_ERROR
+ *
+ * @note Once DONE or ERROR is returned, later calls return the same.
+ */
+int json_extract_feed(json_extract_t *ctx, const char *data, size_t len);
+
+/**
+ * @brief Extract fields from a complete buffer
+ * @return Number of fields found, JSON_EXTRACT_ERROR on a syntax error.
+ *         A truncated document returns the fields completed before its end.
+ */
+int json_extract(const char *data, size_t len, json_extract_field *fields, int nfields);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _JSON_EXTRACT_H_ */
@@ -38,6 +38,7 @@
 #include "driver/chip/hal_def.h"
 #include "driver/chip/hal_ccm.h"
 #include "driver/chip/hal_gpio.h"
+#include "jpeg/jpeg_rc.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -510,6 +511,7 @@ typedef struct {
 
 	uint8_t 		mem_part_en;
 	JPEG_MemPartNum mem_part_num;
+	uint8_t			mem_part_hold;	/* parts are taken back by HAL_JPEG_MpartRelease() */
 
 	uint32_t		quality;
 } JPEG_ConfigParam;
@@ -572,6 +574,12 @@ HAL_Status HAL_JPEG_Config(JPEG_ConfigParam *cfg);
 void HAL_JPEG_Reset(void);
 void HAL_JPEG_WriteHeader(uint8_t *baseAddr);
 
+HAL_Status HAL_JPEG_SetQuality(uint32_t quality);
+uint32_t HAL_JPEG_GetQuality(void);
+HAL_Status HAL_JPEG_SetRateCtrl(const JpegRcParam *param);
+void HAL_JPEG_SetRateCtrlBacklog(uint32_t bytes);
+void HAL_JPEG_MpartRelease(JPEG_MpartBuffInfo *info);
+
 #endif /* (__CONFIG_CHIP_ARCH_VER == 2) */
 
 #ifdef __cplusplus
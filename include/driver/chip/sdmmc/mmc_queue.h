@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _DRIVER_CHIP_SDMMC_MMC_QUEUE_H_
+#define _DRIVER_CHIP_SDMMC_MMC_QUEUE_H_
+
+#include "driver/chip/sdmmc/card.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Asynchronous block I/O on an SD card.
+ *
+ * Requests are queued and issued in order by a worker thread. Adjacent
+ * requests in the same direction are merged into one multi-block command,
+ * and the next command is prepared while the card is still programming the
+ * previous write, so the submitter never waits for the card.
+ */
+
+/* Max segments of one request */
+#define MMC_QUEUE_SEG_MAX               32
+
+/* Multi-block writes of at least this many blocks are sent with a pre-erase hint */
+#define MMC_QUEUE_PRE_ERASE_MIN         8
+
+/* Max time the card may hold the busy signal after a write */
+#define MMC_QUEUE_BUSY_TIMEOUT_MS       1000
+
+#define MMC_QUEUE_F_MERGE               (1 << 0)    /* merge adjacent requests */
+#define MMC_QUEUE_F_SBC                 (1 << 1)    /* CMD23 before multi-block commands, if the card supports it */
+#define MMC_QUEUE_F_PRE_ERASE           (1 << 2)    /* ACMD23 before multi-block writes otherwise */
+#define MMC_QUEUE_F_DEFAULT             (MMC_QUEUE_F_MERGE | MMC_QUEUE_F_SBC | MMC_QUEUE_F_PRE_ERASE)
+
+/* Segment of a request, @len must be a multiple of 512 */
+struct mmc_queue_seg {
+	void *buf;
+	uint32_t len;
+};
+
+struct mmc_queue_req;
+
+/* Called from the worker thread once the request is done, @err is 0 on success */
+typedef void (*mmc_queue_done_t)(struct mmc_queue_req *req, int32_t err);
+
+/* Owned by the caller, and must not be touched until @done is called */
+struct mmc_queue_req {
+	uint32_t sblk;                  /* start block */
+	uint32_t nblk;                  /* number of blocks */
+	uint8_t write;
+	uint8_t seg_cnt;
+	struct mmc_queue_seg *seg;
+	mmc_queue_done_t done;
+	void *arg;                      /* for the caller */
+
+	/* used by the queue */
+	struct mmc_queue_req *next;
+	int32_t err;
+};
+
+struct mmc_queue_stats {
+	uint32_t req;                   /* requests completed */
+	uint32_t cmd;                   /* data commands issued */
+	uint32_t blocks;                /* blocks transferred */
+	uint32_t merged;                /* requests merged into a previous command */
+	uint32_t sbc;                   /* CMD23 sent */
+	uint32_t pre_erase;             /* ACMD23 sent */
+	uint32_t busy_max;              /* longest busy after a write, in us */
+	uint32_t busy_sleep;            /* busy waits long enough to sleep */
+	uint32_t err;                   /* failed commands */
+};
+
+struct mmc_queue;
+
+/**
+ * @brief Create a request queue and its worker thread on an opened card
+ * @param[in] card The card, it must stay opened while the queue exists
+ * @param[in] flags MMC_QUEUE_F_XXX
+ * @param[in] prio Priority of the worker thread
+ * @return Pointer to the queue, NULL on failure
+ */
+struct mmc_queue *mmc_queue_create(struct mmc_card *card, uint32_t flags, uint32_t prio);
+
+/* Complete all queued requests and delete the queue */
+void mmc_queue_destroy(struct mmc_queue *q);
+
+/**
+ * @brief Queue a request
+ * @param[in] q The queue
+ * @param[in] req The request, @done may be NULL
+ * @retval 0 if queued, -1 if the request is invalid
+ *
+ * @note Segments may be anywhere in memory. Buffers that are 4 bytes aligned
+ *       and not cacheable are transferred by DMA in place.
+ *       A request with @nblk 0 is a barrier, it is done once all requests
+ *       queued before are, with -1 if any of them failed since the previous
+ *       barrier.
+ */
+int32_t mmc_queue_submit(struct mmc_queue *q, struct mmc_queue_req *req);
+
+/**
+ * @brief Wait until all requests queued before are done
+ * @retval 0 if all of them succeeded since the previous barrier, -1 otherwise
+ */
+int32_t mmc_queue_flush(struct mmc_queue *q);
+
+/* Synchronous access through the queue, ordered with the queued requests */
+int32_t mmc_queue_read(struct mmc_queue *q, uint8_t *buf, uint32_t sblk, uint32_t nblk);
+int32_t mmc_queue_write(struct mmc_queue *q, const uint8_t *buf, uint32_t sblk, uint32_t nblk);
+
+void mmc_queue_get_stats(struct mmc_queue *q, struct mmc_queue_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DRIVER_CHIP_SDMMC_MMC_QUEUE_H_ */
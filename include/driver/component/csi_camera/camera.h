@@ -84,6 +84,7 @@ typedef struct {
 	uint32_t jpeg_clk;
 	uint32_t memPartEn;
 	uint32_t memPartNum;
+	uint32_t memPartHold;	/* mem parts are given back by HAL_CAMERA_MpartRelease() */
 	uint32_t quality;
 	uint32_t width;
 	uint32_t height;
@@ -128,4 +129,17 @@ uint32_t HAL_CAMERA_CaptureVideoData(CAMERA_JpegBuffInfo *info);
 
 int HAL_CAMERA_IoCtl(CAMERA_IoctrlCmd cmd, uint32_t arg);
 
+int HAL_CAMERA_SetQuality(uint32_t quality);
+int HAL_CAMERA_SetRateCtrl(const JpegRcParam *param);
+void HAL_CAMERA_MpartRelease(CAMERA_MpartBuffInfo *info);
+
+/* Called from the capture interrupt with CAMERA_STATUS_MPART and
+ * CAMERA_STATUS_EXCP before the user callback, a mem part it returns
+ * nonzero for is kept and released by it, the user callback does not see it. */
+typedef int (*CAMERA_MpartHook)(CAMERA_CapStatus status, CAMERA_MpartBuffInfo *info,
+                                CAMERA_Mgmt *mgmt);
+
+int CAMERA_SetMpartHook(CAMERA_MpartHook hook);
+uint32_t CAMERA_GetMpartSize(void);
+
 #endif
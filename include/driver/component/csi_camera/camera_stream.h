@@ -0,0 +1,71 @@
+/**
+  * @file  camera_stream.h
+  * @author  XRADIO IOT WLAN Team
+  */
+
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#ifndef _CAMERA_STREAM_H_
+#define _CAMERA_STREAM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * MJPEG over HTTP from the encoder mem parts, without copying the frames.
+ * Needs the camera configured with memPartEn and memPartHold; the parts of
+ * the frames that are streamed are released by the stream, the others still
+ * go to the camera callback.
+ */
+
+typedef struct {
+	uint16_t port;			/* http port, 0: 80 */
+	uint32_t max_backlog;	/* unacked bytes above which frames are skipped, 0: default */
+} CAMERA_StreamCfg;
+
+typedef struct {
+	uint32_t clients;
+	uint32_t frames;		/* frames sent */
+	uint32_t skipped;		/* frames dropped while the client was behind */
+	uint32_t bytes;			/* bytes acked by the client */
+} CAMERA_StreamStats;
+
+int HAL_CAMERA_StreamStart(const CAMERA_StreamCfg *cfg);
+void HAL_CAMERA_StreamStop(void);
+int HAL_CAMERA_StreamGetStats(CAMERA_StreamStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CAMERA_STREAM_H_ */
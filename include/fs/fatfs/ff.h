@@ -122,6 +122,10 @@ typedef struct {
 	DWORD	dirbase;		/* Root directory base sector/cluster */
 	DWORD	database;		/* Data base sector */
 	DWORD	winsect;		/* Current sector appearing in the win[] */
+#if _USE_CLIDX
+	struct _CLIDX* clidx[_CLIDX_FILES];	/* Cluster indexes of open files (allocated on demand) */
+	DWORD	clidx_stamp;	/* Cluster index usage counter */
+#endif
 	BYTE	win[_MAX_SS];	/* Disk access window for Directory, FAT (and file data at tiny cfg) */
 } FATFS;
 
@@ -300,11 +304,11 @@ DWORD get_fattime (void);
 #if _USE_LFN != 0						/* Unicode - OEM code conversion */
 WCHAR ff_convert (WCHAR chr, UINT dir);	/* OEM-Unicode bidirectional conversion */
 WCHAR ff_wtoupper (WCHAR chr);			/* Unicode upper-case conversion */
-#if _USE_LFN == 3						/* Memory functions */
+#endif
+#if _USE_LFN == 3 || _USE_CLIDX			/* Memory functions */
 void* ff_memalloc (UINT msize);			/* Allocate memory block */
 void ff_memfree (void* mblock);			/* Free memory block */
 #endif
-#endif
 
 /* Sync functions */
 #if _FS_REENTRANT
@@ -47,6 +47,20 @@
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 
+#ifndef _USE_CLIDX
+#define	_USE_CLIDX		1
+#endif
+#define	_CLIDX_FILES	4
+#define	_CLIDX_SIZE		32
+/* This option switches the automatic cluster index for f_lseek(). (0:Disable or 1:Enable)
+/  When enabled, seeking records the fragments of the cluster chain it walks through,
+/  so that later seeks start from the nearest known cluster instead of the top of
+/  the file. Up to _CLIDX_FILES files per volume get an index of _CLIDX_SIZE
+/  fragments, allocated on demand with ff_memalloc() and released on unmount.
+/  A file more fragmented than _CLIDX_SIZE keeps evenly spaced samples of its chain.
+/  Unlike _USE_FASTSEEK, it needs no help from the application and files may grow. */
+
+
 #define	_USE_EXPAND		0
 /* This option switches f_expand function. (0:Disable or 1:Enable) */
 
@@ -0,0 +1,68 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifndef _JPEG_RC_H_
+#define _JPEG_RC_H_
+
+#include <stdint.h>
+
+/*
+ * Frame size / bitrate control for the JPEG encoder.
+ *
+ * After each frame the controller is given the encoded size and returns the
+ * quality for the next one. Frame size is modelled as complexity / scale,
+ * scale being the IJG quantiser scale of jpeg_set_quant_tbl(), and the
+ * complexity is measured again on every frame, so a scene change is
+ * corrected on the next frame. It only does integer arithmetic and depends
+ * on nothing but this header, which keeps it usable from interrupt context
+ * and testable on a host against recorded frame size traces.
+ */
+
+typedef enum {
+	JPEG_RC_OFF,
+	JPEG_RC_FRAME_SIZE,		/* keep every frame near target bytes */
+	JPEG_RC_BITRATE,		/* keep the average near target bit/s */
+} JpegRcMode;
+
+typedef struct {
+	JpegRcMode	mode;
+	uint32_t	target;		/* bytes per frame, or bit/s */
+	uint32_t	fps;		/* frame rate, JPEG_RC_BITRATE only */
+	uint32_t	max_size;	/* bytes, larger frames do not fit the output buffer, 0: no limit */
+	uint8_t		quality;	/* quality of the first frame */
+	uint8_t		min_quality;
+	uint8_t		max_quality;
+	uint8_t		max_step;	/* largest quality raise per frame, 0: no limit */
+} JpegRcParam;
+
+typedef struct {
+	JpegRcParam	param;
+	uint32_t	budget;		/* bytes per frame from the target */
+	int32_t		debt;		/* JPEG_RC_BITRATE: bytes spent above the budget */
+	uint32_t	backlog;	/* bytes the consumer has not sent yet */
+	uint32_t	scale;		/* quantiser scale of the current quality */
+	uint8_t		quality;	/* quality of the frame being encoded */
+
+	uint32_t	frames;
+	uint32_t	oversize;	/* frames larger than max_size */
+} JpegRc;
+
+#define JPEG_RC_SCALE_MAX	(5000)
+
+void JpegRcInit(JpegRc *rc, const JpegRcParam *param);
+
+/* Account one encoded frame, returns the quality of the next one */
+int JpegRcUpdate(JpegRc *rc, uint32_t size);
+
+/* Bytes queued by the consumer, the target shrinks until they are sent */
+void JpegRcSetBacklog(JpegRc *rc, uint32_t bytes);
+
+int JpegQualityToScale(int quality);
+int JpegScaleToQuality(int scale);
+
+#endif /* _JPEG_RC_H_ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
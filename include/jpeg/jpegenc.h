@@ -24,6 +24,7 @@ struct jpeg_ctl_ops {
 	void (*writeHeader)(void *handle);
 	int  (*setParameter)(void *handle, int indexType, void *param);
 	void  (*setQuantTbl)(void *handle, int quality);
+	void (*writeQuantTbl)(void *handle); /* rewrite the DQT of a header at BaseAddr */
 };
 
 typedef struct JpegCtx {
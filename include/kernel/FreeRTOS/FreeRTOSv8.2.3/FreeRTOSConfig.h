@@ -209,6 +209,52 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 
 /* A header file that defines trace macro can be included here. */
 
+/* Idle governor and cpu clock governor of pm, see "pm/pm_idle.h" */
+#if (defined(__CONFIG_PM) && defined(__CONFIG_PM_IDLE) && !defined(__CONFIG_ROM_FREERTOS))
+extern void pm_idle_suspend_ticks(uint32_t expected_ticks);
+extern void pm_idle_task_switched_in(int idle);
+
+#undef  configUSE_TICK_HOOK
+#define configUSE_TICK_HOOK                     1
+#undef  INCLUDE_xTaskGetIdleTaskHandle
+#define INCLUDE_xTaskGetIdleTaskHandle          1
+
+#define portSUPPRESS_TICKS_AND_SLEEP(xExpectedIdleTime) pm_idle_suspend_ticks(xExpectedIdleTime)
+#define PM_IDLE_TASK_SWITCHED_IN() pm_idle_task_switched_in(pxCurrentTCB == xIdleTaskHandle)
+#else
+#define PM_IDLE_TASK_SWITCHED_IN()
+#endif
+
+/* Thread run time stats and scheduler trace, see "kernel/os/os_trace.h" */
+#if (defined(__CONFIG_OS_TRACE) && !defined(__CONFIG_ROM_FREERTOS) && !defined(__CONFIG_BOOTLOADER))
+extern uint32_t OS_TraceClock(void);
+extern void OS_TraceTaskCreate(uint32_t num, uint32_t prio, const char *name);
+extern void OS_TraceTaskReady(uint32_t num, uint32_t prio);
+extern void OS_TraceTaskSwitchedIn(uint32_t num, uint32_t prio);
+
+#undef  configGENERATE_RUN_TIME_STATS
+#define configGENERATE_RUN_TIME_STATS           1
+#undef  portCONFIGURE_TIMER_FOR_RUN_TIME_STATS
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#undef  portGET_RUN_TIME_COUNTER_VALUE
+#define portGET_RUN_TIME_COUNTER_VALUE()        OS_TraceClock()
+
+#define traceTASK_CREATE(pxNewTCB) \
+	OS_TraceTaskCreate((pxNewTCB)->uxTCBNumber, (pxNewTCB)->uxPriority, (pxNewTCB)->pcTaskName)
+#define traceMOVED_TASK_TO_READY_STATE(pxTCB) \
+	OS_TraceTaskReady((pxTCB)->uxTCBNumber, (pxTCB)->uxPriority)
+#define OS_TRACE_TASK_SWITCHED_IN() \
+	OS_TraceTaskSwitchedIn(pxCurrentTCB->uxTCBNumber, pxCurrentTCB->uxPriority)
+#else
+#define OS_TRACE_TASK_SWITCHED_IN()
+#endif
+
+#define traceTASK_SWITCHED_IN()                 \
+	do {                                        \
+		PM_IDLE_TASK_SWITCHED_IN();             \
+		OS_TRACE_TASK_SWITCHED_IN();            \
+	} while (0)
+
 ////////////////////////////////////////////////////////////////////////////////
 
 /* disable some features for bootloader to reduce code size */
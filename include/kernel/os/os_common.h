@@ -35,6 +35,7 @@
 #ifndef _KERNEL_OS_OS_COMMON_H_
 #define _KERNEL_OS_OS_COMMON_H_
 
+#include <stddef.h>
 #include <stdint.h>
 #include "compiler.h"
 
@@ -40,6 +40,9 @@ void OS_CpuUsageInit(uint32_t print_s);
 
 uint32_t OS_CpuUsageGet(void);
 
+/* per thread usage since the previous call, needs __CONFIG_OS_TRACE */
+void OS_CpuUsageThreadShow(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _KERNEL_OS_OS_TRACE_H_
+#define _KERNEL_OS_OS_TRACE_H_
+
+#include "kernel/os/os_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Scheduler trace, a flight recorder of context switches, wakeups and
+ * interrupts in a RAM buffer, plus wake to run latency histograms.
+ *
+ * The buffer is self-describing: the header, the records and the task table
+ * can be read out by OS_TraceDump() over the console or saved from memory
+ * (eg. by a debugger) and decoded on the host by tools/os_trace_decode.py.
+ * All fields are little endian.
+ */
+
+/* OS_TraceStart() flags */
+#define OS_TRACE_F_SCHED        (1U << 0) /* record switches and wakeups */
+#define OS_TRACE_F_ISR          (1U << 1) /* record interrupt entry and exit */
+#define OS_TRACE_F_LATENCY      (1U << 2) /* wake to run latency histograms */
+
+#define OS_TRACE_MAGIC          0x5254534fU /* "OSTR" */
+#define OS_TRACE_VERSION        1
+
+#define OS_TRACE_TASK_MAX       32  /* task table entries */
+#define OS_TRACE_NAME_LEN       16
+#define OS_TRACE_PRIO_MAX       8
+#define OS_TRACE_LAT_BUCKETS    12  /* [0, 1), [1, 2), [2, 4) ... [1024, ~) us */
+
+/* record types, 0 marks a record being written */
+typedef enum {
+    OS_TRACE_EV_NONE        = 0,
+    OS_TRACE_EV_SWITCH_IN   = 1, /* arg: task number, now running */
+    OS_TRACE_EV_READY       = 2, /* arg: task number, made ready */
+    OS_TRACE_EV_ISR_ENTER   = 3, /* arg: exception number, 15 is SysTick */
+    OS_TRACE_EV_ISR_EXIT    = 4, /* arg: exception number */
+    OS_TRACE_EV_MARK        = 5, /* arg: user id, see OS_TraceMark() */
+} OS_TraceEvent;
+
+typedef struct OS_TraceRec {
+    uint32_t    ts;         /* us, wraps */
+    uint8_t     type;       /* OS_TraceEvent */
+    uint8_t     prio;       /* task priority, if any */
+    uint16_t    arg;
+} OS_TraceRec_t;
+
+typedef struct OS_TraceTask {
+    uint16_t    num;        /* kernel task number, 0 if unused */
+    uint8_t     prio;       /* base priority */
+    uint8_t     reserved;
+    char        name[OS_TRACE_NAME_LEN];
+} OS_TraceTask_t;
+
+typedef struct OS_TraceHdr {
+    uint32_t    magic;
+    uint16_t    version;
+    uint16_t    flags;      /* OS_TRACE_F_xxx */
+    uint32_t    clockHz;    /* time stamp clock */
+    uint32_t    recOffset;  /* from the header */
+    uint32_t    recCount;   /* power of 2 */
+    uint32_t    head;       /* records written, wraps, last at (head - 1) % recCount */
+    uint32_t    taskOffset; /* from the header */
+    uint16_t    taskCount;
+    uint16_t    taskSize;   /* sizeof(OS_TraceTask_t) */
+} OS_TraceHdr_t;
+
+/**
+ * @brief Start tracing
+ * @param[in] flags OS_TRACE_F_xxx
+ * @param[in] buf Trace buffer, NULL to allocate one
+ * @param[in] size Size of the trace buffer in bytes
+ * @retval OS_Status, OS_OK on success
+ *
+ * @note The oldest records are overwritten once the buffer is full.
+ */
+OS_Status OS_TraceStart(uint32_t flags, void *buf, uint32_t size);
+
+/**
+ * @brief Stop tracing, the buffer and the histograms are kept
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_TraceStop(void);
+
+/**
+ * @brief Add a user record, eg. to bracket a code path
+ * @param[in] id User defined value
+ */
+void OS_TraceMark(uint16_t id);
+
+/**
+ * @brief Get the trace buffer, valid until the next OS_TraceStart()
+ * @param[out] size Bytes used by the header, records and task table
+ * @return Pointer to the OS_TraceHdr_t at the start of the buffer
+ */
+const void *OS_TraceGetBuffer(uint32_t *size);
+
+/**
+ * @brief Stop tracing and print the trace buffer in hex to the console
+ */
+void OS_TraceDump(void);
+
+/**
+ * @brief Print the wake to run latency histograms, per priority
+ */
+void OS_TraceLatencyShow(void);
+
+/**
+ * @brief Clear the wake to run latency histograms
+ */
+void OS_TraceLatencyReset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _KERNEL_OS_OS_TRACE_H_ */
@@ -104,6 +104,9 @@ err_t netifapi_netif_common    ( struct netif *netif,
 #define netifapi_dhcp_release(n)      netifapi_netif_common(n, NULL, dhcp_release)
 #define netifapi_netif_set_link_up(n)   netifapi_netif_common(n, netif_set_link_up, NULL)
 #define netifapi_netif_set_link_down(n) netifapi_netif_common(n, netif_set_link_down, NULL)
+#if LWIP_DHCP
+err_t netifapi_dhcp_start_reboot(struct netif *netif, ip_addr_t *addr);
+#endif
 #endif
 
 #ifdef __cplusplus
@@ -98,6 +98,11 @@ extern OS_Mutex_t g_lwip_sys_mutex;
 #define SYS_ARCH_UNPROTECT(lev)
 #endif /* SYS_LIGHTWEIGHT_PROT */
 
+#if (LWIP_TCP && LWIP_TCP_AUTOTUNE)
+/* heap pressure for TCP autotuning (0 none, 1 high, 2 critical) */
+u8_t sys_arch_mem_pressure(void);
+#endif
+
 #ifdef  __cplusplus
 }
 #endif
@@ -120,6 +120,9 @@ err_t netifapi_netif_common(struct netif *netif, netifapi_void_fn voidfunc,
 #define netifapi_dhcp_renew(n)        netifapi_netif_common(n, NULL, dhcp_renew)
 /** @ingroup netifapi_dhcp4 */
 #define netifapi_dhcp_release(n)      netifapi_netif_common(n, NULL, dhcp_release)
+#if LWIP_XR_IMPL && LWIP_IPV4 && LWIP_DHCP
+err_t netifapi_dhcp_start_reboot(struct netif *netif, const ip4_addr_t *addr);
+#endif
 
 /**
  * @defgroup netifapi_autoip AUTOIP
@@ -1329,6 +1329,71 @@
 #define LWIP_WND_SCALE                  0
 #define TCP_RCV_SCALE                   0
 #endif
+
+/**
+ * LWIP_TCP_AUTOTUNE==1: Size the receive window and the send buffer of each
+ * connection from its measured bandwidth-delay product instead of using
+ * TCP_WND and TCP_SND_BUF for all of them. TCP_WND and TCP_SND_BUF are the
+ * initial sizes; connections marked with tcp_autotune_mode() grow up to
+ * TCP_AUTOTUNE_WND_MAX and TCP_AUTOTUNE_SND_BUF_MAX, while the sum over all
+ * connections stays below TCP_AUTOTUNE_MEM_LIMIT.
+ */
+#if !defined LWIP_TCP_AUTOTUNE || defined __DOXYGEN__
+#define LWIP_TCP_AUTOTUNE               0
+#endif
+
+/**
+ * TCP_AUTOTUNE_WND_MAX: Largest receive window of a bulk connection.
+ * Must not exceed 0xffff unless window scaling is enabled.
+ */
+#if !defined TCP_AUTOTUNE_WND_MAX || defined __DOXYGEN__
+#define TCP_AUTOTUNE_WND_MAX            (4 * TCP_WND)
+#endif
+
+/**
+ * TCP_AUTOTUNE_SND_BUF_MAX: Largest send buffer of a bulk connection.
+ * Must not exceed 0xffff unless window scaling is enabled. The number of
+ * queued pbufs is still limited by TCP_SND_QUEUELEN.
+ */
+#if !defined TCP_AUTOTUNE_SND_BUF_MAX || defined __DOXYGEN__
+#define TCP_AUTOTUNE_SND_BUF_MAX        (4 * TCP_SND_BUF)
+#endif
+
+/**
+ * TCP_AUTOTUNE_MIN: Receive window and send buffer every connection is
+ * shrunk to under critical memory pressure.
+ */
+#if !defined TCP_AUTOTUNE_MIN || defined __DOXYGEN__
+#define TCP_AUTOTUNE_MIN                (2 * TCP_MSS)
+#endif
+
+/**
+ * TCP_AUTOTUNE_MEM_LIMIT: Upper bound for the receive windows plus send
+ * buffers of all connections together. Above it, no connection grows and
+ * the ones that did are shrunk back to TCP_WND/TCP_SND_BUF.
+ */
+#if !defined TCP_AUTOTUNE_MEM_LIMIT || defined __DOXYGEN__
+#define TCP_AUTOTUNE_MEM_LIMIT          (4 * (TCP_WND + TCP_SND_BUF))
+#endif
+
+/**
+ * TCP_AUTOTUNE_IDLE_TIME: A connection that neither received nor got data
+ * acknowledged for this many milliseconds gives back what it grew.
+ */
+#if !defined TCP_AUTOTUNE_IDLE_TIME || defined __DOXYGEN__
+#define TCP_AUTOTUNE_IDLE_TIME          2000
+#endif
+
+/**
+ * TCP_AUTOTUNE_MEM_PRESSURE(): Heap pressure reported by the port, polled
+ * from the TCP slow timer: 0 for none, 1 to stop growing and shrink back to
+ * TCP_WND/TCP_SND_BUF, 2 to shrink every connection to TCP_AUTOTUNE_MIN.
+ * lwIP adds its own signals (failed allocations for sending and, with
+ * MEM_STATS, the usage of its heap) on top of it.
+ */
+#if !defined TCP_AUTOTUNE_MEM_PRESSURE || defined __DOXYGEN__
+#define TCP_AUTOTUNE_MEM_PRESSURE()     0
+#endif
 /**
  * @}
  */
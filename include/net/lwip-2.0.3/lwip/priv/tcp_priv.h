@@ -461,6 +461,14 @@ err_t tcp_keepalive(struct tcp_pcb *pcb);
 err_t tcp_zero_window_probe(struct tcp_pcb *pcb);
 void  tcp_trigger_input_pcb_close(void);
 
+#if LWIP_TCP_AUTOTUNE
+void tcp_autotune_tmr(void);
+void tcp_autotune_rtt(struct tcp_pcb *pcb);
+void tcp_autotune_acked(struct tcp_pcb *pcb, tcpwnd_size_t acked);
+void tcp_autotune_rcvd(struct tcp_pcb *pcb);
+void tcp_autotune_memerr(void);
+#endif /* LWIP_TCP_AUTOTUNE */
+
 #if TCP_CALCULATE_EFF_SEND_MSS
 u16_t tcp_eff_send_mss_impl(u16_t sendmss, const ip_addr_t *dest
 #if LWIP_IPV6 || LWIP_IPV4_SRC_ROUTING
@@ -254,6 +254,7 @@ struct linger {
 #define TCP_KEEPIDLE   0x03    /* set pcb->keep_idle  - Same as TCP_KEEPALIVE, but use seconds for get/setsockopt */
 #define TCP_KEEPINTVL  0x04    /* set pcb->keep_intvl - Use seconds for get/setsockopt */
 #define TCP_KEEPCNT    0x05    /* set pcb->keep_cnt   - Use number of probes sent for get/setsockopt */
+#define TCP_AUTOTUNE   0x06    /* set tcp_autotune_mode() - TCP_AUTOTUNE_DEFAULT, _BULK or _INTERACTIVE */
 #endif /* LWIP_TCP */
 
 #if LWIP_IPV6
@@ -145,6 +145,12 @@ typedef u32_t tcpwnd_size_t;
 typedef u16_t tcpwnd_size_t;
 #endif
 
+#if LWIP_TCP_AUTOTUNE
+/* the receive window is sized per pcb, see tcp_autotune.c */
+#undef TCP_WND_MAX
+#define TCP_WND_MAX(pcb)        ((pcb)->rcv_wnd_max)
+#endif /* LWIP_TCP_AUTOTUNE */
+
 #if LWIP_WND_SCALE || TCP_LISTEN_BACKLOG || LWIP_TCP_TIMESTAMPS
 typedef u16_t tcpflags_t;
 #else
@@ -269,6 +275,20 @@ struct tcp_pcb {
   tcpwnd_size_t snd_wnd_max; /* the maximum sender window announced by the remote host */
 
   tcpwnd_size_t snd_buf;   /* Available buffer space for sending (in bytes). */
+#if LWIP_TCP_AUTOTUNE
+  /* receive window and send buffer autotuning, see tcp_autotune.c */
+  tcpwnd_size_t rcv_wnd_max; /* current size of the receive window */
+  tcpwnd_size_t snd_buf_max; /* current size of the send buffer */
+  u8_t at_mode;       /* TCP_AUTOTUNE_DEFAULT, _BULK or _INTERACTIVE */
+  u8_t at_flags;
+  u32_t at_rttest;    /* sys_now() when the segment timed by rttest was sent */
+  u32_t at_srtt;      /* smoothed RTT from rttest in ms, 0 if unknown */
+  u32_t at_rcv_rtt;   /* RTT estimated from receiving a window in ms, 0 if unknown */
+  u32_t at_rcv_rtt_seq, at_rcv_rtt_time; /* window being timed */
+  u32_t at_rcv_seq, at_rcv_time;   /* start of the receive rate interval */
+  u32_t at_rcv_space;              /* most bytes received in one interval */
+  u32_t at_snd_acked, at_snd_time; /* bytes acked since start of the send rate interval */
+#endif /* LWIP_TCP_AUTOTUNE */
 #define TCP_SNDQUEUELEN_OVERFLOW (0xffffU-3)
   u16_t snd_queuelen; /* Number of pbufs currently in the send buffer. */
 
@@ -416,6 +436,17 @@ void             tcp_setprio (struct tcp_pcb *pcb, u8_t prio);
 #define TCP_PRIO_NORMAL 64
 #define TCP_PRIO_MAX    127
 
+#if LWIP_TCP_AUTOTUNE
+/* Traffic classes for tcp_autotune_mode() */
+#define TCP_AUTOTUNE_DEFAULT     0 /* may grow to twice TCP_WND/TCP_SND_BUF */
+#define TCP_AUTOTUNE_BULK        1 /* may grow to TCP_AUTOTUNE_WND_MAX/_SND_BUF_MAX */
+#define TCP_AUTOTUNE_INTERACTIVE 2 /* stays at TCP_WND/TCP_SND_BUF */
+
+void             tcp_autotune_mode(struct tcp_pcb *pcb, u8_t mode);
+/** @ingroup tcp_raw */
+#define          tcp_autotune_get_mode(pcb) ((pcb)->at_mode)
+#endif /* LWIP_TCP_AUTOTUNE */
+
 err_t            tcp_output  (struct tcp_pcb *pcb);
 
 
@@ -1107,6 +1107,64 @@
  */
 #define LWIP_WND_SCALE                  0 // ???
 #define TCP_RCV_SCALE                   0 // ???
+
+/**
+ * LWIP_TCP_AUTOTUNE==1: Size the receive window and the send buffer of each
+ * connection from its measured bandwidth-delay product instead of using
+ * TCP_WND and TCP_SND_BUF for all of them. Only worth it when TCP data is
+ * kept on the system heap, not in the small lwIP heap and pools.
+ */
+#define LWIP_TCP_AUTOTUNE               LWIP_XR_MEM
+
+/**
+ * TCP_AUTOTUNE_WND_MAX: Largest receive window of a bulk connection.
+ * Must not exceed 0xffff unless window scaling is enabled.
+ */
+#define TCP_AUTOTUNE_WND_MAX            (32 * TCP_MSS)
+
+/**
+ * TCP_AUTOTUNE_SND_BUF_MAX: Largest send buffer of a bulk connection.
+ * Must not exceed 0xffff unless window scaling is enabled. The number of
+ * queued pbufs is still limited by TCP_SND_QUEUELEN.
+ */
+#define TCP_AUTOTUNE_SND_BUF_MAX        (12 * TCP_MSS)
+
+/**
+ * TCP_AUTOTUNE_MIN: Receive window and send buffer every connection is
+ * shrunk to under critical memory pressure.
+ */
+#define TCP_AUTOTUNE_MIN                (2 * TCP_MSS)
+
+/**
+ * TCP_AUTOTUNE_MEM_LIMIT: Upper bound for the receive windows plus send
+ * buffers of all connections together.
+ */
+#define TCP_AUTOTUNE_MEM_LIMIT          (48 * TCP_MSS)
+
+/**
+ * TCP_AUTOTUNE_IDLE_TIME: A connection that neither received nor got data
+ * acknowledged for this many milliseconds gives back what it grew.
+ */
+#define TCP_AUTOTUNE_IDLE_TIME          2000
+
+/**
+ * TCP_AUTOTUNE_HEAP_LOW: Free heap in bytes below which connections stop
+ * growing and shrink back to TCP_WND/TCP_SND_BUF (high pressure).
+ */
+#define TCP_AUTOTUNE_HEAP_LOW           (32 * 1024)
+
+/**
+ * TCP_AUTOTUNE_HEAP_CRITICAL: Free heap in bytes below which connections
+ * shrink to TCP_AUTOTUNE_MIN (critical pressure).
+ */
+#define TCP_AUTOTUNE_HEAP_CRITICAL      (16 * 1024)
+
+/**
+ * TCP_AUTOTUNE_MEM_PRESSURE(): Heap pressure reported by the port
+ * (0 none, 1 high, 2 critical), polled from the TCP slow timer.
+ * sys_arch_mem_pressure() compares the free heap with the marks above.
+ */
+#define TCP_AUTOTUNE_MEM_PRESSURE()     sys_arch_mem_pressure()
 /**
  * @}
  */
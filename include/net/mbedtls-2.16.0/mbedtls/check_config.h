@@ -138,6 +138,10 @@
 #error "MBEDTLS_ECP_C defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_ECP_COMB_ROM_TABLES) && !defined(MBEDTLS_ECP_C)
+#error "MBEDTLS_ECP_COMB_ROM_TABLES defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_PK_PARSE_C) && !defined(MBEDTLS_ASN1_PARSE_C)
 #error "MBEDTLS_PK_PARSE_C defined, but not all prerequesites"
 #endif
@@ -719,6 +719,25 @@
  */
 #define MBEDTLS_ECP_NIST_OPTIM
 
+/**
+ * \def MBEDTLS_ECP_COMB_ROM_TABLES
+ *
+ * Use precomputed fixed-base comb tables for the curve generators stored
+ * in ROM (library/ecp_comb_rom.c, generated by scripts/ecp_comb_rom.py).
+ * Currently only secp256r1 has one.
+ *
+ * Uncomment this macro to use the ROM tables for multiplications of the
+ * generator, such as key generation and ECDSA signing.
+ *
+ * Tradeoff: the table takes ~3kb of ROM. It saves computing a table in RAM
+ * on each multiplication of the generator, or keeping one in each group when
+ * MBEDTLS_ECP_FIXED_POINT_OPTIM is set. The table for secp256r1 uses a
+ * window of 6 whatever MBEDTLS_ECP_WINDOW_SIZE is.
+ *
+ * Requires: MBEDTLS_ECP_C
+ */
+//#define MBEDTLS_ECP_COMB_ROM_TABLES
+
 /**
  * \def MBEDTLS_ECP_RESTARTABLE
  *
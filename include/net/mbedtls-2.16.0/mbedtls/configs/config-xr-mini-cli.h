@@ -88,6 +88,29 @@
 
 #define MBEDTLS_ON_LWIP
 
+/*
+ * ECDHE-ECDSA on secp256r1, enabled with __CONFIG_MBEDTLS_ECDHE_ECDSA=y.
+ * Point arithmetic runs on 32-bit words on the stack (ecp_p256_alt.c) and
+ * the generator comb table is kept in flash (ecp_comb_rom.c).
+ */
+#if defined(__CONFIG_MBEDTLS_ECDHE_ECDSA)
+#define MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED
+#define MBEDTLS_ECP_C
+#define MBEDTLS_ECDH_C
+#define MBEDTLS_ECDSA_C
+#define MBEDTLS_ECP_DP_SECP256R1_ENABLED
+#define MBEDTLS_ECP_NIST_OPTIM
+#define MBEDTLS_ECP_COMB_ROM_TABLES
+#define MBEDTLS_ECP_INTERNAL_ALT
+#define MBEDTLS_ECP_DOUBLE_JAC_ALT
+#define MBEDTLS_ECP_ADD_MIXED_ALT
+#define MBEDTLS_ECP_RANDOMIZE_JAC_ALT
+#define MBEDTLS_ECP_NORMALIZE_JAC_ALT
+#define MBEDTLS_ECP_NORMALIZE_JAC_MANY_ALT
+#define MBEDTLS_ECP_MAX_BITS                256
+#define MBEDTLS_ECP_FIXED_POINT_OPTIM       0   /**< The ROM table is used instead */
+#endif
+
 #include "mbedtls/check_config.h"
 #include "driver/chip/hal_crypto.h"
 
@@ -95,6 +95,37 @@
 /* Add for XRadio */
 //#define MBEDTLS_DEBUG_C
 
+/*
+ * ECDHE-ECDSA on secp256r1, enabled with __CONFIG_MBEDTLS_ECDHE_ECDSA=y.
+ * Point arithmetic runs on 32-bit words on the stack (ecp_p256_alt.c) and
+ * the generator comb table is kept in flash (ecp_comb_rom.c).
+ */
+#if defined(__CONFIG_MBEDTLS_ECDHE_ECDSA)
+#define MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED
+#define MBEDTLS_ECP_C
+#define MBEDTLS_ECDH_C
+#define MBEDTLS_ECDSA_C
+#define MBEDTLS_ECP_DP_SECP256R1_ENABLED
+#define MBEDTLS_ECP_NIST_OPTIM
+#define MBEDTLS_ECP_COMB_ROM_TABLES
+#define MBEDTLS_ECP_INTERNAL_ALT
+#define MBEDTLS_ECP_DOUBLE_JAC_ALT
+#define MBEDTLS_ECP_ADD_MIXED_ALT
+#define MBEDTLS_ECP_RANDOMIZE_JAC_ALT
+#define MBEDTLS_ECP_NORMALIZE_JAC_ALT
+#define MBEDTLS_ECP_NORMALIZE_JAC_MANY_ALT
+#define MBEDTLS_ECP_MAX_BITS                256
+#define MBEDTLS_ECP_FIXED_POINT_OPTIM       0   /**< The ROM table is used instead */
+#endif
+
+/* AES and GCM on the crypto engine, see aes_alt.c and gcm_alt.c */
+#if defined(__CONFIG_MBEDTLS_CE_ALT)
+#define MBEDTLS_AES_ALT
+#define MBEDTLS_GCM_ALT
+#define MBEDTLS_CIPHER_MODE_CTR
+#define MBEDTLS_GCM_C
+#endif
+
 #define MBEDTLS_ON_LWIP
 
 #include "mbedtls/check_config.h"
@@ -289,5 +289,21 @@ int mbedtls_internal_ecp_normalize_mxz( const mbedtls_ecp_group *grp,
 
 #endif /* MBEDTLS_ECP_INTERNAL_ALT */
 
+#if defined(MBEDTLS_ECP_COMB_ROM_TABLES)
+/**
+ * \brief           Get the fixed-base comb table of the group generator
+ *                  kept in ROM (see ecp_comb_rom.c).
+ *
+ * \param grp       Pointer to the group representing the curve.
+ *
+ * \param w         Set to the window size the table was computed for.
+ *
+ * \return          The table, holding 2^(w-1) normalized points, or NULL
+ *                  if there is no table for this group.
+ */
+const mbedtls_ecp_point *mbedtls_internal_ecp_comb_rom( const mbedtls_ecp_group *grp,
+                                                       unsigned char *w );
+#endif /* MBEDTLS_ECP_COMB_ROM_TABLES */
+
 #endif /* ecp_internal.h */
 
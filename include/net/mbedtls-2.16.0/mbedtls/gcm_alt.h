@@ -0,0 +1,54 @@
+/**
+ * \file gcm_alt.h
+ *
+ * \brief GCM on the XRadio crypto engine
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+#ifndef MBEDTLS_GCM_ALT_H
+#define MBEDTLS_GCM_ALT_H
+
+#if defined(MBEDTLS_GCM_ALT)
+
+#include "aes.h"
+
+/**
+ * \brief          GCM context structure, AES only
+ *
+ * \note           The key stream is produced by the crypto engine through
+ *                 mbedtls_aes_alt_ctr_blocks(), GHASH runs on 32-bit words
+ *                 with Shoup's 4-bit tables.
+ */
+typedef struct mbedtls_gcm_context
+{
+    mbedtls_aes_context aes_ctx;    /*!< The AES context used. */
+    uint32_t HT[16][4];             /*!< Precalculated multiples of H. */
+    uint32_t X[4];                  /*!< The GHASH accumulator. */
+    uint64_t len;                   /*!< The total length of the encrypted data. */
+    uint64_t add_len;               /*!< The total length of the additional data. */
+    unsigned char base_ectr[16];    /*!< The first ECTR for tag. */
+    unsigned char y[16];            /*!< The next counter block. */
+    int mode;                       /*!< The operation to perform:
+                                         #MBEDTLS_GCM_ENCRYPT or
+                                         #MBEDTLS_GCM_DECRYPT. */
+}
+mbedtls_gcm_context;
+
+#endif /* MBEDTLS_GCM_ALT */
+
+#endif /* gcm_alt.h */
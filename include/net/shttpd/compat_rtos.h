@@ -51,11 +51,13 @@
 struct usr_file {
 	char *name;
 	char *body;
+	unsigned long size;	/* 0: body is a string, binary (.gz) needs it */
 };
 
 struct f_stat {
 	unsigned long st_size;
 	unsigned int  st_mode;
+	unsigned long st_tag;	/* Content hash, stands in for st_mtime */
 };
 
 time_t TIME(time_t *timer);
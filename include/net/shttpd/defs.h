@@ -124,6 +124,8 @@ struct headers {
 	union variant   range;        /* Range:			*/
 	union variant   status;       /* Status:			*/
 	union variant   transenc;     /* Transfer-Encoding:		*/
+	union variant   inm;          /* If-None-Match:		*/
+	union variant   ae;           /* Accept-Encoding:		*/
 };
 
 /* Must go after union variant definition */
@@ -175,6 +177,8 @@ struct io_class {
 	int  (*io_read)(struct stream *, void *buf, size_t len);
 	int  (*io_write)(struct stream *, const void *buf, size_t len);
 	void (*io_close)(struct stream *);
+	/* Optional: content already in memory, return pointer and length */
+	const char *(*io_map)(struct stream *, size_t *len);
 };
 
 /*
@@ -198,6 +202,7 @@ struct stream {
 #define FLAG_DONT_CLOSE            32
 #define FLAG_ALWAYS_READY          64      /* File, dir, user_func */
 #define FLAG_SUSPEND               128
+#define FLAG_PENDING               256     /* Pipelined request buffered */
 };
 
 struct worker {
@@ -230,6 +235,9 @@ struct conn {
 	char              *query;       /* QUERY_STRING part of the URI	*/
 	char              *path_info;   /* PATH_INFO thing		*/
 	struct vec        mime_type;    /* Mime type			*/
+	int               keep_alive;   /* Reuse connection after reply	*/
+	int               gzipped;      /* Serving the .gz variant	*/
+	unsigned int      num_requests; /* Requests served on this conn	*/
 
 	struct headers    ch;           /* Parsed client headers	*/
 
@@ -393,6 +401,8 @@ extern int _shttpd_put_dir(const char *path);
 extern void _shttpd_get_dir(struct conn *c);
 #endif
 extern void _shttpd_get_file(struct conn *c, struct stat *stp);
+extern int _shttpd_open_gzip(struct conn *c, char *path, size_t maxpath,
+                                                struct stat *stp);
 extern void _shttpd_ssl_handshake(struct stream *stream);
 extern void _shttpd_setup_embedded_stream(struct conn *,
                                                         union variant, void *);
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __XRADIO_PM_IDLE_H
+#define __XRADIO_PM_IDLE_H
+
+#include <stdint.h>
+#include "sys/list.h"
+
+#if (defined(__CONFIG_PM_IDLE))
+#define CONFIG_PM_IDLE
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief PM QoS classes.
+ * @note:
+ *       PM_QOS_CPU_LATENCY is the longest time in us the requester can wait
+ *         for the cpu to come out of idle and run at its normal clock. The
+ *         smallest request wins, default is no constraint.
+ *       PM_QOS_CPU_THROUGHPUT is the lowest cpu clock in KHz the requester
+ *         needs. The largest request wins, default is no constraint.
+ *       PM_QOS_BUS_THROUGHPUT is the lowest AHB2 bus clock in KHz the
+ *         requester needs (eg. for DMA). AHB2 is divided from the cpu clock,
+ *         so this is turned into a cpu clock floor. The largest request wins.
+ */
+enum pm_qos_class {
+	PM_QOS_CPU_LATENCY      = 0,
+	PM_QOS_CPU_THROUGHPUT   = 1,
+	PM_QOS_BUS_THROUGHPUT   = 2,
+	PM_QOS_NUM_CLASSES      = 3,
+};
+
+#define PM_QOS_LATENCY_DEFAULT          UINT32_MAX
+#define PM_QOS_THROUGHPUT_DEFAULT       0
+
+/**
+ * @brief A QoS request, owned by the requester.
+ * @note Keep it alive (static or in the driver's private data) until
+ *       pm_qos_remove_request() is called.
+ */
+struct pm_qos_request {
+	struct list_head node;
+	enum pm_qos_class qos_class;
+	uint32_t value;
+};
+
+/**
+ * @brief Idle state description, states are ordered from shallow to deep.
+ * @exit_latency: Entry + exit overhead in us. Starts from the table value
+ *      and follows the measured cost at runtime.
+ * @target_residency: Minimum idle time in us for the state to save power.
+ */
+struct pm_idle_state {
+	const char *name;
+	uint32_t exit_latency;
+	uint32_t target_residency;
+	uint32_t disable;
+	uint32_t usage;
+	uint64_t time;          /* total residency in us */
+};
+
+/* Buckets of expected idle time the correction factors are kept for */
+#define PM_IDLE_BUCKETS         6
+/* Recent idle intervals used to detect a repeating pattern */
+#define PM_IDLE_INTERVALS       8
+
+/* Fixed point base of the correction factors */
+#define PM_IDLE_RESOLUTION      1024
+
+/**
+ * @brief Idle duration predictor.
+ * @note The timer list tells when the next timeout is due (expected idle
+ *       time), but interrupts often end the idle period earlier. The
+ *       predictor scales the expected time by the ratio measured in the past
+ *       for the same magnitude, and uses the average of the recent intervals
+ *       instead when they are steady.
+ */
+struct pm_idle_predictor {
+	uint32_t correction[PM_IDLE_BUCKETS];
+	uint32_t intervals[PM_IDLE_INTERVALS];
+	uint32_t expected;
+	uint8_t bucket;
+	uint8_t interval_idx;
+};
+
+/**
+ * @brief Load based cpu clock policy.
+ * @freq: Available cpu clocks in KHz, in ascending order.
+ * @up_threshold: Load in percent above which the highest clock is used.
+ * @down_differential: Load in percent, below @up_threshold, to keep when a
+ *      lower clock is selected, so that the next sample does not jump back.
+ */
+struct pm_cpufreq_policy {
+	const uint32_t *freq;
+	uint8_t cnt;
+	uint8_t cur;
+	uint8_t up_threshold;
+	uint8_t down_differential;
+};
+
+/*
+ * Governor decision logic. It depends on nothing but its arguments, so it can
+ * be run on a host against recorded idle traces.
+ */
+void pm_idle_predictor_init(struct pm_idle_predictor *p);
+
+/**
+ * @brief Predict the duration of the idle period being entered.
+ * @param expected_us:
+ *        @arg expected_us->Time until the next timeout from the timer list.
+ * @retval  Predicted idle time in us, not more than expected_us.
+ */
+uint32_t pm_idle_predict(struct pm_idle_predictor *p, uint32_t expected_us);
+
+/**
+ * @brief Feed back the measured duration of the last predicted idle period.
+ */
+void pm_idle_reflect(struct pm_idle_predictor *p, uint32_t measured_us);
+
+/**
+ * @brief Select the deepest enabled state worth entering.
+ * @param predicted_us:
+ *        @arg predicted_us->Predicted idle time.
+ * @param latency_us:
+ *        @arg latency_us->Latency constraint, see PM_QOS_CPU_LATENCY.
+ * @retval  Index of the state, 0 if no deeper state fits.
+ */
+int pm_idle_select(const struct pm_idle_state *states, int cnt,
+                   uint32_t predicted_us, uint32_t latency_us);
+
+/**
+ * @brief Track the measured entry + exit cost of a state.
+ * @note Rises quickly and decays slowly, so that the latency used for the
+ *       selection stays on the safe side.
+ */
+void pm_idle_update_latency(struct pm_idle_state *state, uint32_t measured_us);
+
+/**
+ * @brief Select a cpu clock from the load of the last sample period.
+ * @param min_khz:
+ *        @arg min_khz->Lowest allowed clock, see PM_QOS_CPU_THROUGHPUT.
+ * @retval  Index in policy->freq.
+ */
+int pm_cpufreq_target(const struct pm_cpufreq_policy *policy, uint32_t busy_us,
+                      uint32_t total_us, uint32_t min_khz);
+
+#ifdef CONFIG_PM_IDLE
+/**
+ * @brief Add a QoS request, it takes effect at once.
+ * @retval  0 if success or other if failed.
+ */
+extern int pm_qos_add_request(struct pm_qos_request *req,
+                              enum pm_qos_class qos_class, uint32_t value);
+
+/**
+ * @brief Update the value of an added QoS request.
+ * @retval  0 if success or other if failed.
+ */
+extern int pm_qos_update_request(struct pm_qos_request *req, uint32_t value);
+
+/**
+ * @brief Remove an added QoS request.
+ * @retval  0 if success or other if failed.
+ */
+extern int pm_qos_remove_request(struct pm_qos_request *req);
+
+/** @brief Get the aggregated value of all requests of a class. */
+extern uint32_t pm_qos_read_value(enum pm_qos_class qos_class);
+
+/**
+ * @brief Initialize the idle governor and the cpu clock governor.
+ * @note Called by pm_init(), the cpu clock set at boot is the highest one
+ *        the cpu clock governor will use.
+ */
+extern void pm_idle_init(void);
+
+/**
+ * @brief Disable or enable an idle state.
+ * @retval  0 if success or other if failed.
+ */
+extern int pm_idle_state_disable(int idx, int disable);
+
+/**
+ * @brief Enable or disable load based cpu clock scaling.
+ * @note The highest clock is restored when disabled.
+ */
+extern void pm_cpufreq_enable(int enable);
+
+/** @brief Show idle states, predictor and cpu clock statistic info. */
+extern void pm_idle_show(void);
+
+#else /* CONFIG_PM_IDLE */
+
+static inline int pm_qos_add_request(struct pm_qos_request *req,
+                                     enum pm_qos_class qos_class,
+                                     uint32_t value) { return 0; }
+static inline int pm_qos_update_request(struct pm_qos_request *req,
+                                        uint32_t value) { return 0; }
+static inline int pm_qos_remove_request(struct pm_qos_request *req) { return 0; }
+static inline uint32_t pm_qos_read_value(enum pm_qos_class qos_class)
+{
+	return (qos_class == PM_QOS_CPU_LATENCY) ? PM_QOS_LATENCY_DEFAULT :
+	                                           PM_QOS_THROUGHPUT_DEFAULT;
+}
+static inline void pm_idle_init(void) { ; }
+static inline int pm_idle_state_disable(int idx, int disable) { return 0; }
+static inline void pm_cpufreq_enable(int enable) { ; }
+static inline void pm_idle_show(void) { ; }
+#endif /* CONFIG_PM_IDLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __XRADIO_PM_IDLE_H */
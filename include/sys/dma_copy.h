@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _SYS_DMA_COPY_H_
+#define _SYS_DMA_COPY_H_
+
+#include <stdint.h>
+#include "kernel/os/os.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Memory copy/fill service on the general DMA controller.
+ *
+ * The service owns its DMA channels for its whole life and runs queued jobs
+ * back to back from the DMA interrupt, so the caller can go on with other
+ * work while large buffers (eg. PSRAM <-> SRAM) are moved. Segments shorter
+ * than the cutoff are copied by the CPU, which is cheaper than programming
+ * the controller for them.
+ */
+
+/* Number of DMA channels held by the service */
+#ifndef DMA_COPY_CHAN_NUM
+#define DMA_COPY_CHAN_NUM		1
+#endif
+
+/* Default cutoff in bytes, shorter segments are copied by the CPU */
+#define DMA_COPY_CPU_CUTOFF		256
+
+/* Timeout of dma_copy() and dma_fill(), in ms */
+#define DMA_COPY_SYNC_TIMEOUT		5000
+
+/*
+ * Run the jobs with a software engine instead of the DMA controller: the
+ * transfers are done by dma_copy_sw_run(). Used to test the service on a
+ * host.
+ */
+#ifndef DMA_COPY_OPT_SW_BACKEND
+#define DMA_COPY_OPT_SW_BACKEND		0
+#endif
+
+enum dma_copy_op {
+	DMA_COPY_OP_COPY = 0,	/* seg[].dst <-- seg[].src */
+	DMA_COPY_OP_FILL,	/* seg[].dst <-- job->fill, seg[].src unused */
+};
+
+/* dma_copy_job::flags */
+#define DMA_COPY_F_FENCE	(1U << 0)	/* start after all earlier jobs are done */
+
+/* dma_copy_job::status */
+#define DMA_COPY_ST_DONE	0
+#define DMA_COPY_ST_PENDING	1
+#define DMA_COPY_ST_ERROR	(-1)
+#define DMA_COPY_ST_CANCELED	(-2)
+
+struct dma_copy_seg {
+	void       *dst;
+	const void *src;
+	uint32_t    len;
+};
+
+struct dma_copy_job;
+
+typedef void (*dma_copy_cb)(struct dma_copy_job *job, void *arg);
+
+struct dma_copy_job {
+	/* set by the caller */
+	const struct dma_copy_seg *seg;	/* scatter list, kept until completion */
+	uint16_t        nseg;
+	uint8_t         op;		/* enum dma_copy_op */
+	uint8_t         flags;		/* DMA_COPY_F_xxx */
+	uint8_t         fill;		/* byte value for DMA_COPY_OP_FILL */
+	dma_copy_cb     cb;		/* completion callback, may be NULL */
+	void           *arg;
+	OS_Semaphore_t *sem;		/* released on completion, may be NULL */
+
+	/* private */
+	struct dma_copy_job *next;
+	uint16_t        cur;		/* segment in progress */
+	uint32_t        off;		/* bytes done in the current segment */
+	int8_t          result;		/* status to report on completion */
+	volatile int8_t status;		/* DMA_COPY_ST_xxx */
+};
+
+struct dma_copy_stats {
+	uint32_t jobs;		/* jobs completed */
+	uint32_t dma_bytes;	/* bytes moved by the DMA controller */
+	uint32_t cpu_bytes;	/* bytes moved by the CPU (below the cutoff) */
+	uint32_t max_queued;	/* queue high-water mark, in jobs */
+};
+
+/**
+ * @brief Request the DMA channels of the service
+ * @return 0 on success, -1 on failure
+ * @note Called on the first job if not done before.
+ */
+int dma_copy_init(void);
+
+/**
+ * @brief Release the DMA channels of the service
+ * @return 0 on success, -1 if jobs are still pending
+ */
+int dma_copy_deinit(void);
+
+/**
+ * @brief Queue a copy or fill job
+ * @param[in] job The job, owned by the service until it completes
+ * @return 0 on success, -1 on invalid job or no DMA channel
+ *
+ * @note Jobs are started in submission order. With more than one channel
+ *       they may complete out of order unless DMA_COPY_F_FENCE is set.
+ * @note When the service is idle and every segment is below the cutoff, the
+ *       job is done by the CPU before returning.
+ * @note The callback runs in interrupt context, or in the context of the
+ *       submitting/canceling thread; it may submit new jobs.
+ * @note Buffers follow the rules of HAL_DMA_Start(): PSRAM data must be
+ *       cleaned from or flushed in the data cache by the caller when the
+ *       cache is not handled by the DMA driver.
+ */
+int dma_copy_submit(struct dma_copy_job *job);
+
+/**
+ * @brief Wait for a job submitted with dma_copy_job::sem set
+ * @return The final status of the job, DMA_COPY_ST_PENDING on timeout
+ */
+int dma_copy_wait(struct dma_copy_job *job, OS_Time_t waitMS);
+
+/**
+ * @brief Cancel a job not completed yet, its callback is called with
+ *        DMA_COPY_ST_CANCELED
+ * @return 0 if canceled, -1 if it had already completed
+ */
+int dma_copy_cancel(struct dma_copy_job *job);
+
+/* Copy/fill and wait for the completion, return 0 on success */
+int dma_copy(void *dst, const void *src, uint32_t len);
+int dma_fill(void *dst, uint8_t c, uint32_t len);
+
+void dma_copy_set_cutoff(uint32_t bytes);
+uint32_t dma_copy_get_cutoff(void);
+void dma_copy_get_stats(struct dma_copy_stats *stats);
+
+static __inline int dma_copy_is_done(struct dma_copy_job *job)
+{
+	return job->status != DMA_COPY_ST_PENDING;
+}
+
+#if DMA_COPY_OPT_SW_BACKEND
+/* Complete the transfers started on the software engine, return their number */
+int dma_copy_sw_run(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SYS_DMA_COPY_H_ */
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _UTIL_TIMELINE_H_
+#define _UTIL_TIMELINE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Timeline profiler, named and nested spans with us time stamps covering
+ * the whole boot, from the bootloader to the application being connected.
+ *
+ * Spans are added with TIMELINE_BEGIN(name) / TIMELINE_END(name), instants
+ * with TIMELINE_MARK(name). Bootloader span names are cut to 7 characters.
+ * The macros compile to nothing unless __CONFIG_TIMELINE is set. Time
+ * stamps come from the RTC free running counter, which runs from power on
+ * and is shared by the bootloader and the application.
+ *
+ * The bootloader keeps its spans in a small retention area at a fixed SRAM
+ * address that is not used by either image; the application imports them in
+ * timeline_init(). Spans may begin and end in different threads, the end is
+ * matched by name to the last open span.
+ */
+
+/* retention area handed over from the bootloader to the application */
+#define TIMELINE_RETAIN_ADDR        0x00200F80
+#define TIMELINE_RETAIN_SIZE        128
+#define TIMELINE_RETAIN_MAGIC       0x4c4d4954U /* "TIML" */
+#define TIMELINE_RETAIN_NAME_LEN    7
+#define TIMELINE_RETAIN_SPANS       7
+
+struct timeline_retain_span {
+	char     name[TIMELINE_RETAIN_NAME_LEN];
+	uint8_t  depth;
+	uint32_t start;     /* us since power on */
+	uint32_t end;       /* 0 while open */
+};
+
+struct timeline_retain {
+	uint32_t magic;
+	uint8_t  count;
+	uint8_t  depth;     /* spans currently open */
+	uint16_t reserved;
+	struct timeline_retain_span span[TIMELINE_RETAIN_SPANS];
+};
+
+/* application spans */
+#ifndef TIMELINE_SPAN_MAX
+#define TIMELINE_SPAN_MAX           64
+#endif
+
+#define TIMELINE_F_MARK             (1U << 0) /* instant, no duration */
+#define TIMELINE_F_BOOT             (1U << 1) /* imported from the bootloader */
+
+struct timeline_span {
+	const char *name;
+	uint32_t    start;  /* us since power on */
+	uint32_t    end;    /* 0 while open */
+	uint8_t     depth;  /* spans open when this one began */
+	uint8_t     flags;  /* TIMELINE_F_xxx */
+	uint16_t    reserved;
+};
+
+#ifdef __CONFIG_TIMELINE
+
+extern uint64_t HAL_RTC_GetFreeRunTime(void);
+
+static __inline uint32_t timeline_now(void)
+{
+	uint32_t t = (uint32_t)HAL_RTC_GetFreeRunTime();
+	return t ? t : 1; /* 0 marks an open span */
+}
+
+#ifdef __CONFIG_BOOTLOADER
+
+/* bootloader: no heap, no OS, write straight to the retention area */
+#define TIMELINE_RETAIN ((struct timeline_retain *)TIMELINE_RETAIN_ADDR)
+
+static __inline void timeline_init(void)
+{
+	TIMELINE_RETAIN->magic = TIMELINE_RETAIN_MAGIC;
+	TIMELINE_RETAIN->count = 0;
+	TIMELINE_RETAIN->depth = 0;
+}
+
+static __inline void timeline_begin(const char *name)
+{
+	struct timeline_retain *r = TIMELINE_RETAIN;
+	struct timeline_retain_span *s;
+
+	if (r->count >= TIMELINE_RETAIN_SPANS)
+		return;
+	s = &r->span[r->count++];
+	strncpy(s->name, name, TIMELINE_RETAIN_NAME_LEN);
+	s->depth = r->depth++;
+	s->end = 0;
+	s->start = timeline_now();
+}
+
+static __inline void timeline_end(const char *name)
+{
+	struct timeline_retain *r = TIMELINE_RETAIN;
+	int i;
+
+	for (i = r->count - 1; i >= 0; i--) {
+		if (r->span[i].end == 0 &&
+		    strncmp(r->span[i].name, name, TIMELINE_RETAIN_NAME_LEN) == 0) {
+			r->span[i].end = timeline_now();
+			r->depth--;
+			break;
+		}
+	}
+}
+
+static __inline void timeline_mark(const char *name)
+{
+	timeline_begin(name);
+	timeline_end(name);
+}
+
+#else /* __CONFIG_BOOTLOADER */
+
+/**
+ * @brief Import the bootloader spans, call once early in the application
+ */
+void timeline_init(void);
+
+/**
+ * @brief Begin a span
+ * @param[in] name Span name, must stay valid (eg. a string literal)
+ */
+void timeline_begin(const char *name);
+
+/**
+ * @brief End the last open span with the given name, if any
+ */
+void timeline_end(const char *name);
+
+/**
+ * @brief Add an instant event
+ */
+void timeline_mark(const char *name);
+
+/**
+ * @brief Drop all application spans, the bootloader ones are kept
+ */
+void timeline_reset(void);
+
+/**
+ * @brief Copy the spans recorded so far, oldest first
+ * @param[out] span Destination array
+ * @param[in] max Entries in @span
+ * @return Number of spans copied
+ */
+int timeline_get(struct timeline_span *span, int max);
+
+/**
+ * @brief Print the spans as an indented table, with start times and durations
+ */
+void timeline_show(void);
+
+/**
+ * @brief Print the spans as Chrome trace event JSON
+ *
+ * Save the text between the "timeline json begin/end" lines to a file and
+ * load it in chrome://tracing or ui.perfetto.dev.
+ */
+void timeline_export(void);
+
+#endif /* __CONFIG_BOOTLOADER */
+
+#define TIMELINE_INIT()         timeline_init()
+#define TIMELINE_BEGIN(name)    timeline_begin(name)
+#define TIMELINE_END(name)      timeline_end(name)
+#define TIMELINE_MARK(name)     timeline_mark(name)
+
+#else /* __CONFIG_TIMELINE */
+
+#define TIMELINE_INIT()         do { } while (0)
+#define TIMELINE_BEGIN(name)    do { } while (0)
+#define TIMELINE_END(name)      do { } while (0)
+#define TIMELINE_MARK(name)     do { } while (0)
+
+#endif /* __CONFIG_TIMELINE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _UTIL_TIMELINE_H_ */
@@ -42,6 +42,7 @@
 #include "image/flash.h"
 #include "ota/ota.h"
 #include "ota/ota_opt.h"
+#include "util/timeline.h"
 
 #include "common/board/board.h"
 #include "bl_debug.h"
@@ -243,6 +244,7 @@ static int bl_xz_image(image_seq_t seq)
 	ota_verify_data_t verify_data;
 */
 	image_cfg_t cfg;
+	image_val_t val;
 #if BL_DBG_ON
 	OS_Time_t tm;
 #endif
@@ -369,7 +371,10 @@ static int bl_xz_image(image_seq_t seq)
 	}
 
 	/* check every section */
-	if (image_check_sections(seq) == IMAGE_INVALID) {
+	TIMELINE_BEGIN("check");
+	val = image_check_sections(seq);
+	TIMELINE_END("check");
+	if (val == IMAGE_INVALID) {
 		BL_ERR("ota check image failed\n");
 		goto out;
 	}
@@ -406,6 +411,7 @@ static int bl_load_bin_by_id(uint32_t id, uint32_t max_addr, uint32_t *entry)
 {
 	uint32_t len;
 	section_header_t sh;
+	image_val_t val;
 
 	BL_DBG("%s(), id %#x\n", __func__, id);
 
@@ -426,7 +432,12 @@ static int bl_load_bin_by_id(uint32_t id, uint32_t max_addr, uint32_t *entry)
 #endif
 #ifdef __CONFIG_BIN_COMPRESS
 	if (sh.attribute & IMAGE_ATTR_FLAG_COMPRESS) {
-		if (bl_decompress_bin(&sh, max_addr - sh.load_addr) != 0) {
+		int ret;
+
+		TIMELINE_BEGIN("unxz");
+		ret = bl_decompress_bin(&sh, max_addr - sh.load_addr);
+		TIMELINE_END("unxz");
+		if (ret != 0) {
 			BL_ERR("decompress bin %#x failed\n", id);
 			return BL_LOAD_BIN_INVALID;
 		}
@@ -448,15 +459,20 @@ static int bl_load_bin_by_id(uint32_t id, uint32_t max_addr, uint32_t *entry)
 			return BL_LOAD_BIN_TOOBIG;
 		}
 
+		TIMELINE_BEGIN("read");
 		len = image_read(id, IMAGE_SEG_BODY, 0, (void *)sh.load_addr,
 		                 sh.data_size);
+		TIMELINE_END("read");
 		if (len != sh.data_size) {
 			BL_WRN("bin data size %u, read %u\n", sh.data_size, len);
 			return BL_LOAD_BIN_INVALID;
 		}
 
-		if (image_check_data(&sh, (void *)sh.load_addr, sh.data_size,
-		                     NULL, 0) == IMAGE_INVALID) {
+		TIMELINE_BEGIN("check");
+		val = image_check_data(&sh, (void *)sh.load_addr, sh.data_size,
+		                       NULL, 0);
+		TIMELINE_END("check");
+		if (val == IMAGE_INVALID) {
 			BL_WRN("invalid bin body\n");
 			return BL_LOAD_BIN_INVALID;
 		}
@@ -545,7 +561,9 @@ static uint32_t bl_load_bin(void)
 	/* if img_xz_max_size is not invalid size, mean use image compression mode */
 	if (cfg_seq == 1 && cfg.state == IMAGE_STATE_VERIFIED &&
 		iop->img_xz_max_size != IMAGE_INVALID_SIZE) {
+		TIMELINE_BEGIN("ota xz");
 		int ret = bl_xz_image(cfg_seq);
+		TIMELINE_END("ota xz");
 		if (ret == 0)
 			load_seq = 0;
 		else if (ret == -1)
@@ -628,8 +646,12 @@ int main(void)
 
 	boot_flag = HAL_PRCM_GetCPUABootFlag();
 	if (boot_flag == PRCM_CPUA_BOOT_FROM_COLD_RESET) {
+		TIMELINE_INIT();
+		TIMELINE_BEGIN("boot");
 		bl_hw_init();
+		TIMELINE_BEGIN("load");
 		entry = bl_load_bin();
+		TIMELINE_END("load");
 		if (entry == BL_INVALID_APP_ENTRY) {
 			BL_ERR("load app bin fail, enter upgrade mode\n");
 			bl_upgrade();
@@ -640,6 +662,7 @@ int main(void)
 #endif
 		BL_DBG("goto %#x\n", entry);
 		bl_hw_deinit();
+		TIMELINE_END("boot");
 
 		__disable_fault_irq();
 		__disable_irq();
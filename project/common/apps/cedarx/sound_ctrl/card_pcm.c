@@ -41,6 +41,7 @@
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
 #include "audio/reverb/mixer.h"
 #include "audio/reverb/resample.h"
+#include "audio/resample/audio_resample.h"
 #endif
 
 #define SUPPORT_EQ
@@ -69,6 +70,9 @@ typedef struct CardContext {
     struct CardPcmConfig support_cfg[SAMPLE_RATE_MAX_NUM + 1];
     struct pcm_config *output_config;
     resample_info res_info;
+    audio_resample_t *resampler; /* polyphase, res_info is the fallback */
+    int16_t *res_buf;
+    unsigned int res_buf_frames;
     unsigned int rate;
     unsigned int channel;
 #endif
@@ -122,9 +126,42 @@ static int card_pcm_close(SoundStreamT *stream)
 
 static int card_pcm_flush(SoundStreamT *stream)
 {
+#ifdef SUPPORT_FIXED_OUTPUT_CONFIG
+    CardContext *context = (CardContext *)stream;
+
+    if (context->resampler) {
+        audio_resample_reset(context->resampler);
+    }
+#endif
     return snd_pcm_flush(AUDIO_SND_CARD_DEFAULT);
 }
 
+#ifdef SUPPORT_FIXED_OUTPUT_CONFIG
+static int card_pcm_resample(CardContext *context, void **data, unsigned int *len)
+{
+    unsigned int channels = context->output_config->channels;
+    unsigned int frames = *len / (2 * channels);
+    unsigned int need;
+
+    need = audio_resample_out_frames(context->resampler, frames);
+    if (need > context->res_buf_frames) {
+        free(context->res_buf);
+        context->res_buf = (int16_t *)malloc(need * 2 * channels);
+        if (context->res_buf == NULL) {
+            context->res_buf_frames = 0;
+            return -1;
+        }
+        context->res_buf_frames = need;
+    }
+
+    frames = audio_resample_process(context->resampler, (const int16_t *)*data,
+                                    frames, context->res_buf);
+    *data = context->res_buf;
+    *len = frames * 2 * channels;
+    return 0;
+}
+#endif
+
 static int card_pcm_write(SoundStreamT *stream, struct SscPcmConfig *config, void *data, unsigned int count)
 {
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
@@ -156,21 +193,34 @@ static int card_pcm_write(SoundStreamT *stream, struct SscPcmConfig *config, voi
             unsigned int out_channel;
             unsigned int in_rate;
 
-            has_resample = 1;
             out_channel = context->output_config->channels;
             in_rate = context->input_config.rate;
             if (context->channel != out_channel || context->rate != in_rate) {
-                res_info->BitsPerSample = 16;
-                res_info->in_SampleRate = in_rate;
-                res_info->NumChannels = out_channel;
-                res_info->out_SampleRate = context->output_config->rate;
-                resample_init(res_info);
+                audio_resample_destroy(context->resampler);
+                context->resampler = audio_resample_create(in_rate,
+                                         context->output_config->rate, out_channel);
+                if (context->resampler == NULL) {
+                    /* ratio not supported, use the linear one */
+                    res_info->BitsPerSample = 16;
+                    res_info->in_SampleRate = in_rate;
+                    res_info->NumChannels = out_channel;
+                    res_info->out_SampleRate = context->output_config->rate;
+                    resample_init(res_info);
+                }
                 context->channel = out_channel;
                 context->rate = in_rate;
             }
-            resample(res_info, (short*)outData, dataLen);
-            outData = res_info->out_buffer;
-            dataLen = res_info->out_frame_indeed * (res_info->BitsPerSample / 8) * res_info->NumChannels;
+            if (context->resampler) {
+                if (card_pcm_resample(context, &outData, &dataLen) != 0) {
+                    printf("resample buffer alloc fail.\n");
+                    return -1;
+                }
+            } else {
+                has_resample = 1;
+                resample(res_info, (short*)outData, dataLen);
+                outData = res_info->out_buffer;
+                dataLen = res_info->out_frame_indeed * (res_info->BitsPerSample / 8) * res_info->NumChannels;
+            }
         }
 
 #ifdef SUPPORT_EQ
@@ -385,6 +435,8 @@ static void card_pcm_destroy(SoundStreamT * stream)
 {
     CardContext *context = (CardContext *)stream;
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
+    audio_resample_destroy(context->resampler);
+    free(context->res_buf);
     free(context->output_config);
 #endif
     free(context);
@@ -38,6 +38,7 @@
 #include "common/cmd/cmd_thread.h"
 #include "common/cmd/cmd_upgrade.h"
 #include "common/cmd/cmd_sysinfo.h"
+#include "common/cmd/cmd_timeline.h"
 
 #include "common/cmd/cmd_gpio.h"
 #include "common/cmd/cmd_clock.h"
@@ -32,6 +32,7 @@
 #include "cmd_camera.h"
 #include "kernel/os/os.h"
 #include "driver/chip/hal_i2c.h"
+#include "driver/component/csi_camera/camera_stream.h"
 
 //#define SENSOR_GC0308
 #ifdef SENSOR_GC0308
@@ -75,12 +76,22 @@
 static uint8_t* gmemaddr;
 static CAMERA_Mgmt mem_mgmt;
 
+#if CSI_JPEG_MEMPART_EN
+/* mem parts not taken by the stream */
+static void camera_cb(CAMERA_CapStatus status, void *arg)
+{
+	if (status == CAMERA_STATUS_MPART)
+		HAL_CAMERA_MpartRelease((CAMERA_MpartBuffInfo *)arg);
+}
+#endif
+
 static CAMERA_Cfg camera_cfg = {
 	.jpeg_cfg.jpeg_en = 1,
 	.jpeg_cfg.quality = 64,
 	.jpeg_cfg.jpeg_clk  = 0, //no use
 	.jpeg_cfg.memPartEn = CSI_JPEG_MEMPART_EN,
 	.jpeg_cfg.memPartNum = CSI_JPEG_MEMPART_EN ? JPEG_MEM_BLOCK4 : 0,
+	.jpeg_cfg.memPartHold = CSI_JPEG_MEMPART_EN,
 	.jpeg_cfg.jpeg_mode = CSI_JPEG_ONLINE_EN ? JPEG_MOD_ONLINE : JPEG_MOD_OFFLINE,
 	.jpeg_cfg.width = 640,
 	.jpeg_cfg.height = 480,
@@ -97,6 +108,10 @@ static CAMERA_Cfg camera_cfg = {
 	.sensor_func.init = SENSOR_FUNC_INIT,
 	.sensor_func.deinit = SENSOR_FUNC_DEINIT,
 	.sensor_func.ioctl = SENSOR_FUNC_IOCTL,
+
+#if CSI_JPEG_MEMPART_EN
+	.cb = camera_cb,
+#endif
 };
 
 static int camera_mem_create(CAMERA_JpegCfg *jpeg_cfg, CAMERA_Mgmt *mgmt)
@@ -278,6 +293,57 @@ enum cmd_status cmd_camera_cap_video_exec(char *cmd)
 	return CMD_STATUS_OK;
 }
 
+#if (CSI_JPEG_MEMPART_EN && PRJCONF_NET_EN)
+/* stream start [port] [kbit/s], stream stop, stream stat */
+enum cmd_status cmd_camera_stream_exec(char *cmd)
+{
+	int argc;
+	char *argv[3];
+	CAMERA_StreamCfg cfg;
+	CAMERA_StreamStats stats;
+	JpegRcParam rc;
+
+	argc = cmd_parse_argv(cmd, argv, cmd_nitems(argv));
+	if (argc < 1)
+		return CMD_STATUS_INVALID_ARG;
+
+	if (cmd_strcmp(argv[0], "start") == 0) {
+		cmd_memset(&cfg, 0, sizeof(cfg));
+		if (argc > 1)
+			cfg.port = cmd_atoi(argv[1]);
+		if (argc > 2) {
+			cmd_memset(&rc, 0, sizeof(rc));
+			rc.mode = JPEG_RC_BITRATE;
+			rc.target = cmd_atoi(argv[2]) * 1000;
+			rc.fps = 30;
+			rc.max_step = 10;
+			if (HAL_CAMERA_SetRateCtrl(&rc) != 0)
+				return CMD_STATUS_FAIL;
+		}
+		if (HAL_CAMERA_StreamStart(&cfg) != 0)
+			return CMD_STATUS_FAIL;
+		if (HAL_CAMERA_CaptureMpartStart(1) != 0) {
+			HAL_CAMERA_StreamStop();
+			return CMD_STATUS_FAIL;
+		}
+	} else if (cmd_strcmp(argv[0], "stop") == 0) {
+		HAL_CAMERA_CaptureMpartStop();
+		HAL_CAMERA_StreamStop();
+		HAL_CAMERA_SetRateCtrl(NULL);
+	} else if (cmd_strcmp(argv[0], "stat") == 0) {
+		if (HAL_CAMERA_StreamGetStats(&stats) != 0)
+			return CMD_STATUS_FAIL;
+		CMD_SYSLOG("clients %u, frames %u, skipped %u, %u bytes, quality %u\n",
+		           stats.clients, stats.frames, stats.skipped, stats.bytes,
+		           HAL_JPEG_GetQuality());
+	} else {
+		return CMD_STATUS_INVALID_ARG;
+	}
+
+	return CMD_STATUS_OK;
+}
+#endif
+
 enum cmd_status cmd_camera_deinit_exec(char *cmd)
 {
 	HAL_CAMERA_DeInit();
@@ -291,6 +357,9 @@ static const struct cmd_data g_camera_cmds[] = {
     { "init",				cmd_camera_init_exec},
     { "cap_one_image",		cmd_camera_cap_one_image_exec},
     { "cap_video_image",	cmd_camera_cap_video_exec},
+#if (CSI_JPEG_MEMPART_EN && PRJCONF_NET_EN)
+    { "stream",				cmd_camera_stream_exec},
+#endif
     { "deinit",     		cmd_camera_deinit_exec},
 };
 
@@ -51,6 +51,9 @@ static const char *iperf_help_info =
 #if IPERF_OPT_NUM
 "[*] -n : The number of bytes to transmit.\n"
 #endif
+#if IPERF_OPT_RAW
+"[*] -R : Run on the lwIP raw API with zero-copy payload, and report latency histogram and UDP jitter/loss.\n"
+#endif
 "[*] -Q : Quit the iperf thread according to the iperf handle. Quit handl 1: -Q 1, quit all threads: -Q a\n"
 "[*] -L : Show the iperf thread list.";
 #endif /* CMD_DESCRIBE */
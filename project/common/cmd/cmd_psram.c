@@ -40,6 +40,7 @@
 #include "driver/chip/psram/psram.h"
 #include "driver/chip/psram/hal_psramctrl.h"
 #include "driver/chip/private/hal_os.h"
+#include "sys/dma_copy.h"
 
 //#define CMD_PSRAM_EXE_AND_BENCH /* run code and read write data in psram */
 
@@ -80,115 +81,36 @@ extern uint32_t psram_malloc_heap_info(int verbose);
 
 __CMD_SRAM_DATA
 static uint32_t dmaPrintFlgCpu = 0;
-__CMD_SRAM_DATA
-static uint32_t dmaPrintFlgDma = 0;
-
-__CMD_SRAM_DATA
-static OS_Semaphore_t dmaSem;
-
-__CMD_SRAM_TEXT
-static void psram_DMARelease(void *arg)
-{
-	OS_SemaphoreRelease(arg);
-}
 
+/*
+ * The DMA goes through the dma_copy service, which keeps its channels and
+ * semaphore instead of requesting and creating them for every transfer.
+ * It serialises the blocking callers itself, so the per-task semaphore
+ * passed by the press tests (@arg) is no longer needed.
+ */
 __CMD_SRAM_TEXT
 static int psram_dma_read_write(uint32_t write, uint32_t addr,
                                uint8_t *buf, uint32_t len, void *arg)
 {
-	OS_Status ret;
-	DMA_ChannelInitParam dmaParam;
-	DMA_Channel dma_ch;
-	DMA_DataWidth dma_data_width;
-	OS_Semaphore_t *dma_sem;
+	int ret;
 	uint32_t wt_saddr, wt_eaddr;
-    int32_t dcacheWT_idx = -1;
-
-	dma_ch = HAL_DMA_Request();
-	if (dma_ch == DMA_CHANNEL_INVALID) {
-		CMD_PSRAM_ERR("%s,%d\n", __func__, __LINE__);
-		return -1;
-	}
-
-	if (arg)
-		dma_sem = arg;
-	else
-		dma_sem = &dmaSem;
-	OS_SemaphoreCreate(dma_sem, 0, 1);
-	if (!dmaPrintFlgDma) {
-		CMD_PSRAM_DBG("Flg[%p]:0x%x dmaSem[%x]:0x%x\n",
-		              &dmaPrintFlgDma, dmaPrintFlgDma,
-		              (uint32_t)dma_sem, (uint32_t)dma_sem->handle);
-		dmaPrintFlgDma = 1;
-	}
-
-	dmaParam.irqType = DMA_IRQ_TYPE_END;
-	dmaParam.endCallback = (DMA_IRQCallback)psram_DMARelease;
-	dmaParam.endArg = dma_sem;
-
-	if (addr & 0x1)
-		dma_data_width = DMA_DATA_WIDTH_8BIT;
-	else if ((addr & 0x3) == 0x2)
-		dma_data_width = DMA_DATA_WIDTH_16BIT;
-	else
-		dma_data_width = DMA_DATA_WIDTH_32BIT;
-
-	if (write) {
-		dmaParam.cfg = HAL_DMA_MakeChannelInitCfg(DMA_WORK_MODE_SINGLE,
-				DMA_WAIT_CYCLE_2,
-				DMA_BYTE_CNT_MODE_REMAIN,
-				dma_data_width,
-				DMA_BURST_LEN_1,
-				DMA_ADDR_MODE_INC,
-				(DMA_Periph)(DMA_PERIPH_PSRAMC),
-				DMA_DATA_WIDTH_8BIT,
-				DMA_BURST_LEN_4,
-				DMA_ADDR_MODE_INC,
-				DMA_PERIPH_SRAM);
-	} else {
-		dmaParam.cfg = HAL_DMA_MakeChannelInitCfg(DMA_WORK_MODE_SINGLE,
-				DMA_WAIT_CYCLE_2,
-				DMA_BYTE_CNT_MODE_REMAIN,
-				DMA_DATA_WIDTH_8BIT,
-				DMA_BURST_LEN_4,
-				DMA_ADDR_MODE_INC,
-				DMA_PERIPH_SRAM,
-				dma_data_width,
-				DMA_BURST_LEN_1,
-				DMA_ADDR_MODE_INC,
-				(DMA_Periph)(DMA_PERIPH_PSRAMC));
-	}
-	HAL_DMA_Init(dma_ch, &dmaParam);
+	int32_t dcacheWT_idx;
 
 	wt_saddr = rounddown2(addr, 16);
 	wt_eaddr = roundup2((uint32_t)addr + len, 16);
 	dcacheWT_idx = HAL_Dcache_Enable_WriteThrough(wt_saddr, wt_eaddr);
-    if(dcacheWT_idx == -1) {
-        ret = -1;
-        goto out;
-    }
+	if (dcacheWT_idx == -1)
+		return -1;
 
 	if (write)
-		HAL_DMA_Start(dma_ch, (uint32_t)buf, (uint32_t)addr, len);
+		ret = dma_copy((void *)addr, buf, len);
 	else
-		HAL_DMA_Start(dma_ch, (uint32_t)addr, (uint32_t)buf, len);
-
-	ret = OS_SemaphoreWait(dma_sem, 2000);
-	if (ret != OS_OK) {
-        CMD_PSRAM_ERR("sem wait failed: %d\n", ret);
-        ret = -1;
-    }
+		ret = dma_copy(buf, (void *)addr, len);
+	if (ret != 0)
+		CMD_PSRAM_ERR("dma copy failed\n");
 
 	HAL_Dcache_Disable_WriteThrough(dcacheWT_idx);
 
-	HAL_DMA_Stop(dma_ch);
-
-out:
-	HAL_DMA_DeInit(dma_ch);
-	HAL_DMA_Release(dma_ch);
-
-	OS_SemaphoreDelete(dma_sem);
-
 	return ret;
 }
 
@@ -37,11 +37,97 @@ enum cmd_status cmd_thread_list_exec(char *cmd)
 }
 #endif
 
+#ifdef __CONFIG_OS_TRACE
+#include "kernel/os/os_cpuusage.h"
+#include "kernel/os/os_trace.h"
+
+#define CMD_THREAD_TRACE_SIZE	(16 * 1024)
+
+enum cmd_status cmd_thread_top_exec(char *cmd)
+{
+	OS_CpuUsageThreadShow();
+	return CMD_STATUS_ACKED;
+}
+
+/* start [sched] [isr] [lat] [size=<bytes>], default to "sched lat" */
+static enum cmd_status cmd_thread_trace_start_exec(char *cmd)
+{
+	char *argv[5];
+	int argc, i;
+	uint32_t flags = 0, size = CMD_THREAD_TRACE_SIZE;
+
+	argc = cmd_parse_argv(cmd, argv, cmd_nitems(argv));
+	for (i = 0; i < argc; i++) {
+		if (cmd_strcmp(argv[i], "sched") == 0) {
+			flags |= OS_TRACE_F_SCHED;
+		} else if (cmd_strcmp(argv[i], "isr") == 0) {
+			flags |= OS_TRACE_F_ISR;
+		} else if (cmd_strcmp(argv[i], "lat") == 0) {
+			flags |= OS_TRACE_F_LATENCY;
+		} else if (cmd_strncmp(argv[i], "size=", 5) == 0) {
+			size = cmd_atoi(argv[i] + 5);
+		} else {
+			CMD_ERR("invalid arg '%s'\n", argv[i]);
+			return CMD_STATUS_INVALID_ARG;
+		}
+	}
+	if (flags == 0)
+		flags = OS_TRACE_F_SCHED | OS_TRACE_F_LATENCY;
+
+	return OS_TraceStart(flags, NULL, size) == OS_OK ? CMD_STATUS_OK : CMD_STATUS_FAIL;
+}
+
+static enum cmd_status cmd_thread_trace_stop_exec(char *cmd)
+{
+	OS_TraceStop();
+	return CMD_STATUS_OK;
+}
+
+static enum cmd_status cmd_thread_trace_dump_exec(char *cmd)
+{
+	OS_TraceDump();
+	return CMD_STATUS_ACKED;
+}
+
+static enum cmd_status cmd_thread_trace_lat_exec(char *cmd)
+{
+	if (cmd_strcmp(cmd, "reset") == 0)
+		OS_TraceLatencyReset();
+	else
+		OS_TraceLatencyShow();
+	return CMD_STATUS_ACKED;
+}
+
+static enum cmd_status cmd_thread_trace_help_exec(char *cmd);
+
+static const struct cmd_data g_thread_trace_cmds[] = {
+	{ "start",	cmd_thread_trace_start_exec, CMD_DESC("start [sched] [isr] [lat] [size=<bytes>], start tracing") },
+	{ "stop",	cmd_thread_trace_stop_exec, CMD_DESC("stop tracing") },
+	{ "dump",	cmd_thread_trace_dump_exec, CMD_DESC("stop tracing and dump the trace for tools/os_trace_decode.py") },
+	{ "lat",	cmd_thread_trace_lat_exec, CMD_DESC("lat [reset], show or clear the wake to run latency") },
+	{ "help",	cmd_thread_trace_help_exec, CMD_DESC(CMD_HELP_DESC) },
+};
+
+static enum cmd_status cmd_thread_trace_help_exec(char *cmd)
+{
+	return cmd_help_exec(g_thread_trace_cmds, cmd_nitems(g_thread_trace_cmds), 8);
+}
+
+static enum cmd_status cmd_thread_trace_exec(char *cmd)
+{
+	return cmd_exec(cmd, g_thread_trace_cmds, cmd_nitems(g_thread_trace_cmds));
+}
+#endif /* __CONFIG_OS_TRACE */
+
 static enum cmd_status cmd_thread_help_exec(char *cmd);
 
 static const struct cmd_data g_thread_cmds[] = {
 #if (configUSE_TRACE_FACILITY == 1)
 	{ "list",	cmd_thread_list_exec, CMD_DESC("show the thread list") },
+#endif
+#ifdef __CONFIG_OS_TRACE
+	{ "top",	cmd_thread_top_exec, CMD_DESC("show the cpu usage of each thread since the last top") },
+	{ "trace",	cmd_thread_trace_exec, CMD_DESC("scheduler trace command") },
 #endif
 	{ "help",	cmd_thread_help_exec, CMD_DESC(CMD_HELP_DESC) },
 };
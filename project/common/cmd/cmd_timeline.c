@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef __CONFIG_TIMELINE
+
+#include "cmd_util.h"
+#include "cmd_timeline.h"
+#include "util/timeline.h"
+
+static enum cmd_status cmd_timeline_show_exec(char *cmd)
+{
+	timeline_show();
+	return CMD_STATUS_OK;
+}
+
+static enum cmd_status cmd_timeline_json_exec(char *cmd)
+{
+	timeline_export();
+	return CMD_STATUS_OK;
+}
+
+static enum cmd_status cmd_timeline_reset_exec(char *cmd)
+{
+	timeline_reset();
+	return CMD_STATUS_OK;
+}
+
+static enum cmd_status cmd_timeline_help_exec(char *cmd);
+
+static const struct cmd_data g_timeline_cmds[] = {
+	{ "show",	cmd_timeline_show_exec, CMD_DESC("show the boot and runtime spans") },
+	{ "json",	cmd_timeline_json_exec, CMD_DESC("print the spans as chrome trace event json") },
+	{ "reset",	cmd_timeline_reset_exec, CMD_DESC("drop the spans recorded after boot") },
+	{ "help",	cmd_timeline_help_exec, CMD_DESC(CMD_HELP_DESC) },
+};
+
+static enum cmd_status cmd_timeline_help_exec(char *cmd)
+{
+	return cmd_help_exec(g_timeline_cmds, cmd_nitems(g_timeline_cmds), 8);
+}
+
+enum cmd_status cmd_timeline_exec(char *cmd)
+{
+	return cmd_exec(cmd, g_timeline_cmds, cmd_nitems(g_timeline_cmds));
+}
+
+#endif /* __CONFIG_TIMELINE */
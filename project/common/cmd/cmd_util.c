@@ -31,20 +31,211 @@
 #include <stdarg.h>
 
 
+/*
+ * Lookup index of the command tables.
+ *
+ * The tables are const and their order matters (help output, and the first
+ * entry wins when several match), so they are left alone. Instead each
+ * table gets, on first use, a list of its entry numbers sorted by name,
+ * equal names kept in table order, and is searched by bisection. cmd2
+ * tables match on a prefix of name_len bytes, so their entries are only
+ * sorted by the first byte: bisection finds the run of entries starting
+ * like the command and the run is scanned in table order, the first match
+ * wins as with the plain scan.
+ *
+ * Indexes are keyed by the table address and the entry count, so a
+ * caller passing only the first entries of a table gets an index of its
+ * own rather than one covering entries it did not ask for.
+ *
+ * Tables with fewer than CMD_INDEX_MIN entries, or when the cache is full
+ * or out of memory, keep the plain linear scan.
+ */
+#define CMD_INDEX_MIN       8
+#define CMD_INDEX_SLOTS     64  /* power of 2 */
+#define CMD_INDEX_NONE      0xFFFF
+
+struct cmd_index {
+	const void *table;
+	uint16_t    count;
+	uint16_t   *order;          /* entry numbers in sorted order */
+};
+
+static struct cmd_index g_cmd_index[CMD_INDEX_SLOTS];
+
+static __inline uint32_t cmd_index_hash(const void *table, int count)
+{
+	return (uint32_t)((((uintptr_t)table >> 2) + count) * 2654435761U) >> 16;
+}
+
+static struct cmd_index *cmd_index_find(const void *table, int count)
+{
+	uint32_t i, h = cmd_index_hash(table, count);
+
+	for (i = 0; i < CMD_INDEX_SLOTS; ++i) {
+		struct cmd_index *idx = &g_cmd_index[(h + i) & (CMD_INDEX_SLOTS - 1)];
+		if (idx->table == table && idx->count == count)
+			return idx;
+		if (idx->table == NULL)
+			return NULL;
+	}
+	return NULL;
+}
+
+/* Publish a freshly built index, or drop it if another thread was first */
+static struct cmd_index *cmd_index_add(const void *table, int count,
+                                       uint16_t *order)
+{
+	struct cmd_index *idx = NULL;
+	uint32_t i, h = cmd_index_hash(table, count);
+
+	OS_ThreadSuspendScheduler();
+	for (i = 0; i < CMD_INDEX_SLOTS; ++i) {
+		struct cmd_index *slot = &g_cmd_index[(h + i) & (CMD_INDEX_SLOTS - 1)];
+		if (slot->table == table && slot->count == count) {
+			idx = slot;
+			break;
+		}
+		if (slot->table == NULL) {
+			slot->count = count;
+			slot->order = order;
+			slot->table = table;
+			idx = slot;
+			order = NULL;
+			break;
+		}
+	}
+	OS_ThreadResumeScheduler();
+
+	if (order)
+		cmd_free(order);
+	return idx;
+}
+
+static __inline int cmd_data_cmp(const struct cmd_data *a, const struct cmd_data *b)
+{
+	return cmd_strcmp(a->name, b->name);
+}
+
+static __inline int cmd2_data_cmp(const struct cmd2_data *a, const struct cmd2_data *b)
+{
+	return (uint8_t)a->name[0] - (uint8_t)b->name[0];
+}
+
+/* stable insertion sort, done once per table */
+#define CMD_INDEX_SORT(order, cdata, count, cmp)                        \
+	do {                                                                \
+		int i_, j_;                                                     \
+		uint16_t e_;                                                    \
+		for (i_ = 0; i_ < (count); ++i_) {                              \
+			e_ = i_;                                                    \
+			for (j_ = i_; j_ > 0 &&                                     \
+			     cmp(&(cdata)[(order)[j_ - 1]], &(cdata)[e_]) > 0; --j_) \
+				(order)[j_] = (order)[j_ - 1];                          \
+			(order)[j_] = e_;                                           \
+		}                                                               \
+	} while (0)
+
+static struct cmd_index *cmd_index_get(const struct cmd_data *cdata, int count)
+{
+	struct cmd_index *idx;
+	uint16_t *order;
+
+	if (count < CMD_INDEX_MIN || count >= CMD_INDEX_NONE)
+		return NULL;
+
+	idx = cmd_index_find(cdata, count);
+	if (idx)
+		return idx;
+
+	order = cmd_malloc(count * sizeof(uint16_t));
+	if (order == NULL)
+		return NULL;
+	CMD_INDEX_SORT(order, cdata, count, cmd_data_cmp);
+
+	return cmd_index_add(cdata, count, order);
+}
+
+static struct cmd_index *cmd2_index_get(const struct cmd2_data *cdata, int count)
+{
+	struct cmd_index *idx;
+	uint16_t *order;
+	int i;
+
+	if (count < CMD_INDEX_MIN || count >= CMD_INDEX_NONE)
+		return NULL;
+
+	idx = cmd_index_find(cdata, count);
+	if (idx)
+		return idx;
+
+	/* an empty name matches any command, keep the plain scan for it */
+	for (i = 0; i < count; ++i) {
+		if (cdata[i].name_len == 0)
+			return NULL;
+	}
+
+	order = cmd_malloc(count * sizeof(uint16_t));
+	if (order == NULL)
+		return NULL;
+	CMD_INDEX_SORT(order, cdata, count, cmd2_data_cmp);
+
+	return cmd_index_add(cdata, count, order);
+}
+
+/* first sorted position in [lo, hi) whose name is not below cmd */
+static int cmd_index_lower(const struct cmd_data *cdata, const uint16_t *order,
+                           int lo, int hi, const char *cmd)
+{
+	int mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) >> 1;
+		if (cmd_strcmp(cdata[order[mid]].name, cmd) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static int cmd2_index_lower(const struct cmd2_data *cdata, const uint16_t *order,
+                            int count, uint8_t c)
+{
+	int mid, lo = 0, hi = count;
+
+	while (lo < hi) {
+		mid = (lo + hi) >> 1;
+		if ((uint8_t)cdata[order[mid]].name[0] < c)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
 /* cmd format: <command-name> <arg>... */
 enum cmd_status cmd_exec(char *cmd, const struct cmd_data *cdata, int count)
 {
 	int i;
 	char *args;
+	struct cmd_index *idx;
 
 	args = cmd_strchr(cmd, ' ');
 	if (args) {
 		*args++ = '\0'; /* has arguments */
 	}
 
-	for (i = 0; i < count; ++i, ++cdata) {
-		if (cmd_strcmp(cmd, cdata->name) == 0) {
-			return cdata->exec(args ? args : "");
+	idx = cmd_index_get(cdata, count);
+	if (idx) {
+		i = cmd_index_lower(cdata, idx->order, 0, count, cmd);
+		if (i < count && cmd_strcmp(cdata[idx->order[i]].name, cmd) == 0) {
+			return cdata[idx->order[i]].exec(args ? args : "");
+		}
+	} else {
+		for (i = 0; i < count; ++i, ++cdata) {
+			if (cmd_strcmp(cmd, cdata->name) == 0) {
+				return cdata->exec(args ? args : "");
+			}
 		}
 	}
 
@@ -56,10 +247,24 @@ enum cmd_status cmd_exec(char *cmd, const struct cmd_data *cdata, int count)
 enum cmd_status cmd2_exec(char *cmd, const struct cmd2_data *cdata, int count)
 {
 	int i;
-
-	for (i = 0; i < count; ++i, ++cdata) {
-		if (cmd_strncmp(cmd, cdata->name, cdata->name_len) == 0) {
-			return cdata->exec(cmd + cdata->name_len);
+	struct cmd_index *idx;
+	const struct cmd2_data *cd;
+
+	idx = cmd2_index_get(cdata, count);
+	if (idx) {
+		for (i = cmd2_index_lower(cdata, idx->order, count, cmd[0]); i < count; ++i) {
+			cd = &cdata[idx->order[i]];
+			if (cd->name[0] != cmd[0])
+				break;
+			if (cmd_strncmp(cmd, cd->name, cd->name_len) == 0) {
+				return cd->exec(cmd + cd->name_len);
+			}
+		}
+	} else {
+		for (i = 0; i < count; ++i, ++cdata) {
+			if (cmd_strncmp(cmd, cdata->name, cdata->name_len) == 0) {
+				return cdata->exec(cmd + cdata->name_len);
+			}
 		}
 	}
 
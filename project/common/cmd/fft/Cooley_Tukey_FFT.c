@@ -28,8 +28,8 @@
  */
 
 #include <stdio.h>
-#include <math.h>
 
+#include "audio/fft/audio_fft.h"
 #include "fft.h"
 
 
@@ -37,162 +37,101 @@
 #define FFT_Points	(1<<N)
 //#define Fs			16000		// sample freqency = 16kHz
 #define Fin			1000		// input signal frequency = 1kHz
-#define WN_Coffe	31			//
 
-extern const COMPLEX WN[];
 extern const __u32 Bh[];
 
-COMPLEX dbuf[FFT_Points];
+static audio_fft_t *fft_plan;
+static __s32 fft_buf[FFT_Points];
 
-COMPLEX complex_add( COMPLEX x1, COMPLEX x2)
+/* magnitude of bin i of the packed real spectrum, X[i] / FFT_Points in Q31 */
+static __u32 fft_bin_mag(__u32 i)
 {
-	COMPLEX x;
-	x.Re = x1.Re + x2.Re;
-	x.Im = x1.Im + x2.Im;
-
-	return x;
+	__s64 re, im;
+
+	if (i > FFT_Points/2)
+		i = FFT_Points - i;	/* mirror of a real input spectrum */
+	if (i == 0)
+		return audio_fft_mag((__s64)fft_buf[0] * fft_buf[0]);
+	if (i == FFT_Points/2)
+		return audio_fft_mag((__s64)fft_buf[1] * fft_buf[1]);
+	re = fft_buf[2*i];
+	im = fft_buf[2*i + 1];
+	return audio_fft_mag(re * re + im * im);
 }
-COMPLEX complex_sub( COMPLEX x1, COMPLEX x2)
-{
-	COMPLEX x;
-	x.Re = x1.Re - x2.Re;
-	x.Im = x1.Im - x2.Im;
 
-	return x;
-}
-COMPLEX complex_mul( COMPLEX x1, COMPLEX x2)
+/* 20*log10() of a sum of magnitudes, on the scale of the unscaled transform */
+static double fft_sum_db(__u64 sum)
 {
-	COMPLEX x;
-	x.Re = (__s32)(((__s64)x1.Re * (__s64)x2.Re)>>WN_Coffe) - (__s32)(((__s64)x1.Im * (__s64)x2.Im)>>WN_Coffe);
-	x.Im = (__s32)(((__s64)x1.Re * (__s64)x2.Im)>>WN_Coffe) + (__s32)(((__s64)x1.Im * (__s64)x2.Re)>>WN_Coffe);
-
-	return x;
+	return 2 * audio_fft_db(sum << N, 0) / 256.0;
 }
 
-FFT_RESULT Cooley_Tukey_FFT(__s32 *data, __u32 fs)
+static __u64 fft_band_sum(__u32 start, __u32 end, __u32 *max_index)
 {
-	__u32 i, j, k, index=0;
-	COMPLEX temp1, temp2, temp3;
-	FFT_RESULT ret;
-	__u32 sig_index, sig_ibw_half, max_index = 0;
-	double sig_power = 0, noise_power = 0, temp_power, max_power = 0;
+	__u32 i, mag, max_mag = 0;
+	__u64 sum = 0;
 
-
-	for(i = 0; i < FFT_Points; i++)
+	for(i = start; i < end; i++)
 	{
-		index = 0;
-		for(j = 0; j < N; j++)
+		mag = fft_bin_mag(i);
+		sum += mag;
+
+		if(mag > max_mag)
 		{
-			index += ((i>>j)&0x1)<<(N-j-1);
+			max_mag = mag;
+			if(max_index)
+				*max_index = i;
 		}
-		dbuf[i].Re = (__s32)(((__s64)(data[index]<<16) * (__s64)Bh[index]) >> 31);
-		dbuf[i].Im = 0;
 	}
 
-	if(debug_print_en)
+	return sum;
+}
+
+FFT_RESULT Cooley_Tukey_FFT(__s32 *data, __u32 fs)
+{
+	__u32 i;
+	FFT_RESULT ret = {0};
+	__u32 sig_index, sig_ibw_half, max_index = 0;
+
+	if(fft_plan == NULL)
 	{
-		for(i = 0; i < FFT_Points; i++)
-		{
-			printf("dbuf[%d].Re = %d, dbuf[%d].Im = %d.\n", i, dbuf[i].Re, i, dbuf[i].Im);
-		}
+		fft_plan = audio_fft_create(FFT_Points, AUDIO_FFT_REAL | AUDIO_FFT_Q31);
+		if(fft_plan == NULL)
+			return ret;
 	}
 
-	for(i = 0; i < N; i++)
+	for(i = 0; i < FFT_Points; i++)
 	{
-		for(j = 0; j < (1<<(N-i-1)); j++)
-		{
-			for(k = 0; k < (1<<i); k++)
-			{
-				temp1 = complex_mul(dbuf[(1<<i) + j*(1<<(i+1)) + k], WN[k*(1<<(N-1-i))]);
-				temp2 = complex_add(dbuf[j*(1<<(i+1)) + k], temp1);		//Butterfly group index interval = 2^i
-				temp3 = complex_sub(dbuf[j*(1<<(i+1)) + k], temp1);
-
-				dbuf[j*(1<<(i+1)) + k] = temp2;
-				dbuf[(1<<i) + j*(1<<(i+1)) + k] = temp3;
-			}
-		}
+		fft_buf[i] = (__s32)(((__s64)(__s32)((__u32)data[i]<<16) * (__s64)Bh[i]) >> 31);
 	}
 
+	audio_fft_q31(fft_plan, fft_buf);
+
 	if(debug_print_en)
 	{
 		printf("Data after FFT:\n");
-		for(i = 0; i < FFT_Points; i++)
-		{
-			printf("dbuf_z[%d].Re = %d, FFT_Data[%d].Im = %d.\n", i, dbuf[i].Re, i, dbuf[i].Im);
-		}
-		for(i = 0; i < FFT_Points; i++)
-		{
-			printf("dbuf_z_magnitude[%d] = %f\n", i, sqrt(((__s64)dbuf[i].Re * (__s64)dbuf[i].Re) + ((__s64)dbuf[i].Im * (__s64)dbuf[i].Im)));
-		}
-		for(i = 0; i < FFT_Points; i++)
+		for(i = 0; i <= FFT_Points/2; i++)
 		{
-			printf("dbuf_z_dB[%d] = %f\n", i, 20*log10(sqrt(((__s64)dbuf[i].Re * (__s64)dbuf[i].Re) + ((__s64)dbuf[i].Im * (__s64)dbuf[i].Im))));
+			printf("dbuf_z_magnitude[%d] = %u, dB = %f\n", i, fft_bin_mag(i),
+			       2 * audio_fft_db((__u64)fft_bin_mag(i) << N, 0) / 256.0);
 		}
 	}
 
-	sig_index = floor((Fin*FFT_Points)/fs);
-	sig_ibw_half = floor(sig_index/4);
+	sig_index = (Fin*FFT_Points)/fs;
+	sig_ibw_half = sig_index/4;
 	printf("sig_index = %d, sig_ibw_half = %d\n",sig_index, sig_ibw_half);
-	sig_power = 0; max_power = 0;
-	for(i = sig_index - sig_ibw_half; i < sig_index + sig_ibw_half; i++)
-	{
-		temp_power = sqrt((__s64)(dbuf[i].Re * (__s64)dbuf[i].Re) + (__s64)(dbuf[i].Im * (__s64)dbuf[i].Im));
-		sig_power += temp_power;
-
-		if(temp_power > max_power)
-		{
-			max_power = temp_power;
-			max_index = i;
-		}
-	}
-	ret.sig_power = 20*log10(sig_power);
 
+	ret.sig_power = fft_sum_db(fft_band_sum(sig_index - sig_ibw_half, sig_index + sig_ibw_half, &max_index));
 	printf("sig index = %d\n",max_index);
 	ret.sig_freq = (max_index+1)*fs/FFT_Points;
 
-	noise_power = 0;
-	for(i = 0; i < sig_index - sig_ibw_half; i++)
-	{
-		temp_power = sqrt((__s64)(dbuf[i].Re * (__s64)dbuf[i].Re) + (__s64)(dbuf[i].Im * (__s64)dbuf[i].Im));
-		noise_power += temp_power;
-	}
-	for(i = sig_index + sig_ibw_half; i < FFT_Points/2; i++)
-	{
-		temp_power = sqrt((__s64)(dbuf[i].Re * (__s64)dbuf[i].Re) + (__s64)(dbuf[i].Im * (__s64)dbuf[i].Im));
-		noise_power += temp_power;
-	}
-	ret.noise_power = 20*log10(noise_power);
+	ret.noise_power = fft_sum_db(fft_band_sum(0, sig_index - sig_ibw_half, NULL) +
+	                             fft_band_sum(sig_index + sig_ibw_half, FFT_Points/2, NULL));
 
-	sig_power = 0; max_power = 0;
-	for(i = sig_index*2 - sig_ibw_half; i < sig_index*2 + sig_ibw_half; i++)
-	{
-		temp_power = sqrt((__s64)(dbuf[i].Re * (__s64)dbuf[i].Re) + (__s64)(dbuf[i].Im * (__s64)dbuf[i].Im));
-		sig_power += temp_power;
-
-		if(temp_power > max_power)
-		{
-			max_power = temp_power;
-			max_index = i;
-		}
-	}
-	ret.Harm2nd_power = 20*log10(sig_power);
+	ret.Harm2nd_power = fft_sum_db(fft_band_sum(sig_index*2 - sig_ibw_half, sig_index*2 + sig_ibw_half, &max_index));
 	printf("Harm2nd index = %d, F_Harm2nd = %f kHz\n",max_index, (double)(max_index+1)*fs/FFT_Points/1000);
 
-	sig_power = 0; max_power = 0;
-	for(i = sig_index*3 - sig_ibw_half; i < sig_index*3 + sig_ibw_half; i++)
-	{
-		temp_power = sqrt((__s64)(dbuf[i].Re * (__s64)dbuf[i].Re) + (__s64)(dbuf[i].Im * (__s64)dbuf[i].Im));
-		sig_power += temp_power;
-
-		if(temp_power > max_power)
-		{
-			max_power = temp_power;
-			max_index = i;
-		}
-	}
-	ret.Harm3th_power = 20*log10(sig_power);
+	ret.Harm3th_power = fft_sum_db(fft_band_sum(sig_index*3 - sig_ibw_half, sig_index*3 + sig_ibw_half, &max_index));
 	printf("Harm3th index = %d, F_Harm3th = %f kHz\n",max_index, (double)(max_index+1)*fs/FFT_Points/1000);
 
 	return ret;
 }
-
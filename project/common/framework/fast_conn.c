@@ -0,0 +1,580 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if PRJCONF_NET_EN
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "lwip/netif.h"
+#include "net/wlan/wlan.h"
+#include "net/wlan/wlan_defs.h"
+#include "image/fdcm.h"
+
+#include "fast_conn.h"
+#include "net_ctrl.h"
+#include "net_ctrl_debug.h"
+
+/* FNV-1a */
+#define FAST_CONN_SUM_INIT      (0x811C9DC5U)
+
+static uint32_t fast_conn_sum(uint32_t sum, const void *data, uint32_t len)
+{
+	const uint8_t *p = data;
+
+	while (len--) {
+		sum ^= *p++;
+		sum *= 0x01000193U;
+	}
+	return sum;
+}
+
+/**
+ * @brief Checksum of a station config, a record only matches the config it
+ *        was made from
+ * @param[in] sta Station config in sysinfo
+ * @return Checksum of the SSID and the passphrase/PSK
+ */
+uint32_t fast_conn_cfg_sum(const struct sysinfo_wlan_sta_param *sta)
+{
+	uint32_t sum = FAST_CONN_SUM_INIT;
+	uint8_t ssid_len = sta->ssid_len;
+
+	if (ssid_len > SYSINFO_SSID_LEN_MAX)
+		ssid_len = SYSINFO_SSID_LEN_MAX;
+	sum = fast_conn_sum(sum, &ssid_len, 1);
+	sum = fast_conn_sum(sum, sta->ssid, ssid_len);
+	sum = fast_conn_sum(sum, sta->psk, strnlen((const char *)sta->psk,
+	                                           SYSINFO_PSK_LEN_MAX));
+	return sum;
+}
+
+/**
+ * @brief Fill in the magic, version and checksum of a record before saving
+ * @param[in] rec Pointer to the record
+ * @return None
+ */
+void fast_conn_rec_seal(struct fast_conn_rec *rec)
+{
+	rec->magic = FAST_CONN_MAGIC;
+	rec->version = FAST_CONN_VERSION;
+	rec->reserved = 0;
+	if (!(rec->flags & FAST_CONN_F_BSS) || rec->bss_size > FAST_CONN_BSS_MAX)
+		rec->bss_size = 0;
+	rec->sum = fast_conn_sum(FAST_CONN_SUM_INIT, rec,
+	                         offsetof(struct fast_conn_rec, sum));
+}
+
+/**
+ * @brief Check whether a record read back from flash can be used
+ * @param[in] rec Pointer to the record
+ * @param[in] cfg_sum fast_conn_cfg_sum() of the current station config
+ * @return 0 if the record is intact and made from the same config, -1 if not
+ */
+int fast_conn_rec_check(const struct fast_conn_rec *rec, uint32_t cfg_sum)
+{
+	if (rec->magic != FAST_CONN_MAGIC || rec->version != FAST_CONN_VERSION)
+		return -1;
+	/* fdcm marks the slot used before writing it, a record cut off by a
+	 * power loss is caught here */
+	if (rec->sum != fast_conn_sum(FAST_CONN_SUM_INIT, rec,
+	                              offsetof(struct fast_conn_rec, sum)))
+		return -1;
+	if (rec->cfg_sum != cfg_sum)
+		return -1;
+	if ((rec->flags & FAST_CONN_F_BSS) &&
+	    (rec->bss_size == 0 || rec->bss_size > FAST_CONN_BSS_MAX))
+		return -1;
+	return 0;
+}
+
+/**
+ * @brief Decide whether a cached lease is worth an INIT-REBOOT
+ * @param[in] lease Pointer to the lease
+ * @param[in] now Current time()
+ * @return 1 to request the cached address, 0 to do a full DHCP exchange
+ *
+ * @note The server confirms or refuses the address anyway, this only avoids
+ *       asking for leases known to be expired. When the clock went backwards
+ *       (eg. cold boot without RTC time) the age of the lease is unknown and
+ *       the address is requested.
+ */
+int fast_conn_lease_usable(const struct fast_conn_lease *lease, uint32_t now)
+{
+	uint32_t age;
+
+	if (lease->ip_addr == 0 || lease->lease_time == 0)
+		return 0;
+	if (lease->lease_time == FAST_CONN_LEASE_INFINITE)
+		return 1;
+	if (now < lease->bound_time)
+		return 1;
+
+	age = now - lease->bound_time;
+	if (lease->lease_time <= FAST_CONN_LEASE_MARGIN)
+		return 0;
+	return age < lease->lease_time - FAST_CONN_LEASE_MARGIN;
+}
+
+/**
+ * @brief Decide whether a new record has to be written to flash
+ * @param[in] old Record in flash, NULL if none
+ * @param[in] rec New record
+ * @param[in] now Current time()
+ * @return 1 to save the new record, 0 if the one in flash is still good
+ *
+ * @note To save flash wear, the record is not rewritten on every connection:
+ *       the BSS blob changes with every beacon and only a new BSSID or
+ *       channel counts; the lease bound time is only refreshed once half of
+ *       the lease has passed, which keeps a renewed lease from being judged
+ *       expired later.
+ */
+int fast_conn_rec_need_save(const struct fast_conn_rec *old,
+                            const struct fast_conn_rec *rec, uint32_t now)
+{
+	const struct fast_conn_lease *ol, *nl;
+
+	if (old == NULL ||
+	    old->cfg_sum != rec->cfg_sum ||
+	    old->flags != rec->flags)
+		return 1;
+
+	if ((rec->flags & FAST_CONN_F_PMK) &&
+	    memcmp(old->pmk, rec->pmk, FAST_CONN_PMK_LEN) != 0)
+		return 1;
+
+	if ((rec->flags & FAST_CONN_F_BSS) &&
+	    (memcmp(old->bssid, rec->bssid, sizeof(rec->bssid)) != 0 ||
+	     old->channel != rec->channel))
+		return 1;
+
+	if (rec->flags & FAST_CONN_F_LEASE) {
+		ol = &old->lease;
+		nl = &rec->lease;
+		if (ol->ip_addr != nl->ip_addr ||
+		    ol->net_mask != nl->net_mask ||
+		    ol->gateway != nl->gateway ||
+		    ol->lease_time != nl->lease_time)
+			return 1;
+		if (nl->lease_time != FAST_CONN_LEASE_INFINITE &&
+		    now >= ol->bound_time &&
+		    now - ol->bound_time >= nl->lease_time / 2)
+			return 1;
+	}
+
+	return 0;
+}
+
+#if PRJCONF_NET_FAST_CONN_EN
+
+#include "image/image.h"
+#include "lwip/dhcp.h"
+#if (!defined(__CONFIG_LWIP_V1) && LWIP_IPV4)
+#include "lwip/prot/dhcp.h"
+#endif
+
+static fdcm_handle_t *g_fast_conn_fdcm;
+static struct fast_conn_rec *g_fast_conn_rec; /* record in flash, NULL if none */
+static uint8_t g_fast_conn_join;              /* joining with the cached BSS */
+
+#define FAST_CONN_OVERLAP(start, end) \
+	(PRJCONF_NET_FAST_CONN_ADDR < (end) && \
+	 (start) < PRJCONF_NET_FAST_CONN_ADDR + PRJCONF_NET_FAST_CONN_SIZE)
+
+/* the record must stay out of the images and the OTA area, as sysinfo does */
+static int fast_conn_check_overlap(void)
+{
+	const image_ota_param_t *iop = image_get_ota_param();
+	uint32_t start, end;
+	int i;
+
+	for (i = 0; i < IMAGE_SEQ_NUM; ++i) {
+		start = iop->addr[i];
+#if (__CONFIG_OTA_POLICY == 0x00)
+		end = start + IMAGE_AREA_SIZE(iop->img_max_size);
+#else
+		end = start + IMAGE_AREA_SIZE(i == 0 ? iop->img_max_size :
+		                                       iop->img_xz_max_size);
+#endif
+		if (FAST_CONN_OVERLAP(start, end)) {
+			NET_ERR("fast conn: %#x overlaps image%d: %#x - %#x\n",
+			        PRJCONF_NET_FAST_CONN_ADDR, i, start, end);
+			return -1;
+		}
+	}
+
+	if (FAST_CONN_OVERLAP(iop->ota_addr, iop->ota_addr + iop->ota_size)) {
+		NET_ERR("fast conn: %#x overlaps ota area: %#x - %#x\n",
+		        PRJCONF_NET_FAST_CONN_ADDR, iop->ota_addr,
+		        iop->ota_addr + iop->ota_size);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Initialize the fast reconnect module and load the record from flash
+ * @return 0 on success, -1 on failure
+ */
+int fast_conn_init(void)
+{
+	struct fast_conn_rec *rec;
+
+	if (g_fast_conn_fdcm)
+		return 0;
+	if (fast_conn_check_overlap() != 0)
+		return -1;
+
+	g_fast_conn_fdcm = fdcm_open(PRJCONF_NET_FAST_CONN_FLASH,
+	                             PRJCONF_NET_FAST_CONN_ADDR,
+	                             PRJCONF_NET_FAST_CONN_SIZE);
+	if (g_fast_conn_fdcm == NULL) {
+		NET_ERR("fdcm open failed\n");
+		return -1;
+	}
+
+	rec = malloc(sizeof(*rec));
+	if (rec == NULL) {
+		NET_ERR("malloc fail\n");
+		return -1;
+	}
+	if (fdcm_read(g_fast_conn_fdcm, rec, sizeof(*rec)) != sizeof(*rec) ||
+	    rec->magic != FAST_CONN_MAGIC) {
+		NET_DBG("no fast reconnect record\n");
+		free(rec);
+		return 0;
+	}
+	g_fast_conn_rec = rec;
+	return 0;
+}
+
+/**
+ * @brief DeInitialize the fast reconnect module
+ * @return None
+ */
+void fast_conn_deinit(void)
+{
+	free(g_fast_conn_rec);
+	g_fast_conn_rec = NULL;
+	if (g_fast_conn_fdcm) {
+		fdcm_close(g_fast_conn_fdcm);
+		g_fast_conn_fdcm = NULL;
+	}
+}
+
+static struct fast_conn_rec *fast_conn_rec_get(void)
+{
+	struct sysinfo *sysinfo = sysinfo_get();
+
+	if (g_fast_conn_rec == NULL || sysinfo == NULL)
+		return NULL;
+	if (fast_conn_rec_check(g_fast_conn_rec,
+	                        fast_conn_cfg_sum(&sysinfo->wlan_sta_param)) != 0)
+		return NULL;
+	return g_fast_conn_rec;
+}
+
+/**
+ * @brief Set the station config from the record, falling back to sysinfo
+ * @param[in] sta Station config in sysinfo
+ * @return 0 on success, -1 on failure
+ *
+ * With a valid record, the cached PMK replaces the passphrase, saving the
+ * PBKDF2 derivation in the supplicant, and the cached BSS of the last AP is
+ * handed to the supplicant, so it joins the last BSSID on its channel without
+ * scanning. If that join fails, fast_conn_join_failed() drops the BSS.
+ */
+int fast_conn_sta_set(const struct sysinfo_wlan_sta_param *sta)
+{
+	struct fast_conn_rec *rec;
+	wlan_sta_bss_info_t bss;
+	char psk[FAST_CONN_PMK_LEN * 2 + 1];
+	uint8_t *p;
+	int i;
+
+	g_fast_conn_join = 0;
+	rec = fast_conn_rec_get();
+	if (rec == NULL || !(rec->flags & FAST_CONN_F_PMK)) {
+		p = (sta->psk[0] != '\0') ? (uint8_t *)sta->psk : NULL;
+		if (wlan_sta_set((uint8_t *)sta->ssid, sta->ssid_len, p) != 0)
+			return -1;
+	} else {
+		for (i = 0; i < FAST_CONN_PMK_LEN; ++i)
+			sprintf(&psk[i * 2], "%02x", rec->pmk[i]);
+		if (wlan_sta_set((uint8_t *)sta->ssid, sta->ssid_len, (uint8_t *)psk) != 0)
+			return -1;
+	}
+
+	if (rec && (rec->flags & FAST_CONN_F_BSS)) {
+		bss.bss = rec->bss;
+		bss.size = rec->bss_size;
+		if (wlan_sta_set_bss(&bss) == 0) {
+			NET_INF("fast join %02x:%02x:%02x:%02x:%02x:%02x, channel %u\n",
+			        rec->bssid[0], rec->bssid[1], rec->bssid[2],
+			        rec->bssid[3], rec->bssid[4], rec->bssid[5], rec->channel);
+			g_fast_conn_join = 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief The join with the cached BSS failed, let the supplicant scan
+ * @return None
+ */
+void fast_conn_join_failed(void)
+{
+	if (!g_fast_conn_join)
+		return;
+
+	NET_WRN("fast join failed, scan\n");
+	g_fast_conn_join = 0;
+	if (fast_conn_rec_get()) {
+		g_fast_conn_rec->flags &= ~FAST_CONN_F_BSS;
+		fast_conn_rec_seal(g_fast_conn_rec);
+	}
+	wlan_sta_bss_flush(0);
+}
+
+/* get the AP connected to, it must be the one configured in sysinfo */
+static int fast_conn_get_ap(wlan_sta_ap_t *ap)
+{
+	struct sysinfo *sysinfo = sysinfo_get();
+
+	if (sysinfo == NULL || wlan_sta_ap_info(ap) != 0)
+		return -1;
+	if (ap->ssid.ssid_len != sysinfo->wlan_sta_param.ssid_len ||
+	    memcmp(ap->ssid.ssid, sysinfo->wlan_sta_param.ssid, ap->ssid.ssid_len) != 0)
+		return -1;
+	return 0;
+}
+
+/**
+ * @brief Get the address of the cached lease to be confirmed by INIT-REBOOT
+ * @param[out] addr Address of the lease, in network byte order
+ * @return 0 on success, -1 if there is no usable lease
+ */
+int fast_conn_get_lease(uint32_t *addr)
+{
+	struct fast_conn_rec *rec = fast_conn_rec_get();
+	wlan_sta_ap_t *ap;
+	int ret;
+
+	if (rec == NULL || !(rec->flags & FAST_CONN_F_LEASE) ||
+	    !fast_conn_lease_usable(&rec->lease, (uint32_t)time(NULL)))
+		return -1;
+
+	/* the lease belongs to the network in sysinfo */
+	ap = malloc(sizeof(*ap));
+	if (ap == NULL)
+		return -1;
+	ret = fast_conn_get_ap(ap);
+	free(ap);
+	if (ret != 0)
+		return -1;
+
+	*addr = rec->lease.ip_addr;
+	return 0;
+}
+
+static void fast_conn_get_pmk(struct fast_conn_rec *rec,
+                              const struct sysinfo_wlan_sta_param *sta)
+{
+	struct fast_conn_rec *old = fast_conn_rec_get();
+	wlan_ssid_psk_t *info;
+	wlan_gen_psk_param_t *param;
+	size_t len;
+
+	len = strnlen((const char *)sta->psk, SYSINFO_PSK_LEN_MAX);
+	if (len < 8 || len > WLAN_PASSPHRASE_MAX_LEN)
+		return; /* open network, or a PSK already */
+
+	if (old && (old->flags & FAST_CONN_F_PMK)) {
+		memcpy(rec->pmk, old->pmk, FAST_CONN_PMK_LEN);
+		rec->flags |= FAST_CONN_F_PMK;
+		return;
+	}
+
+	/* the supplicant derived it when connecting, prefer its copy */
+	info = malloc(sizeof(*info));
+	if (info == NULL)
+		return;
+	if (wlan_sta_get_ap_ssid_psk(info) == 0 && info->psk_valid) {
+		memcpy(rec->pmk, info->psk, FAST_CONN_PMK_LEN);
+		rec->flags |= FAST_CONN_F_PMK;
+		free(info);
+		return;
+	}
+	free(info);
+
+	param = malloc(sizeof(*param));
+	if (param == NULL)
+		return;
+	memcpy(param->ssid, sta->ssid, sta->ssid_len);
+	param->ssid_len = sta->ssid_len;
+	memcpy(param->passphrase, sta->psk, len);
+	param->passphrase[len] = '\0';
+	if (wlan_sta_gen_psk(param) == 0) {
+		memcpy(rec->pmk, param->psk, FAST_CONN_PMK_LEN);
+		rec->flags |= FAST_CONN_F_PMK;
+	}
+	free(param);
+}
+
+static void fast_conn_get_bss(struct fast_conn_rec *rec, const wlan_sta_ap_t *ap)
+{
+	struct fast_conn_rec *old = fast_conn_rec_get();
+	wlan_sta_bss_info_t bss;
+	uint32_t size;
+
+	memcpy(rec->bssid, ap->bssid, sizeof(rec->bssid));
+	rec->channel = ap->channel;
+
+	/* same AP, keep the BSS in flash */
+	if (old && (old->flags & FAST_CONN_F_BSS) &&
+	    memcmp(old->bssid, rec->bssid, sizeof(rec->bssid)) == 0 &&
+	    old->channel == rec->channel) {
+		rec->bss_size = old->bss_size;
+		memcpy(rec->bss, old->bss, old->bss_size);
+		rec->flags |= FAST_CONN_F_BSS;
+		return;
+	}
+
+	if (wlan_sta_get_bss_size(&size) != 0 || size == 0 ||
+	    size > FAST_CONN_BSS_MAX) {
+		NET_DBG("bss size %u\n", size);
+		return;
+	}
+	bss.bss = rec->bss;
+	bss.size = size;
+	if (wlan_sta_get_bss(&bss) == 0) {
+		rec->bss_size = size;
+		rec->flags |= FAST_CONN_F_BSS;
+	}
+}
+
+static void fast_conn_get_lease_info(struct fast_conn_rec *rec, struct netif *nif)
+{
+#ifdef __CONFIG_LWIP_V1
+	struct dhcp *dhcp = nif->dhcp;
+
+	if (dhcp == NULL || dhcp->state != DHCP_BOUND)
+		return;
+
+	rec->lease.ip_addr = ip4_addr_get_u32(&nif->ip_addr);
+	rec->lease.net_mask = ip4_addr_get_u32(&nif->netmask);
+	rec->lease.gateway = ip4_addr_get_u32(&nif->gw);
+	rec->lease.lease_time = dhcp->offered_t0_lease;
+	rec->lease.bound_time = (uint32_t)time(NULL);
+	rec->flags |= FAST_CONN_F_LEASE;
+#elif LWIP_IPV4
+	struct dhcp *dhcp = netif_dhcp_data(nif);
+
+	if (dhcp == NULL || dhcp->state != DHCP_STATE_BOUND ||
+	    !dhcp_supplied_address(nif))
+		return;
+
+	rec->lease.ip_addr = ip4_addr_get_u32(netif_ip4_addr(nif));
+	rec->lease.net_mask = ip4_addr_get_u32(netif_ip4_netmask(nif));
+	rec->lease.gateway = ip4_addr_get_u32(netif_ip4_gw(nif));
+	rec->lease.lease_time = dhcp->offered_t0_lease;
+	rec->lease.bound_time = (uint32_t)time(NULL);
+	rec->flags |= FAST_CONN_F_LEASE;
+#endif
+}
+
+/**
+ * @brief Update the record after the station got its address
+ * @param[in] nif Station netif
+ * @return None
+ */
+void fast_conn_update(struct netif *nif)
+{
+	struct sysinfo *sysinfo = sysinfo_get();
+	struct fast_conn_rec *rec;
+	wlan_sta_ap_t *ap;
+
+	g_fast_conn_join = 0;
+	if (g_fast_conn_fdcm == NULL || sysinfo == NULL ||
+	    sysinfo->wlan_sta_param.ssid_len == 0)
+		return;
+
+	rec = malloc(sizeof(*rec));
+	ap = malloc(sizeof(*ap));
+	if (rec == NULL || ap == NULL) {
+		NET_ERR("malloc fail\n");
+		goto out;
+	}
+	if (fast_conn_get_ap(ap) != 0) {
+		NET_DBG("not connected to the AP in sysinfo\n");
+		goto out;
+	}
+
+	memset(rec, 0, sizeof(*rec));
+	rec->cfg_sum = fast_conn_cfg_sum(&sysinfo->wlan_sta_param);
+	fast_conn_get_pmk(rec, &sysinfo->wlan_sta_param);
+	fast_conn_get_bss(rec, ap);
+	fast_conn_get_lease_info(rec, nif);
+
+	if (!fast_conn_rec_need_save(fast_conn_rec_get(), rec, (uint32_t)time(NULL)))
+		goto out;
+
+	fast_conn_rec_seal(rec);
+	if (fdcm_write(g_fast_conn_fdcm, rec, sizeof(*rec)) != sizeof(*rec)) {
+		NET_ERR("fdcm write failed\n");
+	} else {
+		NET_DBG("fast reconnect record saved, flags %#x\n", rec->flags);
+	}
+	free(g_fast_conn_rec);
+	g_fast_conn_rec = rec;
+	rec = NULL;
+out:
+	free(ap);
+	free(rec);
+}
+
+/**
+ * @brief Erase the record, eg. when leaving the network for good
+ * @return 0 on success, -1 on failure
+ */
+int fast_conn_clear(void)
+{
+	g_fast_conn_join = 0;
+	free(g_fast_conn_rec);
+	g_fast_conn_rec = NULL;
+	if (g_fast_conn_fdcm == NULL)
+		return -1;
+	return fdcm_erase(g_fast_conn_fdcm);
+}
+
+#endif /* PRJCONF_NET_FAST_CONN_EN */
+
+#endif /* PRJCONF_NET_EN */
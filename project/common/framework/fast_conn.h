@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _FAST_CONN_H_
+#define _FAST_CONN_H_
+
+#if PRJCONF_NET_EN
+
+#include <stdint.h>
+#include "lwip/netif.h"
+#include "net/wlan/wlan_defs.h"
+#include "common/framework/sysinfo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FAST_CONN_MAGIC             (0x4E4E4346) /* "FCNN" */
+#define FAST_CONN_VERSION           (1)
+
+#define FAST_CONN_PMK_LEN           WLAN_PSK_HEX_LEN
+#define FAST_CONN_BSS_MAX           (800)
+
+/* lease time of a lease which never expires */
+#define FAST_CONN_LEASE_INFINITE    (0xFFFFFFFFU)
+
+/* don't try to reuse a lease expiring within this time, in seconds */
+#define FAST_CONN_LEASE_MARGIN      (60)
+
+/* fast_conn_rec.flags */
+#define FAST_CONN_F_PMK             (1U << 0) /* pmk[] is valid */
+#define FAST_CONN_F_BSS             (1U << 1) /* bssid, channel and bss[] are valid */
+#define FAST_CONN_F_LEASE           (1U << 2) /* lease is valid */
+
+/**
+ * @brief DHCP lease of the last connection, addresses in network byte order
+ */
+struct fast_conn_lease {
+	uint32_t ip_addr;
+	uint32_t net_mask;
+	uint32_t gateway;
+	uint32_t lease_time;    /* in seconds, FAST_CONN_LEASE_INFINITE for no expiry */
+	uint32_t bound_time;    /* time() when the lease was last confirmed */
+};
+
+/**
+ * @brief Fast reconnect record, saved to its own flash sector
+ *
+ * The record belongs to the station config it was made from (cfg_sum), it is
+ * ignored after the SSID or the passphrase in sysinfo is changed.
+ */
+struct fast_conn_rec {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t flags;
+	uint32_t cfg_sum;       /* fast_conn_cfg_sum() of the station config */
+
+	uint8_t  pmk[FAST_CONN_PMK_LEN];
+
+	uint8_t  bssid[6];
+	uint8_t  channel;
+	uint8_t  reserved;
+
+	struct fast_conn_lease lease;
+
+	uint32_t bss_size;
+	uint8_t  bss[FAST_CONN_BSS_MAX]; /* wlan_sta_get_bss() of the last AP */
+
+	uint32_t sum;           /* checksum of all the fields above */
+};
+
+uint32_t fast_conn_cfg_sum(const struct sysinfo_wlan_sta_param *sta);
+void fast_conn_rec_seal(struct fast_conn_rec *rec);
+int fast_conn_rec_check(const struct fast_conn_rec *rec, uint32_t cfg_sum);
+int fast_conn_lease_usable(const struct fast_conn_lease *lease, uint32_t now);
+int fast_conn_rec_need_save(const struct fast_conn_rec *old,
+                            const struct fast_conn_rec *rec, uint32_t now);
+
+#if PRJCONF_NET_FAST_CONN_EN
+int fast_conn_init(void);
+void fast_conn_deinit(void);
+int fast_conn_sta_set(const struct sysinfo_wlan_sta_param *sta);
+int fast_conn_get_lease(uint32_t *addr);
+void fast_conn_update(struct netif *nif);
+void fast_conn_join_failed(void);
+int fast_conn_clear(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PRJCONF_NET_EN */
+#endif /* _FAST_CONN_H_ */
@@ -32,7 +32,9 @@
 #include "driver/chip/sdmmc/hal_sdhost.h"
 #include "common/framework/sys_ctrl/sys_ctrl.h"
 #include "fs/fatfs/ff.h"
+#include "fs/fatfs/diskio.h"
 #include "driver/chip/sdmmc/sdmmc.h"
+#include "util/timeline.h"
 
 #define FS_DBG_ON	0
 #define FS_INF_ON	1
@@ -83,6 +85,7 @@ int fs_ctrl_mount(enum fs_mnt_dev_type dev_type, uint32_t dev_id)
 		goto out; /* already mounted, nothing to do */
 	}
 
+	TIMELINE_BEGIN("fs mount");
 	card_param.debug_mask = ROM_WRN_MASK | ROM_ERR_MASK | ROM_ANY_MASK;
 	card_param.type = MMC_TYPE_SD; /* define to speed up scan card */
 	if (mmc_card_create(dev_id, &card_param) != 0) {
@@ -131,6 +134,7 @@ err_card:
 	mmc_card_delete(dev_id);
 
 notify:
+	TIMELINE_END("fs mount");
 	if (sys_event_send(CTRL_MSG_TYPE_FS,
 	                   FS_CTRL_MSG_FS_MNT,
 	                   FS_MNT_MSG_PARAM(dev_type, dev_id, status),
@@ -159,6 +163,11 @@ int fs_ctrl_unmount(enum fs_mnt_dev_type dev_type, uint32_t dev_id)
 		goto out; /* unmounted, nothing to do */
 	}
 
+	/* write back the sector cache while the card is still the same one,
+	 * it fails harmlessly if the card is already gone */
+	if (disk_ioctl(0, CTRL_SYNC, NULL) != RES_OK)
+		FS_WRN("sync fail\n");
+
 	FRESULT fs_ret = f_mount(NULL, "", 0);
 	if (fs_ret != FR_OK) {
 		FS_ERR("unmount fail, err %d\n", fs_ret);
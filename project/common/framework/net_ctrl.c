@@ -37,11 +37,15 @@
 #include "lwip/netifapi.h"
 #include "net/wlan/wlan.h"
 #include "net/udhcp/usr_dhcpd.h"
+#include "util/timeline.h"
 
 #include "common/framework/sys_ctrl/sys_ctrl.h"
 #include "common/framework/sysinfo.h"
 #include "net_ctrl.h"
 #include "net_ctrl_debug.h"
+#if PRJCONF_NET_FAST_CONN_EN
+#include "fast_conn.h"
+#endif
 
 #if (__CONFIG_CHIP_ARCH_VER == 2)
 #include "driver/chip/hal_clock.h"
@@ -57,6 +61,7 @@ extern void platform_set_cpu_clock(PRCM_SysClkFactor factor);
 #define NET_CTRL_OPT_DIS_LOW_PWR    0
 #endif
 
+/* with DHCP, a non-zero ipaddr is a previous lease to confirm by INIT-REBOOT */
 struct netif_conf {
     uint8_t     bring_up;   // bring up or down
     uint8_t     use_dhcp;   // use DHCP or not
@@ -272,8 +277,20 @@ static void netif_config(struct netif *nif, struct netif_conf *conf)
 			}
 
 			NET_INF("start DHCP...\n");
+			TIMELINE_BEGIN("dhcp");
+#if PRJCONF_NET_FAST_CONN_EN
+			if (ip4_addr_get_u32(&conf->ipaddr) != 0) {
+				NET_INF("request %s\n", inet_ntoa(conf->ipaddr));
+				if (netifapi_dhcp_start_reboot(nif, &conf->ipaddr) != ERR_OK) {
+					NET_ERR("DHCP start failed!\n");
+					TIMELINE_END("dhcp");
+				}
+				return;
+			}
+#endif
 			if (netifapi_dhcp_start(nif) != ERR_OK) {
 				NET_ERR("DHCP start failed!\n");
+				TIMELINE_END("dhcp");
 				return;
 			}
 		} else {
@@ -332,6 +349,13 @@ void net_config(struct netif *nif, uint8_t bring_up)
 	if (sysinfo->wlan_mode == WLAN_MODE_STA) {
 		if (sysinfo->sta_use_dhcp) {
 			net_conf.use_dhcp = 1;
+#if PRJCONF_NET_FAST_CONN_EN
+			uint32_t lease;
+
+			if (bring_up && fast_conn_init() == 0 &&
+			    fast_conn_get_lease(&lease) == 0)
+				ip4_addr_set_u32(&net_conf.ipaddr, lease);
+#endif
 		} else {
 			net_conf.use_dhcp = 0;
 			memcpy(&net_conf.ipaddr, &sysinfo->netif_sta_param.ip_addr, sizeof(net_conf.ipaddr));
@@ -525,14 +549,50 @@ static const char * const net_ctrl_msg_str[] = {
 };
 #endif
 
+/* connect to the AP in sysinfo */
 int net_ctrl_connect_ap(void)
 {
-	return 0;
+	struct sysinfo *sysinfo = sysinfo_get();
+	struct sysinfo_wlan_sta_param *sta;
+	int ret;
+
+	if (sysinfo == NULL) {
+		NET_ERR("failed to get sysinfo %p\n", sysinfo);
+		return -1;
+	}
+	if (g_wlan_netif == NULL || wlan_if_get_mode(g_wlan_netif) != WLAN_MODE_STA) {
+		NET_WRN("not in station mode\n");
+		return -1;
+	}
+
+	sta = &sysinfo->wlan_sta_param;
+	if (sta->ssid_len == 0 || sta->ssid_len > SYSINFO_SSID_LEN_MAX) {
+		NET_WRN("no ssid in sysinfo\n");
+		return -1;
+	}
+
+#if PRJCONF_NET_FAST_CONN_EN
+	fast_conn_init();
+	ret = fast_conn_sta_set(sta);
+#else
+	ret = wlan_sta_set(sta->ssid, sta->ssid_len,
+	                   sta->psk[0] != '\0' ? sta->psk : NULL);
+#endif
+	if (ret != 0) {
+		NET_ERR("set station config failed\n");
+		return -1;
+	}
+
+	return wlan_sta_enable();
 }
 
 int net_ctrl_disconnect_ap(void)
 {
-	return 0;
+	if (g_wlan_netif == NULL || wlan_if_get_mode(g_wlan_netif) != WLAN_MODE_STA) {
+		return -1;
+	}
+
+	return wlan_sta_disable();
 }
 
 void net_ctrl_msg_process(uint32_t event, uint32_t data, void *arg)
@@ -542,6 +602,7 @@ void net_ctrl_msg_process(uint32_t event, uint32_t data, void *arg)
 
 	switch (type) {
 	case NET_CTRL_MSG_WLAN_CONNECTED:
+		TIMELINE_MARK("wlan connected");
 		if (g_wlan_netif && !netif_is_link_up(g_wlan_netif)) {
 			netifapi_netif_set_link_up(g_wlan_netif); /* set link up */
 #if (defined(__CONFIG_LWIP_V1) || LWIP_IPV4)
@@ -571,11 +632,21 @@ void net_ctrl_msg_process(uint32_t event, uint32_t data, void *arg)
 	case NET_CTRL_MSG_WLAN_4WAY_HANDSHAKE_FAILED:
 		break;
 	case NET_CTRL_MSG_WLAN_CONNECT_FAILED:
+#if PRJCONF_NET_FAST_CONN_EN
+		fast_conn_join_failed();
+#endif
 		break;
 	case NET_CTRL_MSG_CONNECTION_LOSS:
 		break;
 	case NET_CTRL_MSG_NETWORK_UP:
+		TIMELINE_END("dhcp");
+		TIMELINE_MARK("network up");
 		netif_up_handler(g_wlan_netif);
+#if PRJCONF_NET_FAST_CONN_EN
+		if (g_wlan_netif && wlan_if_get_mode(g_wlan_netif) == WLAN_MODE_STA) {
+			fast_conn_update(g_wlan_netif);
+		}
+#endif
 		break;
 	case NET_CTRL_MSG_NETWORK_DOWN:
 		break;
@@ -117,11 +117,11 @@ int net_sys_onoff(unsigned int enable)
 	if (enable) {
 		net_sys_start(sysinfo->wlan_mode);
 #ifdef CONFIG_AUTO_RECONNECT_AP
-		net_ctrl_connect_ap(NULL);
+		net_ctrl_connect_ap();
 #endif
 	} else {
 #ifdef CONFIG_AUTO_RECONNECT_AP
-		net_ctrl_disconnect_ap(NULL, 1);
+		net_ctrl_disconnect_ap();
 #endif
 		net_sys_stop();
 	}
@@ -32,6 +32,7 @@
 #include "version.h"
 #include "pm/pm.h"
 #include "image/image.h"
+#include "util/timeline.h"
 
 #include "common/board/board.h"
 #include "common/board/board_common.h"
@@ -562,7 +563,9 @@ __weak void platform_init_level0(void)
 #endif
 #if ((defined(__CONFIG_PSRAM)) && ((__CONFIG_CACHE_POLICY & 0xF) != 0))
     /*psram have to enable dcache*/
+    TIMELINE_BEGIN("psram init");
     platform_psram_init();
+    TIMELINE_END("psram init");
 #endif
 #if (defined(__CONFIG_XIP) || defined(__CONFIG_PSRAM))
     platform_cache_init();
@@ -659,7 +662,9 @@ __weak void platform_init_level1(void)
 #endif
 
 	struct sysinfo *sysinfo = sysinfo_get();
+	TIMELINE_BEGIN("net start");
 	net_sys_start(sysinfo->wlan_mode);
+	TIMELINE_END("net start");
 
   #if PRJCONF_NET_PM_EN
 	pm_register_wlan_power_onoff(net_sys_onoff, PRJCONF_NET_PM_MODE);
@@ -701,8 +706,17 @@ __weak void platform_init_level2(void)
 __sram_text
 void platform_init(void)
 {
+	TIMELINE_BEGIN("platform init");
+	TIMELINE_BEGIN("level0");
 	platform_init_level0();
+	TIMELINE_END("level0");
+	TIMELINE_INIT(); /* import the bootloader spans */
+	TIMELINE_BEGIN("level1");
 	platform_init_level1();
+	TIMELINE_END("level1");
+	TIMELINE_BEGIN("level2");
 	platform_init_level2();
+	TIMELINE_END("level2");
+	TIMELINE_END("platform init");
 	platform_show_info();
 }
@@ -99,118 +99,22 @@
 //#define LOAD_BY_SBUS_DMA
 
 #if (defined LOAD_BY_DBUS_DMA)
-#include "driver/chip/hal_dma.h"
-__sram_data
-static uint32_t dma_wburst0 = 0, dma_wburst1 = 0;
-__sram_data
-static uint32_t dma_wwidth0 = 0, dma_wwidth1 = 0;
-__sram_data
-static uint32_t dma_rburst0 = 0, dma_rburst1 = 0;
-__sram_data
-static uint32_t dma_rwidth0 = 0, dma_rwidth1 = 0;
-__sram_data
-static OS_Semaphore_t dmaSem;
-__sram_data
-uint32_t dma_burst_type[2] = {DMA_BURST_LEN_1, DMA_BURST_LEN_4};
-__sram_data
-uint32_t dma_width_type[3] = {DMA_DATA_WIDTH_8BIT, DMA_DATA_WIDTH_16BIT, DMA_DATA_WIDTH_32BIT};
+#include "sys/dma_copy.h"
 
-__sram_text
-static void psram_DMARelease(void *arg)
-{
-	OS_SemaphoreRelease(&dmaSem);
-}
-
-__sram_text
+/* not __sram_text, dma_copy() and the DMA driver run from flash */
 static int psram_dma_read_write(uint32_t write, uint32_t addr,
                                uint8_t *buf, uint32_t len)
 {
-	OS_Status ret;
-	DMA_ChannelInitParam dmaParam;
-	DMA_Channel dma_ch;
-
-	dma_ch = HAL_DMA_Request();
-	if (dma_ch == DMA_CHANNEL_INVALID) {
-		PSRAM_ERR("%s,%d\n", __func__, __LINE__);
-		return -1;
-	}
-
-	OS_SemaphoreCreate(&dmaSem, 0, 1);
-
-	dmaParam.irqType = DMA_IRQ_TYPE_END;
-	dmaParam.endCallback = (DMA_IRQCallback)psram_DMARelease;
-	dmaParam.endArg = NULL;
-	if (write) {
-		if (++dma_wburst0 >= 2) {
-			dma_wburst0 = 0;
-			if (++dma_wburst1 >= 2) {
-				dma_wburst1 = 0;
-				if (++dma_wwidth0 >= 3) {
-					dma_wwidth0 = 0;
-					if (++dma_wwidth1 >= 3)
-						dma_wwidth1 = 0;
-				}
-			}
-		}
-	} else {
-		if (++dma_rburst0 >= 2) {
-			dma_rburst0 = 0;
-			if (++dma_rburst1 >= 2) {
-				dma_rburst1 = 0;
-				if (++dma_rwidth0 >= 3) {
-					dma_rwidth0 = 0;
-					if (++dma_rwidth1 >= 3)
-						dma_rwidth1 = 0;
-				}
-			}
-		}
-	}
-	if (write) {
-		dmaParam.cfg = HAL_DMA_MakeChannelInitCfg(DMA_WORK_MODE_SINGLE,
-				DMA_WAIT_CYCLE_2,
-				DMA_BYTE_CNT_MODE_REMAIN,
-				dma_width_type[dma_wwidth0],
-				dma_burst_type[dma_wburst0],
-				DMA_ADDR_MODE_INC,
-				(DMA_Periph)(DMA_PERIPH_PSRAMC),
-				dma_width_type[dma_wwidth1],
-				dma_burst_type[dma_wburst1],
-				DMA_ADDR_MODE_INC,
-				DMA_PERIPH_SRAM);
-	} else {
-		dmaParam.cfg = HAL_DMA_MakeChannelInitCfg(DMA_WORK_MODE_SINGLE,
-				DMA_WAIT_CYCLE_2,
-				DMA_BYTE_CNT_MODE_REMAIN,
-				dma_width_type[dma_rwidth0],
-				dma_burst_type[dma_rburst0],
-				DMA_ADDR_MODE_INC,
-				DMA_PERIPH_SRAM,
-				dma_width_type[dma_rwidth1],
-				dma_burst_type[dma_rburst1],
-				DMA_ADDR_MODE_INC,
-				(DMA_Periph)(DMA_PERIPH_PSRAMC));
-	}
-	HAL_DMA_Init(dma_ch, &dmaParam);
-	//PSRAM_DBG("%s,%d rw:%d\n", __func__, __LINE__, write);
-	//PSRAM_DBG("wb0:%d wb1:%d ww0:%d ww1:%d\n", dma_wburst0, dma_wburst1, dma_wwidth0, dma_wwidth1);
-	//PSRAM_DBG("rb0:%d rb1:%d rw0:%d rw1:%d\n", dma_rburst0, dma_rburst1, dma_rwidth0, dma_rwidth1);
+	int ret;
 
 	if (write)
-		HAL_DMA_Start(dma_ch, (uint32_t)buf, (uint32_t)addr, len);
+		ret = dma_copy((void *)addr, buf, len);
 	else
-		HAL_DMA_Start(dma_ch, (uint32_t)addr, (uint32_t)buf, len);
-
-	ret = OS_SemaphoreWait(&dmaSem, 5000);
-	if (ret != OS_OK)
-		PSRAM_ERR("sem wait failed: %d", ret);
-
-	HAL_DMA_Stop(dma_ch);
-	HAL_DMA_DeInit(dma_ch);
-	HAL_DMA_Release(dma_ch);
-
-	OS_SemaphoreDelete(&dmaSem);
+		ret = dma_copy(buf, (void *)addr, len);
+	if (ret != 0)
+		PSRAM_ERR("%s,%d\n", __func__, __LINE__);
 
-	return 0;
+	return ret;
 }
 #endif
 
@@ -48,8 +48,6 @@
 #define IPERF_PORT					5001
 
 #define IPERF_BUF_SIZE 				(1500)
-#define IPERF_UDP_SEND_DATA_LEN		(1470)	// UDP: 1470 + 8  + 20 = 1498
-#define IPERF_TCP_SEND_DATA_LEN		(1460)	// TCP: 1460 + 20 + 20 = 1500
 
 #define IPERF_THREAD_STACK_SIZE		(2 * 1024)
 
@@ -62,13 +60,16 @@ iperf_arg *g_iperf_arg_handle[IPERF_ARG_HANDLE_MAX] = {NULL};
 
 #define IPERF_SELECT_TIMEOUT		100
 
-static void iperf_speed_log(iperf_arg *arg, uint64_t bytes, uint32_t time,
-                            int8_t is_end)
+void iperf_speed_log(iperf_arg *arg, uint64_t bytes, uint32_t time,
+                     int8_t is_end)
 {
 	uint64_t speed;
 	uint32_t integer_part, decimal_part;
 	char str[16];
 
+	if (time == 0)
+		time = 1;
+
 	if (arg->flags & IPERF_FLAG_FORMAT) {
 		/* KBytes/sec */
 		speed = bytes * IPERF_TIME_PER_SEC * 100 / 1024 / time;
@@ -702,10 +703,16 @@ int iperf_handle_start(struct netif *nif, int handle)
 		return -1;
 	}
 
+	OS_ThreadEntry_t entry = iperf_thread_entry[g_iperf_arg_handle[handle]->mode];
+#if IPERF_OPT_RAW
+	if (g_iperf_arg_handle[handle]->flags & IPERF_FLAG_RAW)
+		entry = iperf_raw_task;
+#endif
+
 	g_iperf_arg_handle[handle]->flags &= ~IPERF_FLAG_STOP; /* clean stop flag */
 	if (OS_ThreadCreate(&(g_iperf_arg_handle[handle]->iperf_thread),
 							"iperf",
-							iperf_thread_entry[g_iperf_arg_handle[handle]->mode],
+							entry,
 							(void *)g_iperf_arg_handle[handle],
 							OS_THREAD_PRIO_APP,
 							IPERF_THREAD_STACK_SIZE) != OS_OK) {
@@ -827,8 +834,9 @@ int iperf_show_list(void) {
 			run_num++;
 
 			IPERF_LOG(1, "\nhandle    = %d\n", i);
-			IPERF_LOG(1, "mode      = %s\n",
-						iperf_mode_str[g_iperf_arg_handle[i]->mode]);
+			IPERF_LOG(1, "mode      = %s%s\n",
+						iperf_mode_str[g_iperf_arg_handle[i]->mode],
+						(g_iperf_arg_handle[i]->flags & IPERF_FLAG_RAW) ? " (raw)" : "");
 			IPERF_LOG(1, "remote ip = %s\n", g_iperf_arg_handle[i]->remote_ip);
 			IPERF_LOG(1, "port      = %u\n", g_iperf_arg_handle[i]->port);
 			IPERF_LOG(1, "run time  = %u\n", g_iperf_arg_handle[i]->run_time);
@@ -845,7 +853,7 @@ int iperf_parse_argv(int argc, char *argv[])
 	iperf_arg iperf_arg_t;
 	uint32_t port;
 	int opt = 0;
-	char *short_opts = "LusQ:c:f:p:t:i:b:n:S:";
+	char *short_opts = "LusRQ:c:f:p:t:i:b:n:S:";
 	memset(&iperf_arg_t, 0, sizeof(iperf_arg_t));
 #if IPERF_OPT_BANDWIDTH
 	iperf_arg_t.bandwidth = 1000 * 1000; /* default to 1Mbits/sec */
@@ -885,6 +893,11 @@ int iperf_parse_argv(int argc, char *argv[])
 			case 's':
 				iperf_arg_t.flags |= IPERF_FLAG_SERVER;
 				break;
+#if IPERF_OPT_RAW
+			case 'R':
+				iperf_arg_t.flags |= IPERF_FLAG_RAW;
+				break;
+#endif
 			case 'c':
 				if (inet_addr(optarg) == INADDR_NONE) {
 					IPERF_ERR("invalid ip arg '%s'\n", optarg);
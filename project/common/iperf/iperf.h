@@ -43,10 +43,14 @@ extern "C" {
 #define IPERF_OPT_BANDWIDTH		1	/* -b, bandwidth to send at in bits/sec */
 #define IPERF_OPT_NUM			1	/* -n, number of bytes to transmit (instead of -t) */
 #define IPERF_OPT_TOS			1	/* -S, the type-of-service for outgoing packets */
+#define IPERF_OPT_RAW			1	/* -R, run on the lwIP raw API instead of sockets */
 
 #define MAX_INTERVAL 60
 #define IPERF_ARG_HANDLE_MAX    4
 
+#define IPERF_UDP_SEND_DATA_LEN		(1470)	// UDP: 1470 + 8  + 20 = 1498
+#define IPERF_TCP_SEND_DATA_LEN		(1460)	// TCP: 1460 + 20 + 20 = 1500
+
 #ifndef INET_ADDRSTRLEN
 #define INET_ADDRSTRLEN         16
 #endif
@@ -73,6 +77,7 @@ enum IPERF_FLAGS {
 	IPERF_FLAG_UDP     = 0x00000010,
 	IPERF_FLAG_FORMAT  = 0x00000020,
 	IPERF_FLAG_STOP    = 0x00000040,
+	IPERF_FLAG_RAW     = 0x00000080,
 };
 
 typedef struct {
@@ -107,6 +112,12 @@ int iperf_parse_argv(int argc, char *argv[]);
 int iperf_handle_free(int handle);
 int iperf_handle_start(struct netif * nif, int handle);
 
+/* shared by the socket and the raw API engines */
+void iperf_speed_log(iperf_arg *arg, uint64_t bytes, uint32_t time, int8_t is_end);
+#if IPERF_OPT_RAW
+void iperf_raw_task(void *arg);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,942 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if PRJCONF_NET_EN
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "kernel/os/os.h"
+#include "lwip/tcpip.h"
+#include "lwip/tcp.h"
+#include "lwip/udp.h"
+#include "driver/chip/hal_rtc.h"
+
+#include "iperf.h"
+#include "iperf_debug.h"
+
+#if IPERF_OPT_RAW
+
+/*
+ * iperf engine on the lwIP raw API.
+ *
+ * All protocol work runs in the tcpip thread: TCP payload is queued with
+ * tcp_write() without TCP_WRITE_FLAG_COPY and UDP payload is a PBUF_REF on
+ * the same static buffer, so nothing is copied on the way out and received
+ * pbufs are only counted. The iperf thread owns the run: it posts a tick
+ * through a preallocated callback message, which opens the pcbs, paces UDP,
+ * handles timeouts and stop requests, and it prints the interval and final
+ * reports from counters sampled without locking.
+ */
+
+#define IPERF_RAW_TIME_US()		HAL_RTC_GetFreeRunTime()
+#define IPERF_RAW_TIME_MS()		OS_GetTicks()
+
+#define IPERF_RAW_SLICE			100	/* ms, thread tick */
+#define IPERF_RAW_SLICE_UDP		1	/* ms, thread tick when pacing udp */
+#define IPERF_RAW_UDP_BURST		16	/* max datagrams sent per tick */
+#define IPERF_RAW_RING_NUM		32	/* unacked tcp writes tracked, power of 2 */
+
+#define IPERF_RAW_FIN_RETRY		10
+#define IPERF_RAW_FIN_INTERVAL	250000	/* us, final datagram retransmission */
+#define IPERF_RAW_FIN_LINGER	1000000	/* us, server waits for lost acks */
+
+#ifdef __CONFIG_LWIP_V1
+#define IPERF_RAW_CONST
+#else
+#define IPERF_RAW_CONST			const
+#endif
+
+/* iperf2 UDP datagram header, network byte order */
+struct iperf_udp_hdr {
+	int32_t		id;
+	uint32_t	tv_sec;
+	uint32_t	tv_usec;
+};
+
+/* iperf2 server report, follows the header in the ack of the final datagram */
+struct iperf_server_hdr {
+	int32_t		flags;
+	int32_t		total_len1;
+	int32_t		total_len2;
+	int32_t		stop_sec;
+	int32_t		stop_usec;
+	int32_t		error_cnt;
+	int32_t		outorder_cnt;
+	int32_t		datagrams;
+	int32_t		jitter1;
+	int32_t		jitter2;
+};
+
+#define IPERF_HEADER_VERSION1	0x80000000
+
+/* log2 histogram in us, bucket 0 is [0, 64), bucket n is [64 << (n - 1), 64 << n) */
+#define IPERF_HIST_NUM			16
+#define IPERF_HIST_SHIFT		6
+
+struct iperf_hist {
+	uint32_t	cnt[IPERF_HIST_NUM];
+	uint32_t	num;
+	uint32_t	min;
+	uint32_t	max;
+	uint64_t	sum;
+};
+
+enum IPERF_RAW_STATE {
+	IPERF_RAW_ST_INIT = 0,	/* waiting for the peer */
+	IPERF_RAW_ST_RUN,
+	IPERF_RAW_ST_FIN,		/* udp: exchanging the final datagram */
+	IPERF_RAW_ST_DONE,
+};
+
+struct iperf_raw {
+	iperf_arg			*idata;
+	OS_Semaphore_t		done;		/* released once the engine is closed */
+	struct tcpip_callback_msg *tick_msg;
+	volatile uint8_t	tick_pending;
+	volatile uint8_t	stop_req;
+	volatile uint8_t	state;
+	uint8_t				opened;
+	uint8_t				stopped;
+	uint8_t				fin_cnt;
+	uint8_t				has_report;
+	err_t				err;
+
+	struct tcp_pcb		*listen;
+	struct tcp_pcb		*tcp;
+	struct udp_pcb		*udp;
+	ip_addr_t			remote_ip;
+	u16_t				remote_port;
+
+	uint64_t			beg_us;		/* first payload */
+	uint64_t			end_us;
+	uint64_t			evt_us;		/* last fin, last tcp arrival */
+	uint64_t			total;		/* payload bytes, acked ones for tcp send */
+	volatile uint32_t	bytes;		/* same, wrapping, sampled by the thread */
+#if IPERF_OPT_NUM
+	uint64_t			left;		/* bytes still to be queued with -n */
+#endif
+
+	/* tcp send: write to ack latency */
+	uint32_t			written;
+	uint32_t			acked;
+	struct {
+		uint32_t		end;
+		uint32_t		us;
+	} ring[IPERF_RAW_RING_NUM];
+	uint8_t				ring_head;
+	uint8_t				ring_cnt;
+	volatile uint32_t	lat_sum;
+	volatile uint32_t	lat_num;
+
+	/* udp */
+	int32_t				seq;		/* send: next id, recv: highest id + 1 */
+	volatile uint32_t	pkts;
+	volatile uint32_t	lost;
+	volatile uint32_t	outorder;
+	uint32_t			transit;
+	volatile uint32_t	jitter16;	/* RFC 3550 interarrival jitter, us << 4 */
+	struct iperf_server_hdr report;
+
+	struct iperf_hist	hist;
+};
+
+static uint8_t iperf_raw_payload[IPERF_TCP_SEND_DATA_LEN];
+
+static void iperf_hist_add(struct iperf_hist *h, uint32_t us)
+{
+	int n = 0;
+
+	if (us >> IPERF_HIST_SHIFT) {
+		n = 32 - __builtin_clz(us) - IPERF_HIST_SHIFT;
+		if (n >= IPERF_HIST_NUM)
+			n = IPERF_HIST_NUM - 1;
+	}
+	h->cnt[n]++;
+	if (h->num == 0 || us < h->min)
+		h->min = us;
+	if (us > h->max)
+		h->max = us;
+	h->num++;
+	h->sum += us;
+}
+
+static uint32_t iperf_hist_upper(int n)
+{
+	return (uint32_t)1 << (IPERF_HIST_SHIFT + n);
+}
+
+static uint32_t iperf_hist_pct(const struct iperf_hist *h, uint32_t pct)
+{
+	uint32_t acc = 0, need = ((uint64_t)h->num * pct + 99) / 100;
+	int n;
+
+	for (n = 0; n < IPERF_HIST_NUM - 1; n++) {
+		acc += h->cnt[n];
+		if (acc >= need)
+			return iperf_hist_upper(n);
+	}
+	return h->max;
+}
+
+static void iperf_hist_log(iperf_arg *idata, const char *name,
+                           const struct iperf_hist *h)
+{
+	int n;
+
+	if (h->num == 0)
+		return;
+
+	IPERF_LOG(1, "[%d] %s: %u samples, min %u us, avg %u us, max %u us\n",
+	          idata->handle, name, h->num, h->min,
+	          (uint32_t)(h->sum / h->num), h->max);
+	for (n = 0; n < IPERF_HIST_NUM; n++) {
+		if (h->cnt[n] == 0)
+			continue;
+		if (n == IPERF_HIST_NUM - 1)
+			IPERF_LOG(1, "[%d]   >= %7u us : %u\n", idata->handle,
+			          iperf_hist_upper(n - 1), h->cnt[n]);
+		else
+			IPERF_LOG(1, "[%d]   <  %7u us : %u\n", idata->handle,
+			          iperf_hist_upper(n), h->cnt[n]);
+	}
+	IPERF_LOG(1, "[%d]   p50 <= %u us, p90 <= %u us, p99 <= %u us\n",
+	          idata->handle, iperf_hist_pct(h, 50), iperf_hist_pct(h, 90),
+	          iperf_hist_pct(h, 99));
+}
+
+/* --------------------------------------------------------------------------
+ * engine, runs in the tcpip thread
+ * -------------------------------------------------------------------------- */
+
+/* Queue a tick from either thread. The message is static, so it must never
+ * be queued twice: a tick already pending covers the new request. */
+static void iperf_raw_post(struct iperf_raw *ctx)
+{
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	SYS_ARCH_PROTECT(lev);
+	if (ctx->tick_pending) {
+		SYS_ARCH_UNPROTECT(lev);
+		return;
+	}
+	ctx->tick_pending = 1;
+	SYS_ARCH_UNPROTECT(lev);
+
+	if (tcpip_trycallback(ctx->tick_msg) != ERR_OK)
+		ctx->tick_pending = 0;
+}
+
+/* Close all pcbs and hand the run back to the iperf thread. Returns ERR_ABRT
+ * if the connection had to be aborted, to be passed up by tcp callbacks. */
+static err_t iperf_raw_finish(struct iperf_raw *ctx, err_t err)
+{
+	err_t ret = ERR_OK;
+
+	if (ctx->state == IPERF_RAW_ST_DONE)
+		return ERR_OK;
+	if (ctx->state != IPERF_RAW_ST_FIN)
+		ctx->end_us = IPERF_RAW_TIME_US();
+
+	if (ctx->tcp) {
+		tcp_arg(ctx->tcp, NULL);
+		tcp_err(ctx->tcp, NULL);
+		tcp_sent(ctx->tcp, NULL);
+		tcp_recv(ctx->tcp, NULL);
+		if (tcp_close(ctx->tcp) != ERR_OK) {
+			tcp_abort(ctx->tcp);
+			ret = ERR_ABRT;
+		}
+		ctx->tcp = NULL;
+	}
+	if (ctx->listen) {
+		tcp_arg(ctx->listen, NULL);
+		tcp_accept(ctx->listen, NULL);
+		tcp_close(ctx->listen);
+		ctx->listen = NULL;
+	}
+	if (ctx->udp) {
+		udp_remove(ctx->udp);
+		ctx->udp = NULL;
+	}
+
+	ctx->err = err;
+	ctx->state = IPERF_RAW_ST_DONE;
+	OS_SemaphoreRelease(&ctx->done);
+	return ret;
+}
+
+static void iperf_raw_tcp_err(void *arg, err_t err)
+{
+	struct iperf_raw *ctx = arg;
+
+	if (ctx == NULL)
+		return;
+	ctx->tcp = NULL; /* already freed by the stack */
+	iperf_raw_finish(ctx, err);
+}
+
+static err_t iperf_raw_tcp_fill(struct iperf_raw *ctx)
+{
+	struct tcp_pcb *pcb = ctx->tcp;
+	uint32_t now = (uint32_t)IPERF_RAW_TIME_US();
+	u16_t len;
+	err_t err;
+	int n;
+
+	while (ctx->state == IPERF_RAW_ST_RUN && ctx->ring_cnt < IPERF_RAW_RING_NUM) {
+		len = IPERF_TCP_SEND_DATA_LEN;
+#if IPERF_OPT_NUM
+		if (!ctx->idata->mode_time) {
+			if (ctx->left == 0)
+				break;
+			if (ctx->left < len)
+				len = ctx->left;
+		}
+#endif
+		if (tcp_sndbuf(pcb) < len)
+			break;
+		/* no TCP_WRITE_FLAG_COPY, segments reference the static payload */
+		err = tcp_write(pcb, iperf_raw_payload, len, 0);
+		if (err == ERR_MEM)
+			break;
+		if (err != ERR_OK)
+			return iperf_raw_finish(ctx, err);
+
+		ctx->written += len;
+		n = (ctx->ring_head + ctx->ring_cnt) & (IPERF_RAW_RING_NUM - 1);
+		ctx->ring[n].end = ctx->written;
+		ctx->ring[n].us = now;
+		ctx->ring_cnt++;
+#if IPERF_OPT_NUM
+		if (!ctx->idata->mode_time)
+			ctx->left -= len;
+#endif
+	}
+	tcp_output(pcb);
+	return ERR_OK;
+}
+
+static err_t iperf_raw_tcp_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+	struct iperf_raw *ctx = arg;
+	uint32_t now = (uint32_t)IPERF_RAW_TIME_US();
+	uint32_t lat;
+
+	ctx->acked += len;
+	ctx->total += len;
+	ctx->bytes += len;
+
+	while (ctx->ring_cnt &&
+	       (int32_t)(ctx->acked - ctx->ring[ctx->ring_head].end) >= 0) {
+		lat = now - ctx->ring[ctx->ring_head].us;
+		iperf_hist_add(&ctx->hist, lat);
+		ctx->lat_sum += lat;
+		ctx->lat_num++;
+		ctx->ring_head = (ctx->ring_head + 1) & (IPERF_RAW_RING_NUM - 1);
+		ctx->ring_cnt--;
+	}
+
+#if IPERF_OPT_NUM
+	if (!ctx->idata->mode_time && ctx->left == 0 && ctx->acked == ctx->written)
+		return iperf_raw_finish(ctx, ERR_OK);
+#endif
+	/* Refill from the tick rather than from here: over loopback, netif_poll()
+	 * would otherwise never drain and the tcpip thread would spin forever. */
+	iperf_raw_post(ctx);
+	return ERR_OK;
+}
+
+static err_t iperf_raw_tcp_connected(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+	struct iperf_raw *ctx = arg;
+
+	if (err != ERR_OK)
+		return iperf_raw_finish(ctx, err);
+
+	ctx->state = IPERF_RAW_ST_RUN;
+	ctx->beg_us = IPERF_RAW_TIME_US();
+	return iperf_raw_tcp_fill(ctx);
+}
+
+static err_t iperf_raw_tcp_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p,
+                                err_t err)
+{
+	struct iperf_raw *ctx = arg;
+	uint64_t now;
+
+	if (p == NULL) /* closed by the peer */
+		return iperf_raw_finish(ctx, ERR_OK);
+	if (err != ERR_OK) {
+		pbuf_free(p);
+		return err;
+	}
+
+	now = IPERF_RAW_TIME_US();
+	if (ctx->total)
+		iperf_hist_add(&ctx->hist, (uint32_t)(now - ctx->evt_us));
+	ctx->evt_us = now;
+	ctx->total += p->tot_len;
+	ctx->bytes += p->tot_len;
+
+	tcp_recved(pcb, p->tot_len);
+	pbuf_free(p);
+	return ERR_OK;
+}
+
+static err_t iperf_raw_tcp_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+	struct iperf_raw *ctx = arg;
+
+	if (err != ERR_OK || pcb == NULL)
+		return ERR_VAL;
+	if (ctx == NULL || ctx->state != IPERF_RAW_ST_INIT) {
+		tcp_abort(pcb); /* one connection per run */
+		return ERR_ABRT;
+	}
+	tcp_accepted(ctx->listen);
+
+	ctx->tcp = pcb;
+#if IPERF_OPT_TOS
+	pcb->tos = ctx->idata->tos;
+#endif
+	tcp_arg(pcb, ctx);
+	tcp_err(pcb, iperf_raw_tcp_err);
+	tcp_recv(pcb, iperf_raw_tcp_recv);
+
+	ctx->state = IPERF_RAW_ST_RUN;
+	ctx->beg_us = IPERF_RAW_TIME_US();
+	IPERF_DBG("iperf: client from %s:%d\n", ipaddr_ntoa(&pcb->remote_ip),
+	          pcb->remote_port);
+	return ERR_OK;
+}
+
+static err_t iperf_raw_udp_send_one(struct iperf_raw *ctx, int32_t id, uint64_t now)
+{
+	struct iperf_udp_hdr *hdr;
+	struct pbuf *p, *q;
+	err_t err;
+
+	/* header in a small ram pbuf with room for udp/ip, payload by reference */
+	p = pbuf_alloc(PBUF_TRANSPORT, sizeof(*hdr), PBUF_RAM);
+	if (p == NULL)
+		return ERR_MEM;
+	q = pbuf_alloc(PBUF_RAW, IPERF_UDP_SEND_DATA_LEN - sizeof(*hdr), PBUF_REF);
+	if (q == NULL) {
+		pbuf_free(p);
+		return ERR_MEM;
+	}
+	q->payload = iperf_raw_payload;
+	pbuf_cat(p, q);
+
+	hdr = p->payload;
+	hdr->id = htonl(id);
+	hdr->tv_sec = htonl((uint32_t)(now / 1000000));
+	hdr->tv_usec = htonl((uint32_t)(now % 1000000));
+
+	err = udp_send(ctx->udp, p);
+	pbuf_free(p);
+	return err;
+}
+
+static void iperf_raw_udp_send_fin(struct iperf_raw *ctx, uint64_t now)
+{
+	if (ctx->state == IPERF_RAW_ST_RUN) {
+		ctx->state = IPERF_RAW_ST_FIN;
+		ctx->end_us = now;
+	}
+	ctx->fin_cnt++;
+	ctx->evt_us = now;
+	iperf_raw_udp_send_one(ctx, -ctx->seq, now);
+}
+
+static void iperf_raw_udp_pace(struct iperf_raw *ctx, uint64_t now)
+{
+	uint64_t allow = (uint64_t)-1;
+	int n;
+
+#if IPERF_OPT_BANDWIDTH
+	if (ctx->idata->bandwidth)
+		allow = (now - ctx->beg_us) * ctx->idata->bandwidth / 8000000;
+#endif
+
+	for (n = 0; n < IPERF_RAW_UDP_BURST && ctx->total < allow; n++) {
+#if IPERF_OPT_NUM
+		if (!ctx->idata->mode_time && ctx->left == 0) {
+			iperf_raw_udp_send_fin(ctx, now);
+			return;
+		}
+#endif
+		if (iperf_raw_udp_send_one(ctx, ctx->seq, now) != ERR_OK)
+			break; /* out of pbufs or no route, retry on next tick */
+		ctx->seq++;
+		ctx->total += IPERF_UDP_SEND_DATA_LEN;
+		ctx->bytes += IPERF_UDP_SEND_DATA_LEN;
+#if IPERF_OPT_NUM
+		if (!ctx->idata->mode_time)
+			ctx->left -= LWIP_MIN(ctx->left, IPERF_UDP_SEND_DATA_LEN);
+#endif
+	}
+}
+
+static void iperf_raw_udp_client_recv(void *arg, struct udp_pcb *pcb,
+                                      struct pbuf *p,
+                                      IPERF_RAW_CONST ip_addr_t *addr, u16_t port)
+{
+	struct iperf_raw *ctx = arg;
+
+	/* the only thing expected back is the ack of the final datagram */
+	if (ctx->state == IPERF_RAW_ST_FIN) {
+		if (pbuf_copy_partial(p, &ctx->report, sizeof(ctx->report),
+		                      sizeof(struct iperf_udp_hdr)) == sizeof(ctx->report) &&
+		    (ntohl(ctx->report.flags) & IPERF_HEADER_VERSION1))
+			ctx->has_report = 1;
+		pbuf_free(p);
+		iperf_raw_finish(ctx, ERR_OK);
+		return;
+	}
+	pbuf_free(p);
+}
+
+static void iperf_raw_udp_ack_fin(struct iperf_raw *ctx, const struct iperf_udp_hdr *fin,
+                                  IPERF_RAW_CONST ip_addr_t *addr, u16_t port)
+{
+	struct iperf_server_hdr *rpt;
+	struct pbuf *p;
+	uint64_t dur = ctx->end_us - ctx->beg_us;
+	uint32_t jitter = ctx->jitter16 >> 4;
+
+	p = pbuf_alloc(PBUF_TRANSPORT, sizeof(*fin) + sizeof(*rpt), PBUF_RAM);
+	if (p == NULL)
+		return;
+
+	memcpy(p->payload, fin, sizeof(*fin));
+	rpt = (struct iperf_server_hdr *)((uint8_t *)p->payload + sizeof(*fin));
+	rpt->flags = htonl(IPERF_HEADER_VERSION1);
+	rpt->total_len1 = htonl((uint32_t)(ctx->total >> 32));
+	rpt->total_len2 = htonl((uint32_t)ctx->total);
+	rpt->stop_sec = htonl((uint32_t)(dur / 1000000));
+	rpt->stop_usec = htonl((uint32_t)(dur % 1000000));
+	rpt->error_cnt = htonl(ctx->lost);
+	rpt->outorder_cnt = htonl(ctx->outorder);
+	rpt->datagrams = htonl(ctx->seq);
+	rpt->jitter1 = htonl(jitter / 1000000);
+	rpt->jitter2 = htonl(jitter % 1000000);
+
+	udp_sendto(ctx->udp, p, addr, port);
+	pbuf_free(p);
+}
+
+static void iperf_raw_udp_server_recv(void *arg, struct udp_pcb *pcb,
+                                      struct pbuf *p,
+                                      IPERF_RAW_CONST ip_addr_t *addr, u16_t port)
+{
+	struct iperf_raw *ctx = arg;
+	struct iperf_udp_hdr hdr;
+	uint64_t now = IPERF_RAW_TIME_US();
+	uint32_t transit;
+	int32_t id, d;
+
+	if (pbuf_copy_partial(p, &hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+		pbuf_free(p);
+		return;
+	}
+	id = (int32_t)ntohl(hdr.id);
+
+	if (id < 0) {
+		/* final datagram, ack it every time it is retransmitted */
+		if (ctx->state == IPERF_RAW_ST_RUN) {
+			ctx->state = IPERF_RAW_ST_FIN;
+			ctx->end_us = now;
+			IPERF_DBG("iperf udp raw receive a FIN datagram\n");
+		}
+		if (ctx->state == IPERF_RAW_ST_FIN) {
+			ctx->evt_us = now;
+			iperf_raw_udp_ack_fin(ctx, &hdr, addr, port);
+		}
+		pbuf_free(p);
+		return;
+	}
+
+	if (ctx->state == IPERF_RAW_ST_INIT) {
+		ctx->state = IPERF_RAW_ST_RUN;
+		ctx->beg_us = now;
+	}
+	if (ctx->state != IPERF_RAW_ST_RUN) {
+		pbuf_free(p);
+		return;
+	}
+
+	ctx->total += p->tot_len;
+	ctx->bytes += p->tot_len;
+	ctx->pkts++;
+	if (id >= ctx->seq) {
+		ctx->lost += id - ctx->seq;
+		ctx->seq = id + 1;
+	} else {
+		ctx->outorder++;
+		if (ctx->lost)
+			ctx->lost--;
+	}
+
+	/* the clocks need not agree, only the change of transit time is used */
+	transit = (uint32_t)now - (ntohl(hdr.tv_sec) * 1000000 + ntohl(hdr.tv_usec));
+	if (ctx->pkts > 1) {
+		d = (int32_t)(transit - ctx->transit);
+		if (d < 0)
+			d = -d;
+		ctx->jitter16 += d - ((ctx->jitter16 + 8) >> 4);
+		iperf_hist_add(&ctx->hist, d);
+	}
+	ctx->transit = transit;
+	pbuf_free(p);
+}
+
+static err_t iperf_raw_open_tcp_send(struct iperf_raw *ctx)
+{
+	struct tcp_pcb *pcb = tcp_new();
+
+	if (pcb == NULL)
+		return ERR_MEM;
+#if IPERF_OPT_TOS
+	pcb->tos = ctx->idata->tos;
+#endif
+	ctx->tcp = pcb;
+	tcp_arg(pcb, ctx);
+	tcp_err(pcb, iperf_raw_tcp_err);
+	tcp_sent(pcb, iperf_raw_tcp_sent);
+	return tcp_connect(pcb, &ctx->remote_ip, ctx->remote_port,
+	                   iperf_raw_tcp_connected);
+}
+
+static err_t iperf_raw_open_tcp_recv(struct iperf_raw *ctx)
+{
+	struct tcp_pcb *pcb = tcp_new();
+	err_t err;
+
+	if (pcb == NULL)
+		return ERR_MEM;
+	err = tcp_bind(pcb, IP_ADDR_ANY, ctx->remote_port);
+	if (err != ERR_OK) {
+		tcp_close(pcb);
+		return err;
+	}
+	ctx->listen = tcp_listen(pcb);
+	if (ctx->listen == NULL) {
+		tcp_close(pcb);
+		return ERR_MEM;
+	}
+	tcp_arg(ctx->listen, ctx);
+	tcp_accept(ctx->listen, iperf_raw_tcp_accept);
+	return ERR_OK;
+}
+
+static err_t iperf_raw_open_udp(struct iperf_raw *ctx, int is_send)
+{
+	err_t err;
+
+	ctx->udp = udp_new();
+	if (ctx->udp == NULL)
+		return ERR_MEM;
+#if IPERF_OPT_TOS
+	ctx->udp->tos = ctx->idata->tos;
+#endif
+
+	if (!is_send) {
+		udp_recv(ctx->udp, iperf_raw_udp_server_recv, ctx);
+		return udp_bind(ctx->udp, IP_ADDR_ANY, ctx->remote_port);
+	}
+
+	udp_recv(ctx->udp, iperf_raw_udp_client_recv, ctx);
+	err = udp_connect(ctx->udp, &ctx->remote_ip, ctx->remote_port);
+	if (err != ERR_OK)
+		return err;
+	ctx->state = IPERF_RAW_ST_RUN;
+	ctx->beg_us = IPERF_RAW_TIME_US();
+	return ERR_OK;
+}
+
+static void iperf_raw_open(struct iperf_raw *ctx)
+{
+	err_t err;
+
+	switch (ctx->idata->mode) {
+	case IPERF_MODE_UDP_SEND:
+		err = iperf_raw_open_udp(ctx, 1);
+		break;
+	case IPERF_MODE_UDP_RECV:
+		err = iperf_raw_open_udp(ctx, 0);
+		break;
+	case IPERF_MODE_TCP_SEND:
+		err = iperf_raw_open_tcp_send(ctx);
+		break;
+	case IPERF_MODE_TCP_RECV:
+		err = iperf_raw_open_tcp_recv(ctx);
+		break;
+	default:
+		err = ERR_ARG;
+		break;
+	}
+
+	if (err != ERR_OK) {
+		IPERF_ERR("open failed, err %d\n", err);
+		iperf_raw_finish(ctx, err);
+	}
+}
+
+static void iperf_raw_stop(struct iperf_raw *ctx)
+{
+	if (ctx->state == IPERF_RAW_ST_RUN && ctx->idata->mode == IPERF_MODE_UDP_SEND)
+		iperf_raw_udp_send_fin(ctx, IPERF_RAW_TIME_US());
+	else
+		iperf_raw_finish(ctx, ERR_OK);
+}
+
+static void iperf_raw_tick(void *arg)
+{
+	struct iperf_raw *ctx = arg;
+	uint64_t now = IPERF_RAW_TIME_US();
+
+	if (!ctx->opened) {
+		ctx->opened = 1;
+		iperf_raw_open(ctx);
+	} else if (ctx->stop_req && !ctx->stopped) {
+		ctx->stopped = 1;
+		iperf_raw_stop(ctx);
+	}
+	if (ctx->state == IPERF_RAW_ST_DONE)
+		goto out;
+
+	switch (ctx->idata->mode) {
+	case IPERF_MODE_UDP_SEND:
+		if (ctx->state == IPERF_RAW_ST_RUN) {
+			iperf_raw_udp_pace(ctx, now);
+		} else if (ctx->state == IPERF_RAW_ST_FIN &&
+		           now - ctx->evt_us >= IPERF_RAW_FIN_INTERVAL) {
+			if (ctx->fin_cnt < IPERF_RAW_FIN_RETRY) {
+				iperf_raw_udp_send_fin(ctx, now);
+			} else {
+				IPERF_WARN("did not receive ack of last datagram after %d tries.\n",
+				           ctx->fin_cnt);
+				iperf_raw_finish(ctx, ERR_TIMEOUT);
+			}
+		}
+		break;
+	case IPERF_MODE_UDP_RECV:
+		if (ctx->state == IPERF_RAW_ST_FIN &&
+		    now - ctx->evt_us >= IPERF_RAW_FIN_LINGER)
+			iperf_raw_finish(ctx, ERR_OK);
+		break;
+	case IPERF_MODE_TCP_SEND:
+		if (ctx->state == IPERF_RAW_ST_RUN)
+			iperf_raw_tcp_fill(ctx);
+		break;
+	default:
+		break;
+	}
+
+out:
+	ctx->tick_pending = 0; /* last access, the thread may free ctx after it */
+}
+
+/* --------------------------------------------------------------------------
+ * iperf thread
+ * -------------------------------------------------------------------------- */
+
+static void iperf_raw_report(struct iperf_raw *ctx)
+{
+	iperf_arg *idata = ctx->idata;
+	uint32_t jitter, lost, num;
+
+	if (ctx->beg_us == 0) {
+		IPERF_WARN("[%d] no data, err %d\n", idata->handle, ctx->err);
+		return;
+	}
+	if (ctx->err != ERR_OK)
+		IPERF_WARN("[%d] stopped on err %d\n", idata->handle, ctx->err);
+
+	iperf_speed_log(idata, ctx->total, (uint32_t)((ctx->end_us - ctx->beg_us) / 1000), 1);
+
+	switch (idata->mode) {
+	case IPERF_MODE_UDP_SEND:
+		if (!ctx->has_report)
+			break;
+		jitter = ntohl(ctx->report.jitter1) * 1000000 + ntohl(ctx->report.jitter2);
+		lost = ntohl(ctx->report.error_cnt);
+		num = ntohl(ctx->report.datagrams);
+		IPERF_LOG(1, "[%d] server: jitter %u.%03u ms, lost %u/%u (%u%%), out of order %u\n",
+		          idata->handle, jitter / 1000, jitter % 1000, lost, num,
+		          num ? (uint32_t)((uint64_t)lost * 100 / num) : 0,
+		          ntohl(ctx->report.outorder_cnt));
+		break;
+	case IPERF_MODE_UDP_RECV:
+		jitter = ctx->jitter16 >> 4;
+		num = ctx->seq;
+		IPERF_LOG(1, "[%d] jitter %u.%03u ms, lost %u/%u (%u%%), out of order %u\n",
+		          idata->handle, jitter / 1000, jitter % 1000, ctx->lost, num,
+		          num ? (uint32_t)((uint64_t)ctx->lost * 100 / num) : 0,
+		          ctx->outorder);
+		iperf_hist_log(idata, "transit variation", &ctx->hist);
+		break;
+	case IPERF_MODE_TCP_SEND:
+		iperf_hist_log(idata, "write to ack latency", &ctx->hist);
+		break;
+	case IPERF_MODE_TCP_RECV:
+		iperf_hist_log(idata, "arrival gap", &ctx->hist);
+		break;
+	default:
+		break;
+	}
+}
+
+void iperf_raw_task(void *arg)
+{
+	iperf_arg *idata = (iperf_arg *)arg;
+	struct iperf_raw *ctx;
+	uint32_t run_time = idata->run_time * 1000;
+	uint32_t interval = idata->interval * 1000;
+	uint32_t slice = IPERF_RAW_SLICE;
+	uint32_t run_beg_tm = 0, beg_tm = 0, cur_tm;
+	uint32_t last_bytes = 0, last_lat_sum = 0, last_lat_num = 0;
+	uint32_t last_pkts = 0, last_lost = 0, pkts, lost, jitter;
+	uint32_t i;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		IPERF_ERR("malloc() failed!\n");
+		goto exit;
+	}
+	ctx->idata = idata;
+	ctx->remote_port = idata->port;
+#if IPERF_OPT_NUM
+	ctx->left = idata->amount;
+	if (idata->mode == IPERF_MODE_UDP_RECV || idata->mode == IPERF_MODE_TCP_RECV)
+		idata->mode_time = 1;
+#endif
+	if (idata->mode == IPERF_MODE_UDP_SEND)
+		slice = IPERF_RAW_SLICE_UDP;
+
+	if (idata->mode == IPERF_MODE_UDP_SEND || idata->mode == IPERF_MODE_TCP_SEND) {
+		if (!ipaddr_aton(idata->remote_ip, &ctx->remote_ip)) {
+			IPERF_ERR("invalid ip %s\n", idata->remote_ip);
+			goto exit;
+		}
+	}
+
+	if (iperf_raw_payload[1] == 0) {
+		for (i = 0; i < sizeof(iperf_raw_payload); ++i)
+			iperf_raw_payload[i] = '0' + i % 10;
+	}
+
+	if (OS_SemaphoreCreate(&ctx->done, 0, 1) != OS_OK) {
+		IPERF_ERR("sem create failed\n");
+		goto exit;
+	}
+	ctx->tick_msg = tcpip_callbackmsg_new(iperf_raw_tick, ctx);
+	if (ctx->tick_msg == NULL) {
+		IPERF_ERR("tcpip callback msg alloc failed\n");
+		goto exit;
+	}
+	iperf_raw_post(ctx); /* opens the pcbs */
+
+	if (idata->mode == IPERF_MODE_UDP_SEND || idata->mode == IPERF_MODE_TCP_SEND)
+		IPERF_DBG("iperf: %s send to %s:%d (raw)\n",
+		          idata->mode == IPERF_MODE_UDP_SEND ? "UDP" : "TCP",
+		          idata->remote_ip, idata->port);
+	else
+		IPERF_DBG("iperf: %s recv at port %d (raw)\n",
+		          idata->mode == IPERF_MODE_UDP_RECV ? "UDP" : "TCP", idata->port);
+
+	while (OS_SemaphoreWait(&ctx->done, slice) != OS_OK) {
+		cur_tm = IPERF_RAW_TIME_MS();
+
+		if (ctx->state == IPERF_RAW_ST_RUN && run_beg_tm == 0) {
+			run_beg_tm = beg_tm = cur_tm;
+			last_bytes = ctx->bytes;
+			last_pkts = ctx->pkts;
+			last_lost = ctx->lost;
+			last_lat_sum = ctx->lat_sum;
+			last_lat_num = ctx->lat_num;
+		}
+
+		if ((idata->flags & IPERF_FLAG_STOP) ||
+		    (run_time && run_beg_tm && cur_tm - run_beg_tm >= run_time))
+			ctx->stop_req = 1; /* handled by the tick */
+		iperf_raw_post(ctx);
+
+		if (ctx->state != IPERF_RAW_ST_RUN || cur_tm - beg_tm < interval)
+			continue;
+
+		i = ctx->bytes;
+		iperf_speed_log(idata, i - last_bytes, cur_tm - beg_tm, 0);
+		last_bytes = i;
+		beg_tm = cur_tm;
+
+		if (idata->mode == IPERF_MODE_UDP_RECV) {
+			pkts = ctx->pkts;
+			lost = ctx->lost;
+			jitter = ctx->jitter16 >> 4;
+			IPERF_LOG(1, "[%d] jitter %u.%03u ms, lost %u/%u\n", idata->handle,
+			          jitter / 1000, jitter % 1000, lost - last_lost,
+			          pkts - last_pkts + lost - last_lost);
+			last_pkts = pkts;
+			last_lost = lost;
+		} else if (idata->mode == IPERF_MODE_TCP_SEND) {
+			i = ctx->lat_num - last_lat_num;
+			if (i)
+				IPERF_LOG(1, "[%d] ack latency avg %u us\n", idata->handle,
+				          (ctx->lat_sum - last_lat_sum) / i);
+			last_lat_sum = ctx->lat_sum;
+			last_lat_num = ctx->lat_num;
+		}
+	}
+
+	/* a tick may still be queued, it must run before ctx is freed */
+	while (ctx->tick_pending)
+		OS_MSleep(1);
+
+	iperf_raw_report(ctx);
+
+exit:
+	if (ctx) {
+		if (ctx->tick_msg)
+			tcpip_callbackmsg_delete(ctx->tick_msg);
+		if (OS_SemaphoreIsValid(&ctx->done))
+			OS_SemaphoreDelete(&ctx->done);
+		free(ctx);
+	}
+
+	OS_Thread_t thread = idata->iperf_thread;
+	iperf_handle_free(idata->handle);
+	IPERF_DBG("%s() [%d] exit!\n", __func__, idata->handle);
+	OS_ThreadDelete(&thread);
+}
+
+#endif /* IPERF_OPT_RAW */
+#endif /* PRJCONF_NET_EN */
@@ -292,6 +292,43 @@ extern "C" {
                                          PM_SUPPORT_HIBERNATION)
 #endif
 
+/*
+ * fast reconnect enable/disable, keep the PMK, the last AP and the last DHCP
+ * lease in flash to reconnect without scan, PBKDF2 and DHCP DISCOVER
+ */
+#ifndef PRJCONF_NET_FAST_CONN_EN
+#define PRJCONF_NET_FAST_CONN_EN        0
+#endif
+
+#if PRJCONF_NET_FAST_CONN_EN
+
+/* fast reconnect record flash ID */
+#ifndef PRJCONF_NET_FAST_CONN_FLASH
+#define PRJCONF_NET_FAST_CONN_FLASH     PRJCONF_SYSINFO_FLASH
+#endif
+
+/* fast reconnect record size */
+#ifndef PRJCONF_NET_FAST_CONN_SIZE
+#define PRJCONF_NET_FAST_CONN_SIZE      (4 * 1024)
+#endif
+
+/*
+ * fast reconnect record start address, no default: the sector below sysinfo
+ * is inside the image area of most projects (eg. 1020K max_size)
+ */
+#ifndef PRJCONF_NET_FAST_CONN_ADDR
+#error "PRJCONF_NET_FAST_CONN_ADDR MUST be set to a free flash area outside the image and OTA areas!"
+#endif
+
+#if (PRJCONF_SYSINFO_SAVE_TO_FLASH && \
+     (PRJCONF_NET_FAST_CONN_FLASH == PRJCONF_SYSINFO_FLASH) && \
+     (PRJCONF_NET_FAST_CONN_ADDR < PRJCONF_SYSINFO_ADDR + PRJCONF_SYSINFO_SIZE) && \
+     (PRJCONF_SYSINFO_ADDR < PRJCONF_NET_FAST_CONN_ADDR + PRJCONF_NET_FAST_CONN_SIZE))
+#error "fast reconnect record overlaps sysinfo!"
+#endif
+
+#endif /* PRJCONF_NET_FAST_CONN_EN */
+
 /* environment variable "TZ" for time zone setting */
 #ifndef PRJCONF_ENV_TZ
 #define PRJCONF_ENV_TZ                  "TZ=GMT-8"
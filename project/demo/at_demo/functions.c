@@ -436,7 +436,7 @@ s32 at_cmdline(char *buf, u32 size)
     return -1;
 }
 
-static u8 queue_buf[1024+4];
+static u8 queue_buf[2048];
 
 void occur(uint32_t evt, uint32_t data, void *arg);
 
@@ -610,6 +610,7 @@ static AT_ERROR_CODE mode(at_callback_para_t *para, at_callback_rsp_t *rsp)
     u8 *buffer;
     s32 len;
     s32 timeout_ms=10;
+    s32 send_timeout_ms=1000;
     fd_set fdset_r,fdset_w;
     int fd;
     struct sockaddr_in address;
@@ -635,8 +636,14 @@ static AT_ERROR_CODE mode(at_callback_para_t *para, at_callback_rsp_t *rsp)
                 FD_SET(fd, &fdset_w);
                 FD_SET(fd, &fdset_r);
 
-                tv.tv_sec = timeout_ms / 1000;
-                tv.tv_usec = (timeout_ms % 1000) * 1000;
+                /* data mode calls in with len 0 when idle, only wait then */
+                if (para->u.mode.len > 0) {
+                    tv.tv_sec = 0;
+                    tv.tv_usec = 0;
+                } else {
+                    tv.tv_sec = timeout_ms / 1000;
+                    tv.tv_usec = (timeout_ms % 1000) * 1000;
+                }
 
                 rc = select(fd + 1, &fdset_r, NULL, NULL, &tv);
                 if (rc > 0) {
@@ -674,6 +681,10 @@ static AT_ERROR_CODE mode(at_callback_para_t *para, at_callback_rsp_t *rsp)
                     res = AEC_NETWORK_ERROR;
                 }
 
+                /* wait for room rather than drop the packet */
+                tv.tv_sec = send_timeout_ms / 1000;
+                tv.tv_usec = (send_timeout_ms % 1000) * 1000;
+
                 rc = select(fd + 1, NULL, &fdset_w, NULL, &tv);
                 if (rc > 0) {
                     if (FD_ISSET(fd, &fdset_w)) {
@@ -788,6 +799,9 @@ static AT_ERROR_CODE mode(at_callback_para_t *para, at_callback_rsp_t *rsp)
                 res = AEC_NETWORK_ERROR;
             }
 
+            tv.tv_sec = send_timeout_ms / 1000;
+            tv.tv_usec = (send_timeout_ms % 1000) * 1000;
+
             rc = select(fd + 1, NULL, &fdset_w, NULL, &tv);
             if (rc > 0) {
                 if (FD_ISSET(fd, &fdset_w)) {
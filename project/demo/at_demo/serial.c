@@ -42,6 +42,17 @@
 #define SERIAL_CACHE_BUF_NUM    16
 #define SERIAL_CACHE_BUF_SIZE   (64/2)
 
+#if SERIAL_RX_DMA
+/*
+ * RX DMA ring, a power of 2. The DMA fills it in chunks of at most
+ * SERIAL_DMA_CHUNK bytes, a partial chunk is collected by serial_read()
+ * after SERIAL_DMA_POLL_MS without a completed one.
+ */
+#define SERIAL_DMA_BUF_SIZE     (4 * 1024)
+#define SERIAL_DMA_CHUNK        512
+#define SERIAL_DMA_POLL_MS      10
+#endif
+
 #define ATCMDSEND_MAX_BUFF_SIZE (1024L+64L)
 
 typedef enum {
@@ -81,12 +92,25 @@ typedef struct serial_priv {
         uint8_t len[SERIAL_CACHE_BUF_NUM];
         uint8_t buf[SERIAL_CACHE_BUF_NUM][SERIAL_CACHE_BUF_SIZE];
     } cache;
+
+#if SERIAL_RX_DMA
+    struct {
+        volatile uint32_t head; /* bytes received, free running */
+        uint32_t tail;          /* bytes read, free running */
+        uint32_t len;           /* length of the running transfer, 0 if none */
+    } dma;
+#endif
 } serial_priv_t;
 
 static serial_priv_t g_serial;
+
+#if SERIAL_RX_DMA
+static uint8_t g_serial_dma_buf[SERIAL_DMA_BUF_SIZE];
+#endif
 void atcmd_sendTask(void *pvParameters);
 
 
+#if !SERIAL_RX_DMA
 /* Note: only support line end with "\r\n" or "\n", not support "\r" */
 static void serial_rx_callback(void *arg)
 {
@@ -164,6 +188,134 @@ static void serial_rx_callback(void *arg)
         SERIAL_WARN("no buf for rx, discard received data\n");
     }
 }
+#endif /* !SERIAL_RX_DMA */
+
+#if SERIAL_RX_DMA
+/*
+ * Account for the bytes the running transfer has received and start the
+ * next one at the new head. Runs from the DMA end callback, or with IRQs
+ * disabled. A transfer completing while the reader restarts it raises a
+ * callback for the new transfer, which then just counts what it has got.
+ */
+static void serial_dma_restart(serial_priv_t *serial)
+{
+    uint32_t off;
+    uint32_t len;
+    int32_t left;
+
+    if (serial->dma.len > 0) {
+        left = HAL_UART_StopReceive_DMA(serial->uartID);
+        if (left >= 0 && left <= serial->dma.len) {
+            serial->dma.head += serial->dma.len - left;
+        }
+        serial->dma.len = 0;
+    }
+
+    off = serial->dma.head & (SERIAL_DMA_BUF_SIZE - 1);
+    len = SERIAL_DMA_BUF_SIZE - (serial->dma.head - serial->dma.tail);
+    if (len > SERIAL_DMA_BUF_SIZE - off) {
+        len = SERIAL_DMA_BUF_SIZE - off;
+    }
+    if (len > SERIAL_DMA_CHUNK) {
+        len = SERIAL_DMA_CHUNK;
+    }
+    if (len == 0) {
+        return; /* ring full, the reader restarts it (hwfc holds the peer) */
+    }
+
+    if (HAL_UART_StartReceive_DMA(serial->uartID, &g_serial_dma_buf[off], len) == HAL_OK) {
+        serial->dma.len = len;
+    }
+}
+
+static void serial_dma_end_callback(void *arg)
+{
+    serial_priv_t *serial = arg;
+
+    serial_dma_restart(serial);
+    OS_SemaphoreRelease(&serial->cmd_sem);
+}
+
+static int serial_dma_enable(serial_priv_t *serial)
+{
+    DMA_ChannelInitParam param;
+
+    memset(&param, 0, sizeof(param));
+    param.cfg = 0; /* default: single transfer, remaining byte count */
+    param.irqType = DMA_IRQ_TYPE_END;
+    param.endCallback = serial_dma_end_callback;
+    param.endArg = serial;
+
+    if (HAL_UART_InitRxDMA(serial->uartID, &param) != HAL_OK) {
+        SERIAL_ERR("init rx dma failed\n");
+        return -1;
+    }
+
+    serial->dma.head = 0;
+    serial->dma.tail = 0;
+    serial->dma.len = 0;
+
+    arch_irq_disable();
+    serial_dma_restart(serial);
+    arch_irq_enable();
+
+    return 0;
+}
+
+static void serial_dma_disable(serial_priv_t *serial)
+{
+    arch_irq_disable();
+    if (serial->dma.len > 0) {
+        HAL_UART_StopReceive_DMA(serial->uartID);
+        serial->dma.len = 0;
+    }
+    arch_irq_enable();
+
+    HAL_UART_DeInitRxDMA(serial->uartID);
+}
+
+static int serial_dma_read(serial_priv_t *serial, uint8_t *buf, int32_t size)
+{
+    uint32_t avail;
+    uint32_t off;
+    uint32_t len;
+    int32_t cnt = 0;
+
+    if (serial->dma.head == serial->dma.tail) {
+        OS_SemaphoreWait(&serial->cmd_sem, SERIAL_DMA_POLL_MS);
+
+        arch_irq_disable();
+        serial_dma_restart(serial); /* collect a partial chunk */
+        arch_irq_enable();
+    }
+
+    avail = serial->dma.head - serial->dma.tail;
+    while (cnt < size && avail > 0) {
+        off = serial->dma.tail & (SERIAL_DMA_BUF_SIZE - 1);
+        len = SERIAL_DMA_BUF_SIZE - off;
+        if (len > avail) {
+            len = avail;
+        }
+        if (len > size - cnt) {
+            len = size - cnt;
+        }
+        memcpy(buf + cnt, &g_serial_dma_buf[off], len);
+        serial->dma.tail += len;
+        avail -= len;
+        cnt += len;
+    }
+
+    if (cnt > 0 && serial->dma.len == 0) {
+        arch_irq_disable();
+        if (serial->dma.len == 0) {
+            serial_dma_restart(serial); /* ring was full */
+        }
+        arch_irq_enable();
+    }
+
+    return cnt;
+}
+#endif /* SERIAL_RX_DMA */
 
 int serial_config(UART_ID uart_id, int baudrate, int data_bits, int parity, int stop_bits, int hwfc)
 {
@@ -238,13 +390,21 @@ int serial_deinit(UART_ID uart_id)
 /* NB: Make sure uart is inited before calling this function. */
 int serial_start(void)
 {
+#if !SERIAL_RX_DMA
     UART_T *uart;
+#endif
     serial_priv_t *serial;
 
     serial = &g_serial;
 
+#if SERIAL_RX_DMA
+    if (serial_dma_enable(serial) != 0) {
+        return -1;
+    }
+#else
     uart = HAL_UART_GetInstance(serial->uartID);
     HAL_UART_EnableRxCallback(serial->uartID, serial_rx_callback, uart);
+#endif
     serial->state = SERIAL_STATE_START;
 
         /* start atcmd task */
@@ -266,7 +426,11 @@ void serial_stop(void)
     serial_priv_t *serial;
 
     serial = &g_serial;
+#if SERIAL_RX_DMA
+    serial_dma_disable(serial);
+#else
     HAL_UART_DisableRxCallback(serial->uartID);
+#endif
     serial->state = SERIAL_STATE_STOP;
 }
 
@@ -278,14 +442,24 @@ void serial_bezero_g_serial(void)
 int serial_read(uint8_t *buf, int32_t size)
 {
     serial_priv_t *serial;
+#if !SERIAL_RX_DMA
     uint32_t cnt;
     uint32_t idx;
+    int len;
+#endif
     int rlen = 0;
 
 //  SERIAL_DBG("%s() start...\n", __func__);
 
     serial = &g_serial;
 
+#if SERIAL_RX_DMA
+    if (serial->state != SERIAL_STATE_START) {
+        OS_MSleep(SERIAL_DMA_POLL_MS);
+        return 0;
+    }
+    rlen = serial_dma_read(serial, buf, size);
+#else
     idx = serial->cache.ridx;
 
     while (1) {
@@ -293,7 +467,7 @@ int serial_read(uint8_t *buf, int32_t size)
         if (OS_SemaphoreWait(&serial->cmd_sem, OS_WAIT_FOREVER) != OS_OK)
             continue;
 */
-        if (OS_SemaphoreWait(&serial->cmd_sem, 10) != OS_OK)
+        if (OS_SemaphoreWait(&serial->cmd_sem, rlen ? 0 : 10) != OS_OK)
             break;
 
         if (serial->state != SERIAL_STATE_START)
@@ -304,12 +478,18 @@ int serial_read(uint8_t *buf, int32_t size)
         arch_irq_enable();
 
         if (cnt > 0) {
-            rlen = serial->cache.len[idx];
-            if (rlen > size) {
-                return -1; /* buffer size is too small */
+            len = serial->cache.len[idx];
+            if (rlen + len > size) {
+                if (rlen == 0) {
+                    return -1; /* buffer size is too small */
+                }
+                /* no room left, keep this chunk for the next call */
+                OS_SemaphoreRelease(&serial->cmd_sem);
+                break;
             }
 
-            memcpy(buf, serial->cache.buf[idx], rlen);
+            memcpy(buf + rlen, serial->cache.buf[idx], len);
+            rlen += len;
 
             idx++;
             if (idx >= SERIAL_CACHE_BUF_NUM) {
@@ -322,13 +502,14 @@ int serial_read(uint8_t *buf, int32_t size)
             serial->cache.cnt--;
             arch_irq_enable();
 
-            break;
+            /* go on with the chunks already waiting */
         }
         else {
             SERIAL_WARN("no valid command\n");
-            return -2; /* no data  */
+            return rlen ? rlen : -2; /* no data  */
         }
     }
+#endif
 
     return rlen;
 }
@@ -347,19 +528,29 @@ void serial_disable(void)
 
     serial = &g_serial;
     if (serial->state == SERIAL_STATE_START) {
+#if SERIAL_RX_DMA
+        serial_dma_disable(serial);
+#else
         HAL_UART_DisableRxCallback(serial->uartID);
+#endif
     }
 }
 
 void serial_enable(void)
 {
     serial_priv_t *serial;
+#if !SERIAL_RX_DMA
     UART_T *uart;
+#endif
 
     serial = &g_serial;
     if (serial->state == SERIAL_STATE_START) {
+#if SERIAL_RX_DMA
+        serial_dma_enable(serial);
+#else
         uart = HAL_UART_GetInstance(serial->uartID);
         HAL_UART_EnableRxCallback(serial->uartID, serial_rx_callback, uart);
+#endif
     }
 }
 
@@ -38,6 +38,14 @@ extern "C" {
 
 #define SERIAL_UART_ID      UART0_ID    /* debug and console */
 
+/*
+ * Receive through DMA into a ring instead of the per-byte RX interrupt.
+ * Opt-in: set to HAL_UART_OPT_DMA once tested on the target board.
+ */
+#ifndef SERIAL_RX_DMA
+#define SERIAL_RX_DMA       0
+#endif
+
 typedef void (*serial_cmd_exec_func)(void);
 
 typedef struct serial_param {
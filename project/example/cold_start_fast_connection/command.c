@@ -201,6 +201,9 @@ static const struct cmd_data g_main_cmds[] = {
 	{ "lmac",	cmd_lmac_exec },
 #endif
 	{ "sysinfo",cmd_sysinfo_exec },
+#ifdef __CONFIG_TIMELINE
+	{ "timeline", cmd_timeline_exec },
+#endif
 };
 
 void main_cmd_exec(char *cmd)
@@ -7,3 +7,6 @@
 # ----------------------------------------------------------------------------
 # enable/disable XIP, default to y
 export __CONFIG_XIP := y
+
+# boot timeline profiler, show the boot spans after connecting
+export __CONFIG_TIMELINE := y
@@ -38,9 +38,8 @@
 #include "lwip/inet.h"
 #include "sys/fdcm.h"
 #include "sys/xr_debug.h"
-#include "util/time_logger.h"
+#include "util/timeline.h"
 
-extern uint64_t HAL_RTC_GetFreeRunTime(void);
 extern void stdout_enable(uint8_t en);
 extern void dns_setserver(u8_t numdns, ip_addr_t *dnsserver);
 
@@ -112,13 +111,14 @@ char sta_ssid[100];
 char sta_psk[100];
 void connect_ap(void)
 {
+	TIMELINE_BEGIN("connect");
     printf("Wait for link up...\n");
 	printf("use this cmd to connect your ap with your own ssid and password:\n"
 			"\t\"net fc config your_ssid your_password\"\n\t\"net fc enable\"\n");
     while (!g_ap_connected) {
         OS_MSleep(10);
     }
-	save_time((uint32_t)HAL_RTC_GetFreeRunTime(), 2);
+	TIMELINE_END("connect");
     printf("Connect AP success!\n");
 	struct sysinfo *sysinfo = sysinfo_get();
 	if (sysinfo == NULL) {
@@ -250,13 +250,14 @@ void connect_ap_fast(bss_info_t * pbss_info)
 	wlan_sta_set((uint8_t *)pbss_info->ssid, strlen((char *)pbss_info->ssid), (uint8_t *)psk_buf);
 
     FC_DEBUG("Try to connect AP\n");
+	TIMELINE_BEGIN("connect");
 	wlan_sta_enable();
 
     FC_DEBUG("Wait for link up...\n");
     while (!g_ap_connected) {
         OS_MSleep(10);
     }
-	save_time((uint32_t)HAL_RTC_GetFreeRunTime(), 2);
+	TIMELINE_END("connect");
     //Fast connect AP success
 }
 
@@ -329,17 +330,16 @@ void fast_connect_example(void)
 
 int main(void)
 {
-	uint32_t time_eob, time_eop;
-	time_eob = (uint32_t)HAL_RTC_GetFreeRunTime();
+	TIMELINE_MARK("begin app");
 #if !FC_DEBUG_EN
 	stdout_enable(0);
 #endif
 	platform_init();
-	time_eop = (uint32_t)HAL_RTC_GetFreeRunTime();
-	save_time(time_eob, 0);
-	save_time(time_eop, 1);
 	fast_connect_example();
-	get_time();
+	TIMELINE_MARK("end connection");
+#ifdef __CONFIG_TIMELINE
+	timeline_show();
+#endif
 
 	ip_addr_t dnsserver;
 	ip4_addr_set_u32(&dnsserver, ipaddr_addr("180.76.76.76"));
@@ -0,0 +1,12 @@
+#
+# project local config options, override the global config options
+#
+
+# ----------------------------------------------------------------------------
+# override global config options
+# ----------------------------------------------------------------------------
+# enable/disable wlan, default to y
+export __CONFIG_WLAN := n
+
+# enable/disable XIP, default to y
+export __CONFIG_XIP := n
@@ -28,37 +28,19 @@
  */
 
 #include <stdio.h>
-#include "util/time_logger.h"
+#include "kernel/os/os.h"
+#include "os_bench.h"
 
-#define SAVE_TIME_TAB		0x00200F80
-#define MAX_SIZE_OF_TIME_ITEM	3
-char * time_item[MAX_SIZE_OF_TIME_ITEM] = {
-//"begin boot",//0
-"begin app",
-"end pf init",
-//"send auth",
-//"send assoc",//4
-//"net if up",
-"end connection",//6
-};
+#define BENCH_LOOPS     1000
 
-void save_time(uint32_t t, uint32_t i)
+/* Run this example, please connect the uart0 */
+int main(void)
 {
-	((uint32_t *)SAVE_TIME_TAB)[i] = t;
-}
+	printf("os bench example started.\n\n");
 
-void get_time(void)
-{
-	printf("\n");
-	for(int i = 0;i < MAX_SIZE_OF_TIME_ITEM;i++) {
-		if (i == 0)
-			printf("%s:\t%06dus\tdelta:%dus\n", time_item[i], ((uint32_t *)SAVE_TIME_TAB)[i],
-										((uint32_t *)SAVE_TIME_TAB)[i]);
-		else
-			printf("%s:\t%06dus\tdelta:%dus\n", time_item[i], ((uint32_t *)SAVE_TIME_TAB)[i],
-										((uint32_t *)SAVE_TIME_TAB)[i] - ((uint32_t *)SAVE_TIME_TAB)[i-1]);
-	}
-	printf("delta of %s to %s:\t%dus\n", time_item[0], time_item[MAX_SIZE_OF_TIME_ITEM - 1],
-				((uint32_t *)SAVE_TIME_TAB)[MAX_SIZE_OF_TIME_ITEM - 1] - ((uint32_t *)SAVE_TIME_TAB)[0]);
-}
+	os_bench_run(BENCH_LOOPS);
 
+	printf("os bench example over.\n");
+
+	return 0;
+}
@@ -0,0 +1,427 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "kernel/os/os.h"
+#include "os_bench.h"
+
+#ifdef __CONFIG_OS_POSIX
+#include <time.h>
+#else
+#include "driver/chip/hal_cmsis.h"
+#include "driver/chip/hal_clock.h"
+#endif
+
+#define BENCH_THREAD_STACK_SIZE     (2 * 1024)
+#define BENCH_QUEUE_LEN             16
+#define BENCH_TIMER_PERIOD_MS       10
+
+/*
+ * Time stamps: the monotonic clock on the host, the DWT cycle counter on
+ * the target. Only differences are used, so 32 bits are enough.
+ */
+#ifdef __CONFIG_OS_POSIX
+
+static void bench_clock_init(void)
+{
+}
+
+static __always_inline uint32_t bench_stamp(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+static __always_inline uint32_t bench_to_ns(uint32_t delta)
+{
+	return delta;
+}
+
+#else /* __CONFIG_OS_POSIX */
+
+static uint32_t bench_cpu_mhz;
+
+static void bench_clock_init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	bench_cpu_mhz = HAL_GetCPUClock() / 1000000;
+}
+
+static __always_inline uint32_t bench_stamp(void)
+{
+	return DWT->CYCCNT;
+}
+
+static __always_inline uint32_t bench_to_ns(uint32_t delta)
+{
+	return (uint32_t)((uint64_t)delta * 1000 / bench_cpu_mhz);
+}
+
+#endif /* __CONFIG_OS_POSIX */
+
+/* samples of one test, in ns */
+struct bench_stat {
+	uint32_t *val;
+	uint32_t cnt;
+	uint32_t max_cnt;
+};
+
+static int bench_stat_init(struct bench_stat *st, uint32_t max_cnt)
+{
+	st->cnt = 0;
+	st->val = malloc(max_cnt * sizeof(uint32_t));
+	st->max_cnt = max_cnt;
+	return st->val ? 0 : -1;
+}
+
+static void bench_stat_add(struct bench_stat *st, uint32_t ns)
+{
+	if (st->cnt < st->max_cnt)
+		st->val[st->cnt++] = ns;
+}
+
+static int bench_cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void bench_stat_show(struct bench_stat *st, const char *name)
+{
+	uint64_t sum = 0;
+	uint32_t i;
+
+	if (st->val == NULL || st->cnt == 0) {
+		printf("%-24s no samples\n", name);
+	} else {
+		qsort(st->val, st->cnt, sizeof(uint32_t), bench_cmp_u32);
+		for (i = 0; i < st->cnt; i++)
+			sum += st->val[i];
+		printf("%-24s %10u %10u %10u %10u %10u\n", name,
+		       st->val[0], (uint32_t)(sum / st->cnt),
+		       st->val[st->cnt / 2], st->val[st->cnt * 99 / 100],
+		       st->val[st->cnt - 1]);
+	}
+	free(st->val);
+	st->val = NULL;
+}
+
+static void bench_rate_show(const char *name, uint32_t ops, uint32_t ns)
+{
+	printf("%-24s %10u ns/op %10u op/s\n", name, ns / (ops ? ops : 1),
+	       ns ? (uint32_t)((uint64_t)ops * 1000000000ULL / ns) : 0);
+}
+
+/*
+ * Shared state of a test, the peer thread is created per test and signals
+ * bench.done when it has finished.
+ */
+static struct {
+	OS_Thread_t thread;
+	OS_Semaphore_t ping;
+	OS_Semaphore_t pong;
+	OS_Semaphore_t done;
+	OS_Queue_t q_ping;
+	OS_Queue_t q_pong;
+	OS_Mutex_t mutex;
+	OS_Timer_t timer;
+	uint32_t loops;
+	volatile uint32_t stamp;
+	volatile uint32_t counter;
+	struct bench_stat stat;
+} bench;
+
+static int bench_peer_start(OS_ThreadEntry_t entry, OS_Priority prio)
+{
+	OS_ThreadSetInvalid(&bench.thread);
+	if (OS_ThreadCreate(&bench.thread, "bench", entry, NULL, prio,
+	                    BENCH_THREAD_STACK_SIZE) != OS_OK) {
+		printf("create bench thread failed\n");
+		return -1;
+	}
+	return 0;
+}
+
+/* bench.thread may be reused as soon as done is released */
+static void bench_peer_exit(void)
+{
+	OS_SemaphoreRelease(&bench.done);
+	OS_ThreadDelete(NULL);
+}
+
+/* semaphore: round trip through a peer, and release to wake latency */
+static void bench_sem_task(void *arg)
+{
+	uint32_t i;
+
+	for (i = 0; i < bench.loops; i++) {
+		OS_SemaphoreWait(&bench.ping, OS_WAIT_FOREVER);
+		OS_SemaphoreRelease(&bench.pong);
+	}
+	for (i = 0; i < bench.loops; i++) {
+		OS_SemaphoreWait(&bench.ping, OS_WAIT_FOREVER);
+		bench_stat_add(&bench.stat, bench_to_ns(bench_stamp() - bench.stamp));
+		OS_SemaphoreRelease(&bench.pong);
+	}
+	bench_peer_exit();
+}
+
+static void bench_semaphore(void)
+{
+	struct bench_stat rtt;
+	uint32_t i, t0;
+
+	if (bench_stat_init(&rtt, bench.loops) || bench_stat_init(&bench.stat, bench.loops))
+		goto out;
+	if (bench_peer_start(bench_sem_task, OS_PRIORITY_ABOVE_NORMAL))
+		goto out;
+
+	for (i = 0; i < bench.loops; i++) {
+		t0 = bench_stamp();
+		OS_SemaphoreRelease(&bench.ping);
+		OS_SemaphoreWait(&bench.pong, OS_WAIT_FOREVER);
+		bench_stat_add(&rtt, bench_to_ns(bench_stamp() - t0));
+	}
+	for (i = 0; i < bench.loops; i++) {
+		bench.stamp = bench_stamp();
+		OS_SemaphoreRelease(&bench.ping);
+		OS_SemaphoreWait(&bench.pong, OS_WAIT_FOREVER);
+	}
+	OS_SemaphoreWait(&bench.done, OS_WAIT_FOREVER);
+
+out:
+	bench_stat_show(&rtt, "sem round trip");
+	bench_stat_show(&bench.stat, "sem wake");
+}
+
+/* queue: round trip of a time stamp, and one way producer/consumer rate */
+static void bench_queue_task(void *arg)
+{
+	uint32_t i, msg[4];
+
+	for (i = 0; i < bench.loops; i++) {
+		OS_QueueReceive(&bench.q_ping, msg, OS_WAIT_FOREVER);
+		bench_stat_add(&bench.stat, bench_to_ns(bench_stamp() - msg[0]));
+		OS_QueueSend(&bench.q_pong, msg, OS_WAIT_FOREVER);
+	}
+	for (i = 0; i < bench.loops * BENCH_QUEUE_LEN; i++) {
+		OS_QueueReceive(&bench.q_ping, msg, OS_WAIT_FOREVER);
+	}
+	bench_peer_exit();
+}
+
+static void bench_queue(void)
+{
+	struct bench_stat rtt;
+	uint32_t i, t0 = 0, msg[4] = { 0 };
+
+	if (bench_stat_init(&rtt, bench.loops) || bench_stat_init(&bench.stat, bench.loops))
+		goto out;
+	if (bench_peer_start(bench_queue_task, OS_PRIORITY_ABOVE_NORMAL))
+		goto out;
+
+	for (i = 0; i < bench.loops; i++) {
+		t0 = bench_stamp();
+		msg[0] = t0;
+		OS_QueueSend(&bench.q_ping, msg, OS_WAIT_FOREVER);
+		OS_QueueReceive(&bench.q_pong, msg, OS_WAIT_FOREVER);
+		bench_stat_add(&rtt, bench_to_ns(bench_stamp() - t0));
+	}
+
+	/* the consumer only drains, the queue fills when it's slower */
+	t0 = bench_stamp();
+	for (i = 0; i < bench.loops * BENCH_QUEUE_LEN; i++) {
+		OS_QueueSend(&bench.q_ping, msg, OS_WAIT_FOREVER);
+	}
+	OS_SemaphoreWait(&bench.done, OS_WAIT_FOREVER);
+	t0 = bench_to_ns(bench_stamp() - t0);
+
+out:
+	bench_stat_show(&rtt, "queue round trip");
+	bench_stat_show(&bench.stat, "queue send to recv");
+	bench_rate_show("queue stream 16B", bench.loops * BENCH_QUEUE_LEN, t0);
+}
+
+/* mutex: lock/unlock pair, alone and with a peer contending */
+static void bench_mutex_task(void *arg)
+{
+	uint32_t i;
+
+	for (i = 0; i < bench.loops; i++) {
+		OS_MutexLock(&bench.mutex, OS_WAIT_FOREVER);
+		bench.counter++;
+		OS_MutexUnlock(&bench.mutex);
+	}
+	bench_peer_exit();
+}
+
+static void bench_mutex(void)
+{
+	uint32_t i, t0, t1;
+
+	t0 = bench_stamp();
+	for (i = 0; i < bench.loops; i++) {
+		OS_MutexLock(&bench.mutex, OS_WAIT_FOREVER);
+		bench.counter++;
+		OS_MutexUnlock(&bench.mutex);
+	}
+	t0 = bench_to_ns(bench_stamp() - t0);
+	bench_rate_show("mutex uncontended", bench.loops, t0);
+
+	bench.counter = 0;
+	t1 = bench_stamp();
+	/* same priority, so the peer runs interleaved on a single core too */
+	if (bench_peer_start(bench_mutex_task, OS_PRIORITY_NORMAL))
+		return;
+	for (i = 0; i < bench.loops; i++) {
+		OS_MutexLock(&bench.mutex, OS_WAIT_FOREVER);
+		bench.counter++;
+		OS_MutexUnlock(&bench.mutex);
+		if ((i & 0xf) == 0)
+			OS_ThreadYield();
+	}
+	OS_SemaphoreWait(&bench.done, OS_WAIT_FOREVER);
+	t1 = bench_to_ns(bench_stamp() - t1);
+	bench_rate_show("mutex contended", bench.loops * 2, t1);
+	if (bench.counter != bench.loops * 2)
+		printf("mutex counter %u != %u\n", bench.counter, bench.loops * 2);
+}
+
+/*
+ * timer: one shot delay and period of a periodic timer, both nominally
+ * BENCH_TIMER_PERIOD_MS. On the target expiry is rounded to ticks.
+ */
+static void bench_timer_cb(void *arg)
+{
+	uint32_t now = bench_stamp();
+
+	if (arg) {
+		/* periodic, stamp holds the previous expiry */
+		if (bench.counter++ > 0)
+			bench_stat_add(&bench.stat, bench_to_ns(now - bench.stamp));
+		bench.stamp = now;
+		if (bench.counter == bench.stat.max_cnt + 1)
+			OS_SemaphoreRelease(&bench.done);
+	} else {
+		bench_stat_add(&bench.stat, bench_to_ns(now - bench.stamp));
+		OS_SemaphoreRelease(&bench.done);
+	}
+}
+
+static void bench_timer(uint32_t count)
+{
+	uint32_t i;
+
+	if (bench_stat_init(&bench.stat, count))
+		goto once_out;
+	OS_TimerSetInvalid(&bench.timer);
+	if (OS_TimerCreate(&bench.timer, OS_TIMER_ONCE, bench_timer_cb, NULL,
+	                   BENCH_TIMER_PERIOD_MS) != OS_OK)
+		goto once_out;
+	for (i = 0; i < count; i++) {
+		/* start right after a tick edge, the same phase every time */
+		OS_MSleep(1);
+		bench.stamp = bench_stamp();
+		OS_TimerStart(&bench.timer);
+		OS_SemaphoreWait(&bench.done, OS_WAIT_FOREVER);
+	}
+	OS_TimerDelete(&bench.timer);
+once_out:
+	bench_stat_show(&bench.stat, "timer once 10ms");
+
+	if (bench_stat_init(&bench.stat, count))
+		goto periodic_out;
+	bench.counter = 0;
+	OS_TimerSetInvalid(&bench.timer);
+	if (OS_TimerCreate(&bench.timer, OS_TIMER_PERIODIC, bench_timer_cb, &bench,
+	                   BENCH_TIMER_PERIOD_MS) != OS_OK)
+		goto periodic_out;
+	OS_TimerStart(&bench.timer);
+	OS_SemaphoreWait(&bench.done, OS_WAIT_FOREVER);
+	OS_TimerStop(&bench.timer);
+	OS_TimerDelete(&bench.timer);
+periodic_out:
+	bench_stat_show(&bench.stat, "timer period 10ms");
+}
+
+int os_bench_run(uint32_t loops)
+{
+	int ret = -1;
+
+	OS_SemaphoreSetInvalid(&bench.ping);
+	OS_SemaphoreSetInvalid(&bench.pong);
+	OS_SemaphoreSetInvalid(&bench.done);
+	OS_QueueSetInvalid(&bench.q_ping);
+	OS_QueueSetInvalid(&bench.q_pong);
+	OS_MutexSetInvalid(&bench.mutex);
+
+	if (OS_SemaphoreCreateBinary(&bench.ping) != OS_OK ||
+	    OS_SemaphoreCreateBinary(&bench.pong) != OS_OK ||
+	    OS_SemaphoreCreateBinary(&bench.done) != OS_OK ||
+	    OS_QueueCreate(&bench.q_ping, BENCH_QUEUE_LEN, sizeof(uint32_t) * 4) != OS_OK ||
+	    OS_QueueCreate(&bench.q_pong, BENCH_QUEUE_LEN, sizeof(uint32_t) * 4) != OS_OK ||
+	    OS_MutexCreate(&bench.mutex) != OS_OK) {
+		printf("create bench resources failed\n");
+		goto out;
+	}
+
+	bench_clock_init();
+	bench.loops = loops;
+
+	printf("%-24s %10s %10s %10s %10s %10s (ns)\n",
+	       "test", "min", "avg", "p50", "p99", "max");
+	bench_semaphore();
+	bench_queue();
+	bench_mutex();
+	bench_timer(100);
+	ret = 0;
+
+out:
+	if (OS_MutexIsValid(&bench.mutex))
+		OS_MutexDelete(&bench.mutex);
+	if (OS_QueueIsValid(&bench.q_pong))
+		OS_QueueDelete(&bench.q_pong);
+	if (OS_QueueIsValid(&bench.q_ping))
+		OS_QueueDelete(&bench.q_ping);
+	if (OS_SemaphoreIsValid(&bench.done))
+		OS_SemaphoreDelete(&bench.done);
+	if (OS_SemaphoreIsValid(&bench.pong))
+		OS_SemaphoreDelete(&bench.pong);
+	if (OS_SemaphoreIsValid(&bench.ping))
+		OS_SemaphoreDelete(&bench.ping);
+	return ret;
+}
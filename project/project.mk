@@ -81,11 +81,17 @@ LIBRARIES += -lcomponent
 LIBRARIES += -lreverb
 LIBRARIES += -laudmgr
 LIBRARIES += -lpcm
+LIBRARIES += -lresample
+LIBRARIES += -lfft
 LIBRARIES += -ladt
 LIBRARIES += -lutil
 LIBRARIES += -ljpeg
 LIBRARIES += -lzbar
-LIBRARIES += -leq
+ifeq ($(__CONFIG_AUDIO_EQ_FIXED), y)
+  LIBRARIES += -leqfix
+else
+  LIBRARIES += -leq
+endif
 LIBRARIES += -lopus
 
 endif # __CONFIG_BOOTLOADER
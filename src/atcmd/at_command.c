@@ -498,20 +498,58 @@ AT_ERROR_CODE at_help(void)
 	return AEC_OK;
 }
 
+/*
+ * at_command_table entries sorted by name, equal names in table order so the
+ * first one still wins. Built by at_init() (or the first lookup), the table
+ * itself keeps its order for AT+S.HELP.
+ */
+static u16 at_command_order[TABLE_SIZE(at_command_table)];
+static u8 at_command_sorted;
+
+static void at_command_sort(void)
+{
+	s32 i, j;
+	u16 e;
+
+	for (i = 0; i < TABLE_SIZE(at_command_table); i++) {
+		e = i;
+		for (j = i; j > 0 && strcmp(at_command_table[at_command_order[j - 1]].cmd,
+		                            at_command_table[e].cmd) > 0; j--) {
+			at_command_order[j] = at_command_order[j - 1];
+		}
+		at_command_order[j] = e;
+	}
+	at_command_sorted = 1;
+}
+
 static s32 at_match(char *cmd)
 {
-	s32 i;
+	s32 lo, hi, mid;
 
 	if (cmd == NULL) {
 		return -2;
 	}
 
-	for (i = 0; i < TABLE_SIZE(at_command_table); i++) {
-		if (!strcmp(cmd, at_command_table[i].cmd)) {
-			return i;
+	if (!at_command_sorted) {
+		at_command_sort();
+	}
+
+	lo = 0;
+	hi = TABLE_SIZE(at_command_table);
+	while (lo < hi) {
+		mid = (lo + hi) >> 1;
+		if (strcmp(at_command_table[at_command_order[mid]].cmd, cmd) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
 		}
 	}
 
+	if (lo < TABLE_SIZE(at_command_table) &&
+	    !strcmp(cmd, at_command_table[at_command_order[lo]].cmd)) {
+		return at_command_order[lo];
+	}
+
 	return -1;
 }
 
@@ -531,6 +569,9 @@ AT_ERROR_CODE at_init(at_callback_t *cb)
 	}
 
 	at_callback = *cb;
+	if (!at_command_sorted) {
+		at_command_sort();
+	}
 #if 0
 	para.cfg = &at_cfg;
 
@@ -2812,6 +2853,12 @@ static AT_ERROR_CODE send_data_handler(at_para_t *at_para)
 
     AT_WRN("at_cfg.CIPMUX== %d\r\n", at_cfg.CIPMUX);
     if (*at_para->ptr != AT_EQU) {
+        if (at_trans_get_mode() == 1 && send_cache.status == 0) {
+            /* transparent transmission until "+++" */
+            at_dump("\r\nOK\r\n>");
+            at_trans(AT_TRANS_ESCAPE);
+            return AEC_BLANK_LINE;
+        }
         return AEC_PARA_ERROR;
     } else {
         at_para->ptr++; /* skip '=' */
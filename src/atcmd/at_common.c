@@ -33,8 +33,6 @@
 #include "at_debug.h"
 #include "kernel/os/os.h"
 
-extern u8 at_socket_buf[AT_SOCKET_BUFFER_SIZE];
-
 typedef struct {
 	AT_ERROR_CODE aec;
 	const char *info;
@@ -145,46 +143,10 @@ AT_ERROR_CODE at_reset(void)
 
 AT_ERROR_CODE at_mode(AT_MODE mode)
 {
-	AT_QUEUE_ERROR_CODE aqec;
-	at_callback_para_t para;
-	s32 len,escape_len;
-	u8 tmp;
-
 	if (at_callback.handle_cb != NULL) {
-		memset(&para, 0, sizeof(para));
-		escape_len = strlen(at_cfg.escape_seq);
 		at_dump("Enter data mode.\r\n");
-		while (1) {
-			para.u.mode.buf = at_socket_buf;
-
-			len = 0;
-
-			while (len < AT_SOCKET_BUFFER_SIZE) {
-				aqec = at_queue_get(&tmp);
-
-				//AT_DBG("aqec = %d\n", aqec);
-				//AT_DBG("len = %d\n", len);
-				if(aqec == AQEC_OK) {
-					at_socket_buf[len++] = tmp;
-				}
-				else {
-					break;
-				}
-			}
-
-			if (len > 2 && (len >= escape_len && len <= escape_len + 2) &&
-				!strncmp(at_cfg.escape_seq, (const char *)at_socket_buf, escape_len)) {
-				at_dump("Exit data mode.\r\n");
-				break;
-			}
-
-			para.u.mode.len = len;
-			//AT_DBG("Enter callback\n");
-			if (at_callback.handle_cb(ACC_MODE, &para, NULL) != AEC_OK) {
-				at_dump("Exit data mode.\r\n");
-				break;
-			}
-		}
+		at_trans(at_cfg.escape_seq);
+		at_dump("Exit data mode.\r\n");
 	}
 
 	return AEC_OK;
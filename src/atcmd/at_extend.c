@@ -406,10 +406,18 @@ extern AT_ERROR_CODE at_set_trans_mode(int mode)
     AT_WRN("------>%s\n",__func__);
     at_callback_para_t para;
 
+    if (mode != 0 && mode != 1) {
+        return AEC_PARA_ERROR;
+    }
+    if (mode == 1 && at_cfg.CIPMUX) {
+        return AEC_IMPROPER_OPERATION; /* data mode only works on link 0 */
+    }
+
+    at_trans_set_mode(mode);
     para.cfg = &at_cfg;
 
     if (at_callback.handle_cb != NULL) {
-        at_callback.handle_cb(ACC_CWQAP, &para, NULL);
+        at_callback.handle_cb(ACC_CIPMODE, &para, NULL);
     }
     return AEC_OK; /* succeed */
 }
@@ -39,6 +39,12 @@ extern "C" {
 #define AT_SOCKET_BUFFER_SIZE	1024L
 #define MAX_DUMP_BUFF_SIZE	1024L
 
+#define AT_TRANS_PACKET_SIZE	AT_SOCKET_BUFFER_SIZE	/* data mode packet size */
+#define AT_TRANS_IDLE_MS	20	/* data mode idle time ending a packet */
+#define AT_TRANS_ESCAPE		"+++"	/* leaves AT+CIPSEND data mode */
+#define AT_QUEUE_POLL_MS	1	/* sleep when the source has nothing at once */
+#define AT_SOCKW_TIMEOUT_MS	3000	/* AT+SOCKW gives up after this long idle */
+
 #define ANL_WINDOWS	0
 #define ANL_UNIX	1
 #define ANL_MAC		2
@@ -106,6 +112,10 @@ extern AT_ERROR_CODE at_status(char *sts_var);
 extern AT_ERROR_CODE at_setsts(char *key, at_value_t *value);
 extern AT_ERROR_CODE at_peer(s32 pn, at_peer_t *peer, char *var);
 
+extern AT_ERROR_CODE at_trans(const char *escape);
+extern void at_trans_set_mode(int mode);
+extern int at_trans_get_mode(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -30,9 +30,11 @@
 #include "atcmd/at_command.h"
 #include "at_private.h"
 #include "at_debug.h"
+#include "kernel/os/os.h"
 
 static at_queue_callback_t at_queue_callback = NULL;
 static at_queue_t at_queue;
+static OS_Time_t at_queue_empty;	/* tick of the last empty refill */
 
 s32 at_queue_init(void *buf, s32 size, at_queue_callback_t cb)
 {
@@ -52,37 +54,63 @@ s32 at_queue_init(void *buf, s32 size, at_queue_callback_t cb)
 	return 0;
 }
 
+/*
+ * The source usually waits a little for data before reporting none. When
+ * it returns empty handed twice within one tick it did not, so sleep
+ * instead of letting the readers polling the queue spin on it.
+ */
+static void at_queue_idle(void)
+{
+	OS_Time_t now = OS_GetTicks();
+
+	if (now == at_queue_empty) {
+		OS_MSleep(AT_QUEUE_POLL_MS);
+		now = OS_GetTicks();
+	}
+	at_queue_empty = now;
+}
+
+/*
+ * Refill an empty queue. The indexes are rewound first so the source can
+ * write the whole buffer in one call and readers get a single contiguous span.
+ */
+static s32 at_queue_fill(at_queue_t *q)
+{
+	s32 dcnt;
+
+	if (q->qcnt > 0) {
+		return q->qcnt;
+	}
+
+	if (at_queue_callback == NULL) {
+		return 0;
+	}
+
+	q->ridx = 0;
+	q->widx = 0;
+
+	dcnt = at_queue_callback(q->qbuf, q->qsize);
+	if (dcnt <= 0) {
+		at_queue_idle();
+		return 0;
+	}
+	if (dcnt > q->qsize) {
+		AT_DBG("queue is overflow\n");
+		dcnt = q->qsize;
+	}
+
+	q->widx = dcnt >= q->qsize ? 0 : dcnt;
+	q->qcnt = dcnt;
+
+	return dcnt;
+}
+
 AT_QUEUE_ERROR_CODE at_queue_get(u8 *element)
 {
 	at_queue_t *q = &at_queue;
-	u8 winbuf[32];
-	s32 dcnt;
 
-	if (q->qcnt <= 0) {
-		if (at_queue_callback != NULL) {
-			dcnt = at_queue_callback(winbuf, sizeof(winbuf));
-
-			if (dcnt > 0) {
-				if (dcnt > q->qsize - q->qcnt) {
-					AT_DBG("queue is overflow\n");
-				}
-				else {
-					s32 i;
-
-					for (i=0; i < dcnt; i++) {
-						q->qbuf[q->widx++] = winbuf[i];
-						q->widx = q->widx >= q->qsize ? 0 : q->widx;
-						q->qcnt++;
-					}
-				}
-			}
-			else {
-				return AQEC_EMPTY;
-			}
-		}
-		else {
-			return AQEC_EMPTY;
-		}
+	if (at_queue_fill(q) <= 0) {
+		return AQEC_EMPTY;
 	}
 
 	*element = q->qbuf[q->ridx++];
@@ -95,37 +123,67 @@ AT_QUEUE_ERROR_CODE at_queue_get(u8 *element)
 AT_QUEUE_ERROR_CODE at_queue_peek(u8 *element)
 {
 	at_queue_t *q = &at_queue;
-	u8 winbuf[32];
-	s32 dcnt;
 
-	if (q->qcnt <= 0) {
-		if (at_queue_callback != NULL) {
-			dcnt = at_queue_callback(winbuf, sizeof(winbuf));
-
-			if (dcnt > 0) {
-				if (dcnt > q->qsize - q->qcnt) {
-					AT_DBG("queue is overflow\n");
-				}
-				else {
-					s32 i;
-
-					for (i=0; i < dcnt; i++) {
-						q->qbuf[q->widx++] = winbuf[i];
-						q->widx = q->widx >= q->qsize ? 0 : q->widx;
-						q->qcnt++;
-					}
-				}
-			}
-			else {
-				return AQEC_EMPTY;
-			}
-		}
-		else {
-			return AQEC_EMPTY;
-		}
+	if (at_queue_fill(q) <= 0) {
+		return AQEC_EMPTY;
 	}
 
 	*element = q->qbuf[q->ridx];
 
 	return AQEC_OK;
 }
+
+s32 at_queue_get_span(u8 **span)
+{
+	at_queue_t *q = &at_queue;
+	s32 len;
+
+	if (at_queue_fill(q) <= 0) {
+		return 0;
+	}
+
+	len = q->qsize - q->ridx;
+	if (len > q->qcnt) {
+		len = q->qcnt;
+	}
+	*span = &q->qbuf[q->ridx];
+
+	return len;
+}
+
+void at_queue_consume(s32 len)
+{
+	at_queue_t *q = &at_queue;
+
+	if (len > q->qcnt) {
+		len = q->qcnt;
+	}
+
+	q->ridx += len;
+	if (q->ridx >= q->qsize) {
+		q->ridx -= q->qsize;
+	}
+	q->qcnt -= len;
+}
+
+s32 at_queue_read(u8 *buf, s32 size)
+{
+	u8 *span;
+	s32 len;
+	s32 cnt = 0;
+
+	while (cnt < size) {
+		len = at_queue_get_span(&span);
+		if (len <= 0) {
+			break;
+		}
+		if (len > size - cnt) {
+			len = size - cnt;
+		}
+		memcpy(buf + cnt, span, len);
+		at_queue_consume(len);
+		cnt += len;
+	}
+
+	return cnt;
+}
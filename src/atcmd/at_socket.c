@@ -30,6 +30,7 @@
 #include "atcmd/at_command.h"
 #include "at_private.h"
 #include "at_debug.h"
+#include "kernel/os/os.h"
 
 u8 at_socket_buf[AT_SOCKET_BUFFER_SIZE];
 
@@ -79,8 +80,10 @@ AT_ERROR_CODE at_sockw(char *id, s32 len)
 {
 	at_callback_para_t para;
 	char *cptr;
+	OS_Time_t last;
 	s32 rlen;
-	s32 i;
+	s32 cnt;
+	s32 n;
 
 	memset(&para, 0, sizeof(para));
 
@@ -92,9 +95,16 @@ AT_ERROR_CODE at_sockw(char *id, s32 len)
 
 		para.u.sockw.len = rlen;
 
-		for (i = 0; i < rlen; i++) {
-			while (at_queue_get(&at_socket_buf[i]) != AQEC_OK) {
-				;
+		cnt = 0;
+		last = OS_GetTicks();
+		while (cnt < rlen) {
+			n = at_queue_read(&at_socket_buf[cnt], rlen - cnt);
+			if (n > 0) {
+				cnt += n;
+				last = OS_GetTicks();
+			} else if (OS_TicksToMSecs(OS_GetTicks() - last) >= AT_SOCKW_TIMEOUT_MS) {
+				AT_DBG("sockw: %d of %d bytes\n", cnt, rlen);
+				return AEC_SEND_TIMEOUT;
 			}
 		}
 
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "atcmd/at_command.h"
+#include "at_private.h"
+#include "at_debug.h"
+#include "kernel/os/os.h"
+
+extern u8 at_socket_buf[AT_SOCKET_BUFFER_SIZE];
+
+static int at_trans_mode;	/* AT+CIPMODE, 1: AT+CIPSEND enters data mode */
+
+void at_trans_set_mode(int mode)
+{
+	at_trans_mode = mode;
+}
+
+int at_trans_get_mode(void)
+{
+	return at_trans_mode;
+}
+
+/* Hand one packet to the application, len 0 only lets it poll the peer */
+static AT_ERROR_CODE at_trans_send(at_callback_para_t *para, u8 *buf, s32 len)
+{
+	para->u.mode.buf = buf;
+	para->u.mode.len = len;
+
+	return at_callback.handle_cb(ACC_MODE, para, NULL);
+}
+
+/* Queue @len bytes behind the @plen bytes already waiting in at_socket_buf */
+static AT_ERROR_CODE at_trans_append(at_callback_para_t *para, s32 *plen,
+                                     const u8 *data, s32 len)
+{
+	AT_ERROR_CODE aec;
+	s32 n;
+
+	while (len > 0) {
+		n = AT_TRANS_PACKET_SIZE - *plen;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(&at_socket_buf[*plen], data, n);
+		*plen += n;
+		data += n;
+		len -= n;
+
+		if (*plen == AT_TRANS_PACKET_SIZE) {
+			aec = at_trans_send(para, at_socket_buf, *plen);
+			*plen = 0;
+			if (aec != AEC_OK) {
+				return aec;
+			}
+		}
+	}
+
+	return AEC_OK;
+}
+
+/**
+  * @brief  Forward everything received on the AT port to the application.
+  * @param	escape: sequence that leaves data mode, it is only recognised
+  *                 when it arrives alone, with the line idle for at least
+  *                 AT_TRANS_IDLE_MS before and after it.
+  * @retval AEC_OK when left by the escape sequence, otherwise the error
+  *         returned by the ACC_MODE callback.
+  *
+  * Data is sent in packets of AT_TRANS_PACKET_SIZE bytes, or as soon as the
+  * line has been idle for AT_TRANS_IDLE_MS, then the callback is called
+  * with len 0 every AT_TRANS_IDLE_MS while it stays idle. Full packets are passed to the
+  * callback straight from the queue buffer without being copied.
+  */
+AT_ERROR_CODE at_trans(const char *escape)
+{
+	AT_ERROR_CODE aec = AEC_OK;
+	at_callback_para_t para;
+	s32 esc_len = strlen(escape);
+	s32 esc = 0;		/* escape bytes received so far, held back */
+	s32 plen = 0;		/* bytes waiting in at_socket_buf */
+	int quiet = 1;		/* the line was idle before the current byte */
+	OS_Time_t last;
+	OS_Time_t now;
+	u8 *span;
+	s32 len;
+	s32 i;
+
+	if (at_callback.handle_cb == NULL) {
+		return AEC_UNDEFINED;
+	}
+
+	memset(&para, 0, sizeof(para));
+	para.cfg = &at_cfg;
+	last = OS_GetTicks();
+
+	while (aec == AEC_OK) {
+		len = at_queue_get_span(&span);
+		now = OS_GetTicks();
+
+		if (len <= 0) {
+			if (OS_TicksToMSecs(now - last) < AT_TRANS_IDLE_MS) {
+				continue;
+			}
+			if (esc_len > 0 && esc == esc_len) {
+				break;
+			}
+			if (esc > 0) {
+				/* a partial escape sequence was data after all */
+				aec = at_trans_append(&para, &plen, (const u8 *)escape, esc);
+				esc = 0;
+			}
+			if (aec == AEC_OK) {
+				aec = at_trans_send(&para, at_socket_buf, plen);
+				plen = 0;
+			}
+			quiet = 1;
+			last = now;	/* poll the peer once per idle period */
+			continue;
+		}
+		last = now;
+
+		i = 0;
+		if (quiet) {
+			while (i < len && esc < esc_len && span[i] == (u8)escape[esc]) {
+				esc++;
+				i++;
+			}
+			if (i == len) {
+				at_queue_consume(len);
+				continue;
+			}
+			quiet = 0;
+			if (esc > 0) {
+				aec = at_trans_append(&para, &plen, (const u8 *)escape, esc);
+				esc = 0;
+			}
+		}
+
+		while (aec == AEC_OK && i < len) {
+			if (plen == 0 && len - i >= AT_TRANS_PACKET_SIZE) {
+				aec = at_trans_send(&para, &span[i], AT_TRANS_PACKET_SIZE);
+				i += AT_TRANS_PACKET_SIZE;
+			} else {
+				aec = at_trans_append(&para, &plen, &span[i], len - i);
+				i = len;
+			}
+		}
+		at_queue_consume(len);
+	}
+
+	return aec;
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "audio/eq/eq.h"
+#include "eq_biquad.h"
+
+#if (__CONFIG_AUDIO_HEAP_MODE == 1)
+#include "sys/sys_heap.h"
+#define eq_malloc(size)		psram_malloc(size)
+#define eq_free(p)		psram_free(p)
+#else
+#include <stdlib.h>
+#define eq_malloc(size)		malloc(size)
+#define eq_free(p)		free(p)
+#endif
+
+#define EQ_DBG_ON		0
+#define EQ_ERR_ON		1
+
+#if EQ_DBG_ON
+#define EQ_DBG(fmt, arg...)	printf("[EQ] "fmt, ##arg)
+#else
+#define EQ_DBG(fmt, arg...)
+#endif
+#if EQ_ERR_ON
+#define EQ_ERR(fmt, arg...)	printf("[EQ ERR] %s():%d, "fmt, __func__, __LINE__, ##arg)
+#else
+#define EQ_ERR(fmt, arg...)
+#endif
+
+#define EQ_MAX_CHAN		2
+#define EQ_MAX_BIQ		16
+
+/*
+ * Sections centred below fs/EQ_Q31_DIV or sharper than EQ_Q31_Q have their
+ * poles close to the unit circle, where 16-bit feedback history is too
+ * coarse (noise gain, limit cycles), run them in Q31.
+ */
+#define EQ_Q31_DIV		16
+#define EQ_Q31_Q		2.0f
+
+#ifndef M_PI
+#define M_PI			3.14159265358979323846
+#endif
+
+typedef struct {
+	int chan;
+	int biq_num;		/* active stages, bypassed ones are dropped */
+	eq_biq_t biq[0];
+} eq_t;
+
+/*
+ * RBJ audio EQ cookbook designs, evaluated in double once per eq_create().
+ * Return 0 if the section is a pass-through.
+ */
+static int eq_design(const eq_core_prms_t *p, int fs, double b[3], double a[3])
+{
+	double A, w0, cw, alpha, sa;
+	double Q = (p->Q > 0.0f) ? p->Q : 0.707;
+	int fc = p->fc;
+
+	if (fc <= 0)
+		fc = 1;
+	if (fc >= fs / 2)
+		fc = fs / 2 - 1;
+
+	A = pow(10.0, p->G / 40.0);
+	w0 = 2.0 * M_PI * fc / fs;
+	cw = cos(w0);
+	alpha = sin(w0) / (2.0 * Q);
+	sa = 2.0 * sqrt(A) * alpha;
+
+	switch (p->type) {
+	case LOWPASS_SHELVING:
+		if (p->G == 0.0f)
+			return 0;
+		b[0] = A * ((A + 1) - (A - 1) * cw + sa);
+		b[1] = 2 * A * ((A - 1) - (A + 1) * cw);
+		b[2] = A * ((A + 1) - (A - 1) * cw - sa);
+		a[0] = (A + 1) + (A - 1) * cw + sa;
+		a[1] = -2 * ((A - 1) + (A + 1) * cw);
+		a[2] = (A + 1) + (A - 1) * cw - sa;
+		break;
+	case BANDPASS_PEAK:
+		if (p->G == 0.0f)
+			return 0;
+		b[0] = 1 + alpha * A;
+		b[1] = -2 * cw;
+		b[2] = 1 - alpha * A;
+		a[0] = 1 + alpha / A;
+		a[1] = -2 * cw;
+		a[2] = 1 - alpha / A;
+		break;
+	case HIHPASS_SHELVING:
+		if (p->G == 0.0f)
+			return 0;
+		b[0] = A * ((A + 1) + (A - 1) * cw + sa);
+		b[1] = -2 * A * ((A - 1) + (A + 1) * cw);
+		b[2] = A * ((A + 1) + (A - 1) * cw - sa);
+		a[0] = (A + 1) - (A - 1) * cw + sa;
+		a[1] = 2 * ((A - 1) - (A + 1) * cw);
+		a[2] = (A + 1) - (A - 1) * cw - sa;
+		break;
+	case LOWPASS:
+		b[0] = (1 - cw) / 2;
+		b[1] = 1 - cw;
+		b[2] = (1 - cw) / 2;
+		a[0] = 1 + alpha;
+		a[1] = -2 * cw;
+		a[2] = 1 - alpha;
+		break;
+	case HIGHPASS:
+		b[0] = (1 + cw) / 2;
+		b[1] = -(1 + cw);
+		b[2] = (1 + cw) / 2;
+		a[0] = 1 + alpha;
+		a[1] = -2 * cw;
+		a[2] = 1 - alpha;
+		break;
+	default:
+		EQ_ERR("invalid filter type %d\n", p->type);
+		return -1;
+	}
+
+	/* G is the pass band gain of the low and high pass filters */
+	if ((p->type == LOWPASS || p->type == HIGHPASS) && p->G != 0.0f) {
+		A = pow(10.0, p->G / 20.0);
+		b[0] *= A;
+		b[1] *= A;
+		b[2] *= A;
+	}
+
+	return 1;
+}
+
+void* eq_create(eq_prms_t* prms)
+{
+	eq_t *eq;
+	eq_biq_t *biq;
+	double b[3], a[3];
+	int i, n, ret, size;
+	uint8_t *state;
+
+	if (prms == NULL || prms->core_prms == NULL ||
+	    prms->biq_num <= 0 || prms->biq_num > EQ_MAX_BIQ ||
+	    prms->chan <= 0 || prms->chan > EQ_MAX_CHAN ||
+	    prms->sampling_rate <= 0) {
+		EQ_ERR("invalid parameters\n");
+		return NULL;
+	}
+
+	/* stage table followed by the history of every stage */
+	size = sizeof(eq_t) + prms->biq_num * sizeof(eq_biq_t) +
+	       prms->biq_num * prms->chan * sizeof(eq_biq_q31_state_t);
+	eq = eq_malloc(size);
+	if (eq == NULL) {
+		EQ_ERR("no memory, size %d\n", size);
+		return NULL;
+	}
+	memset(eq, 0, size);
+	eq->chan = prms->chan;
+
+	state = (uint8_t *)&eq->biq[prms->biq_num];
+	for (i = 0, n = 0; i < prms->biq_num; i++) {
+		const eq_core_prms_t *p = &prms->core_prms[i];
+
+		ret = eq_design(p, prms->sampling_rate, b, a);
+		if (ret < 0) {
+			eq_free(eq);
+			return NULL;
+		} else if (ret == 0) {
+			EQ_DBG("stage %d bypassed\n", i);
+			continue;
+		}
+
+		biq = &eq->biq[n++];
+		if (p->fc < prms->sampling_rate / EQ_Q31_DIV || p->Q > EQ_Q31_Q)
+			eq_biq_set_coef(biq, EQ_BIQ_Q31, b, a);
+		else
+			eq_biq_set_coef(biq, EQ_BIQ_Q15, b, a);
+		biq->state = state;
+		state += eq_biq_state_size(biq->kind) * prms->chan;
+		EQ_DBG("stage %d: type %d, fc %d, %s, shift %d\n", i, p->type,
+		       p->fc, biq->kind == EQ_BIQ_Q31 ? "q31" : "q15", biq->shift);
+	}
+	eq->biq_num = n;
+
+	return eq;
+}
+
+void eq_process(void* handle, short* x, int len)
+{
+	eq_t *eq = (eq_t *)handle;
+	int i;
+
+	if (eq == NULL || x == NULL || len <= 0)
+		return;
+
+	for (i = 0; i < eq->biq_num; i++)
+		eq_biq_process(&eq->biq[i], x, len, eq->chan);
+}
+
+void eq_destroy(void* handle)
+{
+	if (handle)
+		eq_free(handle);
+}
@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <math.h>
+#include "eq_biquad.h"
+
+/*
+ * The MAC and saturation helpers map to single Cortex-M4 DSP instructions,
+ * the plain C versions are bit exact and used on the host.
+ */
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+
+static __inline int64_t eq_smlald(uint32_t x, uint32_t y, int64_t acc)
+{
+	__asm volatile ("smlald %Q0, %R0, %1, %2" : "+r" (acc) : "r" (x), "r" (y));
+	return acc;
+}
+
+static __inline int32_t eq_ssat16(int32_t x)
+{
+	int32_t r;
+	__asm ("ssat %0, #16, %1" : "=r" (r) : "r" (x));
+	return r;
+}
+
+#else /* __ARM_FEATURE_DSP */
+
+static __inline int64_t eq_smlald(uint32_t x, uint32_t y, int64_t acc)
+{
+	acc += (int32_t)(int16_t)x * (int32_t)(int16_t)y;
+	acc += (int32_t)(int16_t)(x >> 16) * (int32_t)(int16_t)(y >> 16);
+	return acc;
+}
+
+static __inline int32_t eq_ssat(int32_t x, int bits)
+{
+	int32_t max = (1 << (bits - 1)) - 1;
+
+	if (x > max)
+		return max;
+	if (x < -max - 1)
+		return -max - 1;
+	return x;
+}
+
+#define eq_ssat16(x)	eq_ssat(x, 16)
+
+#endif /* __ARM_FEATURE_DSP */
+
+/* Saturate the 64-bit Q31 stage output to the 24-bit history range */
+static __inline int32_t eq_sat24(int64_t x)
+{
+	if (x > 0x7FFFFF)
+		return 0x7FFFFF;
+	if (x < -0x800000)
+		return -0x800000;
+	return (int32_t)x;
+}
+
+/* Pack two samples for the dual MAC, lo in bits [15:0] */
+static __inline uint32_t eq_pack(int16_t lo, int16_t hi)
+{
+	return (uint16_t)lo | ((uint32_t)(uint16_t)hi << 16);
+}
+
+static int32_t eq_coef_fix(double c, int frac, int shift)
+{
+	double v = c * (double)(1LL << frac) / (double)(1 << shift);
+
+	return (int32_t)(v < 0 ? v - 0.5 : v + 0.5);
+}
+
+void eq_biq_set_coef(eq_biq_t *biq, eq_biq_kind_t kind, const double b[3], const double a[3])
+{
+	double c[5], max = 0;
+	int frac, shift, i;
+	double lim;
+
+	c[0] = b[0] / a[0];
+	c[1] = b[1] / a[0];
+	c[2] = b[2] / a[0];
+	c[3] = -a[1] / a[0];
+	c[4] = -a[2] / a[0];
+
+	for (i = 0; i < 5; i++) {
+		if (fabs(c[i]) > max)
+			max = fabs(c[i]);
+	}
+
+	/* smallest shift that keeps the largest coefficient in range */
+	frac = (kind == EQ_BIQ_Q15) ? 14 : 30;
+	lim = (kind == EQ_BIQ_Q15) ? 32767.0 : 2147483647.0;
+	for (shift = 0; shift < 8; shift++) {
+		if (max * (double)(1LL << frac) / (double)(1 << shift) < lim)
+			break;
+	}
+
+	biq->kind = kind;
+	biq->shift = shift;
+	if (kind == EQ_BIQ_Q15) {
+		biq->c.q15.b01 = eq_pack(eq_coef_fix(c[0], frac, shift),
+		                         eq_coef_fix(c[1], frac, shift));
+		biq->c.q15.b2a1 = eq_pack(eq_coef_fix(c[2], frac, shift),
+		                          eq_coef_fix(c[3], frac, shift));
+		biq->c.q15.a2 = eq_coef_fix(c[4], frac, shift);
+	} else {
+		biq->c.q31.b0 = eq_coef_fix(c[0], frac, shift);
+		biq->c.q31.b1 = eq_coef_fix(c[1], frac, shift);
+		biq->c.q31.b2 = eq_coef_fix(c[2], frac, shift);
+		biq->c.q31.a1 = eq_coef_fix(c[3], frac, shift);
+		biq->c.q31.a2 = eq_coef_fix(c[4], frac, shift);
+	}
+}
+
+int eq_biq_state_size(eq_biq_kind_t kind)
+{
+	return (kind == EQ_BIQ_Q15) ? sizeof(eq_biq_q15_state_t) :
+	                              sizeof(eq_biq_q31_state_t);
+}
+
+/*
+ * Q15 stage: 16x16 products summed in 64 bits by two SMLALD and one SMLAL,
+ * the output is rounded, saturated and fed back as 16-bit history.
+ * Good enough when the poles are well away from DC.
+ */
+static void eq_biq_q15(const eq_biq_t *biq, eq_biq_q15_state_t *st,
+                       int16_t *x, int frames, int chan)
+{
+	const uint32_t b01 = biq->c.q15.b01;
+	const uint32_t b2a1 = biq->c.q15.b2a1;
+	const int32_t a2 = biq->c.q15.a2;
+	const int out_shift = 14 - biq->shift;
+	const int64_t round = 1 << (out_shift - 1);
+	int16_t x1 = st->x1, x2 = st->x2;
+	int16_t y1 = st->y1, y2 = st->y2;
+	int16_t x0, y0;
+	int64_t acc;
+
+	while (frames--) {
+		x0 = *x;
+		acc = eq_smlald(eq_pack(x0, x1), b01, round);
+		acc = eq_smlald(eq_pack(x2, y1), b2a1, acc);
+		acc += (int32_t)a2 * y2;
+		y0 = eq_ssat16((int32_t)(acc >> out_shift));
+		*x = y0;
+		x += chan;
+
+		x2 = x1;
+		x1 = x0;
+		y2 = y1;
+		y1 = y0;
+	}
+
+	st->x1 = x1;
+	st->x2 = x2;
+	st->y1 = y1;
+	st->y2 = y2;
+}
+
+/*
+ * Q31 stage: 32x16/32x32 products summed in 64 bits (SMLAL), the output
+ * history keeps EQ_Q31_FRAC bits below the 16-bit LSB and the truncation
+ * error is fed back into the next sample (first order noise shaping), so
+ * that the noise of low-frequency, high-Q sections is not amplified by
+ * the poles. Worst case sum is 5 * 2^54, no accumulator overflow.
+ */
+static void eq_biq_q31(const eq_biq_t *biq, eq_biq_q31_state_t *st,
+                       int16_t *x, int frames, int chan)
+{
+	const int32_t b0 = biq->c.q31.b0;
+	const int32_t b1 = biq->c.q31.b1;
+	const int32_t b2 = biq->c.q31.b2;
+	const int32_t a1 = biq->c.q31.a1;
+	const int32_t a2 = biq->c.q31.a2;
+	const int out_shift = 30 - biq->shift;
+	const uint32_t mask = ((uint32_t)1 << out_shift) - 1;
+	int16_t x1 = st->x1, x2 = st->x2;
+	int32_t y1 = st->y1, y2 = st->y2;
+	uint32_t err = st->err;
+	int16_t x0;
+	int32_t y0;
+	int64_t acc;
+
+	while (frames--) {
+		x0 = *x;
+		acc = (int64_t)b0 * x0;
+		acc += (int64_t)b1 * x1;
+		acc += (int64_t)b2 * x2;
+		acc = acc * (1 << EQ_Q31_FRAC) + err;
+		acc += (int64_t)a1 * y1;
+		acc += (int64_t)a2 * y2;
+		err = (uint32_t)acc & mask;
+		y0 = eq_sat24(acc >> out_shift);
+		*x = eq_ssat16((y0 + (1 << (EQ_Q31_FRAC - 1))) >> EQ_Q31_FRAC);
+		x += chan;
+
+		x2 = x1;
+		x1 = x0;
+		y2 = y1;
+		y1 = y0;
+	}
+
+	st->x1 = x1;
+	st->x2 = x2;
+	st->y1 = y1;
+	st->y2 = y2;
+	st->err = err;
+}
+
+void eq_biq_process(eq_biq_t *biq, int16_t *x, int frames, int chan)
+{
+	int ch;
+
+	for (ch = 0; ch < chan; ch++) {
+		if (biq->kind == EQ_BIQ_Q15)
+			eq_biq_q15(biq, (eq_biq_q15_state_t *)biq->state + ch,
+			           x + ch, frames, chan);
+		else
+			eq_biq_q31(biq, (eq_biq_q31_state_t *)biq->state + ch,
+			           x + ch, frames, chan);
+	}
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EQ_BIQUAD_H_
+#define _EQ_BIQUAD_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed-point biquad stage, Direct Form I:
+ *   y[n] = b0*x[n] + b1*x[n-1] + b2*x[n-2] + a1*y[n-1] + a2*y[n-2]
+ * a1/a2 are stored negated so that every term is accumulated.
+ *
+ * Coefficients are scaled down by 2^shift when their magnitude does not fit
+ * the coefficient format, the accumulator is scaled back up at the output.
+ */
+/* Extra fraction bits kept in the output history of a Q31 stage */
+#define EQ_Q31_FRAC	8
+
+typedef enum {
+	EQ_BIQ_Q15,	/* Q2.14 coefficients, 16-bit states */
+	EQ_BIQ_Q31,	/* Q2.30 coefficients, 32-bit output states */
+} eq_biq_kind_t;
+
+/* Per-channel history of a Q15 stage, packed for the dual MAC */
+typedef struct {
+	int16_t x1, x2;
+	int16_t y1, y2;
+} eq_biq_q15_state_t;
+
+/* Per-channel history of a Q31 stage, y1/y2 carry EQ_Q31_FRAC extra bits */
+typedef struct {
+	int16_t x1, x2;
+	int32_t y1, y2;
+	uint32_t err;	/* truncation error of the last output */
+} eq_biq_q31_state_t;
+
+typedef struct {
+	uint8_t kind;		/* eq_biq_kind_t */
+	uint8_t shift;
+	union {
+		struct {
+			int32_t b01;	/* b1 << 16 | b0 */
+			int32_t b2a1;	/* a1 << 16 | b2 */
+			int16_t a2;
+		} q15;
+		struct {
+			int32_t b0, b1, b2, a1, a2;
+		} q31;
+	} c;
+	void *state;		/* eq_biq_q15_state_t or eq_biq_q31_state_t [chan] */
+} eq_biq_t;
+
+/* Coefficient format selection and conversion, b/a normalized by a0 */
+void eq_biq_set_coef(eq_biq_t *biq, eq_biq_kind_t kind, const double b[3], const double a[3]);
+int eq_biq_state_size(eq_biq_kind_t kind);
+
+/*
+ * Filter @frames interleaved frames of @chan channels in place through
+ * one stage. Stages are run one after the other over the whole block,
+ * which keeps the coefficients and one channel's history in registers.
+ */
+void eq_biq_process(eq_biq_t *biq, int16_t *x, int frames, int chan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EQ_BIQUAD_H_ */
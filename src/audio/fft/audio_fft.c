@@ -0,0 +1,619 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "audio/fft/audio_fft.h"
+
+#define FFT_ERR_ON		1
+
+#if FFT_ERR_ON
+#define FFT_ERR(fmt, arg...)	printf("[FFT ERR] %s():%d, "fmt, __func__, __LINE__, ##arg)
+#else
+#define FFT_ERR(fmt, arg...)
+#endif
+
+#ifndef M_PI
+#define M_PI			3.14159265358979323846
+#endif
+
+struct audio_fft {
+	uint16_t points;	/* as created, real samples for a real plan */
+	uint16_t n;		/* complex transform size */
+	uint8_t  flags;
+	uint16_t nswap;		/* bit-reverse swap pairs */
+	uint16_t *swap;		/* [nswap][2] */
+	uint32_t *tw15;		/* W_n^k, k < 3n/4, (im << 16) | re in Q15 */
+	int32_t  *tw31;		/* W_n^k, k < 3n/4, re, im in Q31 */
+	uint32_t *rtw15;	/* W_2n^k, k <= n/2, real plans only */
+	int32_t  *rtw31;
+};
+
+/*
+ * Q15 complex values are handled as one word, re in the low half. With the
+ * DSP extension a butterfly is a few halving adds and two dual multiplies.
+ */
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+
+#define FFT_DSP_OP(name, insn)						\
+static __inline uint32_t name(uint32_t a, uint32_t b)			\
+{									\
+	uint32_t r;							\
+	__asm (insn " %0, %1, %2" : "=r" (r) : "r" (a), "r" (b));	\
+	return r;							\
+}
+
+FFT_DSP_OP(fft_shadd16, "shadd16")	/* (a + b) / 2, per half */
+FFT_DSP_OP(fft_shsub16, "shsub16")	/* (a - b) / 2, per half */
+FFT_DSP_OP(fft_shsax, "shsax")		/* (a - i * b) / 2 */
+FFT_DSP_OP(fft_shasx, "shasx")		/* (a + i * b) / 2 */
+
+static __inline int32_t fft_smusd(uint32_t a, uint32_t b)
+{
+	int32_t r;
+	__asm ("smusd %0, %1, %2" : "=r" (r) : "r" (a), "r" (b));
+	return r;
+}
+
+static __inline int32_t fft_smuadx(uint32_t a, uint32_t b)
+{
+	int32_t r;
+	__asm ("smuadx %0, %1, %2" : "=r" (r) : "r" (a), "r" (b));
+	return r;
+}
+
+static __inline int32_t fft_ssat16(int32_t x)
+{
+	int32_t r;
+	__asm ("ssat %0, #16, %1" : "=r" (r) : "r" (x));
+	return r;
+}
+
+#else /* __ARM_FEATURE_DSP */
+
+#define FFT_LO(x)		((int32_t)(int16_t)(x))
+#define FFT_HI(x)		((int32_t)(int16_t)((x) >> 16))
+#define FFT_PACK(lo, hi)	(((uint32_t)(uint16_t)(lo)) | ((uint32_t)(hi) << 16))
+
+static __inline uint32_t fft_shadd16(uint32_t a, uint32_t b)
+{
+	return FFT_PACK((FFT_LO(a) + FFT_LO(b)) >> 1, (FFT_HI(a) + FFT_HI(b)) >> 1);
+}
+
+static __inline uint32_t fft_shsub16(uint32_t a, uint32_t b)
+{
+	return FFT_PACK((FFT_LO(a) - FFT_LO(b)) >> 1, (FFT_HI(a) - FFT_HI(b)) >> 1);
+}
+
+static __inline uint32_t fft_shsax(uint32_t a, uint32_t b)
+{
+	return FFT_PACK((FFT_LO(a) + FFT_HI(b)) >> 1, (FFT_HI(a) - FFT_LO(b)) >> 1);
+}
+
+static __inline uint32_t fft_shasx(uint32_t a, uint32_t b)
+{
+	return FFT_PACK((FFT_LO(a) - FFT_HI(b)) >> 1, (FFT_HI(a) + FFT_LO(b)) >> 1);
+}
+
+static __inline int32_t fft_smusd(uint32_t a, uint32_t b)
+{
+	return FFT_LO(a) * FFT_LO(b) - FFT_HI(a) * FFT_HI(b);
+}
+
+static __inline int32_t fft_smuadx(uint32_t a, uint32_t b)
+{
+	return FFT_LO(a) * FFT_HI(b) + FFT_HI(a) * FFT_LO(b);
+}
+
+static __inline int32_t fft_ssat16(int32_t x)
+{
+	if (x > 32767)
+		return 32767;
+	if (x < -32768)
+		return -32768;
+	return x;
+}
+
+#endif /* __ARM_FEATURE_DSP */
+
+/* x * w, rounded and saturated */
+static __inline uint32_t fft_cmul15(uint32_t x, uint32_t w)
+{
+	int32_t re = fft_ssat16((fft_smusd(x, w) + 0x4000) >> 15);
+	int32_t im = fft_ssat16((fft_smuadx(x, w) + 0x4000) >> 15);
+
+	return ((uint32_t)(uint16_t)re) | ((uint32_t)im << 16);
+}
+
+static __inline int32_t fft_ssat32(int64_t x)
+{
+	if (x > INT32_MAX)
+		return INT32_MAX;
+	if (x < INT32_MIN)
+		return INT32_MIN;
+	return (int32_t)x;
+}
+
+static __inline int32_t fft_mul31(int32_t a, int32_t b)
+{
+	return (int32_t)(((int64_t)a * b + 0x40000000) >> 31);
+}
+
+static void fft_bitrev(const audio_fft_t *fft, void *data, uint32_t size)
+{
+	const uint16_t *sw = fft->swap;
+	uint32_t i;
+
+	if (size == sizeof(uint32_t)) {
+		uint32_t *x = data, t;
+		for (i = 0; i < fft->nswap; ++i, sw += 2) {
+			t = x[sw[0]];
+			x[sw[0]] = x[sw[1]];
+			x[sw[1]] = t;
+		}
+	} else {
+		uint64_t *x = data, t;
+		for (i = 0; i < fft->nswap; ++i, sw += 2) {
+			t = x[sw[0]];
+			x[sw[0]] = x[sw[1]];
+			x[sw[1]] = t;
+		}
+	}
+}
+
+/*
+ * Radix-4 DIF butterfly over x0..x3 at distance q, two radix-2 stages in
+ * one pass so that the output stays in bit-reversed order:
+ *   y0 = x0 + x1 + x2 + x3
+ *   y1 = (x0 - x1 + x2 - x3) * W^2j
+ *   y2 = (x0 - i*x1 - x2 + i*x3) * W^j
+ *   y3 = (x0 + i*x1 - x2 - i*x3) * W^3j
+ * all divided by 4.
+ */
+static void fft_cfft_q15(const audio_fft_t *fft, uint32_t *x)
+{
+	const uint32_t *tw = fft->tw15;
+	uint32_t n = fft->n;
+	uint32_t L, q, j, g, stride;
+	uint32_t w1, w2, w3;
+	uint32_t x0, x1, x2, x3, s02, d02, s13, d13;
+
+	for (L = n, stride = 1; L >= 4; L >>= 2, stride <<= 2) {
+		q = L >> 2;
+		for (j = 0; j < q; ++j) {
+			w1 = tw[j * stride];
+			w2 = tw[2 * j * stride];
+			w3 = tw[3 * j * stride];
+			for (g = j; g < n; g += L) {
+				x0 = x[g];
+				x1 = x[g + q];
+				x2 = x[g + 2 * q];
+				x3 = x[g + 3 * q];
+				s02 = fft_shadd16(x0, x2);
+				d02 = fft_shsub16(x0, x2);
+				s13 = fft_shadd16(x1, x3);
+				d13 = fft_shsub16(x1, x3);
+				x[g] = fft_shadd16(s02, s13);
+				if (j == 0) {
+					x[g + q] = fft_shsub16(s02, s13);
+					x[g + 2 * q] = fft_shsax(d02, d13);
+					x[g + 3 * q] = fft_shasx(d02, d13);
+				} else {
+					x[g + q] = fft_cmul15(fft_shsub16(s02, s13), w2);
+					x[g + 2 * q] = fft_cmul15(fft_shsax(d02, d13), w1);
+					x[g + 3 * q] = fft_cmul15(fft_shasx(d02, d13), w3);
+				}
+			}
+		}
+	}
+
+	if (L == 2) {
+		for (g = 0; g < n; g += 2) {
+			x0 = x[g];
+			x1 = x[g + 1];
+			x[g] = fft_shadd16(x0, x1);
+			x[g + 1] = fft_shsub16(x0, x1);
+		}
+	}
+
+	fft_bitrev(fft, x, sizeof(uint32_t));
+}
+
+#define H(v)	((v) >> 1)
+
+static void fft_cfft_q31(const audio_fft_t *fft, int32_t *x)
+{
+	const int32_t *tw = fft->tw31;
+	uint32_t n = fft->n;
+	uint32_t L, q, j, g, stride;
+	const int32_t *w1, *w2, *w3;
+	int32_t *p0, *p1, *p2, *p3;
+	int32_t s02r, s02i, d02r, d02i, s13r, s13i, d13r, d13i;
+	int32_t ar, ai;
+
+	for (L = n, stride = 1; L >= 4; L >>= 2, stride <<= 2) {
+		q = L >> 2;
+		for (j = 0; j < q; ++j) {
+			w1 = &tw[2 * (j * stride)];
+			w2 = &tw[2 * (2 * j * stride)];
+			w3 = &tw[2 * (3 * j * stride)];
+			for (g = j; g < n; g += L) {
+				p0 = &x[2 * g];
+				p1 = &x[2 * (g + q)];
+				p2 = &x[2 * (g + 2 * q)];
+				p3 = &x[2 * (g + 3 * q)];
+				s02r = H(p0[0]) + H(p2[0]);
+				s02i = H(p0[1]) + H(p2[1]);
+				d02r = H(p0[0]) - H(p2[0]);
+				d02i = H(p0[1]) - H(p2[1]);
+				s13r = H(p1[0]) + H(p3[0]);
+				s13i = H(p1[1]) + H(p3[1]);
+				d13r = H(p1[0]) - H(p3[0]);
+				d13i = H(p1[1]) - H(p3[1]);
+
+				p0[0] = H(s02r) + H(s13r);
+				p0[1] = H(s02i) + H(s13i);
+
+				ar = H(s02r) - H(s13r);
+				ai = H(s02i) - H(s13i);
+				p1[0] = fft_mul31(ar, w2[0]) - fft_mul31(ai, w2[1]);
+				p1[1] = fft_mul31(ar, w2[1]) + fft_mul31(ai, w2[0]);
+
+				ar = H(d02r) + H(d13i);		/* d02 - i * d13 */
+				ai = H(d02i) - H(d13r);
+				p2[0] = fft_mul31(ar, w1[0]) - fft_mul31(ai, w1[1]);
+				p2[1] = fft_mul31(ar, w1[1]) + fft_mul31(ai, w1[0]);
+
+				ar = H(d02r) - H(d13i);		/* d02 + i * d13 */
+				ai = H(d02i) + H(d13r);
+				p3[0] = fft_mul31(ar, w3[0]) - fft_mul31(ai, w3[1]);
+				p3[1] = fft_mul31(ar, w3[1]) + fft_mul31(ai, w3[0]);
+			}
+		}
+	}
+
+	if (L == 2) {
+		for (g = 0; g < n; g += 2) {
+			p0 = &x[2 * g];
+			p1 = &x[2 * g + 2];
+			ar = H(p0[0]) + H(p1[0]);
+			ai = H(p0[1]) + H(p1[1]);
+			p1[0] = H(p0[0]) - H(p1[0]);
+			p1[1] = H(p0[1]) - H(p1[1]);
+			p0[0] = ar;
+			p0[1] = ai;
+		}
+	}
+
+	fft_bitrev(fft, x, 2 * sizeof(int32_t));
+}
+
+/*
+ * Real input: z[m] = x[2m] + i * x[2m + 1], halved so that |z| <= 1, then
+ * with Z = FFT(z) / n and W = W_2n^k:
+ *   A = (Z[k] + conj(Z[n-k])) / 2
+ *   B = -i * (Z[k] - conj(Z[n-k])) / 2
+ *   X[k] / N = A + W * B,  X[n-k] / N = conj(A - W * B)
+ */
+static void fft_rsplit_q15(const audio_fft_t *fft, int16_t *x)
+{
+	uint32_t n = fft->n, k, m;
+	int32_t ar, ai, br, bi, wr, wi, cr, ci, t;
+
+	t = x[0];
+	x[0] = fft_ssat16(t + x[1]);
+	x[1] = fft_ssat16(t - x[1]);
+
+	for (k = 1; k <= n / 2; ++k) {
+		m = n - k;
+		ar = (x[2 * k] + x[2 * m]) >> 1;
+		ai = (x[2 * k + 1] - x[2 * m + 1]) >> 1;
+		br = (x[2 * k + 1] + x[2 * m + 1]) >> 1;
+		bi = (x[2 * m] - x[2 * k]) >> 1;
+		wr = (int16_t)fft->rtw15[k];
+		wi = (int16_t)(fft->rtw15[k] >> 16);
+		cr = (br * wr - bi * wi + 0x4000) >> 15;
+		ci = (br * wi + bi * wr + 0x4000) >> 15;
+		x[2 * k] = fft_ssat16(ar + cr);
+		x[2 * k + 1] = fft_ssat16(ai + ci);
+		if (m != k) {
+			x[2 * m] = fft_ssat16(ar - cr);
+			x[2 * m + 1] = fft_ssat16(ci - ai);
+		}
+	}
+}
+
+static void fft_rsplit_q31(const audio_fft_t *fft, int32_t *x)
+{
+	uint32_t n = fft->n, k, m;
+	int32_t ar, ai, br, bi, cr, ci, t;
+	const int32_t *w;
+
+	t = x[0];
+	x[0] = fft_ssat32((int64_t)t + x[1]);
+	x[1] = fft_ssat32((int64_t)t - x[1]);
+
+	for (k = 1; k <= n / 2; ++k) {
+		m = n - k;
+		w = &fft->rtw31[2 * k];
+		ar = H(x[2 * k]) + H(x[2 * m]);
+		ai = H(x[2 * k + 1]) - H(x[2 * m + 1]);
+		br = H(x[2 * k + 1]) + H(x[2 * m + 1]);
+		bi = H(x[2 * m]) - H(x[2 * k]);
+		cr = fft_mul31(br, w[0]) - fft_mul31(bi, w[1]);
+		ci = fft_mul31(br, w[1]) + fft_mul31(bi, w[0]);
+		x[2 * k] = fft_ssat32((int64_t)ar + cr);
+		x[2 * k + 1] = fft_ssat32((int64_t)ai + ci);
+		if (m != k) {
+			x[2 * m] = fft_ssat32((int64_t)ar - cr);
+			x[2 * m + 1] = fft_ssat32((int64_t)ci - ai);
+		}
+	}
+}
+
+#undef H
+
+void audio_fft_q15(audio_fft_t *fft, int16_t *data)
+{
+	uint32_t *x = (uint32_t *)data;
+	uint32_t i;
+
+	if (fft->tw15 == NULL) {
+		FFT_ERR("no Q15 tables\n");
+		return;
+	}
+
+	if (fft->flags & AUDIO_FFT_REAL) {
+		for (i = 0; i < fft->n; ++i)
+			x[i] = fft_shadd16(x[i], 0);
+		fft_cfft_q15(fft, x);
+		fft_rsplit_q15(fft, data);
+	} else {
+		fft_cfft_q15(fft, x);
+	}
+}
+
+void audio_fft_q31(audio_fft_t *fft, int32_t *data)
+{
+	uint32_t i;
+
+	if (fft->tw31 == NULL) {
+		FFT_ERR("no Q31 tables\n");
+		return;
+	}
+
+	if (fft->flags & AUDIO_FFT_REAL) {
+		for (i = 0; i < 2 * fft->n; ++i)
+			data[i] >>= 1;
+		fft_cfft_q31(fft, data);
+		fft_rsplit_q31(fft, data);
+	} else {
+		fft_cfft_q31(fft, data);
+	}
+}
+
+uint32_t audio_fft_bins(audio_fft_t *fft)
+{
+	return (fft->flags & AUDIO_FFT_REAL) ? fft->n + 1 : fft->n;
+}
+
+void audio_fft_power_q15(audio_fft_t *fft, const int16_t *spec, uint32_t *power)
+{
+	uint32_t k = 0, n = fft->n;
+
+	if (fft->flags & AUDIO_FFT_REAL) {
+		power[0] = (uint32_t)(spec[0] * spec[0]);
+		power[n] = (uint32_t)(spec[1] * spec[1]);
+		k = 1;
+	}
+	for (; k < n; ++k) {
+		power[k] = (uint32_t)(spec[2 * k] * spec[2 * k]) +
+		           (uint32_t)(spec[2 * k + 1] * spec[2 * k + 1]);
+	}
+}
+
+void audio_fft_power_q31(audio_fft_t *fft, const int32_t *spec, uint64_t *power)
+{
+	uint32_t k = 0, n = fft->n;
+
+	if (fft->flags & AUDIO_FFT_REAL) {
+		power[0] = (uint64_t)((int64_t)spec[0] * spec[0]);
+		power[n] = (uint64_t)((int64_t)spec[1] * spec[1]);
+		k = 1;
+	}
+	for (; k < n; ++k) {
+		power[k] = (uint64_t)((int64_t)spec[2 * k] * spec[2 * k]) +
+		           (uint64_t)((int64_t)spec[2 * k + 1] * spec[2 * k + 1]);
+	}
+}
+
+/* log2(1 + i / 64) in Q16 */
+static const uint32_t fft_log2_tab[65] = {
+	0, 1466, 2909, 4331, 5732, 7112, 8473, 9814,
+	11136, 12440, 13727, 14996, 16248, 17484, 18704, 19909,
+	21098, 22272, 23433, 24579, 25711, 26830, 27936, 29029,
+	30109, 31178, 32234, 33279, 34312, 35334, 36346, 37346,
+	38336, 39316, 40286, 41246, 42196, 43137, 44068, 44990,
+	45904, 46809, 47705, 48593, 49472, 50344, 51207, 52063,
+	52911, 53751, 54584, 55410, 56229, 57040, 57845, 58643,
+	59434, 60219, 60997, 61769, 62534, 63294, 64047, 64794,
+	65536
+};
+
+/* 10 * log10(2) in Q24 */
+#define FFT_DB_PER_LOG2		50504453
+
+int32_t audio_fft_db(uint64_t power, uint32_t frac_bits)
+{
+	uint32_t e, idx, frac;
+	uint64_t m;
+	int32_t lg;
+
+	if (power == 0)
+		return AUDIO_FFT_DB_FLOOR;
+
+	e = 63 - __builtin_clzll(power);
+	m = power << (63 - e);			/* 1.63 */
+	idx = (uint32_t)(m >> 57) & 0x3F;	/* next 6 bits */
+	frac = (uint32_t)(m >> 41) & 0xFFFF;	/* and 16 more */
+	lg = (int32_t)((e - frac_bits) << 16) + fft_log2_tab[idx] +
+	     (int32_t)(((fft_log2_tab[idx + 1] - fft_log2_tab[idx]) * frac) >> 16);
+
+	return (int32_t)(((int64_t)lg * FFT_DB_PER_LOG2 + (1LL << 31)) >> 32);
+}
+
+uint32_t audio_fft_mag(uint64_t power)
+{
+	uint64_t r = 0, bit = 1ULL << 62;
+
+	while (bit > power)
+		bit >>= 2;
+	while (bit) {
+		if (power >= r + bit) {
+			power -= r + bit;
+			r = (r >> 1) + bit;
+		} else {
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)r;
+}
+
+static uint32_t fft_rev(uint32_t i, uint32_t bits)
+{
+	uint32_t r = 0;
+
+	while (bits--) {
+		r = (r << 1) | (i & 1);
+		i >>= 1;
+	}
+	return r;
+}
+
+audio_fft_t *audio_fft_create(uint32_t points, uint32_t flags)
+{
+	audio_fft_t *fft;
+	uint32_t n, bits, i, j, ntw;
+	double a;
+
+	n = (flags & AUDIO_FFT_REAL) ? points / 2 : points;
+	if (n < AUDIO_FFT_MIN_POINTS || n > AUDIO_FFT_MAX_POINTS ||
+	    (n & (n - 1)) || !(flags & (AUDIO_FFT_Q15 | AUDIO_FFT_Q31))) {
+		FFT_ERR("invalid size %u or flags %#x\n", points, flags);
+		return NULL;
+	}
+
+	fft = calloc(1, sizeof(*fft));
+	if (fft == NULL)
+		goto nomem;
+	fft->points = points;
+	fft->n = n;
+	fft->flags = flags;
+
+	for (bits = 0; (1U << bits) < n; ++bits)
+		;
+	fft->swap = malloc(n * sizeof(uint16_t));	/* at most n / 2 pairs */
+	if (fft->swap == NULL)
+		goto nomem;
+	for (i = 0; i < n; ++i) {
+		j = fft_rev(i, bits);
+		if (i < j) {
+			fft->swap[2 * fft->nswap] = i;
+			fft->swap[2 * fft->nswap + 1] = j;
+			fft->nswap++;
+		}
+	}
+
+	ntw = n * 3 / 4;
+	if (flags & AUDIO_FFT_Q15) {
+		fft->tw15 = malloc(ntw * sizeof(uint32_t));
+		if (fft->tw15 == NULL)
+			goto nomem;
+		for (i = 0; i < ntw; ++i) {
+			a = 2 * M_PI * i / n;
+			fft->tw15[i] = (uint16_t)(int16_t)lrint(cos(a) * 32767) |
+			               ((uint32_t)(uint16_t)(int16_t)lrint(-sin(a) * 32767) << 16);
+		}
+	}
+	if (flags & AUDIO_FFT_Q31) {
+		fft->tw31 = malloc(ntw * 2 * sizeof(int32_t));
+		if (fft->tw31 == NULL)
+			goto nomem;
+		for (i = 0; i < ntw; ++i) {
+			a = 2 * M_PI * i / n;
+			fft->tw31[2 * i] = (int32_t)lrint(cos(a) * 2147483647.0);
+			fft->tw31[2 * i + 1] = (int32_t)lrint(-sin(a) * 2147483647.0);
+		}
+	}
+
+	if (flags & AUDIO_FFT_REAL) {
+		if (flags & AUDIO_FFT_Q15) {
+			fft->rtw15 = malloc((n / 2 + 1) * sizeof(uint32_t));
+			if (fft->rtw15 == NULL)
+				goto nomem;
+		}
+		if (flags & AUDIO_FFT_Q31) {
+			fft->rtw31 = malloc((n / 2 + 1) * 2 * sizeof(int32_t));
+			if (fft->rtw31 == NULL)
+				goto nomem;
+		}
+		for (i = 0; i <= n / 2; ++i) {
+			a = M_PI * i / n;
+			if (fft->rtw15)
+				fft->rtw15[i] = (uint16_t)(int16_t)lrint(cos(a) * 32767) |
+				                ((uint32_t)(uint16_t)(int16_t)lrint(-sin(a) * 32767) << 16);
+			if (fft->rtw31) {
+				fft->rtw31[2 * i] = (int32_t)lrint(cos(a) * 2147483647.0);
+				fft->rtw31[2 * i + 1] = (int32_t)lrint(-sin(a) * 2147483647.0);
+			}
+		}
+	}
+
+	return fft;
+
+nomem:
+	FFT_ERR("no mem\n");
+	audio_fft_destroy(fft);
+	return NULL;
+}
+
+void audio_fft_destroy(audio_fft_t *fft)
+{
+	if (fft == NULL)
+		return;
+	free(fft->swap);
+	free(fft->tw15);
+	free(fft->tw31);
+	free(fft->rtw15);
+	free(fft->rtw31);
+	free(fft);
+}
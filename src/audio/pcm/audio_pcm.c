@@ -36,6 +36,7 @@
 #include "driver/chip/hal_i2c.h"
 #include "audio/pcm/audio_pcm.h"
 #include "kernel/os/os_mutex.h"
+#include "pcm_ring.h"
 
 #if (__CONFIG_AUDIO_HEAP_MODE == 1)
 #include "sys/sys_heap.h"
@@ -63,15 +64,20 @@
 
 LIST_HEAD_DEF(audio_pcm_list);
 
+/*
+ * The caches hold less than one half buffer of pcm data between calls.
+ * They are rings so partial reads/writes only move counters, and they are
+ * reset whenever they run empty, so the cached data always starts at the
+ * beginning of the buffer and a full half buffer is one contiguous span
+ * that is handed to the sound card directly.
+ */
 struct play_priv {
-	uint8_t	 *cache;
-	uint32_t length;
+	struct pcm_ring cache;
 	uint32_t half_buf_size;
 };
 
 struct cap_priv {
-	uint8_t	 *cache;
-	uint32_t length;
+	struct pcm_ring cache;
 	uint32_t half_buf_size;
 };
 
@@ -141,10 +147,10 @@ static struct pcm_priv *card_num_to_pcm_priv(Snd_Card_Num card_num)
 int snd_pcm_read(Snd_Card_Num card_num, void *data, uint32_t count)
 {
 	int ret;
-	uint8_t *data_ptr;
+	uint8_t *data_ptr, *span;
 	struct cap_priv *cpriv;
 	struct pcm_priv *audio_pcm_priv;
-	uint32_t half_buf_size, read_remain, hw_read;
+	uint32_t half_buf_size, read_remain, hw_read, len;
 
 	/* Check parms to be valid */
 	if(!data || !count){
@@ -160,7 +166,7 @@ int snd_pcm_read(Snd_Card_Num card_num, void *data, uint32_t count)
 	}
 
 	/* Check cap cache */
-	if(audio_pcm_priv->cap_priv.cache == NULL){
+	if(audio_pcm_priv->cap_priv.cache.buf == NULL){
 		AUDIO_PCM_ERROR("Capture Cache is NULL!\n");
 		return -1;
 	}
@@ -172,20 +178,12 @@ int snd_pcm_read(Snd_Card_Num card_num, void *data, uint32_t count)
 	half_buf_size = audio_pcm_priv->cap_priv.half_buf_size;
 
 	/* Cache has data to read */
-	if(cpriv->length){
-		if(cpriv->length > read_remain){
-			memcpy(data_ptr, cpriv->cache, read_remain);
-			cpriv->length -= read_remain;
-			memcpy(cpriv->cache, cpriv->cache + read_remain, cpriv->length);
+	if(pcm_ring_avail(&cpriv->cache)){
+		len = pcm_ring_read(&cpriv->cache, data_ptr, read_remain);
+		data_ptr += len;
+		read_remain -= len;
+		if(!read_remain){
 			return count;
-		} else {
-			memcpy(data_ptr, cpriv->cache, cpriv->length);
-			data_ptr += cpriv->length;
-			read_remain -= cpriv->length;
-			cpriv->length = 0;
-			if(!read_remain){
-				return count;
-			}
 		}
 	}
 
@@ -204,15 +202,16 @@ int snd_pcm_read(Snd_Card_Num card_num, void *data, uint32_t count)
 		}
 	}
 
-	/* read remain */
-	ret = HAL_SndCard_PcmRead(card_num, cpriv->cache, half_buf_size);
+	/* read remain, cache is empty here */
+	pcm_ring_reset(&cpriv->cache);
+	pcm_ring_write_span(&cpriv->cache, &span);
+	ret = HAL_SndCard_PcmRead(card_num, span, half_buf_size);
 	if(ret != half_buf_size){
 		AUDIO_PCM_ERROR("PCM read half_buf_size error!\n");
 		return count-read_remain;
 	}
-	memcpy(data_ptr, cpriv->cache, read_remain);
-	cpriv->length = half_buf_size-read_remain;
-	memcpy(cpriv->cache, cpriv->cache + read_remain, cpriv->length);
+	pcm_ring_write_commit(&cpriv->cache, half_buf_size);
+	pcm_ring_read(&cpriv->cache, data_ptr, read_remain);
 
 	return count;
 }
@@ -220,10 +219,10 @@ int snd_pcm_read(Snd_Card_Num card_num, void *data, uint32_t count)
 int snd_pcm_write(Snd_Card_Num card_num, void *data, uint32_t count)
 {
 	int ret;
-	uint8_t *data_ptr;
+	uint8_t *data_ptr, *span;
 	struct play_priv *ppriv;
 	struct pcm_priv *audio_pcm_priv;
-	uint32_t  half_buf_size, write_size, cache_remain=0;
+	uint32_t  half_buf_size, write_size, cache_len, cache_remain=0;
 
 	/* Check parms to be valid */
 	if(!data || !count){
@@ -239,7 +238,7 @@ int snd_pcm_write(Snd_Card_Num card_num, void *data, uint32_t count)
 	}
 
 	/* Check play cache */
-	if(audio_pcm_priv->play_priv.cache == NULL){
+	if(audio_pcm_priv->play_priv.cache.buf == NULL){
 		AUDIO_PCM_ERROR("Play Cache is NULL!\n");
 		return -1;
 	}
@@ -257,17 +256,19 @@ int snd_pcm_write(Snd_Card_Num card_num, void *data, uint32_t count)
 	half_buf_size = audio_pcm_priv->play_priv.half_buf_size;
 
 	/* Cache has data to write */
-	if (ppriv->length) {
-		cache_remain = half_buf_size - ppriv->length;
+	cache_len = pcm_ring_avail(&ppriv->cache);
+	if (cache_len) {
+		cache_remain = half_buf_size - cache_len;
 		if (cache_remain > write_size) {
-			memcpy(ppriv->cache + ppriv->length, data_ptr, write_size);
-			ppriv->length += write_size;
+			pcm_ring_write(&ppriv->cache, data_ptr, write_size);
 			pcm_unlock(&audio_pcm_priv->write_lock);
 			return count;
 		} else {
-			memcpy(ppriv->cache + ppriv->length, data_ptr, cache_remain);
-			HAL_SndCard_PcmWrite(card_num, ppriv->cache, half_buf_size);
-			ppriv->length = 0;
+			pcm_ring_write(&ppriv->cache, data_ptr, cache_remain);
+			pcm_ring_read_span(&ppriv->cache, &span);
+			HAL_SndCard_PcmWrite(card_num, span, half_buf_size);
+			pcm_ring_read_commit(&ppriv->cache, half_buf_size);
+			pcm_ring_reset(&ppriv->cache);
 			data_ptr += cache_remain;
 			write_size -= cache_remain;
 			if(!write_size){
@@ -281,13 +282,10 @@ int snd_pcm_write(Snd_Card_Num card_num, void *data, uint32_t count)
 	ret = HAL_SndCard_PcmWrite(card_num, data_ptr, write_size);
 	if (ret>0 && ret<write_size) {	//remain some data that not enough half_buf_size data to write, save to cache
 		data_ptr += ret;
-		ppriv->length = write_size - ret;
-		memcpy(ppriv->cache, data_ptr, ppriv->length);
+		pcm_ring_write(&ppriv->cache, data_ptr, write_size - ret);
 	} else if (ret == write_size) {	//all data write complete
-		ppriv->length = 0;
 	} else if(ret == 0) {			//ret=0, not enough half_buf_size data to write, save to cache
-		ppriv->length = write_size<half_buf_size ? write_size : half_buf_size;
-		memcpy(ppriv->cache, data_ptr, ppriv->length);
+		pcm_ring_write(&ppriv->cache, data_ptr, write_size<half_buf_size ? write_size : half_buf_size);
 	} else {						//ret<0, write fail
 		pcm_unlock(&audio_pcm_priv->write_lock);
 		return cache_remain ? cache_remain : -1;
@@ -299,7 +297,8 @@ int snd_pcm_write(Snd_Card_Num card_num, void *data, uint32_t count)
 
 int snd_pcm_flush(Snd_Card_Num card_num)
 {
-	uint32_t i, half_buf_size;
+	uint32_t i, half_buf_size, cache_len;
+	uint8_t *span;
 	struct play_priv *ppriv;
 	struct pcm_priv *audio_pcm_priv;
 	AUDIO_PCM_DEBUG("--->%s\n",__FUNCTION__);
@@ -312,7 +311,7 @@ int snd_pcm_flush(Snd_Card_Num card_num)
 	}
 
 	/* Check play cache */
-	if(audio_pcm_priv->play_priv.cache == NULL){
+	if(audio_pcm_priv->play_priv.cache.buf == NULL){
 		AUDIO_PCM_ERROR("Play Cache is NULL!\n");
 		return -1;
 	}
@@ -328,16 +327,21 @@ int snd_pcm_flush(Snd_Card_Num card_num)
 	half_buf_size = audio_pcm_priv->play_priv.half_buf_size;
 
 	/* Cache has data to write */
-	if(ppriv->length){
-		memset(ppriv->cache + ppriv->length, 0, half_buf_size - ppriv->length);
-		HAL_SndCard_PcmWrite(card_num, ppriv->cache, half_buf_size);
-		ppriv->length = 0;
+	cache_len = pcm_ring_avail(&ppriv->cache);
+	if(cache_len){
+		pcm_ring_write_span(&ppriv->cache, &span);
+		memset(span, 0, half_buf_size - cache_len);
+		pcm_ring_write_commit(&ppriv->cache, half_buf_size - cache_len);
+		pcm_ring_read_span(&ppriv->cache, &span);
+		HAL_SndCard_PcmWrite(card_num, span, half_buf_size);
+		pcm_ring_read_commit(&ppriv->cache, half_buf_size);
 	}
+	pcm_ring_reset(&ppriv->cache);
 
 	/* play void frames */
-	memset(ppriv->cache, 0, half_buf_size);
+	memset(ppriv->cache.buf, 0, half_buf_size);
 	for(i=0; i<2; i++) {
-		HAL_SndCard_PcmWrite(card_num, ppriv->cache, half_buf_size);
+		HAL_SndCard_PcmWrite(card_num, ppriv->cache.buf, half_buf_size);
 	}
 
 	pcm_unlock(&audio_pcm_priv->write_lock);
@@ -346,7 +350,8 @@ int snd_pcm_flush(Snd_Card_Num card_num)
 
 int snd_pcm_open(Snd_Card_Num card_num, Audio_Stream_Dir stream_dir, struct pcm_config *pcm_cfg)
 {
-	uint32_t buf_size;
+	uint32_t buf_size, cache_size;
+	uint8_t *cache;
 	struct pcm_priv *audio_pcm_priv;
 	AUDIO_PCM_DEBUG("--->%s\n",__FUNCTION__);
 
@@ -367,13 +372,14 @@ int snd_pcm_open(Snd_Card_Num card_num, Audio_Stream_Dir stream_dir, struct pcm_
 
 		// Malloc play cache buffer
 		buf_size = pcm_frames_to_bytes(pcm_cfg, pcm_config_to_frames(pcm_cfg));
-		audio_pcm_priv->play_priv.cache = pcm_zalloc(buf_size/2);
-		if (audio_pcm_priv->play_priv.cache == NULL) {
+		cache_size = pcm_ring_roundup(buf_size/2);
+		cache = pcm_zalloc(cache_size);
+		if (cache == NULL) {
 			pcm_unlock(&audio_pcm_priv->play_lock);
 			AUDIO_PCM_ERROR("obtain play cache failed...\n");
 			return -1;
 		}
-		audio_pcm_priv->play_priv.length = 0;
+		pcm_ring_init(&audio_pcm_priv->play_priv.cache, cache, cache_size);
 		audio_pcm_priv->play_priv.half_buf_size = buf_size/2;
 	} else {
 		//cap lock
@@ -384,13 +390,14 @@ int snd_pcm_open(Snd_Card_Num card_num, Audio_Stream_Dir stream_dir, struct pcm_
 
 		// Malloc capture cache buffer
 		buf_size = pcm_frames_to_bytes(pcm_cfg, pcm_config_to_frames(pcm_cfg));
-		audio_pcm_priv->cap_priv.cache = pcm_zalloc(buf_size/2);
-		if (audio_pcm_priv->cap_priv.cache == NULL) {
+		cache_size = pcm_ring_roundup(buf_size/2);
+		cache = pcm_zalloc(cache_size);
+		if (cache == NULL) {
 			pcm_unlock(&audio_pcm_priv->cap_lock);
 			AUDIO_PCM_ERROR("obtain cap cache failed...\n");
 			return -1;
 		}
-		audio_pcm_priv->cap_priv.length = 0;
+		pcm_ring_init(&audio_pcm_priv->cap_priv.cache, cache, cache_size);
 		audio_pcm_priv->cap_priv.half_buf_size = buf_size/2;
 	}
 
@@ -398,11 +405,11 @@ int snd_pcm_open(Snd_Card_Num card_num, Audio_Stream_Dir stream_dir, struct pcm_
 	if (HAL_SndCard_Open(card_num, stream_dir, pcm_cfg) != HAL_OK) {
 		AUDIO_PCM_ERROR("Sound card-[%d] open Fai!\n",card_num);
 		if (stream_dir == PCM_OUT) {
-			pcm_free(audio_pcm_priv->play_priv.cache);
+			pcm_free(audio_pcm_priv->play_priv.cache.buf);
 			memset(&(audio_pcm_priv->play_priv), 0, sizeof(struct play_priv));
 			pcm_unlock(&audio_pcm_priv->play_lock);
 		} else {
-			pcm_free(audio_pcm_priv->cap_priv.cache);
+			pcm_free(audio_pcm_priv->cap_priv.cache.buf);
 			memset(&(audio_pcm_priv->cap_priv), 0, sizeof(struct cap_priv));
 			pcm_unlock(&audio_pcm_priv->cap_lock);
 		}
@@ -429,11 +436,11 @@ int snd_pcm_close(Snd_Card_Num card_num, Audio_Stream_Dir stream_dir)
 
 	/* deinit audio_pcm_priv */
 	if (stream_dir == PCM_OUT) {
-		pcm_free(audio_pcm_priv->play_priv.cache);
+		pcm_free(audio_pcm_priv->play_priv.cache.buf);
 		memset(&(audio_pcm_priv->play_priv), 0, sizeof(struct play_priv));
 		pcm_unlock(&audio_pcm_priv->play_lock);
 	} else {
-		pcm_free(audio_pcm_priv->cap_priv.cache);
+		pcm_free(audio_pcm_priv->cap_priv.cache.buf);
 		memset(&(audio_pcm_priv->cap_priv), 0, sizeof(struct cap_priv));
 		pcm_unlock(&audio_pcm_priv->cap_lock);
 	}
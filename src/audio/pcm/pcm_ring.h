@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _PCM_RING_H_
+#define _PCM_RING_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Single-producer/single-consumer byte ring.
+ *
+ * The size is a power of two and head/tail are free-running byte counters,
+ * so the fill level is simply head - tail and no slot is wasted. Only the
+ * producer moves head and only the consumer moves tail, data is published
+ * before the counter, so one writer and one reader need no lock.
+ *
+ * The span functions return the largest contiguous region at the current
+ * position, letting callers fill or drain the ring in place (eg. by DMA)
+ * without an intermediate copy.
+ */
+struct pcm_ring {
+	uint8_t *buf;
+	uint32_t mask;			/* size - 1 */
+	volatile uint32_t head;		/* bytes written, producer only */
+	volatile uint32_t tail;		/* bytes read, consumer only */
+};
+
+#if defined(__GNUC__) && defined(__arm__)
+#define pcm_ring_barrier()	__asm volatile ("dmb" : : : "memory")
+#else
+#define pcm_ring_barrier()	__sync_synchronize()
+#endif
+
+static __inline uint32_t pcm_ring_roundup(uint32_t size)
+{
+	uint32_t n = 1;
+
+	while (n < size)
+		n <<= 1;
+	return n;
+}
+
+/* @size must be a power of two */
+static __inline void pcm_ring_init(struct pcm_ring *r, uint8_t *buf, uint32_t size)
+{
+	r->buf = buf;
+	r->mask = size - 1;
+	r->head = 0;
+	r->tail = 0;
+}
+
+/*
+ * Move both counters back to the start of the buffer, only allowed when
+ * producer and consumer are the same context and the ring is empty.
+ * Keeps the next span as long as the whole buffer.
+ */
+static __inline void pcm_ring_reset(struct pcm_ring *r)
+{
+	r->head = 0;
+	r->tail = 0;
+}
+
+static __inline uint32_t pcm_ring_size(const struct pcm_ring *r)
+{
+	return r->mask + 1;
+}
+
+static __inline uint32_t pcm_ring_avail(const struct pcm_ring *r)
+{
+	return r->head - r->tail;
+}
+
+static __inline uint32_t pcm_ring_space(const struct pcm_ring *r)
+{
+	return pcm_ring_size(r) - pcm_ring_avail(r);
+}
+
+static __inline uint32_t pcm_ring_read_span(const struct pcm_ring *r, uint8_t **ptr)
+{
+	uint32_t off = r->tail & r->mask;
+	uint32_t len = pcm_ring_avail(r);
+
+	if (len > pcm_ring_size(r) - off)
+		len = pcm_ring_size(r) - off;
+	*ptr = r->buf + off;
+	return len;
+}
+
+static __inline void pcm_ring_read_commit(struct pcm_ring *r, uint32_t len)
+{
+	pcm_ring_barrier();
+	r->tail += len;
+}
+
+static __inline uint32_t pcm_ring_write_span(const struct pcm_ring *r, uint8_t **ptr)
+{
+	uint32_t off = r->head & r->mask;
+	uint32_t len = pcm_ring_space(r);
+
+	if (len > pcm_ring_size(r) - off)
+		len = pcm_ring_size(r) - off;
+	*ptr = r->buf + off;
+	return len;
+}
+
+static __inline void pcm_ring_write_commit(struct pcm_ring *r, uint32_t len)
+{
+	pcm_ring_barrier();
+	r->head += len;
+}
+
+/* Copy out up to @len bytes, returns the number copied */
+static __inline uint32_t pcm_ring_read(struct pcm_ring *r, uint8_t *data, uint32_t len)
+{
+	uint32_t n, done = 0;
+	uint8_t *p;
+
+	while (done < len && (n = pcm_ring_read_span(r, &p)) != 0) {
+		if (n > len - done)
+			n = len - done;
+		memcpy(data + done, p, n);
+		pcm_ring_read_commit(r, n);
+		done += n;
+	}
+	return done;
+}
+
+/* Copy in up to @len bytes, returns the number copied */
+static __inline uint32_t pcm_ring_write(struct pcm_ring *r, const uint8_t *data, uint32_t len)
+{
+	uint32_t n, done = 0;
+	uint8_t *p;
+
+	while (done < len && (n = pcm_ring_write_span(r, &p)) != 0) {
+		if (n > len - done)
+			n = len - done;
+		memcpy(p, data + done, n);
+		pcm_ring_write_commit(r, n);
+		done += n;
+	}
+	return done;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PCM_RING_H_ */
@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "audio/resample/audio_resample.h"
+
+#if (__CONFIG_AUDIO_HEAP_MODE == 1)
+#include "sys/sys_heap.h"
+#define rs_malloc(size)		psram_malloc(size)
+#define rs_free(p)		psram_free(p)
+#else
+#include <stdlib.h>
+#define rs_malloc(size)		malloc(size)
+#define rs_free(p)		free(p)
+#endif
+
+#define RS_DBG_ON		0
+#define RS_ERR_ON		1
+
+#if RS_DBG_ON
+#define RS_DBG(fmt, arg...)	printf("[RESAMPLE] "fmt, ##arg)
+#else
+#define RS_DBG(fmt, arg...)
+#endif
+#if RS_ERR_ON
+#define RS_ERR(fmt, arg...)	printf("[RESAMPLE ERR] %s():%d, "fmt, __func__, __LINE__, ##arg)
+#else
+#define RS_ERR(fmt, arg...)
+#endif
+
+/* Input frames de-interleaved per pass */
+#define RS_BLOCK		256
+
+/* Kaiser window design: stopband attenuation in dB and the beta for it */
+#define RS_ATTEN		70.0
+#define RS_BETA			(0.1102 * (RS_ATTEN - 8.7))
+
+#ifndef M_PI
+#define M_PI			3.14159265358979323846
+#endif
+
+struct audio_resample {
+	uint8_t channels;
+	uint16_t L;		/* phases, out_rate / gcd */
+	uint16_t M;		/* in_rate / gcd */
+	uint16_t step;		/* M / L */
+	uint16_t rem;		/* M % L */
+	uint16_t taps;		/* per phase, even */
+	uint16_t phase;		/* phase of the next output */
+	uint32_t pos;		/* newest input sample of the next output in buf[] */
+	int16_t *coef;		/* [L][taps], time reversed */
+	int16_t *buf[2];	/* [taps - 1 + RS_BLOCK] per channel */
+};
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+
+static __inline int64_t rs_smlald(uint32_t x, uint32_t y, int64_t acc)
+{
+	__asm volatile ("smlald %Q0, %R0, %1, %2" : "+r" (acc) : "r" (x), "r" (y));
+	return acc;
+}
+
+static __inline int32_t rs_ssat16(int32_t x)
+{
+	int32_t r;
+	__asm ("ssat %0, #16, %1" : "=r" (r) : "r" (x));
+	return r;
+}
+
+#else /* __ARM_FEATURE_DSP */
+
+static __inline int64_t rs_smlald(uint32_t x, uint32_t y, int64_t acc)
+{
+	acc += (int32_t)(int16_t)x * (int32_t)(int16_t)y;
+	acc += (int32_t)(int16_t)(x >> 16) * (int32_t)(int16_t)(y >> 16);
+	return acc;
+}
+
+static __inline int32_t rs_ssat16(int32_t x)
+{
+	if (x > 32767)
+		return 32767;
+	if (x < -32768)
+		return -32768;
+	return x;
+}
+
+#endif /* __ARM_FEATURE_DSP */
+
+/* Two consecutive samples, the history window is not word aligned */
+static __inline uint32_t rs_load2(const int16_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static uint32_t rs_gcd(uint32_t a, uint32_t b)
+{
+	uint32_t t;
+
+	while (b) {
+		t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/* Zeroth order modified Bessel function of the first kind */
+static double rs_bessel_i0(double x)
+{
+	double sum = 1.0, term = 1.0, q = x * x / 4.0;
+	int k;
+
+	for (k = 1; k < 64; k++) {
+		term *= q / ((double)k * k);
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+/*
+ * Kaiser-windowed sinc at the upsampled rate, split into phases. Each
+ * phase is normalized to unity DC gain in Q15, the rounding residue going
+ * to its largest tap, so that a constant input comes out unchanged.
+ */
+static int rs_gen_coef(audio_resample_t *rs)
+{
+	uint32_t L = rs->L, taps = rs->taps, ntot = L * taps;
+	double center = (ntot - 1) / 2.0;
+	double i0b = rs_bessel_i0(RS_BETA);
+	double df, fc, t, r, sum, *h;
+	uint32_t p, j, n, jmax;
+	int16_t *c;
+	int32_t qsum;
+
+	h = rs_malloc(taps * sizeof(double));
+	if (h == NULL)
+		return -1;
+
+	/* put the -6 dB point half a transition band below the lower Nyquist */
+	df = (RS_ATTEN - 8.0) / (2.285 * 2.0 * M_PI * ntot);
+	fc = 0.5 / (L > rs->M ? L : rs->M) - df / 2.0;
+
+	for (p = 0; p < L; p++) {
+		sum = 0.0;
+		for (j = 0; j < taps; j++) {
+			n = (taps - 1 - j) * L + p;
+			t = n - center;
+			h[j] = (t == 0.0) ? 2.0 * fc : sin(2.0 * M_PI * fc * t) / (M_PI * t);
+			r = 2.0 * n / (ntot - 1) - 1.0;
+			h[j] *= rs_bessel_i0(RS_BETA * sqrt(r * r < 1.0 ? 1.0 - r * r : 0.0)) / i0b;
+			sum += h[j];
+		}
+
+		c = rs->coef + p * taps;
+		qsum = 0;
+		jmax = 0;
+		for (j = 0; j < taps; j++) {
+			c[j] = (int16_t)floor(h[j] / sum * 32768.0 + 0.5);
+			qsum += c[j];
+			if (h[j] > h[jmax])
+				jmax = j;
+		}
+		c[jmax] += 32768 - qsum;
+	}
+
+	rs_free(h);
+	return 0;
+}
+
+audio_resample_t *audio_resample_create(uint32_t in_rate, uint32_t out_rate,
+                                        uint8_t channels)
+{
+	audio_resample_t *rs;
+	uint32_t g, L, M, taps, hist;
+
+	if (in_rate == 0 || out_rate == 0 || channels == 0 || channels > 2) {
+		RS_ERR("invalid parameters, %u -> %u, chan %u\n", in_rate, out_rate, channels);
+		return NULL;
+	}
+
+	g = rs_gcd(in_rate, out_rate);
+	L = out_rate / g;
+	M = in_rate / g;
+	if (L > AUDIO_RESAMPLE_MAX_PHASES || M > 0xFFFF) {
+		RS_ERR("ratio %u/%u not supported\n", L, M);
+		return NULL;
+	}
+
+	/* keep the transition band constant relative to the lower rate */
+	taps = AUDIO_RESAMPLE_TAPS;
+	if (M > L)
+		taps = (taps * M + L - 1) / L;
+	taps = (taps + 1) & ~1U;
+	hist = taps - 1;
+
+	rs = rs_malloc(sizeof(*rs));
+	if (rs == NULL)
+		return NULL;
+	memset(rs, 0, sizeof(*rs));
+	rs->channels = channels;
+	rs->L = L;
+	rs->M = M;
+	rs->step = M / L;
+	rs->rem = M % L;
+	rs->taps = taps;
+
+	rs->coef = rs_malloc(L * taps * sizeof(int16_t));
+	rs->buf[0] = rs_malloc(channels * (hist + RS_BLOCK) * sizeof(int16_t));
+	if (rs->coef == NULL || rs->buf[0] == NULL || rs_gen_coef(rs) != 0) {
+		RS_ERR("no memory, %u phases x %u taps\n", L, taps);
+		audio_resample_destroy(rs);
+		return NULL;
+	}
+	if (channels > 1)
+		rs->buf[1] = rs->buf[0] + hist + RS_BLOCK;
+
+	audio_resample_reset(rs);
+	RS_DBG("%u -> %u, L %u, M %u, taps %u\n", in_rate, out_rate, L, M, taps);
+	return rs;
+}
+
+void audio_resample_destroy(audio_resample_t *rs)
+{
+	if (rs == NULL)
+		return;
+	if (rs->buf[0])
+		rs_free(rs->buf[0]);
+	if (rs->coef)
+		rs_free(rs->coef);
+	rs_free(rs);
+}
+
+void audio_resample_reset(audio_resample_t *rs)
+{
+	uint32_t hist = rs->taps - 1;
+
+	memset(rs->buf[0], 0, rs->channels * (hist + RS_BLOCK) * sizeof(int16_t));
+	rs->pos = hist;
+	rs->phase = 0;
+}
+
+uint32_t audio_resample_out_frames(audio_resample_t *rs, uint32_t in_frames)
+{
+	return (uint32_t)(((uint64_t)in_frames * rs->L + rs->M - 1) / rs->M) + 1;
+}
+
+uint32_t audio_resample_process(audio_resample_t *rs, const int16_t *in,
+                                uint32_t in_frames, int16_t *out)
+{
+	const uint32_t taps = rs->taps, hist = taps - 1;
+	const int16_t *c, *x0, *x1;
+	int16_t *b0 = rs->buf[0], *b1 = rs->buf[1];
+	uint32_t n, i, j, avail, cw, produced = 0;
+	int64_t acc0, acc1;
+
+	while (in_frames) {
+		n = (in_frames > RS_BLOCK) ? RS_BLOCK : in_frames;
+
+		if (rs->channels == 1) {
+			memcpy(b0 + hist, in, n * sizeof(int16_t));
+		} else {
+			for (i = 0; i < n; i++) {
+				b0[hist + i] = in[2 * i];
+				b1[hist + i] = in[2 * i + 1];
+			}
+		}
+		in += n * rs->channels;
+		in_frames -= n;
+		avail = hist + n;
+
+		while (rs->pos < avail) {
+			c = rs->coef + rs->phase * taps;
+			x0 = b0 + rs->pos - hist;
+			acc0 = 1 << 14;
+			if (rs->channels == 1) {
+				for (j = 0; j < taps; j += 2)
+					acc0 = rs_smlald(rs_load2(x0 + j), rs_load2(c + j), acc0);
+				*out++ = rs_ssat16((int32_t)(acc0 >> 15));
+			} else {
+				x1 = b1 + rs->pos - hist;
+				acc1 = 1 << 14;
+				for (j = 0; j < taps; j += 2) {
+					cw = rs_load2(c + j);
+					acc0 = rs_smlald(rs_load2(x0 + j), cw, acc0);
+					acc1 = rs_smlald(rs_load2(x1 + j), cw, acc1);
+				}
+				*out++ = rs_ssat16((int32_t)(acc0 >> 15));
+				*out++ = rs_ssat16((int32_t)(acc1 >> 15));
+			}
+			produced++;
+
+			rs->pos += rs->step;
+			rs->phase += rs->rem;
+			if (rs->phase >= rs->L) {
+				rs->phase -= rs->L;
+				rs->pos++;
+			}
+		}
+
+		/* keep the newest hist samples for the next block */
+		memmove(b0, b0 + n, hist * sizeof(int16_t));
+		if (b1)
+			memmove(b1, b1 + n, hist * sizeof(int16_t));
+		rs->pos -= n;
+	}
+
+	return produced;
+}
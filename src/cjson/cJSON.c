@@ -137,6 +137,129 @@ static cJSON *cJSON_New_Item(void)
     return node;
 }
 
+/*
+ * Arena used by cJSON_ParseInSitu(): a bump allocator over a caller
+ * supplied buffer, nothing in it is ever freed individually.
+ */
+typedef struct
+{
+    char *base;
+    size_t size;
+    size_t used;
+} cjson_arena;
+
+#define CJSON_ARENA_ALIGN sizeof(double)
+
+static void *cjson_arena_alloc(cjson_arena *arena, size_t size)
+{
+    size_t start = (arena->used + CJSON_ARENA_ALIGN - 1) & ~(CJSON_ARENA_ALIGN - 1);
+    void *p = NULL;
+
+    if ((start > arena->size) || (size > arena->size - start))
+    {
+        return NULL;
+    }
+    p = arena->base + start;
+    arena->used = start + size;
+
+    return p;
+}
+
+/* Node constructor for the parser, from the arena when there is one. */
+static cJSON *cjson_new_item(cjson_arena *arena)
+{
+    cJSON *node = NULL;
+
+    if (!arena)
+    {
+        return cJSON_New_Item();
+    }
+    node = (cJSON*)cjson_arena_alloc(arena, sizeof(cJSON));
+    if (node)
+    {
+        memset(node, '\0', sizeof(cJSON));
+    }
+
+    return node;
+}
+
+/*
+ * Hash index of the members of an arena object, open addressing on the
+ * lower-cased key. Only the first of several equal keys is entered, which
+ * keeps the result of cJSON_GetObjectItem() identical to the linear walk.
+ * It is reached through the object's index field and dropped by every
+ * function that changes the member list.
+ */
+typedef struct cjson_index
+{
+    unsigned int mask;
+    cJSON *slot[1];
+} cjson_index;
+
+static unsigned int cjson_hash(const char *str)
+{
+    unsigned int h = 2166136261U;
+
+    while (*str)
+    {
+        h ^= (unsigned int)tolower(*(const unsigned char *)str++);
+        h *= 16777619U;
+    }
+
+    return h;
+}
+
+static void cjson_index_object(cJSON *item, cjson_arena *arena)
+{
+    cjson_index *index = NULL;
+    cJSON *c = NULL;
+    unsigned int n = 0;
+    unsigned int size = 1;
+    unsigned int i = 0;
+
+    for (c = item->child; c; c = c->next)
+    {
+        n++;
+    }
+    if (n < CJSON_INDEX_MIN)
+    {
+        return;
+    }
+    while (size < 2 * n)
+    {
+        size <<= 1;
+    }
+
+    /* the index is optional, just skip it when the arena is full */
+    index = (cjson_index*)cjson_arena_alloc(arena, sizeof(cjson_index) + (size - 1) * sizeof(cJSON*));
+    if (!index)
+    {
+        return;
+    }
+    memset(index->slot, 0, size * sizeof(cJSON*));
+    index->mask = size - 1;
+
+    for (c = item->child; c; c = c->next)
+    {
+        i = cjson_hash(c->string) & index->mask;
+        while (index->slot[i] && cJSON_strcasecmp(index->slot[i]->string, c->string))
+        {
+            i = (i + 1) & index->mask;
+        }
+        if (!index->slot[i])
+        {
+            index->slot[i] = c;
+        }
+    }
+    item->index = index;
+}
+
+/* The member list of container is about to change, stop using its index. */
+static void cjson_drop_index(cJSON *container)
+{
+    container->index = NULL;
+}
+
 /* Delete a cJSON structure. */
 void cJSON_Delete(cJSON *c)
 {
@@ -487,7 +610,7 @@ static const unsigned char firstByteMark[7] =
 };
 
 /* Parse the input text into an unescaped cstring, and populate item. */
-static const char *parse_string(cJSON *item, const char *str, const char **ep)
+static const char *parse_string(cJSON *item, const char *str, const char **ep, cjson_arena *arena)
 {
     const char *ptr = str + 1;
     const char *end_ptr =str + 1;
@@ -520,7 +643,15 @@ static const char *parse_string(cJSON *item, const char *str, const char **ep)
     }
 
     /* This is at most how long we need for the string, roughly. */
-    out = (char*)cJSON_malloc(len + 1);
+    if (arena)
+    {
+        /* in situ: unescaping never makes the string longer */
+        out = (char*)str + 1;
+    }
+    else
+    {
+        out = (char*)cJSON_malloc(len + 1);
+    }
     if (!out)
     {
         return NULL;
@@ -655,11 +786,12 @@ static const char *parse_string(cJSON *item, const char *str, const char **ep)
             ptr++;
         }
     }
-    *ptr2 = '\0';
+    /* step over the quote before the terminator may overwrite it in situ */
     if (*ptr == '\"')
     {
         ptr++;
     }
+    *ptr2 = '\0';
 
     return ptr;
 }
@@ -817,11 +949,11 @@ static char *print_string(const cJSON *item, printbuffer *p)
 }
 
 /* Predeclare these prototypes. */
-static const char *parse_value(cJSON *item, const char *value, const char **ep);
+static const char *parse_value(cJSON *item, const char *value, const char **ep, cjson_arena *arena);
 static char *print_value(const cJSON *item, int depth, cjbool fmt, printbuffer *p);
-static const char *parse_array(cJSON *item, const char *value, const char **ep);
+static const char *parse_array(cJSON *item, const char *value, const char **ep, cjson_arena *arena);
 static char *print_array(const cJSON *item, int depth, cjbool fmt, printbuffer *p);
-static const char *parse_object(cJSON *item, const char *value, const char **ep);
+static const char *parse_object(cJSON *item, const char *value, const char **ep, cjson_arena *arena);
 static char *print_object(const cJSON *item, int depth, cjbool fmt, printbuffer *p);
 
 /* Utility to jump whitespace and cr/lf */
@@ -848,7 +980,7 @@ cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cjb
         return NULL;
     }
 
-    end = parse_value(c, skip(value), ep);
+    end = parse_value(c, skip(value), ep, NULL);
     if (!end)
     {
         /* parse failure. ep is set. */
@@ -881,6 +1013,38 @@ cJSON *cJSON_Parse(const char *value)
     return cJSON_ParseWithOpts(value, 0, 0);
 }
 
+/* Parse into a caller supplied arena, strings are unescaped inside value. */
+cJSON *cJSON_ParseInSitu(char *value, void *buffer, size_t size, size_t *used)
+{
+    const char *end = NULL;
+    cjson_arena arena;
+    cJSON *c = NULL;
+
+    global_ep = NULL;
+    arena.base = (char*)buffer;
+    arena.size = size;
+    arena.used = 0;
+
+    c = cjson_new_item(&arena);
+    if (!c) /* memory fail */
+    {
+        return NULL;
+    }
+
+    end = parse_value(c, skip(value), &global_ep, &arena);
+    if (!end)
+    {
+        /* parse failure, nothing to free. */
+        return NULL;
+    }
+    if (used)
+    {
+        *used = arena.used;
+    }
+
+    return c;
+}
+
 /* Render a cJSON item/entity/structure to text. */
 char *cJSON_Print(const cJSON *item)
 {
@@ -918,7 +1082,7 @@ int cJSON_PrintPreallocated(cJSON *item,char *buf, const int len, const cjbool f
 }
 
 /* Parser core - when encountering text, process appropriately. */
-static const char *parse_value(cJSON *item, const char *value, const char **ep)
+static const char *parse_value(cJSON *item, const char *value, const char **ep, cjson_arena *arena)
 {
     if (!value)
     {
@@ -945,7 +1109,7 @@ static const char *parse_value(cJSON *item, const char *value, const char **ep)
     }
     if (*value == '\"')
     {
-        return parse_string(item, value, ep);
+        return parse_string(item, value, ep, arena);
     }
     if ((*value == '-') || ((*value >= '0') && (*value <= '9')))
     {
@@ -953,11 +1117,11 @@ static const char *parse_value(cJSON *item, const char *value, const char **ep)
     }
     if (*value == '[')
     {
-        return parse_array(item, value, ep);
+        return parse_array(item, value, ep, arena);
     }
     if (*value == '{')
     {
-        return parse_object(item, value, ep);
+        return parse_object(item, value, ep, arena);
     }
 
     /* failure. */
@@ -1069,7 +1233,7 @@ static char *print_value(const cJSON *item, int depth, cjbool fmt, printbuffer *
 }
 
 /* Build an array from input text. */
-static const char *parse_array(cJSON *item,const char *value,const char **ep)
+static const char *parse_array(cJSON *item,const char *value,const char **ep,cjson_arena *arena)
 {
     cJSON *child = NULL;
     if (*value != '[')
@@ -1087,14 +1251,14 @@ static const char *parse_array(cJSON *item,const char *value,const char **ep)
         return value + 1;
     }
 
-    item->child = child = cJSON_New_Item();
+    item->child = child = cjson_new_item(arena);
     if (!item->child)
     {
         /* memory fail */
         return NULL;
     }
     /* skip any spacing, get the value. */
-    value = skip(parse_value(child, skip(value), ep));
+    value = skip(parse_value(child, skip(value), ep, arena));
     if (!value)
     {
         return NULL;
@@ -1104,7 +1268,7 @@ static const char *parse_array(cJSON *item,const char *value,const char **ep)
     while (*value == ',')
     {
         cJSON *new_item = NULL;
-        if (!(new_item = cJSON_New_Item()))
+        if (!(new_item = cjson_new_item(arena)))
         {
             /* memory fail */
             return NULL;
@@ -1115,7 +1279,7 @@ static const char *parse_array(cJSON *item,const char *value,const char **ep)
         child = new_item;
 
         /* go to the next comma */
-        value = skip(parse_value(child, skip(value + 1), ep));
+        value = skip(parse_value(child, skip(value + 1), ep, arena));
         if (!value)
         {
             /* memory fail */
@@ -1305,7 +1469,7 @@ static char *print_array(const cJSON *item, int depth, cjbool fmt, printbuffer *
 }
 
 /* Build an object from the text. */
-static const char *parse_object(cJSON *item, const char *value, const char **ep)
+static const char *parse_object(cJSON *item, const char *value, const char **ep, cjson_arena *arena)
 {
     cJSON *child = NULL;
     if (*value != '{')
@@ -1323,14 +1487,14 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
         return value + 1;
     }
 
-    child = cJSON_New_Item();
+    child = cjson_new_item(arena);
     item->child = child;
     if (!item->child)
     {
         return NULL;
     }
     /* parse first key */
-    value = skip(parse_string(child, skip(value), ep));
+    value = skip(parse_string(child, skip(value), ep, arena));
     if (!value)
     {
         return NULL;
@@ -1346,7 +1510,7 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
         return NULL;
     }
     /* skip any spacing, get the value. */
-    value = skip(parse_value(child, skip(value + 1), ep));
+    value = skip(parse_value(child, skip(value + 1), ep, arena));
     if (!value)
     {
         return NULL;
@@ -1355,7 +1519,7 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
     while (*value == ',')
     {
         cJSON *new_item = NULL;
-        if (!(new_item = cJSON_New_Item()))
+        if (!(new_item = cjson_new_item(arena)))
         {
             /* memory fail */
             return NULL;
@@ -1365,7 +1529,7 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
         new_item->prev = child;
 
         child = new_item;
-        value = skip(parse_string(child, skip(value + 1), ep));
+        value = skip(parse_string(child, skip(value + 1), ep, arena));
         if (!value)
         {
             return NULL;
@@ -1382,7 +1546,7 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
             return NULL;
         }
         /* skip any spacing, get the value. */
-        value = skip(parse_value(child, skip(value + 1), ep));
+        value = skip(parse_value(child, skip(value + 1), ep, arena));
         if (!value)
         {
             return NULL;
@@ -1391,6 +1555,10 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
     /* end of object */
     if (*value == '}')
     {
+        if (arena)
+        {
+            cjson_index_object(item, arena);
+        }
         return value + 1;
     }
 
@@ -1707,7 +1875,21 @@ cJSON *cJSON_GetArrayItem(const cJSON *array, int item)
 
 cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string)
 {
-    cJSON *c = object ? object->child : NULL;
+    const cjson_index *index = (object && string) ? object->index : NULL;
+    cJSON *c = NULL;
+    unsigned int i = 0;
+
+    if (index)
+    {
+        i = cjson_hash(string) & index->mask;
+        while ((c = index->slot[i]) && cJSON_strcasecmp(c->string, string))
+        {
+            i = (i + 1) & index->mask;
+        }
+        return c;
+    }
+
+    c = object ? object->child : NULL;
     while (c && cJSON_strcasecmp(c->string, string))
     {
         c = c->next;
@@ -1737,6 +1919,7 @@ static cJSON *create_reference(const cJSON *item)
     }
     memcpy(ref, item, sizeof(cJSON));
     ref->string = NULL;
+    ref->index = NULL;
     ref->type |= cJSON_IsReference;
     ref->next = ref->prev = NULL;
     return ref;
@@ -1750,6 +1933,7 @@ void   cJSON_AddItemToArray(cJSON *array, cJSON *item)
     {
         return;
     }
+    cjson_drop_index(array);
     if (!c)
     {
         /* list is empty, start new one */
@@ -1825,6 +2009,7 @@ cJSON *cJSON_DetachItemFromArray(cJSON *array, int which)
         /* item doesn't exist */
         return NULL;
     }
+    cjson_drop_index(array);
     if (c->prev)
     {
         /* not the first element */
@@ -1885,6 +2070,7 @@ void cJSON_InsertItemInArray(cJSON *array, int which, cJSON *newitem)
         cJSON_AddItemToArray(array, newitem);
         return;
     }
+    cjson_drop_index(array);
     newitem->next = c;
     newitem->prev = c->prev;
     c->prev = newitem;
@@ -1910,6 +2096,7 @@ void cJSON_ReplaceItemInArray(cJSON *array, int which, cJSON *newitem)
     {
         return;
     }
+    cjson_drop_index(array);
     newitem->next = c->next;
     newitem->prev = c->prev;
     if (newitem->next)
@@ -0,0 +1,559 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "cjson/json_extract.h"
+
+enum {
+	S_VALUE,		/* expect a value */
+	S_ARRAY_FIRST,		/* after '[': value or ']' */
+	S_OBJECT_FIRST,		/* after '{': key or '}' */
+	S_KEY,			/* expect the opening quote of a key */
+	S_COLON,
+	S_NEXT,			/* after a value: ',' or the container end */
+	S_STRING,
+	S_ESCAPE,
+	S_UNICODE,
+	S_LITERAL,
+	S_DONE,
+	S_ERROR,
+};
+
+#define KEY_OVERFLOW	0xFF
+
+#define is_plain(c)	((c) != '"' && (c) != '\\' && (unsigned char)(c) >= 0x20)
+#define is_space(c)	((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+#define to_lower(c)	(((c) >= 'A' && (c) <= 'Z') ? (c) + ('a' - 'A') : (c))
+
+static int is_array(const json_extract_t *ctx, int level)
+{
+	return (ctx->stack >> level) & 1;
+}
+
+/* Find segment @i of @path, '.' and '[' separate segments, ']' is dropped */
+static const char *path_segment(const char *path, int i, int *len)
+{
+	const char *p = path;
+
+	while (i--) {
+		while (*p && *p != '.' && *p != '[')
+			p++;
+		if (*p == '\0')
+			return NULL;
+		p++;
+	}
+	*len = 0;
+	while (p[*len] && p[*len] != '.' && p[*len] != '[' && p[*len] != ']')
+		(*len)++;
+	return p;
+}
+
+static int path_count(const char *path)
+{
+	int n = 0;
+	const char *p;
+
+	if (path == NULL || *path == '\0')
+		return 0;
+	for (n = 1, p = path; *p; p++) {
+		if (*p == '.' || *p == '[')
+			n++;
+	}
+	return n;
+}
+
+/* Does segment @d - 1 of @f name the member at depth @d? */
+static int segment_match(const json_extract_t *ctx, const json_extract_field *f, int d)
+{
+	const char *seg;
+	int len, i;
+	uint32_t idx = 0;
+
+	seg = path_segment(f->path, d - 1, &len);
+	if (seg == NULL)
+		return 0;
+
+	if (is_array(ctx, d - 1)) {
+		if (len == 0 || len > 5)
+			return 0;
+		for (i = 0; i < len; i++) {
+			if (seg[i] < '0' || seg[i] > '9')
+				return 0;
+			idx = idx * 10 + (seg[i] - '0');
+		}
+		return idx == ctx->index[d - 1];
+	}
+
+	if (ctx->key_len == KEY_OVERFLOW || ctx->key_len != len)
+		return 0;
+	if (!(f->flags & JSON_EXTRACT_NOCASE))
+		return memcmp(seg, ctx->key, len) == 0;
+	for (i = 0; i < len; i++) {
+		if (to_lower(seg[i]) != to_lower(ctx->key[i]))
+			return 0;
+	}
+	return 1;
+}
+
+/* Keeps buf terminated after every byte, even if the document stops here */
+static void field_put(json_extract_field *f, char c)
+{
+	if (f->len + 1 < f->size) {
+		f->buf[f->len++] = c;
+		f->buf[f->len] = '\0';
+	} else {
+		f->flags |= JSON_EXTRACT_TRUNCATED;
+	}
+}
+
+/* A value of @type starts at the current depth, @c is its first byte */
+static void value_begin(json_extract_t *ctx, uint8_t type, char c)
+{
+	json_extract_field *f;
+	int d = ctx->depth;
+	int i;
+
+	for (i = 0; i < ctx->nfields; i++) {
+		f = &ctx->fields[i];
+		if ((f->flags & JSON_EXTRACT_FOUND) || f->capture)
+			continue;
+		if (d > 0 && (f->matched != d - 1 || !segment_match(ctx, f, d)))
+			continue;
+		if (d == f->nseg) {
+			f->capture = d + 1;
+			f->type = type;
+			f->len = 0;
+			f->buf[0] = '\0';
+			if (type == JSON_EXTRACT_OBJECT || type == JSON_EXTRACT_ARRAY) {
+				field_put(f, c);
+				ctx->raw++;
+			} else if (type == JSON_EXTRACT_STRING) {
+				ctx->copy++;
+			}
+		} else if (d > 0) {
+			f->matched = d;
+		}
+	}
+}
+
+/* The value at the current depth ended */
+static void value_end(json_extract_t *ctx)
+{
+	json_extract_field *f;
+	int d = ctx->depth;
+	int i;
+
+	for (i = 0; i < ctx->nfields; i++) {
+		f = &ctx->fields[i];
+		if (f->capture == d + 1) {
+			f->flags |= JSON_EXTRACT_FOUND;
+			f->capture = 0;
+			if (f->type == JSON_EXTRACT_OBJECT || f->type == JSON_EXTRACT_ARRAY)
+				ctx->raw--;
+			else if (f->type == JSON_EXTRACT_STRING)
+				ctx->copy--;
+			ctx->remain--;
+		}
+		if (d > 0 && f->matched >= d)
+			f->matched = d - 1;
+	}
+}
+
+/* Raw bytes inside captured objects/arrays */
+static void raw_put(json_extract_t *ctx, char c)
+{
+	json_extract_field *f;
+	int i;
+
+	if (ctx->raw == 0)
+		return;
+	for (i = 0; i < ctx->nfields; i++) {
+		f = &ctx->fields[i];
+		if (f->capture && (f->type == JSON_EXTRACT_OBJECT || f->type == JSON_EXTRACT_ARRAY))
+			field_put(f, c);
+	}
+}
+
+/* A decoded string byte, for the key or for captured string values */
+static void string_put(json_extract_t *ctx, char c)
+{
+	json_extract_field *f;
+	int i;
+
+	if (ctx->ret_state == S_COLON) {
+		if (ctx->key_len == KEY_OVERFLOW)
+			return;
+		if (ctx->key_len < JSON_EXTRACT_KEY_MAX)
+			ctx->key[ctx->key_len++] = c;
+		else
+			ctx->key_len = KEY_OVERFLOW;
+		return;
+	}
+
+	for (i = 0; i < ctx->nfields; i++) {
+		f = &ctx->fields[i];
+		if (f->capture == ctx->depth + 1 && f->type == JSON_EXTRACT_STRING)
+			field_put(f, c);
+	}
+}
+
+static void string_put_utf8(json_extract_t *ctx, uint32_t cp)
+{
+	if (cp < 0x80) {
+		string_put(ctx, cp);
+	} else if (cp < 0x800) {
+		string_put(ctx, 0xC0 | (cp >> 6));
+		string_put(ctx, 0x80 | (cp & 0x3F));
+	} else if (cp < 0x10000) {
+		string_put(ctx, 0xE0 | (cp >> 12));
+		string_put(ctx, 0x80 | ((cp >> 6) & 0x3F));
+		string_put(ctx, 0x80 | (cp & 0x3F));
+	} else {
+		string_put(ctx, 0xF0 | (cp >> 18));
+		string_put(ctx, 0x80 | ((cp >> 12) & 0x3F));
+		string_put(ctx, 0x80 | ((cp >> 6) & 0x3F));
+		string_put(ctx, 0x80 | (cp & 0x3F));
+	}
+}
+
+/* Classify the buffered number/literal and hand it to the fields */
+static int literal_end(json_extract_t *ctx)
+{
+	json_extract_field *f;
+	uint8_t type;
+	int i, j;
+
+	ctx->lit[ctx->lit_len] = '\0';
+	if (!strcmp(ctx->lit, "true"))
+		type = JSON_EXTRACT_TRUE;
+	else if (!strcmp(ctx->lit, "false"))
+		type = JSON_EXTRACT_FALSE;
+	else if (!strcmp(ctx->lit, "null"))
+		type = JSON_EXTRACT_NULL;
+	else if (ctx->lit[0] == '-' || (ctx->lit[0] >= '0' && ctx->lit[0] <= '9'))
+		type = JSON_EXTRACT_NUMBER;
+	else
+		return -1;
+
+	value_begin(ctx, type, ctx->lit[0]);
+	for (i = 0; i < ctx->nfields; i++) {
+		f = &ctx->fields[i];
+		if (f->capture == ctx->depth + 1) {
+			for (j = 0; j < ctx->lit_len; j++)
+				field_put(f, ctx->lit[j]);
+		}
+	}
+	value_end(ctx);
+	return 0;
+}
+
+/* Open an object or array, the caller already reported the value begin */
+static int container_push(json_extract_t *ctx, int array)
+{
+	if (ctx->depth >= JSON_EXTRACT_DEPTH_MAX)
+		return -1;
+	if (array)
+		ctx->stack |= (1U << ctx->depth);
+	else
+		ctx->stack &= ~(1U << ctx->depth);
+	ctx->index[ctx->depth] = 0;
+	ctx->depth++;
+	return 0;
+}
+
+/* Close the current container, which ends the value one level up */
+static void container_pop(json_extract_t *ctx)
+{
+	ctx->depth--;
+	value_end(ctx);
+}
+
+/* What follows the end of a value at the current depth */
+static uint8_t after_value(json_extract_t *ctx)
+{
+	if (ctx->depth == 0 || ctx->remain == 0)
+		return S_DONE;
+	return S_NEXT;
+}
+
+static int hex_value(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+/* Start of a value at the current depth */
+static uint8_t value_start(json_extract_t *ctx, char c)
+{
+	switch (c) {
+	case '{':
+		value_begin(ctx, JSON_EXTRACT_OBJECT, c);
+		return container_push(ctx, 0) ? S_ERROR : S_OBJECT_FIRST;
+	case '[':
+		value_begin(ctx, JSON_EXTRACT_ARRAY, c);
+		return container_push(ctx, 1) ? S_ERROR : S_ARRAY_FIRST;
+	case '"':
+		value_begin(ctx, JSON_EXTRACT_STRING, c);
+		ctx->ret_state = S_NEXT;
+		return S_STRING;
+	default:
+		if (c == '-' || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z')) {
+			ctx->lit[0] = c;
+			ctx->lit_len = 1;
+			return S_LITERAL;
+		}
+		return S_ERROR;
+	}
+}
+
+void json_extract_init(json_extract_t *ctx, json_extract_field *fields, int nfields)
+{
+	int i;
+
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->fields = fields;
+	ctx->nfields = nfields;
+	ctx->remain = nfields;
+	ctx->state = (nfields > 0) ? S_VALUE : S_DONE;
+
+	for (i = 0; i < nfields; i++) {
+		fields[i].len = 0;
+		fields[i].type = JSON_EXTRACT_NONE;
+		fields[i].flags &= JSON_EXTRACT_NOCASE;
+		fields[i].nseg = path_count(fields[i].path);
+		fields[i].matched = 0;
+		fields[i].capture = 0;
+		if (fields[i].size)
+			fields[i].buf[0] = '\0';
+		else
+			ctx->state = S_ERROR;
+	}
+}
+
+int json_extract_feed(json_extract_t *ctx, const char *data, size_t len)
+{
+	uint8_t st = ctx->state;
+	int again = 0;
+	size_t i = 0;
+	int v;
+	char c;
+
+	while (i < len && st != S_DONE && st != S_ERROR) {
+		c = data[i];
+		if (!again)
+			raw_put(ctx, c);
+		again = 0;
+
+		switch (st) {
+		case S_VALUE:
+			if (!is_space(c))
+				st = value_start(ctx, c);
+			break;
+		case S_ARRAY_FIRST:
+			if (is_space(c))
+				break;
+			if (c == ']') {
+				container_pop(ctx);
+				st = after_value(ctx);
+			} else {
+				st = value_start(ctx, c);
+			}
+			break;
+		case S_OBJECT_FIRST:
+		case S_KEY:
+			if (is_space(c))
+				break;
+			if (c == '"') {
+				ctx->key_len = 0;
+				ctx->ret_state = S_COLON;
+				st = S_STRING;
+			} else if (c == '}' && st == S_OBJECT_FIRST) {
+				container_pop(ctx);
+				st = after_value(ctx);
+			} else {
+				st = S_ERROR;
+			}
+			break;
+		case S_COLON:
+			if (c == ':')
+				st = S_VALUE;
+			else if (!is_space(c))
+				st = S_ERROR;
+			break;
+		case S_NEXT:
+			if (is_space(c))
+				break;
+			if (c == ',') {
+				if (is_array(ctx, ctx->depth - 1)) {
+					ctx->index[ctx->depth - 1]++;
+					st = S_VALUE;
+				} else {
+					st = S_KEY;
+				}
+			} else if (c == (is_array(ctx, ctx->depth - 1) ? ']' : '}')) {
+				container_pop(ctx);
+				st = after_value(ctx);
+			} else {
+				st = S_ERROR;
+			}
+			break;
+		case S_STRING:
+			if (ctx->surrogate && c != '\\') {
+				st = S_ERROR;
+			} else if (c == '\\') {
+				st = S_ESCAPE;
+			} else if (c == '"') {
+				if (ctx->ret_state == S_NEXT) {
+					value_end(ctx);
+					st = after_value(ctx);
+				} else {
+					st = S_COLON;
+				}
+			} else if ((unsigned char)c < 0x20) {
+				st = S_ERROR;
+			} else {
+				string_put(ctx, c);
+				/* skip the rest of a value nobody stores in one go */
+				if (ctx->ret_state == S_NEXT && ctx->copy == 0 && ctx->raw == 0) {
+					while (i + 1 < len && is_plain(data[i + 1]))
+						i++;
+				}
+			}
+			break;
+		case S_ESCAPE:
+			st = S_STRING;
+			if (ctx->surrogate && c != 'u') {
+				st = S_ERROR;
+				break;
+			}
+			switch (c) {
+			case '"':
+			case '\\':
+			case '/':
+				string_put(ctx, c);
+				break;
+			case 'b':
+				string_put(ctx, '\b');
+				break;
+			case 'f':
+				string_put(ctx, '\f');
+				break;
+			case 'n':
+				string_put(ctx, '\n');
+				break;
+			case 'r':
+				string_put(ctx, '\r');
+				break;
+			case 't':
+				string_put(ctx, '\t');
+				break;
+			case 'u':
+				ctx->hex = 0;
+				ctx->hex_len = 0;
+				st = S_UNICODE;
+				break;
+			default:
+				st = S_ERROR;
+				break;
+			}
+			break;
+		case S_UNICODE:
+			v = hex_value(c);
+			if (v < 0) {
+				st = S_ERROR;
+				break;
+			}
+			ctx->hex = (ctx->hex << 4) | v;
+			if (++ctx->hex_len < 4)
+				break;
+			st = S_STRING;
+			if (ctx->surrogate) {
+				if (ctx->hex < 0xDC00 || ctx->hex > 0xDFFF) {
+					st = S_ERROR;
+					break;
+				}
+				string_put_utf8(ctx, 0x10000 + (((uint32_t)(ctx->surrogate & 0x3FF) << 10) |
+				                                (ctx->hex & 0x3FF)));
+				ctx->surrogate = 0;
+			} else if (ctx->hex >= 0xD800 && ctx->hex <= 0xDBFF) {
+				ctx->surrogate = ctx->hex;
+			} else if ((ctx->hex >= 0xDC00 && ctx->hex <= 0xDFFF) || ctx->hex == 0) {
+				st = S_ERROR;
+			} else {
+				string_put_utf8(ctx, ctx->hex);
+			}
+			break;
+		case S_LITERAL:
+			if (c == '-' || c == '+' || c == '.' ||
+			    (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+				if (ctx->lit_len + 1 >= JSON_EXTRACT_LITERAL_MAX)
+					st = S_ERROR;
+				else
+					ctx->lit[ctx->lit_len++] = c;
+				break;
+			}
+			if (literal_end(ctx) != 0) {
+				st = S_ERROR;
+				break;
+			}
+			/* the delimiter is handled again as the byte after the value */
+			st = after_value(ctx);
+			again = 1;
+			continue;
+		default:
+			break;
+		}
+		i++;
+	}
+
+	ctx->state = st;
+	if (st == S_ERROR)
+		return JSON_EXTRACT_ERROR;
+	return (st == S_DONE) ? JSON_EXTRACT_DONE : JSON_EXTRACT_MORE;
+}
+
+int json_extract(const char *data, size_t len, json_extract_field *fields, int nfields)
+{
+	json_extract_t ctx;
+	int ret;
+
+	json_extract_init(&ctx, fields, nfields);
+	ret = json_extract_feed(&ctx, data, len);
+	if (ret == JSON_EXTRACT_MORE && ctx.state == S_LITERAL && ctx.depth == 0)
+		ret = json_extract_feed(&ctx, " ", 1);	/* a bare number as document */
+	if (ret == JSON_EXTRACT_ERROR)
+		return JSON_EXTRACT_ERROR;
+
+	return nfields - ctx.remain;
+}
@@ -103,6 +103,8 @@ typedef struct {
 	JPEG_Mode			encMode;
 	uint8_t				jpgOutBufId;
 	uint8_t * 			jpgOutStmAddr[JPEG_BUFF_CNT_MAX];
+	uint8_t * 			jpgHdrAddr[JPEG_BUFF_CNT_MAX];	/* header written in front of each buffer */
+	uint8_t				jpgHdrQuality[JPEG_BUFF_CNT_MAX];
 	uint8_t 			jpgOutBufNum;
 	uint32_t 			jpgOutStmSize;
 	uint32_t			jpgMemSize;
@@ -110,6 +112,7 @@ typedef struct {
 
 	uint8_t				memPartEn;
 	uint8_t 			memPartNum;
+	uint8_t				memPartHold;
 	uint32_t			memPartSize;
 	uint32_t			memPartCnt;
 	uint32_t			memPartOffSet;
@@ -121,6 +124,9 @@ typedef struct {
 	CSI_JPEG_IRQCallback cb;
 
 	JpegCtx 			*jpegCtx;
+	uint8_t				quality;	/* quality of the frame being encoded */
+	uint8_t				nextQuality;
+	JpegRc				*rc;
 #ifdef CONFIG_PM
 	uint8_t suspend;
 	uint8_t *baseAddr;
@@ -198,6 +204,9 @@ __STATIC_INLINE void JPEG_MemPartTake(void)
 	HAL_SET_BIT(JPEG->VE_MODE_REG, 0x20000);
 }
 
+static void JPEG_ApplyQuality(uint32_t quality);
+static void JPEG_SyncHeader(void);
+
 static void CSI_JPEG_IRQHandler(void)
 {
 	uint32_t csi_int, jpe_int;
@@ -263,7 +272,8 @@ static void CSI_JPEG_IRQHandler(void)
 
 		if (priv->cb)
 			priv->cb(CSI_JPEG_EVENT_MPART, &mpart_info);
-		JPEG_MemPartTake();
+		if (!priv->memPartHold)
+			JPEG_MemPartTake();
 	}
 
 	if (jpe_int & JPEG_ENC_FINISH) {
@@ -304,6 +314,14 @@ static void CSI_JPEG_IRQHandler(void)
 		JPEG->OUTSTM_START_ADDR = (uint32_t)priv->jpgOutStmAddr[priv->jpgOutBufId];
 		JPEG->OUTSTM_END_ADDR = (uint32_t)priv->jpgOutStmAddr[priv->jpgOutBufId] + (priv->jpgMemSize - 1);
 
+		/* the encoder is idle until the next start, switch tables now */
+		if (priv->rc)
+			priv->nextQuality = JpegRcUpdate(priv->rc, encode_len);
+		if (priv->nextQuality != priv->quality)
+			JPEG_ApplyQuality(priv->nextQuality);
+		else
+			JPEG_SyncHeader();
+
 		if (priv->capRun && priv->encMode == JPEG_MOD_ONLINE)
 			JPEG_EncStart();
 
@@ -474,6 +492,8 @@ HAL_Status HAL_CSI_JPEG_Deinit(void)
 #endif
 	{
 		CSI_JPEG_SetPriv(NULL);
+		if (priv->rc)
+			HAL_Free(priv->rc);
 		HAL_Free(priv);
 		priv = NULL;
 	}
@@ -609,6 +629,38 @@ static void JPEG_WriteQtab(uint32_t base_addr)
 	}
 }
 
+/*
+ * Make the header in front of the buffer the next frame goes to describe the
+ * loaded tables. Headers of the other buffers still describe the frames they
+ * hold.
+ */
+static void JPEG_SyncHeader(void)
+{
+	CSI_JPEG_Priv *priv = CSI_JPEG_GetPriv();
+	uint8_t id = priv->jpgOutBufId;
+
+	if (!priv->jpgHdrAddr[id] || priv->jpgHdrQuality[id] == priv->quality)
+		return;
+
+	priv->jpegCtx->BaseAddr = (char *)priv->jpgHdrAddr[id];
+	priv->jpegCtx->ctl_ops->writeQuantTbl(priv->jpegCtx);
+	priv->jpgHdrQuality[id] = priv->quality;
+}
+
+/* Load the tables of another quality between two frames */
+static void JPEG_ApplyQuality(uint32_t quality)
+{
+	CSI_JPEG_Priv *priv = CSI_JPEG_GetPriv();
+
+	JPEG_SetQtab(quality);
+	JPEG->JPEG_PARA0_REG = 3<<30 | priv->jpegCtx->dc_value[1]<<16 | priv->jpegCtx->dc_value[0];
+	JPEG_WriteQtab(0x0);
+
+	priv->quality = quality;
+	priv->nextQuality = quality;
+	JPEG_SyncHeader();
+}
+
 HAL_Status HAL_JPEG_Config(JPEG_ConfigParam *cfg)
 {
 	uint32_t reg_val;
@@ -644,6 +696,9 @@ HAL_Status HAL_JPEG_Config(JPEG_ConfigParam *cfg)
 		return HAL_ERROR;
 	}
 #endif
+		/* a reconfiguration after an exception keeps the headers */
+		if (priv->jpgOutStmAddr[i] != (uint8_t*)cfg->outstream_buff_addr[i])
+			priv->jpgHdrAddr[i] = NULL;
 		priv->jpgOutStmAddr[i] = (uint8_t*)cfg->outstream_buff_addr[i];
 	}
 	//priv->jpgOutStmSize = priv->jpgMemSize / priv->jpgOutBufNum;
@@ -657,6 +712,7 @@ HAL_Status HAL_JPEG_Config(JPEG_ConfigParam *cfg)
 	priv->jpegCtx->image_width = cfg->pic_size_width;
 
 	priv->memPartEn = cfg->mem_part_en;
+	priv->memPartHold = cfg->mem_part_en && cfg->mem_part_hold;
 	if (priv->memPartEn) {
 		priv->memPartNum = 1 << (cfg->mem_part_num + 1);
 		priv->memPartSize = priv->jpgMemSize / priv->memPartNum;
@@ -728,7 +784,10 @@ HAL_Status HAL_JPEG_Config(JPEG_ConfigParam *cfg)
 			  ((1	& 0x1) << 0);
 	JPEG->VE_INT_EN_REG = reg_val;
 
-	JPEG_SetQtab(cfg->quality);
+	/* a reconfiguration keeps the quality the rate control has reached */
+	priv->quality = (priv->rc && priv->quality) ? priv->quality : cfg->quality;
+	priv->nextQuality = priv->quality;
+	JPEG_SetQtab(priv->quality);
 
 	JPEG->JPEG_PARA0_REG = 3<<30 | priv->jpegCtx->dc_value[1]<<16 | priv->jpegCtx->dc_value[0];
 	JPEG->JPEG_BITRATE_CTRL = cfg->jpeg_bitrate_en ? 0xC0000840 : 0x00000840;
@@ -738,6 +797,7 @@ HAL_Status HAL_JPEG_Config(JPEG_ConfigParam *cfg)
 
 	//priv->jpgOutStmAddr =  (uint8_t*)JPEG->OUTSTM_START_ADDR;
 	JPEG_WriteQtab(0x0);
+	JPEG_SyncHeader();
 
 	CSI_JPEG_REG_ALL(JPEG_REG_MASK);
 
@@ -767,6 +827,126 @@ void HAL_JPEG_WriteHeader(uint8_t *baseAddr)
 #endif
 	priv->jpegCtx->BaseAddr = (char*)baseAddr;
 	priv->jpegCtx->ctl_ops->writeHeader(priv->jpegCtx);
+
+	/* remember headers that sit right in front of an output buffer */
+	for (int i = 0; i < priv->jpgOutBufNum; i++) {
+		if ((uint8_t *)priv->jpegCtx->BaseAddr == priv->jpgOutStmAddr[i]) {
+			priv->jpgHdrAddr[i] = baseAddr;
+			priv->jpgHdrQuality[i] = priv->quality;
+		}
+	}
+}
+
+/**
+ * @brief Change the quality of the following frames.
+ * @note Takes effect at the next frame boundary while capturing. Not allowed
+ *       while the rate control is on.
+ * @param quality: 1~99
+ * @retval HAL_Status
+ */
+HAL_Status HAL_JPEG_SetQuality(uint32_t quality)
+{
+	CSI_JPEG_Priv *priv = CSI_JPEG_GetPriv();
+
+	if (!priv || !priv->jpegCtx || quality == 0 || quality > 99)
+		return HAL_INVALID;
+	if (priv->rc)
+		return HAL_BUSY;
+
+	unsigned long flags = HAL_EnterCriticalSection();
+	if (priv->state == CSI_STATE_BUSY)
+		priv->nextQuality = quality;
+	else if (quality != priv->quality)
+		JPEG_ApplyQuality(quality);
+	HAL_ExitCriticalSection(flags);
+
+	return HAL_OK;
+}
+
+uint32_t HAL_JPEG_GetQuality(void)
+{
+	CSI_JPEG_Priv *priv = CSI_JPEG_GetPriv();
+
+	return priv ? priv->quality : 0;
+}
+
+/**
+ * @brief Turn the closed loop rate control on or off.
+ * @note The controller runs at the end of each frame, before the next one is
+ *       started, and loads the quality it picks for that frame.
+ * @param param: NULL or mode JPEG_RC_OFF to turn it off. A zero quality
+ *               starts from the current one.
+ * @retval HAL_Status
+ */
+HAL_Status HAL_JPEG_SetRateCtrl(const JpegRcParam *param)
+{
+	CSI_JPEG_Priv *priv = CSI_JPEG_GetPriv();
+	JpegRc *rc = NULL, *old;
+	JpegRcParam p;
+
+	if (!priv || !priv->jpegCtx)
+		return HAL_ERROR;
+
+	if (param && param->mode != JPEG_RC_OFF) {
+		rc = HAL_Malloc(sizeof(JpegRc));
+		if (!rc) {
+			CSI_JPEG_ERR("rate ctrl malloc faild\n");
+			return HAL_ERROR;
+		}
+		p = *param;
+		if (p.quality == 0)
+			p.quality = priv->quality;
+		JpegRcInit(rc, &p);
+	}
+
+	unsigned long flags = HAL_EnterCriticalSection();
+	old = priv->rc;
+	priv->rc = rc;
+	if (rc) {
+		if (priv->state == CSI_STATE_BUSY)
+			priv->nextQuality = rc->quality;
+		else if (rc->quality != priv->quality)
+			JPEG_ApplyQuality(rc->quality);
+	}
+	HAL_ExitCriticalSection(flags);
+
+	if (old)
+		HAL_Free(old);
+
+	return HAL_OK;
+}
+
+/**
+ * @brief Tell the rate control how many encoded bytes wait to be sent, the
+ *        frames shrink until the consumer catches up.
+ */
+void HAL_JPEG_SetRateCtrlBacklog(uint32_t bytes)
+{
+	CSI_JPEG_Priv *priv = CSI_JPEG_GetPriv();
+
+	unsigned long flags = HAL_EnterCriticalSection();
+	if (priv && priv->rc)
+		JpegRcSetBacklog(priv->rc, bytes);
+	HAL_ExitCriticalSection(flags);
+}
+
+/**
+ * @brief Give a mem part passed by CSI_JPEG_EVENT_MPART back to the encoder.
+ * @note Only with mem_part_hold, then every part must be released once, in
+ *       the order they were received. The encoder does not wait for the last
+ *       part of a frame (tail set), it is reused once the following frames
+ *       wrap around the buffer, so it should be copied rather than held.
+ */
+void HAL_JPEG_MpartRelease(JPEG_MpartBuffInfo *info)
+{
+	CSI_JPEG_Priv *priv = CSI_JPEG_GetPriv();
+
+	if (!priv || !priv->memPartHold || info->tail)
+		return;
+
+	unsigned long flags = HAL_EnterCriticalSection();
+	JPEG_MemPartTake();
+	HAL_ExitCriticalSection(flags);
 }
 
 #endif
@@ -30,4 +30,80 @@
 #ifndef _DRIVER_CHIP_SDMMC__CORE_H_
 #define _DRIVER_CHIP_SDMMC__CORE_H_
 
+#include "driver/chip/sdmmc/card.h"
+#include "driver/chip/sdmmc/sdmmc.h"
+
+#include "_sdhost.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Request structures of the sdmmc core, they are passed to the core in ROM
+ * so the layout must not differ from the ROM one.
+ */
+struct mmc_data {
+	uint32_t blksz;         /* data block size */
+	uint32_t blocks;        /* number of blocks */
+	uint32_t flags;
+
+#define MMC_DATA_WRITE          (1 << 8)
+#define MMC_DATA_READ           (1 << 9)
+#define MMC_DATA_STREAM         (1 << 10)
+
+	uint32_t                bytes_xfered;
+	uint32_t                sg_len;         /* size of scatter list */
+	struct scatterlist      *sg;            /* I/O scatter list */
+};
+
+struct mmc_command {
+	uint32_t opcode;
+	uint32_t arg;
+	uint32_t resp[4];
+	uint32_t flags;                         /* expected response type */
+	/* data transfer */
+	volatile uint32_t stop        :1,
+	                  boot        :1,
+	                  vol_switch  :1;
+
+#define MMC_RSP_PRESENT         (1 << 0)
+#define MMC_RSP_136             (1 << 1)        /* 136 bit response */
+#define MMC_RSP_CRC             (1 << 2)        /* expect valid crc */
+#define MMC_RSP_BUSY            (1 << 3)        /* card may send busy */
+#define MMC_RSP_OPCODE          (1 << 4)        /* response contains opcode */
+
+#define MMC_CMD_AC              (0 << 5)        /* addressed comamnd without data transfer */
+#define MMC_CMD_ADTC            (1 << 5)        /* addressed command with data transfer */
+
+#define MMC_RSP_SPI_S1          (1 << 7)        /* one status byte */
+
+#define MMC_RSP_R1              (MMC_RSP_PRESENT|MMC_RSP_CRC|MMC_RSP_OPCODE)
+#define MMC_RSP_SPI_R1          (MMC_RSP_SPI_S1)
+
+#if ((defined CONFIG_USE_SD) || (defined CONFIG_USE_MMC))
+	uint32_t retries;               /* max number of retries */
+	uint32_t erase_timeout;         /* in milliseconds */
+#endif
+
+	struct mmc_data         *data;          /* data segment associated with cmd */
+};
+
+struct mmc_request {
+	struct mmc_command      *cmd;
+	struct mmc_data         *data;
+};
+
+extern int32_t mmc_wait_for_req(struct mmc_host *host, struct mmc_request *mrq);
+extern int32_t mmc_wait_for_cmd(struct mmc_host *host, struct mmc_command *cmd);
+extern int32_t mmc_send_status(struct mmc_card *card, uint32_t *status);
+extern int32_t mmc_app_cmd(struct mmc_host *host, struct mmc_card *card);
+#if ((defined CONFIG_USE_SD) || (defined CONFIG_USE_MMC))
+extern int mmc_set_blocklen(struct mmc_card *card, unsigned int blocklen);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* _DRIVER_CHIP_SDMMC__CORE_H_ */
@@ -59,6 +59,11 @@ extern "C" {
 #define SDXC_MAX_DES_NUM                (SDXC_MAX_TRANS_LEN >> SDXC_DES_NUM_SHIFT)      /* 2 is the least */
 #define SDXC_DES_MODE                   (0)             /* 0-chain mode, 1-fix length skip */
 
+struct scatterlist {
+	void *buffer;
+	uint32_t len;
+};
+
 /* IDMC structure */
 typedef struct {
 	uint32_t config;
@@ -285,5 +290,6 @@ extern int32_t __mci_program_clk(struct mmc_host *host);
 extern int32_t __mci_update_clock(struct mmc_host *host, uint32_t cclk);
 extern int32_t HAL_SDC_Claim_Host(struct mmc_host *host);
 extern void HAL_SDC_Release_Host(struct mmc_host *host);
+extern uint32_t HAL_SDC_Is_Busy(struct mmc_host *host);
 
 #endif /* _DRIVER_CHIP_SDMMC__SDHOST_H_ */
@@ -0,0 +1,636 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "kernel/os/os_thread.h"
+#include "kernel/os/os_mutex.h"
+#include "kernel/os/os_semaphore.h"
+#include "kernel/os/os_time.h"
+#include "sys/dma_heap.h"
+#include "driver/chip/hal_dcache.h"
+#include "driver/chip/hal_util.h"
+#include "driver/chip/hal_rtc.h"
+#include "driver/chip/sdmmc/hal_sdhost.h"
+#include "driver/chip/sdmmc/sdmmc.h"
+#include "driver/chip/sdmmc/mmc_queue.h"
+#include "driver/chip/private/hal_debug.h"
+
+#include "_sd_define.h"
+#include "_sdhost.h"
+#include "_core.h"
+
+#define MMC_QUEUE_BLK_SIZE              512
+#define MMC_QUEUE_BLK_MAX               (SDXC_MAX_TRANS_LEN / MMC_QUEUE_BLK_SIZE)
+
+/*
+ * The controller has no interrupt for the end of the busy signal, poll it
+ * for a while first since most writes are programmed well within 1 ms.
+ */
+#define MMC_QUEUE_BUSY_SPIN_US          300
+#define MMC_QUEUE_BUSY_POLL_US          5
+
+#define MMC_QUEUE_R1_ERR                (R1_OUT_OF_RANGE | R1_ADDRESS_ERROR | \
+                                         R1_WP_VIOLATION | R1_CARD_ECC_FAILED | \
+                                         R1_CC_ERROR | R1_ERROR)
+
+#define MMC_QUEUE_THREAD_STACK_SIZE     (2 * 1024)
+
+#if ((defined __CONFIG_PSRAM_ALL_CACHEABLE) && (defined __CONFIG_PSRAM))
+#define MMC_QUEUE_BOUNCE
+#endif
+
+/*
+ * One data command. It covers the rest of the request at the queue head and
+ * the requests merged after it, the last one may be continued by the next
+ * command.
+ */
+struct mmc_queue_cmd {
+	uint32_t sblk;
+	uint32_t nblk;
+	uint8_t write;
+	uint8_t sg_len;
+	int32_t err;                            /* set if preparing failed */
+	struct mmc_queue_req *done;             /* requests ending with this command */
+	struct mmc_queue_req *part;             /* request continued by the next one */
+	struct scatterlist sg[SDXC_MAX_DES_NUM];
+#ifdef MMC_QUEUE_BOUNCE
+	void *orig[SDXC_MAX_DES_NUM];           /* caller buffers of bounced entries */
+	uint8_t *bounce;
+#endif
+};
+
+struct mmc_queue {
+	struct mmc_card *card;
+	uint32_t flags;
+	OS_Thread_t thread;
+	OS_Mutex_t lock;
+	OS_Semaphore_t wake;
+
+	/* pending requests, the head may be partly issued already */
+	struct mmc_queue_req *head;
+	struct mmc_queue_req *tail;
+	uint32_t seg_idx;
+	uint32_t seg_off;
+	uint32_t blk_off;
+	uint8_t exit;
+
+	int32_t barrier_err;
+	struct mmc_queue_cmd cmd[2];
+	struct mmc_queue_stats stats;
+};
+
+static void mmc_queue_pop(struct mmc_queue *q, struct mmc_queue_req ***done)
+{
+	struct mmc_queue_req *req = q->head;
+
+	q->head = req->next;
+	if (q->head == NULL)
+		q->tail = NULL;
+	q->seg_idx = 0;
+	q->seg_off = 0;
+	q->blk_off = 0;
+
+	req->next = NULL;
+	**done = req;
+	*done = &req->next;
+}
+
+/* Take the next command off the pending requests, called with the lock held */
+static int mmc_queue_build(struct mmc_queue *q, struct mmc_queue_cmd *cmd)
+{
+	struct mmc_queue_req *req = q->head;
+	struct mmc_queue_req **done = &cmd->done;
+	struct mmc_queue_seg *seg;
+	uint32_t desc = 0;
+	uint32_t room, piece, n;
+
+	if (req == NULL)
+		return 0;
+
+	cmd->sblk = req->sblk + q->blk_off;
+	cmd->nblk = 0;
+	cmd->write = req->write;
+	cmd->sg_len = 0;
+	cmd->err = 0;
+	cmd->done = NULL;
+	cmd->part = NULL;
+
+	while (req) {
+		if (req->nblk == 0) { /* barrier */
+			mmc_queue_pop(q, &done);
+			break;
+		}
+		if (cmd->nblk && (!(q->flags & MMC_QUEUE_F_MERGE) ||
+		                  req->write != cmd->write ||
+		                  req->sblk != cmd->sblk + cmd->nblk ||
+		                  cmd->nblk == MMC_QUEUE_BLK_MAX ||
+		                  desc == SDXC_MAX_DES_NUM))
+			break;
+
+		while (q->seg_idx < req->seg_cnt) {
+			room = MMC_QUEUE_BLK_MAX - cmd->nblk;
+			if (room == 0 || desc == SDXC_MAX_DES_NUM) {
+				cmd->part = req;
+				return 1;
+			}
+			seg = &req->seg[q->seg_idx];
+			piece = seg->len - q->seg_off;
+			if (piece > room * MMC_QUEUE_BLK_SIZE)
+				piece = room * MMC_QUEUE_BLK_SIZE;
+			/* the host splits each entry into descriptors of 8K */
+			n = (piece + SDXC_DES_BUFFER_MAX_LEN - 1) >> SDXC_DES_NUM_SHIFT;
+			if (desc + n > SDXC_MAX_DES_NUM) {
+				n = SDXC_MAX_DES_NUM - desc;
+				piece = n << SDXC_DES_NUM_SHIFT;
+			}
+
+			cmd->sg[cmd->sg_len].buffer = (uint8_t *)seg->buf + q->seg_off;
+			cmd->sg[cmd->sg_len].len = piece;
+			cmd->sg_len++;
+			desc += n;
+			cmd->nblk += piece / MMC_QUEUE_BLK_SIZE;
+			q->blk_off += piece / MMC_QUEUE_BLK_SIZE;
+			q->seg_off += piece;
+			if (q->seg_off == seg->len) {
+				q->seg_idx++;
+				q->seg_off = 0;
+			}
+		}
+
+		if (cmd->done)
+			q->stats.merged++;
+		mmc_queue_pop(q, &done);
+		req = q->head;
+	}
+
+	return 1;
+}
+
+/* Move cacheable buffers out of the way of the DMA */
+static void mmc_queue_prepare(struct mmc_queue_cmd *cmd)
+{
+#ifdef MMC_QUEUE_BOUNCE
+	uint32_t i;
+	uint32_t len = 0;
+	uint8_t *p;
+
+	cmd->bounce = NULL;
+	for (i = 0; i < cmd->sg_len; i++) {
+		cmd->orig[i] = NULL;
+		if (HAL_Dcache_IsCacheable((uint32_t)cmd->sg[i].buffer, cmd->sg[i].len))
+			len += cmd->sg[i].len;
+	}
+	if (len == 0)
+		return;
+
+	cmd->bounce = dma_malloc(len, DMAHEAP_PSRAM);
+	if (cmd->bounce == NULL) {
+		HAL_ERR("dma_malloc failed\n");
+		cmd->err = -1;
+		return;
+	}
+
+	p = cmd->bounce;
+	for (i = 0; i < cmd->sg_len; i++) {
+		if (!HAL_Dcache_IsCacheable((uint32_t)cmd->sg[i].buffer, cmd->sg[i].len))
+			continue;
+		cmd->orig[i] = cmd->sg[i].buffer;
+		if (cmd->write)
+			HAL_Memcpy(p, cmd->orig[i], cmd->sg[i].len);
+		cmd->sg[i].buffer = p;
+		p += cmd->sg[i].len;
+	}
+#endif
+}
+
+static void mmc_queue_unprepare(struct mmc_queue_cmd *cmd, int32_t err)
+{
+#ifdef MMC_QUEUE_BOUNCE
+	uint32_t i;
+
+	if (cmd->bounce == NULL)
+		return;
+
+	for (i = 0; i < cmd->sg_len; i++) {
+		if (cmd->orig[i] && !cmd->write && !err)
+			HAL_Memcpy(cmd->orig[i], cmd->sg[i].buffer, cmd->sg[i].len);
+	}
+	dma_free(cmd->bounce, DMAHEAP_PSRAM);
+	cmd->bounce = NULL;
+#endif
+}
+
+static int32_t mmc_queue_ac_cmd(struct mmc_host *host, uint32_t opcode, uint32_t arg)
+{
+	struct mmc_command cmd = {0};
+
+	cmd.opcode = opcode;
+	cmd.arg = arg;
+	cmd.flags = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_AC;
+
+	return mmc_wait_for_cmd(host, &cmd);
+}
+
+static int32_t mmc_queue_issue(struct mmc_queue *q, struct mmc_queue_cmd *c)
+{
+	struct mmc_card *card = q->card;
+	struct mmc_host *host = card->host;
+	struct mmc_command cmd = {0};
+	struct mmc_data data = {0};
+	struct mmc_request mrq;
+
+	if (card->suspend) {
+		HAL_WRN("card %d has suspend\n", card->id);
+		return -1;
+	}
+
+	if (mmc_set_blocklen(card, MMC_QUEUE_BLK_SIZE))
+		return -1;
+
+	if (c->nblk > 1) {
+		cmd.stop = 1;
+		if ((q->flags & MMC_QUEUE_F_SBC) && mmc_card_sd(card) &&
+		    (card->scr.cmds & SD_SCR_CMD23_SUPPORT)) {
+			/* the card stops by itself, no CMD12 and no busy after it */
+			if (mmc_queue_ac_cmd(host, MMC_SET_BLOCK_COUNT, c->nblk))
+				return -1;
+			q->stats.sbc++;
+			cmd.stop = 0;
+		} else if (c->write && (q->flags & MMC_QUEUE_F_PRE_ERASE) &&
+		           c->nblk >= MMC_QUEUE_PRE_ERASE_MIN && mmc_card_sd(card)) {
+			/* only a hint, go on without it */
+			if (mmc_app_cmd(host, card) == 0 &&
+			    mmc_queue_ac_cmd(host, SD_APP_SET_WR_BLK_ERASE_COUNT, c->nblk) == 0)
+				q->stats.pre_erase++;
+		}
+		cmd.opcode = c->write ? MMC_WRITE_MULTIPLE_BLOCK : MMC_READ_MULTIPLE_BLOCK;
+	} else {
+		cmd.opcode = c->write ? MMC_WRITE_SINGLE_BLOCK : MMC_READ_SINGLE_BLOCK;
+	}
+	cmd.arg = c->sblk;
+	if (!mmc_card_blockaddr(card))
+		cmd.arg <<= 9;
+	cmd.flags = MMC_RSP_R1 | MMC_CMD_ADTC;
+
+	data.blksz = MMC_QUEUE_BLK_SIZE;
+	data.blocks = c->nblk;
+	data.flags = c->write ? MMC_DATA_WRITE : MMC_DATA_READ;
+	data.sg = c->sg;
+	data.sg_len = c->sg_len;
+
+	mrq.cmd = &cmd;
+	mrq.data = &data;
+
+	if (mmc_wait_for_req(host, &mrq)) {
+		HAL_ERR("%s sector:%x cnt:%u err\n",
+		        c->write ? "W" : "R", c->sblk, c->nblk);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Wait for the card to finish programming, with the host claimed */
+static int32_t mmc_queue_wait_busy(struct mmc_queue *q)
+{
+	struct mmc_card *card = q->card;
+	OS_Time_t end = OS_GetTicks() + OS_MSecsToTicks(MMC_QUEUE_BUSY_TIMEOUT_MS);
+	uint64_t start = HAL_RTC_GetFreeRunTime();
+	uint32_t spin = 0;
+	uint32_t status = 0;
+	uint32_t us;
+	int slept = 0;
+
+	while (1) {
+		if (HAL_SDC_Is_Busy(card->host)) {
+			if (spin < MMC_QUEUE_BUSY_SPIN_US) {
+				HAL_UDelay(MMC_QUEUE_BUSY_POLL_US);
+				spin += MMC_QUEUE_BUSY_POLL_US;
+				continue;
+			}
+		} else {
+			if (mmc_send_status(card, &status))
+				return -1;
+			if ((status & R1_READY_FOR_DATA) &&
+			    R1_CURRENT_STATE(status) != R1_STATE_PRG)
+				break;
+		}
+		if (OS_TimeAfter(OS_GetTicks(), end)) {
+			HAL_ERR("busy timeout\n");
+			return -1;
+		}
+		slept = 1;
+		OS_MSleep(1);
+	}
+
+	us = (uint32_t)(HAL_RTC_GetFreeRunTime() - start);
+	if (us > q->stats.busy_max)
+		q->stats.busy_max = us;
+	if (slept)
+		q->stats.busy_sleep++;
+
+	if (status & MMC_QUEUE_R1_ERR) {
+		HAL_ERR("status %x\n", status);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void mmc_queue_complete(struct mmc_queue *q, struct mmc_queue_cmd *cmd, int32_t err)
+{
+	struct mmc_queue_req *req;
+	struct mmc_queue_req *next;
+
+	mmc_queue_unprepare(cmd, err);
+
+	if (cmd->nblk) {
+		q->stats.cmd++;
+		if (err)
+			q->stats.err++;
+		else
+			q->stats.blocks += cmd->nblk;
+	}
+	if (err && cmd->part && !cmd->part->err)
+		cmd->part->err = err;
+
+	for (req = cmd->done; req; req = next) {
+		next = req->next;
+		if (req->nblk == 0) {
+			req->err = q->barrier_err;
+			q->barrier_err = 0;
+		} else {
+			if (err && !req->err)
+				req->err = err;
+			if (req->err)
+				q->barrier_err = -1;
+			q->stats.req++;
+		}
+		if (req->done)
+			req->done(req, req->err);
+	}
+}
+
+static int mmc_queue_take(struct mmc_queue *q, struct mmc_queue_cmd *cmd)
+{
+	int ret;
+
+	OS_MutexLock(&q->lock, OS_WAIT_FOREVER);
+	ret = mmc_queue_build(q, cmd);
+	OS_MutexUnlock(&q->lock);
+	if (ret)
+		mmc_queue_prepare(cmd);
+
+	return ret;
+}
+
+static void mmc_queue_task(void *arg)
+{
+	struct mmc_queue *q = arg;
+	struct mmc_host *host = q->card->host;
+	struct mmc_queue_cmd *cur = &q->cmd[0];
+	struct mmc_queue_cmd *next = &q->cmd[1];
+	struct mmc_queue_cmd *tmp;
+	int ready = 0;
+	int next_ready;
+	int32_t err;
+
+	while (1) {
+		if (!ready) {
+			ready = mmc_queue_take(q, cur);
+			if (!ready) {
+				if (q->exit)
+					break;
+				OS_SemaphoreWait(&q->wake, OS_WAIT_FOREVER);
+				continue;
+			}
+		}
+
+		err = cur->err;
+		next_ready = 0;
+		if (cur->nblk && !err) {
+			HAL_SDC_Claim_Host(host);
+			err = mmc_queue_issue(q, cur);
+			if (!err && cur->write) {
+				/* the card is programming, get the next command ready meanwhile */
+				next_ready = mmc_queue_take(q, next);
+				err = mmc_queue_wait_busy(q);
+			}
+			HAL_SDC_Release_Host(host);
+		}
+		mmc_queue_complete(q, cur, err);
+
+		tmp = cur;
+		cur = next;
+		next = tmp;
+		ready = next_ready;
+	}
+
+	OS_ThreadDelete(&q->thread);
+}
+
+struct mmc_queue *mmc_queue_create(struct mmc_card *card, uint32_t flags, uint32_t prio)
+{
+	struct mmc_queue *q;
+
+	if (card == NULL || card->host == NULL) {
+		HAL_ERR("card not exist\n");
+		return NULL;
+	}
+
+	q = malloc(sizeof(struct mmc_queue));
+	if (q == NULL) {
+		HAL_ERR("no mem\n");
+		return NULL;
+	}
+	memset(q, 0, sizeof(struct mmc_queue));
+	q->card = card;
+	q->flags = flags;
+
+	if (OS_MutexCreate(&q->lock) != OS_OK)
+		goto err_mutex;
+	if (OS_SemaphoreCreateBinary(&q->wake) != OS_OK)
+		goto err_sem;
+	if (OS_ThreadCreate(&q->thread, "mmc_queue", mmc_queue_task, q,
+	                    (OS_Priority)prio, MMC_QUEUE_THREAD_STACK_SIZE) != OS_OK) {
+		HAL_ERR("create thread failed\n");
+		goto err_thread;
+	}
+
+	return q;
+
+err_thread:
+	OS_SemaphoreDelete(&q->wake);
+err_sem:
+	OS_MutexDelete(&q->lock);
+err_mutex:
+	free(q);
+	return NULL;
+}
+
+void mmc_queue_destroy(struct mmc_queue *q)
+{
+	if (q == NULL)
+		return;
+
+	OS_MutexLock(&q->lock, OS_WAIT_FOREVER);
+	q->exit = 1;
+	OS_MutexUnlock(&q->lock);
+	OS_SemaphoreRelease(&q->wake);
+	while (OS_ThreadIsValid(&q->thread))
+		OS_MSleep(1);
+
+	OS_SemaphoreDelete(&q->wake);
+	OS_MutexDelete(&q->lock);
+	free(q);
+}
+
+int32_t mmc_queue_submit(struct mmc_queue *q, struct mmc_queue_req *req)
+{
+	uint32_t len = 0;
+	uint32_t i;
+
+	if (q == NULL || req == NULL)
+		return -1;
+
+	if (req->nblk) {
+		if (req->seg == NULL || req->seg_cnt == 0 ||
+		    req->seg_cnt > MMC_QUEUE_SEG_MAX) {
+			HAL_ERR("bad segments\n");
+			return -1;
+		}
+		for (i = 0; i < req->seg_cnt; i++) {
+			if (req->seg[i].len == 0 ||
+			    (req->seg[i].len & (MMC_QUEUE_BLK_SIZE - 1))) {
+				HAL_ERR("seg %u len %u\n", i, req->seg[i].len);
+				return -1;
+			}
+			len += req->seg[i].len;
+		}
+		if (len != req->nblk * MMC_QUEUE_BLK_SIZE) {
+			HAL_ERR("len %u of %u blocks\n", len, req->nblk);
+			return -1;
+		}
+	}
+
+	req->next = NULL;
+	req->err = 0;
+
+	OS_MutexLock(&q->lock, OS_WAIT_FOREVER);
+	if (q->exit) {
+		OS_MutexUnlock(&q->lock);
+		return -1;
+	}
+	if (q->tail)
+		q->tail->next = req;
+	else
+		q->head = req;
+	q->tail = req;
+	OS_MutexUnlock(&q->lock);
+
+	OS_SemaphoreRelease(&q->wake);
+
+	return 0;
+}
+
+static void mmc_queue_sync_done(struct mmc_queue_req *req, int32_t err)
+{
+	OS_SemaphoreRelease((OS_Semaphore_t *)req->arg);
+}
+
+static int32_t mmc_queue_sync(struct mmc_queue *q, struct mmc_queue_req *req)
+{
+	OS_Semaphore_t sem;
+	int32_t err = -1;
+
+	if (OS_SemaphoreCreateBinary(&sem) != OS_OK)
+		return -1;
+
+	req->done = mmc_queue_sync_done;
+	req->arg = &sem;
+	if (mmc_queue_submit(q, req) == 0) {
+		OS_SemaphoreWait(&sem, OS_WAIT_FOREVER);
+		err = req->err;
+	}
+	OS_SemaphoreDelete(&sem);
+
+	return err;
+}
+
+int32_t mmc_queue_flush(struct mmc_queue *q)
+{
+	struct mmc_queue_req req;
+
+	memset(&req, 0, sizeof(req));
+
+	return mmc_queue_sync(q, &req);
+}
+
+static int32_t mmc_queue_rw(struct mmc_queue *q, uint8_t *buf, uint32_t sblk,
+                            uint32_t nblk, uint8_t write)
+{
+	struct mmc_queue_seg seg;
+	struct mmc_queue_req req;
+
+	if (nblk == 0)
+		return 0;
+
+	seg.buf = buf;
+	seg.len = nblk * MMC_QUEUE_BLK_SIZE;
+	memset(&req, 0, sizeof(req));
+	req.sblk = sblk;
+	req.nblk = nblk;
+	req.write = write;
+	req.seg_cnt = 1;
+	req.seg = &seg;
+
+	return mmc_queue_sync(q, &req);
+}
+
+int32_t mmc_queue_read(struct mmc_queue *q, uint8_t *buf, uint32_t sblk, uint32_t nblk)
+{
+	return mmc_queue_rw(q, buf, sblk, nblk, 0);
+}
+
+int32_t mmc_queue_write(struct mmc_queue *q, const uint8_t *buf, uint32_t sblk, uint32_t nblk)
+{
+	return mmc_queue_rw(q, (uint8_t *)buf, sblk, nblk, 1);
+}
+
+void mmc_queue_get_stats(struct mmc_queue *q, struct mmc_queue_stats *stats)
+{
+	if (q == NULL || stats == NULL)
+		return;
+
+	OS_MutexLock(&q->lock, OS_WAIT_FOREVER);
+	memcpy(stats, &q->stats, sizeof(*stats));
+	OS_MutexUnlock(&q->lock);
+}
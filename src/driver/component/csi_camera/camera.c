@@ -38,6 +38,7 @@
 #include "driver/component/csi_camera/camera.h"
 #include "driver/component/csi_camera/private/camera_debug.h"
 #include "kernel/os/os_mutex.h"
+#include "sys/interrupt.h"
 
 typedef struct {
 	uint8_t cap_mode;	/* 0:still	1:video */
@@ -52,6 +53,7 @@ typedef struct {
 	SENSOR_ConfigParam sensor_param;
 	CAMERA_OutFmt out_fmt;
 	CAMERA_CapStatusCb cb;
+	CAMERA_MpartHook mpart_hook;
 } CAMERA_Private;
 
 static CAMERA_Private *gCameraPrivate;
@@ -71,6 +73,7 @@ static JPEG_ConfigParam gJpegParam = {
 	.pic_size_height = 480,
 	.mem_part_en = 0,
 	.mem_part_num = 0,
+	.mem_part_hold = 0,
 	.outstream_buff_size = 0,
 	.outstream_buff_num = 0,
 	.outstream_buff_addr[0] = 0, /* JPEG_OUTSTM_ADDR */
@@ -122,11 +125,15 @@ static void CAMERA_CsiJpegIrq(CSI_JPEG_IRQEvent event, void *arg)
 		release = 1;
 	}  else if (event == CSI_JPEG_EVENT_MPART) {
 		status = CAMERA_STATUS_MPART;
+		if (priv->mpart_hook && priv->mpart_hook(status, info, priv->mem_mgmt))
+			return;
 	} else {
 		CAMERA_ERR("csi jpeg excption\n");
 		HAL_JPEG_Reset();
 		HAL_JPEG_Config(&gJpegParam);
 		HAL_CSI_Config(&gCsiParam);
+		if (priv->mpart_hook)
+			priv->mpart_hook(status, info, priv->mem_mgmt);
 	}
 	if (priv->cb)
 		priv->cb(status, info);
@@ -206,6 +213,7 @@ HAL_Status CAMERA_ConfigJpeg(CAMERA_JpegCfg *jpeg_cfg)
 	gJpegParam.quality = jpeg_cfg->quality;		/* 0~99 */
 	gJpegParam.mem_part_en = jpeg_cfg->memPartEn;
 	gJpegParam.mem_part_num = jpeg_cfg->memPartNum;
+	gJpegParam.mem_part_hold = jpeg_cfg->memPartHold;
 	gJpegParam.sensor_out_type = 0;	/* 0:OUT_YUV420  1:OUT_JPEG  2:RAW , is csi out type */
 	gJpegParam.pic_size_width = jpeg_cfg->width;
 	gJpegParam.pic_size_height = jpeg_cfg->height;
@@ -614,3 +622,77 @@ int HAL_CAMERA_IoCtl(CAMERA_IoctrlCmd cmd, uint32_t arg)
 	return 0;
 }
 
+/**
+ * @brief Change the jpeg quality, takes effect at the next frame.
+ * @param quality: 1~99.
+ * @retval 0 : on success, -1 : fail, or the rate control is on.
+ */
+int HAL_CAMERA_SetQuality(uint32_t quality)
+{
+	if (HAL_JPEG_SetQuality(quality) != HAL_OK) {
+		CAMERA_ERR("set quality %u fail\n", quality);
+		return -1;
+	}
+	gJpegParam.quality = quality;
+	return 0;
+}
+
+/**
+ * @brief Turn the jpeg frame size/bitrate control on or off.
+ * @param param: NULL to turn it off.
+ * @retval 0 : on success, -1 : fail.
+ */
+int HAL_CAMERA_SetRateCtrl(const JpegRcParam *param)
+{
+	JpegRcParam p;
+
+	if (param && param->mode != JPEG_RC_OFF) {
+		p = *param;
+		/* frames larger than the buffer are truncated without mem part */
+		if (!p.max_size && !gJpegParam.mem_part_en)
+			p.max_size = gJpegParam.outstream_buff_size;
+		param = &p;
+	}
+	return ((HAL_JPEG_SetRateCtrl(param) == HAL_OK) ? 0 : -1);
+}
+
+/**
+ * @brief Give a mem part back to the encoder when memPartHold is set.
+ * @note Every CAMERA_STATUS_MPART must be released once, in order, the
+ *       encoder stops when all parts are held.
+ */
+void HAL_CAMERA_MpartRelease(CAMERA_MpartBuffInfo *info)
+{
+	HAL_JPEG_MpartRelease(info);
+}
+
+int CAMERA_SetMpartHook(CAMERA_MpartHook hook)
+{
+	CAMERA_Private *priv = CAMERA_GetPriv();
+	if (!priv) {
+		CAMERA_ERR("not init\n");
+		return -1;
+	}
+	if (hook && !(gJpegParam.mem_part_en && gJpegParam.mem_part_hold)) {
+		CAMERA_ERR("need mem part with memPartHold\n");
+		return -1;
+	}
+
+	unsigned long flags = arch_irq_save();
+	if (hook && priv->mpart_hook) {
+		arch_irq_restore(flags);
+		return -1;
+	}
+	priv->mpart_hook = hook;
+	arch_irq_restore(flags);
+
+	return 0;
+}
+
+/* Largest mem part, the tail of a frame never exceeds it */
+uint32_t CAMERA_GetMpartSize(void)
+{
+	if (!gJpegParam.mem_part_en)
+		return 0;
+	return gJpegParam.outstream_buff_size >> (gJpegParam.mem_part_num + 1);
+}
@@ -0,0 +1,734 @@
+/**
+  * @file  camera_stream.c
+  * @author  XRADIO IOT WLAN Team
+  */
+
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "kernel/os/os.h"
+#include "sys/interrupt.h"
+#include "lwip/tcpip.h"
+#include "lwip/tcp.h"
+#include "driver/component/csi_camera/camera.h"
+#include "driver/component/csi_camera/camera_stream.h"
+#include "driver/component/csi_camera/private/camera_debug.h"
+
+/*
+ * The encoder does not reuse a held mem part before it is released, so the
+ * parts are queued to TCP without TCP_WRITE_FLAG_COPY and released once the
+ * client acked them. The capture interrupt records the parts in a ring and
+ * decides at the start of each frame whether the client can take it, all
+ * the rest runs in the tcpip thread through a preallocated callback message.
+ * Only the frame header, which is rewritten when the quality changes, and
+ * the last part of a frame, which the encoder does not wait for, are copied
+ * by the interrupt into one of the frame slots.
+ *
+ * At most all the mem parts plus the last part of the frames in the slots
+ * are in flight, so the ring cannot overflow. The encoder stops while every
+ * part is held: a client that does not ack for STREAM_STALL_POLL is dropped,
+ * and always aborted rather than closed so that TCP lets go of the parts.
+ */
+
+#define STREAM_RING_NUM			16	/* parts in flight, power of 2 */
+#define STREAM_SLOT_NUM			2	/* frames in flight */
+#define STREAM_BACKLOG_DEF		(32 * 1024)
+#define STREAM_STALL_POLL		4	/* tcp poll intervals (500 ms) without progress */
+
+#define STREAM_BOUNDARY			"xrframe"
+
+#define SPAN_FIRST				(1 << 0)
+#define SPAN_TAIL				(1 << 1)	/* last part, or frame cut by an exception */
+#define SPAN_SKIP				(1 << 2)	/* only to be released */
+#define SPAN_HOLD				(1 << 3)	/* mem part held from the encoder */
+
+enum {
+	STREAM_ST_IDLE = 0,
+	STREAM_ST_REQ,		/* client connected, reading the request */
+	STREAM_ST_RUN,
+};
+
+enum {
+	STREAM_STAGE_PART = 0,	/* part headers */
+	STREAM_STAGE_HDR,		/* jpeg header */
+	STREAM_STAGE_DATA,
+	STREAM_STAGE_BOUNDARY,
+};
+
+struct stream_span {
+	uint8_t		*addr;
+	uint32_t	size;
+	uint32_t	end;		/* bytes written once the span is passed */
+	uint8_t		flags;
+	uint8_t		slot;
+	uint8_t		gen;		/* encoder exceptions */
+	uint8_t		conn;		/* clients */
+};
+
+struct camera_stream {
+	CAMERA_StreamCfg	cfg;
+	uint32_t			part_size;
+	OS_Semaphore_t		done;
+	struct tcpip_callback_msg *msg;
+	volatile uint8_t	msg_pending;
+	volatile uint8_t	stop_req;
+	uint8_t				opened;
+	err_t				err;
+
+	struct tcp_pcb		*listen;
+	struct tcp_pcb		*client;
+	volatile uint8_t	state;
+	volatile uint8_t	conn;
+	uint8_t				req_match;	/* chars of the request end seen */
+	uint8_t				poll_idle;
+	uint32_t			poll_acked;
+
+	/* in is moved by the interrupt, sent and rel by the tcpip thread */
+	struct stream_span	ring[STREAM_RING_NUM];
+	volatile uint8_t	in;
+	uint8_t				sent;
+	volatile uint8_t	rel;
+	uint8_t				stage;		/* of ring[sent] */
+	uint8_t				in_part;	/* part headers of a frame sent */
+	uint32_t			off;		/* data of ring[sent] written */
+
+	/* interrupt side */
+	uint8_t				frame;		/* 0: between frames, 1: sending, 2: skipping */
+	uint8_t				frame_slot;
+	uint8_t				frame_conn;
+	volatile uint8_t	gen;
+	volatile uint8_t	slot_busy[STREAM_SLOT_NUM];
+	uint8_t				*slot_hdr[STREAM_SLOT_NUM];
+	uint8_t				*slot_tail[STREAM_SLOT_NUM];
+
+	volatile uint32_t	written;
+	volatile uint32_t	acked;
+	CAMERA_StreamStats	stats;
+};
+
+static struct camera_stream *g_stream;
+
+static const char stream_resp[] =
+	"HTTP/1.1 200 OK\r\n"
+	"Content-Type: multipart/x-mixed-replace; boundary=" STREAM_BOUNDARY "\r\n"
+	"Cache-Control: no-cache\r\n"
+	"Connection: close\r\n"
+	"\r\n"
+	"--" STREAM_BOUNDARY "\r\n";
+static const char stream_part[] = "Content-Type: image/jpeg\r\n\r\n";
+static const char stream_boundary[] = "\r\n--" STREAM_BOUNDARY "\r\n";
+static const char stream_req_end[] = "\r\n\r\n";
+
+#define STREAM_SPAN(s, i)		(&(s)->ring[(i) & (STREAM_RING_NUM - 1)])
+
+/* Queue the callback from the interrupt or any thread, the message is
+ * preallocated so it must never be queued twice. */
+static void stream_post(struct camera_stream *s)
+{
+	unsigned long flags = arch_irq_save();
+	if (s->msg_pending) {
+		arch_irq_restore(flags);
+		return;
+	}
+	s->msg_pending = 1;
+	arch_irq_restore(flags);
+
+	if (tcpip_trycallback(s->msg) != ERR_OK)
+		s->msg_pending = 0;
+}
+
+/* ------------------------------------------------------------------------ *
+ * capture interrupt
+ * ------------------------------------------------------------------------ */
+
+static int stream_admit(struct camera_stream *s)
+{
+	uint32_t backlog = s->written - s->acked;
+	int i;
+
+	if (s->state != STREAM_ST_RUN) {
+		HAL_JPEG_SetRateCtrlBacklog(0);
+		return -1;
+	}
+	HAL_JPEG_SetRateCtrlBacklog(backlog);
+	if (backlog <= s->cfg.max_backlog) {
+		for (i = 0; i < STREAM_SLOT_NUM; i++) {
+			if (!s->slot_busy[i])
+				return i;
+		}
+	}
+	s->stats.skipped++;
+	return -1;
+}
+
+static struct stream_span *stream_push(struct camera_stream *s)
+{
+	if ((uint8_t)(s->in - s->rel) >= STREAM_RING_NUM)
+		return NULL;
+	return STREAM_SPAN(s, s->in);
+}
+
+static int stream_mpart_hook(CAMERA_CapStatus status, CAMERA_MpartBuffInfo *info,
+                             CAMERA_Mgmt *mgmt)
+{
+	struct camera_stream *s = g_stream;
+	struct stream_span *span;
+	uint8_t *addr;
+	uint32_t size;
+	uint8_t flags = 0;
+	int slot;
+
+	if (status == CAMERA_STATUS_EXCP) {
+		/* the parts are lost, close the part the client is receiving */
+		if (s->frame == 1 && (span = stream_push(s)) != NULL) {
+			span->addr = NULL;
+			span->size = 0;
+			span->flags = SPAN_TAIL;
+			span->slot = s->frame_slot;
+			span->gen = s->gen;
+			span->conn = s->frame_conn;
+			s->in++;
+		}
+		s->frame = 0;
+		s->gen++;
+		stream_post(s);
+		return 0;
+	}
+
+	addr = mgmt->jpeg_buf[info->buff_index].addr + info->buff_offset;
+	size = info->size;
+
+	if (s->frame == 0) {
+		slot = stream_admit(s);
+		if (slot >= 0) {
+			s->slot_busy[slot] = 1;
+			s->frame_slot = slot;
+			s->frame_conn = s->conn;
+			memcpy(s->slot_hdr[slot],
+			       mgmt->jpeg_buf[info->buff_index].addr - CAMERA_JPEG_HEADER_LEN,
+			       CAMERA_JPEG_HEADER_LEN);
+			flags = SPAN_FIRST;
+		}
+		s->frame = (slot >= 0) ? 1 : 2;
+	}
+
+	if (s->frame == 2) {
+		if (info->tail) {
+			s->frame = 0;
+			return 1;
+		}
+		/* parts go back in order, behind the ones still sent */
+		if (s->in == s->rel) {
+			HAL_CAMERA_MpartRelease(info);
+			return 1;
+		}
+		flags = SPAN_SKIP;
+		size = 0;
+	}
+
+	if (info->tail) {
+		/* the encoder does not wait for it */
+		if (size > s->part_size)
+			size = s->part_size;
+		memcpy(s->slot_tail[s->frame_slot], addr, size);
+		addr = s->slot_tail[s->frame_slot];
+		flags |= SPAN_TAIL;
+		s->frame = 0;
+	} else {
+		flags |= SPAN_HOLD;
+	}
+
+	span = stream_push(s);
+	if (span == NULL) { /* cannot happen, see above */
+		HAL_CAMERA_MpartRelease(info);
+		return 1;
+	}
+	span->addr = addr;
+	span->size = size;
+	span->flags = flags;
+	span->slot = s->frame_slot;
+	span->gen = s->gen;
+	span->conn = s->frame_conn;
+	s->in++;
+	stream_post(s);
+	return 1;
+}
+
+/* ------------------------------------------------------------------------ *
+ * tcpip thread
+ * ------------------------------------------------------------------------ */
+
+/* Give back the parts the client acked, or that were not sent at all */
+static void stream_release(struct camera_stream *s)
+{
+	CAMERA_MpartBuffInfo info;
+	struct stream_span *span;
+
+	memset(&info, 0, sizeof(info));
+	while (s->rel != s->sent) {
+		span = STREAM_SPAN(s, s->rel);
+		if ((int32_t)(s->acked - span->end) < 0)
+			break;
+		/* after an exception the encoder starts over with all the parts */
+		if ((span->flags & SPAN_HOLD) && span->gen == s->gen)
+			HAL_CAMERA_MpartRelease(&info);
+		if ((span->flags & (SPAN_TAIL | SPAN_SKIP)) == SPAN_TAIL)
+			s->slot_busy[span->slot] = 0;
+		s->rel++;
+	}
+}
+
+/* Drop the client, TCP must not keep any reference to the parts. Returns
+ * ERR_ABRT if the pcb was aborted, to be passed up by tcp callbacks. */
+static err_t stream_drop(struct camera_stream *s)
+{
+	err_t ret = ERR_OK;
+
+	if (s->client) {
+		tcp_arg(s->client, NULL);
+		tcp_err(s->client, NULL);
+		tcp_sent(s->client, NULL);
+		tcp_recv(s->client, NULL);
+		tcp_poll(s->client, NULL, 0);
+		tcp_abort(s->client);
+		s->client = NULL;
+		ret = ERR_ABRT;
+	}
+	if (s->state != STREAM_ST_IDLE)
+		CAMERA_DBG("stream: client dropped\n");
+	s->state = STREAM_ST_IDLE;
+	s->conn++;
+	s->acked = s->written;
+	s->stage = STREAM_STAGE_PART;
+	s->in_part = 0;
+	s->off = 0;
+	s->req_match = 0;
+	stream_post(s);
+	return ret;
+}
+
+static err_t stream_write(struct camera_stream *s, const void *data, uint32_t len,
+                          uint8_t flags)
+{
+	err_t err;
+
+	if (tcp_sndbuf(s->client) < len)
+		return ERR_MEM;
+	err = tcp_write(s->client, data, len, flags);
+	if (err == ERR_OK)
+		s->written += len;
+	return err;
+}
+
+/* Queue the spans to the client, as far as the send buffer goes */
+static void stream_send(struct camera_stream *s)
+{
+	struct tcp_pcb *pcb = s->client;
+	struct stream_span *span;
+	uint32_t len;
+	err_t err = ERR_OK;
+
+	while (s->sent != s->in) {
+		span = STREAM_SPAN(s, s->sent);
+
+		if (s->stage == STREAM_STAGE_PART && s->off == 0 &&
+		    (s->state != STREAM_ST_RUN || (span->flags & SPAN_SKIP) ||
+		     span->conn != s->conn ||
+		     !((span->flags & SPAN_FIRST) || s->in_part) ||
+		     ((span->flags & SPAN_HOLD) && span->gen != s->gen))) {
+			if (span->flags & SPAN_TAIL)
+				s->in_part = 0;
+			span->end = s->written;
+			s->sent++;
+			continue;
+		}
+
+		switch (s->stage) {
+		case STREAM_STAGE_PART:
+			if (span->flags & SPAN_FIRST) {
+				err = stream_write(s, stream_part, sizeof(stream_part) - 1,
+				                   TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
+				if (err != ERR_OK)
+					break;
+				s->in_part = 1;
+			}
+			s->stage = STREAM_STAGE_HDR;
+			/* fall through */
+		case STREAM_STAGE_HDR:
+			if (span->flags & SPAN_FIRST) {
+				/* the slot lives until the tail is acked */
+				err = stream_write(s, s->slot_hdr[span->slot], CAMERA_JPEG_HEADER_LEN,
+				                   TCP_WRITE_FLAG_MORE);
+				if (err != ERR_OK)
+					break;
+			}
+			s->stage = STREAM_STAGE_DATA;
+			/* fall through */
+		case STREAM_STAGE_DATA:
+			while (s->off < span->size) {
+				len = span->size - s->off;
+				if (len > tcp_sndbuf(pcb))
+					len = tcp_sndbuf(pcb);
+				if (len == 0) {
+					err = ERR_MEM;
+					break;
+				}
+				err = stream_write(s, span->addr + s->off, len, TCP_WRITE_FLAG_MORE);
+				if (err != ERR_OK)
+					break;
+				s->off += len;
+			}
+			if (err != ERR_OK)
+				break;
+			s->stage = STREAM_STAGE_BOUNDARY;
+			/* fall through */
+		case STREAM_STAGE_BOUNDARY:
+			if (span->flags & SPAN_TAIL) {
+				/* lets the client show the frame without waiting for the next */
+				err = stream_write(s, stream_boundary, sizeof(stream_boundary) - 1,
+				                   TCP_WRITE_FLAG_COPY);
+				if (err != ERR_OK)
+					break;
+				s->in_part = 0;
+				s->stats.frames++;
+			}
+			span->end = s->written;
+			s->sent++;
+			s->stage = STREAM_STAGE_PART;
+			s->off = 0;
+			break;
+		}
+
+		if (err == ERR_MEM)
+			break;
+		if (err != ERR_OK) {
+			CAMERA_ERR("stream: write err %d\n", err);
+			stream_drop(s);
+			pcb = NULL;
+			break;
+		}
+	}
+
+	if (pcb)
+		tcp_output(pcb);
+}
+
+static void stream_tcp_err(void *arg, err_t err)
+{
+	struct camera_stream *s = arg;
+
+	if (s == NULL)
+		return;
+	s->client = NULL; /* already freed by the stack */
+	stream_drop(s);
+}
+
+static err_t stream_tcp_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+	struct camera_stream *s = arg;
+
+	s->acked += len;
+	s->stats.bytes += len;
+	/* refill from the callback message, not from inside the stack */
+	stream_post(s);
+	return ERR_OK;
+}
+
+static err_t stream_tcp_poll(void *arg, struct tcp_pcb *pcb)
+{
+	struct camera_stream *s = arg;
+
+	if (s->state == STREAM_ST_RUN && s->acked == s->written) {
+		s->poll_idle = 0;
+	} else if (s->acked != s->poll_acked) {
+		s->poll_acked = s->acked;
+		s->poll_idle = 0;
+	} else if (++s->poll_idle >= STREAM_STALL_POLL) {
+		CAMERA_WRN("stream: client stalled\n");
+		return stream_drop(s);
+	}
+	return ERR_OK;
+}
+
+static err_t stream_tcp_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+	struct camera_stream *s = arg;
+	struct pbuf *q;
+	uint16_t i;
+	uint8_t req_end = 0;
+	char c;
+
+	if (p == NULL) /* closed by the peer */
+		return stream_drop(s);
+	if (err != ERR_OK) {
+		pbuf_free(p);
+		return err;
+	}
+
+	/* any request gets the stream once its headers are complete */
+	for (q = p; q != NULL && s->state == STREAM_ST_REQ && !req_end; q = q->next) {
+		for (i = 0; i < q->len; i++) {
+			c = ((char *)q->payload)[i];
+			if (c == stream_req_end[s->req_match])
+				s->req_match++;
+			else
+				s->req_match = (c == '\r') ? 1 : 0;
+			if (s->req_match == sizeof(stream_req_end) - 1) {
+				req_end = 1;
+				break;
+			}
+		}
+	}
+	tcp_recved(pcb, p->tot_len);
+	pbuf_free(p);
+
+	if (req_end) {
+		if (stream_write(s, stream_resp, sizeof(stream_resp) - 1, TCP_WRITE_FLAG_COPY) != ERR_OK)
+			return stream_drop(s);
+		tcp_output(pcb);
+		s->state = STREAM_ST_RUN; /* frames are taken from the next one on */
+		CAMERA_DBG("stream: client running\n");
+	}
+	return ERR_OK;
+}
+
+static err_t stream_tcp_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+	struct camera_stream *s = arg;
+
+	if (err != ERR_OK || pcb == NULL)
+		return ERR_VAL;
+	if (s == NULL || s->client || s->stop_req) {
+		tcp_abort(pcb); /* one client at a time */
+		return ERR_ABRT;
+	}
+	tcp_accepted(s->listen);
+
+	s->client = pcb;
+	s->state = STREAM_ST_REQ;
+	s->req_match = 0;
+	s->poll_idle = 0;
+	s->poll_acked = s->acked;
+	s->stats.clients++;
+	tcp_arg(pcb, s);
+	tcp_err(pcb, stream_tcp_err);
+	tcp_recv(pcb, stream_tcp_recv);
+	tcp_sent(pcb, stream_tcp_sent);
+	tcp_poll(pcb, stream_tcp_poll, 1);
+	tcp_nagle_disable(pcb);
+	CAMERA_DBG("stream: client from %s:%d\n", ipaddr_ntoa(&pcb->remote_ip),
+	           pcb->remote_port);
+	return ERR_OK;
+}
+
+static err_t stream_open(struct camera_stream *s)
+{
+	struct tcp_pcb *pcb = tcp_new();
+	err_t err;
+
+	if (pcb == NULL)
+		return ERR_MEM;
+	err = tcp_bind(pcb, IP_ADDR_ANY, s->cfg.port);
+	if (err != ERR_OK) {
+		tcp_close(pcb);
+		return err;
+	}
+	s->listen = tcp_listen(pcb);
+	if (s->listen == NULL) {
+		tcp_close(pcb);
+		return ERR_MEM;
+	}
+	tcp_arg(s->listen, s);
+	tcp_accept(s->listen, stream_tcp_accept);
+	return ERR_OK;
+}
+
+static void stream_close(struct camera_stream *s)
+{
+	stream_drop(s);
+	if (s->listen) {
+		tcp_arg(s->listen, NULL);
+		tcp_accept(s->listen, NULL);
+		tcp_close(s->listen);
+		s->listen = NULL;
+	}
+}
+
+static void stream_tick(void *arg)
+{
+	struct camera_stream *s = arg;
+
+	if (!s->opened) {
+		s->opened = 1;
+		s->err = stream_open(s);
+		OS_SemaphoreRelease(&s->done);
+	} else if (s->stop_req == 1) {
+		s->stop_req = 2;
+		stream_close(s);
+		OS_SemaphoreRelease(&s->done);
+	}
+
+	stream_send(s);
+	stream_release(s);
+
+	s->msg_pending = 0; /* last access, the thread may free s after it */
+}
+
+/* ------------------------------------------------------------------------ *
+ * api
+ * ------------------------------------------------------------------------ */
+
+static void stream_free(struct camera_stream *s)
+{
+	if (s->msg)
+		tcpip_callbackmsg_delete(s->msg);
+	if (OS_SemaphoreIsValid(&s->done))
+		OS_SemaphoreDelete(&s->done);
+	free(s);
+}
+
+/**
+ * @brief Serve the camera as MJPEG over HTTP, to one client at a time.
+ * @note The capture is started by the caller with HAL_CAMERA_CaptureMpartStart().
+ * @retval 0 : on success, -1 : fail.
+ */
+int HAL_CAMERA_StreamStart(const CAMERA_StreamCfg *cfg)
+{
+	struct camera_stream *s;
+	uint32_t part_size = CAMERA_GetMpartSize();
+	uint8_t *slot;
+	int i;
+
+	if (g_stream) {
+		CAMERA_ERR("stream already started\n");
+		return -1;
+	}
+	if (part_size == 0) {
+		CAMERA_ERR("stream needs mem part\n");
+		return -1;
+	}
+
+	s = malloc(sizeof(*s) + STREAM_SLOT_NUM * (CAMERA_JPEG_HEADER_LEN + part_size));
+	if (s == NULL) {
+		CAMERA_ERR("%s malloc faild\n", __func__);
+		return -1;
+	}
+	memset(s, 0, sizeof(*s));
+	if (cfg)
+		s->cfg = *cfg;
+	if (s->cfg.port == 0)
+		s->cfg.port = 80;
+	if (s->cfg.max_backlog == 0)
+		s->cfg.max_backlog = STREAM_BACKLOG_DEF;
+	s->part_size = part_size;
+	slot = (uint8_t *)(s + 1);
+	for (i = 0; i < STREAM_SLOT_NUM; i++) {
+		s->slot_hdr[i] = slot;
+		s->slot_tail[i] = slot + CAMERA_JPEG_HEADER_LEN;
+		slot += CAMERA_JPEG_HEADER_LEN + part_size;
+	}
+
+	if (OS_SemaphoreCreate(&s->done, 0, 1) != OS_OK) {
+		CAMERA_ERR("sem create fail\n");
+		goto err;
+	}
+	s->msg = tcpip_callbackmsg_new(stream_tick, s);
+	if (s->msg == NULL) {
+		CAMERA_ERR("tcpip msg alloc fail\n");
+		goto err;
+	}
+
+	stream_post(s); /* opens the listening pcb */
+	if (OS_SemaphoreWait(&s->done, OS_WAIT_FOREVER) != OS_OK || s->err != ERR_OK) {
+		CAMERA_ERR("stream listen on %d fail, err %d\n", s->cfg.port, s->err);
+		while (s->msg_pending)
+			OS_MSleep(1);
+		goto err;
+	}
+
+	g_stream = s;
+	if (CAMERA_SetMpartHook(stream_mpart_hook) != 0) {
+		s->stop_req = 1;
+		do {
+			stream_post(s);
+		} while (OS_SemaphoreWait(&s->done, 100) != OS_OK);
+		while (s->msg_pending)
+			OS_MSleep(1);
+		g_stream = NULL;
+		goto err;
+	}
+	CAMERA_DBG("stream on port %d\n", s->cfg.port);
+	return 0;
+
+err:
+	stream_free(s);
+	return -1;
+}
+
+void HAL_CAMERA_StreamStop(void)
+{
+	struct camera_stream *s = g_stream;
+	CAMERA_MpartBuffInfo info;
+
+	if (s == NULL)
+		return;
+
+	/* no new client, then no more parts from the interrupt */
+	s->stop_req = 1;
+	do {
+		stream_post(s); /* again if a running tick missed the request */
+	} while (OS_SemaphoreWait(&s->done, 100) != OS_OK);
+	CAMERA_SetMpartHook(NULL);
+	while (s->msg_pending)
+		OS_MSleep(1);
+
+	/* nothing else touches the ring now, give back what is left in order */
+	memset(&info, 0, sizeof(info));
+	while (s->rel != s->in) {
+		struct stream_span *span = STREAM_SPAN(s, s->rel);
+		if ((span->flags & SPAN_HOLD) && span->gen == s->gen)
+			HAL_CAMERA_MpartRelease(&info);
+		s->rel++;
+	}
+
+	g_stream = NULL;
+	stream_free(s);
+}
+
+int HAL_CAMERA_StreamGetStats(CAMERA_StreamStats *stats)
+{
+	struct camera_stream *s = g_stream;
+
+	if (s == NULL)
+		return -1;
+	memcpy(stats, &s->stats, sizeof(*stats));
+	return 0;
+}
@@ -20,6 +20,10 @@
 #define SUPPORT_DEV_RAM 0
 #define SUPPORT_DEV_USB 0
 
+#if (SUPPORT_DEV_RAM)
+#include "driver/ram_diskio.h"
+#endif
+
 /*-----------------------------------------------------------------------*/
 /* Get Drive Status                                                      */
 /*-----------------------------------------------------------------------*/
@@ -36,7 +40,7 @@ DSTATUS disk_status (
 	case DEV_RAM :
 		result = RAM_disk_status();
 
-		// translate the reslut code here
+		stat = result;
 
 		return stat;
 #endif
@@ -78,7 +82,7 @@ DSTATUS disk_initialize (
 	case DEV_RAM :
 		result = RAM_disk_initialize();
 
-		// translate the reslut code here
+		stat = result;
 
 		return stat;
 #endif
@@ -125,7 +129,7 @@ DRESULT disk_read (
 
 		result = RAM_disk_read(buff, sector, count);
 
-		// translate the reslut code here
+		res = result;
 
 		return res;
 #endif
@@ -177,7 +181,7 @@ DRESULT disk_write (
 
 		result = RAM_disk_write(buff, sector, count);
 
-		// translate the reslut code here
+		res = result;
 
 		return res;
 #endif
@@ -225,7 +229,9 @@ DRESULT disk_ioctl (
 #if (SUPPORT_DEV_RAM)
 	case DEV_RAM :
 
-		// Process of the command for the RAM drive
+		result = RAM_disk_ioctl(cmd, buff);
+
+		res = result;
 
 		return res;
 #endif
@@ -0,0 +1,501 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "blkcache.h"
+
+#if (__CONFIG_FATFS_HEAP_MODE == 1)
+#include "sys/sys_heap.h"
+#define BLKCACHE_MALLOC(l)		psram_malloc(l)
+#define BLKCACHE_FREE(p)		psram_free(p)
+#else
+#include <stdlib.h>
+#define BLKCACHE_MALLOC(l)		malloc(l)
+#define BLKCACHE_FREE(p)		free(p)
+#endif
+
+#define BLKCACHE_DBG_ON			0
+
+#if BLKCACHE_DBG_ON
+#define BLKCACHE_DBG(fmt, arg...)	printf("[blkcache] "fmt, ##arg)
+#else
+#define BLKCACHE_DBG(fmt, arg...)
+#endif
+#define BLKCACHE_ERR(fmt, arg...)	printf("[blkcache] "fmt, ##arg)
+
+#define BLKCACHE_NIL			0xFFFF
+
+#define BLKCACHE_F_VALID		(1 << 0)
+#define BLKCACHE_F_DIRTY		(1 << 1)
+
+struct blkcache_line {
+	DWORD    sector;
+	uint16_t prev;		/* towards the MRU end */
+	uint16_t next;		/* towards the LRU end */
+	uint16_t hnext;		/* hash chain */
+	uint8_t  flags;
+};
+
+struct blkcache {
+	const struct blkcache_dev_ops *ops;
+	struct blkcache_line *line;
+	uint16_t *hash;		/* bucket heads */
+	uint16_t *order;	/* scratch for sorting dirty lines */
+	uint8_t  *data;		/* line data, BLKCACHE_SECTOR_SIZE per line */
+	uint8_t  *batch;	/* staging buffer for read-ahead and write-back */
+	DWORD     capacity;
+	DWORD     next_sector;	/* sector following the last read */
+	uint16_t  nr_lines;
+	uint16_t  nr_batch;
+	uint16_t  hash_mask;
+	uint16_t  nr_dirty;
+	uint16_t  mru;
+	uint16_t  lru;
+	uint16_t  ra_window;
+	struct blkcache_stats stats;
+};
+
+#define LINE_DATA(bc, idx)	((bc)->data + (uint32_t)(idx) * BLKCACHE_SECTOR_SIZE)
+#define HASH_IDX(bc, sec)	((uint16_t)((sec) ^ ((sec) >> 11)) & (bc)->hash_mask)
+
+static void lru_unlink(struct blkcache *bc, uint16_t idx)
+{
+	struct blkcache_line *l = &bc->line[idx];
+
+	if (l->prev != BLKCACHE_NIL)
+		bc->line[l->prev].next = l->next;
+	else
+		bc->mru = l->next;
+	if (l->next != BLKCACHE_NIL)
+		bc->line[l->next].prev = l->prev;
+	else
+		bc->lru = l->prev;
+}
+
+static void lru_push_mru(struct blkcache *bc, uint16_t idx)
+{
+	struct blkcache_line *l = &bc->line[idx];
+
+	l->prev = BLKCACHE_NIL;
+	l->next = bc->mru;
+	if (bc->mru != BLKCACHE_NIL)
+		bc->line[bc->mru].prev = idx;
+	else
+		bc->lru = idx;
+	bc->mru = idx;
+}
+
+static void lru_push_lru(struct blkcache *bc, uint16_t idx)
+{
+	struct blkcache_line *l = &bc->line[idx];
+
+	l->next = BLKCACHE_NIL;
+	l->prev = bc->lru;
+	if (bc->lru != BLKCACHE_NIL)
+		bc->line[bc->lru].next = idx;
+	else
+		bc->mru = idx;
+	bc->lru = idx;
+}
+
+static void lru_touch(struct blkcache *bc, uint16_t idx)
+{
+	if (bc->mru != idx) {
+		lru_unlink(bc, idx);
+		lru_push_mru(bc, idx);
+	}
+}
+
+static uint16_t hash_lookup(struct blkcache *bc, DWORD sector)
+{
+	uint16_t idx = bc->hash[HASH_IDX(bc, sector)];
+
+	while (idx != BLKCACHE_NIL) {
+		if (bc->line[idx].sector == sector)
+			return idx;
+		idx = bc->line[idx].hnext;
+	}
+	return BLKCACHE_NIL;
+}
+
+static void hash_insert(struct blkcache *bc, uint16_t idx)
+{
+	uint16_t *head = &bc->hash[HASH_IDX(bc, bc->line[idx].sector)];
+
+	bc->line[idx].hnext = *head;
+	*head = idx;
+}
+
+static void hash_remove(struct blkcache *bc, uint16_t idx)
+{
+	uint16_t *pp = &bc->hash[HASH_IDX(bc, bc->line[idx].sector)];
+
+	while (*pp != BLKCACHE_NIL) {
+		if (*pp == idx) {
+			*pp = bc->line[idx].hnext;
+			return;
+		}
+		pp = &bc->line[*pp].hnext;
+	}
+}
+
+/* Take the LRU line for @sector, or BLKCACHE_NIL if it is dirty */
+static uint16_t line_alloc(struct blkcache *bc, DWORD sector)
+{
+	uint16_t idx = bc->lru;
+	struct blkcache_line *l = &bc->line[idx];
+
+	if (l->flags & BLKCACHE_F_DIRTY)
+		return BLKCACHE_NIL;
+	if (l->flags & BLKCACHE_F_VALID)
+		hash_remove(bc, idx);
+	l->sector = sector;
+	l->flags = BLKCACHE_F_VALID;
+	hash_insert(bc, idx);
+	lru_touch(bc, idx);
+	return idx;
+}
+
+static void line_drop(struct blkcache *bc, uint16_t idx)
+{
+	if (bc->line[idx].flags & BLKCACHE_F_DIRTY)
+		bc->nr_dirty--;
+	hash_remove(bc, idx);
+	bc->line[idx].flags = 0;
+	lru_unlink(bc, idx);
+	lru_push_lru(bc, idx);
+}
+
+static DRESULT dev_read(struct blkcache *bc, BYTE *buff, DWORD sector, UINT count)
+{
+	bc->stats.dev_read++;
+	return bc->ops->read(buff, sector, count);
+}
+
+static DRESULT dev_write(struct blkcache *bc, const BYTE *buff, DWORD sector, UINT count)
+{
+	bc->stats.dev_write++;
+	return bc->ops->write(buff, sector, count);
+}
+
+DRESULT blkcache_flush(struct blkcache *bc)
+{
+	uint16_t i, j, n, idx, run;
+	DWORD sector;
+	DRESULT res;
+
+	if (bc->nr_dirty == 0)
+		return RES_OK;
+
+	/* collect dirty lines sorted by sector, insertion sort is fine here */
+	n = 0;
+	for (idx = 0; idx < bc->nr_lines; idx++) {
+		if (!(bc->line[idx].flags & BLKCACHE_F_DIRTY))
+			continue;
+		sector = bc->line[idx].sector;
+		for (j = n; j > 0 && bc->line[bc->order[j - 1]].sector > sector; j--)
+			bc->order[j] = bc->order[j - 1];
+		bc->order[j] = idx;
+		n++;
+	}
+
+	for (i = 0; i < n; i += run) {
+		sector = bc->line[bc->order[i]].sector;
+		run = 1;
+		while (i + run < n && run < bc->nr_batch &&
+		       bc->line[bc->order[i + run]].sector == sector + run)
+			run++;
+
+		if (run == 1) {
+			res = dev_write(bc, LINE_DATA(bc, bc->order[i]), sector, 1);
+		} else {
+			for (j = 0; j < run; j++)
+				memcpy(bc->batch + (uint32_t)j * BLKCACHE_SECTOR_SIZE,
+				       LINE_DATA(bc, bc->order[i + j]), BLKCACHE_SECTOR_SIZE);
+			res = dev_write(bc, bc->batch, sector, run);
+		}
+		if (res != RES_OK) {
+			BLKCACHE_ERR("write back %u+%u failed\n", (unsigned)sector, run);
+			return res;
+		}
+		for (j = 0; j < run; j++)
+			bc->line[bc->order[i + j]].flags &= ~BLKCACHE_F_DIRTY;
+		bc->nr_dirty -= run;
+		bc->stats.write_back += run;
+	}
+
+	return RES_OK;
+}
+
+/* Write back before a dirty line can become an eviction candidate */
+static DRESULT flush_if_lru_dirty(struct blkcache *bc)
+{
+	if (bc->line[bc->lru].flags & BLKCACHE_F_DIRTY)
+		return blkcache_flush(bc);
+	return RES_OK;
+}
+
+static void update_read_ahead(struct blkcache *bc, DWORD sector, UINT count)
+{
+	if (sector == bc->next_sector) {
+		if (bc->ra_window == 0)
+			bc->ra_window = BLKCACHE_RA_MIN;
+		else if (bc->ra_window < bc->nr_batch)
+			bc->ra_window <<= 1;
+		if (bc->ra_window > bc->nr_batch)
+			bc->ra_window = bc->nr_batch;
+	} else {
+		bc->ra_window = 0;
+	}
+	bc->next_sector = sector + count;
+}
+
+/* Large read: go to the device, then overlay sectors that are dirty in cache */
+static DRESULT read_bypass(struct blkcache *bc, BYTE *buff, DWORD sector, UINT count)
+{
+	DRESULT res;
+	UINT i;
+	uint16_t idx;
+
+	res = dev_read(bc, buff, sector, count);
+	if (res != RES_OK || bc->nr_dirty == 0)
+		return res;
+
+	for (i = 0; i < count; i++) {
+		idx = hash_lookup(bc, sector + i);
+		if (idx != BLKCACHE_NIL && (bc->line[idx].flags & BLKCACHE_F_DIRTY))
+			memcpy(buff + i * BLKCACHE_SECTOR_SIZE, LINE_DATA(bc, idx),
+			       BLKCACHE_SECTOR_SIZE);
+	}
+	return RES_OK;
+}
+
+DRESULT blkcache_read(struct blkcache *bc, BYTE *buff, DWORD sector, UINT count)
+{
+	DRESULT res;
+	UINT i, j, miss, fetch;
+	uint16_t idx;
+	const BYTE *src;
+
+	update_read_ahead(bc, sector, count);
+
+	if (count >= bc->nr_batch)
+		return read_bypass(bc, buff, sector, count);
+
+	res = flush_if_lru_dirty(bc);
+	if (res != RES_OK)
+		return res;
+
+	i = 0;
+	while (i < count) {
+		idx = hash_lookup(bc, sector + i);
+		if (idx != BLKCACHE_NIL) {
+			memcpy(buff + i * BLKCACHE_SECTOR_SIZE, LINE_DATA(bc, idx),
+			       BLKCACHE_SECTOR_SIZE);
+			lru_touch(bc, idx);
+			bc->stats.read_hit++;
+			i++;
+			continue;
+		}
+
+		/* run of missing sectors, extended by read-ahead at the tail */
+		miss = 1;
+		while (i + miss < count && hash_lookup(bc, sector + i + miss) == BLKCACHE_NIL)
+			miss++;
+		fetch = miss;
+		if (i + miss == count)
+			fetch += bc->ra_window;
+		if (fetch > bc->nr_batch)
+			fetch = bc->nr_batch;
+		if (sector + i + fetch > bc->capacity)
+			fetch = (bc->capacity > sector + i + miss) ? bc->capacity - sector - i : miss;
+
+		res = dev_read(bc, bc->batch, sector + i, fetch);
+		if (res != RES_OK)
+			return res;
+
+		memcpy(buff + i * BLKCACHE_SECTOR_SIZE, bc->batch, miss * BLKCACHE_SECTOR_SIZE);
+		bc->stats.read_miss += miss;
+		bc->stats.read_ahead += fetch - miss;
+
+		/* read-ahead sectors may be cached already, maybe dirty: keep them */
+		for (j = 0, src = bc->batch; j < fetch; j++, src += BLKCACHE_SECTOR_SIZE) {
+			if (j >= miss && hash_lookup(bc, sector + i + j) != BLKCACHE_NIL)
+				continue;
+			idx = line_alloc(bc, sector + i + j);
+			if (idx == BLKCACHE_NIL)
+				break;
+			memcpy(LINE_DATA(bc, idx), src, BLKCACHE_SECTOR_SIZE);
+		}
+		i += miss;
+	}
+
+	return RES_OK;
+}
+
+DRESULT blkcache_write(struct blkcache *bc, const BYTE *buff, DWORD sector, UINT count)
+{
+	DRESULT res;
+	UINT i;
+	uint16_t idx;
+
+	if (count >= bc->nr_batch) {
+		res = dev_write(bc, buff, sector, count);
+		if (res != RES_OK)
+			return res;
+		/* keep overlapping lines coherent, they are clean now */
+		for (i = 0; i < count; i++) {
+			idx = hash_lookup(bc, sector + i);
+			if (idx == BLKCACHE_NIL)
+				continue;
+			memcpy(LINE_DATA(bc, idx), buff + i * BLKCACHE_SECTOR_SIZE,
+			       BLKCACHE_SECTOR_SIZE);
+			if (bc->line[idx].flags & BLKCACHE_F_DIRTY) {
+				bc->line[idx].flags &= ~BLKCACHE_F_DIRTY;
+				bc->nr_dirty--;
+			}
+		}
+		return RES_OK;
+	}
+
+	for (i = 0; i < count; i++) {
+		idx = hash_lookup(bc, sector + i);
+		if (idx == BLKCACHE_NIL) {
+			res = flush_if_lru_dirty(bc);
+			if (res != RES_OK)
+				return res;
+			idx = line_alloc(bc, sector + i);
+		} else {
+			lru_touch(bc, idx);
+		}
+		memcpy(LINE_DATA(bc, idx), buff + i * BLKCACHE_SECTOR_SIZE,
+		       BLKCACHE_SECTOR_SIZE);
+		if (!(bc->line[idx].flags & BLKCACHE_F_DIRTY)) {
+			bc->line[idx].flags |= BLKCACHE_F_DIRTY;
+			bc->nr_dirty++;
+		}
+	}
+
+	return RES_OK;
+}
+
+uint16_t blkcache_invalidate(struct blkcache *bc, DWORD capacity)
+{
+	uint16_t idx, dropped = bc->nr_dirty;
+
+	if (dropped)
+		BLKCACHE_ERR("invalidate: %u dirty sectors dropped\n", dropped);
+
+	for (idx = 0; idx < bc->nr_lines; idx++) {
+		if (bc->line[idx].flags & BLKCACHE_F_VALID)
+			line_drop(bc, idx);
+	}
+	bc->nr_dirty = 0;
+	bc->capacity = capacity;
+	bc->next_sector = 0;
+	bc->ra_window = 0;
+	return dropped;
+}
+
+void blkcache_get_stats(struct blkcache *bc, struct blkcache_stats *stats)
+{
+	memcpy(stats, &bc->stats, sizeof(*stats));
+}
+
+struct blkcache *blkcache_create(const struct blkcache_dev_ops *ops,
+                                 uint16_t sectors, uint16_t batch,
+                                 DWORD capacity)
+{
+	struct blkcache *bc;
+	uint16_t idx, buckets;
+
+	if (sectors == 0)
+		sectors = BLKCACHE_DEF_SECTORS;
+	if (batch == 0)
+		batch = BLKCACHE_DEF_BATCH;
+	if (sectors >= BLKCACHE_NIL || batch < 2 || batch > sectors) {
+		BLKCACHE_ERR("invalid geometry %u/%u\n", sectors, batch);
+		return NULL;
+	}
+
+	for (buckets = 1; buckets < sectors; buckets <<= 1)
+		;
+
+	bc = BLKCACHE_MALLOC(sizeof(*bc));
+	if (bc == NULL)
+		goto err;
+	memset(bc, 0, sizeof(*bc));
+	bc->line = BLKCACHE_MALLOC(sizeof(struct blkcache_line) * sectors);
+	bc->hash = BLKCACHE_MALLOC(sizeof(uint16_t) * buckets);
+	bc->order = BLKCACHE_MALLOC(sizeof(uint16_t) * sectors);
+	bc->data = BLKCACHE_MALLOC((uint32_t)sectors * BLKCACHE_SECTOR_SIZE);
+	bc->batch = BLKCACHE_MALLOC((uint32_t)batch * BLKCACHE_SECTOR_SIZE);
+	if (!bc->line || !bc->hash || !bc->order || !bc->data || !bc->batch)
+		goto err;
+
+	bc->ops = ops;
+	bc->nr_lines = sectors;
+	bc->nr_batch = batch;
+	bc->hash_mask = buckets - 1;
+	bc->capacity = capacity;
+	bc->mru = BLKCACHE_NIL;
+	bc->lru = BLKCACHE_NIL;
+	memset(bc->hash, 0xFF, sizeof(uint16_t) * buckets);
+	for (idx = 0; idx < sectors; idx++) {
+		bc->line[idx].flags = 0;
+		bc->line[idx].hnext = BLKCACHE_NIL;
+		lru_push_lru(bc, idx);
+	}
+
+	BLKCACHE_DBG("create %u sectors, batch %u\n", sectors, batch);
+	return bc;
+
+err:
+	BLKCACHE_ERR("no mem\n");
+	blkcache_destroy(bc);
+	return NULL;
+}
+
+void blkcache_destroy(struct blkcache *bc)
+{
+	if (bc == NULL)
+		return;
+	if (bc->batch)
+		BLKCACHE_FREE(bc->batch);
+	if (bc->data)
+		BLKCACHE_FREE(bc->data);
+	if (bc->order)
+		BLKCACHE_FREE(bc->order);
+	if (bc->hash)
+		BLKCACHE_FREE(bc->hash);
+	if (bc->line)
+		BLKCACHE_FREE(bc->line);
+	BLKCACHE_FREE(bc);
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _BLKCACHE_H_
+#define _BLKCACHE_H_
+
+#include <stdint.h>
+#include "fs/fatfs/integer.h"
+#include "fs/fatfs/diskio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Sector size handled by the cache, in bytes */
+#define BLKCACHE_SECTOR_SIZE		512
+
+/*
+ * Default geometry: number of cached sectors and the size of the staging
+ * buffer, which bounds both the read-ahead window and the length of one
+ * coalesced multi-block write.
+ */
+#if (__CONFIG_FATFS_HEAP_MODE == 1)
+#define BLKCACHE_DEF_SECTORS		128	/* 64 KB in PSRAM */
+#define BLKCACHE_DEF_BATCH		32	/* 16 KB */
+#else
+#define BLKCACHE_DEF_SECTORS		16	/* 8 KB in SRAM */
+#define BLKCACHE_DEF_BATCH		8	/* 4 KB */
+#endif
+
+/* Smallest read-ahead window used once a sequential stream is detected */
+#define BLKCACHE_RA_MIN			2
+
+/* Raw access to the underlying block device */
+struct blkcache_dev_ops {
+	DRESULT (*read)(BYTE *buff, DWORD sector, UINT count);
+	DRESULT (*write)(const BYTE *buff, DWORD sector, UINT count);
+};
+
+struct blkcache_stats {
+	uint32_t read_hit;	/* sectors served from the cache */
+	uint32_t read_miss;	/* sectors fetched from the device on demand */
+	uint32_t read_ahead;	/* sectors fetched ahead of demand */
+	uint32_t dev_read;	/* read commands issued to the device */
+	uint32_t dev_write;	/* write commands issued to the device */
+	uint32_t write_back;	/* dirty sectors written back by a flush */
+};
+
+struct blkcache;
+
+/**
+ * @brief Create a write-back sector cache on top of a block device
+ * @param[in] ops Raw device read/write functions
+ * @param[in] sectors Number of sectors to cache, 0 for the default
+ * @param[in] batch Staging buffer size in sectors, 0 for the default
+ * @param[in] capacity Device size in sectors, read-ahead never crosses it.
+ *                     0 disables read-ahead.
+ * @return Pointer to the cache, NULL on failure
+ *
+ * @note The cache has no lock of its own; callers must serialize access
+ *       (FatFS does so through the volume lock when _FS_REENTRANT is set).
+ *       Requests of at least @batch sectors bypass the cache.
+ */
+struct blkcache *blkcache_create(const struct blkcache_dev_ops *ops,
+                                 uint16_t sectors, uint16_t batch,
+                                 DWORD capacity);
+void blkcache_destroy(struct blkcache *bc);
+
+DRESULT blkcache_read(struct blkcache *bc, BYTE *buff, DWORD sector, UINT count);
+DRESULT blkcache_write(struct blkcache *bc, const BYTE *buff, DWORD sector, UINT count);
+
+/* Write back all dirty sectors, adjacent sectors in one command */
+DRESULT blkcache_flush(struct blkcache *bc);
+
+/*
+ * Drop all cached sectors, dirty ones without writing them back (eg. the
+ * medium was swapped). Call blkcache_flush() first to keep them.
+ * Returns the number of dirty sectors thrown away.
+ */
+uint16_t blkcache_invalidate(struct blkcache *bc, DWORD capacity);
+
+void blkcache_get_stats(struct blkcache *bc, struct blkcache_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BLKCACHE_H_ */
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "ram_diskio.h"
+#include "blkcache.h"
+
+#if (__CONFIG_FATFS_HEAP_MODE == 1)
+#include "sys/sys_heap.h"
+#define RAMDISK_MALLOC(l)	psram_malloc(l)
+#define RAMDISK_FREE(p)		psram_free(p)
+#else
+#include <stdlib.h>
+#define RAMDISK_MALLOC(l)	malloc(l)
+#define RAMDISK_FREE(p)		free(p)
+#endif
+
+#define RAMDISK_SECTOR_SIZE	BLKCACHE_SECTOR_SIZE
+
+/* Run the RAM disk behind the sector cache, as the SD card does */
+#ifdef __CONFIG_FATFS_BLKCACHE
+#define RAMDISK_BLKCACHE_EN	1
+#else
+#define RAMDISK_BLKCACHE_EN	0
+#endif
+
+static struct {
+	BYTE *mem;
+	DWORD sector_count;
+	uint8_t allocated;
+	DSTATUS stat;
+#if RAMDISK_BLKCACHE_EN
+	struct blkcache *cache;
+#endif
+} ramdisk = { NULL, 0, 0, STA_NOINIT };
+
+static DRESULT ramdisk_raw_read(BYTE *buff, DWORD sector, UINT count)
+{
+	if (sector + count > ramdisk.sector_count)
+		return RES_PARERR;
+	memcpy(buff, ramdisk.mem + (size_t)sector * RAMDISK_SECTOR_SIZE, count * RAMDISK_SECTOR_SIZE);
+	return RES_OK;
+}
+
+static DRESULT ramdisk_raw_write(const BYTE *buff, DWORD sector, UINT count)
+{
+	if (sector + count > ramdisk.sector_count)
+		return RES_PARERR;
+	memcpy(ramdisk.mem + (size_t)sector * RAMDISK_SECTOR_SIZE, buff, count * RAMDISK_SECTOR_SIZE);
+	return RES_OK;
+}
+
+#if RAMDISK_BLKCACHE_EN
+static const struct blkcache_dev_ops ramdisk_dev_ops = {
+	.read  = ramdisk_raw_read,
+	.write = ramdisk_raw_write,
+};
+#endif
+
+/**
+  * @brief  Attach memory to the RAM disk
+  * @param  mem: Backing memory, NULL to allocate it
+  * @param  sector_count: Disk size in sectors
+  * @retval 0 on success, -1 on failure
+  */
+int RAM_disk_setup(BYTE *mem, DWORD sector_count)
+{
+	RAM_disk_release();
+
+	if (mem == NULL) {
+		mem = RAMDISK_MALLOC((size_t)sector_count * RAMDISK_SECTOR_SIZE);
+		if (mem == NULL) {
+			printf("ramdisk: no mem\n");
+			return -1;
+		}
+		memset(mem, 0, (size_t)sector_count * RAMDISK_SECTOR_SIZE);
+		ramdisk.allocated = 1;
+	}
+	ramdisk.mem = mem;
+	ramdisk.sector_count = sector_count;
+	return 0;
+}
+
+void RAM_disk_release(void)
+{
+#if RAMDISK_BLKCACHE_EN
+	if (ramdisk.cache) {
+		blkcache_destroy(ramdisk.cache);
+		ramdisk.cache = NULL;
+	}
+#endif
+	if (ramdisk.allocated)
+		RAMDISK_FREE(ramdisk.mem);
+	ramdisk.mem = NULL;
+	ramdisk.sector_count = 0;
+	ramdisk.allocated = 0;
+	ramdisk.stat = STA_NOINIT;
+}
+
+DSTATUS RAM_disk_initialize()
+{
+	if (ramdisk.mem == NULL)
+		return STA_NOINIT;
+
+#if RAMDISK_BLKCACHE_EN
+	if (ramdisk.cache == NULL)
+		ramdisk.cache = blkcache_create(&ramdisk_dev_ops, 0, 0, ramdisk.sector_count);
+	else if (blkcache_flush(ramdisk.cache) != RES_OK)
+		return STA_NOINIT;
+	else
+		blkcache_invalidate(ramdisk.cache, ramdisk.sector_count);
+#endif
+	ramdisk.stat = 0;
+	return ramdisk.stat;
+}
+
+DSTATUS RAM_disk_status()
+{
+	return ramdisk.stat;
+}
+
+DRESULT RAM_disk_read(BYTE *buff, DWORD sector, UINT count)
+{
+#if RAMDISK_BLKCACHE_EN
+	if (ramdisk.cache)
+		return blkcache_read(ramdisk.cache, buff, sector, count);
+#endif
+	return ramdisk_raw_read(buff, sector, count);
+}
+
+DRESULT RAM_disk_write(const BYTE *buff, DWORD sector, UINT count)
+{
+#if RAMDISK_BLKCACHE_EN
+	if (ramdisk.cache)
+		return blkcache_write(ramdisk.cache, buff, sector, count);
+#endif
+	return ramdisk_raw_write(buff, sector, count);
+}
+
+DRESULT RAM_disk_ioctl(BYTE cmd, void *buff)
+{
+	if (ramdisk.stat & STA_NOINIT)
+		return RES_NOTRDY;
+
+	switch (cmd) {
+	case CTRL_SYNC:
+#if RAMDISK_BLKCACHE_EN
+		if (ramdisk.cache)
+			return blkcache_flush(ramdisk.cache);
+#endif
+		return RES_OK;
+	case GET_SECTOR_COUNT:
+		*(DWORD *)buff = ramdisk.sector_count;
+		return RES_OK;
+	case GET_SECTOR_SIZE:
+		*(WORD *)buff = RAMDISK_SECTOR_SIZE;
+		return RES_OK;
+	case GET_BLOCK_SIZE:
+		*(DWORD *)buff = 1;
+		return RES_OK;
+	default:
+		return RES_PARERR;
+	}
+}
@@ -0,0 +1,22 @@
+#ifndef _RAM_DISKIO_H_
+#define _RAM_DISKIO_H_
+
+#include "fs/fatfs/integer.h"
+#include "fs/fatfs/ffconf.h"
+#include "fs/fatfs/ff.h"
+#include "fs/fatfs/diskio.h"
+
+/*
+ * RAM disk, mainly a backend to benchmark the sector cache and FatFS on the
+ * host. Call RAM_disk_setup() before mounting, with @mem NULL to allocate.
+ */
+int RAM_disk_setup(BYTE *mem, DWORD sector_count);
+void RAM_disk_release(void);
+
+DSTATUS RAM_disk_initialize();
+DSTATUS RAM_disk_status();
+DRESULT RAM_disk_read(BYTE *buff, DWORD sector, UINT count);
+DRESULT RAM_disk_write(const BYTE *buff, DWORD sector, UINT count);
+DRESULT RAM_disk_ioctl(BYTE cmd, void *buff);
+
+#endif /* _RAM_DISKIO_H_ */
@@ -15,6 +15,7 @@
 #include "sdmmc_diskio.h"
 #include "driver/chip/sdmmc/hal_sdhost.h"
 #include "driver/chip/sdmmc/sdmmc.h"
+#include "blkcache.h"
 
 
 //#include "ff_gen_drv.h"
@@ -27,10 +28,37 @@
 /* Block Size in Bytes */
 #define BLOCK_SIZE                512
 
+/* Put a write-back sector cache between FatFS and the card */
+#ifdef __CONFIG_FATFS_BLKCACHE
+#define SDMMC_BLKCACHE_EN         1
+#else
+#define SDMMC_BLKCACHE_EN         0
+#endif
+
 /* Private variables ---------------------------------------------------------*/
 /* Disk status */
 static volatile DSTATUS Stat = STA_NOINIT;
 
+#if SDMMC_BLKCACHE_EN
+static struct blkcache *sdmmc_cache;
+
+static DRESULT sdmmc_raw_read(BYTE *buff, DWORD sector, UINT count);
+static DRESULT sdmmc_raw_write(const BYTE *buff, DWORD sector, UINT count);
+
+static const struct blkcache_dev_ops sdmmc_dev_ops = {
+	.read  = sdmmc_raw_read,
+	.write = sdmmc_raw_write,
+};
+
+/* card the cached sectors were read from and are written back to */
+struct sdmmc_card_id {
+	struct mmc_cid cid;
+	uint32_t capacity;
+};
+
+static struct sdmmc_card_id sdmmc_cache_id;
+#endif
+
 /* Private function prototypes -----------------------------------------------*/
 DSTATUS SD_initialize (BYTE);
 DSTATUS SD_status (BYTE);
@@ -70,6 +98,44 @@ uint32_t sdmmc_get_sector_count(void)
 		return 0;
 }
 
+#if SDMMC_BLKCACHE_EN
+static void sdmmc_get_card_id(struct sdmmc_card_id *id)
+{
+	struct mmc_card *card;
+
+	memset(id, 0, sizeof(*id));
+	card = mmc_card_open(0);
+	if (card != NULL) {
+		id->cid = card->cid;
+		id->capacity = mmc_get_capacity(card);
+	}
+	mmc_card_close(0);
+}
+
+/*
+ * The card may have been removed and another one inserted since the cache
+ * was filled. Sectors still dirty are written back only to the same card,
+ * a different one would get the FAT and data of the old one.
+ */
+static DSTATUS sdmmc_cache_reinit(void)
+{
+	struct sdmmc_card_id id;
+
+	sdmmc_get_card_id(&id);
+	if (sdmmc_cache == NULL) {
+		sdmmc_cache = blkcache_create(&sdmmc_dev_ops, 0, 0,
+		                              sdmmc_get_sector_count());
+	} else {
+		if (memcmp(&id, &sdmmc_cache_id, sizeof(id)) == 0 &&
+		    blkcache_flush(sdmmc_cache) != RES_OK)
+			return STA_NOINIT; /* keep the data, drive not ready */
+		blkcache_invalidate(sdmmc_cache, sdmmc_get_sector_count());
+	}
+	sdmmc_cache_id = id;
+	return 0;
+}
+#endif
+
 /**
   * @brief  Initializes a Drive
   * @param  lun : not used
@@ -89,6 +155,11 @@ DSTATUS SDMMC_initialize()
 		}
 	}
 	mmc_card_close(0);
+
+#if SDMMC_BLKCACHE_EN
+	if (!(Stat & STA_NOINIT))
+		Stat |= sdmmc_cache_reinit();
+#endif
 	return Stat;
 }
 
@@ -103,6 +174,40 @@ DSTATUS SDMMC_status()
   	return 0;
 }
 
+static DRESULT sdmmc_raw_read(BYTE *buff, DWORD sector, UINT count)
+{
+	DRESULT res = RES_ERROR;
+	struct mmc_card *card;
+
+	card = mmc_card_open(0);
+	if (card != NULL) {
+		if (mmc_block_read(card, buff, sector, count) != 0) {
+			SDMMC_DEBUG("sdmmc driver read failed\n");
+		} else
+			res = RES_OK;
+	}
+	mmc_card_close(0);
+
+	return res;
+}
+
+static DRESULT sdmmc_raw_write(const BYTE *buff, DWORD sector, UINT count)
+{
+	DRESULT res = RES_ERROR;
+	struct mmc_card *card;
+
+	card = mmc_card_open(0);
+	if (card != NULL) {
+		if (mmc_block_write(card, (uint8_t *)buff, sector, count) != 0) {
+			SDMMC_DEBUG("sdmmc driver write failed\n");
+		} else
+			res = RES_OK;
+	}
+	mmc_card_close(0);
+
+	return res;
+}
+
 /**
   * @brief  Reads Sector(s)
   * @param  lun : not used
@@ -113,20 +218,13 @@ DSTATUS SDMMC_status()
   */
 DRESULT SDMMC_read(BYTE *buff, const DWORD sector, UINT count)
 {
-  SDMMC_ENTRY();
-  DRESULT res = RES_ERROR;
-  struct mmc_card *card;
-
-  card = mmc_card_open(0);
-  if (card != NULL) {
-  	if (mmc_block_read(card, buff, sector, count) != 0) {
-		SDMMC_DEBUG("sdmmc driver read failed\n");
- 	} else
-		res = RES_OK;
-  }
-  mmc_card_close(0);
+	SDMMC_ENTRY();
 
-  return res;
+#if SDMMC_BLKCACHE_EN
+	if (sdmmc_cache)
+		return blkcache_read(sdmmc_cache, buff, sector, count);
+#endif
+	return sdmmc_raw_read(buff, sector, count);
 }
 
 /**
@@ -136,27 +234,21 @@ DRESULT SDMMC_read(BYTE *buff, const DWORD sector, UINT count)
   * @param  sector: Sector address (LBA)
   * @param  count: Number of sectors to write (1..128)
   * @retval DRESULT: Operation result
+  *
+  * @note   With the sector cache enabled, short writes are only staged in
+  *         the cache. They reach the card as multi-block writes when dirty
+  *         sectors age out or on CTRL_SYNC.
   */
 //#if _USE_WRITE == 1
 DRESULT SDMMC_write(const BYTE *buff, DWORD sector, UINT count)
 {
-	int32_t err;
-	struct mmc_card *card;
-
 	SDMMC_ENTRY();
-	DRESULT res = RES_ERROR;
-
-	card = mmc_card_open(0);
-	if (card != NULL) {
-		err = mmc_block_write(card, (uint8_t *)buff, sector, count);
-		if (err != 0) {
-			SDMMC_DEBUG("sdmmc driver write failed\n");
-		} else
-			res = RES_OK;
-	}
-	mmc_card_close(0);
 
-	return res;
+#if SDMMC_BLKCACHE_EN
+	if (sdmmc_cache)
+		return blkcache_write(sdmmc_cache, buff, sector, count);
+#endif
+	return sdmmc_raw_write(buff, sector, count);
 }
 //#endif /* _USE_WRITE == 1 */
 
@@ -179,6 +271,12 @@ DRESULT SDMMC_ioctl(BYTE cmd, void *buff)
   {
   /* Make sure that no pending write process */
   case CTRL_SYNC :
+#if SDMMC_BLKCACHE_EN
+    if (sdmmc_cache) {
+      res = blkcache_flush(sdmmc_cache);
+      break;
+    }
+#endif
     res = RES_OK;
     break;
 
@@ -1464,6 +1464,211 @@ DWORD clmt_clust (	/* <2:Error, >=2:Cluster number */
 
 
 
+#if _USE_CLIDX
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Cluster index of the open files                        */
+/*-----------------------------------------------------------------------*/
+
+typedef struct {
+	DWORD	fcl;		/* Cluster order of the fragment top from top of the file */
+	DWORD	clst;		/* Cluster number of the fragment top */
+	DWORD	ncl;		/* Number of clusters known to be contiguous */
+} CLIDX_ENT;
+
+typedef struct _CLIDX {
+	const FIL* fp;		/* Owner file object (0:slot unused) */
+	DWORD	sclust;		/* Owner start cluster when the index was started */
+	WORD	id;			/* Owner file system mount ID */
+	WORD	n_ent;		/* Number of items used */
+	DWORD	gap;		/* Minimum distance in clusters between two recorded fragments */
+	DWORD	stamp;		/* Last use, the least recently used slot is reclaimed */
+	CLIDX_ENT ent[_CLIDX_SIZE];	/* Fragments sorted by cluster order */
+} CLIDX;
+
+
+static
+CLIDX* clidx_get (	/* Cluster index of the file, 0:None */
+	FATFS* fs,		/* File system object */
+	const FIL* fp,	/* File object */
+	int create		/* Take a slot if the file has no index */
+)
+{
+	CLIDX *ci;
+	UINT i, vi;
+
+
+	for (i = 0; i < _CLIDX_FILES; i++) {
+		ci = fs->clidx[i];
+		if (ci && ci->fp == fp) {
+			if (ci->id != fs->id || ci->sclust != fp->obj.sclust) {	/* Chain replaced, restart the index */
+				ci->id = fs->id; ci->sclust = fp->obj.sclust;
+				ci->n_ent = 0; ci->gap = 1;
+			}
+			ci->stamp = ++fs->clidx_stamp;
+			return ci;
+		}
+	}
+	if (!create) return 0;
+
+	vi = 0;
+	for (i = 0; i < _CLIDX_FILES; i++) {	/* Find an unused or the least recently used slot */
+		ci = fs->clidx[i];
+		if (!ci || !ci->fp) {
+			vi = i; break;
+		}
+		if (ci->stamp < fs->clidx[vi]->stamp) vi = i;
+	}
+	ci = fs->clidx[vi];
+	if (!ci) {
+		ci = ff_memalloc(sizeof (CLIDX));
+		if (!ci) return 0;
+		fs->clidx[vi] = ci;
+	}
+	ci->fp = fp; ci->id = fs->id; ci->sclust = fp->obj.sclust;
+	ci->n_ent = 0; ci->gap = 1;
+	ci->stamp = ++fs->clidx_stamp;
+	return ci;
+}
+
+
+static
+int clidx_search (	/* Index of the last item at or before fcl, -1:None */
+	const CLIDX* ci,
+	DWORD fcl
+)
+{
+	int lo = 0, hi = (int)ci->n_ent - 1, mid;
+
+
+	while (lo <= hi) {
+		mid = (lo + hi) / 2;
+		if (ci->ent[mid].fcl <= fcl) {
+			lo = mid + 1;
+		} else {
+			hi = mid - 1;
+		}
+	}
+	return hi;
+}
+
+
+static
+int clidx_find (	/* 1:Found, 0:Nothing known at or before *fcl */
+	const CLIDX* ci,
+	DWORD* fcl,		/* Cluster order to look up (in), nearest known order at or before it (out) */
+	DWORD* clst		/* Cluster number at *fcl (out) */
+)
+{
+	const CLIDX_ENT *e;
+	int i;
+
+
+	i = clidx_search(ci, *fcl);
+	if (i < 0) return 0;
+	e = &ci->ent[i];
+	if (*fcl - e->fcl >= e->ncl) *fcl = e->fcl + e->ncl - 1;	/* Beyond the fragment, stop at its last known cluster */
+	*clst = e->clst + (*fcl - e->fcl);
+	return 1;
+}
+
+
+static
+void clidx_note (
+	CLIDX* ci,
+	DWORD fcl,		/* Cluster order in the file */
+	DWORD clst		/* Cluster number found at fcl */
+)
+{
+	CLIDX_ENT *e;
+	int i, j;
+
+
+	i = clidx_search(ci, fcl);
+	if (i >= 0) {
+		e = &ci->ent[i];
+		if (fcl - e->fcl < e->ncl) return;		/* Already known */
+		if (fcl - e->fcl == e->ncl && clst == e->clst + e->ncl) {	/* Stretches the fragment */
+			e->ncl++;
+			if (i + 1 < ci->n_ent && e[1].fcl == fcl + 1 && e[1].clst == clst + 1) {	/* Joined the next one */
+				e->ncl += e[1].ncl;
+				for (j = i + 1; j < ci->n_ent - 1; j++) ci->ent[j] = ci->ent[j + 1];
+				ci->n_ent--;
+			}
+			return;
+		}
+		if (fcl - (e->fcl + e->ncl - 1) < ci->gap) return;	/* Too close to the previous record */
+	}
+	if (ci->n_ent >= _CLIDX_SIZE) {		/* Full, keep every other item and double the spacing */
+		for (j = 1; j < _CLIDX_SIZE / 2; j++) ci->ent[j] = ci->ent[j * 2];
+		ci->n_ent = _CLIDX_SIZE / 2;
+		ci->gap *= 2;
+		i = clidx_search(ci, fcl);
+	}
+	for (j = ci->n_ent; j > i + 1; j--) ci->ent[j] = ci->ent[j - 1];
+	e = &ci->ent[i + 1];
+	e->fcl = fcl; e->clst = clst; e->ncl = 1;
+	ci->n_ent++;
+}
+
+
+#if !_FS_READONLY
+static
+void clidx_trim (
+	FATFS* fs,		/* File system object */
+	const FIL* fp,	/* File object */
+	DWORD ncl		/* Number of clusters left in the chain */
+)
+{
+	CLIDX *ci;
+	CLIDX_ENT *e;
+
+
+	ci = clidx_get(fs, fp, 0);
+	if (!ci) return;
+	while (ci->n_ent && ci->ent[ci->n_ent - 1].fcl >= ncl) ci->n_ent--;
+	if (ci->n_ent) {
+		e = &ci->ent[ci->n_ent - 1];
+		if (e->fcl + e->ncl > ncl) e->ncl = ncl - e->fcl;
+	}
+}
+#endif
+
+
+static
+void clidx_release (
+	FATFS* fs,		/* File system object */
+	const FIL* fp	/* File object */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < _CLIDX_FILES; i++) {
+		if (fs->clidx[i] && fs->clidx[i]->fp == fp) fs->clidx[i]->fp = 0;
+	}
+}
+
+
+static
+void clidx_free (
+	FATFS* fs		/* File system object */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < _CLIDX_FILES; i++) {
+		if (fs->clidx[i]) ff_memfree(fs->clidx[i]);
+		fs->clidx[i] = 0;
+	}
+	fs->clidx_stamp = 0;
+}
+
+#endif	/* _USE_CLIDX */
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Set directory index                              */
 /*-----------------------------------------------------------------------*/
@@ -3273,10 +3478,17 @@ FRESULT f_mount (
 		if (!ff_del_syncobj(cfs->sobj)) return FR_INT_ERR;
 #endif
 		cfs->fs_type = 0;				/* Clear old fs object */
+#if _USE_CLIDX
+		clidx_free(cfs);				/* Discard cluster indexes of the old fs object */
+#endif
 	}
 
 	if (fs) {
 		fs->fs_type = 0;				/* Clear new fs object */
+#if _USE_CLIDX
+		mem_set(fs->clidx, 0, sizeof fs->clidx);
+		fs->clidx_stamp = 0;
+#endif
 #if _FS_REENTRANT						/* Create sync object for the new volume */
 		if (!ff_cre_syncobj((BYTE)vol, &fs->sobj)) return FR_INT_ERR;
 #endif
@@ -3449,6 +3661,9 @@ FRESULT f_open (
 			}
 #if _USE_FASTSEEK
 			fp->cltbl = 0;			/* Disable fast seek mode */
+#endif
+#if _USE_CLIDX
+			clidx_release(fs, fp);	/* Forget an index left by a former use of the object */
 #endif
 			fp->obj.fs = fs;	 	/* Validate the file object */
 			fp->obj.id = fs->id;
@@ -3820,6 +4035,9 @@ FRESULT f_close (
 			if (res == FR_OK)
 #endif
 			{
+#if _USE_CLIDX
+				clidx_release(fs, fp);	/* Give the cluster index slot back */
+#endif
 				fp->obj.fs = 0;			/* Invalidate file object */
 			}
 #if _FS_REENTRANT
@@ -4001,6 +4219,10 @@ FRESULT f_lseek (
 #if _USE_FASTSEEK
 	DWORD cl, pcl, ncl, tcl, dsc, tlen, ulen, *tbl;
 #endif
+#if _USE_CLIDX
+	DWORD icl, itcl, iclst;
+	CLIDX *ci = 0;
+#endif
 
 	res = validate(&fp->obj, &fs);		/* Check validity of the file object */
 	if (res == FR_OK) res = (FRESULT)fp->err;
@@ -4093,6 +4315,21 @@ FRESULT f_lseek (
 				fp->clust = clst;
 			}
 			if (clst != 0) {
+#if _USE_CLIDX
+				if (ofs > bcs && !(_FS_EXFAT && fs->fs_type == FS_EXFAT)) {	/* Start from the nearest known cluster */
+					ci = clidx_get(fs, fp, 1);
+					if (ci) {
+						icl = (DWORD)(fp->fptr / bcs);
+						clidx_note(ci, icl, clst);
+						itcl = icl + (DWORD)((ofs - 1) / bcs);
+						if (clidx_find(ci, &itcl, &iclst) && itcl > icl) {
+							fp->fptr += (FSIZE_t)(itcl - icl) * bcs;
+							ofs -= (FSIZE_t)(itcl - icl) * bcs;
+							clst = fp->clust = iclst;
+						}
+					}
+				}
+#endif
 				while (ofs > bcs) {						/* Cluster following loop */
 					ofs -= bcs; fp->fptr += bcs;
 #if !_FS_READONLY
@@ -4113,6 +4350,9 @@ FRESULT f_lseek (
 					if (clst == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
 					if (clst <= 1 || clst >= fs->n_fatent) ABORT(fs, FR_INT_ERR);
 					fp->clust = clst;
+#if _USE_CLIDX
+					if (ci) clidx_note(ci, (DWORD)(fp->fptr / bcs), clst);	/* Record the chain walked through */
+#endif
 				}
 				fp->fptr += ofs;
 				if (ofs % SS(fs)) {
@@ -4491,6 +4731,11 @@ FRESULT f_truncate (
 		}
 		fp->obj.objsize = fp->fptr;	/* Set file size to current R/W point */
 		fp->flag |= FA_MODIFIED;
+#if _USE_CLIDX
+		if (res == FR_OK) {			/* Forget the removed part of the chain */
+			clidx_trim(fs, fp, fp->fptr ? (DWORD)((fp->fptr - 1) / ((DWORD)fs->csize * SS(fs))) + 1 : 0);
+		}
+#endif
 #if !_FS_TINY
 		if (res == FR_OK && (fp->flag & FA_DIRTY)) {
 			if (disk_write(fs->drv, fp->buf, fp->sect, 1) != RES_OK) {
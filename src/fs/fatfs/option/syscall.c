@@ -170,7 +170,7 @@ void ff_rel_grant (
 
 
 
-#if _USE_LFN == 3	/* LFN with a working buffer on the heap */
+#if _USE_LFN == 3 || _USE_CLIDX	/* LFN working buffer or cluster index on the heap */
 /*------------------------------------------------------------------------*/
 /* Allocate a memory block                                                */
 /*------------------------------------------------------------------------*/
@@ -0,0 +1,137 @@
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <string.h>
+#include "jpeg/jpeg_rc.h"
+
+#define JPEG_RC_PAYBACK		(4)	/* frames over which a debt is paid back */
+#define JPEG_RC_DEBT_MAX	(4)	/* budgets, debt kept when quality cannot go lower */
+#define JPEG_RC_TARGET_MIN	(4)	/* target never drops below budget / 4 */
+#define JPEG_RC_DEADBAND	(16)	/* sizes within target / 16 keep the quality */
+
+/* Same mapping as jpeg_set_quant_tbl() */
+int JpegQualityToScale(int quality)
+{
+	if (quality <= 0)
+		quality = 1;
+	if (quality >= 100)
+		return 1;
+	if (quality < 50)
+		return 5000 / quality;
+	return 200 - quality * 2;
+}
+
+/* Highest quality whose scale is not below the given one */
+int JpegScaleToQuality(int scale)
+{
+	if (scale < 1)
+		scale = 1;
+	if (scale > JPEG_RC_SCALE_MAX)
+		scale = JPEG_RC_SCALE_MAX;
+	if (scale <= 100)
+		return (200 - scale) / 2;
+	return 5000 / scale;
+}
+
+static int JpegRcClamp(const JpegRcParam *p, int quality)
+{
+	if (quality < p->min_quality)
+		quality = p->min_quality;
+	if (quality > p->max_quality)
+		quality = p->max_quality;
+	return quality;
+}
+
+void JpegRcInit(JpegRc *rc, const JpegRcParam *param)
+{
+	JpegRcParam *p = &rc->param;
+
+	memset(rc, 0, sizeof(JpegRc));
+	*p = *param;
+	if (p->min_quality == 0)
+		p->min_quality = 1;
+	if (p->max_quality == 0 || p->max_quality > 99)
+		p->max_quality = 99;
+	if (p->min_quality > p->max_quality)
+		p->min_quality = p->max_quality;
+	if (p->quality == 0)
+		p->quality = (p->min_quality + p->max_quality) / 2;
+
+	if (p->mode == JPEG_RC_BITRATE)
+		rc->budget = p->target / 8 / (p->fps ? p->fps : 1);
+	else
+		rc->budget = p->target;
+	if (rc->budget == 0)
+		rc->budget = 1;
+
+	rc->quality = JpegRcClamp(p, p->quality);
+	rc->scale = JpegQualityToScale(rc->quality);
+}
+
+void JpegRcSetBacklog(JpegRc *rc, uint32_t bytes)
+{
+	rc->backlog = bytes;
+}
+
+int JpegRcUpdate(JpegRc *rc, uint32_t size)
+{
+	const JpegRcParam *p = &rc->param;
+	int32_t budget = (int32_t)rc->budget;
+	int32_t target = budget;
+	uint64_t complexity;
+	uint32_t scale, dev;
+	int quality, oversize = 0;
+
+	if (p->mode == JPEG_RC_OFF)
+		return rc->quality;
+	rc->frames++;
+
+	if (p->mode == JPEG_RC_BITRATE) {
+		/* a cheap scene earns at most one frame of credit, an expensive
+		 * one is paid back over the next frames */
+		rc->debt += (int32_t)size - budget;
+		if (rc->debt < -budget)
+			rc->debt = -budget;
+		if (rc->debt > JPEG_RC_DEBT_MAX * budget)
+			rc->debt = JPEG_RC_DEBT_MAX * budget;
+		target -= rc->debt / JPEG_RC_PAYBACK;
+	}
+	/* the link is slower than the frames, let the consumer catch up */
+	if (rc->backlog)
+		target -= rc->backlog / 2 > (uint32_t)budget ? budget : (int32_t)(rc->backlog / 2);
+	if (target < budget / JPEG_RC_TARGET_MIN)
+		target = budget / JPEG_RC_TARGET_MIN;
+	/* keep a quarter of the buffer for a misprediction */
+	if (p->max_size && target > (int32_t)(p->max_size - p->max_size / 4))
+		target = p->max_size - p->max_size / 4;
+	if (target < 1)
+		target = 1;
+
+	complexity = (uint64_t)size * rc->scale;
+	if (p->max_size && size >= p->max_size) {
+		/* truncated, the real size is unknown */
+		rc->oversize++;
+		complexity *= 2;
+		oversize = 1;
+	}
+
+	dev = size > (uint32_t)target ? size - target : target - size;
+	if (!oversize && dev <= (uint32_t)target / JPEG_RC_DEADBAND)
+		return rc->quality;
+
+	complexity /= (uint32_t)target;
+	scale = complexity > JPEG_RC_SCALE_MAX ? JPEG_RC_SCALE_MAX : (uint32_t)complexity;
+	quality = JpegScaleToQuality(scale);
+	if (p->max_step && quality > rc->quality + p->max_step)
+		quality = rc->quality + p->max_step;
+	quality = JpegRcClamp(p, quality);
+
+	rc->quality = quality;
+	rc->scale = JpegQualityToScale(quality);
+	return quality;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
@@ -136,10 +136,29 @@ void JPEG_Write_Header(void *handle)
 
 }
 
+/* SOI and the JFIF APP0 segment come before the tables */
+#define JPEG_HEADER_DQT_OFFSET	(2 + 2 + 16)
+
+/* Update the quantisation tables of a header written by JPEG_Write_Header,
+ * the rest of it does not depend on the quality */
+void JPEG_Write_QuantTbl(void *handle)
+{
+	JpegCtx *jpegCtx = (JpegCtx *)handle;
+	if (!jpegCtx) {
+		loge("invalid handle");
+		return;
+	}
+
+	jpegCtx->BaseAddr += JPEG_HEADER_DQT_OFFSET;
+	emit_dqt(jpegCtx,0);
+	emit_dqt(jpegCtx,1);
+}
+
 static struct jpeg_ctl_ops encoder_jpeg = {
 	.writeHeader  = JPEG_Write_Header,
 	.setParameter = JpegSetParameter,
 	.setQuantTbl  = jpeg_set_quant_tbl,
+	.writeQuantTbl = JPEG_Write_QuantTbl,
 };
 
 JpegCtx *JpegEncCreate()
@@ -30,6 +30,7 @@
 #include "kernel/os/os_cpuusage.h"
 #include "os_util.h"
 #include "cpuusage.h"
+#include "task.h"
 
 /*
  * print_s: 0: not print, other: print cpu usage every print_s seconds.
@@ -45,3 +46,78 @@ uint32_t OS_CpuUsageGet(void)
 {
 	return OSGetCpuUsage();
 }
+
+#if (configGENERATE_RUN_TIME_STATS == 1)
+
+#define OS_CPUUSAGE_THREAD_MAX  48
+
+/* run time of each thread at the previous call, by task number */
+static struct {
+	uint32_t num;
+	uint32_t runTime;
+} os_cpuusage_last[OS_CPUUSAGE_THREAD_MAX];
+static uint32_t os_cpuusage_last_cnt;
+static uint32_t os_cpuusage_last_total;
+
+static uint32_t OS_CpuUsageLastRunTime(uint32_t num)
+{
+	uint32_t i;
+
+	for (i = 0; i < os_cpuusage_last_cnt; i++) {
+		if (os_cpuusage_last[i].num == num)
+			return os_cpuusage_last[i].runTime;
+	}
+	return 0; /* created since, count from 0 */
+}
+
+void OS_CpuUsageThreadShow(void)
+{
+	TaskStatus_t *status, tmp;
+	UBaseType_t num, i, j;
+	uint32_t *runTime, total, window, delta, permille;
+
+	num = uxTaskGetNumberOfTasks();
+	status = OS_Malloc(num * (sizeof(TaskStatus_t) + sizeof(uint32_t)));
+	if (status == NULL) {
+		OS_ERR("no mem\n");
+		return;
+	}
+	runTime = (uint32_t *)&status[num];
+	num = uxTaskGetSystemState(status, num, &total);
+
+	/* ulRunTimeCounter is the delta from now on, busiest first */
+	for (i = 0; i < num; i++) {
+		runTime[i] = status[i].ulRunTimeCounter;
+		status[i].ulRunTimeCounter -= OS_CpuUsageLastRunTime(status[i].xTaskNumber);
+	}
+	for (i = 0; i < num && i < OS_CPUUSAGE_THREAD_MAX; i++) {
+		os_cpuusage_last[i].num = status[i].xTaskNumber;
+		os_cpuusage_last[i].runTime = runTime[i];
+	}
+	os_cpuusage_last_cnt = i;
+	for (i = 1; i < num; i++) {
+		tmp = status[i];
+		for (j = i; j > 0 && status[j - 1].ulRunTimeCounter < tmp.ulRunTimeCounter; j--)
+			status[j] = status[j - 1];
+		status[j] = tmp;
+	}
+
+	window = total - os_cpuusage_last_total;
+	os_cpuusage_last_total = total;
+	if (window == 0)
+		window = 1;
+
+	OS_LOG(1, "%*sPri Num  CPU%%   Run(us) in %u ms\n",
+	       -configMAX_TASK_NAME_LEN, "Name", window / 1000);
+	for (i = 0; i < num; i++) {
+		delta = status[i].ulRunTimeCounter;
+		permille = (uint32_t)((uint64_t)delta * 1000 / window);
+		OS_LOG(1, "%*.*s%-3lu %-4lu %3u.%u %9u\n",
+		       -configMAX_TASK_NAME_LEN, configMAX_TASK_NAME_LEN,
+		       status[i].pcTaskName, status[i].uxCurrentPriority,
+		       status[i].xTaskNumber, permille / 10, permille % 10, delta);
+	}
+	OS_Free(status);
+}
+
+#endif /* configGENERATE_RUN_TIME_STATS */
@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "kernel/os/os_trace.h"
+#include "os_util.h"
+#include "task.h"
+
+#ifdef __CONFIG_OS_TRACE
+
+#ifdef __CONFIG_ROM_FREERTOS
+#error "__CONFIG_OS_TRACE needs FreeRTOS built from source"
+#endif
+
+#include "driver/chip/hal_nvic.h"
+#include "os_trace_ring.h"
+
+#define OS_TRACE_TICK_US        (1000000U / configTICK_RATE_HZ)
+#define OS_TRACE_READY_SLOTS    32  /* power of 2 */
+#define OS_TRACE_DUMP_LINE      32
+
+#define OS_TRACE_F_RING         (OS_TRACE_F_SCHED | OS_TRACE_F_ISR)
+
+static struct {
+	volatile uint32_t flags;
+	OS_TraceRing_t ring;
+	void *alloc;                                /* buffer allocated by us */
+
+	/* wake time of ready tasks, by task number */
+	uint16_t readyNum[OS_TRACE_READY_SLOTS];
+	uint32_t readyTs[OS_TRACE_READY_SLOTS];
+	uint32_t lat[OS_TRACE_PRIO_MAX][OS_TRACE_LAT_BUCKETS];
+	uint32_t latMax[OS_TRACE_PRIO_MAX];
+
+	/* original handlers of the wrapped exceptions */
+	NVIC_IRQHandler handler[NVIC_VECTOR_TABLE_SIZE];
+} os_trace;
+
+/*
+ * Free running us clock from the tick count and the SysTick, also the run
+ * time stats clock of FreeRTOS. Wraps after 71 minutes.
+ */
+uint32_t OS_TraceClock(void)
+{
+	uint32_t ticks, load, val;
+
+	ticks = xTaskGetTickCountFromISR();
+	load = SysTick->LOAD;
+	val = SysTick->VAL;
+	/* wrapped, but the tick interrupt is not taken yet */
+	if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) && val > load / 2)
+		ticks++;
+
+	return ticks * OS_TRACE_TICK_US + (load - val) * OS_TRACE_TICK_US / (load + 1);
+}
+
+static __always_inline uint32_t OS_TracePrio(uint32_t prio)
+{
+	return prio < OS_TRACE_PRIO_MAX ? prio : OS_TRACE_PRIO_MAX - 1;
+}
+
+static __always_inline uint32_t OS_TraceLatBucket(uint32_t us)
+{
+	uint32_t b = 32 - __CLZ(us); /* 0 for 0 us, 1 for 1 us, 2 for 2..3 us */
+
+	return b < OS_TRACE_LAT_BUCKETS ? b : OS_TRACE_LAT_BUCKETS - 1;
+}
+
+/*
+ * Kernel hooks, see FreeRTOSConfig.h. They run in kernel critical sections
+ * or in the context switch, so they don't race with each other.
+ */
+void OS_TraceTaskCreate(uint32_t num, uint32_t prio, const char *name)
+{
+	if (os_trace.flags & OS_TRACE_F_RING)
+		OS_TraceRingTaskSet(&os_trace.ring, num, prio, name);
+}
+
+void OS_TraceTaskReady(uint32_t num, uint32_t prio)
+{
+	uint32_t flags = os_trace.flags;
+	uint32_t ts, slot;
+
+	if (flags == 0)
+		return;
+
+	ts = OS_TraceClock();
+	if (flags & OS_TRACE_F_LATENCY) {
+		slot = num & (OS_TRACE_READY_SLOTS - 1);
+		/* keep the first wakeup if it's made ready again before running */
+		if (os_trace.readyNum[slot] != num) {
+			os_trace.readyNum[slot] = num;
+			os_trace.readyTs[slot] = ts;
+		}
+	}
+	if (flags & OS_TRACE_F_SCHED)
+		OS_TraceRingPut(&os_trace.ring, ts, OS_TRACE_EV_READY, prio, num);
+}
+
+void OS_TraceTaskSwitchedIn(uint32_t num, uint32_t prio)
+{
+	uint32_t flags = os_trace.flags;
+	uint32_t ts, slot, lat;
+
+	if (flags == 0)
+		return;
+
+	ts = OS_TraceClock();
+	if (flags & OS_TRACE_F_LATENCY) {
+		slot = num & (OS_TRACE_READY_SLOTS - 1);
+		if (os_trace.readyNum[slot] == num) {
+			os_trace.readyNum[slot] = 0;
+			lat = ts - os_trace.readyTs[slot];
+			prio = OS_TracePrio(prio);
+			os_trace.lat[prio][OS_TraceLatBucket(lat)]++;
+			if (lat > os_trace.latMax[prio])
+				os_trace.latMax[prio] = lat;
+		}
+	}
+	if (flags & OS_TRACE_F_SCHED)
+		OS_TraceRingPut(&os_trace.ring, ts, OS_TRACE_EV_SWITCH_IN, prio, num);
+}
+
+/* Installed in the vector table in place of the exception handlers */
+static void OS_TraceIrqHandler(void)
+{
+	uint32_t exc = __get_IPSR();
+
+	OS_TraceRingPut(&os_trace.ring, OS_TraceClock(), OS_TRACE_EV_ISR_ENTER, 0, exc);
+	os_trace.handler[exc]();
+	OS_TraceRingPut(&os_trace.ring, OS_TraceClock(), OS_TRACE_EV_ISR_EXIT, 0, exc);
+}
+
+/*
+ * Wrap SysTick and the peripheral interrupts. PendSV and SVC are left alone,
+ * they depend on the exception frame. Handlers set while tracing bypass it.
+ */
+static void OS_TraceIrqWrap(int wrap)
+{
+	uint32_t *vectors = (uint32_t *)SCB->VTOR;
+	uint32_t exc;
+
+	for (exc = SysTick_IRQn + NVIC_PERIPH_IRQ_OFFSET; exc < NVIC_VECTOR_TABLE_SIZE; exc++) {
+		if (wrap) {
+			if (vectors[exc] == (uint32_t)OS_TraceIrqHandler)
+				continue;
+			os_trace.handler[exc] = (NVIC_IRQHandler)vectors[exc];
+			vectors[exc] = (uint32_t)OS_TraceIrqHandler;
+		} else if (vectors[exc] == (uint32_t)OS_TraceIrqHandler) {
+			vectors[exc] = (uint32_t)os_trace.handler[exc];
+		}
+	}
+	__DSB();
+}
+
+/* Name the tasks alive now, the others are added as they are created */
+static void OS_TraceTaskUpdate(void)
+{
+	TaskStatus_t *status;
+	UBaseType_t num, i;
+
+	num = uxTaskGetNumberOfTasks();
+	status = OS_Malloc(num * sizeof(TaskStatus_t));
+	if (status == NULL) {
+		OS_ERR("no mem\n");
+		return;
+	}
+
+	num = uxTaskGetSystemState(status, num, NULL);
+	for (i = 0; i < num; i++) {
+		taskENTER_CRITICAL();
+		OS_TraceRingTaskSet(&os_trace.ring, status[i].xTaskNumber,
+		                    status[i].uxBasePriority, status[i].pcTaskName);
+		taskEXIT_CRITICAL();
+	}
+	OS_Free(status);
+}
+
+OS_Status OS_TraceStart(uint32_t flags, void *buf, uint32_t size)
+{
+	if (OS_IsISRContext()) {
+		OS_ERR("%s() in ISR\n", __func__);
+		return OS_E_ISR;
+	}
+	if (os_trace.flags) {
+		OS_ERR("trace is running\n");
+		return OS_FAIL;
+	}
+
+	if (os_trace.alloc) {
+		OS_Free(os_trace.alloc);
+		os_trace.alloc = NULL;
+	}
+	os_trace.ring.hdr = NULL;
+
+	if (flags & OS_TRACE_F_RING) {
+		if (buf == NULL) {
+			buf = OS_Malloc(size);
+			if (buf == NULL) {
+				OS_ERR("no mem, size %u\n", size);
+				return OS_E_NOMEM;
+			}
+			os_trace.alloc = buf;
+		}
+		if (OS_TraceRingInit(&os_trace.ring, buf, size, flags, 1000000) != 0) {
+			OS_ERR("invalid buffer %p, size %u\n", buf, size);
+			OS_Free(os_trace.alloc);
+			os_trace.alloc = NULL;
+			return OS_E_PARAM;
+		}
+	}
+
+	if (flags & OS_TRACE_F_LATENCY)
+		OS_TraceLatencyReset();
+
+	os_trace.flags = flags;
+	if (flags & OS_TRACE_F_RING)
+		OS_TraceTaskUpdate();
+	if (flags & OS_TRACE_F_ISR)
+		OS_TraceIrqWrap(1);
+
+	return OS_OK;
+}
+
+OS_Status OS_TraceStop(void)
+{
+	uint32_t flags = os_trace.flags;
+
+	if (flags == 0)
+		return OS_OK;
+
+	if (flags & OS_TRACE_F_ISR)
+		OS_TraceIrqWrap(0);
+	if (flags & OS_TRACE_F_RING)
+		OS_TraceTaskUpdate();
+	os_trace.flags = 0;
+
+	return OS_OK;
+}
+
+void OS_TraceMark(uint16_t id)
+{
+	if (os_trace.flags & OS_TRACE_F_RING)
+		OS_TraceRingPut(&os_trace.ring, OS_TraceClock(), OS_TRACE_EV_MARK, 0, id);
+}
+
+const void *OS_TraceGetBuffer(uint32_t *size)
+{
+	if (os_trace.ring.hdr == NULL) {
+		*size = 0;
+		return NULL;
+	}
+
+	*size = OS_TraceRingSize(&os_trace.ring);
+	return os_trace.ring.hdr;
+}
+
+void OS_TraceDump(void)
+{
+	const uint8_t *buf;
+	uint32_t size, i, j;
+
+	OS_TraceStop();
+	buf = OS_TraceGetBuffer(&size);
+	if (buf == NULL) {
+		OS_LOG(1, "no trace\n");
+		return;
+	}
+
+	/* decoded by tools/os_trace_decode.py, which skips anything else */
+	OS_LOG(1, "ostrace begin %u\n", size);
+	for (i = 0; i < size; i += OS_TRACE_DUMP_LINE) {
+		OS_LOG(1, "ostrace %08x ", i);
+		for (j = i; j < i + OS_TRACE_DUMP_LINE && j < size; j++)
+			OS_LOG(1, "%02x", buf[j]);
+		OS_LOG(1, "\n");
+	}
+	OS_LOG(1, "ostrace end\n");
+}
+
+void OS_TraceLatencyShow(void)
+{
+	uint32_t prio, b, cnt;
+
+	OS_LOG(1, "wake to run latency (us)\nprio    count      max");
+	for (b = 0; b < OS_TRACE_LAT_BUCKETS - 1; b++)
+		OS_LOG(1, "   <%-4u", 1U << b);
+	OS_LOG(1, "  >=%-4u\n", 1U << (b - 1));
+
+	for (prio = 0; prio < OS_TRACE_PRIO_MAX; prio++) {
+		cnt = 0;
+		for (b = 0; b < OS_TRACE_LAT_BUCKETS; b++)
+			cnt += os_trace.lat[prio][b];
+		if (cnt == 0)
+			continue;
+		OS_LOG(1, "%-4u %8u %8u", prio, cnt, os_trace.latMax[prio]);
+		for (b = 0; b < OS_TRACE_LAT_BUCKETS; b++)
+			OS_LOG(1, " %7u", os_trace.lat[prio][b]);
+		OS_LOG(1, "\n");
+	}
+}
+
+void OS_TraceLatencyReset(void)
+{
+	taskENTER_CRITICAL();
+	OS_Memset(os_trace.readyNum, 0, sizeof(os_trace.readyNum));
+	OS_Memset(os_trace.lat, 0, sizeof(os_trace.lat));
+	OS_Memset(os_trace.latMax, 0, sizeof(os_trace.latMax));
+	taskEXIT_CRITICAL();
+}
+
+#endif /* __CONFIG_OS_TRACE */
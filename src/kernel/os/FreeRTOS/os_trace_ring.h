@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _OS_TRACE_RING_H_
+#define _OS_TRACE_RING_H_
+
+#include <stdint.h>
+#include <string.h>
+#include "kernel/os/os_trace.h"
+
+/*
+ * Trace buffer layout: header, task table, then a power of 2 ring of records.
+ * No kernel dependency, so that the ring can be built and tested on the host.
+ */
+
+#define OS_TRACE_REC_MIN    16
+
+typedef struct OS_TraceRing {
+    OS_TraceHdr_t  *hdr;
+    OS_TraceTask_t *task;
+    OS_TraceRec_t  *rec;
+    uint32_t        mask;
+} OS_TraceRing_t;
+
+static __inline int OS_TraceRingInit(OS_TraceRing_t *ring, void *buf, uint32_t size,
+                                     uint32_t flags, uint32_t clockHz)
+{
+	uint32_t off, cnt;
+
+	off = sizeof(OS_TraceHdr_t) + OS_TRACE_TASK_MAX * sizeof(OS_TraceTask_t);
+	if (buf == NULL || ((uintptr_t)buf & 3) ||
+	    size < off + OS_TRACE_REC_MIN * sizeof(OS_TraceRec_t))
+		return -1;
+
+	cnt = (size - off) / sizeof(OS_TraceRec_t);
+	while (cnt & (cnt - 1))
+		cnt &= cnt - 1; /* round down to a power of 2 */
+
+	memset(buf, 0, off + cnt * sizeof(OS_TraceRec_t));
+	ring->hdr = buf;
+	ring->task = (OS_TraceTask_t *)(ring->hdr + 1);
+	ring->rec = (OS_TraceRec_t *)((uint8_t *)buf + off);
+	ring->mask = cnt - 1;
+
+	ring->hdr->version = OS_TRACE_VERSION;
+	ring->hdr->flags = flags;
+	ring->hdr->clockHz = clockHz;
+	ring->hdr->recOffset = off;
+	ring->hdr->recCount = cnt;
+	ring->hdr->head = 0;
+	ring->hdr->taskOffset = sizeof(OS_TraceHdr_t);
+	ring->hdr->taskCount = OS_TRACE_TASK_MAX;
+	ring->hdr->taskSize = sizeof(OS_TraceTask_t);
+	ring->hdr->magic = OS_TRACE_MAGIC;
+	return 0;
+}
+
+static __inline uint32_t OS_TraceRingSize(OS_TraceRing_t *ring)
+{
+	return ring->hdr->recOffset + ring->hdr->recCount * sizeof(OS_TraceRec_t);
+}
+
+/*
+ * Lock free for any number of writers, including nested interrupts: a slot
+ * is claimed by an atomic increment of the head. The type is stored last,
+ * so a reader skips a record whose writer was interrupted (type 0).
+ */
+static __always_inline void OS_TraceRingPut(OS_TraceRing_t *ring, uint32_t ts,
+                                            uint8_t type, uint8_t prio, uint16_t arg)
+{
+	OS_TraceRec_t *rec;
+	uint32_t idx;
+
+	idx = __atomic_fetch_add(&ring->hdr->head, 1, __ATOMIC_RELAXED);
+	rec = &ring->rec[idx & ring->mask];
+	rec->type = OS_TRACE_EV_NONE;
+	__atomic_signal_fence(__ATOMIC_SEQ_CST);
+	rec->ts = ts;
+	rec->prio = prio;
+	rec->arg = arg;
+	__atomic_signal_fence(__ATOMIC_SEQ_CST);
+	rec->type = type;
+}
+
+/* Add or update a task, returns -1 if the table is full. Not reentrant. */
+static __inline int OS_TraceRingTaskSet(OS_TraceRing_t *ring, uint16_t num,
+                                        uint8_t prio, const char *name)
+{
+	OS_TraceTask_t *task, *free = NULL;
+	int i;
+
+	for (i = 0; i < OS_TRACE_TASK_MAX; i++) {
+		task = &ring->task[i];
+		if (task->num == num)
+			break;
+		if (task->num == 0 && free == NULL)
+			free = task;
+	}
+	if (i == OS_TRACE_TASK_MAX) {
+		if (free == NULL)
+			return -1;
+		task = free;
+	}
+
+	task->num = num;
+	task->prio = prio;
+	strncpy(task->name, name, OS_TRACE_NAME_LEN - 1);
+	task->name[OS_TRACE_NAME_LEN - 1] = '\0';
+	return 0;
+}
+
+#endif /* _OS_TRACE_RING_H_ */
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "kernel/os/os_cpuusage.h"
+#include "kernel/os/os_thread.h"
+#include "os_util.h"
+
+/*
+ * The process CPU time is sampled once a second against the monotonic clock,
+ * so the usage is that of one core and may exceed 100 on a multi-core host.
+ */
+
+#define OS_CPUUSAGE_STACK_SIZE  (2 * 1024)
+
+static OS_Thread_t os_cpuusage_thread;
+static uint32_t os_cpuusage_print_s;
+static uint32_t os_cpuusage;
+
+static uint64_t OS_ProcessCpuNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return (uint64_t)ts.tv_sec * OS_NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void OS_CpuUsageTask(void *arg)
+{
+	uint64_t cpu, wall, lastCpu, lastWall;
+	uint32_t sec = 0;
+
+	lastCpu = OS_ProcessCpuNs();
+	lastWall = OS_MonotonicNs();
+	for (;;) {
+		OS_MSleep(OS_MSEC_PER_SEC);
+		cpu = OS_ProcessCpuNs();
+		wall = OS_MonotonicNs();
+		if (wall > lastWall)
+			os_cpuusage = (uint32_t)((cpu - lastCpu) * 100 / (wall - lastWall));
+		lastCpu = cpu;
+		lastWall = wall;
+
+		if (os_cpuusage_print_s && ++sec >= os_cpuusage_print_s) {
+			sec = 0;
+			OS_LOG(1, "cpu usage %u%%\n", os_cpuusage);
+		}
+	}
+}
+
+/*
+ * print_s: 0: not print, other: print cpu usage every print_s seconds.
+ */
+void OS_CpuUsageInit(uint32_t print_s)
+{
+	os_cpuusage_print_s = print_s;
+	if (OS_ThreadIsValid(&os_cpuusage_thread))
+		return;
+
+	if (OS_ThreadCreate(&os_cpuusage_thread, "cpuusage", OS_CpuUsageTask, NULL,
+	                    OS_PRIORITY_IDLE, OS_CPUUSAGE_STACK_SIZE) != OS_OK) {
+		OS_ERR("create cpuusage thread failed\n");
+	}
+}
+
+uint32_t OS_CpuUsageGet(void)
+{
+	return os_cpuusage;
+}
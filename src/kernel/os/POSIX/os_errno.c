@@ -27,12 +27,16 @@
  *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifndef _UTIL_TIME_LOGGER_H_
-#define _UTIL_TIME_LOGGER_H_
+#include <errno.h>
+#include "kernel/os/os_errno.h"
+#include "os_util.h"
 
-#include <stdint.h>
+int OS_GetErrno(void)
+{
+	return errno;
+}
 
-void save_time(uint32_t t, uint32_t i);
-void get_time(void);
-
-#endif /* _UTIL_TIME_LOGGER_H_ */
+void OS_SetErrno(int err)
+{
+	errno = err;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include "kernel/os/os_mutex.h"
+#include "os_util.h"
+
+/* pthread_mutex_clocklock() is there since glibc 2.30 */
+#if defined(__GLIBC__) && \
+    ((__GLIBC__ > 2) || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 30))
+#define OS_MUTEX_USE_CLOCKLOCK  1
+#else
+#define OS_MUTEX_USE_CLOCKLOCK  0
+#endif
+
+/* Mutex private data definition */
+typedef struct OS_MutexPriv {
+    pthread_mutex_t     mutex;
+    OS_ThreadHandle_t   owner;
+    uint32_t            depth;    /* recursive lock depth of the owner */
+} OS_MutexPriv_t;
+
+static OS_Status OS_MutexInit(OS_Mutex_t *mutex, int type)
+{
+	OS_MutexPriv_t *priv;
+	pthread_mutexattr_t attr;
+
+	priv = OS_Malloc(sizeof(OS_MutexPriv_t));
+	if (priv == NULL) {
+		OS_ERR("err %"OS_HANDLE_F"\n", priv);
+		return OS_FAIL;
+	}
+
+	/* error checking, so that relocking a mutex fails instead of hanging */
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, type);
+	pthread_mutex_init(&priv->mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+	priv->owner = OS_INVALID_HANDLE;
+	priv->depth = 0;
+	mutex->handle = priv;
+	return OS_OK;
+}
+
+static OS_Status OS_MutexDeinit(OS_Mutex_t *mutex)
+{
+	OS_MutexPriv_t *priv = mutex->handle;
+
+	pthread_mutex_destroy(&priv->mutex);
+	OS_Free(priv);
+	OS_MutexSetInvalid(mutex);
+	return OS_OK;
+}
+
+static OS_Status OS_MutexTake(OS_Mutex_t *mutex, OS_Time_t waitMS)
+{
+	OS_MutexPriv_t *priv = mutex->handle;
+	struct timespec ts;
+	int ret;
+
+	if (waitMS == OS_WAIT_FOREVER) {
+		ret = pthread_mutex_lock(&priv->mutex);
+	} else if (waitMS == 0) {
+		ret = pthread_mutex_trylock(&priv->mutex);
+	} else {
+#if OS_MUTEX_USE_CLOCKLOCK
+		OS_CalcDeadline(&ts, waitMS);
+		ret = pthread_mutex_clocklock(&priv->mutex, CLOCK_MONOTONIC, &ts);
+#else
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += waitMS / OS_MSEC_PER_SEC;
+		ts.tv_nsec += (long)(waitMS % OS_MSEC_PER_SEC) * OS_NSEC_PER_MSEC;
+		if (ts.tv_nsec >= OS_NSEC_PER_SEC) {
+			ts.tv_sec++;
+			ts.tv_nsec -= OS_NSEC_PER_SEC;
+		}
+		ret = pthread_mutex_timedlock(&priv->mutex, &ts);
+#endif
+	}
+
+	if (ret != 0) {
+		if (ret == EDEADLK) {
+			OS_ERR("mutex %"OS_HANDLE_F" relock\n", priv);
+			return OS_FAIL;
+		}
+		OS_DBG("%s() fail @ %d, %"OS_TIME_F" ms\n", __func__, __LINE__, waitMS);
+		return OS_E_TIMEOUT;
+	}
+
+	priv->owner = OS_ThreadGetCurrentHandle();
+	priv->depth++;
+	return OS_OK;
+}
+
+static OS_Status OS_MutexGive(OS_Mutex_t *mutex)
+{
+	OS_MutexPriv_t *priv = mutex->handle;
+
+	/* only the owner ever stores its own handle here */
+	if (priv->owner != OS_ThreadGetCurrentHandle()) {
+		OS_DBG("%s() fail @ %d\n", __func__, __LINE__);
+		return OS_FAIL;
+	}
+
+	if (--priv->depth == 0)
+		priv->owner = OS_INVALID_HANDLE;
+	pthread_mutex_unlock(&priv->mutex);
+	return OS_OK;
+}
+
+OS_Status OS_MutexCreate(OS_Mutex_t *mutex)
+{
+//	OS_HANDLE_ASSERT(!OS_MutexIsValid(mutex), mutex->handle);
+
+	return OS_MutexInit(mutex, PTHREAD_MUTEX_ERRORCHECK);
+}
+
+OS_Status OS_MutexDelete(OS_Mutex_t *mutex)
+{
+	OS_HANDLE_ASSERT(OS_MutexIsValid(mutex), mutex->handle);
+
+	return OS_MutexDeinit(mutex);
+}
+
+OS_Status OS_MutexLock(OS_Mutex_t *mutex, OS_Time_t waitMS)
+{
+	OS_HANDLE_ASSERT(OS_MutexIsValid(mutex), mutex->handle);
+
+	return OS_MutexTake(mutex, waitMS);
+}
+
+OS_Status OS_MutexUnlock(OS_Mutex_t *mutex)
+{
+	OS_HANDLE_ASSERT(OS_MutexIsValid(mutex), mutex->handle);
+
+	return OS_MutexGive(mutex);
+}
+
+OS_Status OS_RecursiveMutexCreate(OS_Mutex_t *mutex)
+{
+//	OS_HANDLE_ASSERT(!OS_MutexIsValid(mutex), mutex->handle);
+
+	return OS_MutexInit(mutex, PTHREAD_MUTEX_RECURSIVE);
+}
+
+OS_Status OS_RecursiveMutexDelete(OS_Mutex_t *mutex)
+{
+	OS_HANDLE_ASSERT(OS_MutexIsValid(mutex), mutex->handle);
+
+	return OS_MutexDeinit(mutex);
+}
+
+OS_Status OS_RecursiveMutexLock(OS_Mutex_t *mutex, OS_Time_t waitMS)
+{
+	OS_HANDLE_ASSERT(OS_MutexIsValid(mutex), mutex->handle);
+
+	return OS_MutexTake(mutex, waitMS);
+}
+
+OS_Status OS_RecursiveMutexUnlock(OS_Mutex_t *mutex)
+{
+	OS_HANDLE_ASSERT(OS_MutexIsValid(mutex), mutex->handle);
+
+	return OS_MutexGive(mutex);
+}
+
+OS_ThreadHandle_t OS_MutexGetOwner(OS_Mutex_t *mutex)
+{
+	OS_MutexPriv_t *priv;
+
+	if (!OS_MutexIsValid(mutex)) {
+		return OS_INVALID_HANDLE;
+	}
+
+	priv = mutex->handle;
+	return priv->owner;
+}
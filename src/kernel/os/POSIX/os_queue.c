@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include "kernel/os/os_queue.h"
+#include "os_util.h"
+
+/* Queue private data definition, a ring of fixed size items */
+typedef struct OS_QueuePriv {
+    pthread_mutex_t lock;
+    pthread_cond_t  notEmpty;
+    pthread_cond_t  notFull;
+    uint32_t        itemSize;
+    uint32_t        queueLen;
+    uint32_t        count;
+    uint32_t        head;
+    uint8_t         buf[];
+} OS_QueuePriv_t;
+
+OS_Status OS_QueueCreate(OS_Queue_t *queue, uint32_t queueLen, uint32_t itemSize)
+{
+	OS_QueuePriv_t *priv;
+
+//	OS_HANDLE_ASSERT(!OS_QueueIsValid(queue), queue->handle);
+
+	if (queueLen == 0 || itemSize == 0) {
+		OS_ERR("invalid len %u, size %u\n", queueLen, itemSize);
+		return OS_E_PARAM;
+	}
+
+	priv = OS_Malloc(sizeof(OS_QueuePriv_t) + (size_t)queueLen * itemSize);
+	if (priv == NULL) {
+		OS_ERR("err %"OS_HANDLE_F"\n", priv);
+		return OS_FAIL;
+	}
+	pthread_mutex_init(&priv->lock, NULL);
+	OS_CondInit(&priv->notEmpty);
+	OS_CondInit(&priv->notFull);
+	priv->itemSize = itemSize;
+	priv->queueLen = queueLen;
+	priv->count = 0;
+	priv->head = 0;
+	queue->handle = priv;
+	return OS_OK;
+}
+
+OS_Status OS_QueueDelete(OS_Queue_t *queue)
+{
+	OS_QueuePriv_t *priv;
+	uint32_t count;
+
+	OS_HANDLE_ASSERT(OS_QueueIsValid(queue), queue->handle);
+
+	priv = queue->handle;
+	pthread_mutex_lock(&priv->lock);
+	count = priv->count;
+	pthread_mutex_unlock(&priv->lock);
+	if (count != 0) {
+		OS_ERR("queue %"OS_HANDLE_F" is not empty\n", priv);
+		return OS_FAIL;
+	}
+
+	pthread_cond_destroy(&priv->notFull);
+	pthread_cond_destroy(&priv->notEmpty);
+	pthread_mutex_destroy(&priv->lock);
+	OS_Free(priv);
+	OS_QueueSetInvalid(queue);
+	return OS_OK;
+}
+
+/* Wait once on @cond with the queue locked, returns 0 or ETIMEDOUT */
+static int OS_QueueWait(OS_QueuePriv_t *priv, pthread_cond_t *cond,
+                        OS_Time_t waitMS, struct timespec *deadline)
+{
+	int ret = 0;
+
+	if (waitMS == 0)
+		return ETIMEDOUT;
+
+	pthread_cleanup_push(OS_MutexCleanup, &priv->lock);
+	if (waitMS == OS_WAIT_FOREVER) {
+		pthread_cond_wait(cond, &priv->lock);
+	} else {
+		if (deadline->tv_sec == 0 && deadline->tv_nsec == 0)
+			OS_CalcDeadline(deadline, waitMS);
+		ret = pthread_cond_timedwait(cond, &priv->lock, deadline);
+	}
+	pthread_cleanup_pop(0);
+	return ret;
+}
+
+OS_Status OS_QueueSend(OS_Queue_t *queue, const void *item, OS_Time_t waitMS)
+{
+	OS_QueuePriv_t *priv;
+	uint32_t tail;
+	struct timespec deadline = { 0, 0 };
+
+	OS_HANDLE_ASSERT(OS_QueueIsValid(queue), queue->handle);
+
+	priv = queue->handle;
+	pthread_mutex_lock(&priv->lock);
+	while (priv->count >= priv->queueLen) {
+		/* room may still appear just as the wait times out */
+		if (OS_QueueWait(priv, &priv->notFull, waitMS, &deadline) != 0 &&
+		    priv->count >= priv->queueLen) {
+			pthread_mutex_unlock(&priv->lock);
+			OS_DBG("%s() fail @ %d, %"OS_TIME_F" ms\n", __func__, __LINE__, waitMS);
+			return OS_E_TIMEOUT;
+		}
+	}
+
+	tail = priv->head + priv->count;
+	if (tail >= priv->queueLen)
+		tail -= priv->queueLen;
+	OS_Memcpy(priv->buf + (size_t)tail * priv->itemSize, item, priv->itemSize);
+	priv->count++;
+	pthread_cond_signal(&priv->notEmpty);
+	pthread_mutex_unlock(&priv->lock);
+
+	return OS_OK;
+}
+
+OS_Status OS_QueueReceive(OS_Queue_t *queue, void *item, OS_Time_t waitMS)
+{
+	OS_QueuePriv_t *priv;
+	struct timespec deadline = { 0, 0 };
+
+	OS_HANDLE_ASSERT(OS_QueueIsValid(queue), queue->handle);
+
+	priv = queue->handle;
+	pthread_mutex_lock(&priv->lock);
+	while (priv->count == 0) {
+		if (OS_QueueWait(priv, &priv->notEmpty, waitMS, &deadline) != 0 &&
+		    priv->count == 0) {
+			pthread_mutex_unlock(&priv->lock);
+			OS_DBG("%s() fail @ %d, %"OS_TIME_F" ms\n", __func__, __LINE__, waitMS);
+			return OS_E_TIMEOUT;
+		}
+	}
+
+	OS_Memcpy(item, priv->buf + (size_t)priv->head * priv->itemSize, priv->itemSize);
+	if (++priv->head == priv->queueLen)
+		priv->head = 0;
+	priv->count--;
+	pthread_cond_signal(&priv->notFull);
+	pthread_mutex_unlock(&priv->lock);
+
+	return OS_OK;
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include "kernel/os/os_semaphore.h"
+#include "os_util.h"
+
+/*
+ * Counting semaphore on a futex: the count is taken and given with atomics
+ * and the kernel is only entered when a taker has to sleep or a giver sees
+ * sleepers, like the uncontended path of the FreeRTOS queue.
+ */
+
+/* Semaphore private data definition */
+typedef struct OS_SemaphorePriv {
+    uint32_t count;
+    uint32_t maxCount;
+    uint32_t waiters;
+} OS_SemaphorePriv_t;
+
+static int OS_FutexWait(uint32_t *addr, uint32_t val, const struct timespec *deadline)
+{
+	/* FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC timeout */
+	return syscall(SYS_futex, addr, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG,
+	               val, deadline, NULL, FUTEX_BITSET_MATCH_ANY);
+}
+
+static void OS_FutexWake(uint32_t *addr, int n)
+{
+	syscall(SYS_futex, addr, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, n, NULL, NULL, 0);
+}
+
+static OS_Status OS_SemaphoreInit(OS_Semaphore_t *sem, uint32_t initCount, uint32_t maxCount)
+{
+	OS_SemaphorePriv_t *priv;
+
+	if (maxCount == 0 || initCount > maxCount) {
+		OS_ERR("invalid count %u, max %u\n", initCount, maxCount);
+		return OS_E_PARAM;
+	}
+
+	priv = OS_Malloc(sizeof(OS_SemaphorePriv_t));
+	if (priv == NULL) {
+		OS_ERR("err %"OS_HANDLE_F"\n", priv);
+		return OS_FAIL;
+	}
+	priv->count = initCount;
+	priv->maxCount = maxCount;
+	priv->waiters = 0;
+	sem->handle = priv;
+	return OS_OK;
+}
+
+OS_Status OS_SemaphoreCreate(OS_Semaphore_t *sem, uint32_t initCount, uint32_t maxCount)
+{
+//	OS_HANDLE_ASSERT(!OS_SemaphoreIsValid(sem), sem->handle);
+
+	return OS_SemaphoreInit(sem, initCount, maxCount);
+}
+
+OS_Status OS_SemaphoreCreateBinary(OS_Semaphore_t *sem)
+{
+//	OS_HANDLE_ASSERT(!OS_SemaphoreIsValid(sem), sem->handle);
+
+	return OS_SemaphoreInit(sem, 0, 1);
+}
+
+OS_Status OS_SemaphoreDelete(OS_Semaphore_t *sem)
+{
+	OS_HANDLE_ASSERT(OS_SemaphoreIsValid(sem), sem->handle);
+
+	OS_Free(sem->handle);
+	OS_SemaphoreSetInvalid(sem);
+	return OS_OK;
+}
+
+static __always_inline int OS_SemaphoreTryTake(OS_SemaphorePriv_t *priv)
+{
+	uint32_t count = __atomic_load_n(&priv->count, __ATOMIC_RELAXED);
+
+	while (count > 0) {
+		if (__atomic_compare_exchange_n(&priv->count, &count, count - 1, 1,
+		                                __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return 1;
+	}
+	return 0;
+}
+
+OS_Status OS_SemaphoreWait(OS_Semaphore_t *sem, OS_Time_t waitMS)
+{
+	OS_SemaphorePriv_t *priv;
+	struct timespec ts, *deadline = NULL;
+	int ret;
+
+	OS_HANDLE_ASSERT(OS_SemaphoreIsValid(sem), sem->handle);
+
+	priv = sem->handle;
+	if (OS_SemaphoreTryTake(priv))
+		return OS_OK;
+
+	if (waitMS != OS_WAIT_FOREVER && waitMS != 0) {
+		OS_CalcDeadline(&ts, waitMS);
+		deadline = &ts;
+	}
+
+	while (waitMS != 0) {
+		__atomic_fetch_add(&priv->waiters, 1, __ATOMIC_SEQ_CST);
+		/* returns at once if a give raced in before the sleep */
+		ret = OS_FutexWait(&priv->count, 0, deadline);
+		__atomic_fetch_sub(&priv->waiters, 1, __ATOMIC_SEQ_CST);
+		if (OS_SemaphoreTryTake(priv))
+			return OS_OK;
+		if (ret != 0 && errno == ETIMEDOUT)
+			break;
+		pthread_testcancel();
+	}
+
+	OS_DBG("%s() fail @ %d, %"OS_TIME_F" ms\n", __func__, __LINE__, waitMS);
+	return OS_E_TIMEOUT;
+}
+
+OS_Status OS_SemaphoreRelease(OS_Semaphore_t *sem)
+{
+	OS_SemaphorePriv_t *priv;
+	uint32_t count;
+
+	OS_HANDLE_ASSERT(OS_SemaphoreIsValid(sem), sem->handle);
+
+	priv = sem->handle;
+	count = __atomic_load_n(&priv->count, __ATOMIC_RELAXED);
+	do {
+		if (count >= priv->maxCount) {
+			OS_DBG("%s() fail @ %d\n", __func__, __LINE__);
+			return OS_FAIL;
+		}
+	} while (!__atomic_compare_exchange_n(&priv->count, &count, count + 1, 1,
+	                                      __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+
+	if (__atomic_load_n(&priv->waiters, __ATOMIC_SEQ_CST))
+		OS_FutexWake(&priv->count, 1);
+
+	return OS_OK;
+}
@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sched.h>
+#include <unistd.h>
+#include <limits.h>
+#include "kernel/os/os_thread.h"
+#include "os_util.h"
+
+/*
+ * Threads are plain pthreads that run as soon as they are created, the host
+ * scheduler is in charge. OS_Priority is recorded only: real-time policies
+ * need privileges a benchmark run should not depend on.
+ */
+
+#define OS_THREAD_NAME_LEN      16
+
+/* host code (libc, 64-bit pointers) needs far more stack than the target */
+#define OS_THREAD_STACK_SCALE   4
+#define OS_THREAD_STACK_MIN     (64 * 1024)
+
+/* Thread private data definition */
+typedef struct OS_ThreadPriv {
+    pthread_t               tid;
+    char                    name[OS_THREAD_NAME_LEN];
+    OS_ThreadEntry_t        entry;
+    void                   *arg;
+    OS_Priority             priority;
+    uint32_t                stackSize;
+    struct OS_ThreadPriv   *next;
+} OS_ThreadPriv_t;
+
+static pthread_mutex_t os_thread_lock = PTHREAD_MUTEX_INITIALIZER;
+static OS_ThreadPriv_t *os_thread_list;
+static __thread OS_ThreadPriv_t *os_thread_self;
+
+/* emulated vTaskSuspendAll(), only excludes other suspenders */
+static pthread_mutex_t os_sched_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static __thread uint32_t os_sched_suspended;
+
+static void OS_ThreadListAdd(OS_ThreadPriv_t *priv)
+{
+	pthread_mutex_lock(&os_thread_lock);
+	priv->next = os_thread_list;
+	os_thread_list = priv;
+	pthread_mutex_unlock(&os_thread_lock);
+}
+
+static void OS_ThreadListRemove(OS_ThreadPriv_t *priv)
+{
+	OS_ThreadPriv_t **pp;
+
+	pthread_mutex_lock(&os_thread_lock);
+	for (pp = &os_thread_list; *pp; pp = &(*pp)->next) {
+		if (*pp == priv) {
+			*pp = priv->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&os_thread_lock);
+}
+
+static void OS_ThreadExit(void *arg)
+{
+	OS_ThreadPriv_t *priv = arg;
+
+	os_thread_self = NULL;
+	OS_ThreadListRemove(priv);
+	OS_Free(priv);
+}
+
+static void *OS_ThreadPrivEntry(void *arg)
+{
+	OS_ThreadPriv_t *priv = arg;
+
+	pthread_setname_np(pthread_self(), priv->name);
+	os_thread_self = priv;
+	pthread_cleanup_push(OS_ThreadExit, priv);
+	priv->entry(priv->arg);
+	pthread_cleanup_pop(1);
+	return NULL;
+}
+
+OS_Status OS_ThreadCreate(OS_Thread_t *thread, const char *name,
+                          OS_ThreadEntry_t entry, void *arg,
+                          OS_Priority priority, uint32_t stackSize)
+{
+	OS_ThreadPriv_t *priv;
+	pthread_attr_t attr;
+	size_t size;
+	int ret;
+
+	OS_HANDLE_ASSERT(!OS_ThreadIsValid(thread), thread->handle);
+
+	priv = OS_Malloc(sizeof(OS_ThreadPriv_t));
+	if (priv == NULL) {
+		return OS_E_NOMEM;
+	}
+	OS_Memset(priv, 0, sizeof(OS_ThreadPriv_t));
+	if (name)
+		strncpy(priv->name, name, OS_THREAD_NAME_LEN - 1);
+	priv->entry = entry;
+	priv->arg = arg;
+	priv->priority = priority;
+	priv->stackSize = stackSize;
+
+	size = (size_t)stackSize * OS_THREAD_STACK_SCALE;
+	if (size < OS_THREAD_STACK_MIN)
+		size = OS_THREAD_STACK_MIN;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	pthread_attr_setstacksize(&attr, size);
+
+	/* published before the thread runs, it may exit at once */
+	thread->handle = priv;
+	OS_ThreadListAdd(priv);
+	ret = pthread_create(&priv->tid, &attr, OS_ThreadPrivEntry, priv);
+	pthread_attr_destroy(&attr);
+	if (ret != 0) {
+		OS_ERR("err %d\n", ret);
+		OS_ThreadListRemove(priv);
+		OS_Free(priv);
+		OS_ThreadSetInvalid(thread);
+		return OS_FAIL;
+	}
+	return OS_OK;
+}
+
+OS_Status OS_ThreadDelete(OS_Thread_t *thread)
+{
+	OS_ThreadPriv_t *priv;
+	OS_ThreadHandle_t curHandle;
+
+	if (thread == NULL) {
+		pthread_exit(NULL); /* delete self */
+		return OS_OK;
+	}
+
+	OS_HANDLE_ASSERT(OS_ThreadIsValid(thread), thread->handle);
+
+	priv = thread->handle;
+	curHandle = OS_ThreadGetCurrentHandle();
+	if (priv == curHandle) {
+		/* delete self */
+		OS_ThreadSetInvalid(thread);
+		pthread_exit(NULL);
+	} else {
+		/* delete other thread, at its next cancellation point */
+		OS_WRN("thread %"OS_HANDLE_F" delete %"OS_HANDLE_F"\n", curHandle, priv);
+		pthread_cancel(priv->tid);
+		OS_ThreadSetInvalid(thread);
+	}
+
+	return OS_OK;
+}
+
+void OS_ThreadSleep(OS_Time_t msec)
+{
+	OS_MSleep(msec);
+}
+
+void OS_ThreadYield(void)
+{
+	sched_yield();
+}
+
+OS_ThreadHandle_t OS_ThreadGetCurrentHandle(void)
+{
+	OS_ThreadPriv_t *priv = os_thread_self;
+
+	/* threads not created by OS_ThreadCreate(), eg. main() */
+	if (priv == NULL) {
+		priv = OS_Malloc(sizeof(OS_ThreadPriv_t));
+		if (priv == NULL)
+			return OS_INVALID_HANDLE;
+		OS_Memset(priv, 0, sizeof(OS_ThreadPriv_t));
+		priv->tid = pthread_self();
+		pthread_getname_np(priv->tid, priv->name, OS_THREAD_NAME_LEN);
+		priv->priority = OS_PRIORITY_NORMAL;
+		OS_ThreadListAdd(priv);
+		os_thread_self = priv;
+	}
+	return (OS_ThreadHandle_t)priv;
+}
+
+/* Threads are already running, the caller just parks like the idle task */
+void OS_ThreadStartScheduler(void)
+{
+	for (;;)
+		pause();
+}
+
+void OS_ThreadSuspendScheduler(void)
+{
+	pthread_mutex_lock(&os_sched_lock);
+	os_sched_suspended++;
+}
+
+void OS_ThreadResumeScheduler(void)
+{
+	if (os_sched_suspended == 0) {
+		OS_WRN("%s() not suspended\n", __func__);
+		return;
+	}
+	os_sched_suspended--;
+	pthread_mutex_unlock(&os_sched_lock);
+}
+
+int OS_ThreadIsSchedulerRunning(void)
+{
+	return (os_sched_suspended == 0);
+}
+
+/* stack high water mark is not tracked on the host */
+uint32_t OS_ThreadGetStackMinFreeSize(OS_Thread_t *thread)
+{
+	return 0;
+}
+
+void OS_ThreadList(void)
+{
+	OS_ThreadPriv_t *priv;
+
+	OS_LOG(1, "%*sPri StkSize Handle\n", -OS_THREAD_NAME_LEN, "Name");
+	pthread_mutex_lock(&os_thread_lock);
+	for (priv = os_thread_list; priv; priv = priv->next) {
+		OS_LOG(1, "%*.*s%-3d %-7u %p\n", -OS_THREAD_NAME_LEN, OS_THREAD_NAME_LEN,
+		       priv->name, priv->priority, priv->stackSize, priv);
+	}
+	pthread_mutex_unlock(&os_thread_lock);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include "kernel/os/os_time.h"
+#include "os_util.h"
+
+/* system clock's frequency, OS ticks per second */
+uint32_t OS_TickRateHz = 1000;
+
+/* ticks count from the first OS call, as they do from boot on the target */
+static uint64_t os_time_base;
+
+static __always_inline uint64_t OS_TimeElapsedNs(void)
+{
+	uint64_t now = OS_MonotonicNs();
+	uint64_t base = __atomic_load_n(&os_time_base, __ATOMIC_RELAXED);
+
+	if (base == 0) {
+		if (!__atomic_compare_exchange_n(&os_time_base, &base, now, 0,
+		                                 __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			return now - base;
+		return 0;
+	}
+	return now - base;
+}
+
+OS_Time_t OS_GetTicks(void)
+{
+	return (OS_Time_t)(OS_TimeElapsedNs() / (OS_NSEC_PER_SEC / OS_HZ));
+}
+
+OS_Time_t OS_GetTime(void)
+{
+	return (OS_Time_t)(OS_TimeElapsedNs() / OS_NSEC_PER_SEC);
+}
+
+void OS_MSleep(OS_Time_t msec)
+{
+	struct timespec ts;
+
+	OS_CalcDeadline(&ts, msec);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+		;
+}
+
+/* The fake random 32-bit value is generated by combining OS ticks and
+ * the nanoseconds of the monotonic clock, as the SysTick value on target.
+ */
+uint32_t OS_Rand32(void)
+{
+	return (uint32_t)((OS_MonotonicNs() & 0xffffff) | (OS_GetTicks() << 24));
+}
@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "kernel/os/os_timer.h"
+#include "kernel/os/os_thread.h"
+#include "os_util.h"
+
+/*
+ * All timers are run by one service thread off a list sorted by expiry,
+ * like the FreeRTOS timer task: callbacks are serialized and may block
+ * each other, which is the behaviour portable code is written against.
+ */
+
+#define OS_TIMER_THREAD_STACK_SIZE  (4 * 1024)
+
+/* Timer private data definition */
+typedef struct OS_TimerPriv {
+    struct OS_TimerPriv    *next;
+    OS_TimerCallback_t      callback; /* Timer expire callback function */
+    void                   *argument; /* Argument of timer expire callback function */
+    OS_TimerType            type;
+    uint64_t                period;   /* ns */
+    uint64_t                expiry;   /* CLOCK_MONOTONIC ns */
+    uint8_t                 active;
+} OS_TimerPriv_t;
+
+static struct {
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    pthread_once_t      once;
+    OS_Thread_t         thread;
+    OS_ThreadHandle_t   handle;
+    OS_TimerPriv_t     *list;     /* active timers, earliest first */
+    OS_TimerPriv_t     *running;  /* timer whose callback is running */
+} os_timer = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.once = PTHREAD_ONCE_INIT,
+};
+
+static void OS_TimerInsert(OS_TimerPriv_t *priv)
+{
+	OS_TimerPriv_t **pp;
+
+	for (pp = &os_timer.list; *pp; pp = &(*pp)->next) {
+		if (priv->expiry < (*pp)->expiry)
+			break;
+	}
+	priv->next = *pp;
+	*pp = priv;
+	priv->active = 1;
+}
+
+static void OS_TimerRemove(OS_TimerPriv_t *priv)
+{
+	OS_TimerPriv_t **pp;
+
+	if (!priv->active)
+		return;
+
+	for (pp = &os_timer.list; *pp; pp = &(*pp)->next) {
+		if (*pp == priv) {
+			*pp = priv->next;
+			break;
+		}
+	}
+	priv->active = 0;
+}
+
+static void OS_TimerTask(void *arg)
+{
+	OS_TimerPriv_t *priv;
+	struct timespec ts;
+	uint64_t now;
+
+	os_timer.handle = OS_ThreadGetCurrentHandle();
+	pthread_mutex_lock(&os_timer.lock);
+	for (;;) {
+		priv = os_timer.list;
+		if (priv == NULL) {
+			pthread_cond_wait(&os_timer.cond, &os_timer.lock);
+			continue;
+		}
+
+		now = OS_MonotonicNs();
+		if (priv->expiry > now) {
+			ts.tv_sec = priv->expiry / OS_NSEC_PER_SEC;
+			ts.tv_nsec = priv->expiry % OS_NSEC_PER_SEC;
+			pthread_cond_timedwait(&os_timer.cond, &os_timer.lock, &ts);
+			continue;
+		}
+
+		/* reload before the callback, as FreeRTOS does */
+		OS_TimerRemove(priv);
+		if (priv->type == OS_TIMER_PERIODIC) {
+			priv->expiry += priv->period;
+			if (priv->expiry <= now) /* overrun, don't burst */
+				priv->expiry = now + priv->period;
+			OS_TimerInsert(priv);
+		}
+
+		os_timer.running = priv;
+		pthread_mutex_unlock(&os_timer.lock);
+		priv->callback(priv->argument);
+		pthread_mutex_lock(&os_timer.lock);
+		os_timer.running = NULL;
+		pthread_cond_broadcast(&os_timer.cond);
+	}
+}
+
+static void OS_TimerInit(void)
+{
+	OS_CondInit(&os_timer.cond);
+	if (OS_ThreadCreate(&os_timer.thread, "timer", OS_TimerTask, NULL,
+	                    OS_PRIORITY_REAL_TIME, OS_TIMER_THREAD_STACK_SIZE) != OS_OK) {
+		OS_ERR("create timer thread failed\n");
+		OS_ABORT();
+	}
+}
+
+static __always_inline uint64_t OS_TimerPeriodNs(OS_Time_t periodMS)
+{
+	/* same granularity as a one tick FreeRTOS period */
+	if (periodMS == 0)
+		periodMS = 1;
+	return (uint64_t)periodMS * OS_NSEC_PER_MSEC;
+}
+
+OS_Status OS_TimerCreate(OS_Timer_t *timer, OS_TimerType type,
+                         OS_TimerCallback_t cb, void *arg, OS_Time_t periodMS)
+{
+	OS_TimerPriv_t *priv;
+
+	OS_HANDLE_ASSERT(!OS_TimerIsValid(timer), timer->handle);
+
+	pthread_once(&os_timer.once, OS_TimerInit);
+
+	priv = OS_Malloc(sizeof(OS_TimerPriv_t));
+	if (priv == NULL) {
+		return OS_E_NOMEM;
+	}
+
+	OS_Memset(priv, 0, sizeof(OS_TimerPriv_t));
+	priv->callback = cb;
+	priv->argument = arg;
+	priv->type = type;
+	priv->period = OS_TimerPeriodNs(periodMS);
+	timer->handle = priv;
+	return OS_OK;
+}
+
+OS_Status OS_TimerDelete(OS_Timer_t *timer)
+{
+	OS_TimerPriv_t *priv;
+
+	OS_HANDLE_ASSERT(OS_TimerIsValid(timer), timer->handle);
+
+	priv = timer->handle;
+	pthread_mutex_lock(&os_timer.lock);
+	OS_TimerRemove(priv);
+	/* let a running callback finish, unless it is deleting its own timer */
+	while (os_timer.running == priv && OS_ThreadGetCurrentHandle() != os_timer.handle)
+		pthread_cond_wait(&os_timer.cond, &os_timer.lock);
+	pthread_mutex_unlock(&os_timer.lock);
+
+	OS_TimerSetInvalid(timer);
+	OS_Free(priv);
+	return OS_OK;
+}
+
+/* (re)start the timer from now, wake the service thread if it is the first */
+static void OS_TimerArm(OS_TimerPriv_t *priv)
+{
+	OS_TimerRemove(priv);
+	priv->expiry = OS_MonotonicNs() + priv->period;
+	OS_TimerInsert(priv);
+	if (os_timer.list == priv)
+		pthread_cond_broadcast(&os_timer.cond);
+}
+
+OS_Status OS_TimerStart(OS_Timer_t *timer)
+{
+	OS_HANDLE_ASSERT(OS_TimerIsValid(timer), timer->handle);
+
+	pthread_mutex_lock(&os_timer.lock);
+	OS_TimerArm(timer->handle);
+	pthread_mutex_unlock(&os_timer.lock);
+
+	return OS_OK;
+}
+
+OS_Status OS_TimerChangePeriod(OS_Timer_t *timer, OS_Time_t periodMS)
+{
+	OS_TimerPriv_t *priv;
+
+	OS_HANDLE_ASSERT(OS_TimerIsValid(timer), timer->handle);
+
+	priv = timer->handle;
+	pthread_mutex_lock(&os_timer.lock);
+	priv->period = OS_TimerPeriodNs(periodMS);
+	OS_TimerArm(priv);
+	pthread_mutex_unlock(&os_timer.lock);
+
+	return OS_OK;
+}
+
+OS_Status OS_TimerStop(OS_Timer_t *timer)
+{
+	OS_HANDLE_ASSERT(OS_TimerIsValid(timer), timer->handle);
+
+	pthread_mutex_lock(&os_timer.lock);
+	OS_TimerRemove(timer->handle);
+	pthread_mutex_unlock(&os_timer.lock);
+
+	return OS_OK;
+}
+
+int OS_TimerIsActive(OS_Timer_t *timer)
+{
+	OS_TimerPriv_t *priv;
+	int active;
+
+	if (!OS_TimerIsValid(timer)) {
+		return 0;
+	}
+
+	priv = timer->handle;
+	pthread_mutex_lock(&os_timer.lock);
+	active = priv->active;
+	pthread_mutex_unlock(&os_timer.lock);
+
+	return active;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _OS_UTIL_H_
+#define _OS_UTIL_H_
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include "kernel/os/os_time.h"
+#include "os_debug.h"
+
+#define OS_NSEC_PER_SEC     1000000000L
+#define OS_NSEC_PER_MSEC    1000000L
+
+/* There is no interrupt context on the host, signal handlers don't count */
+static __always_inline int OS_IsISRContext(void)
+{
+	return 0;
+}
+
+static __always_inline uint64_t OS_MonotonicNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * OS_NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/*
+ * Absolute CLOCK_MONOTONIC deadline of a wait, so that spurious wakeups
+ * don't extend the timeout. Not used for OS_WAIT_FOREVER.
+ */
+static __always_inline void OS_CalcDeadline(struct timespec *ts, OS_Time_t msec)
+{
+	clock_gettime(CLOCK_MONOTONIC, ts);
+	ts->tv_sec += msec / OS_MSEC_PER_SEC;
+	ts->tv_nsec += (long)(msec % OS_MSEC_PER_SEC) * OS_NSEC_PER_MSEC;
+	if (ts->tv_nsec >= OS_NSEC_PER_SEC) {
+		ts->tv_sec++;
+		ts->tv_nsec -= OS_NSEC_PER_SEC;
+	}
+}
+
+/* condition variable timed against CLOCK_MONOTONIC */
+static __always_inline int OS_CondInit(pthread_cond_t *cond)
+{
+	pthread_condattr_t attr;
+	int ret;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	ret = pthread_cond_init(cond, &attr);
+	pthread_condattr_destroy(&attr);
+	return ret;
+}
+
+/* cancellation cleanup handler, threads deleted by others may be waiting */
+static __always_inline void OS_MutexCleanup(void *mutex)
+{
+	pthread_mutex_unlock((pthread_mutex_t *)mutex);
+}
+
+/* memory */
+#define OS_Malloc(l)        malloc(l)
+#define OS_Free(p)          free(p)
+#define OS_Memcpy(d, s, l)  memcpy(d, s, l)
+#define OS_Memset(d, c, l)  memset(d, c, l)
+#define OS_Memcmp(a, b, l)  memcmp(a, b, l)
+#define OS_Memmove(d, s, n) memmove(d, s, n)
+
+#endif /* _OS_UTIL_H_ */
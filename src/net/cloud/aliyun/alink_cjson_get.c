@@ -32,95 +32,75 @@
 #include <string.h>
 
 #include "alink_cjson_get.h"
+#include "cjson/json_extract.h"
 #include "alink_debug.h"
 
-
-char* alink_cjson_get_iot_para(const char *cjson_explain, const char *get_name)
+/*
+ * The replies are only scanned for one value, so walk them with the
+ * streaming extractor instead of building a cJSON tree on the heap.
+ * Keys match whatever their case, as cJSON_GetObjectItem() did. A value
+ * that does not fit @para_get is an error rather than being cut.
+ */
+static int alink_cjson_get_value(const char *cjson_explain, const char *path,
+                                 char *para_get, uint16_t size)
 {
-	cJSON* json_message = NULL, *get_data = NULL, *get_iotId = NULL;
+	json_extract_field field;
 
-	static char para_get[64] = {0};
-
-	json_message = cJSON_Parse(cjson_explain);
-	if (!json_message) {
-		ALINK_DBG("cjson get json_message error\n");
-		goto cjosn_exit;
-	}
+	memset(&field, 0, sizeof(field));
+	field.path = path;
+	field.buf = para_get;
+	field.size = size;
+	field.flags = JSON_EXTRACT_NOCASE;
 
-	get_data = cJSON_GetObjectItem(json_message, "data");
-	if(!get_data) {
-		ALINK_DBG("cjson get data error\n");
-		goto cjosn_exit;
+	if (json_extract(cjson_explain, strlen(cjson_explain), &field, 1) <= 0) {
+		ALINK_DBG("cjson get %s error\n", path);
+		return -1;
 	}
-
-	get_iotId = cJSON_GetObjectItem(get_data, get_name);
-	if(!get_iotId) {
-		ALINK_DBG("cjson get_iotId error\n");
-		goto cjosn_exit;
+	if (field.type != JSON_EXTRACT_STRING && field.type != JSON_EXTRACT_NUMBER) {
+		ALINK_DBG("cjson %s type %d\n", path, field.type);
+		return -1;
 	}
-	if(get_iotId->type == cJSON_String) {
-		ALINK_DBG("cjson get_iotId = %s\n", get_iotId->valuestring);
-		memcpy(para_get, get_iotId->valuestring, strlen(get_iotId->valuestring)+1);
+	if (field.flags & JSON_EXTRACT_TRUNCATED) {
+		ALINK_DBG("cjson %s longer than %u\n", path, size - 1);
+		para_get[0] = '\0';
+		return -1;
 	}
 
-cjosn_exit:
-
-	if(json_message) cJSON_Delete(json_message);
-
-	return para_get;
+	ALINK_DBG("cjson %s = %s\n", path, para_get);
+	return 0;
 }
 
-char* alink_cjson_get_mqtt_addr(const char *cjson_explain, const char *get_name)
+char* alink_cjson_get_iot_para(const char *cjson_explain, const char *get_name)
 {
-	cJSON* json_message = NULL, *get_data = NULL, *resourece = NULL, *mqtt = NULL, *addr = NULL;
-
 	static char para_get[64] = {0};
+	char path[48];
+	int n;
 
-	json_message = cJSON_Parse(cjson_explain);
-	if (!json_message) {
-		ALINK_DBG("cjson get json_message error\n");
-		goto cjosn_exit;
-	}
-
-	get_data = cJSON_GetObjectItem(json_message, "data");
-	if(!get_data) {
-		ALINK_DBG("cjson get data error\n");
-		goto cjosn_exit;
-	}
-
-	resourece = cJSON_GetObjectItem(get_data, "resources");
-	if(!resourece) {
-		ALINK_DBG("cjson get resourece error\n");
-		goto cjosn_exit;
+	n = snprintf(path, sizeof(path), "data.%s", get_name);
+	if (n < 0 || n >= (int)sizeof(path)) {
+		ALINK_DBG("cjson name %s too long\n", get_name);
+		return NULL;
 	}
+	if (alink_cjson_get_value(cjson_explain, path, para_get, sizeof(para_get)) < 0)
+		return NULL;
 
-	mqtt = cJSON_GetObjectItem(resourece, "mqtt");
-	if(!resourece) {
-		ALINK_DBG("cjson get mqtt error\n");
-		goto cjosn_exit;
-	}
+	return para_get;
+}
 
-	addr = cJSON_GetObjectItem(mqtt, get_name);
-	if(!resourece) {
-		ALINK_DBG("cjson get resourece error\n");
-		goto cjosn_exit;
-	}
-	if(addr->type == cJSON_String) {
-		ALINK_DBG("cjson addr = %s\n", addr->valuestring);
-		memcpy(para_get, addr->valuestring, strlen(addr->valuestring)+1);
-	}
-	if(addr->type == cJSON_Number) {
-		ALINK_DBG("cjson addr = %d\n", addr->valueint);
-		char port[6] = {0};
-		sprintf(port, "%d", addr->valueint);
-		memcpy(para_get, port, strlen(port) + 1);
+char* alink_cjson_get_mqtt_addr(const char *cjson_explain, const char *get_name)
+{
+	static char para_get[64] = {0};
+	char path[64];
+	int n;
+
+	/* a number (the port) is returned as its decimal text */
+	n = snprintf(path, sizeof(path), "data.resources.mqtt.%s", get_name);
+	if (n < 0 || n >= (int)sizeof(path)) {
+		ALINK_DBG("cjson name %s too long\n", get_name);
+		return NULL;
 	}
-
-cjosn_exit:
-
-	if(json_message) cJSON_Delete(json_message);
+	if (alink_cjson_get_value(cjson_explain, path, para_get, sizeof(para_get)) < 0)
+		return NULL;
 
 	return para_get;
 }
-
-
@@ -88,6 +88,18 @@ do_netifapi_netif_common(struct netifapi_msg_msg *msg)
   TCPIP_NETIFAPI_ACK(msg);
 }
 
+#if LWIP_XR_IMPL && LWIP_DHCP
+/**
+ * Call dhcp_start_reboot() inside the tcpip_thread context.
+ */
+static void
+do_netifapi_dhcp_start_reboot(struct netifapi_msg_msg *msg)
+{
+  msg->err = dhcp_start_reboot(msg->netif, msg->msg.add.ipaddr);
+  TCPIP_NETIFAPI_ACK(msg);
+}
+#endif /* LWIP_XR_IMPL && LWIP_DHCP */
+
 /**
  * Call netif_add() in a thread-safe way by running that function inside the
  * tcpip_thread context.
@@ -157,4 +169,23 @@ netifapi_netif_common(struct netif *netif, netifapi_void_fn voidfunc,
   return msg.msg.err;
 }
 
+#if LWIP_XR_IMPL && LWIP_DHCP
+/**
+ * Call dhcp_start_reboot() in a thread-safe way by running that function
+ * inside the tcpip_thread context.
+ *
+ * @note for params @see dhcp_start_reboot()
+ */
+err_t
+netifapi_dhcp_start_reboot(struct netif *netif, ip_addr_t *addr)
+{
+  struct netifapi_msg msg;
+  msg.function = do_netifapi_dhcp_start_reboot;
+  msg.msg.netif = netif;
+  msg.msg.msg.add.ipaddr = addr;
+  TCPIP_NETIFAPI(&msg);
+  return msg.msg.err;
+}
+#endif /* LWIP_XR_IMPL && LWIP_DHCP */
+
 #endif /* LWIP_NETIF_API */
@@ -625,8 +625,39 @@ void dhcp_cleanup(struct netif *netif)
  * - ERR_OK - No error
  * - ERR_MEM - Out of memory
  */
+#if LWIP_XR_IMPL
+static err_t dhcp_start_addr(struct netif *netif, ip_addr_t *addr);
+
+err_t
+dhcp_start(struct netif *netif)
+{
+  return dhcp_start_addr(netif, NULL);
+}
+
+/**
+ * Start DHCP negotiation for a network interface in INIT-REBOOT state
+ * (RFC 2131, 3.2), asking the server to confirm a previously assigned
+ * address instead of doing the full DISCOVER/OFFER exchange.
+ *
+ * A NAK, or no answer after REBOOT_TRIES requests, falls back to DISCOVER.
+ *
+ * @param netif The lwIP network interface
+ * @param addr The address of the lease to reuse
+ * @return lwIP error code
+ */
+err_t
+dhcp_start_reboot(struct netif *netif, ip_addr_t *addr)
+{
+  LWIP_ERROR("addr != NULL", (addr != NULL), return ERR_ARG;);
+  return dhcp_start_addr(netif, addr);
+}
+
+static err_t
+dhcp_start_addr(struct netif *netif, ip_addr_t *addr)
+#else /* LWIP_XR_IMPL */
 err_t
 dhcp_start(struct netif *netif)
+#endif /* LWIP_XR_IMPL */
 {
   struct dhcp *dhcp;
   err_t result = ERR_OK;
@@ -687,6 +718,14 @@ dhcp_start(struct netif *netif)
   /* set up the recv callback and argument */
   udp_recv(dhcp->pcb, dhcp_recv, netif);
   LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE, ("dhcp_start(): starting DHCP configuration\n"));
+#if LWIP_XR_IMPL
+  if (addr != NULL && !ip_addr_isany(addr)) {
+    /* confirm the previous lease, dhcp_timeout() and the NAK handling
+       fall back to dhcp_discover() */
+    ip_addr_copy(dhcp->offered_ip_addr, *addr);
+    result = dhcp_reboot(netif);
+  } else
+#endif /* LWIP_XR_IMPL */
   /* (re)start the DHCP negotiation */
   result = dhcp_discover(netif);
   if (result != ERR_OK) {
@@ -95,6 +95,19 @@ netifapi_do_netif_set_addr(struct tcpip_api_call_data *m)
 }
 #endif /* LWIP_IPV4 */
 
+#if LWIP_XR_IMPL && LWIP_IPV4 && LWIP_DHCP
+/**
+ * Call dhcp_start_reboot() inside the tcpip_thread context.
+ */
+static err_t
+netifapi_do_dhcp_start_reboot(struct tcpip_api_call_data *m)
+{
+  struct netifapi_msg *msg = (struct netifapi_msg*)(void*)m;
+
+  return dhcp_start_reboot(msg->netif, API_EXPR_REF(msg->msg.add.ipaddr));
+}
+#endif /* LWIP_XR_IMPL && LWIP_IPV4 && LWIP_DHCP */
+
 /**
  * Call the "errtfunc" (or the "voidfunc" if "errtfunc" is NULL) inside the
  * tcpip_thread context.
@@ -218,4 +231,27 @@ netifapi_netif_common(struct netif *netif, netifapi_void_fn voidfunc,
   return err;
 }
 
+#if LWIP_XR_IMPL && LWIP_IPV4 && LWIP_DHCP
+/**
+ * @ingroup netifapi_dhcp4
+ * Call dhcp_start_reboot() in a thread-safe way by running that function
+ * inside the tcpip_thread context.
+ *
+ * @note for params @see dhcp_start_reboot()
+ */
+err_t
+netifapi_dhcp_start_reboot(struct netif *netif, const ip4_addr_t *addr)
+{
+  err_t err;
+  NETIFAPI_VAR_DECLARE(msg);
+  NETIFAPI_VAR_ALLOC(msg);
+
+  NETIFAPI_VAR_REF(msg).netif = netif;
+  NETIFAPI_VAR_REF(msg).msg.add.ipaddr = NETIFAPI_VAR_REF(addr);
+  err = tcpip_api_call(netifapi_do_dhcp_start_reboot, &API_VAR_REF(msg).call);
+  NETIFAPI_VAR_FREE(msg);
+  return err;
+}
+#endif /* LWIP_XR_IMPL && LWIP_IPV4 && LWIP_DHCP */
+
 #endif /* LWIP_NETIF_API */
@@ -2103,6 +2103,13 @@ lwip_getsockopt_impl(int s, int level, int optname, void *optval, socklen_t *opt
                   s, *(int *)optval));
       break;
 #endif /* LWIP_TCP_KEEPALIVE */
+#if LWIP_TCP_AUTOTUNE
+    case TCP_AUTOTUNE:
+      *(int*)optval = (int)tcp_autotune_get_mode(sock->conn->pcb.tcp);
+      LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_getsockopt(%d, IPPROTO_TCP, TCP_AUTOTUNE) = %d\n",
+                  s, *(int *)optval));
+      break;
+#endif /* LWIP_TCP_AUTOTUNE */
     default:
       LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_getsockopt(%d, IPPROTO_TCP, UNIMPL: optname=0x%x, ..)\n",
                   s, optname));
@@ -2499,6 +2506,17 @@ lwip_setsockopt_impl(int s, int level, int optname, const void *optval, socklen_
                   s, sock->conn->pcb.tcp->keep_cnt));
       break;
 #endif /* LWIP_TCP_KEEPALIVE */
+#if LWIP_TCP_AUTOTUNE
+    case TCP_AUTOTUNE:
+      if ((*(const int*)optval < TCP_AUTOTUNE_DEFAULT) || (*(const int*)optval > TCP_AUTOTUNE_INTERACTIVE)) {
+        err = EINVAL;
+        break;
+      }
+      tcp_autotune_mode(sock->conn->pcb.tcp, (u8_t)(*(const int*)optval));
+      LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_setsockopt(%d, IPPROTO_TCP, TCP_AUTOTUNE) -> %d\n",
+                  s, *(const int*)optval));
+      break;
+#endif /* LWIP_TCP_AUTOTUNE */
     default:
       LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_setsockopt(%d, IPPROTO_TCP, UNIMPL: optname=0x%x, ..)\n",
                   s, optname));
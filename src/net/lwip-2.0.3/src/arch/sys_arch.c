@@ -36,6 +36,10 @@
 
 #include "arch/sys_arch.h"
 
+#if (LWIP_TCP && LWIP_TCP_AUTOTUNE && defined(__CONFIG_MALLOC_USE_STDLIB))
+#include <malloc.h>
+#endif
+
 #if LWIP_RESOURCE_TRACE
 int g_lwip_mutex_cnt = 0;
 int g_lwip_sem_cnt = 0;
@@ -438,6 +442,49 @@ u32_t sys_now(void)
 	return OS_TicksToMSecs(OS_GetTicks());
 }
 
+#if (LWIP_TCP && LWIP_TCP_AUTOTUNE)
+#if (defined(__CONFIG_MALLOC_USE_STDLIB) && !defined(__CONFIG_OS_LITEOS))
+extern void heap_get_space(uint8_t **start, uint8_t **end, uint8_t **current);
+
+/* free chunks inside the heap plus the space sbrk has not handed out yet */
+static size_t sys_arch_free_heap(void)
+{
+	uint8_t *start, *end, *current;
+	struct mallinfo info = mallinfo();
+
+	heap_get_space(&start, &end, &current);
+	return (size_t)info.fordblks + (size_t)(end - current);
+}
+#elif defined(__CONFIG_OS_FREERTOS)
+extern size_t xPortGetFreeHeapSize(void);
+
+static size_t sys_arch_free_heap(void)
+{
+	return xPortGetFreeHeapSize();
+}
+#else
+#warning "no free heap query, TCP autotuning sees no heap pressure"
+static size_t sys_arch_free_heap(void)
+{
+	return TCP_AUTOTUNE_HEAP_LOW;
+}
+#endif
+
+/** Heap pressure polled by TCP autotuning from the TCP slow timer */
+u8_t sys_arch_mem_pressure(void)
+{
+	size_t free_size = sys_arch_free_heap();
+
+	if (free_size < TCP_AUTOTUNE_HEAP_CRITICAL) {
+		return 2;
+	}
+	if (free_size < TCP_AUTOTUNE_HEAP_LOW) {
+		return 1;
+	}
+	return 0;
+}
+#endif /* (LWIP_TCP && LWIP_TCP_AUTOTUNE) */
+
 #if LWIP_RESOURCE_TRACE
 extern int g_lwip_socket_cnt;
 
@@ -155,6 +155,23 @@ PACK_STRUCT_END
   #error "If you want to use TCP, TCP_WND must fit in an u16_t, so, you have to reduce it in your lwipopts.h (or enable window scaling)"
 #endif
 #endif /* LWIP_WND_SCALE */
+#if (LWIP_TCP && LWIP_TCP_AUTOTUNE)
+#if ((TCP_AUTOTUNE_WND_MAX < TCP_WND) || (TCP_AUTOTUNE_SND_BUF_MAX < TCP_SND_BUF))
+  #error "TCP_AUTOTUNE_WND_MAX and TCP_AUTOTUNE_SND_BUF_MAX must not be smaller than TCP_WND and TCP_SND_BUF"
+#endif
+#if ((TCP_AUTOTUNE_MIN > TCP_WND) || (TCP_AUTOTUNE_MIN > TCP_SND_BUF))
+  #error "TCP_AUTOTUNE_MIN must not be bigger than TCP_WND and TCP_SND_BUF"
+#endif
+#if LWIP_WND_SCALE
+#if (TCP_AUTOTUNE_WND_MAX > (0xFFFFU << TCP_RCV_SCALE))
+  #error "TCP_AUTOTUNE_WND_MAX is bigger than the configured LWIP_WND_SCALE allows!"
+#endif
+#else /* LWIP_WND_SCALE */
+#if ((TCP_AUTOTUNE_WND_MAX > 0xffff) || (TCP_AUTOTUNE_SND_BUF_MAX > 0xffff))
+  #error "TCP_AUTOTUNE_WND_MAX and TCP_AUTOTUNE_SND_BUF_MAX must fit in an u16_t (or enable window scaling)"
+#endif
+#endif /* LWIP_WND_SCALE */
+#endif /* LWIP_TCP && LWIP_TCP_AUTOTUNE */
 #if (LWIP_TCP && (TCP_SND_QUEUELEN > 0xffff))
   #error "If you want to use TCP, TCP_SND_QUEUELEN must fit in an u16_t, so, you have to reduce it in your lwipopts.h"
 #endif
@@ -717,8 +717,40 @@ void dhcp_cleanup(struct netif *netif)
  * - ERR_OK - No error
  * - ERR_MEM - Out of memory
  */
+#if LWIP_XR_IMPL
+static err_t dhcp_start_addr(struct netif *netif, const ip4_addr_t *addr);
+
 err_t
 dhcp_start(struct netif *netif)
+{
+  return dhcp_start_addr(netif, NULL);
+}
+
+/**
+ * @ingroup dhcp4
+ * Start DHCP negotiation for a network interface in INIT-REBOOT state
+ * (RFC 2131, 3.2), asking the server to confirm a previously assigned
+ * address instead of doing the full DISCOVER/OFFER exchange.
+ *
+ * A NAK, or no answer after REBOOT_TRIES requests, falls back to DISCOVER.
+ *
+ * @param netif The lwIP network interface
+ * @param addr The address of the lease to reuse
+ * @return lwIP error code
+ */
+err_t
+dhcp_start_reboot(struct netif *netif, const ip4_addr_t *addr)
+{
+  LWIP_ERROR("addr != NULL", (addr != NULL), return ERR_ARG;);
+  return dhcp_start_addr(netif, addr);
+}
+
+static err_t
+dhcp_start_addr(struct netif *netif, const ip4_addr_t *addr)
+#else /* LWIP_XR_IMPL */
+err_t
+dhcp_start(struct netif *netif)
+#endif /* LWIP_XR_IMPL */
 {
   struct dhcp *dhcp;
   err_t result;
@@ -769,6 +801,25 @@ dhcp_start(struct netif *netif)
   }
   dhcp->pcb_allocated = 1;
 
+#if LWIP_XR_IMPL
+  if (addr != NULL && !ip4_addr_isany(addr)) {
+    ip4_addr_copy(dhcp->offered_ip_addr, *addr);
+#if LWIP_DHCP_CHECK_LINK_UP
+    if (!netif_is_link_up(netif)) {
+      /* dhcp_network_changed() calls dhcp_reboot() in this state */
+      dhcp_set_state(dhcp, DHCP_STATE_REBOOTING);
+      return ERR_OK;
+    }
+#endif /* LWIP_DHCP_CHECK_LINK_UP */
+    result = dhcp_reboot(netif);
+    if (result != ERR_OK) {
+      dhcp_stop(netif);
+      return ERR_MEM;
+    }
+    return result;
+  }
+#endif /* LWIP_XR_IMPL */
+
 #if LWIP_DHCP_CHECK_LINK_UP
   if (!netif_is_link_up(netif)) {
     /* set state INIT and wait for dhcp_network_changed() to call dhcp_discover() */
@@ -800,6 +800,14 @@ tcp_recved(struct tcp_pcb *pcb, u16_t len)
     pcb->state != LISTEN);
 
   pcb->rcv_wnd += len;
+#if LWIP_TCP_AUTOTUNE
+  if ((pcb->rcv_wnd > TCP_WND_MAX(pcb)) &&
+      TCP_SEQ_GT(pcb->rcv_ann_right_edge, pcb->rcv_nxt + TCP_WND_MAX(pcb))) {
+    /* autotuning shrunk the window: let it close as the peer uses up what
+       was announced instead of retracting it */
+    pcb->rcv_wnd = LWIP_MIN(pcb->rcv_wnd, pcb->rcv_ann_right_edge - pcb->rcv_nxt);
+  } else
+#endif /* LWIP_TCP_AUTOTUNE */
   if (pcb->rcv_wnd > TCP_WND_MAX(pcb)) {
     pcb->rcv_wnd = TCP_WND_MAX(pcb);
   } else if (pcb->rcv_wnd == 0) {
@@ -944,6 +952,9 @@ tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port,
   /* Start with a window that does not need scaling. When window scaling is
      enabled and used, the window is enlarged when both sides agree on scaling. */
   pcb->rcv_wnd = pcb->rcv_ann_wnd = TCPWND_MIN16(TCP_WND);
+#if LWIP_TCP_AUTOTUNE
+  pcb->rcv_wnd_max = TCPWND_MIN16(TCP_WND);
+#endif /* LWIP_TCP_AUTOTUNE */
   pcb->rcv_ann_right_edge = pcb->rcv_nxt;
   pcb->snd_wnd = TCP_WND;
   /* As initial send MSS, we use TCP_MSS but limit it to 536.
@@ -996,6 +1007,10 @@ tcp_slowtmr(void)
   ++tcp_ticks;
   ++tcp_timer_ctr;
 
+#if LWIP_TCP_AUTOTUNE
+  tcp_autotune_tmr();
+#endif /* LWIP_TCP_AUTOTUNE */
+
 tcp_slowtmr_start:
   /* Steps through all of the active PCBs. */
   prev = NULL;
@@ -1609,6 +1624,10 @@ tcp_alloc(u8_t prio)
     /* Start with a window that does not need scaling. When window scaling is
        enabled and used, the window is enlarged when both sides agree on scaling. */
     pcb->rcv_wnd = pcb->rcv_ann_wnd = TCPWND_MIN16(TCP_WND);
+#if LWIP_TCP_AUTOTUNE
+    pcb->snd_buf_max = TCP_SND_BUF;
+    pcb->rcv_wnd_max = TCPWND_MIN16(TCP_WND);
+#endif /* LWIP_TCP_AUTOTUNE */
     pcb->ttl = TCP_TTL;
     /* As initial send MSS, we use TCP_MSS but limit it to 536.
        The send MSS is updated when an MSS option is received. */
@@ -0,0 +1,465 @@
+/**
+ * @file
+ * TCP receive window and send buffer autotuning
+ *
+ * Each connection starts with TCP_WND and TCP_SND_BUF. Once per round trip,
+ * the bytes received (acknowledged) during that round trip are compared to
+ * the window (send buffer): when the peer (application) filled it, it is
+ * grown to twice the measured amount so that slow start is not capped by it.
+ * The slow timer shrinks connections back when the stack is short of memory,
+ * when the sum over all connections exceeds TCP_AUTOTUNE_MEM_LIMIT or when a
+ * connection went idle.
+ */
+
+/*
+ * Copyright (c) 2001-2004 Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_TCP && LWIP_TCP_AUTOTUNE /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/def.h"
+#include "lwip/sys.h"
+#include "lwip/tcp.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/debug.h"
+#include "lwip/stats.h"
+
+/* at_flags */
+#define TCP_AT_RCV_RTT  0x01U   /* a window is being timed for at_rcv_rtt */
+#define TCP_AT_RCV      0x02U   /* a receive rate interval is running */
+#define TCP_AT_SND      0x04U   /* a send rate interval is running */
+#define TCP_AT_SNDLIM   0x08U   /* the send buffer was the limit in this interval */
+
+/* ticks of the slow timer a failed allocation keeps growth disabled */
+#define TCP_AUTOTUNE_MEMERR_TICKS  ((2000 + TCP_SLOW_INTERVAL - 1) / TCP_SLOW_INTERVAL)
+
+#define TCP_AUTOTUNE_BASE_WND     TCPWND_MIN16(TCP_WND)
+#define TCP_AUTOTUNE_BASE_SND_BUF ((tcpwnd_size_t)TCP_SND_BUF)
+
+/** Receive windows plus send buffers of all active pcbs */
+static u32_t tcp_autotune_used;
+/** Memory pressure: 0 none, 1 no growth and shrink to base, 2 shrink to TCP_AUTOTUNE_MIN */
+static u8_t tcp_autotune_level;
+static u8_t tcp_autotune_memerr_ticks;
+
+#if (MEM_STATS && !MEM_LIBC_MALLOC && !MEM_USE_POOLS) || (MEMP_STATS && !MEMP_MEM_MALLOC)
+static u8_t
+tcp_autotune_usage(u32_t used, u32_t avail)
+{
+  if (avail == 0) {
+    return 0;
+  }
+  if (used >= avail - avail / 8) {
+    return 2;
+  }
+  if (used >= avail - avail / 4) {
+    return 1;
+  }
+  return 0;
+}
+#endif
+
+/** Collect the pressure signals into one level */
+static u8_t
+tcp_autotune_pressure(void)
+{
+  u8_t level = (u8_t)(TCP_AUTOTUNE_MEM_PRESSURE());
+
+  if (tcp_autotune_memerr_ticks > 0) {
+    tcp_autotune_memerr_ticks--;
+    level = LWIP_MAX(level, 1);
+  }
+#if MEM_STATS && !MEM_LIBC_MALLOC && !MEM_USE_POOLS
+  level = LWIP_MAX(level, tcp_autotune_usage(lwip_stats.mem.used, lwip_stats.mem.avail));
+#endif
+#if MEMP_STATS && !MEMP_MEM_MALLOC
+  level = LWIP_MAX(level, tcp_autotune_usage(lwip_stats.memp[MEMP_PBUF_POOL]->used,
+                                             lwip_stats.memp[MEMP_PBUF_POOL]->avail));
+#endif
+  return LWIP_MIN(level, 2);
+}
+
+/** Largest receive window and send buffer the pcb may have at this level */
+static void
+tcp_autotune_caps(struct tcp_pcb *pcb, u8_t level, u32_t *wnd, u32_t *snd_buf)
+{
+  if (level >= 2) {
+    *wnd = TCP_AUTOTUNE_MIN;
+    *snd_buf = TCP_AUTOTUNE_MIN;
+  } else if (level == 1 || pcb->at_mode == TCP_AUTOTUNE_INTERACTIVE) {
+    *wnd = TCP_AUTOTUNE_BASE_WND;
+    *snd_buf = TCP_AUTOTUNE_BASE_SND_BUF;
+  } else if (pcb->at_mode == TCP_AUTOTUNE_BULK) {
+    *wnd = TCP_AUTOTUNE_WND_MAX;
+    *snd_buf = TCP_AUTOTUNE_SND_BUF_MAX;
+  } else {
+    *wnd = LWIP_MIN(2 * (u32_t)TCP_AUTOTUNE_BASE_WND, TCP_AUTOTUNE_WND_MAX);
+    *snd_buf = LWIP_MIN(2 * (u32_t)TCP_AUTOTUNE_BASE_SND_BUF, TCP_AUTOTUNE_SND_BUF_MAX);
+  }
+#if LWIP_WND_SCALE
+  if (!(pcb->flags & TF_WND_SCALE))
+#endif
+  {
+    /* the peer cannot be told about a larger window */
+    *wnd = LWIP_MIN(*wnd, 0xffff);
+  }
+}
+
+/** Amount the budget still allows a pcb to grow by */
+static u32_t
+tcp_autotune_room(u32_t delta)
+{
+  if (tcp_autotune_used >= TCP_AUTOTUNE_MEM_LIMIT) {
+    return 0;
+  }
+  return LWIP_MIN(delta, TCP_AUTOTUNE_MEM_LIMIT - tcp_autotune_used);
+}
+
+static void
+tcp_autotune_grow_wnd(struct tcp_pcb *pcb, u32_t target, u8_t budget)
+{
+  u32_t wnd, snd_buf, delta;
+
+  tcp_autotune_caps(pcb, tcp_autotune_level, &wnd, &snd_buf);
+  target = LWIP_MIN(target, wnd);
+  if (target <= pcb->rcv_wnd_max) {
+    return;
+  }
+  delta = target - pcb->rcv_wnd_max;
+  if (budget) {
+    delta = tcp_autotune_room(delta);
+    tcp_autotune_used += delta;
+  }
+  if (delta == 0) {
+    return;
+  }
+  pcb->rcv_wnd_max += (tcpwnd_size_t)delta;
+  pcb->rcv_wnd += (tcpwnd_size_t)delta;
+  LWIP_DEBUGF(TCP_WND_DEBUG, ("tcp_autotune: rcv_wnd_max %"TCPWNDSIZE_F" for port %"U16_F"\n",
+                              pcb->rcv_wnd_max, pcb->local_port));
+  if (tcp_update_rcv_ann_wnd(pcb) >= TCP_WND_UPDATE_THRESHOLD) {
+    tcp_ack_now(pcb);
+  }
+}
+
+static void
+tcp_autotune_grow_snd_buf(struct tcp_pcb *pcb, u32_t target, u8_t budget)
+{
+  u32_t wnd, snd_buf, delta;
+
+  tcp_autotune_caps(pcb, tcp_autotune_level, &wnd, &snd_buf);
+  target = LWIP_MIN(target, snd_buf);
+  if (target <= pcb->snd_buf_max) {
+    return;
+  }
+  delta = target - pcb->snd_buf_max;
+  if (budget) {
+    delta = tcp_autotune_room(delta);
+    tcp_autotune_used += delta;
+  }
+  if (delta == 0) {
+    return;
+  }
+  /* ssthresh starts out as the largest cwnd the send buffer allowed */
+  if (pcb->ssthresh >= pcb->snd_buf_max) {
+    pcb->ssthresh = (tcpwnd_size_t)LWIP_MAX(pcb->ssthresh, pcb->snd_buf_max + delta);
+  }
+  pcb->snd_buf_max += (tcpwnd_size_t)delta;
+  pcb->snd_buf += (tcpwnd_size_t)delta;
+  LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_autotune: snd_buf_max %"TCPWNDSIZE_F" for port %"U16_F"\n",
+                               pcb->snd_buf_max, pcb->local_port));
+}
+
+/** Keep snd_buf plus the bytes queued (written but not acked) within snd_buf_max */
+static void
+tcp_autotune_clamp_snd_buf(struct tcp_pcb *pcb)
+{
+  u32_t queued = pcb->snd_lbb - pcb->lastack;
+
+  if ((u32_t)pcb->snd_buf + queued > pcb->snd_buf_max) {
+    pcb->snd_buf = (tcpwnd_size_t)((pcb->snd_buf_max > queued) ? (pcb->snd_buf_max - queued) : 0);
+  }
+}
+
+/** Shrink the pcb to at most wnd/snd_buf, without dropping data */
+static void
+tcp_autotune_shrink(struct tcp_pcb *pcb, u32_t wnd, u32_t snd_buf)
+{
+  u32_t announced;
+
+  if (pcb->rcv_wnd_max > wnd) {
+    pcb->rcv_wnd_max = (tcpwnd_size_t)wnd;
+    /* never retract what was already announced: tcp_receive() would trim
+       the data the peer sends into it. tcp_recved() lets the window close
+       down to rcv_wnd_max as the peer uses it up. */
+    announced = 0;
+    if (TCP_SEQ_GT(pcb->rcv_ann_right_edge, pcb->rcv_nxt)) {
+      announced = pcb->rcv_ann_right_edge - pcb->rcv_nxt;
+    }
+    pcb->rcv_wnd = (tcpwnd_size_t)LWIP_MIN(pcb->rcv_wnd, LWIP_MAX(wnd, announced));
+    tcp_update_rcv_ann_wnd(pcb);
+    /* measure again from scratch once the pressure is gone */
+    pcb->at_rcv_space = 0;
+    LWIP_DEBUGF(TCP_WND_DEBUG, ("tcp_autotune: rcv_wnd_max %"TCPWNDSIZE_F" for port %"U16_F"\n",
+                                pcb->rcv_wnd_max, pcb->local_port));
+  }
+  if (pcb->snd_buf_max > snd_buf) {
+    pcb->snd_buf_max = (tcpwnd_size_t)snd_buf;
+    /* queued data is not dropped, snd_buf stays 0 until it is acked */
+    tcp_autotune_clamp_snd_buf(pcb);
+    pcb->ssthresh = LWIP_MIN(pcb->ssthresh, LWIP_MAX(pcb->snd_buf_max, 2 * pcb->mss));
+    LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_autotune: snd_buf_max %"TCPWNDSIZE_F" for port %"U16_F"\n",
+                                 pcb->snd_buf_max, pcb->local_port));
+  }
+}
+
+/** Round trip time in milliseconds, 0 if not known yet */
+static u32_t
+tcp_autotune_rtt_ms(struct tcp_pcb *pcb)
+{
+  if (pcb->at_srtt != 0 && (pcb->at_rcv_rtt == 0 || pcb->at_srtt < pcb->at_rcv_rtt)) {
+    return pcb->at_srtt;
+  }
+  return pcb->at_rcv_rtt;
+}
+
+/**
+ * Called from tcp_receive() when the segment timed by pcb->rttest is
+ * acknowledged. tcp_ticks are too coarse to size a window, so the segment
+ * is timed again with sys_now().
+ */
+void
+tcp_autotune_rtt(struct tcp_pcb *pcb)
+{
+  u32_t m = sys_now() - pcb->at_rttest;
+
+  m = LWIP_MAX(m, 1);
+  if (pcb->at_srtt == 0) {
+    pcb->at_srtt = m;
+  } else if (m > pcb->at_srtt) {
+    pcb->at_srtt += (m - pcb->at_srtt) >> 3;
+  } else {
+    pcb->at_srtt -= (pcb->at_srtt - m) >> 3;
+  }
+  pcb->at_srtt = LWIP_MAX(pcb->at_srtt, 1);
+}
+
+static void
+tcp_autotune_rcv_rtt_start(struct tcp_pcb *pcb, u32_t now)
+{
+  pcb->at_rcv_rtt_seq = pcb->rcv_nxt + pcb->rcv_wnd;
+  if (TCP_SEQ_GT(pcb->rcv_ann_right_edge, pcb->at_rcv_rtt_seq)) {
+    pcb->at_rcv_rtt_seq = pcb->rcv_ann_right_edge;
+  }
+  pcb->at_rcv_rtt_time = now;
+}
+
+/**
+ * Called from tcp_receive() after in-sequence data was accepted.
+ * Grows the receive window when the peer sent (almost) a full window
+ * during the last round trip.
+ */
+void
+tcp_autotune_rcvd(struct tcp_pcb *pcb)
+{
+  u32_t now = sys_now();
+  u32_t rtt, elapsed, copied;
+
+  if (pcb->state != ESTABLISHED) {
+    return;
+  }
+
+  /* A receiver without data to send has no RTT sample of its own. Data
+     beyond the current right edge of the window can only arrive after the
+     peer got a later ACK, so the time until it does is an upper bound of
+     the RTT; keep the smallest. */
+  if (!(pcb->at_flags & TCP_AT_RCV_RTT)) {
+    pcb->at_flags |= TCP_AT_RCV_RTT;
+    tcp_autotune_rcv_rtt_start(pcb, now);
+  } else if (TCP_SEQ_GT(pcb->rcv_nxt, pcb->at_rcv_rtt_seq)) {
+    rtt = LWIP_MAX(now - pcb->at_rcv_rtt_time, 1);
+    if (pcb->at_rcv_rtt == 0 || rtt < pcb->at_rcv_rtt) {
+      pcb->at_rcv_rtt = rtt;
+    }
+    tcp_autotune_rcv_rtt_start(pcb, now);
+  }
+
+  if (!(pcb->at_flags & TCP_AT_RCV)) {
+    pcb->at_flags |= TCP_AT_RCV;
+    pcb->at_rcv_seq = pcb->rcv_nxt;
+    pcb->at_rcv_time = now;
+    return;
+  }
+  rtt = tcp_autotune_rtt_ms(pcb);
+  elapsed = now - pcb->at_rcv_time;
+  if (rtt == 0 || elapsed < rtt) {
+    return;
+  }
+  copied = pcb->rcv_nxt - pcb->at_rcv_seq;
+  /* an interval that spans an idle period says nothing about the rate */
+  if (elapsed < 2 * rtt &&
+      (copied > pcb->at_rcv_space || copied + pcb->mss > pcb->rcv_wnd_max)) {
+    /* a new high or a sender stalled on the window we offer */
+    pcb->at_rcv_space = LWIP_MAX(pcb->at_rcv_space, copied);
+    /* leave room for the sender to double its rate in slow start */
+    if (tcp_autotune_level == 0) {
+      tcp_autotune_grow_wnd(pcb, 2 * copied, 1);
+    }
+  }
+  pcb->at_rcv_seq = pcb->rcv_nxt;
+  pcb->at_rcv_time = now;
+}
+
+/**
+ * Called from tcp_receive() after snd_buf was credited with acked bytes.
+ * Grows the send buffer when it, not cwnd or the peer's window, limited
+ * the amount in flight during the last round trip.
+ */
+void
+tcp_autotune_acked(struct tcp_pcb *pcb, tcpwnd_size_t acked)
+{
+  u32_t now = sys_now();
+  u32_t rtt, elapsed;
+
+  /* a shrunk send buffer only gets back what exceeds the queued data */
+  tcp_autotune_clamp_snd_buf(pcb);
+  if (pcb->state != ESTABLISHED && pcb->state != CLOSE_WAIT) {
+    return;
+  }
+  /* everything queued is in flight and no more fitted: buffer limited */
+  if (pcb->unsent == NULL && pcb->snd_buf < (tcpwnd_size_t)(acked + pcb->mss)) {
+    pcb->at_flags |= TCP_AT_SNDLIM;
+  }
+  if (!(pcb->at_flags & TCP_AT_SND)) {
+    pcb->at_flags |= TCP_AT_SND;
+    pcb->at_snd_acked = acked;
+    pcb->at_snd_time = now;
+    return;
+  }
+  pcb->at_snd_acked += acked;
+  rtt = tcp_autotune_rtt_ms(pcb);
+  elapsed = now - pcb->at_snd_time;
+  if (rtt == 0 || elapsed < rtt) {
+    return;
+  }
+  if (elapsed < 2 * rtt && (pcb->at_flags & TCP_AT_SNDLIM) && tcp_autotune_level == 0) {
+    tcp_autotune_grow_snd_buf(pcb, 2 * pcb->at_snd_acked, 1);
+  }
+  pcb->at_flags &= ~TCP_AT_SNDLIM;
+  pcb->at_snd_acked = 0;
+  pcb->at_snd_time = now;
+}
+
+/** Called from tcp_enqueue_flags()/tcp_write() when an allocation failed */
+void
+tcp_autotune_memerr(void)
+{
+  tcp_autotune_memerr_ticks = TCP_AUTOTUNE_MEMERR_TICKS;
+  tcp_autotune_level = LWIP_MAX(tcp_autotune_level, 1);
+}
+
+/**
+ * Called from tcp_slowtmr(): update the pressure level and shrink or
+ * restore the windows and send buffers of all active pcbs accordingly.
+ */
+void
+tcp_autotune_tmr(void)
+{
+  struct tcp_pcb *pcb;
+  u32_t now = sys_now();
+  u32_t used = 0;
+  u32_t wnd, snd_buf;
+  u8_t level = tcp_autotune_pressure();
+
+  for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
+    used += (u32_t)pcb->rcv_wnd_max + pcb->snd_buf_max;
+  }
+  if (level == 0 && used > TCP_AUTOTUNE_MEM_LIMIT) {
+    level = 1;
+  }
+  if (level != tcp_autotune_level) {
+    LWIP_DEBUGF(TCP_WND_DEBUG, ("tcp_autotune: pressure %"U16_F", %"U32_F" bytes\n",
+                                (u16_t)level, used));
+  }
+  tcp_autotune_level = level;
+
+  used = 0;
+  for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
+    tcp_autotune_caps(pcb, level, &wnd, &snd_buf);
+    if (level == 0) {
+      /* idle connections give back what they grew */
+      if (!(pcb->at_flags & TCP_AT_RCV) ||
+          (u32_t)(now - pcb->at_rcv_time) >= TCP_AUTOTUNE_IDLE_TIME) {
+        wnd = LWIP_MIN(wnd, TCP_AUTOTUNE_BASE_WND);
+        pcb->at_rcv_space = 0;
+      }
+      if (!(pcb->at_flags & TCP_AT_SND) ||
+          (u32_t)(now - pcb->at_snd_time) >= TCP_AUTOTUNE_IDLE_TIME) {
+        snd_buf = LWIP_MIN(snd_buf, TCP_AUTOTUNE_BASE_SND_BUF);
+      }
+    }
+    tcp_autotune_shrink(pcb, wnd, snd_buf);
+    if (level < 2) {
+      /* give back what critical pressure took */
+      tcp_autotune_grow_wnd(pcb, TCP_AUTOTUNE_BASE_WND, 0);
+      tcp_autotune_grow_snd_buf(pcb, TCP_AUTOTUNE_BASE_SND_BUF, 0);
+      if (pcb->flags & TF_ACK_NOW) {
+        /* the peer may be waiting for the window to open */
+        tcp_output(pcb);
+      }
+    }
+    used += (u32_t)pcb->rcv_wnd_max + pcb->snd_buf_max;
+  }
+  tcp_autotune_used = used;
+}
+
+/**
+ * @ingroup tcp_raw
+ * Mark a connection as bulk transfer (TCP_AUTOTUNE_BULK: may grow up to
+ * TCP_AUTOTUNE_WND_MAX/TCP_AUTOTUNE_SND_BUF_MAX), interactive
+ * (TCP_AUTOTUNE_INTERACTIVE: keeps TCP_WND/TCP_SND_BUF) or default
+ * (TCP_AUTOTUNE_DEFAULT: may grow to twice TCP_WND/TCP_SND_BUF).
+ *
+ * @param pcb the tcp_pcb to mark (not a listening pcb)
+ * @param mode one of TCP_AUTOTUNE_DEFAULT, _BULK or _INTERACTIVE
+ */
+void
+tcp_autotune_mode(struct tcp_pcb *pcb, u8_t mode)
+{
+  u32_t wnd, snd_buf;
+
+  LWIP_ASSERT("tcp_autotune_mode: invalid pcb", pcb != NULL && pcb->state != LISTEN);
+  pcb->at_mode = mode;
+  tcp_autotune_caps(pcb, tcp_autotune_level, &wnd, &snd_buf);
+  tcp_autotune_shrink(pcb, wnd, snd_buf);
+}
+
+#endif /* LWIP_TCP && LWIP_TCP_AUTOTUNE */
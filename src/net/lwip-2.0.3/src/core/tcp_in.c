@@ -1246,6 +1246,9 @@ tcp_receive(struct tcp_pcb *pcb)
       }
     }
     pcb->snd_buf += recv_acked;
+#if LWIP_TCP_AUTOTUNE
+    tcp_autotune_acked(pcb, recv_acked);
+#endif /* LWIP_TCP_AUTOTUNE */
     /* End of ACK for new data processing. */
 
     LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_receive: pcb->rttest %"U32_F" rtseq %"U32_F" ackno %"U32_F"\n",
@@ -1258,6 +1261,9 @@ tcp_receive(struct tcp_pcb *pcb)
       /* diff between this shouldn't exceed 32K since this are tcp timer ticks
          and a round-trip shouldn't be that long... */
       m = (s16_t)(tcp_ticks - pcb->rttest);
+#if LWIP_TCP_AUTOTUNE
+      tcp_autotune_rtt(pcb);
+#endif /* LWIP_TCP_AUTOTUNE */
 
       LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_receive: experienced rtt %"U16_F" ticks (%"U16_F" msec).\n",
                                   m, (u16_t)(m * TCP_SLOW_INTERVAL)));
@@ -1466,6 +1472,9 @@ tcp_receive(struct tcp_pcb *pcb)
         pcb->rcv_wnd -= tcplen;
 
         tcp_update_rcv_ann_wnd(pcb);
+#if LWIP_TCP_AUTOTUNE
+        tcp_autotune_rcvd(pcb);
+#endif /* LWIP_TCP_AUTOTUNE */
 
         /* If there is data in the segment, we make preparations to
            pass this up to the application. The ->recv_data variable
@@ -1783,6 +1792,9 @@ tcp_parseopt(struct tcp_pcb *pcb)
           LWIP_ASSERT("window not at default value", pcb->rcv_wnd == TCPWND_MIN16(TCP_WND));
           LWIP_ASSERT("window not at default value", pcb->rcv_ann_wnd == TCPWND_MIN16(TCP_WND));
           pcb->rcv_wnd = pcb->rcv_ann_wnd = TCP_WND;
+#if LWIP_TCP_AUTOTUNE
+          pcb->rcv_wnd_max = TCP_WND;
+#endif /* LWIP_TCP_AUTOTUNE */
         }
         break;
 #endif
@@ -758,6 +758,12 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
 memerr:
   pcb->flags |= TF_NAGLEMEMERR;
   TCP_STATS_INC(tcp.memerr);
+#if LWIP_TCP_AUTOTUNE
+  if ((queuelen <= TCP_SND_QUEUELEN) && (queuelen <= TCP_SNDQUEUELEN_OVERFLOW)) {
+    /* an allocation failed, not just the queue limit */
+    tcp_autotune_memerr();
+  }
+#endif /* LWIP_TCP_AUTOTUNE */
 
   if (concat_p != NULL) {
     pbuf_free(concat_p);
@@ -827,6 +833,9 @@ tcp_enqueue_flags(struct tcp_pcb *pcb, u8_t flags)
   if ((p = pbuf_alloc(PBUF_TRANSPORT, optlen, PBUF_RAM)) == NULL) {
     pcb->flags |= TF_NAGLEMEMERR;
     TCP_STATS_INC(tcp.memerr);
+#if LWIP_TCP_AUTOTUNE
+    tcp_autotune_memerr();
+#endif /* LWIP_TCP_AUTOTUNE */
     return ERR_MEM;
   }
   LWIP_ASSERT("tcp_enqueue_flags: check that first pbuf can hold optlen",
@@ -836,6 +845,9 @@ tcp_enqueue_flags(struct tcp_pcb *pcb, u8_t flags)
   if ((seg = tcp_create_segment(pcb, p, flags, pcb->snd_lbb, optflags)) == NULL) {
     pcb->flags |= TF_NAGLEMEMERR;
     TCP_STATS_INC(tcp.memerr);
+#if LWIP_TCP_AUTOTUNE
+    tcp_autotune_memerr();
+#endif /* LWIP_TCP_AUTOTUNE */
     return ERR_MEM;
   }
   LWIP_ASSERT("seg->tcphdr not aligned", ((mem_ptr_t)seg->tcphdr % LWIP_MIN(MEM_ALIGNMENT, 4)) == 0);
@@ -1255,6 +1267,9 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
   if (pcb->rttest == 0) {
     pcb->rttest = tcp_ticks;
     pcb->rtseq = lwip_ntohl(seg->tcphdr->seqno);
+#if LWIP_TCP_AUTOTUNE
+    pcb->at_rttest = sys_now();
+#endif /* LWIP_TCP_AUTOTUNE */
 
     LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_output_segment: rtseq %"U32_F"\n", pcb->rtseq));
   }
@@ -121,9 +121,13 @@ static enum tcase {
   TEST_LWIP_DHCP_NAK,
   TEST_LWIP_DHCP_RELAY,
   TEST_LWIP_DHCP_NAK_NO_ENDMARKER,
-  TEST_LWIP_DHCP_INVALID_OVERLOAD
+  TEST_LWIP_DHCP_INVALID_OVERLOAD,
+  TEST_LWIP_DHCP_REBOOT
 } tcase;
 
+/* Number of INIT-REBOOT requests expected before falling back to discover */
+static int reboot_requests;
+
 static int debug = 0;
 static void setdebug(int a) {debug = a;}
 
@@ -417,6 +421,44 @@ static err_t lwip_tx_func(struct netif *netif, struct pbuf *p)
     }
     break;
 
+  case TEST_LWIP_DHCP_REBOOT:
+    {
+      const u8_t arpproto[] = { 0x08, 0x06 };
+      const u8_t ipproto[] = { 0x08, 0x00 };
+      const u8_t bootp_start[] = { 0x01, 0x01, 0x06, 0x00}; /* bootp request, eth, hwaddr len 6, 0 hops */
+      const u8_t ipaddrs[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+      check_pkt(p, 0, broadcast, 6); /* eth level dest: broadcast */
+      check_pkt(p, 6, netif->hwaddr, 6); /* eth level src: unit mac */
+
+      if (txpacket > reboot_requests && netif_dhcp_data(netif)->state == DHCP_STATE_BOUND) {
+        check_pkt(p, 12, arpproto, sizeof(arpproto)); /* gratuitous ARP after bind */
+        break;
+      }
+
+      check_pkt(p, 12, ipproto, sizeof(ipproto)); /* eth level proto: ip */
+
+      check_pkt(p, 42, bootp_start, sizeof(bootp_start));
+
+      check_pkt(p, 53, ipaddrs, sizeof(ipaddrs)); /* no ciaddr in INIT-REBOOT */
+
+      check_pkt(p, 70, netif->hwaddr, 6); /* mac addr inside bootp */
+
+      check_pkt(p, 278, magic_cookie, sizeof(magic_cookie));
+
+      if (txpacket <= reboot_requests) {
+        u8_t dhcp_request_opt[] = { 0x35, 0x01, 0x03 };
+        u8_t requested_ipaddr[] = { 0x32, 0x04, 0xc3, 0xaa, 0xbd, 0xc8 }; /* Ask for the old IP */
+
+        check_pkt_fuzzy(p, 282, dhcp_request_opt, sizeof(dhcp_request_opt));
+        check_pkt_fuzzy(p, 282, requested_ipaddr, sizeof(requested_ipaddr));
+      } else {
+        u8_t dhcp_discover_opt[] = { 0x35, 0x01, 0x01 };
+        check_pkt_fuzzy(p, 282, dhcp_discover_opt, sizeof(dhcp_discover_opt));
+      }
+      break;
+    }
+
   default:
     break;
   }
@@ -1009,6 +1051,131 @@ START_TEST(test_dhcp_invalid_overload)
 }
 END_TEST
 
+#if LWIP_XR_IMPL
+/*
+ * Test INIT-REBOOT with the address of a previous lease:
+ * one REQUEST, no DISCOVER/OFFER, bound on the ACK.
+ */
+START_TEST(test_dhcp_reboot)
+{
+  ip4_addr_t addr;
+  ip4_addr_t netmask;
+  ip4_addr_t gw;
+  ip4_addr_t old_addr;
+  u32_t xid;
+  LWIP_UNUSED_ARG(_i);
+
+  tcase = TEST_LWIP_DHCP_REBOOT;
+  reboot_requests = 1;
+  setdebug(0);
+
+  IP4_ADDR(&addr, 0, 0, 0, 0);
+  IP4_ADDR(&netmask, 0, 0, 0, 0);
+  IP4_ADDR(&gw, 0, 0, 0, 0);
+  IP4_ADDR(&old_addr, 195, 170, 189, 200);
+
+  netif_add(&net_test, &addr, &netmask, &gw, &net_test, testif_init, ethernet_input);
+  netif_set_up(&net_test);
+
+  dhcp_start_reboot(&net_test, &old_addr);
+
+  fail_unless(txpacket == 1); /* DHCP request sent */
+  fail_unless(netif_dhcp_data(&net_test)->state == DHCP_STATE_REBOOTING);
+
+  /* IP addresses should be zero until the server confirms */
+  fail_if(memcmp(&addr, &net_test.ip_addr, sizeof(ip4_addr_t)));
+
+  xid = htonl(netif_dhcp_data(&net_test)->xid);
+  memcpy(&dhcp_ack[46], &xid, 4); /* insert transaction id */
+  send_pkt(&net_test, dhcp_ack, sizeof(dhcp_ack));
+
+  fail_unless(netif_dhcp_data(&net_test)->state == DHCP_STATE_BOUND);
+  fail_unless(txpacket == 2, "TX %d packets, expected 2", txpacket); /* Gratuitous ARP, no DHCP */
+
+  IP4_ADDR(&netmask, 255, 255, 255, 0);
+  IP4_ADDR(&gw, 195, 170, 189, 171);
+  fail_if(memcmp(&old_addr, &net_test.ip_addr, sizeof(ip4_addr_t)));
+  fail_if(memcmp(&netmask, &net_test.netmask, sizeof(ip4_addr_t)));
+  fail_if(memcmp(&gw, &net_test.gw, sizeof(ip4_addr_t)));
+
+  netif_remove(&net_test);
+}
+END_TEST
+
+/*
+ * Test that a NAK to INIT-REBOOT falls back to discover.
+ */
+START_TEST(test_dhcp_reboot_nak)
+{
+  ip4_addr_t addr;
+  ip4_addr_t old_addr;
+  u8_t dhcp_nak[sizeof(dhcp_ack)];
+  u32_t xid;
+  LWIP_UNUSED_ARG(_i);
+
+  tcase = TEST_LWIP_DHCP_REBOOT;
+  reboot_requests = 1;
+  setdebug(0);
+
+  IP4_ADDR(&addr, 0, 0, 0, 0);
+  IP4_ADDR(&old_addr, 195, 170, 189, 200);
+
+  netif_add(&net_test, &addr, &addr, &addr, &net_test, testif_init, ethernet_input);
+  netif_set_up(&net_test);
+
+  dhcp_start_reboot(&net_test, &old_addr);
+
+  fail_unless(txpacket == 1); /* DHCP request sent */
+
+  memcpy(dhcp_nak, dhcp_ack, sizeof(dhcp_ack));
+  dhcp_nak[284] = 0x06; /* Dhcp message type nak */
+  xid = htonl(netif_dhcp_data(&net_test)->xid);
+  memcpy(&dhcp_nak[46], &xid, 4); /* insert transaction id */
+  send_pkt(&net_test, dhcp_nak, sizeof(dhcp_nak));
+
+  fail_unless(txpacket == 2, "TX %d packets, expected 2", txpacket); /* DHCP discover sent */
+  fail_unless(netif_dhcp_data(&net_test)->state == DHCP_STATE_SELECTING);
+  fail_if(memcmp(&addr, &net_test.ip_addr, sizeof(ip4_addr_t)));
+
+  netif_remove(&net_test);
+}
+END_TEST
+
+/*
+ * Test that INIT-REBOOT without an answer falls back to discover.
+ */
+START_TEST(test_dhcp_reboot_timeout)
+{
+  ip4_addr_t addr;
+  ip4_addr_t old_addr;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  tcase = TEST_LWIP_DHCP_REBOOT;
+  reboot_requests = 2; /* REBOOT_TRIES */
+  setdebug(0);
+
+  IP4_ADDR(&addr, 0, 0, 0, 0);
+  IP4_ADDR(&old_addr, 195, 170, 189, 200);
+
+  netif_add(&net_test, &addr, &addr, &addr, &net_test, testif_init, ethernet_input);
+  netif_set_up(&net_test);
+
+  dhcp_start_reboot(&net_test, &old_addr);
+
+  fail_unless(txpacket == 1); /* DHCP request sent */
+
+  for (i = 0; i < 40 && txpacket < 3; i++) {
+    tick_lwip();
+  }
+  fail_unless(txpacket == 3, "TX %d packets, expected 3", txpacket); /* retry, then discover */
+  fail_unless(netif_dhcp_data(&net_test)->state == DHCP_STATE_SELECTING);
+
+  netif_remove(&net_test);
+}
+END_TEST
+#endif /* LWIP_XR_IMPL */
+
 /** Create the suite including all tests for this module */
 Suite *
 dhcp_suite(void)
@@ -1018,7 +1185,12 @@ dhcp_suite(void)
     TESTFUNC(test_dhcp_nak),
     TESTFUNC(test_dhcp_relayed),
     TESTFUNC(test_dhcp_nak_no_endmarker),
-    TESTFUNC(test_dhcp_invalid_overload)
+    TESTFUNC(test_dhcp_invalid_overload),
+#if LWIP_XR_IMPL
+    TESTFUNC(test_dhcp_reboot),
+    TESTFUNC(test_dhcp_reboot_nak),
+    TESTFUNC(test_dhcp_reboot_timeout),
+#endif
   };
   return create_suite("DHCP", tests, sizeof(tests)/sizeof(testfunc), dhcp_setup, dhcp_teardown);
 }
@@ -7,6 +7,8 @@
 #include <check.h>
 #include <stdlib.h>
 
+#include "lwip/arch.h"
+
 #define FAIL_RET() do { fail(); return; } while(0)
 #define EXPECT(x) fail_unless(x)
 #define EXPECT_RET(x) do { fail_unless(x); if(!(x)) { return; }} while(0)
@@ -24,6 +26,9 @@ typedef struct {
 #define tcase_add_named_test(tc,tf) \
    _tcase_add_test((tc),(tf).func,(tf).name,0, 0, 0, 1)
 
+/** Current time returned by sys_now(), advanced by the tests */
+extern u32_t lwip_sys_now;
+
 /** typedef for a function returning a test suite */
 typedef Suite* (suite_getter_fn)(void);
 
@@ -4,6 +4,7 @@
 #include "udp/test_udp.h"
 #include "tcp/test_tcp.h"
 #include "tcp/test_tcp_oos.h"
+#include "tcp/test_tcp_autotune.h"
 #include "core/test_mem.h"
 #include "core/test_pbuf.h"
 #include "etharp/test_etharp.h"
@@ -11,6 +12,16 @@
 #include "mdns/test_mdns.h"
 
 #include "lwip/init.h"
+#include "lwip/sys.h"
+
+/* Time is simulated: tests advance lwip_sys_now themselves */
+u32_t lwip_sys_now;
+
+u32_t
+sys_now(void)
+{
+  return lwip_sys_now;
+}
 
 Suite* create_suite(const char* name, testfunc *tests, size_t num_tests, SFun setup, SFun teardown)
 {
@@ -42,6 +53,7 @@ int main(void)
     udp_suite,
     tcp_suite,
     tcp_oos_suite,
+    tcp_autotune_suite,
     mem_suite,
     pbuf_suite,
     etharp_suite,
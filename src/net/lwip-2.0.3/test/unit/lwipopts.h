@@ -41,6 +41,9 @@
 /* Enable DHCP to test it, disable UDP checksum to easier inject packets */
 #define LWIP_DHCP                       1
 
+/* Vendor additions, eg. dhcp_start_reboot() */
+#define LWIP_XR_IMPL                    1
+
 /* Minimal changes to opt.h required for tcp unit tests: */
 #define MEM_SIZE                        16000
 #define TCP_SND_QUEUELEN                40
@@ -51,6 +54,16 @@
 #define TCP_RCV_SCALE                   0
 #define PBUF_POOL_SIZE                  400 /* pbuf tests need ~200KByte */
 
+/* Window autotuning, the tests control the port's pressure signal */
+#define LWIP_TCP_AUTOTUNE               1
+#define TCP_AUTOTUNE_WND_MAX            (64 * TCP_MSS)
+#define TCP_AUTOTUNE_SND_BUF_MAX        (16 * TCP_MSS)
+#define TCP_AUTOTUNE_MEM_LIMIT          (100 * TCP_MSS)
+#undef  MEMP_NUM_TCP_SEG                /* ooseq must hold a grown window */
+#define MEMP_NUM_TCP_SEG                (TCP_SND_QUEUELEN + TCP_AUTOTUNE_WND_MAX / TCP_MSS)
+extern unsigned char test_tcp_autotune_pressure;
+#define TCP_AUTOTUNE_MEM_PRESSURE()     test_tcp_autotune_pressure
+
 /* Enable IGMP and MDNS for MDNS tests */
 #define LWIP_IGMP                       1
 #define LWIP_MDNS_RESPONDER             1
@@ -0,0 +1,644 @@
+#include "test_tcp_autotune.h"
+
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/stats.h"
+#include "tcp_helper.h"
+
+#include <string.h>
+
+#if !LWIP_STATS || !TCP_STATS || !MEMP_STATS
+#error "This tests needs TCP- and MEMP-statistics enabled"
+#endif
+#if !LWIP_TCP_AUTOTUNE
+#error "This tests needs LWIP_TCP_AUTOTUNE enabled"
+#endif
+#if TCP_AUTOTUNE_WND_MAX <= 2 * TCP_WND
+#error "This tests needs TCP_AUTOTUNE_WND_MAX to be > 2 * TCP_WND"
+#endif
+
+/* pressure level reported to lwIP by TCP_AUTOTUNE_MEM_PRESSURE() */
+unsigned char test_tcp_autotune_pressure;
+
+/* The tests run connections over an emulated link: every packet is delayed
+ * by TEST_AT_DELAY ms, data segments additionally queue behind a bottleneck
+ * of test_at.rate bytes per ms and every test_at.loss-th data segment is
+ * dropped. ACKs are never lost. Time advances in 1 ms steps via lwip_sys_now.
+ *
+ * For rx flows, the peer is a NewReno sender and lwIP receives; for tx
+ * flows, the application writes to lwIP as fast as it accepts data and the
+ * peer is a receiver that acks every segment. */
+#define TEST_AT_DELAY     100
+#define TEST_AT_RTO       1000
+#define TEST_AT_MAX_PKTS  512
+#define TEST_AT_MAX_OOSEQ 128
+#define TEST_AT_MAX_FLOWS 2
+
+struct test_at_pkt {
+  u32_t due;
+  u8_t flow;
+  u32_t seq;    /* data: stream offset */
+  u32_t ack;    /* ack: stream offset */
+  u16_t len;
+  u16_t wnd;
+};
+
+struct test_at_queue {
+  struct test_at_pkt pkt[TEST_AT_MAX_PKTS];
+  u16_t head;
+  u16_t count;
+};
+
+struct test_at_flow {
+  struct tcp_pcb *pcb;
+  u8_t tx;
+  u32_t base;       /* sequence number of stream offset 0 */
+  u32_t total;      /* bytes to transfer */
+  /* sender: offsets of the first unacked and the next new byte */
+  u32_t una, nxt;
+  u32_t cwnd, ssthresh, recover, wnd_edge, rto_start;
+  u8_t dupacks;
+  /* receiver: bytes received in order, out-of-order segments (tx only) */
+  u32_t rcvd;
+  u32_t ooseq_seq[TEST_AT_MAX_OOSEQ];
+  u16_t ooseq_len[TEST_AT_MAX_OOSEQ];
+  u32_t done;       /* time the last byte was received */
+  tcpwnd_size_t wnd_peak, snd_buf_peak;
+};
+
+static struct {
+  u32_t rate;
+  u32_t loss;
+  u32_t busy;
+  u32_t data_pkts;
+  u8_t timer;
+  u8_t num_flows;
+  struct test_at_queue to_lwip;
+  struct test_at_queue to_peer;
+  struct test_at_flow flow[TEST_AT_MAX_FLOWS];
+} test_at;
+
+static struct netif test_at_netif;
+static ip_addr_t test_at_local_ip;
+static ip_addr_t test_at_remote_ip;
+static ip_addr_t test_at_netmask;
+
+/* helper functions */
+
+static u8_t
+test_at_byte(u32_t offset)
+{
+  return (u8_t)(offset ^ (offset >> 8) ^ (offset >> 16));
+}
+
+/** Put a packet on the link; data packets queue behind the bottleneck and may get lost */
+static void
+test_at_push(struct test_at_queue *q, struct test_at_pkt *pkt)
+{
+  if (pkt->len > 0) {
+    if (test_at.loss != 0 && (++test_at.data_pkts % test_at.loss) == 0) {
+      return;
+    }
+    test_at.busy = LWIP_MAX(test_at.busy, lwip_sys_now) +
+                   (pkt->len + 40 + test_at.rate - 1) / test_at.rate;
+    pkt->due = test_at.busy + TEST_AT_DELAY;
+  } else {
+    pkt->due = lwip_sys_now + TEST_AT_DELAY;
+  }
+  fail_unless(q->count < TEST_AT_MAX_PKTS);
+  q->pkt[(q->head + q->count) % TEST_AT_MAX_PKTS] = *pkt;
+  q->count++;
+}
+
+/** Take the next packet that is due from the link */
+static int
+test_at_pop(struct test_at_queue *q, struct test_at_pkt *pkt)
+{
+  if (q->count == 0 || q->pkt[q->head].due > lwip_sys_now) {
+    return 0;
+  }
+  *pkt = q->pkt[q->head];
+  q->head = (q->head + 1) % TEST_AT_MAX_PKTS;
+  q->count--;
+  return 1;
+}
+
+static void
+test_at_peer_xmit(struct test_at_flow *f, u32_t offset)
+{
+  struct test_at_pkt pkt;
+
+  memset(&pkt, 0, sizeof(pkt));
+  pkt.flow = (u8_t)(f - test_at.flow);
+  pkt.seq = offset;
+  pkt.len = (u16_t)LWIP_MIN(TCP_MSS, f->total - offset);
+  test_at_push(&test_at.to_lwip, &pkt);
+}
+
+/** rx flows: the peer sends as much as cwnd and the window allow */
+static void
+test_at_peer_send(struct test_at_flow *f)
+{
+  if (f->una < f->nxt && lwip_sys_now - f->rto_start >= TEST_AT_RTO) {
+    f->ssthresh = LWIP_MAX((f->nxt - f->una) / 2, 2 * TCP_MSS);
+    f->cwnd = TCP_MSS;
+    f->recover = f->una;
+    f->nxt = f->una;
+    f->dupacks = 0;
+    f->rto_start = lwip_sys_now;
+  }
+  while (f->nxt < f->total) {
+    u32_t len = LWIP_MIN(TCP_MSS, f->total - f->nxt);
+    if ((f->nxt + len > f->wnd_edge) || (f->nxt + len - f->una > f->cwnd)) {
+      break;
+    }
+    if (f->una == f->nxt) {
+      f->rto_start = lwip_sys_now;
+    }
+    test_at_peer_xmit(f, f->nxt);
+    f->nxt += len;
+  }
+}
+
+/** rx flows: the peer processes an ACK from lwIP */
+static void
+test_at_peer_ack(struct test_at_flow *f, u32_t ack, u16_t wnd)
+{
+  if (ack > f->una) {
+    u32_t acked = ack - f->una;
+    f->una = ack;
+    f->nxt = LWIP_MAX(f->nxt, f->una);
+    f->dupacks = 0;
+    f->rto_start = lwip_sys_now;
+    if (f->una < f->recover) {
+      /* partial ACK: the next hole was lost, too */
+      test_at_peer_xmit(f, f->una);
+    } else if (f->cwnd < f->ssthresh) {
+      f->cwnd += acked;
+    } else {
+      f->cwnd += LWIP_MAX(TCP_MSS * TCP_MSS / f->cwnd, 1);
+    }
+  } else if ((ack == f->una) && (f->nxt > f->una) && (ack + wnd == f->wnd_edge)) {
+    if (++f->dupacks == 3 && f->una >= f->recover) {
+      f->ssthresh = LWIP_MAX((f->nxt - f->una) / 2, 2 * TCP_MSS);
+      f->cwnd = f->ssthresh;
+      f->recover = f->nxt;
+      test_at_peer_xmit(f, f->una);
+    }
+  }
+  f->wnd_edge = ack + wnd;
+}
+
+/** tx flows: the peer receives a data segment and acks it */
+static void
+test_at_peer_data(struct test_at_flow *f, u32_t seq, u16_t len)
+{
+  struct test_at_pkt pkt;
+  int i, merged;
+
+  if (seq > f->rcvd) {
+    for (i = 0; i < TEST_AT_MAX_OOSEQ; i++) {
+      if (f->ooseq_len[i] == 0) {
+        f->ooseq_seq[i] = seq;
+        f->ooseq_len[i] = len;
+        break;
+      }
+    }
+  } else if (seq + len > f->rcvd) {
+    f->rcvd = seq + len;
+  }
+  do {
+    merged = 0;
+    for (i = 0; i < TEST_AT_MAX_OOSEQ; i++) {
+      if (f->ooseq_len[i] != 0 && f->ooseq_seq[i] <= f->rcvd) {
+        f->rcvd = LWIP_MAX(f->rcvd, f->ooseq_seq[i] + f->ooseq_len[i]);
+        f->ooseq_len[i] = 0;
+        merged = 1;
+      }
+    }
+  } while (merged);
+  if (f->rcvd == f->total && f->done == 0) {
+    f->done = lwip_sys_now;
+  }
+
+  memset(&pkt, 0, sizeof(pkt));
+  pkt.flow = (u8_t)(f - test_at.flow);
+  pkt.ack = f->rcvd;
+  pkt.wnd = 0xffff;
+  test_at_push(&test_at.to_lwip, &pkt);
+}
+
+/** tx flows: the application writes as much as lwIP takes */
+static void
+test_at_app_send(struct test_at_flow *f)
+{
+  u8_t buf[TCP_MSS];
+  u16_t i, len;
+
+  while (f->nxt < f->total && tcp_sndqueuelen(f->pcb) < TCP_SND_QUEUELEN) {
+    len = (u16_t)LWIP_MIN(LWIP_MIN(sizeof(buf), tcp_sndbuf(f->pcb)), f->total - f->nxt);
+    if (len == 0) {
+      break;
+    }
+    for (i = 0; i < len; i++) {
+      buf[i] = test_at_byte(f->nxt + i);
+    }
+    if (tcp_write(f->pcb, buf, len, TCP_WRITE_FLAG_COPY) != ERR_OK) {
+      break;
+    }
+    f->nxt += len;
+  }
+  tcp_output(f->pcb);
+}
+
+/** Hand a packet from the link to lwIP */
+static void
+test_at_to_lwip(struct test_at_pkt *pkt)
+{
+  struct test_at_flow *f = &test_at.flow[pkt->flow];
+  struct pbuf *p;
+  u8_t buf[TCP_MSS];
+  u16_t i;
+
+  if (f->pcb == NULL) {
+    return;
+  }
+  if (f->tx) {
+    p = tcp_create_rx_segment_wnd(f->pcb, NULL, 0, 0, f->base + pkt->ack - f->pcb->lastack,
+                                  TCP_ACK, pkt->wnd);
+  } else {
+    for (i = 0; i < pkt->len; i++) {
+      buf[i] = test_at_byte(pkt->seq + i);
+    }
+    p = tcp_create_rx_segment(f->pcb, buf, pkt->len, f->base + pkt->seq - f->pcb->rcv_nxt,
+                              f->pcb->snd_nxt - f->pcb->lastack, TCP_ACK);
+  }
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &test_at_netif);
+}
+
+/** netif output: put what lwIP sends on the link */
+static err_t
+test_at_netif_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  struct test_at_pkt pkt;
+  struct test_at_flow *f = NULL;
+  struct tcp_hdr tcphdr;
+  u16_t iphlen, hlen, i;
+  u8_t n;
+
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(ipaddr);
+
+  iphlen = (u16_t)(IPH_HL((struct ip_hdr *)p->payload) * 4);
+  EXPECT_RETX(pbuf_copy_partial(p, &tcphdr, sizeof(tcphdr), iphlen) == sizeof(tcphdr), ERR_OK);
+  for (n = 0; n < test_at.num_flows; n++) {
+    if (test_at.flow[n].pcb != NULL && test_at.flow[n].pcb->local_port == lwip_ntohs(tcphdr.src)) {
+      f = &test_at.flow[n];
+      break;
+    }
+  }
+  if (f == NULL || (TCPH_FLAGS(&tcphdr) & TCP_RST)) {
+    return ERR_OK;
+  }
+  hlen = (u16_t)(iphlen + TCPH_HDRLEN(&tcphdr) * 4);
+
+  memset(&pkt, 0, sizeof(pkt));
+  pkt.flow = n;
+  if (f->tx) {
+    pkt.seq = lwip_ntohl(tcphdr.seqno) - f->base;
+    pkt.len = (u16_t)(p->tot_len - hlen);
+    for (i = 0; i < pkt.len; i++) {
+      EXPECT_RETX(pbuf_get_at(p, (u16_t)(hlen + i)) == test_at_byte(pkt.seq + i), ERR_OK);
+    }
+    if (pkt.len > 0) {
+      test_at_push(&test_at.to_peer, &pkt);
+    }
+  } else {
+    EXPECT_RETX(p->tot_len == hlen, ERR_OK);
+    pkt.ack = lwip_ntohl(tcphdr.ackno) - f->base;
+    pkt.wnd = lwip_ntohs(tcphdr.wnd);
+    test_at_push(&test_at.to_peer, &pkt);
+  }
+  return ERR_OK;
+}
+
+/** rx flows: the application reads everything immediately */
+static err_t
+test_at_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+  struct test_at_flow *f = (struct test_at_flow *)arg;
+  u16_t i;
+
+  EXPECT_RETX(err == ERR_OK, ERR_OK);
+  if (p == NULL) {
+    return ERR_OK;
+  }
+  for (i = 0; i < p->tot_len; i++) {
+    EXPECT_RETX(pbuf_get_at(p, i) == test_at_byte(f->rcvd + i), ERR_OK);
+  }
+  f->rcvd += p->tot_len;
+  if (f->rcvd == f->total) {
+    f->done = lwip_sys_now;
+  }
+  tcp_recved(pcb, p->tot_len);
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static struct test_at_flow *
+test_at_add_flow(u8_t tx, u8_t mode, u32_t total)
+{
+  struct test_at_flow *f;
+  struct tcp_pcb *pcb;
+
+  EXPECT_RETNULL(test_at.num_flows < TEST_AT_MAX_FLOWS);
+  f = &test_at.flow[test_at.num_flows];
+  memset(f, 0, sizeof(*f));
+  pcb = tcp_new();
+  EXPECT_RETNULL(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_at_local_ip, &test_at_remote_ip,
+                (u16_t)(1000 + test_at.num_flows), (u16_t)(2000 + test_at.num_flows));
+  tcp_arg(pcb, f);
+  tcp_recv(pcb, test_at_recv);
+  pcb->snd_wnd = pcb->snd_wnd_max = 0xffff;
+  /* as if the handshake had been done */
+  pcb->cwnd = 2 * pcb->mss;
+  tcp_autotune_mode(pcb, mode);
+  EXPECT(tcp_autotune_get_mode(pcb) == mode);
+  test_at.num_flows++;
+
+  f->pcb = pcb;
+  f->tx = tx;
+  f->base = tx ? pcb->snd_nxt : pcb->rcv_nxt;
+  f->total = total;
+  f->cwnd = 2 * TCP_MSS;
+  f->ssthresh = 0x7fffffff;
+  f->wnd_edge = pcb->rcv_ann_wnd;
+  return f;
+}
+
+/** Close all flows and empty the link */
+static void
+test_at_reset(void)
+{
+  u8_t n;
+  for (n = 0; n < test_at.num_flows; n++) {
+    if (test_at.flow[n].pcb != NULL) {
+      tcp_abort(test_at.flow[n].pcb);
+    }
+  }
+  memset(&test_at, 0, sizeof(test_at));
+}
+
+/** Advance time by one millisecond */
+static void
+test_at_step(void)
+{
+  struct test_at_pkt pkt;
+  struct test_at_flow *f;
+  u8_t n;
+
+  lwip_sys_now++;
+  while (test_at_pop(&test_at.to_peer, &pkt)) {
+    f = &test_at.flow[pkt.flow];
+    if (f->tx) {
+      test_at_peer_data(f, pkt.seq, pkt.len);
+    } else {
+      test_at_peer_ack(f, pkt.ack, pkt.wnd);
+    }
+  }
+  while (test_at_pop(&test_at.to_lwip, &pkt)) {
+    test_at_to_lwip(&pkt);
+  }
+  for (n = 0; n < test_at.num_flows; n++) {
+    f = &test_at.flow[n];
+    if (f->tx) {
+      test_at_app_send(f);
+    } else {
+      test_at_peer_send(f);
+    }
+  }
+  if ((lwip_sys_now % TCP_TMR_INTERVAL) == 0) {
+    tcp_fasttmr();
+    if (++test_at.timer & 1) {
+      tcp_slowtmr();
+    }
+  }
+  for (n = 0; n < test_at.num_flows; n++) {
+    f = &test_at.flow[n];
+    f->wnd_peak = LWIP_MAX(f->wnd_peak, f->pcb->rcv_wnd_max);
+    f->snd_buf_peak = LWIP_MAX(f->snd_buf_peak, f->pcb->snd_buf_max);
+  }
+}
+
+/** Run until all flows are done, returns the time that took */
+static u32_t
+test_at_run(u32_t max_ms)
+{
+  u32_t start = lwip_sys_now;
+  u8_t n, done;
+
+  do {
+    test_at_step();
+    done = 1;
+    for (n = 0; n < test_at.num_flows; n++) {
+      if (test_at.flow[n].done == 0) {
+        done = 0;
+      }
+    }
+  } while (!done && (lwip_sys_now - start < max_ms));
+  return lwip_sys_now - start;
+}
+
+/** Transfer total bytes over a fresh connection in the given mode */
+static u32_t
+test_at_transfer(u8_t tx, u8_t mode, u32_t total, tcpwnd_size_t *peak)
+{
+  struct test_at_flow *f;
+  u32_t rate = test_at.rate, loss = test_at.loss;
+  u32_t ms;
+
+  test_at_reset();
+  test_at.rate = rate;
+  test_at.loss = loss;
+  f = test_at_add_flow(tx, mode, total);
+  EXPECT_RETX(f != NULL, 0);
+  ms = test_at_run(60000);
+  EXPECT(f->rcvd == total);
+  EXPECT(f->done != 0);
+  *peak = tx ? f->snd_buf_peak : f->wnd_peak;
+  return ms;
+}
+
+/* Setups/teardown functions */
+
+static void
+tcp_autotune_setup(void)
+{
+  tcp_remove_all();
+  memset(&test_at, 0, sizeof(test_at));
+  test_tcp_autotune_pressure = 0;
+  IP_ADDR4(&test_at_local_ip, 192, 168, 1, 1);
+  IP_ADDR4(&test_at_remote_ip, 192, 168, 1, 2);
+  IP_ADDR4(&test_at_netmask, 255, 255, 255, 0);
+  test_tcp_init_netif(&test_at_netif, NULL, &test_at_local_ip, &test_at_netmask);
+  test_at_netif.output = test_at_netif_output;
+  /* forget the connections of earlier tests */
+  tcp_autotune_tmr();
+}
+
+static void
+tcp_autotune_teardown(void)
+{
+  test_at_reset();
+  netif_list = NULL;
+  netif_default = NULL;
+  test_tcp_autotune_pressure = 0;
+  tcp_remove_all();
+  tcp_autotune_tmr();
+}
+
+
+/* Test functions */
+
+/** Receive over a lossy 200 ms RTT link: bulk connections grow their window
+ * to the bandwidth-delay product, interactive ones keep TCP_WND. */
+START_TEST(test_tcp_autotune_rx_modes)
+{
+  u32_t t_bulk, t_default, t_interactive;
+  tcpwnd_size_t peak_bulk, peak_default, peak_interactive;
+  LWIP_UNUSED_ARG(_i);
+
+  test_at.rate = 100;
+  test_at.loss = 100;
+  t_interactive = test_at_transfer(0, TCP_AUTOTUNE_INTERACTIVE, 200000, &peak_interactive);
+  t_default = test_at_transfer(0, TCP_AUTOTUNE_DEFAULT, 200000, &peak_default);
+  t_bulk = test_at_transfer(0, TCP_AUTOTUNE_BULK, 200000, &peak_bulk);
+
+  EXPECT(peak_interactive == TCP_WND);
+  EXPECT(peak_default > TCP_WND);
+  EXPECT(peak_default <= 2 * TCP_WND);
+  EXPECT(peak_bulk > 2 * TCP_WND);
+  EXPECT(peak_bulk <= TCP_AUTOTUNE_WND_MAX);
+  EXPECT(t_default < t_interactive);
+  EXPECT(3 * t_bulk < 2 * t_interactive);
+
+  /* an idle connection gives back what it grew */
+  EXPECT(test_at.flow[0].pcb->rcv_wnd_max > TCP_WND);
+  while (lwip_sys_now - test_at.flow[0].done < TCP_AUTOTUNE_IDLE_TIME + 2 * TCP_SLOW_INTERVAL) {
+    test_at_step();
+  }
+  EXPECT(test_at.flow[0].pcb->rcv_wnd_max == TCP_WND);
+}
+END_TEST
+
+/** Memory pressure shrinks the window while data is in flight, the transfer
+ * completes and the window grows again when the pressure is gone */
+START_TEST(test_tcp_autotune_rx_pressure)
+{
+  struct test_at_flow *f;
+  u32_t start;
+  LWIP_UNUSED_ARG(_i);
+
+  test_at.rate = 100;
+  test_at.loss = 100;
+  f = test_at_add_flow(0, TCP_AUTOTUNE_BULK, 400000);
+  EXPECT_RET(f != NULL);
+  start = lwip_sys_now;
+
+  while (lwip_sys_now - start < 3000) {
+    test_at_step();
+  }
+  EXPECT(f->pcb->rcv_wnd_max > 2 * TCP_WND);
+
+  test_tcp_autotune_pressure = 1;
+  while (lwip_sys_now - start < 5000) {
+    test_at_step();
+  }
+  EXPECT(f->pcb->rcv_wnd_max == TCP_WND);
+  EXPECT(f->pcb->snd_buf_max == TCP_SND_BUF);
+
+  test_tcp_autotune_pressure = 2;
+  while (lwip_sys_now - start < 7000) {
+    test_at_step();
+    /* announced window is never retracted */
+    EXPECT(TCP_SEQ_GEQ(f->pcb->rcv_nxt + f->pcb->rcv_wnd, f->pcb->rcv_ann_right_edge));
+  }
+  EXPECT(f->pcb->rcv_wnd_max == TCP_AUTOTUNE_MIN);
+  EXPECT(f->pcb->snd_buf_max == TCP_AUTOTUNE_MIN);
+  EXPECT(f->rcvd < f->total);
+
+  test_tcp_autotune_pressure = 0;
+  f->wnd_peak = 0;
+  test_at_run(60000);
+  EXPECT(f->rcvd == f->total);
+  EXPECT(f->wnd_peak > 2 * TCP_WND);
+}
+END_TEST
+
+/** Two bulk connections share TCP_AUTOTUNE_MEM_LIMIT */
+START_TEST(test_tcp_autotune_rx_budget)
+{
+  struct test_at_flow *f1, *f2;
+  struct tcp_pcb *pcb;
+  u32_t used, used_peak = 0;
+  u32_t start;
+  LWIP_UNUSED_ARG(_i);
+
+  test_at.rate = 400;
+  test_at.loss = 200;
+  f1 = test_at_add_flow(0, TCP_AUTOTUNE_BULK, 1000000);
+  f2 = test_at_add_flow(0, TCP_AUTOTUNE_BULK, 1000000);
+  EXPECT_RET(f1 != NULL && f2 != NULL);
+  start = lwip_sys_now;
+
+  while ((f1->done == 0 || f2->done == 0) && (lwip_sys_now - start < 60000)) {
+    test_at_step();
+    used = 0;
+    for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
+      used += pcb->rcv_wnd_max + pcb->snd_buf_max;
+    }
+    EXPECT_RET(used <= TCP_AUTOTUNE_MEM_LIMIT);
+    used_peak = LWIP_MAX(used_peak, used);
+  }
+  EXPECT(f1->rcvd == f1->total);
+  EXPECT(f2->rcvd == f2->total);
+  EXPECT(f1->wnd_peak > TCP_WND);
+  EXPECT(f2->wnd_peak > TCP_WND);
+  /* alone, each would have grown to TCP_AUTOTUNE_WND_MAX */
+  EXPECT(used_peak > TCP_AUTOTUNE_MEM_LIMIT - TCP_MSS);
+}
+END_TEST
+
+/** Send over a lossy 200 ms RTT link: the send buffer of a bulk connection
+ * grows when it limits the amount of data in flight */
+START_TEST(test_tcp_autotune_tx_bulk)
+{
+  u32_t t_bulk, t_interactive;
+  tcpwnd_size_t peak_bulk, peak_interactive;
+  LWIP_UNUSED_ARG(_i);
+
+  test_at.rate = 100;
+  test_at.loss = 100;
+  t_interactive = test_at_transfer(1, TCP_AUTOTUNE_INTERACTIVE, 200000, &peak_interactive);
+  t_bulk = test_at_transfer(1, TCP_AUTOTUNE_BULK, 200000, &peak_bulk);
+
+  EXPECT(peak_interactive == TCP_SND_BUF);
+  EXPECT(peak_bulk == TCP_AUTOTUNE_SND_BUF_MAX);
+  EXPECT(t_bulk < t_interactive);
+}
+END_TEST
+
+
+/** Create the suite including all tests for this module */
+Suite *
+tcp_autotune_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_tcp_autotune_rx_modes),
+    TESTFUNC(test_tcp_autotune_rx_pressure),
+    TESTFUNC(test_tcp_autotune_rx_budget),
+    TESTFUNC(test_tcp_autotune_tx_bulk)
+  };
+  return create_suite("TCP_AUTOTUNE", tests, sizeof(tests)/sizeof(testfunc), tcp_autotune_setup, tcp_autotune_teardown);
+}
@@ -36,27 +36,403 @@
 #include <string.h>
 
 #include "mbedtls/aes.h"
-#if defined(MBEDTLS_PADLOCK_C)
-#include "mbedtls/padlock.h"
-#endif
-#if defined(MBEDTLS_AESNI_C)
-#include "mbedtls/aesni.h"
-#endif
+#include "mbedtls/platform_util.h"
+
+#if defined(MBEDTLS_AES_ALT)
 
-#if defined(MBEDTLS_SELF_TEST)
 #if defined(MBEDTLS_PLATFORM_C)
 #include "mbedtls/platform.h"
 #else
-#include <stdio.h>
-#define mbedtls_printf printf
+#include <stdlib.h>
+#define mbedtls_calloc    calloc
+#define mbedtls_free      free
 #endif /* MBEDTLS_PLATFORM_C */
-#endif /* MBEDTLS_SELF_TEST */
 
-#if defined(MBEDTLS_AES_ALT)
+#include "driver/chip/hal_dma.h"
+
+/* Largest job handed to the engine in one run, bounded by a DMA transfer */
+#define AES_ALT_CE_MAX_LEN      ( DMA_DATA_MAX_LEN & ~15U )
+
+/*
+ * 32-bit integer manipulation macros (little endian)
+ */
+#ifndef GET_UINT32_LE
+#define GET_UINT32_LE(n,b,i)                            \
+{                                                       \
+    (n) = ( (uint32_t) (b)[(i)    ]       )             \
+        | ( (uint32_t) (b)[(i) + 1] <<  8 )             \
+        | ( (uint32_t) (b)[(i) + 2] << 16 )             \
+        | ( (uint32_t) (b)[(i) + 3] << 24 );            \
+}
+#endif
+
+#ifndef PUT_UINT32_LE
+#define PUT_UINT32_LE(n,b,i)                                    \
+{                                                               \
+    (b)[(i)    ] = (unsigned char) ( ( (n)       ) & 0xFF );    \
+    (b)[(i) + 1] = (unsigned char) ( ( (n) >>  8 ) & 0xFF );    \
+    (b)[(i) + 2] = (unsigned char) ( ( (n) >> 16 ) & 0xFF );    \
+    (b)[(i) + 3] = (unsigned char) ( ( (n) >> 24 ) & 0xFF );    \
+}
+#endif
+
+#if (MBEDTLS_AES_ALT_SW_MAX_LEN > 0)
+/*
+ * Software AES, encryption only, used below the engine crossover size.
+ * Tables and rounds are those of aes.c with MBEDTLS_AES_ROM_TABLES and
+ * MBEDTLS_AES_FEWER_TABLES, so they live in flash and cost 1.25 KB.
+ */
+
+/*
+ * Forward S-box
+ */
+static const unsigned char FSb[256] =
+{
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5,
+    0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+    0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0,
+    0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+    0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC,
+    0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A,
+    0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+    0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0,
+    0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+    0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B,
+    0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85,
+    0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+    0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5,
+    0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+    0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17,
+    0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88,
+    0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+    0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C,
+    0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+    0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9,
+    0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6,
+    0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+    0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E,
+    0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+    0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94,
+    0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68,
+    0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+/*
+ * Forward table
+ */
+#define FT \
+\
+    V(A5,63,63,C6), V(84,7C,7C,F8), V(99,77,77,EE), V(8D,7B,7B,F6), \
+    V(0D,F2,F2,FF), V(BD,6B,6B,D6), V(B1,6F,6F,DE), V(54,C5,C5,91), \
+    V(50,30,30,60), V(03,01,01,02), V(A9,67,67,CE), V(7D,2B,2B,56), \
+    V(19,FE,FE,E7), V(62,D7,D7,B5), V(E6,AB,AB,4D), V(9A,76,76,EC), \
+    V(45,CA,CA,8F), V(9D,82,82,1F), V(40,C9,C9,89), V(87,7D,7D,FA), \
+    V(15,FA,FA,EF), V(EB,59,59,B2), V(C9,47,47,8E), V(0B,F0,F0,FB), \
+    V(EC,AD,AD,41), V(67,D4,D4,B3), V(FD,A2,A2,5F), V(EA,AF,AF,45), \
+    V(BF,9C,9C,23), V(F7,A4,A4,53), V(96,72,72,E4), V(5B,C0,C0,9B), \
+    V(C2,B7,B7,75), V(1C,FD,FD,E1), V(AE,93,93,3D), V(6A,26,26,4C), \
+    V(5A,36,36,6C), V(41,3F,3F,7E), V(02,F7,F7,F5), V(4F,CC,CC,83), \
+    V(5C,34,34,68), V(F4,A5,A5,51), V(34,E5,E5,D1), V(08,F1,F1,F9), \
+    V(93,71,71,E2), V(73,D8,D8,AB), V(53,31,31,62), V(3F,15,15,2A), \
+    V(0C,04,04,08), V(52,C7,C7,95), V(65,23,23,46), V(5E,C3,C3,9D), \
+    V(28,18,18,30), V(A1,96,96,37), V(0F,05,05,0A), V(B5,9A,9A,2F), \
+    V(09,07,07,0E), V(36,12,12,24), V(9B,80,80,1B), V(3D,E2,E2,DF), \
+    V(26,EB,EB,CD), V(69,27,27,4E), V(CD,B2,B2,7F), V(9F,75,75,EA), \
+    V(1B,09,09,12), V(9E,83,83,1D), V(74,2C,2C,58), V(2E,1A,1A,34), \
+    V(2D,1B,1B,36), V(B2,6E,6E,DC), V(EE,5A,5A,B4), V(FB,A0,A0,5B), \
+    V(F6,52,52,A4), V(4D,3B,3B,76), V(61,D6,D6,B7), V(CE,B3,B3,7D), \
+    V(7B,29,29,52), V(3E,E3,E3,DD), V(71,2F,2F,5E), V(97,84,84,13), \
+    V(F5,53,53,A6), V(68,D1,D1,B9), V(00,00,00,00), V(2C,ED,ED,C1), \
+    V(60,20,20,40), V(1F,FC,FC,E3), V(C8,B1,B1,79), V(ED,5B,5B,B6), \
+    V(BE,6A,6A,D4), V(46,CB,CB,8D), V(D9,BE,BE,67), V(4B,39,39,72), \
+    V(DE,4A,4A,94), V(D4,4C,4C,98), V(E8,58,58,B0), V(4A,CF,CF,85), \
+    V(6B,D0,D0,BB), V(2A,EF,EF,C5), V(E5,AA,AA,4F), V(16,FB,FB,ED), \
+    V(C5,43,43,86), V(D7,4D,4D,9A), V(55,33,33,66), V(94,85,85,11), \
+    V(CF,45,45,8A), V(10,F9,F9,E9), V(06,02,02,04), V(81,7F,7F,FE), \
+    V(F0,50,50,A0), V(44,3C,3C,78), V(BA,9F,9F,25), V(E3,A8,A8,4B), \
+    V(F3,51,51,A2), V(FE,A3,A3,5D), V(C0,40,40,80), V(8A,8F,8F,05), \
+    V(AD,92,92,3F), V(BC,9D,9D,21), V(48,38,38,70), V(04,F5,F5,F1), \
+    V(DF,BC,BC,63), V(C1,B6,B6,77), V(75,DA,DA,AF), V(63,21,21,42), \
+    V(30,10,10,20), V(1A,FF,FF,E5), V(0E,F3,F3,FD), V(6D,D2,D2,BF), \
+    V(4C,CD,CD,81), V(14,0C,0C,18), V(35,13,13,26), V(2F,EC,EC,C3), \
+    V(E1,5F,5F,BE), V(A2,97,97,35), V(CC,44,44,88), V(39,17,17,2E), \
+    V(57,C4,C4,93), V(F2,A7,A7,55), V(82,7E,7E,FC), V(47,3D,3D,7A), \
+    V(AC,64,64,C8), V(E7,5D,5D,BA), V(2B,19,19,32), V(95,73,73,E6), \
+    V(A0,60,60,C0), V(98,81,81,19), V(D1,4F,4F,9E), V(7F,DC,DC,A3), \
+    V(66,22,22,44), V(7E,2A,2A,54), V(AB,90,90,3B), V(83,88,88,0B), \
+    V(CA,46,46,8C), V(29,EE,EE,C7), V(D3,B8,B8,6B), V(3C,14,14,28), \
+    V(79,DE,DE,A7), V(E2,5E,5E,BC), V(1D,0B,0B,16), V(76,DB,DB,AD), \
+    V(3B,E0,E0,DB), V(56,32,32,64), V(4E,3A,3A,74), V(1E,0A,0A,14), \
+    V(DB,49,49,92), V(0A,06,06,0C), V(6C,24,24,48), V(E4,5C,5C,B8), \
+    V(5D,C2,C2,9F), V(6E,D3,D3,BD), V(EF,AC,AC,43), V(A6,62,62,C4), \
+    V(A8,91,91,39), V(A4,95,95,31), V(37,E4,E4,D3), V(8B,79,79,F2), \
+    V(32,E7,E7,D5), V(43,C8,C8,8B), V(59,37,37,6E), V(B7,6D,6D,DA), \
+    V(8C,8D,8D,01), V(64,D5,D5,B1), V(D2,4E,4E,9C), V(E0,A9,A9,49), \
+    V(B4,6C,6C,D8), V(FA,56,56,AC), V(07,F4,F4,F3), V(25,EA,EA,CF), \
+    V(AF,65,65,CA), V(8E,7A,7A,F4), V(E9,AE,AE,47), V(18,08,08,10), \
+    V(D5,BA,BA,6F), V(88,78,78,F0), V(6F,25,25,4A), V(72,2E,2E,5C), \
+    V(24,1C,1C,38), V(F1,A6,A6,57), V(C7,B4,B4,73), V(51,C6,C6,97), \
+    V(23,E8,E8,CB), V(7C,DD,DD,A1), V(9C,74,74,E8), V(21,1F,1F,3E), \
+    V(DD,4B,4B,96), V(DC,BD,BD,61), V(86,8B,8B,0D), V(85,8A,8A,0F), \
+    V(90,70,70,E0), V(42,3E,3E,7C), V(C4,B5,B5,71), V(AA,66,66,CC), \
+    V(D8,48,48,90), V(05,03,03,06), V(01,F6,F6,F7), V(12,0E,0E,1C), \
+    V(A3,61,61,C2), V(5F,35,35,6A), V(F9,57,57,AE), V(D0,B9,B9,69), \
+    V(91,86,86,17), V(58,C1,C1,99), V(27,1D,1D,3A), V(B9,9E,9E,27), \
+    V(38,E1,E1,D9), V(13,F8,F8,EB), V(B3,98,98,2B), V(33,11,11,22), \
+    V(BB,69,69,D2), V(70,D9,D9,A9), V(89,8E,8E,07), V(A7,94,94,33), \
+    V(B6,9B,9B,2D), V(22,1E,1E,3C), V(92,87,87,15), V(20,E9,E9,C9), \
+    V(49,CE,CE,87), V(FF,55,55,AA), V(78,28,28,50), V(7A,DF,DF,A5), \
+    V(8F,8C,8C,03), V(F8,A1,A1,59), V(80,89,89,09), V(17,0D,0D,1A), \
+    V(DA,BF,BF,65), V(31,E6,E6,D7), V(C6,42,42,84), V(B8,68,68,D0), \
+    V(C3,41,41,82), V(B0,99,99,29), V(77,2D,2D,5A), V(11,0F,0F,1E), \
+    V(CB,B0,B0,7B), V(FC,54,54,A8), V(D6,BB,BB,6D), V(3A,16,16,2C)
+
+#define V(a,b,c,d) 0x##a##b##c##d
+static const uint32_t FT0[256] = { FT };
+#undef V
+
+/*
+ * Round constants
+ */
+static const uint32_t RCON[10] =
+{
+    0x00000001, 0x00000002, 0x00000004, 0x00000008,
+    0x00000010, 0x00000020, 0x00000040, 0x00000080,
+    0x0000001B, 0x00000036
+};
+
+#define ROTL8(x)  ( (uint32_t)( ( x ) <<  8 ) + (uint32_t)( ( x ) >> 24 ) )
+#define ROTL16(x) ( (uint32_t)( ( x ) << 16 ) + (uint32_t)( ( x ) >> 16 ) )
+#define ROTL24(x) ( (uint32_t)( ( x ) << 24 ) + (uint32_t)( ( x ) >>  8 ) )
+
+#define AES_FT0(idx) FT0[idx]
+#define AES_FT1(idx) ROTL8(  FT0[idx] )
+#define AES_FT2(idx) ROTL16( FT0[idx] )
+#define AES_FT3(idx) ROTL24( FT0[idx] )
+
+/*
+ * Software AES key schedule (encryption)
+ */
+static void aes_sw_setkey( mbedtls_aes_context *ctx, const unsigned char *key,
+                           unsigned int keybits )
+{
+    unsigned int i;
+    uint32_t *RK;
+
+    switch( keybits )
+    {
+        case 128: ctx->nr = 10; break;
+        case 192: ctx->nr = 12; break;
+        default : ctx->nr = 14; break;
+    }
+
+    RK = ctx->rk;
+
+    for( i = 0; i < ( keybits >> 5 ); i++ )
+    {
+        GET_UINT32_LE( RK[i], key, i << 2 );
+    }
+
+    switch( ctx->nr )
+    {
+        case 10:
+
+            for( i = 0; i < 10; i++, RK += 4 )
+            {
+                RK[4]  = RK[0] ^ RCON[i] ^
+                ( (uint32_t) FSb[ ( RK[3] >>  8 ) & 0xFF ]       ) ^
+                ( (uint32_t) FSb[ ( RK[3] >> 16 ) & 0xFF ] <<  8 ) ^
+                ( (uint32_t) FSb[ ( RK[3] >> 24 ) & 0xFF ] << 16 ) ^
+                ( (uint32_t) FSb[ ( RK[3]       ) & 0xFF ] << 24 );
+
+                RK[5]  = RK[1] ^ RK[4];
+                RK[6]  = RK[2] ^ RK[5];
+                RK[7]  = RK[3] ^ RK[6];
+            }
+            break;
+
+        case 12:
+
+            for( i = 0; i < 8; i++, RK += 6 )
+            {
+                RK[6]  = RK[0] ^ RCON[i] ^
+                ( (uint32_t) FSb[ ( RK[5] >>  8 ) & 0xFF ]       ) ^
+                ( (uint32_t) FSb[ ( RK[5] >> 16 ) & 0xFF ] <<  8 ) ^
+                ( (uint32_t) FSb[ ( RK[5] >> 24 ) & 0xFF ] << 16 ) ^
+                ( (uint32_t) FSb[ ( RK[5]       ) & 0xFF ] << 24 );
+
+                RK[7]  = RK[1] ^ RK[6];
+                RK[8]  = RK[2] ^ RK[7];
+                RK[9]  = RK[3] ^ RK[8];
+                RK[10] = RK[4] ^ RK[9];
+                RK[11] = RK[5] ^ RK[10];
+            }
+            break;
+
+        case 14:
+
+            for( i = 0; i < 7; i++, RK += 8 )
+            {
+                RK[8]  = RK[0] ^ RCON[i] ^
+                ( (uint32_t) FSb[ ( RK[7] >>  8 ) & 0xFF ]       ) ^
+                ( (uint32_t) FSb[ ( RK[7] >> 16 ) & 0xFF ] <<  8 ) ^
+                ( (uint32_t) FSb[ ( RK[7] >> 24 ) & 0xFF ] << 16 ) ^
+                ( (uint32_t) FSb[ ( RK[7]       ) & 0xFF ] << 24 );
+
+                RK[9]  = RK[1] ^ RK[8];
+                RK[10] = RK[2] ^ RK[9];
+                RK[11] = RK[3] ^ RK[10];
+
+                RK[12] = RK[4] ^
+                ( (uint32_t) FSb[ ( RK[11]       ) & 0xFF ]       ) ^
+                ( (uint32_t) FSb[ ( RK[11] >>  8 ) & 0xFF ] <<  8 ) ^
+                ( (uint32_t) FSb[ ( RK[11] >> 16 ) & 0xFF ] << 16 ) ^
+                ( (uint32_t) FSb[ ( RK[11] >> 24 ) & 0xFF ] << 24 );
+
+                RK[13] = RK[5] ^ RK[12];
+                RK[14] = RK[6] ^ RK[13];
+                RK[15] = RK[7] ^ RK[14];
+            }
+            break;
+    }
+}
+
+#define AES_FROUND(X0,X1,X2,X3,Y0,Y1,Y2,Y3)         \
+{                                                   \
+    X0 = *RK++ ^ AES_FT0( ( Y0       ) & 0xFF ) ^   \
+                 AES_FT1( ( Y1 >>  8 ) & 0xFF ) ^   \
+                 AES_FT2( ( Y2 >> 16 ) & 0xFF ) ^   \
+                 AES_FT3( ( Y3 >> 24 ) & 0xFF );    \
+                                                    \
+    X1 = *RK++ ^ AES_FT0( ( Y1       ) & 0xFF ) ^   \
+                 AES_FT1( ( Y2 >>  8 ) & 0xFF ) ^   \
+                 AES_FT2( ( Y3 >> 16 ) & 0xFF ) ^   \
+                 AES_FT3( ( Y0 >> 24 ) & 0xFF );    \
+                                                    \
+    X2 = *RK++ ^ AES_FT0( ( Y2       ) & 0xFF ) ^   \
+                 AES_FT1( ( Y3 >>  8 ) & 0xFF ) ^   \
+                 AES_FT2( ( Y0 >> 16 ) & 0xFF ) ^   \
+                 AES_FT3( ( Y1 >> 24 ) & 0xFF );    \
+                                                    \
+    X3 = *RK++ ^ AES_FT0( ( Y3       ) & 0xFF ) ^   \
+                 AES_FT1( ( Y0 >>  8 ) & 0xFF ) ^   \
+                 AES_FT2( ( Y1 >> 16 ) & 0xFF ) ^   \
+                 AES_FT3( ( Y2 >> 24 ) & 0xFF );    \
+}
+
+/*
+ * Software AES-ECB block encryption
+ */
+static void aes_sw_encrypt( mbedtls_aes_context *ctx,
+                            const unsigned char input[16],
+                            unsigned char output[16] )
+{
+    int i;
+    uint32_t *RK, X0, X1, X2, X3, Y0, Y1, Y2, Y3;
+
+    RK = ctx->rk;
+
+    GET_UINT32_LE( X0, input,  0 ); X0 ^= *RK++;
+    GET_UINT32_LE( X1, input,  4 ); X1 ^= *RK++;
+    GET_UINT32_LE( X2, input,  8 ); X2 ^= *RK++;
+    GET_UINT32_LE( X3, input, 12 ); X3 ^= *RK++;
+
+    for( i = ( ctx->nr >> 1 ) - 1; i > 0; i-- )
+    {
+        AES_FROUND( Y0, Y1, Y2, Y3, X0, X1, X2, X3 );
+        AES_FROUND( X0, X1, X2, X3, Y0, Y1, Y2, Y3 );
+    }
+
+    AES_FROUND( Y0, Y1, Y2, Y3, X0, X1, X2, X3 );
+
+    X0 = *RK++ ^ \
+            ( (uint32_t) FSb[ ( Y0       ) & 0xFF ]       ) ^
+            ( (uint32_t) FSb[ ( Y1 >>  8 ) & 0xFF ] <<  8 ) ^
+            ( (uint32_t) FSb[ ( Y2 >> 16 ) & 0xFF ] << 16 ) ^
+            ( (uint32_t) FSb[ ( Y3 >> 24 ) & 0xFF ] << 24 );
+
+    X1 = *RK++ ^ \
+            ( (uint32_t) FSb[ ( Y1       ) & 0xFF ]       ) ^
+            ( (uint32_t) FSb[ ( Y2 >>  8 ) & 0xFF ] <<  8 ) ^
+            ( (uint32_t) FSb[ ( Y3 >> 16 ) & 0xFF ] << 16 ) ^
+            ( (uint32_t) FSb[ ( Y0 >> 24 ) & 0xFF ] << 24 );
+
+    X2 = *RK++ ^ \
+            ( (uint32_t) FSb[ ( Y2       ) & 0xFF ]       ) ^
+            ( (uint32_t) FSb[ ( Y3 >>  8 ) & 0xFF ] <<  8 ) ^
+            ( (uint32_t) FSb[ ( Y0 >> 16 ) & 0xFF ] << 16 ) ^
+            ( (uint32_t) FSb[ ( Y1 >> 24 ) & 0xFF ] << 24 );
+
+    X3 = *RK++ ^ \
+            ( (uint32_t) FSb[ ( Y3       ) & 0xFF ]       ) ^
+            ( (uint32_t) FSb[ ( Y0 >>  8 ) & 0xFF ] <<  8 ) ^
+            ( (uint32_t) FSb[ ( Y1 >> 16 ) & 0xFF ] << 16 ) ^
+            ( (uint32_t) FSb[ ( Y2 >> 24 ) & 0xFF ] << 24 );
+
+    PUT_UINT32_LE( X0, output,  0 );
+    PUT_UINT32_LE( X1, output,  4 );
+    PUT_UINT32_LE( X2, output,  8 );
+    PUT_UINT32_LE( X3, output, 12 );
+}
+#endif /* MBEDTLS_AES_ALT_SW_MAX_LEN > 0 */
+
+/*
+ * Run a job through the engine, one DMA transfer at a time. The engine keeps
+ * the CBC chaining value in ctx->aes.iv between the runs.
+ */
+static int aes_ce_crypt( mbedtls_aes_context *ctx, int mode, size_t length,
+                         const unsigned char *input, unsigned char *output )
+{
+    HAL_Status status;
+    size_t len;
+
+    while( length > 0 )
+    {
+        len = ( length < AES_ALT_CE_MAX_LEN ) ? length : AES_ALT_CE_MAX_LEN;
+
+        if( mode == MBEDTLS_AES_ENCRYPT )
+            status = HAL_AES_Encrypt( &ctx->aes, (uint8_t *) input, output, len );
+        else
+            status = HAL_AES_Decrypt( &ctx->aes, (uint8_t *) input, output, len );
+        if( status != HAL_OK )
+            return( MBEDTLS_ERR_AES_HW_ACCEL_FAILED );
+
+        input  += len;
+        output += len;
+        length -= len;
+    }
+
+    return( 0 );
+}
+
+static void aes_xor( unsigned char *output, const unsigned char *a,
+                     const unsigned char *b, size_t length )
+{
+    size_t i = 0;
+
+    if( ( ( (uintptr_t) output | (uintptr_t) a | (uintptr_t) b ) & 3 ) == 0 )
+    {
+        for( ; i + 4 <= length; i += 4 )
+            *(uint32_t *)( output + i ) = *(const uint32_t *)( a + i ) ^
+                                          *(const uint32_t *)( b + i );
+    }
+    for( ; i < length; i++ )
+        output[i] = a[i] ^ b[i];
+}
+
+/* Increment the trailing len bytes of a big endian counter block */
+static void aes_ctr_inc( unsigned char counter[16], unsigned int len )
+{
+    unsigned int i;
 
-/* Implementation that should never be optimized out by the compiler */
-static void mbedtls_zeroize( void *v, size_t n ) {
-    volatile unsigned char *p = v; while( n-- ) *p++ = 0;
+    for( i = 16; i > 16 - len; i-- )
+        if( ++counter[i - 1] != 0 )
+            break;
 }
 
 void mbedtls_aes_init( mbedtls_aes_context *ctx )
@@ -69,72 +445,84 @@ void mbedtls_aes_free( mbedtls_aes_context *ctx )
     if( ctx == NULL )
         return;
 
-    mbedtls_zeroize( ctx, sizeof( mbedtls_aes_context ) );
+    mbedtls_platform_zeroize( ctx, sizeof( mbedtls_aes_context ) );
 }
 
 /*
  * AES key schedule (encryption)
  */
-#if !defined(MBEDTLS_AES_SETKEY_ENC_ALT)
 int mbedtls_aes_setkey_enc( mbedtls_aes_context *ctx, const unsigned char *key,
                     unsigned int keybits )
 {
-    switch( keybits ) {
-		case 128:
-			ctx->aes.keysize = CE_CTL_AES_KEYSIZE_128BITS;
-			memcpy(ctx->aes.key, key, 16);
-			break;
-		case 192:
-			ctx->aes.keysize = CE_CTL_AES_KEYSIZE_192BITS;
-			memcpy(ctx->aes.key, key, 24);
-			break;
-		case 256:
-			ctx->aes.keysize = CE_CTL_AES_KEYSIZE_256BITS;
-			memcpy(ctx->aes.key, key, 32);
-			break;
-		default : return( MBEDTLS_ERR_AES_INVALID_KEY_LENGTH );
+    switch( keybits )
+    {
+        case 128: ctx->aes.keysize = CE_CTL_AES_KEYSIZE_128BITS; break;
+        case 192: ctx->aes.keysize = CE_CTL_AES_KEYSIZE_192BITS; break;
+        case 256: ctx->aes.keysize = CE_CTL_AES_KEYSIZE_256BITS; break;
+        default : return( MBEDTLS_ERR_AES_INVALID_KEY_LENGTH );
     }
 
+    ctx->aes.src = CE_CTL_KEYSOURCE_INPUT;
+    memcpy( ctx->aes.key, key, keybits >> 3 );
+
+#if (MBEDTLS_AES_ALT_SW_MAX_LEN > 0)
+    aes_sw_setkey( ctx, key, keybits );
+#endif
+
     return( 0 );
 }
-#endif /* !MBEDTLS_AES_SETKEY_ENC_ALT */
 
 /*
- * AES key schedule (decryption)
+ * AES key schedule (decryption), the engine expands the key itself
  */
-#if !defined(MBEDTLS_AES_SETKEY_DEC_ALT)
 int mbedtls_aes_setkey_dec( mbedtls_aes_context *ctx, const unsigned char *key,
                     unsigned int keybits )
 {
-	mbedtls_aes_setkey_enc(ctx, key, keybits);
-
-	return( 0 );
+    return( mbedtls_aes_setkey_enc( ctx, key, keybits ) );
 }
-#endif /* !MBEDTLS_AES_SETKEY_DEC_ALT */
 
 /*
  * AES-ECB block encryption
  */
-#if !defined(MBEDTLS_AES_ENCRYPT_ALT)
-void mbedtls_aes_encrypt( mbedtls_aes_context *ctx,
-                          const unsigned char input[16],
-                          unsigned char output[16] )
+int mbedtls_internal_aes_encrypt( mbedtls_aes_context *ctx,
+                                  const unsigned char input[16],
+                                  unsigned char output[16] )
 {
-
+#if (MBEDTLS_AES_ALT_SW_MAX_LEN >= 16)
+    aes_sw_encrypt( ctx, input, output );
+    return( 0 );
+#else
+    ctx->aes.mode = CE_CTL_CRYPT_MODE_ECB;
+    return( aes_ce_crypt( ctx, MBEDTLS_AES_ENCRYPT, 16, input, output ) );
+#endif
 }
-#endif /* !MBEDTLS_AES_ENCRYPT_ALT */
 
 /*
  * AES-ECB block decryption
  */
-#if !defined(MBEDTLS_AES_DECRYPT_ALT)
-void mbedtls_aes_decrypt( mbedtls_aes_context *ctx,
+int mbedtls_internal_aes_decrypt( mbedtls_aes_context *ctx,
+                                  const unsigned char input[16],
+                                  unsigned char output[16] )
+{
+    ctx->aes.mode = CE_CTL_CRYPT_MODE_ECB;
+    return( aes_ce_crypt( ctx, MBEDTLS_AES_DECRYPT, 16, input, output ) );
+}
+
+#if !defined(MBEDTLS_DEPRECATED_REMOVED)
+void mbedtls_aes_encrypt( mbedtls_aes_context *ctx,
                           const unsigned char input[16],
                           unsigned char output[16] )
 {
+    mbedtls_internal_aes_encrypt( ctx, input, output );
+}
 
+void mbedtls_aes_decrypt( mbedtls_aes_context *ctx,
+                          const unsigned char input[16],
+                          unsigned char output[16] )
+{
+    mbedtls_internal_aes_decrypt( ctx, input, output );
 }
-#endif /* !MBEDTLS_AES_DECRYPT_ALT */
+#endif /* !MBEDTLS_DEPRECATED_REMOVED */
 
 /*
  * AES-ECB block encryption/decryption
@@ -144,14 +532,10 @@ int mbedtls_aes_crypt_ecb( mbedtls_aes_context *ctx,
                     const unsigned char input[16],
                     unsigned char output[16] )
 {
-	ctx->aes.mode = CE_CTL_CRYPT_MODE_ECB;
-
-	if (mode == MBEDTLS_AES_ENCRYPT)
-		HAL_AES_Encrypt(&ctx->aes, (uint8_t*)input, (uint8_t*)output, 16);
-	else
-		HAL_AES_Decrypt(&ctx->aes, (uint8_t*)input, (uint8_t*)output, 16);
-
-	return( 0 );
+    if( mode == MBEDTLS_AES_ENCRYPT )
+        return( mbedtls_internal_aes_encrypt( ctx, input, output ) );
+    else
+        return( mbedtls_internal_aes_decrypt( ctx, input, output ) );
 }
 
 #if defined(MBEDTLS_CIPHER_MODE_CBC)
@@ -165,20 +549,39 @@ int mbedtls_aes_crypt_cbc( mbedtls_aes_context *ctx,
                     const unsigned char *input,
                     unsigned char *output )
 {
+    int ret;
+
     if( length % 16 )
         return( MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH );
 
-	ctx->aes.mode = CE_CTL_CRYPT_MODE_CBC;
-	ctx->aes.src = CE_CTL_KEYSOURCE_INPUT;
-	memcpy(ctx->aes.iv, iv, 16);
+#if (MBEDTLS_AES_ALT_SW_MAX_LEN > 0)
+    if( mode == MBEDTLS_AES_ENCRYPT && length <= MBEDTLS_AES_ALT_SW_MAX_LEN )
+    {
+        while( length > 0 )
+        {
+            aes_xor( output, input, iv, 16 );
+            aes_sw_encrypt( ctx, output, output );
+            memcpy( iv, output, 16 );
 
-	if (mode == MBEDTLS_AES_ENCRYPT)
-		HAL_AES_Encrypt(&ctx->aes, (uint8_t*)input, (uint8_t*)output, length);
-	else
-		HAL_AES_Decrypt(&ctx->aes, (uint8_t*)input, (uint8_t*)output, length);
-	memcpy(iv, ctx->aes.iv, 16);
+            input  += 16;
+            output += 16;
+            length -= 16;
+        }
 
-	return( 0 );
+        return( 0 );
+    }
+#endif
+
+    if( length == 0 )
+        return( 0 );
+
+    ctx->aes.mode = CE_CTL_CRYPT_MODE_CBC;
+    memcpy( ctx->aes.iv, iv, 16 );
+
+    ret = aes_ce_crypt( ctx, mode, length, input, output );
+    memcpy( iv, ctx->aes.iv, 16 );
+
+    return( ret );
 }
 #endif /* MBEDTLS_CIPHER_MODE_CBC */
 
@@ -262,6 +665,111 @@ int mbedtls_aes_crypt_cfb8( mbedtls_aes_context *ctx,
 }
 #endif /*MBEDTLS_CIPHER_MODE_CFB */
 
+/*
+ * Counter mode on whole blocks: the counter blocks are laid out in memory
+ * and encrypted by the engine in ECB mode, then xored with the input. The
+ * engine's CTR mode is not used, it is broken in hardware.
+ */
+int mbedtls_aes_alt_ctr_blocks( mbedtls_aes_context *ctx,
+                                size_t nblocks,
+                                unsigned int ctr_len,
+                                unsigned char counter[16],
+                                const unsigned char *input,
+                                unsigned char *output )
+{
+    unsigned char batch[MBEDTLS_AES_ALT_CTR_BATCH];
+    unsigned char *stream, *heap = NULL;
+    size_t n, i, len, heap_len = 0;
+    int ret = 0;
+
+#if (MBEDTLS_AES_ALT_SW_MAX_LEN > 0)
+    if( nblocks <= MBEDTLS_AES_ALT_SW_MAX_LEN / 16 )
+    {
+        while( nblocks-- > 0 )
+        {
+            aes_sw_encrypt( ctx, counter, batch );
+            aes_ctr_inc( counter, ctr_len );
+            aes_xor( output, input, batch, 16 );
+
+            input  += 16;
+            output += 16;
+        }
+        mbedtls_platform_zeroize( batch, 16 );
+
+        return( 0 );
+    }
+#endif
+
+    ctx->aes.mode = CE_CTL_CRYPT_MODE_ECB;
+
+    while( nblocks > 0 )
+    {
+        len = nblocks * 16;
+
+        /*
+         * Stage the counter blocks in the output buffer when it does not
+         * overlap the input, the job then needs no copy and runs at the
+         * largest DMA size. In place jobs (TLS records) are staged in a
+         * heap buffer if they outgrow the stack one.
+         */
+        if( (uintptr_t) output >= (uintptr_t) input + len ||
+            (uintptr_t) input >= (uintptr_t) output + len )
+        {
+            stream = output;
+            n = AES_ALT_CE_MAX_LEN / 16;
+        }
+        else
+        {
+#if (MBEDTLS_AES_ALT_CTR_HEAP > MBEDTLS_AES_ALT_CTR_BATCH)
+            if( heap == NULL && len > sizeof( batch ) )
+            {
+                heap_len = ( len < MBEDTLS_AES_ALT_CTR_HEAP ) ?
+                           len : MBEDTLS_AES_ALT_CTR_HEAP & ~15U;
+                heap = mbedtls_calloc( 1, heap_len );
+            }
+#endif
+            if( heap != NULL )
+            {
+                stream = heap;
+                n = heap_len / 16;
+            }
+            else
+            {
+                stream = batch;
+                n = sizeof( batch ) / 16;
+            }
+        }
+        if( n > nblocks )
+            n = nblocks;
+        len = n * 16;
+
+        for( i = 0; i < len; i += 16 )
+        {
+            memcpy( stream + i, counter, 16 );
+            aes_ctr_inc( counter, ctr_len );
+        }
+
+        if( ( ret = aes_ce_crypt( ctx, MBEDTLS_AES_ENCRYPT, len,
+                                  stream, stream ) ) != 0 )
+            break;
+
+        aes_xor( output, input, stream, len );
+
+        input   += len;
+        output  += len;
+        nblocks -= n;
+    }
+
+    if( heap != NULL )
+    {
+        mbedtls_platform_zeroize( heap, heap_len );
+        mbedtls_free( heap );
+    }
+    mbedtls_platform_zeroize( batch, sizeof( batch ) );
+
+    return( ret );
+}
+
 #if defined(MBEDTLS_CIPHER_MODE_CTR)
 /*
  * AES-CTR buffer encryption/decryption
@@ -274,22 +782,42 @@ int mbedtls_aes_crypt_ctr( mbedtls_aes_context *ctx,
                        const unsigned char *input,
                        unsigned char *output )
 {
-    int c, i;
+    int ret;
     size_t n = *nc_off;
+    size_t nblocks;
 
-    while( length-- )
+    if( n > 0x0F )
+        return( MBEDTLS_ERR_AES_BAD_INPUT_DATA );
+
+    /* Use up the key stream left over from the previous call */
+    while( n != 0 && length > 0 )
     {
-        if( n == 0 ) {
-            mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, nonce_counter, stream_block );
+        *output++ = (unsigned char)( *input++ ^ stream_block[n] );
+        n = ( n + 1 ) & 0x0F;
+        length--;
+    }
 
-            for( i = 16; i > 0; i-- )
-                if( ++nonce_counter[i - 1] != 0 )
-                    break;
-        }
-        c = *input++;
-        *output++ = (unsigned char)( c ^ stream_block[n] );
+    nblocks = length / 16;
+    if( nblocks > 0 )
+    {
+        if( ( ret = mbedtls_aes_alt_ctr_blocks( ctx, nblocks, 16, nonce_counter,
+                                                input, output ) ) != 0 )
+            return( ret );
 
-        n = ( n + 1 ) & 0x0F;
+        input  += nblocks * 16;
+        output += nblocks * 16;
+        length -= nblocks * 16;
+    }
+
+    if( length > 0 )
+    {
+        if( ( ret = mbedtls_internal_aes_encrypt( ctx, nonce_counter,
+                                                  stream_block ) ) != 0 )
+            return( ret );
+        aes_ctr_inc( nonce_counter, 16 );
+
+        aes_xor( output, input, stream_block, length );
+        n = length;
     }
 
     *nc_off = n;
@@ -298,6 +826,6 @@ int mbedtls_aes_crypt_ctr( mbedtls_aes_context *ctx,
 }
 #endif /* MBEDTLS_CIPHER_MODE_CTR */
 
-#endif /* !MBEDTLS_AES_ALT */
+#endif /* MBEDTLS_AES_ALT */
 
 #endif /* MBEDTLS_AES_C */
@@ -102,8 +102,6 @@
 #define mbedtls_free       free
 #endif
 
-#include "mbedtls/ecp_internal.h"
-
 #if ( defined(__ARMCC_VERSION) || defined(_MSC_VER) ) && \
     !defined(inline) && !defined(__cplusplus)
 #define inline __inline
@@ -363,6 +361,9 @@ int mbedtls_ecp_check_budget( const mbedtls_ecp_group *grp,
 #define ECP_MONTGOMERY
 #endif
 
+/* after the curve types, which select the declarations it provides */
+#include "mbedtls/ecp_internal.h"
+
 /*
  * Curve types: internal for now, might be exposed later
  */
@@ -2005,6 +2006,10 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     size_t d;
     unsigned char T_size, T_ok;
     mbedtls_ecp_point *T;
+#if defined(MBEDTLS_ECP_COMB_ROM_TABLES)
+    const mbedtls_ecp_point *T_rom = NULL;
+    unsigned char w_rom;
+#endif
 
     ECP_RS_ENTER( rsm );
 
@@ -2018,9 +2023,27 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
 
     /* Pick window size and deduce related sizes */
     w = ecp_pick_window_size( grp, p_eq_g );
+
+#if defined(MBEDTLS_ECP_COMB_ROM_TABLES)
+    /* A table in ROM for the base point fixes the window size */
+    if( mbedtls_mpi_cmp_mpi( &P->Y, &grp->G.Y ) == 0 &&
+        mbedtls_mpi_cmp_mpi( &P->X, &grp->G.X ) == 0 &&
+        ( T_rom = mbedtls_internal_ecp_comb_rom( grp, &w_rom ) ) != NULL )
+        w = w_rom;
+#endif
+
     T_size = 1U << ( w - 1 );
     d = ( grp->nbits + w - 1 ) / w;
 
+#if defined(MBEDTLS_ECP_COMB_ROM_TABLES)
+    /* Pre-computed table in ROM: only ever read, see ecp_select_comb() */
+    if( T_rom != NULL )
+    {
+        T = (mbedtls_ecp_point *) T_rom;
+        T_ok = 1;
+    }
+    else
+#endif
     /* Pre-computed table: do we have it already for the base point? */
     if( p_eq_g && grp->T != NULL )
     {
@@ -2083,6 +2106,12 @@ cleanup:
     if( T == grp->T )
         T = NULL;
 
+#if defined(MBEDTLS_ECP_COMB_ROM_TABLES)
+    /* or to ROM? */
+    if( T == T_rom )
+        T = NULL;
+#endif
+
     /* does T belong to the restart context? */
 #if defined(MBEDTLS_ECP_RESTARTABLE)
     if( rs_ctx != NULL && rs_ctx->rsm != NULL && ret == MBEDTLS_ERR_ECP_IN_PROGRESS && T != NULL )
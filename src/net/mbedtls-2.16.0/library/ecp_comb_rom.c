@@ -0,0 +1,518 @@
+/*
+ *  Fixed-base comb tables for the elliptic curve generators, kept in ROM
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+/*
+ * Generated by scripts/ecp_comb_rom.py, do not edit.
+ *
+ * Each table is the one ecp_precompute_comb() builds for P = G, already
+ * normalized. Z is left unset, which ecp_add_mixed() reads as Z = 1.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_ECP_C) && defined(MBEDTLS_ECP_COMB_ROM_TABLES)
+
+#include "mbedtls/ecp.h"
+#include "mbedtls/ecp_internal.h"
+
+#include <stddef.h>
+
+#if !defined(MBEDTLS_ECP_ALT)
+
+#if defined(MBEDTLS_HAVE_INT32)
+
+#define BYTES_TO_T_UINT_4( a, b, c, d )             \
+    ( (mbedtls_mpi_uint) a <<  0 ) |                \
+    ( (mbedtls_mpi_uint) b <<  8 ) |                \
+    ( (mbedtls_mpi_uint) c << 16 ) |                \
+    ( (mbedtls_mpi_uint) d << 24 )
+
+#define BYTES_TO_T_UINT_8( a, b, c, d, e, f, g, h ) \
+    BYTES_TO_T_UINT_4( a, b, c, d ),                \
+    BYTES_TO_T_UINT_4( e, f, g, h )
+
+#else /* 64-bits */
+
+#define BYTES_TO_T_UINT_8( a, b, c, d, e, f, g, h ) \
+    ( (mbedtls_mpi_uint) a <<  0 ) |                \
+    ( (mbedtls_mpi_uint) b <<  8 ) |                \
+    ( (mbedtls_mpi_uint) c << 16 ) |                \
+    ( (mbedtls_mpi_uint) d << 24 ) |                \
+    ( (mbedtls_mpi_uint) e << 32 ) |                \
+    ( (mbedtls_mpi_uint) f << 40 ) |                \
+    ( (mbedtls_mpi_uint) g << 48 ) |                \
+    ( (mbedtls_mpi_uint) h << 56 )
+
+#endif /* bits in mbedtls_mpi_uint */
+
+#define ECP_ROM_MPI( a )                                            \
+    { 1, sizeof( a ) / sizeof( mbedtls_mpi_uint ), (mbedtls_mpi_uint *) a }
+
+#define ECP_ROM_POINT( x, y )                                       \
+    { ECP_ROM_MPI( x ), ECP_ROM_MPI( y ), { 1, 0, NULL } }
+
+#if defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+/* w = 6, d = 43 */
+static const mbedtls_mpi_uint secp256r1_T_0_X[] = {
+    BYTES_TO_T_UINT_8( 0x96, 0xC2, 0x98, 0xD8, 0x45, 0x39, 0xA1, 0xF4 ),
+    BYTES_TO_T_UINT_8( 0xA0, 0x33, 0xEB, 0x2D, 0x81, 0x7D, 0x03, 0x77 ),
+    BYTES_TO_T_UINT_8( 0xF2, 0x40, 0xA4, 0x63, 0xE5, 0xE6, 0xBC, 0xF8 ),
+    BYTES_TO_T_UINT_8( 0x47, 0x42, 0x2C, 0xE1, 0xF2, 0xD1, 0x17, 0x6B ),
+};
+static const mbedtls_mpi_uint secp256r1_T_0_Y[] = {
+    BYTES_TO_T_UINT_8( 0xF5, 0x51, 0xBF, 0x37, 0x68, 0x40, 0xB6, 0xCB ),
+    BYTES_TO_T_UINT_8( 0xCE, 0x5E, 0x31, 0x6B, 0x57, 0x33, 0xCE, 0x2B ),
+    BYTES_TO_T_UINT_8( 0x16, 0x9E, 0x0F, 0x7C, 0x4A, 0xEB, 0xE7, 0x8E ),
+    BYTES_TO_T_UINT_8( 0x9B, 0x7F, 0x1A, 0xFE, 0xE2, 0x42, 0xE3, 0x4F ),
+};
+static const mbedtls_mpi_uint secp256r1_T_1_X[] = {
+    BYTES_TO_T_UINT_8( 0xB1, 0x3F, 0x1C, 0x5A, 0x7C, 0x16, 0xDB, 0x59 ),
+    BYTES_TO_T_UINT_8( 0xB2, 0x8E, 0x31, 0xBF, 0x2A, 0xCE, 0xB3, 0x98 ),
+    BYTES_TO_T_UINT_8( 0xA6, 0x2F, 0xBC, 0xD2, 0x1E, 0xC4, 0xF1, 0x2D ),
+    BYTES_TO_T_UINT_8( 0xAF, 0xB2, 0xD1, 0x6E, 0x43, 0x2C, 0xCC, 0xEF ),
+};
+static const mbedtls_mpi_uint secp256r1_T_1_Y[] = {
+    BYTES_TO_T_UINT_8( 0x13, 0x55, 0xB2, 0x97, 0xF1, 0x07, 0xFE, 0x17 ),
+    BYTES_TO_T_UINT_8( 0x89, 0xA5, 0x34, 0x37, 0x33, 0x45, 0x82, 0x46 ),
+    BYTES_TO_T_UINT_8( 0x43, 0xF5, 0x34, 0xED, 0x77, 0x4A, 0x38, 0xA5 ),
+    BYTES_TO_T_UINT_8( 0x63, 0x38, 0x9F, 0x8D, 0x9C, 0x4F, 0x68, 0xF3 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_2_X[] = {
+    BYTES_TO_T_UINT_8( 0x8E, 0x18, 0x18, 0x73, 0x64, 0x02, 0xC9, 0xAE ),
+    BYTES_TO_T_UINT_8( 0x99, 0x70, 0x16, 0xCA, 0x28, 0xEC, 0x0B, 0x41 ),
+    BYTES_TO_T_UINT_8( 0x2B, 0x20, 0x9C, 0x09, 0x2F, 0x4D, 0x66, 0xBF ),
+    BYTES_TO_T_UINT_8( 0x5C, 0x62, 0xFA, 0x55, 0x34, 0xCA, 0xCC, 0x13 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_2_Y[] = {
+    BYTES_TO_T_UINT_8( 0x0C, 0x1C, 0x42, 0x05, 0x31, 0xC2, 0x84, 0xAA ),
+    BYTES_TO_T_UINT_8( 0x71, 0x0D, 0xDB, 0x6C, 0x21, 0x75, 0x64, 0x6B ),
+    BYTES_TO_T_UINT_8( 0x5E, 0x6A, 0x21, 0xFB, 0xB1, 0x46, 0x04, 0xE9 ),
+    BYTES_TO_T_UINT_8( 0x3D, 0x89, 0x46, 0xAF, 0xA5, 0xA5, 0x5B, 0x4B ),
+};
+static const mbedtls_mpi_uint secp256r1_T_3_X[] = {
+    BYTES_TO_T_UINT_8( 0x78, 0x1C, 0xDB, 0xCB, 0x09, 0x28, 0xB2, 0xD3 ),
+    BYTES_TO_T_UINT_8( 0xA4, 0xCD, 0xF6, 0x30, 0xEB, 0xC8, 0x91, 0x55 ),
+    BYTES_TO_T_UINT_8( 0x8B, 0x0F, 0xE8, 0xBF, 0x40, 0x87, 0xE2, 0xB6 ),
+    BYTES_TO_T_UINT_8( 0xE7, 0xE7, 0xE7, 0x40, 0x2A, 0x34, 0x74, 0x0F ),
+};
+static const mbedtls_mpi_uint secp256r1_T_3_Y[] = {
+    BYTES_TO_T_UINT_8( 0xF2, 0x51, 0x1C, 0x35, 0x87, 0x8E, 0x96, 0xD2 ),
+    BYTES_TO_T_UINT_8( 0x5E, 0x7B, 0xE1, 0xF5, 0x81, 0xC5, 0xC5, 0x65 ),
+    BYTES_TO_T_UINT_8( 0x2E, 0x4E, 0x99, 0x9D, 0x2A, 0xF0, 0x58, 0x6F ),
+    BYTES_TO_T_UINT_8( 0x07, 0xEC, 0xC1, 0xF5, 0x00, 0x0B, 0x1C, 0x53 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_4_X[] = {
+    BYTES_TO_T_UINT_8( 0x51, 0xAA, 0x21, 0x8B, 0x7D, 0xC4, 0x52, 0x2B ),
+    BYTES_TO_T_UINT_8( 0x0D, 0x87, 0x7E, 0x5A, 0x29, 0x36, 0x50, 0x0F ),
+    BYTES_TO_T_UINT_8( 0x27, 0x51, 0xB4, 0x88, 0x14, 0x28, 0xA9, 0xBA ),
+    BYTES_TO_T_UINT_8( 0x50, 0xE0, 0x02, 0xC4, 0x1E, 0x45, 0xD6, 0x27 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_4_Y[] = {
+    BYTES_TO_T_UINT_8( 0x2D, 0x43, 0x67, 0x55, 0x14, 0xEC, 0x96, 0x5C ),
+    BYTES_TO_T_UINT_8( 0xC7, 0x50, 0x41, 0x0F, 0x29, 0x98, 0xEB, 0xCD ),
+    BYTES_TO_T_UINT_8( 0x66, 0xF5, 0xEE, 0xCD, 0x0C, 0x74, 0x91, 0x5D ),
+    BYTES_TO_T_UINT_8( 0x83, 0xE5, 0xE9, 0x1B, 0x5E, 0xFA, 0x58, 0x2A ),
+};
+static const mbedtls_mpi_uint secp256r1_T_5_X[] = {
+    BYTES_TO_T_UINT_8( 0x79, 0xA9, 0x95, 0x21, 0x50, 0xC5, 0xB7, 0x73 ),
+    BYTES_TO_T_UINT_8( 0x13, 0x58, 0xDD, 0xB8, 0x74, 0xD4, 0x7E, 0x2D ),
+    BYTES_TO_T_UINT_8( 0xAC, 0xE9, 0x04, 0xE1, 0xD2, 0xEC, 0xB9, 0xC0 ),
+    BYTES_TO_T_UINT_8( 0xD8, 0x0E, 0xBD, 0xA2, 0x75, 0xD9, 0x90, 0xDC ),
+};
+static const mbedtls_mpi_uint secp256r1_T_5_Y[] = {
+    BYTES_TO_T_UINT_8( 0x2E, 0xEB, 0xD6, 0x4D, 0x03, 0x52, 0xB5, 0x9F ),
+    BYTES_TO_T_UINT_8( 0xE8, 0xFD, 0x1D, 0xC0, 0xBB, 0x54, 0xD5, 0x50 ),
+    BYTES_TO_T_UINT_8( 0x30, 0x7A, 0x97, 0xF0, 0x77, 0x32, 0xFD, 0x4C ),
+    BYTES_TO_T_UINT_8( 0xC4, 0x74, 0x53, 0x81, 0x32, 0xE2, 0x7C, 0xC8 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_6_X[] = {
+    BYTES_TO_T_UINT_8( 0x6D, 0x40, 0x03, 0x17, 0x5B, 0xC3, 0x4D, 0xCB ),
+    BYTES_TO_T_UINT_8( 0x4C, 0xC5, 0xDA, 0x75, 0xC9, 0xAF, 0xD3, 0x4F ),
+    BYTES_TO_T_UINT_8( 0x78, 0x28, 0xF0, 0x29, 0xEB, 0x21, 0x23, 0x11 ),
+    BYTES_TO_T_UINT_8( 0x5F, 0x22, 0x6B, 0xAD, 0x2F, 0x8D, 0xB1, 0xAF ),
+};
+static const mbedtls_mpi_uint secp256r1_T_6_Y[] = {
+    BYTES_TO_T_UINT_8( 0x67, 0x6A, 0x77, 0xF1, 0x73, 0x82, 0xF5, 0xDD ),
+    BYTES_TO_T_UINT_8( 0x2F, 0x6C, 0xB9, 0xF6, 0x55, 0x97, 0x88, 0x96 ),
+    BYTES_TO_T_UINT_8( 0xFB, 0x8F, 0x20, 0x22, 0x63, 0xD6, 0xA8, 0x31 ),
+    BYTES_TO_T_UINT_8( 0x77, 0x48, 0xCA, 0xFC, 0x10, 0x1C, 0xD8, 0x5E ),
+};
+static const mbedtls_mpi_uint secp256r1_T_7_X[] = {
+    BYTES_TO_T_UINT_8( 0x40, 0xAF, 0x6A, 0x33, 0x1B, 0x1E, 0xC6, 0x2D ),
+    BYTES_TO_T_UINT_8( 0xB7, 0xF5, 0x51, 0x42, 0xBD, 0x87, 0x7E, 0x89 ),
+    BYTES_TO_T_UINT_8( 0x70, 0xB3, 0x11, 0x65, 0x23, 0x20, 0xB3, 0x2F ),
+    BYTES_TO_T_UINT_8( 0x99, 0xF4, 0x41, 0x23, 0xCF, 0xA9, 0x0F, 0x46 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_7_Y[] = {
+    BYTES_TO_T_UINT_8( 0xA7, 0x01, 0xAF, 0xCB, 0x79, 0x3B, 0xE6, 0x03 ),
+    BYTES_TO_T_UINT_8( 0x34, 0x74, 0x15, 0x44, 0x3F, 0x12, 0x7E, 0x93 ),
+    BYTES_TO_T_UINT_8( 0x1A, 0x4A, 0x9E, 0x80, 0x6E, 0x22, 0x59, 0x9D ),
+    BYTES_TO_T_UINT_8( 0x62, 0x5E, 0x77, 0x41, 0x3A, 0xF6, 0xD6, 0x18 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_8_X[] = {
+    BYTES_TO_T_UINT_8( 0xEA, 0x76, 0x64, 0x01, 0xD0, 0xB6, 0xE4, 0xC6 ),
+    BYTES_TO_T_UINT_8( 0x10, 0x25, 0xEC, 0xD4, 0xE5, 0xA7, 0xB9, 0x71 ),
+    BYTES_TO_T_UINT_8( 0xD2, 0x90, 0xE4, 0xCB, 0x1E, 0xB7, 0x75, 0x19 ),
+    BYTES_TO_T_UINT_8( 0x25, 0xCD, 0x2A, 0xB5, 0x2F, 0x47, 0x6B, 0xDF ),
+};
+static const mbedtls_mpi_uint secp256r1_T_8_Y[] = {
+    BYTES_TO_T_UINT_8( 0xEB, 0x55, 0x40, 0x78, 0x16, 0x87, 0x73, 0xF1 ),
+    BYTES_TO_T_UINT_8( 0x9E, 0x39, 0x7D, 0xB8, 0xB3, 0xB0, 0xC7, 0xCC ),
+    BYTES_TO_T_UINT_8( 0x19, 0x11, 0xB5, 0x1B, 0x37, 0x13, 0x9A, 0x3C ),
+    BYTES_TO_T_UINT_8( 0x93, 0xD5, 0x8F, 0xA8, 0xE1, 0x39, 0x26, 0xB4 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_9_X[] = {
+    BYTES_TO_T_UINT_8( 0x97, 0xD6, 0xB4, 0x20, 0x06, 0x42, 0xE9, 0x41 ),
+    BYTES_TO_T_UINT_8( 0xF9, 0x0D, 0xFA, 0x29, 0xD9, 0xD0, 0x0F, 0xA1 ),
+    BYTES_TO_T_UINT_8( 0x38, 0x2C, 0x02, 0x76, 0xA7, 0xB0, 0x1E, 0xF1 ),
+    BYTES_TO_T_UINT_8( 0x63, 0x1C, 0x62, 0xA5, 0xDC, 0x7D, 0xCB, 0xFF ),
+};
+static const mbedtls_mpi_uint secp256r1_T_9_Y[] = {
+    BYTES_TO_T_UINT_8( 0x5A, 0x96, 0x27, 0x09, 0x1B, 0x7B, 0xE3, 0x24 ),
+    BYTES_TO_T_UINT_8( 0x9E, 0x19, 0x2C, 0xBD, 0x02, 0xC1, 0x9F, 0x8D ),
+    BYTES_TO_T_UINT_8( 0x85, 0x3F, 0x7F, 0x90, 0x5E, 0xE7, 0x2D, 0x86 ),
+    BYTES_TO_T_UINT_8( 0x8E, 0x77, 0x9C, 0x5A, 0x29, 0x51, 0x98, 0xD3 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_10_X[] = {
+    BYTES_TO_T_UINT_8( 0xCC, 0xB8, 0x19, 0xF1, 0xE7, 0x08, 0x6A, 0x54 ),
+    BYTES_TO_T_UINT_8( 0x6A, 0x69, 0xFC, 0x8A, 0x23, 0xD5, 0xB7, 0x03 ),
+    BYTES_TO_T_UINT_8( 0xB4, 0x70, 0x9F, 0x45, 0x32, 0x61, 0x89, 0x0A ),
+    BYTES_TO_T_UINT_8( 0x16, 0x91, 0x6A, 0xA8, 0x57, 0x62, 0xA4, 0x57 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_10_Y[] = {
+    BYTES_TO_T_UINT_8( 0x65, 0x4C, 0x31, 0xBB, 0xEF, 0x6F, 0xA5, 0xFA ),
+    BYTES_TO_T_UINT_8( 0x6D, 0x5C, 0x79, 0x74, 0x40, 0x1F, 0xE6, 0xF4 ),
+    BYTES_TO_T_UINT_8( 0xD6, 0x50, 0x78, 0x43, 0x52, 0x56, 0x3C, 0x1A ),
+    BYTES_TO_T_UINT_8( 0x11, 0xEC, 0x21, 0x66, 0x7D, 0x12, 0x4B, 0x7C ),
+};
+static const mbedtls_mpi_uint secp256r1_T_11_X[] = {
+    BYTES_TO_T_UINT_8( 0x5E, 0x81, 0xC8, 0x56, 0x07, 0x03, 0x1E, 0xF4 ),
+    BYTES_TO_T_UINT_8( 0xF1, 0xA2, 0x37, 0x7D, 0xE3, 0x47, 0xF6, 0xBA ),
+    BYTES_TO_T_UINT_8( 0xF5, 0xFB, 0xFA, 0xFE, 0x36, 0xEB, 0x91, 0x77 ),
+    BYTES_TO_T_UINT_8( 0x06, 0xF6, 0xB7, 0x35, 0xFB, 0x62, 0x82, 0x15 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_11_Y[] = {
+    BYTES_TO_T_UINT_8( 0xE5, 0xE9, 0xDC, 0x32, 0x55, 0x22, 0xC3, 0xF6 ),
+    BYTES_TO_T_UINT_8( 0x80, 0x47, 0x1B, 0x36, 0xCE, 0xD4, 0x7C, 0x6C ),
+    BYTES_TO_T_UINT_8( 0x8F, 0x28, 0x85, 0x3F, 0x70, 0x5E, 0xBE, 0xE5 ),
+    BYTES_TO_T_UINT_8( 0x4A, 0x62, 0x8E, 0xC9, 0xA3, 0x1A, 0x28, 0x4C ),
+};
+static const mbedtls_mpi_uint secp256r1_T_12_X[] = {
+    BYTES_TO_T_UINT_8( 0xEF, 0x3D, 0x6A, 0x4D, 0xDD, 0x11, 0x29, 0x5B ),
+    BYTES_TO_T_UINT_8( 0xF1, 0x08, 0x60, 0xB9, 0x7C, 0xD0, 0xED, 0x4B ),
+    BYTES_TO_T_UINT_8( 0x64, 0x7D, 0x6E, 0xE3, 0x6F, 0x8A, 0x74, 0xEE ),
+    BYTES_TO_T_UINT_8( 0xF4, 0x5C, 0xBF, 0x4B, 0x34, 0x99, 0xC4, 0xBF ),
+};
+static const mbedtls_mpi_uint secp256r1_T_12_Y[] = {
+    BYTES_TO_T_UINT_8( 0x0F, 0x75, 0x74, 0x8E, 0x2D, 0xF6, 0xC6, 0x55 ),
+    BYTES_TO_T_UINT_8( 0x02, 0x99, 0x91, 0x48, 0x87, 0x9F, 0x63, 0x22 ),
+    BYTES_TO_T_UINT_8( 0x8F, 0x24, 0x8A, 0x95, 0x94, 0xAA, 0x01, 0xFA ),
+    BYTES_TO_T_UINT_8( 0x40, 0xAA, 0x51, 0xED, 0x8A, 0xAE, 0x43, 0x27 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_13_X[] = {
+    BYTES_TO_T_UINT_8( 0x15, 0x78, 0xEB, 0x86, 0x21, 0xA8, 0xDD, 0x9C ),
+    BYTES_TO_T_UINT_8( 0x65, 0x32, 0x41, 0xCE, 0x12, 0x36, 0x00, 0x8C ),
+    BYTES_TO_T_UINT_8( 0xF5, 0x77, 0xB5, 0x91, 0xAB, 0x1F, 0xCE, 0x8B ),
+    BYTES_TO_T_UINT_8( 0x0C, 0x73, 0x8F, 0x48, 0xFF, 0x29, 0x3F, 0x0F ),
+};
+static const mbedtls_mpi_uint secp256r1_T_13_Y[] = {
+    BYTES_TO_T_UINT_8( 0x55, 0x0D, 0x96, 0xE6, 0x63, 0x80, 0xB0, 0xEB ),
+    BYTES_TO_T_UINT_8( 0x67, 0xF4, 0xCB, 0xAE, 0xE2, 0x99, 0x96, 0x1A ),
+    BYTES_TO_T_UINT_8( 0x1B, 0x76, 0xE5, 0x4C, 0xA4, 0x64, 0x15, 0x6B ),
+    BYTES_TO_T_UINT_8( 0x96, 0x29, 0x38, 0x81, 0xA5, 0x0E, 0xF0, 0x08 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_14_X[] = {
+    BYTES_TO_T_UINT_8( 0x21, 0x4A, 0x51, 0x70, 0x39, 0xFF, 0x17, 0x0D ),
+    BYTES_TO_T_UINT_8( 0xEE, 0x80, 0xDD, 0xDA, 0xBA, 0xB5, 0xA7, 0xD2 ),
+    BYTES_TO_T_UINT_8( 0xC4, 0xC8, 0x26, 0x81, 0xC3, 0x33, 0x1E, 0x94 ),
+    BYTES_TO_T_UINT_8( 0xDE, 0xC1, 0x57, 0x1D, 0xD0, 0x56, 0xE1, 0xB9 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_14_Y[] = {
+    BYTES_TO_T_UINT_8( 0xAD, 0x05, 0x81, 0xEA, 0x0D, 0x50, 0x0D, 0x22 ),
+    BYTES_TO_T_UINT_8( 0xAE, 0xF3, 0x02, 0x02, 0x62, 0xA4, 0x2A, 0x6A ),
+    BYTES_TO_T_UINT_8( 0x56, 0x63, 0xC9, 0x3D, 0xAB, 0x56, 0x00, 0x45 ),
+    BYTES_TO_T_UINT_8( 0xC3, 0x42, 0x21, 0x45, 0xAA, 0xB6, 0x6A, 0x50 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_15_X[] = {
+    BYTES_TO_T_UINT_8( 0xCD, 0x31, 0x51, 0xC0, 0x5B, 0x73, 0x97, 0xF1 ),
+    BYTES_TO_T_UINT_8( 0x67, 0xB5, 0xBE, 0x22, 0x68, 0x07, 0x65, 0x05 ),
+    BYTES_TO_T_UINT_8( 0x1F, 0x5B, 0xF5, 0xF7, 0x89, 0xB1, 0xF2, 0xDB ),
+    BYTES_TO_T_UINT_8( 0x14, 0x26, 0x2C, 0x13, 0x82, 0x4C, 0x14, 0xAA ),
+};
+static const mbedtls_mpi_uint secp256r1_T_15_Y[] = {
+    BYTES_TO_T_UINT_8( 0x51, 0x22, 0x82, 0xB3, 0x14, 0xBE, 0x1C, 0xF4 ),
+    BYTES_TO_T_UINT_8( 0xBE, 0xAF, 0xD0, 0xFF, 0xB2, 0x72, 0xCE, 0xB1 ),
+    BYTES_TO_T_UINT_8( 0xFA, 0x43, 0x47, 0x84, 0x18, 0x4D, 0xA1, 0x01 ),
+    BYTES_TO_T_UINT_8( 0xB8, 0x39, 0x37, 0x92, 0xE3, 0x9F, 0xD8, 0xC1 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_16_X[] = {
+    BYTES_TO_T_UINT_8( 0x80, 0x5B, 0x3F, 0x5F, 0x5C, 0x6A, 0x41, 0x12 ),
+    BYTES_TO_T_UINT_8( 0x22, 0x24, 0x52, 0xDA, 0xDB, 0x03, 0xE9, 0x58 ),
+    BYTES_TO_T_UINT_8( 0x7E, 0x86, 0x91, 0x42, 0xF1, 0x80, 0xCC, 0x18 ),
+    BYTES_TO_T_UINT_8( 0x2B, 0x2C, 0x15, 0x7A, 0xF8, 0x5C, 0x03, 0xB2 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_16_Y[] = {
+    BYTES_TO_T_UINT_8( 0xDE, 0x0E, 0xC8, 0x95, 0x91, 0x56, 0x12, 0x71 ),
+    BYTES_TO_T_UINT_8( 0xB0, 0xC5, 0x97, 0xAF, 0x68, 0x25, 0xE0, 0xBF ),
+    BYTES_TO_T_UINT_8( 0x93, 0xE4, 0x14, 0x8A, 0xC5, 0x1D, 0x3E, 0x60 ),
+    BYTES_TO_T_UINT_8( 0xDE, 0x80, 0x96, 0x74, 0x9C, 0x35, 0x2F, 0xF1 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_17_X[] = {
+    BYTES_TO_T_UINT_8( 0x0C, 0x7B, 0xA7, 0xFE, 0x1B, 0x9D, 0x42, 0x40 ),
+    BYTES_TO_T_UINT_8( 0x31, 0x9A, 0x5E, 0x59, 0xDC, 0xA4, 0x51, 0x46 ),
+    BYTES_TO_T_UINT_8( 0x3A, 0x69, 0x12, 0xE7, 0xB1, 0xAA, 0x00, 0x89 ),
+    BYTES_TO_T_UINT_8( 0x2D, 0x61, 0xBF, 0x84, 0x67, 0x77, 0xEA, 0x90 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_17_Y[] = {
+    BYTES_TO_T_UINT_8( 0xB6, 0xF2, 0x02, 0x0D, 0x25, 0x04, 0xD1, 0xBD ),
+    BYTES_TO_T_UINT_8( 0x4F, 0x59, 0x4D, 0xFB, 0xCC, 0x3B, 0x58, 0xF5 ),
+    BYTES_TO_T_UINT_8( 0xA1, 0xB6, 0xA7, 0x5B, 0x62, 0x44, 0x75, 0x75 ),
+    BYTES_TO_T_UINT_8( 0xF4, 0x86, 0x1E, 0x10, 0xD3, 0x21, 0xA3, 0xD1 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_18_X[] = {
+    BYTES_TO_T_UINT_8( 0x69, 0xA0, 0x2D, 0xE6, 0x6C, 0xB2, 0x90, 0x68 ),
+    BYTES_TO_T_UINT_8( 0x65, 0x62, 0x58, 0x7C, 0x19, 0x23, 0x70, 0xA5 ),
+    BYTES_TO_T_UINT_8( 0xAB, 0x72, 0x56, 0x86, 0xBF, 0x19, 0x4E, 0xE6 ),
+    BYTES_TO_T_UINT_8( 0x93, 0x98, 0x7D, 0xA0, 0xF5, 0x03, 0x65, 0xA6 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_18_Y[] = {
+    BYTES_TO_T_UINT_8( 0x43, 0x47, 0xFE, 0x21, 0xC0, 0xB7, 0xDE, 0xE4 ),
+    BYTES_TO_T_UINT_8( 0xBE, 0x00, 0x71, 0x7D, 0x7D, 0x84, 0xAE, 0x3B ),
+    BYTES_TO_T_UINT_8( 0x29, 0x1D, 0x7B, 0xE1, 0xA7, 0xFC, 0x69, 0x17 ),
+    BYTES_TO_T_UINT_8( 0x60, 0xFC, 0x0A, 0x32, 0xEC, 0x60, 0xBA, 0xAD ),
+};
+static const mbedtls_mpi_uint secp256r1_T_19_X[] = {
+    BYTES_TO_T_UINT_8( 0x58, 0x81, 0xE4, 0xC4, 0x14, 0xD6, 0xC9, 0xA3 ),
+    BYTES_TO_T_UINT_8( 0x08, 0xC5, 0x8F, 0xAE, 0x98, 0x4A, 0x6B, 0xB2 ),
+    BYTES_TO_T_UINT_8( 0x18, 0x8E, 0xB6, 0x38, 0xE0, 0x8B, 0xEF, 0x44 ),
+    BYTES_TO_T_UINT_8( 0xCD, 0x1F, 0x27, 0xDB, 0x96, 0xF5, 0x9C, 0xBE ),
+};
+static const mbedtls_mpi_uint secp256r1_T_19_Y[] = {
+    BYTES_TO_T_UINT_8( 0xAD, 0x95, 0x6F, 0x8E, 0x3E, 0x65, 0x7B, 0x73 ),
+    BYTES_TO_T_UINT_8( 0x0A, 0x4D, 0x9E, 0x9B, 0xFF, 0xE6, 0xDB, 0x73 ),
+    BYTES_TO_T_UINT_8( 0x59, 0x9F, 0x13, 0xA4, 0x8C, 0x2A, 0x77, 0x4B ),
+    BYTES_TO_T_UINT_8( 0x8A, 0x7E, 0xC6, 0x66, 0xE5, 0x35, 0xF3, 0xA1 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_20_X[] = {
+    BYTES_TO_T_UINT_8( 0x52, 0xF1, 0x7C, 0xF7, 0xFB, 0x61, 0xB1, 0xC0 ),
+    BYTES_TO_T_UINT_8( 0x43, 0x00, 0xE3, 0x8C, 0xED, 0x4F, 0x3C, 0x24 ),
+    BYTES_TO_T_UINT_8( 0xDF, 0x20, 0x0E, 0x05, 0xD0, 0xA2, 0xB4, 0xB1 ),
+    BYTES_TO_T_UINT_8( 0xAE, 0x99, 0x49, 0xC3, 0x86, 0xA2, 0x61, 0x5A ),
+};
+static const mbedtls_mpi_uint secp256r1_T_20_Y[] = {
+    BYTES_TO_T_UINT_8( 0xB7, 0x4E, 0x21, 0x70, 0x68, 0xAF, 0x7B, 0x8C ),
+    BYTES_TO_T_UINT_8( 0xFE, 0x61, 0xC2, 0xF2, 0x7D, 0xCA, 0x5B, 0x97 ),
+    BYTES_TO_T_UINT_8( 0xE8, 0x1A, 0xD9, 0x1E, 0x31, 0xDF, 0xC6, 0x03 ),
+    BYTES_TO_T_UINT_8( 0x38, 0x0D, 0x38, 0xA1, 0xAD, 0xAA, 0xCF, 0xE8 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_21_X[] = {
+    BYTES_TO_T_UINT_8( 0xDD, 0x28, 0x6D, 0x96, 0x78, 0x31, 0x9E, 0xC7 ),
+    BYTES_TO_T_UINT_8( 0xC1, 0xA2, 0xF8, 0x89, 0x86, 0x86, 0xBA, 0x67 ),
+    BYTES_TO_T_UINT_8( 0x42, 0x8D, 0xCF, 0x4A, 0x6D, 0x9C, 0x1F, 0xAF ),
+    BYTES_TO_T_UINT_8( 0x7D, 0x7F, 0x84, 0xE0, 0x73, 0x42, 0x2B, 0x2D ),
+};
+static const mbedtls_mpi_uint secp256r1_T_21_Y[] = {
+    BYTES_TO_T_UINT_8( 0xEC, 0x0C, 0x13, 0x69, 0x90, 0x1A, 0x9E, 0x1D ),
+    BYTES_TO_T_UINT_8( 0xB5, 0xE7, 0x83, 0x93, 0xFD, 0x10, 0xCB, 0x95 ),
+    BYTES_TO_T_UINT_8( 0xAE, 0x71, 0xCC, 0x44, 0x26, 0x8A, 0x43, 0x73 ),
+    BYTES_TO_T_UINT_8( 0x49, 0xEA, 0xE4, 0x1E, 0x10, 0xEB, 0xEA, 0x37 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_22_X[] = {
+    BYTES_TO_T_UINT_8( 0xDE, 0x37, 0x4A, 0xD8, 0xCB, 0xB5, 0x12, 0x1C ),
+    BYTES_TO_T_UINT_8( 0x1A, 0xEA, 0xB1, 0xC7, 0xB4, 0x6D, 0xD6, 0x56 ),
+    BYTES_TO_T_UINT_8( 0x9A, 0x1E, 0xE3, 0x2C, 0x20, 0xE4, 0x2B, 0x85 ),
+    BYTES_TO_T_UINT_8( 0x48, 0xAF, 0x0F, 0xE4, 0x2D, 0x9C, 0xBE, 0x17 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_22_Y[] = {
+    BYTES_TO_T_UINT_8( 0x97, 0x87, 0xCC, 0x38, 0xCB, 0x3C, 0x5B, 0x73 ),
+    BYTES_TO_T_UINT_8( 0x3E, 0x09, 0xB1, 0x34, 0x80, 0x9D, 0x8D, 0x1F ),
+    BYTES_TO_T_UINT_8( 0xC0, 0x81, 0x5B, 0xE7, 0x86, 0x6E, 0xCC, 0xD8 ),
+    BYTES_TO_T_UINT_8( 0x97, 0xE6, 0xDB, 0x3F, 0x94, 0xBF, 0x14, 0x69 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_23_X[] = {
+    BYTES_TO_T_UINT_8( 0x35, 0x6F, 0xB1, 0x00, 0x33, 0x4D, 0xB4, 0x54 ),
+    BYTES_TO_T_UINT_8( 0x07, 0x57, 0x2D, 0x00, 0xF3, 0x8E, 0x98, 0x59 ),
+    BYTES_TO_T_UINT_8( 0x94, 0x4F, 0x49, 0xD0, 0xEB, 0xE1, 0x6F, 0x25 ),
+    BYTES_TO_T_UINT_8( 0xE4, 0x0D, 0x71, 0x7F, 0x69, 0x41, 0xF8, 0xAE ),
+};
+static const mbedtls_mpi_uint secp256r1_T_23_Y[] = {
+    BYTES_TO_T_UINT_8( 0x04, 0x96, 0xD4, 0x8B, 0x1F, 0xFB, 0x38, 0xCA ),
+    BYTES_TO_T_UINT_8( 0x5C, 0xB1, 0xA0, 0xBF, 0xAE, 0xDA, 0xC9, 0xAE ),
+    BYTES_TO_T_UINT_8( 0xDD, 0xF6, 0x2C, 0x64, 0x5E, 0x36, 0x51, 0x15 ),
+    BYTES_TO_T_UINT_8( 0xFF, 0x8F, 0x0E, 0x16, 0xFA, 0xB0, 0xB8, 0x75 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_24_X[] = {
+    BYTES_TO_T_UINT_8( 0xB9, 0x9C, 0xAB, 0xED, 0x13, 0xD1, 0x33, 0x60 ),
+    BYTES_TO_T_UINT_8( 0xEE, 0x45, 0x9D, 0xE6, 0xA3, 0x7B, 0xF8, 0x1D ),
+    BYTES_TO_T_UINT_8( 0x03, 0x5A, 0xD6, 0xE4, 0x36, 0x62, 0x43, 0x93 ),
+    BYTES_TO_T_UINT_8( 0x08, 0xA5, 0x98, 0x3F, 0xF9, 0xF6, 0x93, 0x58 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_24_Y[] = {
+    BYTES_TO_T_UINT_8( 0xAB, 0x4F, 0xD5, 0xAA, 0x15, 0x2E, 0x83, 0xB3 ),
+    BYTES_TO_T_UINT_8( 0x5E, 0x36, 0xC7, 0x6B, 0x0D, 0xFF, 0x77, 0x32 ),
+    BYTES_TO_T_UINT_8( 0xB8, 0x4F, 0x0C, 0x20, 0x18, 0x11, 0x30, 0xE8 ),
+    BYTES_TO_T_UINT_8( 0x4D, 0x38, 0xE9, 0xD4, 0xBC, 0x71, 0xE4, 0x26 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_25_X[] = {
+    BYTES_TO_T_UINT_8( 0xD8, 0x27, 0x24, 0xC5, 0xA4, 0xC5, 0x76, 0x32 ),
+    BYTES_TO_T_UINT_8( 0x64, 0x4B, 0xA3, 0xF5, 0x43, 0x82, 0x95, 0x66 ),
+    BYTES_TO_T_UINT_8( 0x92, 0x0D, 0x6E, 0xF3, 0x98, 0x67, 0x16, 0x04 ),
+    BYTES_TO_T_UINT_8( 0x3F, 0xE6, 0xE9, 0xC6, 0x27, 0x39, 0xE3, 0x43 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_25_Y[] = {
+    BYTES_TO_T_UINT_8( 0x2B, 0x8D, 0xCA, 0xF0, 0x76, 0xED, 0x9A, 0x89 ),
+    BYTES_TO_T_UINT_8( 0xD8, 0x0D, 0xF5, 0x0A, 0xDE, 0x9C, 0xB8, 0x43 ),
+    BYTES_TO_T_UINT_8( 0x3B, 0xE1, 0x51, 0x59, 0x1E, 0xA2, 0x5E, 0x80 ),
+    BYTES_TO_T_UINT_8( 0x43, 0x30, 0x41, 0x28, 0xA4, 0xDA, 0x10, 0xE2 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_26_X[] = {
+    BYTES_TO_T_UINT_8( 0x5B, 0x03, 0x58, 0x07, 0x65, 0xA1, 0x46, 0xCE ),
+    BYTES_TO_T_UINT_8( 0xC9, 0xA0, 0x70, 0xE0, 0xAD, 0xF1, 0x3D, 0xB3 ),
+    BYTES_TO_T_UINT_8( 0xC9, 0x34, 0x69, 0x68, 0x38, 0xFB, 0x01, 0xBF ),
+    BYTES_TO_T_UINT_8( 0xD0, 0x6E, 0xF1, 0xF0, 0x57, 0x62, 0xBA, 0x1C ),
+};
+static const mbedtls_mpi_uint secp256r1_T_26_Y[] = {
+    BYTES_TO_T_UINT_8( 0x9C, 0x40, 0x93, 0xEE, 0xB6, 0xA9, 0x38, 0xE5 ),
+    BYTES_TO_T_UINT_8( 0xDA, 0x38, 0x6B, 0x4A, 0xA1, 0x29, 0x24, 0xD8 ),
+    BYTES_TO_T_UINT_8( 0xB1, 0x15, 0xC2, 0xA5, 0x0D, 0x77, 0x88, 0x14 ),
+    BYTES_TO_T_UINT_8( 0x58, 0x76, 0x1D, 0x89, 0x8E, 0x1F, 0xDE, 0x4A ),
+};
+static const mbedtls_mpi_uint secp256r1_T_27_X[] = {
+    BYTES_TO_T_UINT_8( 0x3F, 0xE6, 0xAD, 0x27, 0x4B, 0x2B, 0x70, 0xFE ),
+    BYTES_TO_T_UINT_8( 0x3A, 0x67, 0x05, 0xA1, 0x33, 0x1A, 0xF1, 0x5D ),
+    BYTES_TO_T_UINT_8( 0xCE, 0xB9, 0x62, 0xA3, 0x80, 0xCB, 0x33, 0x0D ),
+    BYTES_TO_T_UINT_8( 0x09, 0xB2, 0x5B, 0x85, 0xF5, 0x42, 0xBB, 0xA7 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_27_Y[] = {
+    BYTES_TO_T_UINT_8( 0x75, 0xE5, 0x5F, 0xC9, 0x96, 0x60, 0xCC, 0xFD ),
+    BYTES_TO_T_UINT_8( 0xC6, 0xDE, 0x51, 0x23, 0xD7, 0x08, 0x0E, 0xFF ),
+    BYTES_TO_T_UINT_8( 0x28, 0x5B, 0x6A, 0xBB, 0xF5, 0x3F, 0x32, 0xA3 ),
+    BYTES_TO_T_UINT_8( 0xAB, 0xA2, 0xF7, 0x89, 0xAE, 0x2D, 0xAA, 0x2C ),
+};
+static const mbedtls_mpi_uint secp256r1_T_28_X[] = {
+    BYTES_TO_T_UINT_8( 0x49, 0xEB, 0xA7, 0x2D, 0x76, 0xD6, 0x96, 0x20 ),
+    BYTES_TO_T_UINT_8( 0x41, 0x5E, 0x77, 0xFB, 0x8E, 0x76, 0x04, 0x6E ),
+    BYTES_TO_T_UINT_8( 0x6C, 0xF7, 0x24, 0xAF, 0x3D, 0x9C, 0x34, 0xC3 ),
+    BYTES_TO_T_UINT_8( 0xF6, 0x90, 0x0C, 0xDE, 0xCA, 0x6C, 0xDB, 0xE6 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_28_Y[] = {
+    BYTES_TO_T_UINT_8( 0x87, 0xFD, 0x16, 0xA4, 0xF5, 0x01, 0xAA, 0x98 ),
+    BYTES_TO_T_UINT_8( 0x27, 0xC4, 0x1E, 0x78, 0x0B, 0x27, 0xC3, 0x84 ),
+    BYTES_TO_T_UINT_8( 0xB2, 0x34, 0x10, 0x02, 0x04, 0x0F, 0x68, 0x37 ),
+    BYTES_TO_T_UINT_8( 0x35, 0xF7, 0x4B, 0x65, 0x3C, 0xFE, 0x90, 0xEB ),
+};
+static const mbedtls_mpi_uint secp256r1_T_29_X[] = {
+    BYTES_TO_T_UINT_8( 0x76, 0x19, 0x57, 0xB3, 0x16, 0xBF, 0x35, 0x8E ),
+    BYTES_TO_T_UINT_8( 0xE7, 0x64, 0x68, 0x34, 0x63, 0x0C, 0xEB, 0xE2 ),
+    BYTES_TO_T_UINT_8( 0x7F, 0x6C, 0x9B, 0x7E, 0xE0, 0x57, 0x7B, 0x2B ),
+    BYTES_TO_T_UINT_8( 0x98, 0x5A, 0xB3, 0x70, 0x6F, 0xCF, 0x57, 0x31 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_29_Y[] = {
+    BYTES_TO_T_UINT_8( 0xA5, 0x9E, 0xC4, 0x5A, 0x14, 0x4C, 0xC2, 0xFE ),
+    BYTES_TO_T_UINT_8( 0xAE, 0x32, 0x1A, 0x6B, 0x90, 0x56, 0x0C, 0xC2 ),
+    BYTES_TO_T_UINT_8( 0x35, 0xA3, 0x5F, 0x34, 0x4E, 0x7B, 0xEF, 0xEA ),
+    BYTES_TO_T_UINT_8( 0x5F, 0x47, 0x77, 0x40, 0x5D, 0x65, 0xC9, 0xB4 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_30_X[] = {
+    BYTES_TO_T_UINT_8( 0xB9, 0x66, 0xF8, 0xFC, 0xFE, 0xE3, 0xF4, 0xF3 ),
+    BYTES_TO_T_UINT_8( 0xD5, 0x0A, 0x8B, 0xE1, 0x07, 0x08, 0x2A, 0x15 ),
+    BYTES_TO_T_UINT_8( 0x7B, 0x2E, 0x9B, 0x1B, 0x06, 0xC7, 0xC4, 0x2E ),
+    BYTES_TO_T_UINT_8( 0x6F, 0x00, 0xDD, 0xDA, 0x2B, 0xE9, 0xD7, 0x41 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_30_Y[] = {
+    BYTES_TO_T_UINT_8( 0xF7, 0x6E, 0x4B, 0x1D, 0x79, 0x8A, 0x0A, 0xFF ),
+    BYTES_TO_T_UINT_8( 0x47, 0x2F, 0xAA, 0xB2, 0xFF, 0x4D, 0x34, 0x02 ),
+    BYTES_TO_T_UINT_8( 0x81, 0x06, 0x7A, 0x35, 0x04, 0xD7, 0x26, 0x17 ),
+    BYTES_TO_T_UINT_8( 0xF4, 0x85, 0xBC, 0xC1, 0x77, 0xBB, 0xE6, 0x4C ),
+};
+static const mbedtls_mpi_uint secp256r1_T_31_X[] = {
+    BYTES_TO_T_UINT_8( 0xEF, 0x2B, 0xCC, 0xAF, 0xF4, 0x37, 0xE4, 0xB9 ),
+    BYTES_TO_T_UINT_8( 0x53, 0x2B, 0xDA, 0x3A, 0xD6, 0xB2, 0x1F, 0x4F ),
+    BYTES_TO_T_UINT_8( 0x9A, 0x0C, 0x58, 0xBB, 0x2D, 0xE1, 0xC0, 0xE6 ),
+    BYTES_TO_T_UINT_8( 0x6D, 0x54, 0xC7, 0x33, 0x34, 0x37, 0x18, 0x25 ),
+};
+static const mbedtls_mpi_uint secp256r1_T_31_Y[] = {
+    BYTES_TO_T_UINT_8( 0xB9, 0x2F, 0xD9, 0xBF, 0x0F, 0xD9, 0x12, 0xAB ),
+    BYTES_TO_T_UINT_8( 0x46, 0xAE, 0x85, 0xA1, 0xB3, 0xB9, 0xB9, 0x2C ),
+    BYTES_TO_T_UINT_8( 0x9F, 0xF4, 0xE6, 0x9C, 0x7E, 0x7A, 0x0C, 0x2A ),
+    BYTES_TO_T_UINT_8( 0xF2, 0x21, 0x8F, 0xB4, 0x7F, 0x30, 0x1F, 0x53 ),
+};
+static const mbedtls_ecp_point secp256r1_T[32] = {
+    ECP_ROM_POINT( secp256r1_T_0_X, secp256r1_T_0_Y ),
+    ECP_ROM_POINT( secp256r1_T_1_X, secp256r1_T_1_Y ),
+    ECP_ROM_POINT( secp256r1_T_2_X, secp256r1_T_2_Y ),
+    ECP_ROM_POINT( secp256r1_T_3_X, secp256r1_T_3_Y ),
+    ECP_ROM_POINT( secp256r1_T_4_X, secp256r1_T_4_Y ),
+    ECP_ROM_POINT( secp256r1_T_5_X, secp256r1_T_5_Y ),
+    ECP_ROM_POINT( secp256r1_T_6_X, secp256r1_T_6_Y ),
+    ECP_ROM_POINT( secp256r1_T_7_X, secp256r1_T_7_Y ),
+    ECP_ROM_POINT( secp256r1_T_8_X, secp256r1_T_8_Y ),
+    ECP_ROM_POINT( secp256r1_T_9_X, secp256r1_T_9_Y ),
+    ECP_ROM_POINT( secp256r1_T_10_X, secp256r1_T_10_Y ),
+    ECP_ROM_POINT( secp256r1_T_11_X, secp256r1_T_11_Y ),
+    ECP_ROM_POINT( secp256r1_T_12_X, secp256r1_T_12_Y ),
+    ECP_ROM_POINT( secp256r1_T_13_X, secp256r1_T_13_Y ),
+    ECP_ROM_POINT( secp256r1_T_14_X, secp256r1_T_14_Y ),
+    ECP_ROM_POINT( secp256r1_T_15_X, secp256r1_T_15_Y ),
+    ECP_ROM_POINT( secp256r1_T_16_X, secp256r1_T_16_Y ),
+    ECP_ROM_POINT( secp256r1_T_17_X, secp256r1_T_17_Y ),
+    ECP_ROM_POINT( secp256r1_T_18_X, secp256r1_T_18_Y ),
+    ECP_ROM_POINT( secp256r1_T_19_X, secp256r1_T_19_Y ),
+    ECP_ROM_POINT( secp256r1_T_20_X, secp256r1_T_20_Y ),
+    ECP_ROM_POINT( secp256r1_T_21_X, secp256r1_T_21_Y ),
+    ECP_ROM_POINT( secp256r1_T_22_X, secp256r1_T_22_Y ),
+    ECP_ROM_POINT( secp256r1_T_23_X, secp256r1_T_23_Y ),
+    ECP_ROM_POINT( secp256r1_T_24_X, secp256r1_T_24_Y ),
+    ECP_ROM_POINT( secp256r1_T_25_X, secp256r1_T_25_Y ),
+    ECP_ROM_POINT( secp256r1_T_26_X, secp256r1_T_26_Y ),
+    ECP_ROM_POINT( secp256r1_T_27_X, secp256r1_T_27_Y ),
+    ECP_ROM_POINT( secp256r1_T_28_X, secp256r1_T_28_Y ),
+    ECP_ROM_POINT( secp256r1_T_29_X, secp256r1_T_29_Y ),
+    ECP_ROM_POINT( secp256r1_T_30_X, secp256r1_T_30_Y ),
+    ECP_ROM_POINT( secp256r1_T_31_X, secp256r1_T_31_Y ),
+};
+#endif /* MBEDTLS_ECP_DP_SECP256R1_ENABLED */
+
+/*
+ * Comb table for the generator of grp, NULL if there is none in ROM
+ */
+const mbedtls_ecp_point *mbedtls_internal_ecp_comb_rom( const mbedtls_ecp_group *grp,
+                                                       unsigned char *w )
+{
+    switch( grp->id )
+    {
+#if defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+        case MBEDTLS_ECP_DP_SECP256R1:
+            *w = 6;
+            return( secp256r1_T );
+#endif
+        default:
+            return( NULL );
+    }
+}
+
+#endif /* !MBEDTLS_ECP_ALT */
+
+#endif /* MBEDTLS_ECP_C && MBEDTLS_ECP_COMB_ROM_TABLES */
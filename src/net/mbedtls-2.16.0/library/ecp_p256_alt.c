@@ -0,0 +1,752 @@
+/*
+ *  Elliptic curve point arithmetic for secp256r1 on 32-bit words
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+/*
+ * Implementation of the MBEDTLS_ECP_INTERNAL_ALT hooks of ecp.c for
+ * secp256r1. The formulas and the special cases are those of ecp.c, so the
+ * results are the same, but field elements are eight 32-bit words on the
+ * stack instead of MPIs on the heap:
+ *
+ * - multiplication is operand scanning, where each step a * b + t + c
+ *   fits in 64 bits, one UMAAL on Armv7E-M (Cortex-M4);
+ * - reduction is the NIST fast reduction of FIPS 186-4 D.2.3 with a signed
+ *   carry, followed by a masked subtraction of p;
+ * - addition, subtraction and inversion (Fermat, fixed addition chain)
+ *   don't branch on the operands either.
+ *
+ * Only the point operations are replaced, scalar recoding and the constant
+ * time table selection of the comb method stay in ecp.c.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_ECP_C) && defined(MBEDTLS_ECP_INTERNAL_ALT) && \
+    defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+
+#include "mbedtls/ecp.h"
+
+#define ECP_SHORTWEIERSTRASS
+#include "mbedtls/ecp_internal.h"
+#include "mbedtls/platform_util.h"
+
+#include <string.h>
+
+#if defined(MBEDTLS_PLATFORM_C)
+#include "mbedtls/platform.h"
+#else
+#include <stdlib.h>
+#define mbedtls_calloc    calloc
+#define mbedtls_free       free
+#endif
+
+#if !defined(MBEDTLS_ECP_ALT)
+
+#define P256_WORDS          8
+
+/* 32-bit words per MPI limb */
+#define P256_WPL            ( sizeof( mbedtls_mpi_uint ) / 4 )
+
+typedef uint32_t p256_fe[P256_WORDS];
+
+static const p256_fe p256_p = {
+    0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000000,
+    0x00000000, 0x00000000, 0x00000001, 0xFFFFFFFF,
+};
+
+/*
+ * (hi, lo) = a * b + hi + lo, which cannot overflow
+ */
+#if defined(__GNUC__) && defined(__arm__) && \
+    defined(__ARM_FEATURE_DSP) && ( __ARM_FEATURE_DSP == 1 )
+#define P256_UMAAL( lo, hi, a, b )                              \
+    __asm__( "umaal %0, %1, %2, %3"                             \
+             : "+r" ( lo ), "+r" ( hi ) : "r" ( a ), "r" ( b ) )
+#else
+#define P256_UMAAL( lo, hi, a, b )                              \
+    do {                                                        \
+        uint64_t t_ = (uint64_t) ( a ) * ( b ) + ( lo ) + ( hi ); \
+        ( lo ) = (uint32_t) t_;                                 \
+        ( hi ) = (uint32_t) ( t_ >> 32 );                       \
+    } while( 0 )
+#endif
+
+/*
+ * r = a - b, returns the borrow (0 or 1)
+ */
+static uint32_t p256_sub_words( p256_fe r, const p256_fe a, const p256_fe b )
+{
+    int64_t t = 0;
+    int i;
+
+    for( i = 0; i < P256_WORDS; i++ )
+    {
+        t += (int64_t) a[i] - b[i];
+        r[i] = (uint32_t) t;
+        t >>= 32;
+    }
+
+    return( (uint32_t) -t );
+}
+
+/*
+ * r = a + (b & mask), returns the carry (0 or 1)
+ */
+static uint32_t p256_add_masked( p256_fe r, const p256_fe a, const p256_fe b,
+                                 uint32_t mask )
+{
+    uint64_t t = 0;
+    int i;
+
+    for( i = 0; i < P256_WORDS; i++ )
+    {
+        t += (uint64_t) a[i] + ( b[i] & mask );
+        r[i] = (uint32_t) t;
+        t >>= 32;
+    }
+
+    return( (uint32_t) t );
+}
+
+/*
+ * Subtract p from a + carry * 2^256 if that is >= p, where a + carry * 2^256
+ * is less than 2p
+ */
+static void p256_reduce_once( p256_fe a, uint32_t carry )
+{
+    p256_fe t;
+    uint32_t borrow, mask;
+    int i;
+
+    borrow = p256_sub_words( t, a, p256_p );
+
+    /* keep t unless the subtraction borrowed past the carry */
+    mask = 0 - ( borrow & ( carry ^ 1 ) );
+    for( i = 0; i < P256_WORDS; i++ )
+        a[i] = ( a[i] & mask ) | ( t[i] & ~mask );
+}
+
+static void p256_add( p256_fe r, const p256_fe a, const p256_fe b )
+{
+    p256_reduce_once( r, p256_add_masked( r, a, b, 0xFFFFFFFF ) );
+}
+
+static void p256_sub( p256_fe r, const p256_fe a, const p256_fe b )
+{
+    uint32_t borrow = p256_sub_words( r, a, b );
+
+    p256_add_masked( r, r, p256_p, 0 - borrow );
+}
+
+/*
+ * r = c * 2^256 + r mod p, using 2^256 = 2^224 - 2^192 - 2^96 + 1 mod p,
+ * returns the new carry
+ */
+static int32_t p256_fold( p256_fe r, int32_t c )
+{
+    int64_t t = 0;
+
+    t += (int64_t) r[0] + c;  r[0] = (uint32_t) t; t >>= 32;
+    t += (int64_t) r[1];      r[1] = (uint32_t) t; t >>= 32;
+    t += (int64_t) r[2];      r[2] = (uint32_t) t; t >>= 32;
+    t += (int64_t) r[3] - c;  r[3] = (uint32_t) t; t >>= 32;
+    t += (int64_t) r[4];      r[4] = (uint32_t) t; t >>= 32;
+    t += (int64_t) r[5];      r[5] = (uint32_t) t; t >>= 32;
+    t += (int64_t) r[6] - c;  r[6] = (uint32_t) t; t >>= 32;
+    t += (int64_t) r[7] + c;  r[7] = (uint32_t) t; t >>= 32;
+
+    return( (int32_t) t );
+}
+
+/*
+ * r = A mod p for a 512-bit A (FIPS 186-4 D.2.3):
+ * r = T + 2 S1 + 2 S2 + S3 + S4 - D1 - D2 - D3 - D4
+ */
+static void p256_reduce( p256_fe r, const uint32_t A[2 * P256_WORDS] )
+{
+    int64_t t = 0;
+    int32_t c;
+
+#define P256_WORD( i, expr )    \
+    t += expr; r[i] = (uint32_t) t; t >>= 32
+
+    P256_WORD( 0, (int64_t) A[0] + A[8] + A[9] - A[11] - A[12] - A[13] - A[14] );
+    P256_WORD( 1, (int64_t) A[1] + A[9] + A[10] - A[12] - A[13] - A[14] - A[15] );
+    P256_WORD( 2, (int64_t) A[2] + A[10] + A[11] - A[13] - A[14] - A[15] );
+    P256_WORD( 3, (int64_t) A[3] + 2 * (int64_t) A[11] + 2 * (int64_t) A[12] + A[13]
+                  - A[15] - A[8] - A[9] );
+    P256_WORD( 4, (int64_t) A[4] + 2 * (int64_t) A[12] + 2 * (int64_t) A[13] + A[14]
+                  - A[9] - A[10] );
+    P256_WORD( 5, (int64_t) A[5] + 2 * (int64_t) A[13] + 2 * (int64_t) A[14] + A[15]
+                  - A[10] - A[11] );
+    P256_WORD( 6, (int64_t) A[6] + 3 * (int64_t) A[14] + 2 * (int64_t) A[15] + A[13]
+                  - A[8] - A[9] );
+    P256_WORD( 7, (int64_t) A[7] + 3 * (int64_t) A[15] + A[8]
+                  - A[10] - A[11] - A[12] - A[13] );
+
+#undef P256_WORD
+
+    /*
+     * The carry is small: folding it in may carry (or borrow) once more,
+     * folding that in cannot, and the result is then below 2p.
+     */
+    c = p256_fold( r, (int32_t) t );
+    p256_fold( r, c );
+    p256_reduce_once( r, 0 );
+}
+
+static void p256_mul( p256_fe r, const p256_fe a, const p256_fe b )
+{
+    uint32_t t[2 * P256_WORDS];
+    uint32_t c;
+    int i, j;
+
+    memset( t, 0, sizeof( t ) );
+
+    for( i = 0; i < P256_WORDS; i++ )
+    {
+        c = 0;
+        for( j = 0; j < P256_WORDS; j++ )
+            P256_UMAAL( t[i + j], c, a[i], b[j] );
+        t[i + P256_WORDS] = c;
+    }
+
+    p256_reduce( r, t );
+}
+
+/*
+ * Squaring: off-diagonal products once, doubled, plus the squares
+ */
+static void p256_sqr( p256_fe r, const p256_fe a )
+{
+    uint32_t t[2 * P256_WORDS];
+    uint32_t c, hi;
+    uint64_t s;
+    int i, j;
+
+    memset( t, 0, sizeof( t ) );
+
+    for( i = 0; i < P256_WORDS - 1; i++ )
+    {
+        c = 0;
+        for( j = i + 1; j < P256_WORDS; j++ )
+            P256_UMAAL( t[i + j], c, a[i], a[j] );
+        t[i + P256_WORDS] = c;
+    }
+
+    for( i = 2 * P256_WORDS - 1; i > 0; i-- )
+        t[i] = ( t[i] << 1 ) | ( t[i - 1] >> 31 );
+    t[0] <<= 1;
+
+    c = 0;
+    for( i = 0; i < P256_WORDS; i++ )
+    {
+        hi = c;
+        P256_UMAAL( t[2 * i], hi, a[i], a[i] );
+        s = (uint64_t) t[2 * i + 1] + hi;
+        t[2 * i + 1] = (uint32_t) s;
+        c = (uint32_t) ( s >> 32 );
+    }
+
+    p256_reduce( r, t );
+}
+
+static void p256_sqr_n( p256_fe r, const p256_fe a, int n )
+{
+    p256_sqr( r, a );
+    while( --n > 0 )
+        p256_sqr( r, r );
+}
+
+/*
+ * r = a^(p - 2) = 1 / a, with
+ * p - 2 = ffffffff 00000001 00000000 00000000 00000000 ffffffff ffffffff fffffffd
+ */
+static void p256_inv( p256_fe r, const p256_fe a )
+{
+    p256_fe x2, x3, x6, x12, x15, x30, x32, t;
+
+    p256_sqr( t, a );        p256_mul( x2, t, a );
+    p256_sqr( t, x2 );       p256_mul( x3, t, a );
+    p256_sqr_n( t, x3, 3 );  p256_mul( x6, t, x3 );
+    p256_sqr_n( t, x6, 6 );  p256_mul( x12, t, x6 );
+    p256_sqr_n( t, x12, 3 ); p256_mul( x15, t, x3 );
+    p256_sqr_n( t, x15, 15 ); p256_mul( x30, t, x15 );
+    p256_sqr_n( t, x30, 2 ); p256_mul( x32, t, x2 );
+
+    /* ffffffff 00000001 */
+    p256_sqr_n( t, x32, 32 ); p256_mul( t, t, a );
+    /* 00000000 00000000 00000000 ffffffff */
+    p256_sqr_n( t, t, 128 ); p256_mul( t, t, x32 );
+    /* ffffffff */
+    p256_sqr_n( t, t, 32 );  p256_mul( t, t, x32 );
+    /* fffffffd */
+    p256_sqr_n( t, t, 30 );  p256_mul( t, t, x30 );
+    p256_sqr_n( t, t, 2 );   p256_mul( r, t, a );
+
+    mbedtls_platform_zeroize( t, sizeof( t ) );
+}
+
+static int p256_is_zero( const p256_fe a )
+{
+    uint32_t acc = 0;
+    int i;
+
+    for( i = 0; i < P256_WORDS; i++ )
+        acc |= a[i];
+
+    return( acc == 0 );
+}
+
+static int p256_is_one( const p256_fe a )
+{
+    uint32_t acc = a[0] ^ 1;
+    int i;
+
+    for( i = 1; i < P256_WORDS; i++ )
+        acc |= a[i];
+
+    return( acc == 0 );
+}
+
+/*
+ * Read a coordinate, which must be in [0, 2^256), and reduce it mod p
+ */
+static int p256_load( p256_fe r, const mbedtls_mpi *X )
+{
+    size_t i, l;
+
+    if( X->s < 0 || mbedtls_mpi_bitlen( X ) > 256 )
+        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+
+    for( i = 0; i < P256_WORDS; i++ )
+    {
+        l = i / P256_WPL;
+        r[i] = l < X->n ?
+               (uint32_t) ( X->p[l] >> ( 32 * ( i % P256_WPL ) ) ) : 0;
+    }
+
+    p256_reduce_once( r, 0 );
+
+    return( 0 );
+}
+
+static int p256_store( mbedtls_mpi *X, const p256_fe a )
+{
+    int ret;
+    size_t i;
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_grow( X, P256_WORDS / P256_WPL ) );
+
+    memset( X->p, 0, X->n * sizeof( mbedtls_mpi_uint ) );
+    for( i = 0; i < P256_WORDS; i++ )
+        X->p[i / P256_WPL] |= (mbedtls_mpi_uint) a[i] << ( 32 * ( i % P256_WPL ) );
+    X->s = 1;
+
+cleanup:
+    return( ret );
+}
+
+/*
+ * Point in Jacobian coordinates
+ */
+typedef struct
+{
+    p256_fe X, Y, Z;
+}
+p256_jac;
+
+static int p256_load_point( p256_jac *R, const mbedtls_ecp_point *P )
+{
+    int ret;
+
+    MBEDTLS_MPI_CHK( p256_load( R->X, &P->X ) );
+    MBEDTLS_MPI_CHK( p256_load( R->Y, &P->Y ) );
+    MBEDTLS_MPI_CHK( p256_load( R->Z, &P->Z ) );
+
+cleanup:
+    return( ret );
+}
+
+static int p256_store_point( mbedtls_ecp_point *R, const p256_jac *P )
+{
+    int ret;
+
+    MBEDTLS_MPI_CHK( p256_store( &R->X, P->X ) );
+    MBEDTLS_MPI_CHK( p256_store( &R->Y, P->Y ) );
+    MBEDTLS_MPI_CHK( p256_store( &R->Z, P->Z ) );
+
+cleanup:
+    return( ret );
+}
+
+/*
+ * Doubling with A = -3, same steps as ecp_double_jac()
+ */
+static void p256_double( p256_jac *R, const p256_jac *P )
+{
+    p256_fe M, S, T, U;
+
+    /* M = 3(X + Z^2)(X - Z^2) */
+    p256_sqr( S, P->Z );
+    p256_add( T, P->X, S );
+    p256_sub( U, P->X, S );
+    p256_mul( S, T, U );
+    p256_add( M, S, S );
+    p256_add( M, M, S );
+
+    /* S = 4.X.Y^2 */
+    p256_sqr( T, P->Y );
+    p256_add( T, T, T );
+    p256_mul( S, P->X, T );
+    p256_add( S, S, S );
+
+    /* U = 8.Y^4 */
+    p256_sqr( U, T );
+    p256_add( U, U, U );
+
+    /* T = M^2 - 2.S */
+    p256_sqr( T, M );
+    p256_sub( T, T, S );
+    p256_sub( T, T, S );
+
+    /* S = M(S - T) - U */
+    p256_sub( S, S, T );
+    p256_mul( S, S, M );
+    p256_sub( S, S, U );
+
+    /* U = 2.Y.Z */
+    p256_mul( U, P->Y, P->Z );
+    p256_add( R->Z, U, U );
+
+    memcpy( R->X, T, sizeof( p256_fe ) );
+    memcpy( R->Y, S, sizeof( p256_fe ) );
+
+    mbedtls_platform_zeroize( M, sizeof( M ) );
+    mbedtls_platform_zeroize( S, sizeof( S ) );
+    mbedtls_platform_zeroize( T, sizeof( T ) );
+    mbedtls_platform_zeroize( U, sizeof( U ) );
+}
+
+unsigned char mbedtls_internal_ecp_grp_capable( const mbedtls_ecp_group *grp )
+{
+    return( grp->id == MBEDTLS_ECP_DP_SECP256R1 );
+}
+
+int mbedtls_internal_ecp_init( const mbedtls_ecp_group *grp )
+{
+    (void) grp;
+    return( 0 );
+}
+
+void mbedtls_internal_ecp_free( const mbedtls_ecp_group *grp )
+{
+    (void) grp;
+}
+
+#if defined(MBEDTLS_ECP_DOUBLE_JAC_ALT)
+int mbedtls_internal_ecp_double_jac( const mbedtls_ecp_group *grp,
+        mbedtls_ecp_point *R, const mbedtls_ecp_point *P )
+{
+    int ret;
+    p256_jac J;
+
+    (void) grp;
+
+    MBEDTLS_MPI_CHK( p256_load_point( &J, P ) );
+    p256_double( &J, &J );
+    MBEDTLS_MPI_CHK( p256_store_point( R, &J ) );
+
+cleanup:
+    mbedtls_platform_zeroize( &J, sizeof( J ) );
+
+    return( ret );
+}
+#endif /* MBEDTLS_ECP_DOUBLE_JAC_ALT */
+
+#if defined(MBEDTLS_ECP_ADD_MIXED_ALT)
+/*
+ * Same steps and special cases as ecp_add_mixed(): the branches only depend
+ * on the points being zero or equal, which doesn't happen inside the comb.
+ */
+int mbedtls_internal_ecp_add_mixed( const mbedtls_ecp_group *grp,
+        mbedtls_ecp_point *R, const mbedtls_ecp_point *P,
+        const mbedtls_ecp_point *Q )
+{
+    int ret;
+    p256_jac J;
+    p256_fe QX, QY, T1, T2, T3, T4;
+
+    (void) grp;
+
+    if( mbedtls_mpi_cmp_int( &P->Z, 0 ) == 0 )
+        return( mbedtls_ecp_copy( R, Q ) );
+
+    if( Q->Z.p != NULL && mbedtls_mpi_cmp_int( &Q->Z, 0 ) == 0 )
+        return( mbedtls_ecp_copy( R, P ) );
+
+    if( Q->Z.p != NULL && mbedtls_mpi_cmp_int( &Q->Z, 1 ) != 0 )
+        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+
+    MBEDTLS_MPI_CHK( p256_load_point( &J, P ) );
+    MBEDTLS_MPI_CHK( p256_load( QX, &Q->X ) );
+    MBEDTLS_MPI_CHK( p256_load( QY, &Q->Y ) );
+
+    p256_sqr( T1, J.Z );
+    p256_mul( T2, T1, J.Z );
+    p256_mul( T1, T1, QX );
+    p256_mul( T2, T2, QY );
+    p256_sub( T1, T1, J.X );
+    p256_sub( T2, T2, J.Y );
+
+    if( p256_is_zero( T1 ) )
+    {
+        if( p256_is_zero( T2 ) )
+        {
+            p256_double( &J, &J );
+            ret = p256_store_point( R, &J );
+        }
+        else
+            ret = mbedtls_ecp_set_zero( R );
+        goto cleanup;
+    }
+
+    p256_mul( J.Z, J.Z, T1 );
+    p256_sqr( T3, T1 );
+    p256_mul( T4, T3, T1 );
+    p256_mul( T3, T3, J.X );
+    p256_add( T1, T3, T3 );
+    p256_sqr( J.X, T2 );
+    p256_sub( J.X, J.X, T1 );
+    p256_sub( J.X, J.X, T4 );
+    p256_sub( T3, T3, J.X );
+    p256_mul( T3, T3, T2 );
+    p256_mul( T4, T4, J.Y );
+    p256_sub( J.Y, T3, T4 );
+
+    MBEDTLS_MPI_CHK( p256_store_point( R, &J ) );
+
+cleanup:
+    mbedtls_platform_zeroize( &J, sizeof( J ) );
+    mbedtls_platform_zeroize( T1, sizeof( T1 ) );
+    mbedtls_platform_zeroize( T2, sizeof( T2 ) );
+    mbedtls_platform_zeroize( T3, sizeof( T3 ) );
+    mbedtls_platform_zeroize( T4, sizeof( T4 ) );
+
+    return( ret );
+}
+#endif /* MBEDTLS_ECP_ADD_MIXED_ALT */
+
+#if defined(MBEDTLS_ECP_RANDOMIZE_JAC_ALT)
+/*
+ * (X, Y, Z) -> (l^2 X, l^3 Y, l Z) for a random 1 < l < p
+ */
+int mbedtls_internal_ecp_randomize_jac( const mbedtls_ecp_group *grp,
+        mbedtls_ecp_point *pt, int (*f_rng)(void *, unsigned char *, size_t),
+        void *p_rng )
+{
+    int ret;
+    int count = 0;
+    unsigned char buf[4 * P256_WORDS];
+    p256_jac J;
+    p256_fe l, ll, t;
+    size_t i;
+
+    (void) grp;
+
+    do
+    {
+        if( count++ > 10 )
+        {
+            ret = MBEDTLS_ERR_ECP_RANDOM_FAILED;
+            goto cleanup;
+        }
+
+        if( ( ret = f_rng( p_rng, buf, sizeof( buf ) ) ) != 0 )
+            goto cleanup;
+
+        for( i = 0; i < P256_WORDS; i++ )
+            l[i] = ( (uint32_t) buf[31 - 4 * i]       ) |
+                   ( (uint32_t) buf[30 - 4 * i] <<  8 ) |
+                   ( (uint32_t) buf[29 - 4 * i] << 16 ) |
+                   ( (uint32_t) buf[28 - 4 * i] << 24 );
+    }
+    while( p256_sub_words( t, l, p256_p ) == 0 || p256_is_zero( l ) ||
+           p256_is_one( l ) );
+
+    MBEDTLS_MPI_CHK( p256_load_point( &J, pt ) );
+
+    p256_mul( J.Z, J.Z, l );
+    p256_sqr( ll, l );
+    p256_mul( J.X, J.X, ll );
+    p256_mul( ll, ll, l );
+    p256_mul( J.Y, J.Y, ll );
+
+    MBEDTLS_MPI_CHK( p256_store_point( pt, &J ) );
+
+cleanup:
+    mbedtls_platform_zeroize( buf, sizeof( buf ) );
+    mbedtls_platform_zeroize( &J, sizeof( J ) );
+    mbedtls_platform_zeroize( l, sizeof( l ) );
+    mbedtls_platform_zeroize( ll, sizeof( ll ) );
+    mbedtls_platform_zeroize( t, sizeof( t ) );
+
+    return( ret );
+}
+#endif /* MBEDTLS_ECP_RANDOMIZE_JAC_ALT */
+
+#if defined(MBEDTLS_ECP_NORMALIZE_JAC_ALT) || \
+    defined(MBEDTLS_ECP_NORMALIZE_JAC_MANY_ALT)
+static int p256_normalize( mbedtls_ecp_point *pt )
+{
+    int ret;
+    p256_jac J;
+    p256_fe Zi, ZZi;
+
+    if( mbedtls_mpi_cmp_int( &pt->Z, 0 ) == 0 )
+        return( 0 );
+
+    MBEDTLS_MPI_CHK( p256_load_point( &J, pt ) );
+
+    p256_inv( Zi, J.Z );
+    p256_sqr( ZZi, Zi );
+    p256_mul( J.X, J.X, ZZi );
+    p256_mul( J.Y, J.Y, ZZi );
+    p256_mul( J.Y, J.Y, Zi );
+
+    MBEDTLS_MPI_CHK( p256_store( &pt->X, J.X ) );
+    MBEDTLS_MPI_CHK( p256_store( &pt->Y, J.Y ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_lset( &pt->Z, 1 ) );
+
+cleanup:
+    mbedtls_platform_zeroize( &J, sizeof( J ) );
+    mbedtls_platform_zeroize( Zi, sizeof( Zi ) );
+    mbedtls_platform_zeroize( ZZi, sizeof( ZZi ) );
+
+    return( ret );
+}
+#endif
+
+#if defined(MBEDTLS_ECP_NORMALIZE_JAC_ALT)
+int mbedtls_internal_ecp_normalize_jac( const mbedtls_ecp_group *grp,
+        mbedtls_ecp_point *pt )
+{
+    (void) grp;
+
+    return( p256_normalize( pt ) );
+}
+#endif /* MBEDTLS_ECP_NORMALIZE_JAC_ALT */
+
+#if defined(MBEDTLS_ECP_NORMALIZE_JAC_MANY_ALT)
+/*
+ * Montgomery's trick as in ecp_normalize_jac_many(), fails if one of the
+ * points is zero
+ */
+int mbedtls_internal_ecp_normalize_jac_many( const mbedtls_ecp_group *grp,
+        mbedtls_ecp_point *T[], size_t t_len )
+{
+    int ret;
+    size_t i;
+    p256_fe *c;
+    p256_fe u, Zi, ZZi, X, Y;
+
+    if( t_len < 2 )
+        return( p256_normalize( *T ) );
+
+    if( ( c = mbedtls_calloc( t_len, sizeof( p256_fe ) ) ) == NULL )
+        return( MBEDTLS_ERR_ECP_ALLOC_FAILED );
+
+    /* c[i] = Z_0 * ... * Z_i */
+    MBEDTLS_MPI_CHK( p256_load( c[0], &T[0]->Z ) );
+    for( i = 1; i < t_len; i++ )
+    {
+        MBEDTLS_MPI_CHK( p256_load( u, &T[i]->Z ) );
+        p256_mul( c[i], c[i - 1], u );
+    }
+
+    if( p256_is_zero( c[t_len - 1] ) )
+    {
+        ret = MBEDTLS_ERR_MPI_NOT_ACCEPTABLE;
+        goto cleanup;
+    }
+
+    /* u = 1 / (Z_0 * ... * Z_n) mod P */
+    p256_inv( u, c[t_len - 1] );
+
+    for( i = t_len - 1; ; i-- )
+    {
+        /*
+         * Zi = 1 / Z_i mod p
+         * u = 1 / (Z_0 * ... * Z_i) mod P
+         */
+        if( i == 0 )
+            memcpy( Zi, u, sizeof( p256_fe ) );
+        else
+        {
+            p256_mul( Zi, u, c[i - 1] );
+            MBEDTLS_MPI_CHK( p256_load( X, &T[i]->Z ) );
+            p256_mul( u, u, X );
+        }
+
+        /* proceed as in normalize() */
+        MBEDTLS_MPI_CHK( p256_load( X, &T[i]->X ) );
+        MBEDTLS_MPI_CHK( p256_load( Y, &T[i]->Y ) );
+        p256_sqr( ZZi, Zi );
+        p256_mul( X, X, ZZi );
+        p256_mul( Y, Y, ZZi );
+        p256_mul( Y, Y, Zi );
+
+        MBEDTLS_MPI_CHK( p256_store( &T[i]->X, X ) );
+        MBEDTLS_MPI_CHK( p256_store( &T[i]->Y, Y ) );
+
+        /*
+         * Post-precessing: reclaim some memory by shrinking coordinates
+         * - not storing Z (always 1)
+         * - shrinking other coordinates, but still keeping the same number of
+         *   limbs as P, as otherwise it will too likely be regrown too fast.
+         */
+        MBEDTLS_MPI_CHK( mbedtls_mpi_shrink( &T[i]->X, grp->P.n ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_shrink( &T[i]->Y, grp->P.n ) );
+        mbedtls_mpi_free( &T[i]->Z );
+
+        if( i == 0 )
+            break;
+    }
+
+cleanup:
+    mbedtls_platform_zeroize( c, t_len * sizeof( p256_fe ) );
+    mbedtls_free( c );
+    mbedtls_platform_zeroize( u, sizeof( u ) );
+    mbedtls_platform_zeroize( Zi, sizeof( Zi ) );
+    mbedtls_platform_zeroize( ZZi, sizeof( ZZi ) );
+    mbedtls_platform_zeroize( X, sizeof( X ) );
+    mbedtls_platform_zeroize( Y, sizeof( Y ) );
+
+    return( ret );
+}
+#endif /* MBEDTLS_ECP_NORMALIZE_JAC_MANY_ALT */
+
+#endif /* !MBEDTLS_ECP_ALT */
+
+#endif /* MBEDTLS_ECP_C && MBEDTLS_ECP_INTERNAL_ALT && MBEDTLS_ECP_DP_SECP256R1_ENABLED */
@@ -0,0 +1,509 @@
+/*
+ *  NIST SP800-38D compliant GCM implementation
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+/*
+ * http://csrc.nist.gov/publications/nistpubs/800-38D/SP-800-38D.pdf
+ *
+ * See also:
+ * [MGV] http://csrc.nist.gov/groups/ST/toolkit/BCM/documents/proposedmodes/gcm/gcm-revised-spec.pdf
+ *
+ * We use the algorithm described as Shoup's method with 4-bit tables in
+ * [MGV] 4.1, pp. 12-13, to enhance speed without using too much memory,
+ * on 32-bit words. The counter mode key stream is produced by the crypto
+ * engine, see mbedtls_aes_alt_ctr_blocks().
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_GCM_C) && defined(MBEDTLS_GCM_ALT)
+
+#include "mbedtls/gcm.h"
+#include "mbedtls/platform_util.h"
+
+#include <string.h>
+
+/* Parameter validation macros */
+#define GCM_VALIDATE_RET( cond ) \
+    MBEDTLS_INTERNAL_VALIDATE_RET( cond, MBEDTLS_ERR_GCM_BAD_INPUT )
+#define GCM_VALIDATE( cond ) \
+    MBEDTLS_INTERNAL_VALIDATE( cond )
+
+/*
+ * 32-bit integer manipulation macros (big endian)
+ */
+#ifndef GET_UINT32_BE
+#define GET_UINT32_BE(n,b,i)                            \
+{                                                       \
+    (n) = ( (uint32_t) (b)[(i)    ] << 24 )             \
+        | ( (uint32_t) (b)[(i) + 1] << 16 )             \
+        | ( (uint32_t) (b)[(i) + 2] <<  8 )             \
+        | ( (uint32_t) (b)[(i) + 3]       );            \
+}
+#endif
+
+#ifndef PUT_UINT32_BE
+#define PUT_UINT32_BE(n,b,i)                            \
+{                                                       \
+    (b)[(i)    ] = (unsigned char) ( (n) >> 24 );       \
+    (b)[(i) + 1] = (unsigned char) ( (n) >> 16 );       \
+    (b)[(i) + 2] = (unsigned char) ( (n) >>  8 );       \
+    (b)[(i) + 3] = (unsigned char) ( (n)       );       \
+}
+#endif
+
+/*
+ * Initialize a context
+ */
+void mbedtls_gcm_init( mbedtls_gcm_context *ctx )
+{
+    GCM_VALIDATE( ctx != NULL );
+    memset( ctx, 0, sizeof( mbedtls_gcm_context ) );
+}
+
+/*
+ * Precompute small multiples of H, that is set
+ *      HT[i] = H times i,
+ * where i is seen as a field element as in [MGV], ie high-order bits
+ * correspond to low powers of P. HT[i][0] holds the 32 bits of lowest
+ * powers, HT[i][3] those of the highest.
+ */
+static int gcm_gen_table( mbedtls_gcm_context *ctx )
+{
+    int ret, i, j;
+    uint32_t v0, v1, v2, v3, T;
+    unsigned char h[16];
+
+    memset( h, 0, 16 );
+    if( ( ret = mbedtls_internal_aes_encrypt( &ctx->aes_ctx, h, h ) ) != 0 )
+        return( ret );
+
+    GET_UINT32_BE( v0, h,  0 );
+    GET_UINT32_BE( v1, h,  4 );
+    GET_UINT32_BE( v2, h,  8 );
+    GET_UINT32_BE( v3, h, 12 );
+    mbedtls_platform_zeroize( h, sizeof( h ) );
+
+    /* 8 = 1000 corresponds to 1 in GF(2^128) */
+    ctx->HT[8][0] = v0;
+    ctx->HT[8][1] = v1;
+    ctx->HT[8][2] = v2;
+    ctx->HT[8][3] = v3;
+
+    /* 0 corresponds to 0 in GF(2^128) */
+    memset( ctx->HT[0], 0, sizeof( ctx->HT[0] ) );
+
+    for( i = 4; i > 0; i >>= 1 )
+    {
+        T  = ( v3 & 1 ) * 0xe1000000U;
+        v3 = ( v2 << 31 ) | ( v3 >> 1 );
+        v2 = ( v1 << 31 ) | ( v2 >> 1 );
+        v1 = ( v0 << 31 ) | ( v1 >> 1 );
+        v0 = ( v0 >> 1 ) ^ T;
+
+        ctx->HT[i][0] = v0;
+        ctx->HT[i][1] = v1;
+        ctx->HT[i][2] = v2;
+        ctx->HT[i][3] = v3;
+    }
+
+    for( i = 2; i <= 8; i *= 2 )
+    {
+        for( j = 1; j < i; j++ )
+        {
+            ctx->HT[i + j][0] = ctx->HT[i][0] ^ ctx->HT[j][0];
+            ctx->HT[i + j][1] = ctx->HT[i][1] ^ ctx->HT[j][1];
+            ctx->HT[i + j][2] = ctx->HT[i][2] ^ ctx->HT[j][2];
+            ctx->HT[i + j][3] = ctx->HT[i][3] ^ ctx->HT[j][3];
+        }
+    }
+
+    return( 0 );
+}
+
+int mbedtls_gcm_setkey( mbedtls_gcm_context *ctx,
+                        mbedtls_cipher_id_t cipher,
+                        const unsigned char *key,
+                        unsigned int keybits )
+{
+    int ret;
+
+    GCM_VALIDATE_RET( ctx != NULL );
+    GCM_VALIDATE_RET( key != NULL );
+    GCM_VALIDATE_RET( keybits == 128 || keybits == 192 || keybits == 256 );
+
+    if( cipher != MBEDTLS_CIPHER_ID_AES )
+        return( MBEDTLS_ERR_GCM_BAD_INPUT );
+
+    mbedtls_aes_free( &ctx->aes_ctx );
+    mbedtls_aes_init( &ctx->aes_ctx );
+
+    if( ( ret = mbedtls_aes_setkey_enc( &ctx->aes_ctx, key, keybits ) ) != 0 )
+        return( ret );
+
+    return( gcm_gen_table( ctx ) );
+}
+
+/*
+ * Shoup's method for multiplication use this table with
+ *      last4[x] = x times P^128
+ * where x and last4[x] are seen as elements of GF(2^128) as in [MGV]
+ */
+static const uint16_t last4[16] =
+{
+    0x0000, 0x1c20, 0x3840, 0x2460,
+    0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560,
+    0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+#define GCM_MULT_STEP( nibble )                                 \
+{                                                               \
+    rem = z3 & 0xf;                                             \
+    z3 = ( z2 << 28 ) | ( z3 >> 4 );                            \
+    z2 = ( z1 << 28 ) | ( z2 >> 4 );                            \
+    z1 = ( z0 << 28 ) | ( z1 >> 4 );                            \
+    z0 = ( z0 >> 4 ) ^ ( (uint32_t) last4[rem] << 16 );         \
+    t = ctx->HT[nibble];                                        \
+    z0 ^= t[0]; z1 ^= t[1]; z2 ^= t[2]; z3 ^= t[3];             \
+}
+
+/*
+ * Sets x to x times H using the precomputed tables.
+ * x is seen as an element of GF(2^128) as in [MGV].
+ */
+static void gcm_mult( const mbedtls_gcm_context *ctx, uint32_t x[4] )
+{
+    int i;
+    unsigned int b, rem;
+    uint32_t z0, z1, z2, z3;
+    const uint32_t *t;
+
+    t = ctx->HT[x[3] & 0xf];
+    z0 = t[0]; z1 = t[1]; z2 = t[2]; z3 = t[3];
+
+    GCM_MULT_STEP( ( x[3] >> 4 ) & 0xf );
+
+    for( i = 14; i >= 0; i-- )
+    {
+        b = ( x[i >> 2] >> ( ( 3 - ( i & 3 ) ) << 3 ) ) & 0xff;
+
+        GCM_MULT_STEP( b & 0xf );
+        GCM_MULT_STEP( b >> 4 );
+    }
+
+    x[0] = z0; x[1] = z1; x[2] = z2; x[3] = z3;
+}
+
+/*
+ * Fold length bytes into the GHASH accumulator x, a trailing partial block
+ * is padded with zeros
+ */
+static void gcm_ghash( const mbedtls_gcm_context *ctx, uint32_t x[4],
+                       const unsigned char *p, size_t length )
+{
+    unsigned char last[16];
+    uint32_t w;
+
+    while( length > 0 )
+    {
+        if( length < 16 )
+        {
+            memset( last, 0, 16 );
+            memcpy( last, p, length );
+            p = last;
+            length = 16;
+        }
+
+        GET_UINT32_BE( w, p,  0 ); x[0] ^= w;
+        GET_UINT32_BE( w, p,  4 ); x[1] ^= w;
+        GET_UINT32_BE( w, p,  8 ); x[2] ^= w;
+        GET_UINT32_BE( w, p, 12 ); x[3] ^= w;
+
+        gcm_mult( ctx, x );
+
+        length -= 16;
+        p += 16;
+    }
+}
+
+/* Increment the 32-bit counter of a counter block */
+static void gcm_inc32( unsigned char y[16] )
+{
+    int i;
+
+    for( i = 16; i > 12; i-- )
+        if( ++y[i - 1] != 0 )
+            break;
+}
+
+int mbedtls_gcm_starts( mbedtls_gcm_context *ctx,
+                int mode,
+                const unsigned char *iv,
+                size_t iv_len,
+                const unsigned char *add,
+                size_t add_len )
+{
+    int ret;
+    unsigned char work_buf[16];
+
+    GCM_VALIDATE_RET( ctx != NULL );
+    GCM_VALIDATE_RET( iv != NULL );
+    GCM_VALIDATE_RET( add_len == 0 || add != NULL );
+
+    /* IV and AD are limited to 2^64 bits, so 2^61 bytes */
+    /* IV is not allowed to be zero length */
+    if( iv_len == 0 ||
+      ( (uint64_t) iv_len  ) >> 61 != 0 ||
+      ( (uint64_t) add_len ) >> 61 != 0 )
+    {
+        return( MBEDTLS_ERR_GCM_BAD_INPUT );
+    }
+
+    memset( ctx->X, 0x00, sizeof( ctx->X ) );
+
+    ctx->mode = mode;
+    ctx->len = 0;
+    ctx->add_len = 0;
+
+    if( iv_len == 12 )
+    {
+        memcpy( ctx->y, iv, iv_len );
+        memset( ctx->y + 12, 0x00, 3 );
+        ctx->y[15] = 1;
+    }
+    else
+    {
+        uint32_t j0[4] = { 0, 0, 0, 0 };
+
+        memset( work_buf, 0x00, 16 );
+        PUT_UINT32_BE( iv_len * 8, work_buf, 12 );
+
+        gcm_ghash( ctx, j0, iv, iv_len );
+        gcm_ghash( ctx, j0, work_buf, 16 );
+
+        PUT_UINT32_BE( j0[0], ctx->y,  0 );
+        PUT_UINT32_BE( j0[1], ctx->y,  4 );
+        PUT_UINT32_BE( j0[2], ctx->y,  8 );
+        PUT_UINT32_BE( j0[3], ctx->y, 12 );
+    }
+
+    if( ( ret = mbedtls_internal_aes_encrypt( &ctx->aes_ctx, ctx->y,
+                                              ctx->base_ectr ) ) != 0 )
+        return( ret );
+    gcm_inc32( ctx->y );
+
+    ctx->add_len = add_len;
+    gcm_ghash( ctx, ctx->X, add, add_len );
+
+    return( 0 );
+}
+
+int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
+                size_t length,
+                const unsigned char *input,
+                unsigned char *output )
+{
+    int ret;
+    unsigned char ectr[16];
+    size_t nblocks, tail;
+
+    GCM_VALIDATE_RET( ctx != NULL );
+    GCM_VALIDATE_RET( length == 0 || input != NULL );
+    GCM_VALIDATE_RET( length == 0 || output != NULL );
+
+    if( output > input && (size_t) ( output - input ) < length )
+        return( MBEDTLS_ERR_GCM_BAD_INPUT );
+
+    /* Total length is restricted to 2^39 - 256 bits, ie 2^36 - 2^5 bytes
+     * Also check for possible overflow */
+    if( ctx->len + length < ctx->len ||
+        (uint64_t) ctx->len + length > 0xFFFFFFFE0ull )
+    {
+        return( MBEDTLS_ERR_GCM_BAD_INPUT );
+    }
+
+    ctx->len += length;
+
+    /* The cipher text is hashed before it may be overwritten in place */
+    if( ctx->mode == MBEDTLS_GCM_DECRYPT )
+        gcm_ghash( ctx, ctx->X, input, length );
+
+    nblocks = length / 16;
+    tail = length % 16;
+
+    if( nblocks > 0 &&
+        ( ret = mbedtls_aes_alt_ctr_blocks( &ctx->aes_ctx, nblocks, 4, ctx->y,
+                                            input, output ) ) != 0 )
+    {
+        return( ret );
+    }
+
+    if( tail > 0 )
+    {
+        size_t i;
+
+        if( ( ret = mbedtls_internal_aes_encrypt( &ctx->aes_ctx, ctx->y,
+                                                  ectr ) ) != 0 )
+            return( ret );
+        gcm_inc32( ctx->y );
+
+        for( i = nblocks * 16; i < length; i++ )
+            output[i] = ectr[i % 16] ^ input[i];
+
+        mbedtls_platform_zeroize( ectr, sizeof( ectr ) );
+    }
+
+    if( ctx->mode == MBEDTLS_GCM_ENCRYPT )
+        gcm_ghash( ctx, ctx->X, output, length );
+
+    return( 0 );
+}
+
+int mbedtls_gcm_finish( mbedtls_gcm_context *ctx,
+                unsigned char *tag,
+                size_t tag_len )
+{
+    unsigned char work_buf[16];
+    size_t i;
+    uint64_t orig_len;
+    uint64_t orig_add_len;
+
+    GCM_VALIDATE_RET( ctx != NULL );
+    GCM_VALIDATE_RET( tag != NULL );
+
+    orig_len = ctx->len * 8;
+    orig_add_len = ctx->add_len * 8;
+
+    if( tag_len > 16 || tag_len < 4 )
+        return( MBEDTLS_ERR_GCM_BAD_INPUT );
+
+    memcpy( tag, ctx->base_ectr, tag_len );
+
+    if( orig_len || orig_add_len )
+    {
+        PUT_UINT32_BE( ( orig_add_len >> 32 ), work_buf, 0  );
+        PUT_UINT32_BE( ( orig_add_len       ), work_buf, 4  );
+        PUT_UINT32_BE( ( orig_len     >> 32 ), work_buf, 8  );
+        PUT_UINT32_BE( ( orig_len           ), work_buf, 12 );
+
+        gcm_ghash( ctx, ctx->X, work_buf, 16 );
+
+        PUT_UINT32_BE( ctx->X[0], work_buf,  0 );
+        PUT_UINT32_BE( ctx->X[1], work_buf,  4 );
+        PUT_UINT32_BE( ctx->X[2], work_buf,  8 );
+        PUT_UINT32_BE( ctx->X[3], work_buf, 12 );
+
+        for( i = 0; i < tag_len; i++ )
+            tag[i] ^= work_buf[i];
+    }
+
+    return( 0 );
+}
+
+int mbedtls_gcm_crypt_and_tag( mbedtls_gcm_context *ctx,
+                       int mode,
+                       size_t length,
+                       const unsigned char *iv,
+                       size_t iv_len,
+                       const unsigned char *add,
+                       size_t add_len,
+                       const unsigned char *input,
+                       unsigned char *output,
+                       size_t tag_len,
+                       unsigned char *tag )
+{
+    int ret;
+
+    GCM_VALIDATE_RET( ctx != NULL );
+    GCM_VALIDATE_RET( iv != NULL );
+    GCM_VALIDATE_RET( add_len == 0 || add != NULL );
+    GCM_VALIDATE_RET( length == 0 || input != NULL );
+    GCM_VALIDATE_RET( length == 0 || output != NULL );
+    GCM_VALIDATE_RET( tag != NULL );
+
+    if( ( ret = mbedtls_gcm_starts( ctx, mode, iv, iv_len, add, add_len ) ) != 0 )
+        return( ret );
+
+    if( ( ret = mbedtls_gcm_update( ctx, length, input, output ) ) != 0 )
+        return( ret );
+
+    if( ( ret = mbedtls_gcm_finish( ctx, tag, tag_len ) ) != 0 )
+        return( ret );
+
+    return( 0 );
+}
+
+int mbedtls_gcm_auth_decrypt( mbedtls_gcm_context *ctx,
+                      size_t length,
+                      const unsigned char *iv,
+                      size_t iv_len,
+                      const unsigned char *add,
+                      size_t add_len,
+                      const unsigned char *tag,
+                      size_t tag_len,
+                      const unsigned char *input,
+                      unsigned char *output )
+{
+    int ret;
+    unsigned char check_tag[16];
+    size_t i;
+    int diff;
+
+    GCM_VALIDATE_RET( ctx != NULL );
+    GCM_VALIDATE_RET( iv != NULL );
+    GCM_VALIDATE_RET( add_len == 0 || add != NULL );
+    GCM_VALIDATE_RET( tag != NULL );
+    GCM_VALIDATE_RET( length == 0 || input != NULL );
+    GCM_VALIDATE_RET( length == 0 || output != NULL );
+
+    if( ( ret = mbedtls_gcm_crypt_and_tag( ctx, MBEDTLS_GCM_DECRYPT, length,
+                                   iv, iv_len, add, add_len,
+                                   input, output, tag_len, check_tag ) ) != 0 )
+    {
+        return( ret );
+    }
+
+    /* Check tag in "constant-time" */
+    for( diff = 0, i = 0; i < tag_len; i++ )
+        diff |= tag[i] ^ check_tag[i];
+
+    if( diff != 0 )
+    {
+        mbedtls_platform_zeroize( output, length );
+        return( MBEDTLS_ERR_GCM_AUTH_FAILED );
+    }
+
+    return( 0 );
+}
+
+void mbedtls_gcm_free( mbedtls_gcm_context *ctx )
+{
+    if( ctx == NULL )
+        return;
+    mbedtls_aes_free( &ctx->aes_ctx );
+    mbedtls_platform_zeroize( ctx, sizeof( mbedtls_gcm_context ) );
+}
+
+#endif /* MBEDTLS_GCM_C && MBEDTLS_GCM_ALT */
@@ -0,0 +1,451 @@
+/*
+ *  In-memory TLS handshake benchmark: RSA vs ECDHE-ECDSA key exchange
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+/*
+ * Runs full handshakes between a client and a server living in the same
+ * process, connected through memory buffers, and reports for each key
+ * exchange the time spent on each side and the peak heap of each side.
+ *
+ * Usage: ssl_hs_bench [count]
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_PLATFORM_C)
+#include "mbedtls/platform.h"
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#define mbedtls_printf          printf
+#define mbedtls_exit            exit
+#define MBEDTLS_EXIT_SUCCESS    EXIT_SUCCESS
+#define MBEDTLS_EXIT_FAILURE    EXIT_FAILURE
+#endif /* MBEDTLS_PLATFORM_C */
+
+#if !defined(MBEDTLS_ENTROPY_C) || !defined(MBEDTLS_CTR_DRBG_C) ||      \
+    !defined(MBEDTLS_SSL_TLS_C) || !defined(MBEDTLS_SSL_CLI_C) ||        \
+    !defined(MBEDTLS_SSL_SRV_C) || !defined(MBEDTLS_CERTS_C) ||          \
+    !defined(MBEDTLS_PEM_PARSE_C) || !defined(MBEDTLS_X509_CRT_PARSE_C) || \
+    !defined(MBEDTLS_TIMING_C) || !defined(MBEDTLS_PLATFORM_MEMORY)
+int main( void )
+{
+    mbedtls_printf("MBEDTLS_ENTROPY_C and/or MBEDTLS_CTR_DRBG_C and/or "
+           "MBEDTLS_SSL_TLS_C and/or MBEDTLS_SSL_CLI_C and/or "
+           "MBEDTLS_SSL_SRV_C and/or MBEDTLS_CERTS_C and/or "
+           "MBEDTLS_PEM_PARSE_C and/or MBEDTLS_X509_CRT_PARSE_C and/or "
+           "MBEDTLS_TIMING_C and/or MBEDTLS_PLATFORM_MEMORY "
+           "not defined.\n");
+    return( 0 );
+}
+#else
+
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_ciphersuites.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/certs.h"
+#include "mbedtls/timing.h"
+#include "mbedtls/error.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DFL_COUNT       10
+#define BIO_SIZE        ( 2 * MBEDTLS_SSL_MAX_CONTENT_LEN )
+
+#if defined(MBEDTLS_CHECK_PARAMS)
+#include "mbedtls/platform_util.h"
+void mbedtls_param_failed( const char *failure_condition,
+                           const char *file,
+                           int line )
+{
+    mbedtls_printf( "%s:%i: Input param failed - %s\n",
+                    file, line, failure_condition );
+    mbedtls_exit( MBEDTLS_EXIT_FAILURE );
+}
+#endif
+
+/*
+ * Heap accounting: every block carries a header recording its size and the
+ * side (client or server) that was running when it was allocated.
+ */
+#define SIDE_CLI    0
+#define SIDE_SRV    1
+
+typedef union
+{
+    struct
+    {
+        size_t size;
+        int side;
+    } h;
+    long double align;
+} bench_hdr;
+
+static int cur_side;
+static size_t heap_cur[2];
+static size_t heap_peak[2];
+
+static void *bench_calloc( size_t n, size_t size )
+{
+    bench_hdr *hdr;
+    size_t len;
+
+    if( size != 0 && n > ( (size_t) -1 - sizeof( bench_hdr ) ) / size )
+        return( NULL );
+    len = n * size;
+
+    hdr = calloc( 1, sizeof( bench_hdr ) + len );
+    if( hdr == NULL )
+        return( NULL );
+
+    hdr->h.size = len;
+    hdr->h.side = cur_side;
+    heap_cur[cur_side] += len;
+    if( heap_cur[cur_side] > heap_peak[cur_side] )
+        heap_peak[cur_side] = heap_cur[cur_side];
+
+    return( hdr + 1 );
+}
+
+static void bench_free( void *ptr )
+{
+    bench_hdr *hdr;
+
+    if( ptr == NULL )
+        return;
+
+    hdr = (bench_hdr *) ptr - 1;
+    heap_cur[hdr->h.side] -= hdr->h.size;
+    free( hdr );
+}
+
+/*
+ * One direction of the in-memory transport
+ */
+typedef struct
+{
+    unsigned char buf[BIO_SIZE];
+    size_t len;
+} bench_bio;
+
+typedef struct
+{
+    bench_bio *in;
+    bench_bio *out;
+} bench_link;
+
+static int bench_send( void *ctx, const unsigned char *buf, size_t len )
+{
+    bench_bio *out = ( (bench_link *) ctx )->out;
+
+    if( len > sizeof( out->buf ) - out->len )
+        len = sizeof( out->buf ) - out->len;
+    if( len == 0 )
+        return( MBEDTLS_ERR_SSL_WANT_WRITE );
+
+    memcpy( out->buf + out->len, buf, len );
+    out->len += len;
+
+    return( (int) len );
+}
+
+static int bench_recv( void *ctx, unsigned char *buf, size_t len )
+{
+    bench_bio *in = ( (bench_link *) ctx )->in;
+
+    if( in->len == 0 )
+        return( MBEDTLS_ERR_SSL_WANT_READ );
+    if( len > in->len )
+        len = in->len;
+
+    memcpy( buf, in->buf, len );
+    memmove( in->buf, in->buf + len, in->len - len );
+    in->len -= len;
+
+    return( (int) len );
+}
+
+typedef struct
+{
+    const char *name;
+    mbedtls_key_exchange_type_t key_exchange;
+    const char *crt;
+    const char *key;
+} bench_profile;
+
+static const bench_profile profiles[] =
+{
+#if defined(MBEDTLS_KEY_EXCHANGE_RSA_ENABLED)
+    { "RSA", MBEDTLS_KEY_EXCHANGE_RSA,
+      mbedtls_test_srv_crt_rsa, mbedtls_test_srv_key_rsa },
+#endif
+#if defined(MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED)
+    { "ECDHE-ECDSA", MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA,
+      mbedtls_test_srv_crt_ec, mbedtls_test_srv_key_ec },
+#endif
+    { NULL, MBEDTLS_KEY_EXCHANGE_NONE, NULL, NULL }
+};
+
+/*
+ * First ciphersuite of the default list using the given key exchange
+ */
+static int bench_pick_suite( mbedtls_key_exchange_type_t key_exchange )
+{
+    const int *id;
+    const mbedtls_ssl_ciphersuite_t *info;
+
+    for( id = mbedtls_ssl_list_ciphersuites(); *id != 0; id++ )
+    {
+        info = mbedtls_ssl_ciphersuite_from_id( *id );
+        if( info != NULL && info->key_exchange == key_exchange )
+            return( *id );
+    }
+
+    return( 0 );
+}
+
+typedef struct
+{
+    unsigned long ticks[2];
+    size_t peak[2];
+} bench_result;
+
+/*
+ * One complete handshake with fresh contexts on both sides. The peak heap
+ * covers everything the side holds, certificate and key included.
+ */
+static int bench_handshake( const bench_profile *prof, const int *suites,
+                            mbedtls_ctr_drbg_context *ctr_drbg,
+                            bench_result *res )
+{
+    int ret, side, done[2] = { 0, 0 };
+    unsigned long start;
+    mbedtls_ssl_config conf[2];
+    mbedtls_ssl_context ssl[2];
+    mbedtls_x509_crt srvcert;
+    mbedtls_pk_context pkey;
+    static bench_bio c2s, s2c;
+    bench_link link[2];
+
+    memset( res, 0, sizeof( *res ) );
+    c2s.len = s2c.len = 0;
+    link[SIDE_CLI].in = &s2c;
+    link[SIDE_CLI].out = &c2s;
+    link[SIDE_SRV].in = &c2s;
+    link[SIDE_SRV].out = &s2c;
+
+    for( side = SIDE_CLI; side <= SIDE_SRV; side++ )
+    {
+        heap_peak[side] = heap_cur[side];
+        res->peak[side] = heap_cur[side];
+    }
+
+    cur_side = SIDE_SRV;
+    mbedtls_x509_crt_init( &srvcert );
+    mbedtls_pk_init( &pkey );
+
+    for( side = SIDE_CLI; side <= SIDE_SRV; side++ )
+    {
+        cur_side = side;
+        mbedtls_ssl_init( &ssl[side] );
+        mbedtls_ssl_config_init( &conf[side] );
+    }
+
+    cur_side = SIDE_SRV;
+    start = mbedtls_timing_hardclock();
+    if( ( ret = mbedtls_x509_crt_parse( &srvcert,
+                    (const unsigned char *) prof->crt,
+                    strlen( prof->crt ) + 1 ) ) != 0 ||
+        ( ret = mbedtls_pk_parse_key( &pkey,
+                    (const unsigned char *) prof->key,
+                    strlen( prof->key ) + 1, NULL, 0 ) ) != 0 )
+        goto exit;
+    res->ticks[SIDE_SRV] += mbedtls_timing_hardclock() - start;
+
+    for( side = SIDE_CLI; side <= SIDE_SRV; side++ )
+    {
+        cur_side = side;
+        if( ( ret = mbedtls_ssl_config_defaults( &conf[side],
+                        side == SIDE_CLI ? MBEDTLS_SSL_IS_CLIENT :
+                                           MBEDTLS_SSL_IS_SERVER,
+                        MBEDTLS_SSL_TRANSPORT_STREAM,
+                        MBEDTLS_SSL_PRESET_DEFAULT ) ) != 0 )
+            goto exit;
+
+        /* No CA chain in the test certificates shared by both curves */
+        mbedtls_ssl_conf_authmode( &conf[side], MBEDTLS_SSL_VERIFY_NONE );
+        mbedtls_ssl_conf_rng( &conf[side], mbedtls_ctr_drbg_random, ctr_drbg );
+        mbedtls_ssl_conf_ciphersuites( &conf[side], suites );
+
+        if( side == SIDE_SRV &&
+            ( ret = mbedtls_ssl_conf_own_cert( &conf[side],
+                                               &srvcert, &pkey ) ) != 0 )
+            goto exit;
+
+        if( ( ret = mbedtls_ssl_setup( &ssl[side], &conf[side] ) ) != 0 )
+            goto exit;
+
+        mbedtls_ssl_set_bio( &ssl[side], &link[side],
+                             bench_send, bench_recv, NULL );
+    }
+
+    while( !done[SIDE_CLI] || !done[SIDE_SRV] )
+    {
+        for( side = SIDE_CLI; side <= SIDE_SRV; side++ )
+        {
+            if( done[side] )
+                continue;
+
+            cur_side = side;
+            start = mbedtls_timing_hardclock();
+            ret = mbedtls_ssl_handshake( &ssl[side] );
+            res->ticks[side] += mbedtls_timing_hardclock() - start;
+
+            if( ret == 0 )
+                done[side] = 1;
+            else if( ret != MBEDTLS_ERR_SSL_WANT_READ &&
+                     ret != MBEDTLS_ERR_SSL_WANT_WRITE )
+                goto exit;
+        }
+    }
+
+    ret = 0;
+
+exit:
+    for( side = SIDE_CLI; side <= SIDE_SRV; side++ )
+        res->peak[side] = heap_peak[side];
+
+    for( side = SIDE_CLI; side <= SIDE_SRV; side++ )
+    {
+        cur_side = side;
+        mbedtls_ssl_free( &ssl[side] );
+        mbedtls_ssl_config_free( &conf[side] );
+    }
+
+    cur_side = SIDE_SRV;
+    mbedtls_x509_crt_free( &srvcert );
+    mbedtls_pk_free( &pkey );
+
+    return( ret );
+}
+
+int main( int argc, char *argv[] )
+{
+    int ret = 1, i, count = DFL_COUNT;
+    int exit_code = MBEDTLS_EXIT_FAILURE;
+    int suites[2] = { 0, 0 };
+    const bench_profile *prof;
+    const char *pers = "ssl_hs_bench";
+    unsigned long ticks[2];
+    size_t peak[2];
+    bench_result res;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+
+    if( argc > 1 && ( count = atoi( argv[1] ) ) < 1 )
+    {
+        mbedtls_printf( "usage: %s [count]\n", argv[0] );
+        goto exit;
+    }
+
+    mbedtls_platform_set_calloc_free( bench_calloc, bench_free );
+
+    mbedtls_entropy_init( &entropy );
+    mbedtls_ctr_drbg_init( &ctr_drbg );
+
+    if( ( ret = mbedtls_ctr_drbg_seed( &ctr_drbg, mbedtls_entropy_func,
+                    &entropy, (const unsigned char *) pers,
+                    strlen( pers ) ) ) != 0 )
+    {
+        mbedtls_printf( " failed\n  ! mbedtls_ctr_drbg_seed returned -0x%x\n",
+                        -ret );
+        goto exit;
+    }
+
+    mbedtls_printf( "\n  %-12s  %-44s  %12s  %12s  %9s  %9s\n",
+                    "key exchange", "ciphersuite", "cli ticks", "srv ticks",
+                    "cli heap", "srv heap" );
+
+    for( prof = profiles; prof->name != NULL; prof++ )
+    {
+        if( ( suites[0] = bench_pick_suite( prof->key_exchange ) ) == 0 )
+        {
+            mbedtls_printf( "  %-12s  no ciphersuite enabled\n", prof->name );
+            continue;
+        }
+
+        ticks[SIDE_CLI] = ticks[SIDE_SRV] = 0;
+        peak[SIDE_CLI] = peak[SIDE_SRV] = 0;
+
+        for( i = 0; i < count; i++ )
+        {
+            if( ( ret = bench_handshake( prof, suites, &ctr_drbg, &res ) ) != 0 )
+            {
+#if defined(MBEDTLS_ERROR_C)
+                char error_buf[100];
+                mbedtls_strerror( ret, error_buf, sizeof( error_buf ) );
+                mbedtls_printf( "  %-12s  handshake failed: -0x%x - %s\n",
+                                prof->name, -ret, error_buf );
+#else
+                mbedtls_printf( "  %-12s  handshake failed: -0x%x\n",
+                                prof->name, -ret );
+#endif
+                goto exit;
+            }
+
+            ticks[SIDE_CLI] += res.ticks[SIDE_CLI];
+            ticks[SIDE_SRV] += res.ticks[SIDE_SRV];
+            if( res.peak[SIDE_CLI] > peak[SIDE_CLI] )
+                peak[SIDE_CLI] = res.peak[SIDE_CLI];
+            if( res.peak[SIDE_SRV] > peak[SIDE_SRV] )
+                peak[SIDE_SRV] = res.peak[SIDE_SRV];
+        }
+
+        mbedtls_printf( "  %-12s  %-44s  %12lu  %12lu  %9u  %9u\n",
+                        prof->name, mbedtls_ssl_get_ciphersuite_name( suites[0] ),
+                        ticks[SIDE_CLI] / count, ticks[SIDE_SRV] / count,
+                        (unsigned) peak[SIDE_CLI], (unsigned) peak[SIDE_SRV] );
+    }
+
+    mbedtls_printf( "\n  ticks: mean per handshake, heap: peak bytes\n\n" );
+
+    exit_code = MBEDTLS_EXIT_SUCCESS;
+
+exit:
+    mbedtls_ctr_drbg_free( &ctr_drbg );
+    mbedtls_entropy_free( &entropy );
+
+#if defined(_WIN32)
+    mbedtls_printf( "  + Press Enter to exit this program.\n" );
+    fflush( stdout ); getchar();
+#endif
+
+    return( exit_code );
+}
+#endif /* MBEDTLS_ENTROPY_C && MBEDTLS_CTR_DRBG_C && MBEDTLS_SSL_TLS_C &&
+          MBEDTLS_SSL_CLI_C && MBEDTLS_SSL_SRV_C && MBEDTLS_CERTS_C &&
+          MBEDTLS_PEM_PARSE_C && MBEDTLS_X509_CRT_PARSE_C && MBEDTLS_TIMING_C &&
+          MBEDTLS_PLATFORM_MEMORY */
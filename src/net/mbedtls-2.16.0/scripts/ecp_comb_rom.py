@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""
+This file is part of Mbed TLS (https://tls.mbed.org)
+
+Purpose
+
+Generate library/ecp_comb_rom.c, the fixed-base comb tables for the curve
+generators used by ecp_mul_comb() when MBEDTLS_ECP_COMB_ROM_TABLES is set.
+
+The tables hold the same points ecp_precompute_comb() would compute for
+P = G with window w and d = ceil(nbits / w), already normalized:
+
+    T[i] = G + sum over bits b set in i of 2^((b + 1) * d) G
+
+so they can be selected by ecp_select_comb() exactly like a RAM table.
+
+Usage: scripts/ecp_comb_rom.py > library/ecp_comb_rom.c
+"""
+
+import sys
+
+CURVES = [
+    # name, macro, nbits, p, a, gx, gy, w
+    ("secp256r1", "MBEDTLS_ECP_DP_SECP256R1", 256,
+     0xFFFFFFFF00000001000000000000000000000000FFFFFFFFFFFFFFFFFFFFFFFF,
+     -3,
+     0x6B17D1F2E12C4247F8BCE6E563A440F277037D812DEB33A0F4A13945D898C296,
+     0x4FE342E2FE1A7F9B8EE7EB4A7C0F9E162BCE33576B315ECECBB6406837BF51F5,
+     6),
+]
+
+
+def add(pt1, pt2, p, a):
+    """Affine point addition, None is the point at infinity"""
+    if pt1 is None:
+        return pt2
+    if pt2 is None:
+        return pt1
+    x1, y1 = pt1
+    x2, y2 = pt2
+    if x1 == x2:
+        if (y1 + y2) % p == 0:
+            return None
+        lam = (3 * x1 * x1 + a) * pow(2 * y1, p - 2, p) % p
+    else:
+        lam = (y2 - y1) * pow(x2 - x1, p - 2, p) % p
+    x3 = (lam * lam - x1 - x2) % p
+    return (x3, (lam * (x1 - x3) - y1) % p)
+
+
+def double_n(pt, n, p, a):
+    for _ in range(n):
+        pt = add(pt, pt, p, a)
+    return pt
+
+
+def comb_table(nbits, p, a, g, w):
+    d = (nbits + w - 1) // w
+    base = [g]
+    for _ in range(w - 1):
+        base.append(double_n(base[-1], d, p, a))
+    table = []
+    for i in range(1 << (w - 1)):
+        pt = g
+        for b in range(w - 1):
+            if i & (1 << b):
+                pt = add(pt, base[b + 1], p, a)
+        table.append(pt)
+    return table
+
+
+def limbs(value, nbits):
+    """BYTES_TO_T_UINT_8() lines, least significant byte first"""
+    data = value.to_bytes(nbits // 8, "little")
+    lines = []
+    for off in range(0, len(data), 8):
+        args = ", ".join("0x%02X" % c for c in data[off:off + 8])
+        lines.append("    BYTES_TO_T_UINT_8( %s )," % args)
+    return "\n".join(lines)
+
+
+HEADER = """/*
+ *  Fixed-base comb tables for the elliptic curve generators, kept in ROM
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+/*
+ * Generated by scripts/ecp_comb_rom.py, do not edit.
+ *
+ * Each table is the one ecp_precompute_comb() builds for P = G, already
+ * normalized. Z is left unset, which ecp_add_mixed() reads as Z = 1.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_ECP_C) && defined(MBEDTLS_ECP_COMB_ROM_TABLES)
+
+#include "mbedtls/ecp.h"
+#include "mbedtls/ecp_internal.h"
+
+#include <stddef.h>
+
+#if !defined(MBEDTLS_ECP_ALT)
+
+#if defined(MBEDTLS_HAVE_INT32)
+
+#define BYTES_TO_T_UINT_4( a, b, c, d )             \\
+    ( (mbedtls_mpi_uint) a <<  0 ) |                \\
+    ( (mbedtls_mpi_uint) b <<  8 ) |                \\
+    ( (mbedtls_mpi_uint) c << 16 ) |                \\
+    ( (mbedtls_mpi_uint) d << 24 )
+
+#define BYTES_TO_T_UINT_8( a, b, c, d, e, f, g, h ) \\
+    BYTES_TO_T_UINT_4( a, b, c, d ),                \\
+    BYTES_TO_T_UINT_4( e, f, g, h )
+
+#else /* 64-bits */
+
+#define BYTES_TO_T_UINT_8( a, b, c, d, e, f, g, h ) \\
+    ( (mbedtls_mpi_uint) a <<  0 ) |                \\
+    ( (mbedtls_mpi_uint) b <<  8 ) |                \\
+    ( (mbedtls_mpi_uint) c << 16 ) |                \\
+    ( (mbedtls_mpi_uint) d << 24 ) |                \\
+    ( (mbedtls_mpi_uint) e << 32 ) |                \\
+    ( (mbedtls_mpi_uint) f << 40 ) |                \\
+    ( (mbedtls_mpi_uint) g << 48 ) |                \\
+    ( (mbedtls_mpi_uint) h << 56 )
+
+#endif /* bits in mbedtls_mpi_uint */
+
+#define ECP_ROM_MPI( a )                                            \\
+    { 1, sizeof( a ) / sizeof( mbedtls_mpi_uint ), (mbedtls_mpi_uint *) a }
+
+#define ECP_ROM_POINT( x, y )                                       \\
+    { ECP_ROM_MPI( x ), ECP_ROM_MPI( y ), { 1, 0, NULL } }
+"""
+
+FOOTER = """
+/*
+ * Comb table for the generator of grp, NULL if there is none in ROM
+ */
+const mbedtls_ecp_point *mbedtls_internal_ecp_comb_rom( const mbedtls_ecp_group *grp,
+                                                       unsigned char *w )
+{
+    switch( grp->id )
+    {
+%s
+        default:
+            return( NULL );
+    }
+}
+
+#endif /* !MBEDTLS_ECP_ALT */
+
+#endif /* MBEDTLS_ECP_C && MBEDTLS_ECP_COMB_ROM_TABLES */
+"""
+
+
+def main():
+    out = [HEADER]
+    cases = []
+    for name, macro, nbits, p, a, gx, gy, w in CURVES:
+        table = comb_table(nbits, p, a, (gx, gy), w)
+        out.append("#if defined(%s_ENABLED)" % macro)
+        out.append("/* w = %d, d = %d */" % (w, (nbits + w - 1) // w))
+        for i, (x, y) in enumerate(table):
+            out.append("static const mbedtls_mpi_uint %s_T_%d_X[] = {" % (name, i))
+            out.append(limbs(x, nbits))
+            out.append("};")
+            out.append("static const mbedtls_mpi_uint %s_T_%d_Y[] = {" % (name, i))
+            out.append(limbs(y, nbits))
+            out.append("};")
+        out.append("static const mbedtls_ecp_point %s_T[%d] = {" % (name, len(table)))
+        for i in range(len(table)):
+            out.append("    ECP_ROM_POINT( %s_T_%d_X, %s_T_%d_Y )," % (name, i, name, i))
+        out.append("};")
+        out.append("#endif /* %s_ENABLED */" % macro)
+        cases.append("#if defined(%s_ENABLED)\n"
+                     "        case %s:\n"
+                     "            *w = %d;\n"
+                     "            return( %s_T );\n"
+                     "#endif" % (macro, macro, w, name))
+    out.append(FOOTER % "\n".join(cases))
+    sys.stdout.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
@@ -54,6 +54,16 @@
 
 #define NOPOLL_DELIVER_PONG_FRAME  0
 
+/* Unmasked frames with at least this much payload are sent without
+ * being copied, as a header write plus a payload write. Smaller ones
+ * are assembled and sent in one write: lwIP outputs every write as
+ * its own segment, and TCP_NODELAY is set on client sockets, so a
+ * split frame would take two segments (or stall on Nagle and the
+ * delayed ACK when it is not set). */
+#ifndef NOPOLL_SEND_GATHER_MIN
+#define NOPOLL_SEND_GATHER_MIN     1460
+#endif
+
 /**
  * @brief Allows to enable/disable non-blocking/blocking behavior on
  * the provided socket.
@@ -3211,18 +3221,74 @@ void nopoll_conn_complete_handshake (noPollConn * conn)
 	return;
 }
 
-void nopoll_conn_mask_content (noPollCtx * ctx, char * payload, int payload_size, char * mask, int desp)
+/**
+ * @internal Returns the mask as it applies to the 4 bytes found at
+ * payload offset desp (that is, rotated by desp % 4), laid out in
+ * memory order so it can be xored against a word read from the
+ * payload on any endianness.
+ */
+static uint32_t __nopoll_conn_mask_key (const char * mask, int desp)
 {
-	int iter       = 0;
-	int mask_index = 0;
+	char     key[4];
+	uint32_t value;
+	int      iter;
+
+	for (iter = 0; iter < 4; iter++)
+		key[iter] = mask[(desp + iter) & 3];
+	memcpy (&value, key, 4);
+
+	return value;
+}
 
-	while (iter < payload_size) {
-		/* rotate mask and apply it */
-		mask_index = (iter + desp) % 4;
-		payload[iter] ^= mask[mask_index];
+/**
+ * @internal Copies size bytes from src into dest applying the
+ * provided mask, src and dest may be the same buffer. desp is the
+ * offset of src inside the frame payload, which selects the mask byte
+ * to start with. Bytes are handled one by one only until dest is word
+ * aligned, then 32 bits at a time.
+ */
+static void __nopoll_conn_mask_copy (char * dest, const char * src, int size, const char * mask, int desp)
+{
+	uint32_t key;
+	uint32_t word[4];
+	int      iter = 0;
+
+	while (iter < size && ((long) (dest + iter) & 3)) {
+		dest[iter] = src[iter] ^ mask[(iter + desp) & 3];
 		iter++;
 	} /* end while */
 
+	/* dest is aligned now, rotate the mask to the current offset */
+	key = __nopoll_conn_mask_key (mask, iter + desp);
+	while (iter + 16 <= size) {
+		memcpy (word, src + iter, 16);
+		word[0] ^= key;
+		word[1] ^= key;
+		word[2] ^= key;
+		word[3] ^= key;
+		memcpy (dest + iter, word, 16);
+		iter += 16;
+	} /* end while */
+	while (iter + 4 <= size) {
+		memcpy (word, src + iter, 4);
+		word[0] ^= key;
+		memcpy (dest + iter, word, 4);
+		iter += 4;
+	} /* end while */
+
+	while (iter < size) {
+		dest[iter] = src[iter] ^ mask[(iter + desp) & 3];
+		iter++;
+	} /* end while */
+
+	return;
+}
+
+void nopoll_conn_mask_content (noPollCtx * ctx, char * payload, int payload_size, char * mask, int desp)
+{
+	/* unmask in place */
+	__nopoll_conn_mask_copy (payload, payload, payload_size, mask, desp);
+
 	return;
 }
 
@@ -4550,6 +4616,49 @@ int nopoll_conn_flush_writes (noPollConn * conn, long timeout, int previous_resu
 }
 
 
+/**
+ * @internal Writes the frame made of header and payload, starting at
+ * frame offset desp, straight from both buffers without assembling
+ * them first. This takes two writes, so the header usually leaves in
+ * a segment of its own (MSG_MORE only merges them where the stack
+ * honours it, lwIP 1.4.1 does not). Only used for payloads of at least
+ * NOPOLL_SEND_GATHER_MIN bytes, which span several segments anyway.
+ *
+ * @return Bytes written (header included) or the send(2) result if
+ * nothing was written.
+ */
+static int __nopoll_conn_send_gather (noPollConn * conn, const char * header, int header_size,
+				      const char * payload, long length, int desp)
+{
+	int written = 0;
+	int res;
+
+	if (desp < header_size) {
+#if defined(NOPOLL_LWIP)
+		res = lwip_send (conn->session, header + desp, header_size - desp, length > 0 ? MSG_MORE : 0);
+#elif defined(MSG_MORE)
+		res = send (conn->session, header + desp, header_size - desp, length > 0 ? MSG_MORE : 0);
+#else
+		res = send (conn->session, header + desp, header_size - desp, 0);
+#endif
+		if (res <= 0 || desp + res < header_size || length == 0)
+			return res;
+		written = res;
+		desp    = header_size;
+	} /* end if */
+
+	desp -= header_size;
+#if defined(NOPOLL_LWIP)
+	res = lwip_send (conn->session, payload + desp, length - desp, 0);
+#else
+	res = send (conn->session, payload + desp, length - desp, 0);
+#endif
+	if (res < 0)
+		return written > 0 ? written : res;
+
+	return written + res;
+}
+
 /**
  * @internal Function used to send a frame over the provided
  * connection.
@@ -4583,7 +4692,9 @@ int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool mask
 {
 	char               header[14];
 	int                header_size;
-	char             * send_buffer;
+	char             * send_buffer = NULL;
+	char             * frame       = NULL;
+	nopoll_bool        gather;
 	int                bytes_written = 0;
 	int                bytes_sent    = 0;
 	char               mask[4];
@@ -4665,30 +4776,39 @@ int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool mask
 		header_size += 4;
 	} /* end if */
 
-	/* allocate enough memory to send content */
-	send_buffer = nopoll_new (char, length + header_size + 2);
-	if (send_buffer == NULL) {
-		nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Unable to allocate memory to implement send operation");
-		return -1;
-	} /* end if */
-
-	/* copy content to be sent */
-	nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "Copying into the buffer %d bytes of header (total memory allocated: %d)",
-		    header_size, (int) length + header_size + 1);
-	memcpy (send_buffer, header, header_size);
-	if (length > 0) {
-		memcpy (send_buffer + header_size, content, length);
-
-		/* mask content before sending if requested */
-		if (masked) {
-			nopoll_conn_mask_content (conn->ctx, send_buffer + header_size, length, mask, 0);
-		}
+	/* large unmasked content over a plain socket is written from
+	   the caller buffer right after the header, without copying it */
+	gather = ! masked && length >= NOPOLL_SEND_GATHER_MIN &&
+		conn->send == nopoll_conn_default_send &&
+		sleep_in_header == 0 && conn->__force_stop_after_header == 0;
+
+	if (! gather) {
+		/* allocate enough memory to send content, placing the
+		   header so the payload is word aligned for masking */
+		desp        = (4 - (header_size & 3)) & 3;
+		send_buffer = nopoll_new (char, desp + length + header_size + 2);
+		if (send_buffer == NULL) {
+			nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Unable to allocate memory to implement send operation");
+			return -1;
+		} /* end if */
+		frame = send_buffer + desp;
+
+		/* copy content to be sent */
+		nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "Copying into the buffer %d bytes of header (total memory allocated: %d)",
+			    header_size, (int) length + header_size + desp + 2);
+		memcpy (frame, header, header_size);
+		if (length > 0) {
+			/* mask content while copying it if requested */
+			if (masked)
+				__nopoll_conn_mask_copy (frame + header_size, content, length, mask, 0);
+			else
+				memcpy (frame + header_size, content, length);
+		} /* end if */
 	} /* end if */
 
-
 	/* send content */
-	nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "Mask used for this delivery: %d (about to send %d bytes)",
-		    nopoll_get_32bit (send_buffer + header_size - 2), (int) length + header_size);
+	nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "Mask used for this delivery: %u (about to send %d bytes)",
+		    mask_value, (int) length + header_size);
 
 	/* clear errno status before writting */
 	desp  = 0;
@@ -4700,7 +4820,7 @@ int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool mask
 		nopoll_log (conn->ctx, NOPOLL_LEVEL_WARNING, "Sending broken header (just %d bytes) and implement a pause on purpose...", conn->__force_stop_after_header);
 
 		/* send just 2 bytes for the header and then implement a very long pause */
-		bytes_written = conn->send (conn, send_buffer, conn->__force_stop_after_header);
+		bytes_written = conn->send (conn, frame, conn->__force_stop_after_header);
 		desp          = conn->__force_stop_after_header;
 		if (bytes_written != conn->__force_stop_after_header) {
 			nopoll_log (conn->ctx, NOPOLL_LEVEL_WARNING, "Requested to write %d bytes for the header but %d were written",
@@ -4716,17 +4836,19 @@ int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool mask
 
 	while (nopoll_true) {
 		/* try to write bytes */
-		if (sleep_in_header == 0) {
-			bytes_written = conn->send (conn, send_buffer + desp, length + header_size - desp);
+		if (gather) {
+			bytes_written = __nopoll_conn_send_gather (conn, header, header_size, content, length, desp);
+		} else if (sleep_in_header == 0) {
+			bytes_written = conn->send (conn, frame + desp, length + header_size - desp);
 		} else {
 			nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "Found sleep in header indication, sending header: %d bytes (waiting %ld)", header_size, sleep_in_header);
-			bytes_written = conn->send (conn, send_buffer, header_size);
+			bytes_written = conn->send (conn, frame, header_size);
 			if (bytes_written == header_size) {
 				/* sleep after header ... */
 				nopoll_sleep (sleep_in_header);
 
 				/* now send the rest of the content (without the header) */
-				bytes_written = conn->send (conn, send_buffer + header_size, length);
+				bytes_written = conn->send (conn, frame + header_size, length);
 				nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "Rest of content written %d (header size: %d, length: %d)",
 					    bytes_written, header_size, length);
 				bytes_written = length + header_size;
@@ -4734,6 +4856,7 @@ int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool mask
 			} else {
 				nopoll_log (conn->ctx, NOPOLL_LEVEL_WARNING, "Requested to write %d bytes for the header but %d were written",
 					    header_size, bytes_written);
+				nopoll_free (send_buffer);
 				return -1;
 			} /* end if */
 		} /* end if */
@@ -4814,12 +4937,31 @@ int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool mask
 #endif
 
 	/* check pending bytes for the next operation */
-	if (conn->pending_write_bytes > 0) {
+	if (conn->pending_write_bytes > 0 && gather) {
+		/* only now the rest of the frame has to be copied since
+		   the caller owns the payload */
+		conn->pending_write = nopoll_new (char, conn->pending_write_bytes);
+		if (conn->pending_write == NULL) {
+			nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Unable to allocate memory to store %d pending bytes",
+				    conn->pending_write_bytes);
+			conn->pending_write_bytes = 0;
+			return -1;
+		} /* end if */
+		conn->pending_write_desp = 0;
+		if (desp < header_size) {
+			memcpy (conn->pending_write, header + desp, header_size - desp);
+			memcpy (conn->pending_write + header_size - desp, content, length);
+		} else {
+			memcpy (conn->pending_write, (const char *) content + desp - header_size, conn->pending_write_bytes);
+		} /* end if */
+		nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "Stored %d bytes starting from %d out of %d bytes (header size: %d)",
+			    conn->pending_write_bytes, desp, length + header_size, header_size);
+	} else if (conn->pending_write_bytes > 0) {
 		conn->pending_write = send_buffer;
-		conn->pending_write_desp = desp;
+		conn->pending_write_desp = frame - send_buffer + desp;
 		nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "Stored %d bytes starting from %d out of %d bytes (header size: %d)",
 			    conn->pending_write_bytes, desp, length + header_size, header_size);
-	} else {
+	} else if (send_buffer != NULL) {
 		/* release memory */
 		nopoll_free (send_buffer);
 	} /* end if */
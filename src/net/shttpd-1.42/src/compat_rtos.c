@@ -34,6 +34,8 @@ struct local {
 	const char      *name;
 	char            *body;
 	unsigned long	mode;
+	unsigned long	size;
+	unsigned long	tag;		/* 0: not hashed yet */
 };
 
 struct llhead	registered_file;
@@ -83,8 +85,11 @@ void _shttpd_init_local_file(const struct usr_file *list, int count)
 			file->name = list[i].name;
 			file->mode = (file->name[strlen(file->name)-1]
 				             == '/')? _S_IFDIR : _S_IFREG;
-			if (file->mode == _S_IFREG)
+			if (file->mode == _S_IFREG) {
 				file->body = list[i].body;
+				file->size = list[i].size ? list[i].size :
+				                            strlen(file->body);
+			}
 		} else
 			break;
 		LL_ADD(&registered_file, &file->link);
@@ -150,6 +155,24 @@ int _shttpd_lookup_file(struct local **file, const char *name)
 	return -1;
 }
 
+/*
+ * FNV-1a over the body. The files never change at run time, so the hash is
+ * taken once, on the first request, and makes a stable ETag.
+ */
+static unsigned long _shttpd_file_tag(struct local *file)
+{
+	const unsigned char *p = (const unsigned char *)file->body;
+	const unsigned char *e = p + file->size;
+	unsigned long h = 2166136261UL;
+
+	if (file->tag != 0)
+		return file->tag;
+	while (p < e)
+		h = (h ^ *p++) * 16777619UL;
+	file->tag = h ? h : 1;
+	return file->tag;
+}
+
 void _shttpd_set_close_on_exec(int fd)
 {
 }
@@ -162,10 +185,13 @@ int _shttpd_stat(const char *path, struct stat *stp)
 		return -1;
 	 }
 	stp->st_mode = file->mode;
-	if (stp->st_mode == _S_IFREG)
-		stp->st_size = strlen(file->body);
-	else
+	if (stp->st_mode == _S_IFREG) {
+		stp->st_size = file->size;
+		stp->st_tag = _shttpd_file_tag(file);
+	} else {
 		stp->st_size = 0;
+		stp->st_tag = 0;
+	}
 	return 0;
 }
 
@@ -101,6 +101,21 @@ read_file(struct stream *stream, void *buf, size_t len)
 #endif
 }
 
+#if !defined(SHTTPD_FS)
+/*
+ * The file body is already in memory (usually XIP flash), so it can be
+ * given to the socket as it is, without going through the stream buffer.
+ */
+static const char *
+map_file(struct stream *stream, size_t *len)
+{
+	const char *fp = (const char *)stream->conn->loc.chan.fh;
+
+	*len = stream->content_len - stream->io.total;
+	return (fp + stream->io.total);
+}
+#endif /* !SHTTPD_FS */
+
 static void
 close_file(struct stream *stream)
 {
@@ -113,10 +128,93 @@ close_file(struct stream *stream)
 #endif
 }
 
+/*
+ * Check If-None-Match: against our ETag. The list may hold several
+ * quoted tags, weak ones included, or "*".
+ */
+static int
+match_etag(const struct vec *inm, const char *etag)
+{
+	const char	*s = inm->ptr, *e = inm->ptr + inm->len;
+	size_t		len = strlen(etag);
+
+	for (; s < e; s++) {
+		if (*s == '*')
+			return (TRUE);
+		if (*s == '"' && (size_t)(e - s) >= len + 2 &&
+		    !memcmp(s + 1, etag, len) && s[len + 1] == '"')
+			return (TRUE);
+	}
+
+	return (FALSE);
+}
+
+/*
+ * Return TRUE if Accept-Encoding: lists gzip, and not with q=0
+ */
+static int
+accepts_gzip(const struct vec *ae)
+{
+	const char	*s = ae->ptr, *e = ae->ptr + ae->len, *p;
+
+	for (; s + 4 <= e; s++) {
+		if (_shttpd_strncasecmp(s, "gzip", 4) != 0 ||
+		    (s > ae->ptr && isalnum(*(unsigned char *) (s - 1))))
+			continue;
+		for (p = s + 4; p < e && *p == ' '; p++);
+		if (p < e && *p == ';') {
+			while (p < e && *p != '=')
+				p++;
+			if (p < e && strtod(p + 1, NULL) == 0)
+				return (FALSE);
+		}
+		return (TRUE);
+	}
+
+	return (FALSE);
+}
+
+/*
+ * If the client takes gzip and "path.gz" exists, open it in place of
+ * path. The mime type still comes from the URI, not from the .gz name.
+ * Return TRUE if the compressed variant is opened.
+ */
+int
+_shttpd_open_gzip(struct conn *c, char *path, size_t maxpath,
+		struct stat *stp)
+{
+	struct stat	st;
+	size_t		len = strlen(path);
+	int		ok = FALSE;
+
+	if (c->ch.ae.v_vec.len == 0 || !accepts_gzip(&c->ch.ae.v_vec) ||
+	    len + 4 > maxpath)
+		return (FALSE);
+
+	(void) memcpy(path + len, ".gz", 4);
+	if (_shttpd_stat(path, &st) == 0 && !S_ISDIR(st.st_mode)) {
+#if defined(SHTTPD_FS)
+		if ((c->loc.chan.fd = _shttpd_open(path,
+		    O_RDONLY | O_BINARY, 0644)) != -1)
+#else
+		if ((c->loc.chan.fh = (unsigned int)_shttpd_open(path, 0, 0)) != 0)
+#endif
+		{
+			*stp = st;
+			c->gzipped = TRUE;
+			ok = TRUE;
+		}
+	}
+	path[len] = '\0';
+
+	return (ok);
+}
+
 void
 _shttpd_get_file(struct conn *c, struct stat *stp)
 {
 	char		date[64], lm[64], etag[64], range[64] = "";
+	const char	*conn_hdr = "", *enc_hdr = "";
 	size_t	 status = 200;
 	const char	*fmt = "%a, %d %b %Y %H:%M:%S GMT", *msg = "OK";
 	big_int_t	cl = 0; /* Content-Length */
@@ -158,8 +256,28 @@ _shttpd_get_file(struct conn *c, struct stat *stp)
 	    (unsigned long) stp->st_mtime, (unsigned long) stp->st_size);
 #else
 	(void) _shttpd_snprintf(etag, sizeof(etag), "%lx.%lx",
-		(unsigned long)_shttpd_current_time, (unsigned long) stp->st_size);
+		(unsigned long) stp->st_tag, (unsigned long) stp->st_size);
 #endif
+	if (c->gzipped)
+		enc_hdr = "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n";
+	/* HTTP/1.1 is persistent by default, 1.0 has to be told */
+	if (c->keep_alive && c->minor_version == 0)
+		conn_hdr = "Connection: keep-alive\r\n";
+
+	if (c->ch.inm.v_vec.len > 0 && match_etag(&c->ch.inm.v_vec, etag)) {
+		c->loc.io.head = c->loc.headers_len = _shttpd_snprintf(
+		    c->loc.io.buf, c->loc.io.size,
+		    "HTTP/1.1 304 Not Modified\r\n"
+		    "Date: %s\r\n"
+		    "Etag: \"%s\"\r\n"
+		    "%s%s\r\n",
+		    date, etag, enc_hdr, conn_hdr);
+		c->status = 304;
+		c->loc.content_len = 0;
+		c->loc.io_class = &_shttpd_io_file;
+		_shttpd_stop_stream(&c->loc);
+		return;
+	}
 
 	/*
 	 * We do not do io_inc_head here, because it will increase 'total'
@@ -175,16 +293,16 @@ _shttpd_get_file(struct conn *c, struct stat *stp)
 	    "Content-Type: %.*s\r\n"
 	    "Content-Length: %lu\r\n"
 	    "Accept-Ranges: bytes\r\n"
-	    "%s\r\n",
+	    "%s%s%s\r\n",
 	    status, msg, date, lm, etag,
-	    c->mime_type.len, c->mime_type.ptr, cl, range);
+	    c->mime_type.len, c->mime_type.ptr, cl, enc_hdr, conn_hdr, range);
 
 	c->status = status;
 	c->loc.content_len = cl;
 	c->loc.io_class = &_shttpd_io_file;
 	c->loc.flags |= FLAG_R | FLAG_ALWAYS_READY;
 
-	if (c->method == METHOD_HEAD)
+	if (c->method == METHOD_HEAD || cl == 0)
 		_shttpd_stop_stream(&c->loc);
 }
 
@@ -192,5 +310,8 @@ const struct io_class	_shttpd_io_file =  {
 	"file",
 	read_file,
 	write_file,
-	close_file
+	close_file,
+#if !defined(SHTTPD_FS)
+	map_file
+#endif
 };
@@ -48,6 +48,8 @@ static const struct http_header http_headers[] = {
 	{7,  HDR_STRING, OFFSET(range),		"Range: "		},
 	{12, HDR_STRING, OFFSET(connection),	"Connection: "		},
 	{19, HDR_STRING, OFFSET(transenc),	"Transfer-Encoding: "	},
+	{15, HDR_STRING, OFFSET(inm),		"If-None-Match: "	},
+	{17, HDR_STRING, OFFSET(ae),		"Accept-Encoding: "	},
 	{0,  HDR_INT,	 0,			NULL			}
 };
 
@@ -268,6 +270,9 @@ _shttpd_send_server_error(struct conn *c, int status, const char *reason)
 	    status, reason, status);
 	c->loc.content_len = 10;
 	c->status = status;
+	/* No "Connection: keep-alive" for 1.0, and a 304 must not have a body */
+	if (c->minor_version == 0 || status == 304)
+		c->keep_alive = FALSE;
 	_shttpd_stop_stream(&c->loc);
 }
 
@@ -703,6 +708,8 @@ decide_what_to_do(struct conn *c)
 			_shttpd_do_ssi(c);
 		}
 #endif /* SHTTPD_SSI */
+	} else if (_shttpd_open_gzip(c, path, URI_MAX, &st)) {
+		_shttpd_get_file(c, &st);
 #if defined(SHTTPD_FS)
 	} else if (c->ch.ims.v_time && st.st_mtime <= c->ch.ims.v_time) {
 		_shttpd_send_server_error(c, 304, "Not Modified");
@@ -739,6 +746,21 @@ set_request_method(struct conn *c)
 	return (v->ptr == NULL);
 }
 
+/*
+ * HTTP/1.1 connections persist unless the client says "close",
+ * HTTP/1.0 ones only if the client asks for "keep-alive".
+ */
+static int
+want_keep_alive(const struct conn *c)
+{
+	const struct vec	*v = &c->ch.connection.v_vec;
+
+	if (c->major_version == 1 && c->minor_version >= 1)
+		return (!(v->len >= 5 && !_shttpd_strncasecmp(v->ptr, "close", 5)));
+	return (c->major_version == 1 &&
+	    v->len >= 10 && !_shttpd_strncasecmp(v->ptr, "keep-alive", 10));
+}
+
 static void
 parse_http_request(struct conn *c)
 {
@@ -814,6 +836,7 @@ parse_http_request(struct conn *c)
 		assert(c->rem.io.total >= (big_int_t) req_len);
 		c->rem.io.total -= req_len;
 		c->rem.content_len = c->ch.cl.v_big_int;
+		c->keep_alive = want_keep_alive(c);
 		decide_what_to_do(c);
 	}
 }
@@ -830,6 +853,7 @@ add_socket(struct worker *worker, int sock, int is_ssl)
 	struct conn		*c;
 	struct usa		sa;
 	int			l = IS_TRUE(ctx, OPT_INETD) ? E_FATAL : E_LOG;
+	int			on = 1;
 	l = l;
 #if defined(SHTTPD_SSL)
 	SSL_CTX        *ssl_ctx = ctx->ssl_ctx;
@@ -848,6 +872,12 @@ add_socket(struct worker *worker, int sock, int is_ssl)
 
 	sa.len = sizeof(sa.u.sin);
 	(void) _shttpd_set_non_blocking_mode(sock);
+	/*
+	 * Headers and body leave in separate writes, and the next reply on
+	 * a kept-alive connection must not wait for the delayed ACK.
+	 */
+	(void) setsockopt(sock, IPPROTO_TCP, TCP_NODELAY,
+	    (char *) &on, sizeof(on));
 
 	if (getpeername(sock, &sa.u.sa, &sa.len)) {
 		_shttpd_elog(E_LOG, NULL, "add_socket: %s", strerror(ERRNO));
@@ -1036,11 +1066,57 @@ write_stream(struct stream *from, struct stream *to)
 		_shttpd_stop_stream(to);
 }
 
+/*
+ * Send local content that is already in memory straight from there,
+ * the socket takes what it has room for.
+ */
+static void
+write_mapped(struct stream *from, struct stream *to)
+{
+	const char	*p;
+	size_t		len;
+	int		n;
+
+	p = from->io_class->io_map(from, &len);
+	assert(len > 0);
+
+	n = to->io_class->io_write(to, p, len);
+	to->conn->expire_time = _shttpd_current_time + EXPIRE_TIME;
+	DBG(("write_mapped (%d %s): written %d/%d bytes (ERRNO %d)",
+	    to->conn->rem.chan.sock, from->io_class->name, n, (int) len, ERRNO));
+	if (n > 0) {
+		from->io.total += n;
+		if (from->io.total >= from->content_len)
+			_shttpd_stop_stream(from);
+	} else if (n == -1 && (ERRNO == EINTR || ERRNO == EWOULDBLOCK))
+		n = n;	/* Ignore EINTR and EAGAIN */
+	else if (!(to->flags & FLAG_DONT_CLOSE))
+		_shttpd_stop_stream(to);
+}
+
+static int
+is_mapped(const struct stream *stream)
+{
+	return (stream->io_class != NULL && stream->io_class->io_map != NULL &&
+	    (stream->flags & FLAG_R));
+}
+
+/*
+ * Kept-alive connection waiting for its next request
+ */
+static int
+is_idle(const struct conn *c)
+{
+	return (c->num_requests > 0 && c->loc.io_class == NULL &&
+	    !(c->rem.flags & FLAG_HEADERS_PARSED) &&
+	    io_data_len(&c->rem.io) == 0 && io_data_len(&c->loc.io) == 0);
+}
+
 static void
 connection_desctructor(struct llhead *lp)
 {
 	struct conn		*c = LL_ENTRY(lp, struct conn, link);
-	static const struct vec	vec = {"close", 5};
+	size_t			n;
 	int			do_close;
 	DBG(("Disconnecting %d (%.*s)", c->rem.chan.sock,
 	    c->ch.connection.v_vec.len, c->ch.connection.v_vec.ptr));
@@ -1058,13 +1134,19 @@ connection_desctructor(struct llhead *lp)
 		c->loc.io_class->io_close(&c->loc);
 
 	/*
-	 * Check the "Connection: " header before we free c->request
-	 * If it its 'keep-alive', then do not close the connection
+	 * Keep the connection open only if the client wants it, the whole
+	 * request has been consumed and the reply, which had a length, has
+	 * been sent in full. free_list() detaches the connection first when
+	 * the worker goes away, then it is always closed.
 	 */
-	do_close = (c->ch.connection.v_vec.len >= vec.len &&
-	    !_shttpd_strncasecmp(vec.ptr,c->ch.connection.v_vec.ptr,vec.len)) ||
-	    (c->major_version < 1 ||
-	    (c->major_version >= 1 && c->minor_version < 1));
+	do_close = !c->keep_alive ||
+	    !(c->rem.flags & FLAG_HEADERS_PARSED) ||
+	    c->rem.content_len > 0 ||
+	    (c->rem.flags & FLAG_CLOSED) ||
+	    !(c->loc.flags & FLAG_CLOSED) || io_data_len(&c->loc.io) > 0 ||
+	    (c->loc.content_len == 0 && c->status != 304) ||
+	    _shttpd_current_time > c->expire_time ||
+	    LL_EMPTY(&c->link);
 
 	if (c->request)
 		_shttpd_free(c->request);
@@ -1078,21 +1160,38 @@ connection_desctructor(struct llhead *lp)
 	if (c->rem.io_class == NULL)
 		do_close = 1;
 
-	/* Keep the connection open only if we have Content-Length set */
-
-	if (!do_close && c->loc.content_len > 0) {
+	if (!do_close) {
 		DBG(("Keep connection.\n"));
 		c->loc.io_class = NULL;
 		c->loc.flags = 0;
 		c->loc.content_len = 0;
+		c->loc.headers_len = 0;
 		c->rem.flags = FLAG_W | FLAG_R | FLAG_SSL_ACCEPTED;
+		c->rem.content_len = 0;
+		c->rem.headers_len = 0;
+		/* Whatever is buffered belongs to the next request */
+		n = io_data_len(&c->rem.io);
+		if (c->rem.io.tail > 0) {
+			(void) memmove(c->rem.io.buf, io_data(&c->rem.io), n);
+			c->rem.io.tail = 0;
+			c->rem.io.head = n;
+		}
+		c->rem.io.total = n;
 		c->query = c->request = c->uri = c->path_info = NULL;
 		c->mime_type.len = 0;
+		c->status = 0;
+		c->keep_alive = c->gzipped = FALSE;
 		(void) memset(&c->ch, 0, sizeof(c->ch));
 		io_clear(&c->loc.io);
+		c->num_requests++;
 		c->birth_time = _shttpd_current_time;
+		c->expire_time = _shttpd_current_time + EXPIRE_TIME;
+		/*
+		 * A pipelined request is parsed on the next poll, which then
+		 * does not wait. Other connections get their turn in between.
+		 */
 		if (io_data_len(&c->rem.io) > 0)
-			process_connection(c, 0, 0);
+			c->rem.flags |= FLAG_PENDING;
 	} else {
 		DBG(("Destroy connection.\n"));
 		if (c->rem.io_class != NULL)
@@ -1146,7 +1245,11 @@ add_to_set(int fd, fd_set *set, int *max_fd)
 static void
 process_connection(struct conn *c, int remote_ready, int local_ready)
 {
+	int	mapped;
+
 	DBG(("process:remote_ready:%d,local_ready:%d\n",remote_ready,local_ready));
+	c->rem.flags &= ~FLAG_PENDING;
+
 	/* Read from remote end if it is ready */
 	if (remote_ready && io_space_len(&c->rem.io)) {
 		read_stream(&c->rem);
@@ -1160,8 +1263,20 @@ process_connection(struct conn *c, int remote_ready, int local_ready)
 	DBG(("rem: %d [%.*s]", (int) io_data_len(&c->rem.io),
 	    (int) io_data_len(&c->rem.io), io_data(&c->rem.io)));
 
+	/* A reply that has just been set up can be served right away */
+	if (c->loc.io_class != NULL && (c->loc.flags & FLAG_ALWAYS_READY))
+		local_ready = TRUE;
+
+	/*
+	 * Local content already in memory is not copied into the IO buffer,
+	 * unless all of it fits behind the headers to leave in one write.
+	 */
+	mapped = local_ready && is_mapped(&c->loc) &&
+	    (io_data_len(&c->loc.io) == 0 ||
+	    c->loc.content_len - c->loc.io.total > io_space_len(&c->loc.io));
+
 	/* Read from the local end if it is ready */
-	if (local_ready && io_space_len(&c->loc.io)) {
+	if (local_ready && !mapped && io_space_len(&c->loc.io)) {
 		read_stream(&c->loc);
 	}
 
@@ -1176,6 +1291,12 @@ process_connection(struct conn *c, int remote_ready, int local_ready)
 		write_stream(&c->loc, &c->rem);
 	}
 
+	if (mapped && io_data_len(&c->loc.io) == 0 && is_mapped(&c->loc) &&
+	    c->rem.io_class != NULL) {
+		DBG(("process:write mapped.(loc to rem)\n"));
+		write_mapped(&c->loc, &c->rem);
+	}
+
 	/* Check whether we should close this connection */
 	if ((_shttpd_current_time > c->expire_time) ||
 	    (c->rem.flags & FLAG_CLOSED) ||
@@ -1191,6 +1312,23 @@ num_workers(const struct shttpd_ctx *ctx)
 	return (p ? atoi(p) : 1);
 }
 
+#if defined(SHTTPD_SINGLE_CONNECTION)
+static void
+retire_idle_connections(struct worker *worker)
+{
+	struct llhead	*lp, *tmp;
+	struct conn	*c;
+
+	LL_FOREACH_SAFE(&worker->connections, lp, tmp) {
+		c = LL_ENTRY(lp, struct conn, link);
+		if (is_idle(c)) {
+			DBG(("Retire idle connection %d", c->rem.chan.sock));
+			connection_desctructor(&c->link);
+		}
+	}
+}
+#endif
+
 static void
 handle_connected_socket(struct shttpd_ctx *ctx,
 		struct usa *sap, int sock, int is_ssl)
@@ -1212,6 +1350,9 @@ handle_connected_socket(struct shttpd_ctx *ctx,
 		_shttpd_elog(E_FATAL, NULL, "only support one work.\n");
 #endif
 	} else {
+#if defined(SHTTPD_SINGLE_CONNECTION)
+		retire_idle_connections(first_worker(ctx));
+#endif
 		add_socket(first_worker(ctx), sock, is_ssl);
 	}
 }
@@ -1277,7 +1418,8 @@ multiplex_worker_sockets(const struct worker *worker, int *max_fd,
 		 * If there is some data read from local endpoint, check the
 		 * remote socket for write availability
 		 */
-		if (io_data_len(&c->loc.io) && !(c->loc.flags & FLAG_SUSPEND)) {
+		if ((io_data_len(&c->loc.io) || is_mapped(&c->loc)) &&
+		    !(c->loc.flags & FLAG_SUSPEND)) {
 #if defined(SHTTPD_FS)
 			add_to_set(c->rem.chan.fd, write_set, max_fd);
 #else
@@ -1286,13 +1428,18 @@ multiplex_worker_sockets(const struct worker *worker, int *max_fd,
 		}
 
 		/*
-		 * Set select wait interval to zero if FLAG_ALWAYS_READY set
+		 * Set select wait interval to zero if FLAG_ALWAYS_READY set.
+		 * Mapped content waits for the socket instead.
 		 */
 		if (io_space_len(&c->loc.io) && (c->loc.flags & FLAG_R) &&
-		    (c->loc.flags & FLAG_ALWAYS_READY)) {
+		    (c->loc.flags & FLAG_ALWAYS_READY) && !is_mapped(&c->loc)) {
 			nowait = TRUE;
 		}
 
+		/* Pipelined request is already here */
+		if (c->rem.flags & FLAG_PENDING)
+			nowait = TRUE;
+
 		if (io_data_len(&c->rem.io) && (c->loc.flags & FLAG_W) &&
 		    (c->loc.flags & FLAG_ALWAYS_READY)) {
 			nowait = TRUE;
@@ -1313,9 +1460,15 @@ shttpd_join(struct shttpd_ctx *ctx,
 	LL_FOREACH(&ctx->listeners, lp) {
 		l = LL_ENTRY(lp, struct listener, link);
 #if defined(SHTTPD_SINGLE_CONNECTION)
-		/* one connection exist, keep single worker single connection*/
+		/*
+		 * one connection exist, keep single worker single connection,
+		 * unless it is idle in keep-alive, then it gives way to a new
+		 * client, see retire_idle_connections()
+		 */
 		if (num_workers(ctx) == 1) {
-			if (LL_EMPTY(&(first_worker(ctx)->connections)) == 0)
+			struct llhead *conns = &first_worker(ctx)->connections;
+			if (!LL_EMPTY(conns) &&
+			    !is_idle(LL_ENTRY(conns->next, struct conn, link)))
 				break;
 		}
 #endif
@@ -1330,10 +1483,12 @@ shttpd_join(struct shttpd_ctx *ctx,
 }
 
 static void
-process_worker_sockets(struct worker *worker, fd_set *read_set)
+process_worker_sockets(struct worker *worker, fd_set *read_set,
+		fd_set *write_set)
 {
 	struct llhead	*lp, *tmp;
 	struct conn	*c;
+	int		remote_ready, local_ready;
 
 #if defined(SHTTPD_CONTROL_SOCKET)
 	int		cmd, skt[2], sock = worker->ctl[0];
@@ -1360,15 +1515,27 @@ process_worker_sockets(struct worker *worker, fd_set *read_set)
 	LL_FOREACH_SAFE(&worker->connections, lp, tmp) {
 
 		c = LL_ENTRY(lp, struct conn, link);
-		int remote_ready = FD_ISSET(c->rem.chan.sock, read_set);
-		process_connection(c, remote_ready,
-		    c->loc.io_class != NULL &&
+		remote_ready = FD_ISSET(c->rem.chan.sock, read_set);
+		local_ready = c->loc.io_class != NULL &&
 		    ((c->loc.flags & FLAG_ALWAYS_READY)
 #if defined(SHTTPD_CGI)
 		    || (c->loc.io_class == &_shttpd_io_cgi &&
 		     FD_ISSET(c->loc.chan.fd, read_set))
 #endif /* SHTTPD_CGI */
-		    ));
+		    );
+
+		/* Nothing happened to it, only see whether it has expired */
+		if (!remote_ready && !local_ready &&
+		    !FD_ISSET(c->rem.chan.sock, write_set) &&
+#if defined(SHTTPD_CGI)
+		    !(c->loc.io_class == &_shttpd_io_cgi &&
+		     FD_ISSET(c->loc.chan.fd, write_set)) &&
+#endif /* SHTTPD_CGI */
+		    !(c->rem.flags & FLAG_PENDING) &&
+		    _shttpd_current_time <= c->expire_time)
+			continue;
+
+		process_connection(c, remote_ready, local_ready);
 	}
 }
 
@@ -1409,7 +1576,7 @@ shttpd_poll(struct shttpd_ctx *ctx, int milliseconds)
 		} while (sock != -1);
 	}
 	if (num_workers(ctx) == 1)
-		process_worker_sockets(first_worker(ctx), &read_set);
+		process_worker_sockets(first_worker(ctx), &read_set, &write_set);
 }
 
 /*
@@ -1699,7 +1866,7 @@ poll_worker(struct worker *worker, int milliseconds)
 	if (do_select(max_fd, &read_set, &write_set, milliseconds) < 0)
 		return;;
 
-	process_worker_sockets(worker, &read_set);
+	process_worker_sockets(worker, &read_set, &write_set);
 }
 
 static void
@@ -31,15 +31,6 @@
 #include "debug.h"
 #include "arpping.h"
 
-/* args:	yiaddr - what IP to ping
- *		ip - our ip
- *		mac - our arp address
- *		interface - interface to use
- * retn: 	1 addr free
- *		0 addr used
- *		-1 error
- */
-
 #ifdef DHCPD_LWIP
 #define ETH_P_ARP		ETHTYPE_ARP
 #define ARPHRD_ETHER		1
@@ -48,28 +39,20 @@
 #define ARPOP_REQUEST		ARP_REQUEST
 #endif
 
-/* FIXME: match response against chaddr */
-int   arpping(u_int32_t yiaddr, u_int32_t ip, unsigned char *mac, char *interface)
+#ifdef DHCPD_ICMPPING
+#define ARPPING_ICMP_ID		0x6470	/* "dp", tells our echo requests apart */
+#define ARPPING_BUF_SIZE	50
+#endif
+
+/* open the socket the conflict probes are sent and answered on
+ * retn:	socket
+ *		-1 error
+ */
+int arpping_open(void)
 {
-	int	timeout = 2;
 	int 	optval = 1;
 	int	s;			/* socket */
-	int	rv = 1;			/* return value */
-	//struct sockaddr addr;		/* for interface name */
-#ifdef DHCPD_ICMPPING
-	char icmp_buf[50];
-	struct icmp_echo_hdr *icmp_hdr = (struct icmp_echo_hdr *)icmp_buf;
-#else
-	struct arpMsg	arp;
-#endif
-	fd_set		fdset;
-	struct timeval	tm;
-	time_t		prevTime;
-#ifdef DHCPD_ICMPPING
-	struct sockaddr_in sl;
-#else
-	struct sockaddr_ll sl;
-#endif
+
 #ifdef DHCPD_ICMPPING
 	if ((s = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP)) == -1) {
 #else
@@ -81,21 +64,61 @@ int   arpping(u_int32_t yiaddr, u_int32_t ip, unsigned char *mac, char *interfac
 
 	if (setsockopt(s, SOL_SOCKET, SO_BROADCAST, &optval, sizeof(optval)) == -1) {
 		DHCPD_LOG(LOG_ERR, "arp:Could not setsocketopt on raw socket");
+		arpping_close(s);
+		return -1;
+	}
+	return s;
+}
+
+
+void arpping_close(int s)
+{
 #ifdef DHCPD_LWIP
-		closesocket(s);
+	closesocket(s);
 #else
-		close(s);
+	close(s);
 #endif
-		return -1;
-	}
+}
+
+
+/* args:	s - socket from arpping_open()
+ *		yiaddr - what IP to ping
+ *		ip - our ip
+ *		mac - our arp address
+ *		seq - probe sequence number
+ * retn: 	0 probe sent
+ *		-1 error
+ */
+int arpping_send(int s, u_int32_t yiaddr, u_int32_t ip, unsigned char *mac, u_int16_t seq)
+{
+#ifdef DHCPD_ICMPPING
+	char icmp_buf[ARPPING_BUF_SIZE];
+	struct icmp_echo_hdr *icmp_hdr = (struct icmp_echo_hdr *)icmp_buf;
+	struct sockaddr_in sl;
+#else
+	struct arpMsg	arp;
+	struct sockaddr_ll sl;
+#endif
+
 	DHCPD_LOG(LOG_INFO, "arp : check ip %s\n", inet_ntoa(yiaddr));
 	/* send arp request */
 #ifdef DHCPD_ICMPPING
 	memset(icmp_buf, 0, sizeof(icmp_buf));
+	ICMPH_TYPE_SET(icmp_hdr, ICMP_ECHO);
+	ICMPH_CODE_SET(icmp_hdr, 0);
+	icmp_hdr->id = htons(ARPPING_ICMP_ID);
+	icmp_hdr->seqno = htons(seq);
+	icmp_hdr->chksum = 0;
+	icmp_hdr->chksum = inet_chksum(icmp_hdr, sizeof(icmp_buf));
+
+	memset(&sl, 0, sizeof(sl));
+	sl.sin_len = sizeof(sl);
+	sl.sin_family = AF_INET;
+	sl.sin_addr.s_addr = yiaddr;
+	if (sendto(s, icmp_buf, sizeof(icmp_buf), 0, (struct sockaddr*)&sl, sizeof(sl)) < 0)
+		return -1;
 #else
 	memset(&arp, 0, sizeof(arp));
-#endif
-#ifndef DHCPD_ICMPPING
 #ifdef DHCPD_LWIP
 	memcpy(arp.ethhdr.dest.addr, MAC_BCAST_ADDR, 6);	/* MAC DA */
 	memcpy(arp.ethhdr.src.addr, mac, 6);		/* MAC SA */
@@ -105,96 +128,55 @@ int   arpping(u_int32_t yiaddr, u_int32_t ip, unsigned char *mac, char *interfac
 	memcpy(arp.ethhdr.h_source, mac, 6);		/* MAC SA */
 	arp.ethhdr.h_proto = htons(ETH_P_ARP);		/* protocol type (Ethernet) */
 #endif
-#endif
-#ifdef DHCPD_ICMPPING
-	ICMPH_TYPE_SET(icmp_hdr, ICMP_ECHO);
-	ICMPH_CODE_SET(icmp_hdr, 0);
-	icmp_hdr->chksum = 0;
-	icmp_hdr->id = 0;
-	icmp_hdr->seqno = 0;
-	icmp_hdr->chksum = inet_chksum(icmp_hdr, sizeof(struct icmp_echo_hdr));
-#else
 	arp.htype = htons(ARPHRD_ETHER);		/* hardware type */
 	arp.ptype = htons(ETH_P_IP);			/* protocol type (ARP message) */
 	arp.hlen = 6;					/* hardware address length */
 	arp.plen = 4;					/* protocol address length */
 	arp.operation = htons(ARPOP_REQUEST);		/* ARP op code */
-#endif
-#ifndef DHCPD_ICMPPING
-#ifndef DHCPD_LWIP
-	*((u_int *) arp.sInaddr) = ip;			/* source IP address */
-#else
-	memcpy(arp.sInaddr,(char *)&ip, 4);
-#endif
+	memcpy(arp.sInaddr, (char *)&ip, 4);		/* source IP address */
 	memcpy(arp.sHaddr, mac, 6);			/* source hardware address */
-#ifndef DHCPD_LWIP
-	*((u_int *) arp.tInaddr) = yiaddr;		/* target IP address */
-#else
-	memcpy(arp.tInaddr,(char *)&yiaddr, 4);
-#endif
-#endif
-	//memset(&addr, 0, sizeof(addr));
-	//strcpy(addr.sa_data, interface);
-	//if (sendto(s, &arp, sizeof(arp), 0, &addr, sizeof(addr)) < 0)
+	memcpy(arp.tInaddr, (char *)&yiaddr, 4);	/* target IP address */
+
 	memset(&sl, 0, sizeof(sl));
-#ifdef DHCPD_ICMPPING
-	sl.sin_len = sizeof(sl);
-	sl.sin_family = AF_INET;
-	sl.sin_addr.s_addr = htonl(INADDR_ANY);
-#else
 	sl.sll_family = AF_PACKET;
-    	//sl.sll_addr = MAC_SOURCE;
-    	//sl.sll_halen = ETH_ALEN;
 	sl.sll_ifindex = 0x2;
-#endif
-#ifdef DHCPD_ICMPPING
-	if (sendto(s, icmp_buf, sizeof(icmp_buf), 0, (struct sockaddr*)&sl, sizeof(sl)) < 0)
-#else
 	if (sendto(s, &arp, sizeof(arp), 0, (struct sockaddr*)&sl, sizeof(sl)) < 0)
+		return -1;
 #endif
-		rv = 0;
-
-	/* wait arp reply, and check it */
-	tm.tv_usec = 0;
-	time(&prevTime);
-
-	while (timeout > 0) {
-		FD_ZERO(&fdset);
-		FD_SET(s, &fdset);
-		tm.tv_sec = timeout;
-		if (select(s + 1, &fdset, (fd_set *) NULL, (fd_set *) NULL, &tm) < 0) {
-			DEBUG(LOG_ERR, "Error on ARPING request: %s", strerror(errno));
-			if (errno != EINTR) rv = 0;
-		} else if (FD_ISSET(s, &fdset)) {
-#ifdef DHCPD_ICMPPING
-			if (recv(s, icmp_buf, sizeof(icmp_buf), 0) < 0 ) rv = 0;
-			struct ip_hdr *iphdr = (struct ip_hdr *)icmp_buf;
-			icmp_hdr = (struct icmp_echo_hdr *)(icmp_buf + IPH_HL(iphdr) * 4);
-#else
-			if (recv(s, &arp, sizeof(arp), 0) < 0 ) rv = 0;
-			u_int *tsInaddr = (u_int *)arp.sInaddr;
-#endif
+	return 0;
+}
+
+
+/* FIXME: match response against chaddr */
+/* args:	s - readable socket from arpping_open()
+ *		mac - our arp address
+ * retn: 	address that answered a probe
+ *		0 nothing valid received
+ */
+u_int32_t arpping_recv(int s, unsigned char *mac)
+{
+	u_int32_t addr = 0;
 #ifdef DHCPD_ICMPPING
-			if (iphdr->src.addr == yiaddr && icmp_hdr->type == ICMP_ER) {
-#else
-			if (arp.operation == htons(ARP_REPLY) &&
-				bcmp(arp.tHaddr, mac, 6) == 0 &&
-				*(/*(u_int *) arp.sInaddr*/tsInaddr) == yiaddr) {
-#endif
-				DEBUG(LOG_INFO, "Valid arp reply receved for this address");
-				rv = 0;
-				break;
-			}
-		}
-		timeout -= time(NULL) - prevTime;
-		time(&prevTime);
+	char icmp_buf[ARPPING_BUF_SIZE];
+	struct ip_hdr *iphdr = (struct ip_hdr *)icmp_buf;
+	struct icmp_echo_hdr *icmp_hdr;
 
-	}
-#ifdef DHCPD_LWIP
-	closesocket(s);
+	if (recv(s, icmp_buf, sizeof(icmp_buf), MSG_DONTWAIT) < (int)(IP_HLEN + sizeof(*icmp_hdr)))
+		return 0;
+	icmp_hdr = (struct icmp_echo_hdr *)(icmp_buf + IPH_HL(iphdr) * 4);
+	if (IPH_HL(iphdr) * 4 + sizeof(*icmp_hdr) <= sizeof(icmp_buf) &&
+	    icmp_hdr->type == ICMP_ER && icmp_hdr->id == htons(ARPPING_ICMP_ID))
+		addr = iphdr->src.addr;
 #else
-	close(s);
-#endif
-	DEBUG(LOG_INFO, "%salid arp replies for this address", rv ? "No v" : "V");
-	return rv;
+	struct arpMsg	arp;
+
+	if (recv(s, &arp, sizeof(arp), MSG_DONTWAIT) < 0)
+		return 0;
+	if (arp.operation == htons(ARP_REPLY) &&
+	    bcmp(arp.tHaddr, mac, 6) == 0)
+		memcpy(&addr, arp.sInaddr, 4);
+#endif
+	if (addr)
+		DEBUG(LOG_INFO, "Valid arp reply receved for %s", inet_ntoa(addr));
+	return addr;
 }
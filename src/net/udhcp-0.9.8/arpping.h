@@ -36,6 +36,9 @@ struct arpMsg {
 };
 
 /* function prototypes */
-int arpping(u_int32_t yiaddr, u_int32_t ip, unsigned char *arp, char *interface);
+int arpping_open(void);
+void arpping_close(int s);
+int arpping_send(int s, u_int32_t yiaddr, u_int32_t ip, unsigned char *mac, u_int16_t seq);
+u_int32_t arpping_recv(int s, unsigned char *mac);
 
 #endif
@@ -22,6 +22,11 @@
 /* the period of time the client is allowed to use that address */
 #define LEASE_TIME              (60*60*24*10) /* 10 days of seconds */
 
+/* how long an offered address is probed for a conflicting host */
+#define PROBE_TIME_MS           500
+/* how many conflicting addresses to skip before an OFFER is abandoned */
+#define PROBE_TRIES             4
+
 #ifdef DHCPD_FS
 /* where to find the DHCP server configuration file */
 #define DHCPD_CONF_FILE         "/etc/udhcpd.conf"
@@ -3,6 +3,7 @@
  * Russ Dill <Russ.Dill@asu.edu> July 2001
  */
 #include <string.h>
+#include <stdlib.h>
 
 #ifdef DHCPD_LWIP
 #include <lwip/sockets.h>
@@ -27,18 +28,165 @@
 
 unsigned char blank_chaddr[] = {[0 ... 15] = 0};
 
-/* clear every lease out that chaddr OR yiaddr matches and is nonzero */
-void clear_lease(u_int8_t *chaddr, u_int32_t yiaddr)
+/*
+ * The lease table is indexed twice so that no lookup has to walk it:
+ * a hash of the client MAC chains the leases of non blank chaddr, and every
+ * address of [start, end] maps to the lease holding it. A bitmap keeps the
+ * addresses no lease refers to, so finding a free one is a word scan.
+ */
+#define LEASE_NIL	0xFFFF
+
+static void *lease_index;
+static u_int32_t *addr_free;	/* one bit per address of the range held by no lease */
+static u_int16_t *addr_lease;	/* lease slot holding each address of the range */
+static u_int16_t *lease_hash;	/* chaddr hash bucket heads */
+static u_int16_t *lease_next;	/* hash chain, one link per lease slot */
+static u_int32_t hash_mask;
+static u_int32_t addr_base;	/* first address of the range, host order */
+static u_int32_t addr_count;
+
+static int chaddr_blank(const u_int8_t *chaddr)
 {
-	unsigned int i, j;
+	int j;
 
 	for (j = 0; j < 16 && !chaddr[j]; j++);
+	return j == 16;
+}
 
-	for (i = 0; i < server_config.max_leases; i++)
-		if ((j != 16 && !memcmp(leases[i].chaddr, chaddr, 16)) ||
-		    (yiaddr && leases[i].yiaddr == yiaddr)) {
-			memset(&(leases[i]), 0, sizeof(struct dhcpOfferedAddr));
+/* FNV-1a over the hardware address, the rest of chaddr is padding */
+static u_int32_t chaddr_hash(const u_int8_t *chaddr)
+{
+	u_int32_t h = 2166136261UL;
+	int i;
+
+	for (i = 0; i < 6; i++) {
+		h ^= chaddr[i];
+		h *= 16777619UL;
+	}
+	return h & hash_mask;
+}
+
+/* offset of yiaddr in the range, -1 if it is outside */
+static int addr_offset(u_int32_t yiaddr)
+{
+	u_int32_t off = ntohl(yiaddr) - addr_base;
+
+	return (yiaddr && off < addr_count) ? (int)off : -1;
+}
+
+/* ie, not 192.168.55.0 nor 192.168.55.255 */
+static int addr_assignable(u_int32_t addr)
+{
+	return (addr & 0xFF) != 0 && (addr & 0xFF) != 0xFF;
+}
+
+static void lease_unlink(unsigned int i)
+{
+	u_int16_t *p;
+	int off;
+
+	if (!chaddr_blank(leases[i].chaddr)) {
+		for (p = &lease_hash[chaddr_hash(leases[i].chaddr)]; *p != LEASE_NIL; p = &lease_next[*p]) {
+			if (*p == i) {
+				*p = lease_next[i];
+				break;
+			}
 		}
+	}
+	lease_next[i] = LEASE_NIL;
+
+	if ((off = addr_offset(leases[i].yiaddr)) >= 0 && addr_lease[off] == i) {
+		addr_lease[off] = LEASE_NIL;
+		if (addr_assignable(addr_base + off))
+			addr_free[off >> 5] |= 1UL << (off & 31);
+	}
+}
+
+static void lease_link(unsigned int i)
+{
+	u_int32_t h;
+	int off;
+
+	if (!chaddr_blank(leases[i].chaddr)) {
+		h = chaddr_hash(leases[i].chaddr);
+		lease_next[i] = lease_hash[h];
+		lease_hash[h] = i;
+	}
+
+	if ((off = addr_offset(leases[i].yiaddr)) >= 0) {
+		addr_lease[off] = i;
+		addr_free[off >> 5] &= ~(1UL << (off & 31));
+	}
+}
+
+
+int leases_init(void)
+{
+	unsigned int i, buckets, words;
+	u_int32_t start = ntohl(server_config.start);
+	u_int32_t end = ntohl(server_config.end);
+
+	if (server_config.max_leases == 0 || server_config.max_leases >= LEASE_NIL)
+		return -1;
+
+	addr_base = start;
+	addr_count = (end >= start) ? end - start + 1 : 0;
+	for (buckets = 1; buckets < server_config.max_leases; buckets <<= 1);
+	hash_mask = buckets - 1;
+	words = (addr_count + 31) >> 5;
+
+	leases = malloc(sizeof(struct dhcpOfferedAddr) * server_config.max_leases);
+	lease_index = malloc(words * sizeof(u_int32_t) +
+	                     (addr_count + buckets + server_config.max_leases) * sizeof(u_int16_t));
+	if (!leases || !lease_index) {
+		leases_deinit();
+		return -1;
+	}
+	memset(leases, 0, sizeof(struct dhcpOfferedAddr) * server_config.max_leases);
+
+	addr_free = lease_index;
+	addr_lease = (u_int16_t *)(addr_free + words);
+	lease_hash = addr_lease + addr_count;
+	lease_next = lease_hash + buckets;
+
+	memset(addr_free, 0, words * sizeof(u_int32_t));
+	for (i = 0; i < addr_count; i++) {
+		addr_lease[i] = LEASE_NIL;
+		if (addr_assignable(addr_base + i))
+			addr_free[i >> 5] |= 1UL << (i & 31);
+	}
+	for (i = 0; i < buckets; i++)
+		lease_hash[i] = LEASE_NIL;
+	for (i = 0; i < server_config.max_leases; i++)
+		lease_next[i] = LEASE_NIL;
+
+	return 0;
+}
+
+
+void leases_deinit(void)
+{
+	if (leases != NULL) {
+		free(leases);
+		leases = NULL;
+	}
+	if (lease_index != NULL) {
+		free(lease_index);
+		lease_index = NULL;
+	}
+}
+
+
+/* clear every lease out that chaddr OR yiaddr matches and is nonzero */
+void clear_lease(u_int8_t *chaddr, u_int32_t yiaddr)
+{
+	struct dhcpOfferedAddr *lease;
+
+	if (!chaddr_blank(chaddr) && (lease = find_lease_by_chaddr(chaddr)))
+		lease_drop(lease);
+
+	if (yiaddr && (lease = find_lease_by_yiaddr(yiaddr)))
+		lease_drop(lease);
 }
 
 
@@ -53,15 +201,34 @@ struct dhcpOfferedAddr *add_lease(u_int8_t *chaddr, u_int32_t yiaddr, unsigned l
 	oldest = oldest_expired_lease();
 
 	if (oldest) {
+		lease_unlink(oldest - leases);
 		memcpy(oldest->chaddr, chaddr, 16);
 		oldest->yiaddr = yiaddr;
 		oldest->expires = time(0) + lease;
+		lease_link(oldest - leases);
 	}
 
 	return oldest;
 }
 
 
+/* forget the client of a lease but keep its address reserved */
+void lease_drop_chaddr(struct dhcpOfferedAddr *lease)
+{
+	lease_unlink(lease - leases);
+	memset(lease->chaddr, 0, 16);
+	lease_link(lease - leases);
+}
+
+
+/* free a lease slot and its address */
+void lease_drop(struct dhcpOfferedAddr *lease)
+{
+	lease_unlink(lease - leases);
+	memset(lease, 0, sizeof(struct dhcpOfferedAddr));
+}
+
+
 /* true if a lease has expired */
 int lease_expired(struct dhcpOfferedAddr *lease)
 {
@@ -92,7 +259,13 @@ struct dhcpOfferedAddr *find_lease_by_chaddr(u_int8_t *chaddr)
 {
 	unsigned int i;
 
-	for (i = 0; i < server_config.max_leases; i++)
+	if (chaddr_blank(chaddr)) {
+		for (i = 0; i < server_config.max_leases; i++)
+			if (chaddr_blank(leases[i].chaddr)) return &(leases[i]);
+		return NULL;
+	}
+
+	for (i = lease_hash[chaddr_hash(chaddr)]; i != LEASE_NIL; i = lease_next[i])
 		if (!memcmp(leases[i].chaddr, chaddr, 16)) return &(leases[i]);
 
 	return NULL;
@@ -103,6 +276,10 @@ struct dhcpOfferedAddr *find_lease_by_chaddr(u_int8_t *chaddr)
 struct dhcpOfferedAddr *find_lease_by_yiaddr(u_int32_t yiaddr)
 {
 	unsigned int i;
+	int off;
+
+	if ((off = addr_offset(yiaddr)) >= 0)
+		return addr_lease[off] != LEASE_NIL ? &(leases[addr_lease[off]]) : NULL;
 
 	for (i = 0; i < server_config.max_leases; i++)
 		if (leases[i].yiaddr == yiaddr) return &(leases[i]);
@@ -112,50 +289,28 @@ struct dhcpOfferedAddr *find_lease_by_yiaddr(u_int32_t yiaddr)
 
 
 /* find an assignable address, it check_expired is true, we check all the expired leases as well.
+ * The address is not probed here, see probe_start() for the conflict check.
  * Maybe this should try expired leases by age... */
 u_int32_t find_address(int check_expired)
 {
-	u_int32_t addr, ret;
-	struct dhcpOfferedAddr *lease = NULL;
-
-	addr = ntohl(server_config.start); /* addr is in host order here */
-	for (;addr <= ntohl(server_config.end); addr++) {
+	struct dhcpOfferedAddr *lease;
+	u_int32_t i;
 
-		/* ie, 192.168.55.0 */
-		if (!(addr & 0xFF)) continue;
-
-		/* ie, 192.168.55.255 */
-		if ((addr & 0xFF) == 0xFF) continue;
-
-		/* lease is not taken */
-		ret = htonl(addr);
-		if ((!(lease = find_lease_by_yiaddr(ret)) ||
-
-		     /* or it expired and we are checking for expired leases */
-		     (check_expired  && lease_expired(lease))) &&
+	/* lease is not taken */
+	for (i = 0; i < (addr_count + 31) >> 5; i++) {
+		if (addr_free[i])
+			return htonl(addr_base + (i << 5) + __builtin_ctz(addr_free[i]));
+	}
 
-		     /* and it isn't on the network */
-	    	     !check_ip(ret)) {
-			return ret;
-			break;
+	/* or it expired and we are checking for expired leases */
+	if (check_expired) {
+		for (i = 0; i < addr_count; i++) {
+			if (addr_lease[i] == LEASE_NIL)
+				continue;
+			lease = &(leases[addr_lease[i]]);
+			if (lease_expired(lease))
+				return htonl(addr_base + i);
 		}
 	}
 	return 0;
 }
-
-
-/* check is an IP is taken, if it is, add it to the lease table */
-int check_ip(u_int32_t addr)
-{
-	struct in_addr temp;
-	memset(&temp, 0, sizeof(temp));
-	DHCPD_LOG(LOG_INFO, "check ip");
-	if (arpping(addr, server_config.server, server_config.arp, server_config.interface) == 0) {
-		temp.s_addr = addr;
-	 	DHCPD_LOG(LOG_INFO, "%s belongs to someone, reserving it for %ld seconds",
-	 		inet_ntoa(temp), server_config.conflict_time);
-		add_lease(blank_chaddr, addr, server_config.conflict_time);
-		return 1;
-	} else return 0;
-}
-
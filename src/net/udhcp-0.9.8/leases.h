@@ -14,6 +14,10 @@ struct dhcpOfferedAddr {
 
 extern unsigned char blank_chaddr[];
 
+/* allocate the lease table and its indexes, server_config must be set */
+int leases_init(void);
+void leases_deinit(void);
+
 void clear_lease(u_int8_t *chaddr, u_int32_t yiaddr);
 struct dhcpOfferedAddr *add_lease(u_int8_t *chaddr, u_int32_t yiaddr, unsigned long lease);
 int lease_expired(struct dhcpOfferedAddr *lease);
@@ -21,7 +25,10 @@ struct dhcpOfferedAddr *oldest_expired_lease(void);
 struct dhcpOfferedAddr *find_lease_by_chaddr(u_int8_t *chaddr);
 struct dhcpOfferedAddr *find_lease_by_yiaddr(u_int32_t yiaddr);
 u_int32_t find_address(int check_expired);
-int check_ip(u_int32_t addr);
+
+/* leases are indexed by chaddr and yiaddr, never write those fields directly */
+void lease_drop_chaddr(struct dhcpOfferedAddr *lease);
+void lease_drop(struct dhcpOfferedAddr *lease);
 
 
 #endif
@@ -0,0 +1,271 @@
+/*
+ * probe.c -- asynchronous conflict probes of offered addresses
+ *
+ * An address picked by find_address() is probed before it is offered, but
+ * the server does not wait for the answer: the DISCOVER is parked in a probe
+ * slot and the OFFER goes out from probe_expire() once PROBE_TIME_MS passed
+ * in silence. The probes of clients joining together thus overlap instead of
+ * queueing behind each other.
+ */
+#ifdef DHCPD_LWIP
+#include <lwip/sockets.h>
+#else
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef DHCPD_TIMEALT
+#include "dhcp_time.h"
+#else
+#include <time.h>
+#endif
+#ifdef DHCPD_FREERTOS
+#include "kernel/os/os_time.h"
+#endif
+
+#include "packet.h"
+#include "debug.h"
+#include "dhcpd.h"
+#include "leases.h"
+#include "arpping.h"
+#include "serverpacket.h"
+#include "probe.h"
+
+struct offer_probe {
+	u_int8_t chaddr[16];
+	u_int32_t xid;
+	u_int32_t ciaddr;
+	u_int32_t giaddr;
+	u_int16_t flags;
+	u_int16_t seq;
+	u_int32_t yiaddr;	/* network order */
+	u_int32_t lease_time;	/* host order */
+	u_int32_t deadline;	/* ms */
+	u_int8_t tries;
+	u_int8_t busy;
+};
+
+/* one slot per lease, every pending OFFER holds one */
+static struct offer_probe *probes;
+static int probe_socket = -1;
+static u_int16_t probe_seq;
+
+static u_int32_t probe_now(void)
+{
+#ifdef DHCPD_FREERTOS
+	return OS_TicksToMSecs(OS_GetTicks());
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000 + tv.tv_usec / 1000;
+#endif
+}
+
+
+int probe_init(void)
+{
+	probes = calloc(server_config.max_leases, sizeof(struct offer_probe));
+	if (!probes) {
+		DHCPD_LOG(LOG_ERR, "Calloc failed...%d", __LINE__);
+		return -1;
+	}
+	/* without a socket addresses are offered unprobed */
+	probe_socket = arpping_open();
+	return 0;
+}
+
+
+void probe_deinit(void)
+{
+	if (probe_socket >= 0) {
+		arpping_close(probe_socket);
+		probe_socket = -1;
+	}
+	if (probes != NULL) {
+		free(probes);
+		probes = NULL;
+	}
+}
+
+
+/* socket to wait on for probe answers, -1 if there is none */
+int probe_fd(void)
+{
+	return probe_socket;
+}
+
+
+/* reserve the address for the client and probe it */
+static int probe_send(struct offer_probe *p)
+{
+	if (!add_lease(p->chaddr, p->yiaddr, server_config.offer_time)) {
+		DHCPD_LOG(LOG_WARNING, "lease pool is full -- OFFER abandoned");
+		return -1;
+	}
+
+	p->deadline = probe_now();
+	if (arpping_send(probe_socket, p->yiaddr, server_config.server,
+	                 server_config.arp, p->seq) == 0)
+		p->deadline += PROBE_TIME_MS;
+	/* else offer it right away, like an address nobody answered for */
+	return 0;
+}
+
+
+/* park a DISCOVER until yiaddr is known to be free */
+int probe_start(struct dhcpMessage *oldpacket, u_int32_t yiaddr, u_int32_t lease_time)
+{
+	struct offer_probe *p = NULL;
+	unsigned int i;
+
+	if (probe_socket >= 0) {
+		for (i = 0; i < server_config.max_leases; i++) {
+			if (!probes[i].busy) {
+				p = &probes[i];
+				break;
+			}
+		}
+	}
+	if (!p)
+		return send_offer_addr(oldpacket, yiaddr, lease_time);
+
+	memcpy(p->chaddr, oldpacket->chaddr, 16);
+	p->xid = oldpacket->xid;
+	p->ciaddr = oldpacket->ciaddr;
+	p->giaddr = oldpacket->giaddr;
+	p->flags = oldpacket->flags;
+	p->seq = probe_seq++;
+	p->yiaddr = yiaddr;
+	p->lease_time = lease_time;
+	p->tries = 0;
+	if (probe_send(p) < 0)
+		return -1;
+	p->busy = 1;
+	return 0;
+}
+
+
+/* true if the client of oldpacket already waits for a probe,
+ * the OFFER will then answer its latest transaction */
+int probe_pending(struct dhcpMessage *oldpacket)
+{
+	struct offer_probe *p;
+	unsigned int i;
+
+	if (!probes)
+		return 0;
+
+	for (i = 0; i < server_config.max_leases; i++) {
+		p = &probes[i];
+		if (p->busy && !memcmp(p->chaddr, oldpacket->chaddr, 16)) {
+			p->xid = oldpacket->xid;
+			p->ciaddr = oldpacket->ciaddr;
+			p->giaddr = oldpacket->giaddr;
+			p->flags = oldpacket->flags;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+/* a host answered, reserve its address and probe another one */
+void probe_input(void)
+{
+	struct offer_probe *p = NULL;
+	struct in_addr temp;
+	u_int32_t addr;
+	unsigned int i;
+
+	if (!(addr = arpping_recv(probe_socket, server_config.arp)))
+		return;
+
+	for (i = 0; i < server_config.max_leases; i++) {
+		if (probes[i].busy && probes[i].yiaddr == addr) {
+			p = &probes[i];
+			break;
+		}
+	}
+	if (!p)
+		return;
+
+	memset(&temp, 0, sizeof(temp));
+	temp.s_addr = addr;
+	DHCPD_LOG(LOG_INFO, "%s belongs to someone, reserving it for %ld seconds",
+		inet_ntoa(temp), server_config.conflict_time);
+	add_lease(blank_chaddr, addr, server_config.conflict_time);
+
+	if (++p->tries >= PROBE_TRIES ||
+	    (!(p->yiaddr = find_address(0)) && !(p->yiaddr = find_address(1)))) {
+		DHCPD_LOG(LOG_WARNING, "no IP addresses to give -- OFFER abandoned");
+		p->busy = 0;
+		return;
+	}
+	p->seq = probe_seq++;
+	if (probe_send(p) < 0)
+		p->busy = 0;
+}
+
+
+/* send the OFFERs whose probe went unanswered */
+void probe_expire(void)
+{
+	struct offer_probe *p;
+	struct dhcpMessage *packet;
+	u_int32_t now;
+	unsigned int i;
+
+	if (!probes)
+		return;
+
+	now = probe_now();
+	for (i = 0; i < server_config.max_leases; i++) {
+		p = &probes[i];
+		if (!p->busy || (int32_t)(now - p->deadline) < 0)
+			continue;
+		p->busy = 0;
+
+		packet = calloc(1, sizeof(struct dhcpMessage));
+		if (!packet) {
+			DHCPD_LOG(LOG_ERR, "Calloc failed...%d", __LINE__);
+			continue;
+		}
+		packet->xid = p->xid;
+		packet->ciaddr = p->ciaddr;
+		packet->giaddr = p->giaddr;
+		packet->flags = p->flags;
+		memcpy(packet->chaddr, p->chaddr, 16);
+		if (send_offer_addr(packet, p->yiaddr, p->lease_time) < 0)
+			DHCPD_LOG(LOG_ERR, "send OFFER failed");
+		free(packet);
+	}
+}
+
+
+/* ms until the next probe expires, -1 if none is pending */
+long probe_timeout(void)
+{
+	u_int32_t now;
+	long left, timeout = -1;
+	unsigned int i;
+
+	if (!probes)
+		return -1;
+
+	now = probe_now();
+	for (i = 0; i < server_config.max_leases; i++) {
+		if (!probes[i].busy)
+			continue;
+		left = (int32_t)(probes[i].deadline - now);
+		if (left < 0)
+			left = 0;
+		if (timeout < 0 || left < timeout)
+			timeout = left;
+	}
+	return timeout;
+}
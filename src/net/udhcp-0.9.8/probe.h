@@ -0,0 +1,16 @@
+/* probe.h */
+#ifndef _PROBE_H
+#define _PROBE_H
+
+#include "packet.h"
+
+int probe_init(void);
+void probe_deinit(void);
+int probe_fd(void);
+int probe_start(struct dhcpMessage *oldpacket, u_int32_t yiaddr, u_int32_t lease_time);
+int probe_pending(struct dhcpMessage *oldpacket);
+void probe_input(void);
+void probe_expire(void);
+long probe_timeout(void);
+
+#endif
@@ -32,6 +32,8 @@
 #include "dhcpd.h"
 #include "options.h"
 #include "leases.h"
+#include "probe.h"
+#include "serverpacket.h"
 #ifdef DHCPD_TIMEALT
 #include "dhcp_time.h"
 #else
@@ -110,41 +112,46 @@ static void add_bootp_options(struct dhcpMessage *packet)
 }
 
 
+/* lease time to offer to the client of oldpacket */
+static u_int32_t offer_lease_time(struct dhcpMessage *oldpacket, struct dhcpOfferedAddr *lease)
+{
+	u_int32_t lease_time_align = server_config.lease;
+	unsigned char *lease_time;
+
+	if (lease && !lease_expired(lease))
+		lease_time_align = lease->expires - time(0);
+
+	if ((lease_time = get_option(oldpacket, DHCP_LEASE_TIME))) {
+		memcpy(&lease_time_align, lease_time, 4);
+		lease_time_align = ntohl(lease_time_align);
+		if (lease_time_align > server_config.lease)
+			lease_time_align = server_config.lease;
+	}
+
+	/* Make sure we aren't just using the lease time from the previous offer */
+	if (lease_time_align < server_config.min_lease)
+		lease_time_align = server_config.lease;
+
+	return lease_time_align;
+}
+
+
 /* send a DHCP OFFER to a DHCP DISCOVER */
 int sendOffer(struct dhcpMessage *oldpacket)
 {
-#ifdef DHCPD_HEAP_REPLACE_STACK
-	struct dhcpMessage *packet;
-#else
-	struct dhcpMessage packet;
-#endif
 	struct dhcpOfferedAddr *lease = NULL;
-	u_int32_t req_align, lease_time_align = server_config.lease;
-	unsigned char *req, *lease_time;
-	struct option_set *curr;
-	//struct in_addr addr;
+	u_int32_t req_align, yiaddr;
+	unsigned char *req;
 
-#ifdef DHCPD_HEAP_REPLACE_STACK
-	packet = calloc(1,sizeof(struct dhcpMessage));
-	if (!packet) {
-		DHCPD_LOG(LOG_ERR, "Calloc failed...%d",__LINE__);
-		return -1;
-	}
-	init_packet(packet, oldpacket, DHCPOFFER);
-#else
-	init_packet(&packet, oldpacket, DHCPOFFER);
-#endif
+	/* the DISCOVER is retransmitted while its address is probed */
+	if (probe_pending(oldpacket))
+		return 0;
 
 	/* ADDME: if static, short circuit */
 	/* the client is in our lease/offered table */
 	if ((lease = find_lease_by_chaddr(oldpacket->chaddr))) {
-		if (!lease_expired(lease))
-			lease_time_align = lease->expires - time(0);
-#ifdef DHCPD_HEAP_REPLACE_STACK
-		packet->yiaddr = lease->yiaddr;
-#else
-		packet.yiaddr = lease->yiaddr;
-#endif
+		return send_offer_addr(oldpacket, lease->yiaddr, offer_lease_time(oldpacket, lease));
+
 	/* Or the client has a requested ip */
 	} else if ((req = get_option(oldpacket, DHCP_REQUESTED_IP)) &&
 
@@ -160,36 +167,48 @@ int sendOffer(struct dhcpMessage *oldpacket)
 
 		   /* or its taken, but expired */ /* ADDME: or maybe in here */
 		   lease_expired(lease)))) {
-#ifdef DHCPD_HEAP_REPLACE_STACK
-				packet->yiaddr = req_align; /* FIXME: oh my, is there a host using this IP? */
-#else
-				packet.yiaddr = req_align; /* FIXME: oh my, is there a host using this IP? */
-#endif
+		/* FIXME: oh my, is there a host using this IP? */
+		return send_offer_addr(oldpacket, req_align, offer_lease_time(oldpacket, NULL));
+	}
 
 	/* otherwise, find a free IP */ /*ADDME: is it a static lease? */
-	} else {
-#ifdef DHCPD_HEAP_REPLACE_STACK
-		packet->yiaddr = find_address(0);
-		/* try for an expired lease */
-		if (!packet->yiaddr) packet->yiaddr = find_address(1);
-#else
-		packet.yiaddr = find_address(0);
-
-		/* try for an expired lease */
-		if (!packet.yiaddr) packet.yiaddr = find_address(1);
-#endif
+	yiaddr = find_address(0);
+	/* try for an expired lease */
+	if (!yiaddr) yiaddr = find_address(1);
+	if (!yiaddr) {
+		DHCPD_LOG(LOG_WARNING, "no IP addresses to give -- OFFER abandoned");
+		return -1;
 	}
-#ifdef DHCPD_HEAP_REPLACE_STACK
-	if(!(packet->yiaddr)) {
-		if (packet != NULL)
-			free(packet);
 
+	/* and offer it once no host answered a probe for it */
+	return probe_start(oldpacket, yiaddr, offer_lease_time(oldpacket, NULL));
+}
+
+
+/* send a DHCP OFFER of yiaddr */
+int send_offer_addr(struct dhcpMessage *oldpacket, u_int32_t yiaddr, u_int32_t lease_time_align)
+{
+#ifdef DHCPD_HEAP_REPLACE_STACK
+	struct dhcpMessage *packet;
 #else
-	if(!packet.yiaddr) {
+	struct dhcpMessage packet;
 #endif
-		DHCPD_LOG(LOG_WARNING, "no IP addresses to give -- OFFER abandoned");
+	struct option_set *curr;
+	//struct in_addr addr;
+
+#ifdef DHCPD_HEAP_REPLACE_STACK
+	packet = calloc(1,sizeof(struct dhcpMessage));
+	if (!packet) {
+		DHCPD_LOG(LOG_ERR, "Calloc failed...%d",__LINE__);
 		return -1;
 	}
+	init_packet(packet, oldpacket, DHCPOFFER);
+	packet->yiaddr = yiaddr;
+#else
+	init_packet(&packet, oldpacket, DHCPOFFER);
+	packet.yiaddr = yiaddr;
+#endif
+
 #ifdef DHCPD_HEAP_REPLACE_STACK
 	if (!add_lease(packet->chaddr, packet->yiaddr, server_config.offer_time)) {
 		if (packet != NULL) {
@@ -203,16 +222,6 @@ int sendOffer(struct dhcpMessage *oldpacket)
 		return -1;
 	}
 
-	if ((lease_time = get_option(oldpacket, DHCP_LEASE_TIME))) {
-		memcpy(&lease_time_align, lease_time, 4);
-		lease_time_align = ntohl(lease_time_align);
-		if (lease_time_align > server_config.lease)
-			lease_time_align = server_config.lease;
-	}
-
-	/* Make sure we aren't just using the lease time from the previous offer */
-	if (lease_time_align < server_config.min_lease)
-		lease_time_align = server_config.lease;
 	/* ADDME: end of short circuit */
 #ifdef DHCPD_HEAP_REPLACE_STACK
 	struct netif *netif = netif_find(server_config.interface);
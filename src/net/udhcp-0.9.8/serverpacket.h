@@ -3,6 +3,7 @@
 
 
 int sendOffer(struct dhcpMessage *oldpacket);
+int send_offer_addr(struct dhcpMessage *oldpacket, u_int32_t yiaddr, u_int32_t lease_time);
 int sendNAK(struct dhcpMessage *oldpacket);
 int sendACK(struct dhcpMessage *oldpacket, u_int32_t yiaddr);
 int send_inform(struct dhcpMessage *oldpacket);
@@ -40,6 +40,7 @@
 #include "leases.h"
 #include "packet.h"
 #include "serverpacket.h"
+#include "probe.h"
 #include "net/udhcp/usr_dhcpd.h"
 #include "dns.h"
 
@@ -118,7 +119,7 @@ static int udhcpd_upgrade_sta_mac(void)
 				DEBUG(LOG_INFO, "Mac: %02x:%02x:%02x:%02x:%02x:%02x has disconnect, will be delete!",
 					leases[i].chaddr[0], leases[i].chaddr[1], leases[i].chaddr[2],
 					leases[i].chaddr[3], leases[i].chaddr[4], leases[i].chaddr[5]);
-				memset(&(leases[i]), 0, sizeof(struct dhcpOfferedAddr));
+				lease_drop(&(leases[i]));
 			}
 		}
 	}
@@ -130,11 +131,12 @@ exit:
 
 static void udhcpd_start(void *arg)
 {
-#ifdef DHCPD_DNS
 	fd_set fds;
 	int maxfdp;
 	int ret;
-
+	long timeout;
+	struct timeval tv;
+#ifdef DHCPD_DNS
 	int dns_socket = -1;
 	char *dns_buf = NULL;
 	dns_buf = malloc(DNS_BUF_SIZE);
@@ -197,8 +199,10 @@ static void udhcpd_start(void *arg)
 	if ((ntohl(server_param->addr_end) - ntohl(server_param->addr_start))  > (server_config.max_leases - 1))
 		server_config.end = htonl((ntohl(server_config.start) + server_config.max_leases - 1));
 
-	leases = malloc(sizeof(struct dhcpOfferedAddr) * server_config.max_leases);
-	memset(leases, 0, sizeof(struct dhcpOfferedAddr) * server_config.max_leases);
+	if (leases_init() < 0 || probe_init() < 0) {
+		DHCPD_LOG(LOG_ERR, "no mem");
+		goto exit_server;
+	}
 	DEBUG(LOG_DEBUG, "start ip=%s", inet_ntoa(server_config.start));
 	DEBUG(LOG_DEBUG, "end   ip=%s", inet_ntoa(server_config.end));
 
@@ -215,21 +219,39 @@ static void udhcpd_start(void *arg)
 				DNS_ERR("FATAL: couldn't create dns server socket\n");
 				goto exit_server;
 			}
+#endif
 
 		FD_ZERO(&fds);
 		FD_SET(server_socket, &fds);
+		maxfdp = server_socket + 1;
+#ifdef DHCPD_DNS
 		FD_SET(dns_socket, &fds);
-		maxfdp = server_socket > dns_socket ? server_socket + 1 : dns_socket + 1;
-		ret = select(maxfdp, &fds, NULL, NULL, NULL);
+		if (dns_socket >= maxfdp)
+			maxfdp = dns_socket + 1;
+#endif
+		if (probe_fd() >= 0) {
+			FD_SET(probe_fd(), &fds);
+			if (probe_fd() >= maxfdp)
+				maxfdp = probe_fd() + 1;
+		}
+		/* wake up for the next OFFER whose probe runs out */
+		timeout = probe_timeout();
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		ret = select(maxfdp, &fds, NULL, NULL, timeout < 0 ? NULL : &tv);
 		if (ret < 0)
 			goto exit_server;
-		else if (ret == 0)
+		if (ret > 0 && probe_fd() >= 0 && FD_ISSET(probe_fd(), &fds))
+			probe_input();
+		probe_expire();
+		if (ret == 0)
 			continue;
+#ifdef DHCPD_DNS
 		if (FD_ISSET(dns_socket, &fds))
 			dns_server(dns_socket, dns_buf, DNS_BUF_SIZE);
+#endif
 
 		if (FD_ISSET(server_socket, &fds)) {
-#endif
 			if ((bytes = get_packet(packet, server_socket)) < 0) { /* this waits for a packet - idle */
 				if (bytes == -1 && errno != EINTR) {
 					DEBUG(LOG_INFO, "error on read, %s, reopening socket", strerror(errno));
@@ -312,7 +334,7 @@ static void udhcpd_start(void *arg)
 						if ((lease = find_lease_by_yiaddr(requested_align))) {
 							if (lease_expired(lease)) {
 								/* probably best if we drop this lease */
-								memset(lease->chaddr, 0, 16);
+								lease_drop_chaddr(lease);
 								/* make some contention for this address */
 							} else sendNAK(packet);
 						} else {
@@ -325,7 +347,7 @@ static void udhcpd_start(void *arg)
 				case DHCPDECLINE:
 					DEBUG(LOG_INFO,"received DECLINE");
 					if (lease) {
-						memset(lease->chaddr, 0, 16);
+						lease_drop_chaddr(lease);
 						lease->expires = time(0) + server_config.decline_time;
 					}
 					break;
@@ -340,9 +362,7 @@ static void udhcpd_start(void *arg)
 				default:
 					DEBUG(LOG_WARNING, "unsupported DHCP message (%02x) -- ignoring", state[0]);
 			}
-#ifdef DHCPD_DNS
 		}
-#endif
 	}
 
 exit_server:
@@ -358,10 +378,8 @@ exit_server:
 		free(packet);
 		packet = NULL;
 	}
-	if (leases != NULL) {
-		free(leases);
-		leases = NULL;
-	}
+	probe_deinit();
+	leases_deinit();
 	if (arg != NULL)
 		free(arg);
 #ifdef DHCPD_UPGRADE_STA_MAC
@@ -55,6 +55,7 @@
 #endif
 
 #include "pm/pm.h"
+#include "pm/pm_idle.h"
 #include "_pm_define.h"
 #include "pm_i.h"
 #include "port.h"
@@ -223,10 +224,20 @@ static void __suspend_enter(enum suspend_state_t state)
 #endif
 		pm_hibernation(); /* never return */
 	} else if (state < PM_MODE_STANDBY) {
+#ifdef __CONFIG_PM_IDLE
+		uint32_t sysclk;
+
+		__record_dbg_status(PM_SUSPEND_ENTER | 8);
+		/* devices are suspended, run cpu and bus from HOSC while sleeping */
+		sysclk = pm_cpu_clk_to_hosc();
+		__cpu_sleep(state);
+		pm_cpu_clk_restore(sysclk);
+#else
 		__record_dbg_status(PM_SUSPEND_ENTER | 8);
 		/* TODO: set system bus to low freq */
 		__cpu_sleep(state);
 		/* TODO: restore system bus to normal freq */
+#endif
 	} else {
         HAL_PRCM_SetSys1WakeupPowerFlags(0x6);
         if (HAL_GlobalGetChipVer() >= 0xE) {
@@ -386,6 +397,7 @@ int pm_init(void)
 	suspend_ops.wake = platform_wake;
 	suspend_ops.end = __suspend_end;
 	suspend_ops_init(&suspend_ops);
+	pm_idle_init();
 
 #ifdef __CONFIG_ARCH_APP_CORE
 #if 0 /* enable this if only APP CPU used */
@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "pm/pm_idle.h"
+
+#ifdef CONFIG_PM_IDLE
+
+/* upper limits (us) of the expected idle time buckets, the last is open */
+static const uint32_t pm_idle_bucket_limit[PM_IDLE_BUCKETS - 1] = {
+	1000, 3000, 10000, 30000, 100000
+};
+
+/* intervals are clamped so that the variance can not overflow */
+#define PM_IDLE_INTERVAL_MAX    (10 * 1000 * 1000)
+
+/* weight of the history in the correction factor, 1/8 for the new sample */
+#define PM_IDLE_DECAY           8
+
+void pm_idle_predictor_init(struct pm_idle_predictor *p)
+{
+	int i;
+
+	memset(p, 0, sizeof(*p));
+	for (i = 0; i < PM_IDLE_BUCKETS; i++)
+		p->correction[i] = PM_IDLE_RESOLUTION;
+}
+
+static uint8_t pm_idle_bucket(uint32_t expected_us)
+{
+	uint8_t b;
+
+	for (b = 0; b < PM_IDLE_BUCKETS - 1; b++) {
+		if (expected_us < pm_idle_bucket_limit[b])
+			break;
+	}
+	return b;
+}
+
+/*
+ * Return the average of the recent intervals if they are steady, 0 if not.
+ * The largest interval is dropped and the rest checked again, so that a
+ * single long idle period does not hide a periodic wakeup.
+ */
+static uint32_t pm_idle_typical_interval(const struct pm_idle_predictor *p)
+{
+	uint32_t thresh = UINT32_MAX;
+	uint32_t max, avg;
+	uint64_t sum, variance, diff;
+	int i, divisor;
+
+	for (;;) {
+		sum = 0;
+		max = 0;
+		divisor = 0;
+		for (i = 0; i < PM_IDLE_INTERVALS; i++) {
+			uint32_t v = p->intervals[i];
+			if (v == 0 || v > thresh)
+				continue;
+			sum += v;
+			divisor++;
+			if (v > max)
+				max = v;
+		}
+		if (divisor * 4 < PM_IDLE_INTERVALS * 3)
+			return 0;
+
+		avg = (uint32_t)(sum / divisor);
+		variance = 0;
+		for (i = 0; i < PM_IDLE_INTERVALS; i++) {
+			uint32_t v = p->intervals[i];
+			if (v == 0 || v > thresh)
+				continue;
+			diff = (v > avg) ? (v - avg) : (avg - v);
+			variance += diff * diff;
+		}
+		variance /= divisor;
+
+		/* standard deviation below 1/6 of the average, or below 20us */
+		if ((uint64_t)avg * avg > variance * 36 || variance <= 400)
+			return avg;
+
+		thresh = max - 1;
+	}
+}
+
+uint32_t pm_idle_predict(struct pm_idle_predictor *p, uint32_t expected_us)
+{
+	uint32_t predicted, typical;
+
+	p->expected = expected_us;
+	p->bucket = pm_idle_bucket(expected_us);
+
+	predicted = (uint32_t)(((uint64_t)expected_us * p->correction[p->bucket] +
+	                        PM_IDLE_RESOLUTION / 2) / PM_IDLE_RESOLUTION);
+
+	typical = pm_idle_typical_interval(p);
+	if (typical && typical < predicted)
+		predicted = typical;
+
+	return predicted;
+}
+
+void pm_idle_reflect(struct pm_idle_predictor *p, uint32_t measured_us)
+{
+	uint32_t factor, corr;
+
+	/* woken up by the timer, or late: the prediction could not be longer */
+	if (measured_us > p->expected)
+		measured_us = p->expected;
+
+	if (p->expected) {
+		factor = (uint32_t)((uint64_t)measured_us * PM_IDLE_RESOLUTION /
+		                    p->expected);
+		corr = p->correction[p->bucket];
+		corr = (corr * (PM_IDLE_DECAY - 1) + factor) / PM_IDLE_DECAY;
+		p->correction[p->bucket] = corr ? corr : 1;
+	}
+
+	if (measured_us > PM_IDLE_INTERVAL_MAX)
+		measured_us = PM_IDLE_INTERVAL_MAX;
+	p->intervals[p->interval_idx] = measured_us ? measured_us : 1;
+	if (++p->interval_idx >= PM_IDLE_INTERVALS)
+		p->interval_idx = 0;
+}
+
+int pm_idle_select(const struct pm_idle_state *states, int cnt,
+                   uint32_t predicted_us, uint32_t latency_us)
+{
+	int i, idx = 0;
+
+	for (i = 1; i < cnt; i++) {
+		if (states[i].disable)
+			continue;
+		if (states[i].target_residency > predicted_us ||
+		    states[i].exit_latency > latency_us)
+			break;
+		idx = i;
+	}
+
+	return idx;
+}
+
+void pm_idle_update_latency(struct pm_idle_state *state, uint32_t measured_us)
+{
+	uint32_t lat = state->exit_latency;
+
+	if (measured_us > lat)
+		lat = (lat + measured_us + 1) / 2;
+	else
+		lat -= (lat - measured_us) / PM_IDLE_DECAY;
+	state->exit_latency = lat;
+}
+
+int pm_cpufreq_target(const struct pm_cpufreq_policy *policy, uint32_t busy_us,
+                      uint32_t total_us, uint32_t min_khz)
+{
+	int idx, floor;
+	uint32_t load;
+	uint64_t target;
+
+	for (floor = 0; floor < policy->cnt - 1; floor++) {
+		if (policy->freq[floor] >= min_khz)
+			break;
+	}
+
+	idx = policy->cur;
+	if (total_us) {
+		if (busy_us > total_us)
+			busy_us = total_us;
+		load = (uint32_t)((uint64_t)busy_us * 100 / total_us);
+
+		if (load > policy->up_threshold) {
+			idx = policy->cnt - 1;
+		} else if (load < policy->up_threshold - policy->down_differential) {
+			/* lowest clock keeping the load under up_threshold - differential */
+			target = (uint64_t)policy->freq[policy->cur] * load /
+			         (policy->up_threshold - policy->down_differential);
+			for (idx = 0; idx < policy->cur; idx++) {
+				if (policy->freq[idx] >= target)
+					break;
+			}
+		}
+	}
+
+	return (idx < floor) ? floor : idx;
+}
+
+#endif /* CONFIG_PM_IDLE */
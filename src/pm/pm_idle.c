@@ -0,0 +1,576 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sys/io.h"
+#include "sys/list.h"
+#include "sys/interrupt.h"
+
+#include "driver/chip/system_chip.h"
+#include "driver/chip/chip.h"
+#include "driver/chip/hal_prcm.h"
+#include "driver/chip/hal_ccm.h"
+#include "driver/chip/hal_clock.h"
+#include "driver/chip/hal_rtc.h"
+
+#include "pm/pm.h"
+#include "pm/pm_idle.h"
+#include "_pm_define.h"
+#include "pm_i.h"
+#include "port.h"
+
+#if (defined(CONFIG_PM) && defined(CONFIG_PM_IDLE))
+
+#if (!defined(__CONFIG_OS_FREERTOS) || defined(__CONFIG_ROM_FREERTOS))
+#error "pm idle governor needs FreeRTOS built from source"
+#endif
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*
+ * The tickless idle path of FreeRTOS is routed here by FreeRTOSConfig.h
+ * (portSUPPRESS_TICKS_AND_SLEEP). The SysTick runs from the cpu clock, so the
+ * tick is stopped and reprogrammed here whenever the cpu clock is changed,
+ * either for an idle state or by the cpu clock governor.
+ */
+
+#define PM_IDLE_TICK_US                 (1000000 / configTICK_RATE_HZ)
+
+#define SYSTICK_MAX_COUNT               0xFFFFFFUL
+#define SYSTICK_CTRL_RUN                (SysTick_CTRL_CLKSOURCE_Msk | \
+                                         SysTick_CTRL_TICKINT_Msk)
+
+/* cpu clock governor sample period, in ticks */
+#define PM_CPUFREQ_SAMPLE_TICKS         (50 * configTICK_RATE_HZ / 1000)
+#define PM_CPUFREQ_UP_THRESHOLD         80
+#define PM_CPUFREQ_DOWN_DIFFERENTIAL    20
+#define PM_CPUFREQ_MAX_OPP              8
+
+enum {
+	PM_IDLE_WFI = 0,
+	PM_IDLE_HOSC,
+	PM_IDLE_STATE_NUM,
+};
+
+/* exit_latency is the initial guess, it follows the measured cost */
+static struct pm_idle_state pm_idle_states[PM_IDLE_STATE_NUM] = {
+	{ .name = "wfi",  .exit_latency = 0,  .target_residency = 0 },
+	/* cpu and AHB from HOSC, system PLL left running for the devices */
+	{ .name = "hosc", .exit_latency = 10, .target_residency = 1000 },
+};
+
+static struct pm_idle_predictor pm_idle_pred;
+static uint32_t pm_idle_abort;
+
+static struct list_head pm_qos_list[PM_QOS_NUM_CLASSES] = {
+	LIST_HEAD_INIT(pm_qos_list[PM_QOS_CPU_LATENCY]),
+	LIST_HEAD_INIT(pm_qos_list[PM_QOS_CPU_THROUGHPUT]),
+	LIST_HEAD_INIT(pm_qos_list[PM_QOS_BUS_THROUGHPUT]),
+};
+
+static uint32_t pm_qos_value[PM_QOS_NUM_CLASSES] = {
+	PM_QOS_LATENCY_DEFAULT,
+	PM_QOS_THROUGHPUT_DEFAULT,
+	PM_QOS_THROUGHPUT_DEFAULT,
+};
+
+struct pm_cpufreq {
+	struct pm_cpufreq_policy policy;
+	uint32_t freq[PM_CPUFREQ_MAX_OPP];      /* KHz */
+	uint32_t factor[PM_CPUFREQ_MAX_OPP];
+	uint32_t trans;
+	uint8_t enable;
+	uint8_t in_idle;
+	uint16_t ticks;
+	uint32_t last;                          /* us */
+	uint32_t window;                        /* us */
+	uint32_t idle;                          /* us */
+};
+
+static struct pm_cpufreq pm_cpufreq;
+
+/* Free running us clock from the tick count and the SysTick. */
+static uint32_t pm_idle_clock_us(void)
+{
+	uint32_t ticks, load, val;
+
+	ticks = xTaskGetTickCountFromISR();
+	load = SysTick->LOAD;
+	val = SysTick->VAL;
+	/* wrapped, but the tick interrupt is not taken yet */
+	if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) && val > load / 2)
+		ticks++;
+
+	return ticks * PM_IDLE_TICK_US + (load - val) * PM_IDLE_TICK_US / (load + 1);
+}
+
+/*
+ * QoS requests
+ */
+static uint32_t pm_qos_aggregate(enum pm_qos_class qos_class)
+{
+	struct pm_qos_request *req;
+	uint32_t value;
+
+	if (qos_class == PM_QOS_CPU_LATENCY) {
+		value = PM_QOS_LATENCY_DEFAULT;
+		list_for_each_entry(req, &pm_qos_list[qos_class], node) {
+			if (req->value < value)
+				value = req->value;
+		}
+	} else {
+		value = PM_QOS_THROUGHPUT_DEFAULT;
+		list_for_each_entry(req, &pm_qos_list[qos_class], node) {
+			if (req->value > value)
+				value = req->value;
+		}
+	}
+
+	return value;
+}
+
+static uint32_t pm_cpufreq_min_khz(void)
+{
+	uint32_t cpu, bus, div;
+
+	div = HAL_GET_BIT_VAL(CCM->CPU_BUS_CLKCFG, CCM_AHB2_CLK_DIV_SHIFT,
+	                      CCM_AHB2_CLK_DIV_VMASK) + 1;
+	cpu = pm_qos_value[PM_QOS_CPU_THROUGHPUT];
+	bus = pm_qos_value[PM_QOS_BUS_THROUGHPUT] * div;
+
+	return (cpu > bus) ? cpu : bus;
+}
+
+/*
+ * Switch the cpu clock and rescale the SysTick, so that the part of the
+ * current tick already elapsed is kept.
+ */
+static void pm_cpufreq_set(int idx)
+{
+	unsigned long flags;
+	uint32_t cpt, ncpt, val, load;
+
+	flags = arch_irq_save();
+
+	cpt = SysTick->LOAD + 1;
+	val = SysTick->VAL;
+
+	HAL_PRCM_SetCPUAClk(PRCM_CPU_CLK_SRC_SYSCLK,
+	                    (PRCM_SysClkFactor)pm_cpufreq.factor[idx]);
+	SystemCoreClockUpdate();
+
+	ncpt = SystemCoreClock / configTICK_RATE_HZ;
+	load = (uint32_t)((uint64_t)val * ncpt / cpt);
+	SysTick->LOAD = load ? load : 1;
+	SysTick->VAL = 0;
+	__DSB();
+	__ISB();
+	SysTick->LOAD = ncpt - 1;
+
+	pm_cpufreq.policy.cur = idx;
+	pm_cpufreq.trans++;
+
+	arch_irq_restore(flags);
+}
+
+/* Raise the cpu clock at once if a new request needs it. */
+static void pm_cpufreq_apply_qos(void)
+{
+	unsigned long flags;
+	int idx;
+
+	flags = arch_irq_save();
+	if (pm_cpufreq.policy.cnt > 1) {
+		idx = pm_cpufreq_target(&pm_cpufreq.policy, 0, 0, pm_cpufreq_min_khz());
+		if (idx != pm_cpufreq.policy.cur)
+			pm_cpufreq_set(idx);
+	}
+	arch_irq_restore(flags);
+}
+
+int pm_qos_add_request(struct pm_qos_request *req,
+                       enum pm_qos_class qos_class, uint32_t value)
+{
+	unsigned long flags;
+
+	if (!req || qos_class >= PM_QOS_NUM_CLASSES) {
+		PM_LOGE("%s invalid request\n", __func__);
+		return -1;
+	}
+
+	req->qos_class = qos_class;
+	req->value = value;
+
+	flags = arch_irq_save();
+	list_add_tail(&req->node, &pm_qos_list[qos_class]);
+	pm_qos_value[qos_class] = pm_qos_aggregate(qos_class);
+	arch_irq_restore(flags);
+
+	if (qos_class != PM_QOS_CPU_LATENCY)
+		pm_cpufreq_apply_qos();
+
+	return 0;
+}
+
+int pm_qos_update_request(struct pm_qos_request *req, uint32_t value)
+{
+	unsigned long flags;
+
+	if (!req || req->qos_class >= PM_QOS_NUM_CLASSES)
+		return -1;
+
+	flags = arch_irq_save();
+	req->value = value;
+	pm_qos_value[req->qos_class] = pm_qos_aggregate(req->qos_class);
+	arch_irq_restore(flags);
+
+	if (req->qos_class != PM_QOS_CPU_LATENCY)
+		pm_cpufreq_apply_qos();
+
+	return 0;
+}
+
+int pm_qos_remove_request(struct pm_qos_request *req)
+{
+	unsigned long flags;
+
+	if (!req || req->qos_class >= PM_QOS_NUM_CLASSES)
+		return -1;
+
+	flags = arch_irq_save();
+	list_del(&req->node);
+	pm_qos_value[req->qos_class] = pm_qos_aggregate(req->qos_class);
+	arch_irq_restore(flags);
+
+	/* the clock governor lowers the clock at its next sample */
+	return 0;
+}
+
+uint32_t pm_qos_read_value(enum pm_qos_class qos_class)
+{
+	if (qos_class >= PM_QOS_NUM_CLASSES)
+		return 0;
+
+	return pm_qos_value[qos_class];
+}
+
+/*
+ * Cpu clock governor, idle time is accounted on context switches and the load
+ * is sampled from the tick hook.
+ */
+static void pm_cpufreq_account(uint32_t now)
+{
+	int32_t delta = (int32_t)(now - pm_cpufreq.last);
+
+	if (pm_cpufreq.in_idle && delta > 0)
+		pm_cpufreq.idle += delta;
+	pm_cpufreq.last = now;
+}
+
+void pm_idle_task_switched_in(int idle)
+{
+	pm_cpufreq_account(pm_idle_clock_us());
+	pm_cpufreq.in_idle = idle;
+}
+
+static void pm_cpufreq_sample(void)
+{
+	uint32_t now, total, busy;
+	int idx;
+
+	now = pm_idle_clock_us();
+	pm_cpufreq_account(now);
+
+	total = now - pm_cpufreq.window;
+	busy = (total > pm_cpufreq.idle) ? (total - pm_cpufreq.idle) : 0;
+	pm_cpufreq.window = now;
+	pm_cpufreq.idle = 0;
+
+	if (!pm_cpufreq.enable || pm_cpufreq.policy.cnt < 2)
+		return;
+
+	idx = pm_cpufreq_target(&pm_cpufreq.policy, busy, total,
+	                        pm_cpufreq_min_khz());
+	if (idx != pm_cpufreq.policy.cur)
+		pm_cpufreq_set(idx);
+}
+
+void vApplicationTickHook(void)
+{
+	if (++pm_cpufreq.ticks < PM_CPUFREQ_SAMPLE_TICKS)
+		return;
+
+	pm_cpufreq.ticks = 0;
+	pm_cpufreq_sample();
+}
+
+void pm_cpufreq_enable(int enable)
+{
+	pm_cpufreq.enable = enable ? 1 : 0;
+	if (!enable && pm_cpufreq.policy.cur != pm_cpufreq.policy.cnt - 1)
+		pm_cpufreq_set(pm_cpufreq.policy.cnt - 1);
+}
+
+#if (__CONFIG_CHIP_ARCH_VER == 2)
+static const PRCM_SysClkFactor pm_cpufreq_factors[] = {
+	PRCM_SYS_CLK_FACTOR_48M,
+	PRCM_SYS_CLK_FACTOR_64M,
+	PRCM_SYS_CLK_FACTOR_96M,
+	PRCM_SYS_CLK_FACTOR_120M,
+	PRCM_SYS_CLK_FACTOR_160M,
+	PRCM_SYS_CLK_FACTOR_192M,
+};
+#endif
+
+/*
+ * Clocks below the boot one, the boot clock last. The LDO voltage is set for
+ * the boot clock, so it is never exceeded.
+ */
+static void pm_cpufreq_init(void)
+{
+	struct pm_cpufreq *cf = &pm_cpufreq;
+	uint32_t clk = PRCM->SYS_CLK1_CTRL;
+	uint8_t cnt = 0;
+
+#if (__CONFIG_CHIP_ARCH_VER == 2)
+	if ((clk & PRCM_CPU_CLK_SRC_MASK) == PRCM_CPU_CLK_SRC_SYSCLK) {
+		uint32_t boot_hz = HAL_PRCM_SysClkFactor2Hz(clk & PRCM_SYS_CLK_FACTOR_MASK);
+		uint32_t hz;
+		int i;
+
+		for (i = 0; i < ARRAY_SIZE(pm_cpufreq_factors); i++) {
+			hz = HAL_PRCM_SysClkFactor2Hz(pm_cpufreq_factors[i]);
+			if (hz >= boot_hz || cnt >= PM_CPUFREQ_MAX_OPP - 1)
+				break;
+			cf->factor[cnt] = pm_cpufreq_factors[i];
+			cf->freq[cnt++] = hz / 1000;
+		}
+	}
+#endif
+	cf->factor[cnt] = clk & PRCM_SYS_CLK_FACTOR_MASK;
+	cf->freq[cnt++] = HAL_GetCPUClock() / 1000;
+
+	cf->policy.freq = cf->freq;
+	cf->policy.cnt = cnt;
+	cf->policy.cur = cnt - 1;
+	cf->policy.up_threshold = PM_CPUFREQ_UP_THRESHOLD;
+	cf->policy.down_differential = PM_CPUFREQ_DOWN_DIFFERENTIAL;
+	cf->enable = 1;
+}
+
+/* Standby and its resume run at the boot clock. */
+static int pm_cpufreq_suspend(struct soc_device *dev, enum suspend_state_t state)
+{
+	if (pm_cpufreq.policy.cur != pm_cpufreq.policy.cnt - 1)
+		pm_cpufreq_set(pm_cpufreq.policy.cnt - 1);
+
+	return 0;
+}
+
+static const struct soc_device_driver pm_cpufreq_drv = {
+	.name = "cpufreq",
+	.suspend = pm_cpufreq_suspend,
+};
+
+static struct soc_device pm_cpufreq_dev = {
+	.name = "cpufreq",
+	.driver = &pm_cpufreq_drv,
+};
+
+/*
+ * Idle governor
+ */
+static void pm_systick_restart(uint32_t first_us)
+{
+	uint32_t ncpt, first;
+
+	ncpt = SystemCoreClock / configTICK_RATE_HZ;
+	first = (uint32_t)((uint64_t)first_us * ncpt / PM_IDLE_TICK_US);
+	if (first < 2)
+		first = 2;
+	else if (first > SYSTICK_MAX_COUNT)
+		first = SYSTICK_MAX_COUNT;
+
+	SysTick->LOAD = first - 1;
+	SysTick->VAL = 0;
+	SysTick->CTRL = SYSTICK_CTRL_RUN | SysTick_CTRL_ENABLE_Msk;
+	SysTick->LOAD = ncpt - 1;
+}
+
+void pm_idle_suspend_ticks(uint32_t expected_ticks)
+{
+	struct pm_idle_state *st;
+	uint32_t cpt, val, hz, done, expected_us, wake_us, max_us, predicted;
+	uint32_t count, elapsed, slept_us, lost_us = 0, sysclk = 0, step;
+	uint64_t t0 = 0, t1, t2, t3;
+	int32_t rest;
+	int idx, fired, clamped = 0;
+
+	__disable_irq();
+	__DSB();
+	__ISB();
+
+	/* a task got ready, or a tick is pending: the expected time is stale */
+	if (eTaskConfirmSleepModeStatus() == eAbortSleep ||
+	    (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)) {
+		pm_idle_abort++;
+		__enable_irq();
+		return;
+	}
+
+	SysTick->CTRL = SYSTICK_CTRL_RUN;
+	cpt = SysTick->LOAD + 1;
+	val = SysTick->VAL;
+	done = (cpt - 1 - val) * PM_IDLE_TICK_US / cpt;
+	expected_us = expected_ticks * PM_IDLE_TICK_US - done;
+
+	predicted = pm_idle_predict(&pm_idle_pred, expected_us);
+	idx = pm_idle_select(pm_idle_states, PM_IDLE_STATE_NUM, predicted,
+	                     pm_qos_value[PM_QOS_CPU_LATENCY]);
+	st = &pm_idle_states[idx];
+
+	if (idx == PM_IDLE_HOSC) {
+		t0 = HAL_RTC_GetFreeRunTime();
+		sysclk = pm_cpu_clk_to_hosc();
+		hz = HAL_GetHFClock();
+		t1 = HAL_RTC_GetFreeRunTime();
+	} else {
+		hz = SystemCoreClock;
+	}
+
+	/* the SysTick is the wakeup timer, wake up early by the exit latency */
+	max_us = (uint32_t)((uint64_t)SYSTICK_MAX_COUNT * 1000000 / hz);
+	wake_us = expected_us;
+	if (wake_us > max_us) {
+		wake_us = max_us;
+		clamped = 1;
+	}
+	if (wake_us > st->exit_latency * 2)
+		wake_us -= st->exit_latency;
+	count = (uint32_t)((uint64_t)wake_us * hz / 1000000);
+	if (count < 2)
+		count = 2;
+
+	SysTick->LOAD = count;
+	SysTick->VAL = 0;
+	SysTick->CTRL = SYSTICK_CTRL_RUN | SysTick_CTRL_ENABLE_Msk;
+
+	__DSB();
+	__WFI();
+	__ISB();
+
+	SysTick->CTRL = SYSTICK_CTRL_RUN;
+	fired = (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) ? 1 : 0;
+	val = SysTick->VAL;
+	elapsed = fired ? (count + count - val) : (count - val);
+	slept_us = (uint32_t)((uint64_t)elapsed * 1000000 / hz);
+
+	if (idx == PM_IDLE_HOSC) {
+		t2 = HAL_RTC_GetFreeRunTime();
+		pm_cpu_clk_restore(sysclk);
+		t3 = HAL_RTC_GetFreeRunTime();
+		lost_us = (uint32_t)(t3 - t2);
+		pm_idle_update_latency(st, (uint32_t)((t1 - t0) + lost_us));
+	}
+
+	/* whole ticks passed, the last one is left to the pending tick interrupt */
+	done += slept_us + lost_us;
+	if (fired && !clamped) {
+		step = expected_ticks - 1;
+		rest = (int32_t)(done - expected_ticks * PM_IDLE_TICK_US);
+	} else {
+		if (fired)
+			SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+		step = done / PM_IDLE_TICK_US;
+		if (step > expected_ticks - 1)
+			step = expected_ticks - 1;
+		rest = (int32_t)(done - step * PM_IDLE_TICK_US);
+	}
+	if (rest >= PM_IDLE_TICK_US)
+		rest = PM_IDLE_TICK_US - 1;
+	else if (rest < -PM_IDLE_TICK_US)
+		rest = -PM_IDLE_TICK_US;
+
+	if (step)
+		vTaskStepTick(step);
+	pm_systick_restart(PM_IDLE_TICK_US - rest);
+
+	st->usage++;
+	st->time += slept_us + lost_us;
+	pm_idle_reflect(&pm_idle_pred, slept_us + lost_us);
+
+	__enable_irq();
+}
+
+int pm_idle_state_disable(int idx, int disable)
+{
+	if (idx <= PM_IDLE_WFI || idx >= PM_IDLE_STATE_NUM)
+		return -1;
+
+	pm_idle_states[idx].disable = disable;
+	return 0;
+}
+
+void pm_idle_show(void)
+{
+	struct pm_idle_state *st;
+	int i;
+
+	PM_LOGA("idle state   latency(us) residency(us)  usage      time(ms)\n");
+	for (i = 0; i < PM_IDLE_STATE_NUM; i++) {
+		st = &pm_idle_states[i];
+		PM_LOGA("%-8s%c %10u %13u %10u %12u\n", st->name,
+		        st->disable ? '*' : ' ', st->exit_latency,
+		        st->target_residency, st->usage, (uint32_t)(st->time / 1000));
+	}
+	PM_LOGA("idle aborted:%u\n", pm_idle_abort);
+	PM_LOGA("qos latency:%u cpu:%uKHz bus:%uKHz\n",
+	        pm_qos_value[PM_QOS_CPU_LATENCY],
+	        pm_qos_value[PM_QOS_CPU_THROUGHPUT],
+	        pm_qos_value[PM_QOS_BUS_THROUGHPUT]);
+	PM_LOGA("cpufreq %s, cur:%uKHz (%u/%u) trans:%u\n",
+	        pm_cpufreq.enable ? "on" : "off",
+	        pm_cpufreq.freq[pm_cpufreq.policy.cur],
+	        pm_cpufreq.policy.cur + 1, pm_cpufreq.policy.cnt,
+	        pm_cpufreq.trans);
+}
+
+void pm_idle_init(void)
+{
+	pm_idle_predictor_init(&pm_idle_pred);
+	pm_cpufreq_init();
+	pm_register_ops(&pm_cpufreq_dev);
+}
+
+#endif /* CONFIG_PM && CONFIG_PM_IDLE */
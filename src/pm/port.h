@@ -31,6 +31,7 @@
 #define __PM_PORT_H
 
 #include "driver/chip/hal_nvic.h"
+#include "driver/chip/hal_prcm.h"
 #include "driver/chip/hal_rtc.h"
 #include "driver/chip/hal_util.h"
 
@@ -79,6 +80,21 @@ static __always_inline void __record_dbg_status(int val)
 	isb();
 }
 
+/* Run cpu (and AHB) from HOSC, return the clock setting to restore. */
+static __always_inline uint32_t pm_cpu_clk_to_hosc(void)
+{
+	uint32_t clk = PRCM->SYS_CLK1_CTRL;
+
+	HAL_PRCM_SetCPUAClk(PRCM_CPU_CLK_SRC_HFCLK, PRCM_SYS_CLK_FACTOR_80M);
+	return clk;
+}
+
+static __always_inline void pm_cpu_clk_restore(uint32_t clk)
+{
+	HAL_PRCM_SetCPUAClk((PRCM_CPUClkSrc)(clk & PRCM_CPU_CLK_SRC_MASK),
+	                    (PRCM_SysClkFactor)(clk & PRCM_SYS_CLK_FACTOR_MASK));
+}
+
 extern unsigned int nvic_int_mask[];
 
 extern int platform_prepare(enum suspend_state_t state);
@@ -0,0 +1,662 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "sys/param.h"
+#include "sys/interrupt.h"
+#include "sys/dma_copy.h"
+
+#if !DMA_COPY_OPT_SW_BACKEND
+#include "driver/chip/hal_dma.h"
+#ifdef __CONFIG_PSRAM
+#include "driver/chip/psram/psram.h"
+#endif
+#endif
+
+#define DMACPY_DBG_ON	0
+#define DMACPY_ERR_ON	1
+
+#define DMACPY_LOG(flags, fmt, arg...)	\
+	do {				\
+		if (flags)		\
+			printf(fmt, ##arg);	\
+	} while (0)
+
+#define DMACPY_DBG(fmt, arg...)	DMACPY_LOG(DMACPY_DBG_ON, "[dmacpy] "fmt, ##arg)
+#define DMACPY_ERR(fmt, arg...)	\
+	DMACPY_LOG(DMACPY_ERR_ON, "[dmacpy ERR] %s():%d, "fmt, __func__, __LINE__, ##arg)
+
+/* Longest transfer programmed at once, longer segments are split */
+#define DMA_COPY_MAX_LEN	(128 * 1024U)
+
+/*
+ * Engine under the service. start() runs one transfer on channel @idx and
+ * the engine calls dma_copy_end(idx) when it is done.
+ */
+struct dma_copy_backend {
+	int  (*open)(uint32_t idx);
+	void (*close)(uint32_t idx);
+	int  (*start)(uint32_t idx, void *dst, const void *src, uint32_t len,
+	              int fixed_src);
+	void (*stop)(uint32_t idx);
+};
+
+struct dma_copy_chan {
+	struct dma_copy_job *job;	/* job owning the channel, NULL if idle */
+	uint32_t len;			/* length of the running transfer */
+	uint32_t pattern;		/* DMA source of fill jobs */
+};
+
+/* jobs completed under the lock, reported once it is released */
+struct dma_copy_list {
+	struct dma_copy_job *head;
+	struct dma_copy_job *tail;
+};
+
+struct dma_copy_ctx {
+	struct dma_copy_chan chan[DMA_COPY_CHAN_NUM];
+	struct dma_copy_job *head;	/* queued jobs, not started yet */
+	struct dma_copy_job *tail;
+	uint16_t queued;
+	uint8_t  busy;			/* channels owned by a job */
+	uint8_t  ready;
+	uint32_t cutoff;
+	struct dma_copy_stats stats;
+	OS_Mutex_t sync_lock;		/* dma_copy()/dma_fill() callers */
+	OS_Semaphore_t sync_sem;
+};
+
+static struct dma_copy_ctx g_dmacpy = {
+	.cutoff = DMA_COPY_CPU_CUTOFF,
+};
+
+static void dma_copy_end(uint32_t idx);
+
+#if DMA_COPY_OPT_SW_BACKEND
+
+struct dma_copy_sw_chan {
+	uint8_t    *dst;
+	const void *src;
+	uint32_t    len;
+	uint8_t     fixed;
+	uint8_t     running;
+};
+
+static struct dma_copy_sw_chan dma_copy_sw[DMA_COPY_CHAN_NUM];
+
+static int dma_copy_sw_open(uint32_t idx)
+{
+	memset(&dma_copy_sw[idx], 0, sizeof(dma_copy_sw[idx]));
+	return 0;
+}
+
+static void dma_copy_sw_close(uint32_t idx)
+{
+	dma_copy_sw[idx].running = 0;
+}
+
+static int dma_copy_sw_start(uint32_t idx, void *dst, const void *src,
+                             uint32_t len, int fixed_src)
+{
+	struct dma_copy_sw_chan *sw = &dma_copy_sw[idx];
+
+	if (sw->running)
+		return -1;
+	sw->dst = dst;
+	sw->src = src;
+	sw->len = len;
+	sw->fixed = fixed_src;
+	sw->running = 1;
+	return 0;
+}
+
+static void dma_copy_sw_stop(uint32_t idx)
+{
+	dma_copy_sw[idx].running = 0;
+}
+
+int dma_copy_sw_run(void)
+{
+	struct dma_copy_sw_chan *sw;
+	uint32_t idx;
+	int n = 0;
+
+	for (idx = 0; idx < DMA_COPY_CHAN_NUM; ++idx) {
+		sw = &dma_copy_sw[idx];
+		if (!sw->running)
+			continue;
+		if (sw->fixed)
+			memset(sw->dst, *(const uint8_t *)sw->src, sw->len);
+		else
+			memcpy(sw->dst, sw->src, sw->len);
+		sw->running = 0;
+		++n;
+		dma_copy_end(idx);
+	}
+	return n;
+}
+
+static const struct dma_copy_backend dma_copy_be = {
+	.open  = dma_copy_sw_open,
+	.close = dma_copy_sw_close,
+	.start = dma_copy_sw_start,
+	.stop  = dma_copy_sw_stop,
+};
+
+#else /* DMA_COPY_OPT_SW_BACKEND */
+
+static DMA_Channel dma_copy_hw[DMA_COPY_CHAN_NUM];
+static volatile uint8_t dma_copy_hw_running[DMA_COPY_CHAN_NUM];
+
+static DMA_Periph dma_copy_periph(const void *addr)
+{
+#ifdef __CONFIG_PSRAM
+	if ((uint32_t)addr >= PSRAM_START_ADDR && (uint32_t)addr < PSRAM_END_ADDR)
+		return DMA_PERIPH_PSRAMC;
+#endif
+	return DMA_PERIPH_SRAM;
+}
+
+static void dma_copy_hal_end(void *arg)
+{
+	uint32_t idx = (uint32_t)arg;
+
+	if (!dma_copy_hw_running[idx])
+		return;
+	dma_copy_hw_running[idx] = 0;
+	HAL_DMA_Stop(dma_copy_hw[idx]);
+	HAL_DMA_DeInit(dma_copy_hw[idx]);
+	dma_copy_end(idx);
+}
+
+static int dma_copy_hal_open(uint32_t idx)
+{
+	dma_copy_hw[idx] = HAL_DMA_Request();
+	if (dma_copy_hw[idx] == DMA_CHANNEL_INVALID)
+		return -1;
+	dma_copy_hw_running[idx] = 0;
+	return 0;
+}
+
+static void dma_copy_hal_close(uint32_t idx)
+{
+	HAL_DMA_Release(dma_copy_hw[idx]);
+	dma_copy_hw[idx] = DMA_CHANNEL_INVALID;
+}
+
+static int dma_copy_hal_start(uint32_t idx, void *dst, const void *src,
+                              uint32_t len, int fixed_src)
+{
+	DMA_Channel chan = dma_copy_hw[idx];
+	DMA_ChannelInitParam param;
+	DMA_DataWidth width;
+	DMA_BurstLen burst;
+	uint32_t align;
+
+	/* the fill pattern is a word, only its destination matters */
+	align = (uint32_t)dst | len | (fixed_src ? 0 : (uint32_t)src);
+	if ((align & 0x3) == 0)
+		width = DMA_DATA_WIDTH_32BIT;
+	else if ((align & 0x1) == 0)
+		width = DMA_DATA_WIDTH_16BIT;
+	else
+		width = DMA_DATA_WIDTH_8BIT;
+	burst = (width == DMA_DATA_WIDTH_32BIT && (len & 0xF) == 0) ?
+	        DMA_BURST_LEN_4 : DMA_BURST_LEN_1;
+
+	memset(&param, 0, sizeof(param));
+	param.cfg = HAL_DMA_MakeChannelInitCfg(DMA_WORK_MODE_SINGLE,
+	                                       DMA_WAIT_CYCLE_2,
+	                                       DMA_BYTE_CNT_MODE_REMAIN,
+	                                       width, burst,
+	                                       DMA_ADDR_MODE_INC,
+	                                       dma_copy_periph(dst),
+	                                       width,
+	                                       fixed_src ? DMA_BURST_LEN_1 : burst,
+	                                       fixed_src ? DMA_ADDR_MODE_FIXED : DMA_ADDR_MODE_INC,
+	                                       dma_copy_periph(src));
+	param.irqType = DMA_IRQ_TYPE_END;
+	param.endCallback = dma_copy_hal_end;
+	param.endArg = (void *)idx;
+	if (HAL_DMA_Init(chan, &param) != HAL_OK)
+		return -1;
+
+	dma_copy_hw_running[idx] = 1;
+	if (HAL_DMA_Start(chan, (uint32_t)src, (uint32_t)dst, len) != HAL_OK) {
+		dma_copy_hw_running[idx] = 0;
+		HAL_DMA_DeInit(chan);
+		return -1;
+	}
+	return 0;
+}
+
+static void dma_copy_hal_stop(uint32_t idx)
+{
+	if (!dma_copy_hw_running[idx])
+		return;
+	dma_copy_hw_running[idx] = 0;
+	HAL_DMA_Stop(dma_copy_hw[idx]);
+	HAL_DMA_DeInit(dma_copy_hw[idx]);
+}
+
+static const struct dma_copy_backend dma_copy_be = {
+	.open  = dma_copy_hal_open,
+	.close = dma_copy_hal_close,
+	.start = dma_copy_hal_start,
+	.stop  = dma_copy_hal_stop,
+};
+
+#endif /* DMA_COPY_OPT_SW_BACKEND */
+
+static void dma_copy_cpu(struct dma_copy_job *job, void *dst, const void *src,
+                         uint32_t len)
+{
+	if (job->op == DMA_COPY_OP_FILL)
+		memset(dst, job->fill, len);
+	else
+		memcpy(dst, src, len);
+}
+
+static void dma_copy_list_add(struct dma_copy_list *list, struct dma_copy_job *job)
+{
+	job->next = NULL;
+	if (list->tail)
+		list->tail->next = job;
+	else
+		list->head = job;
+	list->tail = job;
+	g_dmacpy.stats.jobs++;
+}
+
+/* Report the completed jobs, called without the lock */
+static void dma_copy_complete(struct dma_copy_list *list)
+{
+	struct dma_copy_job *job, *next;
+	OS_Semaphore_t *sem;
+	dma_copy_cb cb;
+	void *arg;
+
+	for (job = list->head; job; job = next) {
+		next = job->next;
+		/* the owner may reuse the job as soon as the status changes */
+		cb = job->cb;
+		arg = job->arg;
+		sem = job->sem;
+		job->status = job->result;
+		if (cb)
+			cb(job, arg);
+		if (sem)
+			OS_SemaphoreRelease(sem);
+	}
+}
+
+/*
+ * Move the job of channel @idx forward: small segments are copied by the
+ * CPU, the next large piece is started on the engine. Return 1 if a transfer
+ * is running, 0 if the job is over and has been moved to @done.
+ * Called with the lock held.
+ */
+static int dma_copy_chan_run(uint32_t idx, struct dma_copy_list *done)
+{
+	struct dma_copy_chan *ch = &g_dmacpy.chan[idx];
+	struct dma_copy_job *job = ch->job;
+	const struct dma_copy_seg *seg;
+	uint8_t *dst;
+	const void *src;
+	uint32_t len;
+
+	while (job->cur < job->nseg) {
+		seg = &job->seg[job->cur];
+		if (job->off >= seg->len) {
+			job->cur++;
+			job->off = 0;
+			continue;
+		}
+
+		dst = (uint8_t *)seg->dst + job->off;
+		len = seg->len - job->off;
+		if (job->op == DMA_COPY_OP_FILL)
+			src = &ch->pattern;
+		else
+			src = (const uint8_t *)seg->src + job->off;
+
+		if (seg->len < g_dmacpy.cutoff) {
+			dma_copy_cpu(job, dst, src, len);
+			g_dmacpy.stats.cpu_bytes += len;
+			job->off = seg->len;
+			continue;
+		}
+
+		len = MIN(len, DMA_COPY_MAX_LEN);
+		if (dma_copy_be.start(idx, dst, src, len,
+		                      job->op == DMA_COPY_OP_FILL) == 0) {
+			ch->len = len;
+			return 1;
+		}
+		DMACPY_ERR("start %p <- %p, %u failed\n", dst, src, len);
+		job->result = DMA_COPY_ST_ERROR;
+		break;
+	}
+
+	ch->job = NULL;
+	g_dmacpy.busy--;
+	dma_copy_list_add(done, job);
+	return 0;
+}
+
+/* Hand queued jobs to idle channels, called with the lock held */
+static void dma_copy_kick(struct dma_copy_list *done)
+{
+	struct dma_copy_chan *ch;
+	struct dma_copy_job *job;
+	uint32_t idx;
+
+	for (idx = 0; idx < DMA_COPY_CHAN_NUM; ++idx) {
+		ch = &g_dmacpy.chan[idx];
+		while (ch->job == NULL && (job = g_dmacpy.head) != NULL) {
+			if ((job->flags & DMA_COPY_F_FENCE) && g_dmacpy.busy)
+				return;
+			g_dmacpy.head = job->next;
+			if (g_dmacpy.head == NULL)
+				g_dmacpy.tail = NULL;
+			g_dmacpy.queued--;
+
+			ch->job = job;
+			ch->pattern = job->fill * 0x01010101U;
+			g_dmacpy.busy++;
+			dma_copy_chan_run(idx, done);
+		}
+	}
+}
+
+/* Engine completion of channel @idx, usually in interrupt context */
+static void dma_copy_end(uint32_t idx)
+{
+	struct dma_copy_list done = { NULL, NULL };
+	struct dma_copy_chan *ch = &g_dmacpy.chan[idx];
+	unsigned long flags;
+
+	flags = arch_irq_save();
+	if (ch->job) {
+		g_dmacpy.stats.dma_bytes += ch->len;
+		ch->job->off += ch->len;
+		if (!dma_copy_chan_run(idx, &done))
+			dma_copy_kick(&done);
+	}
+	arch_irq_restore(flags);
+
+	dma_copy_complete(&done);
+}
+
+int dma_copy_init(void)
+{
+	uint32_t idx;
+
+	if (g_dmacpy.ready)
+		return 0;
+
+	for (idx = 0; idx < DMA_COPY_CHAN_NUM; ++idx) {
+		if (dma_copy_be.open(idx) != 0) {
+			DMACPY_ERR("no dma channel\n");
+			goto err;
+		}
+	}
+	if (OS_MutexCreate(&g_dmacpy.sync_lock) != OS_OK)
+		goto err;
+	if (OS_SemaphoreCreateBinary(&g_dmacpy.sync_sem) != OS_OK) {
+		OS_MutexDelete(&g_dmacpy.sync_lock);
+		goto err;
+	}
+
+	g_dmacpy.head = g_dmacpy.tail = NULL;
+	g_dmacpy.queued = 0;
+	g_dmacpy.busy = 0;
+	g_dmacpy.ready = 1;
+	DMACPY_DBG("%d channel(s), cutoff %u\n", DMA_COPY_CHAN_NUM, g_dmacpy.cutoff);
+	return 0;
+
+err:
+	while (idx-- > 0)
+		dma_copy_be.close(idx);
+	return -1;
+}
+
+int dma_copy_deinit(void)
+{
+	unsigned long flags;
+	uint32_t idx;
+
+	if (!g_dmacpy.ready)
+		return 0;
+
+	flags = arch_irq_save();
+	if (g_dmacpy.head || g_dmacpy.busy) {
+		arch_irq_restore(flags);
+		return -1;
+	}
+	g_dmacpy.ready = 0;
+	arch_irq_restore(flags);
+
+	for (idx = 0; idx < DMA_COPY_CHAN_NUM; ++idx)
+		dma_copy_be.close(idx);
+	OS_SemaphoreDelete(&g_dmacpy.sync_sem);
+	OS_MutexDelete(&g_dmacpy.sync_lock);
+	return 0;
+}
+
+int dma_copy_submit(struct dma_copy_job *job)
+{
+	struct dma_copy_list done = { NULL, NULL };
+	unsigned long flags;
+	uint32_t i, total = 0, cpu_only = 1;
+
+	if (job == NULL || (job->seg == NULL && job->nseg) ||
+	    job->op > DMA_COPY_OP_FILL)
+		return -1;
+	for (i = 0; i < job->nseg; ++i) {
+		if (job->seg[i].len == 0)
+			continue;
+		if (job->seg[i].dst == NULL ||
+		    (job->op == DMA_COPY_OP_COPY && job->seg[i].src == NULL))
+			return -1;
+		if (job->seg[i].len >= g_dmacpy.cutoff)
+			cpu_only = 0;
+		total += job->seg[i].len;
+	}
+
+	if (!g_dmacpy.ready && dma_copy_init() != 0)
+		return -1;
+
+	job->next = NULL;
+	job->cur = 0;
+	job->off = 0;
+	job->result = DMA_COPY_ST_DONE;
+	job->status = DMA_COPY_ST_PENDING;
+
+	flags = arch_irq_save();
+	if (cpu_only && g_dmacpy.head == NULL && g_dmacpy.busy == 0) {
+		/* nothing to wait for, not worth the DMA */
+		dma_copy_list_add(&done, job);
+		g_dmacpy.stats.cpu_bytes += total;
+		arch_irq_restore(flags);
+		for (i = 0; i < job->nseg; ++i) {
+			if (job->seg[i].len)
+				dma_copy_cpu(job, job->seg[i].dst, job->seg[i].src,
+				             job->seg[i].len);
+		}
+		dma_copy_complete(&done);
+		return 0;
+	}
+
+	if (g_dmacpy.tail)
+		g_dmacpy.tail->next = job;
+	else
+		g_dmacpy.head = job;
+	g_dmacpy.tail = job;
+	if (++g_dmacpy.queued > g_dmacpy.stats.max_queued)
+		g_dmacpy.stats.max_queued = g_dmacpy.queued;
+	dma_copy_kick(&done);
+	arch_irq_restore(flags);
+
+	dma_copy_complete(&done);
+	return 0;
+}
+
+int dma_copy_wait(struct dma_copy_job *job, OS_Time_t waitMS)
+{
+	/* the semaphore may hold a release of an earlier job, check again */
+	while (job->status == DMA_COPY_ST_PENDING && job->sem) {
+		if (OS_SemaphoreWait(job->sem, waitMS) != OS_OK)
+			break;
+	}
+	return job->status;
+}
+
+int dma_copy_cancel(struct dma_copy_job *job)
+{
+	struct dma_copy_list done = { NULL, NULL };
+	struct dma_copy_job **pp, *prev = NULL;
+	unsigned long flags;
+	uint32_t idx;
+
+	flags = arch_irq_save();
+	if (job->status != DMA_COPY_ST_PENDING) {
+		arch_irq_restore(flags);
+		return -1;
+	}
+
+	for (pp = &g_dmacpy.head; *pp; prev = *pp, pp = &(*pp)->next) {
+		if (*pp == job)
+			break;
+	}
+	if (*pp) {
+		*pp = job->next;
+		if (g_dmacpy.tail == job)
+			g_dmacpy.tail = prev;
+		g_dmacpy.queued--;
+	} else {
+		for (idx = 0; idx < DMA_COPY_CHAN_NUM; ++idx) {
+			if (g_dmacpy.chan[idx].job == job)
+				break;
+		}
+		if (idx == DMA_COPY_CHAN_NUM) {
+			/* already being reported */
+			arch_irq_restore(flags);
+			return -1;
+		}
+		dma_copy_be.stop(idx);
+		g_dmacpy.chan[idx].job = NULL;
+		g_dmacpy.busy--;
+	}
+	job->result = DMA_COPY_ST_CANCELED;
+	dma_copy_list_add(&done, job);
+	dma_copy_kick(&done);
+	arch_irq_restore(flags);
+
+	dma_copy_complete(&done);
+	return 0;
+}
+
+static int dma_copy_sync(struct dma_copy_job *job)
+{
+	int ret;
+
+	if (!g_dmacpy.ready && dma_copy_init() != 0)
+		return -1;
+
+	OS_MutexLock(&g_dmacpy.sync_lock, OS_WAIT_FOREVER);
+	job->cb = NULL;
+	job->sem = &g_dmacpy.sync_sem;
+	ret = dma_copy_submit(job);
+	if (ret == 0) {
+		ret = dma_copy_wait(job, DMA_COPY_SYNC_TIMEOUT);
+		if (ret == DMA_COPY_ST_PENDING) {
+			DMACPY_ERR("timeout\n");
+			dma_copy_cancel(job);
+		}
+		ret = (ret == DMA_COPY_ST_DONE) ? 0 : -1;
+		/* drop a release left by the completion */
+		OS_SemaphoreWait(&g_dmacpy.sync_sem, 0);
+	}
+	OS_MutexUnlock(&g_dmacpy.sync_lock);
+	return ret;
+}
+
+int dma_copy(void *dst, const void *src, uint32_t len)
+{
+	struct dma_copy_seg seg = { dst, src, len };
+	struct dma_copy_job job;
+
+	if (len < g_dmacpy.cutoff) {
+		memcpy(dst, src, len);
+		return 0;
+	}
+	memset(&job, 0, sizeof(job));
+	job.seg = &seg;
+	job.nseg = 1;
+	job.op = DMA_COPY_OP_COPY;
+	return dma_copy_sync(&job);
+}
+
+int dma_fill(void *dst, uint8_t c, uint32_t len)
+{
+	struct dma_copy_seg seg = { dst, NULL, len };
+	struct dma_copy_job job;
+
+	if (len < g_dmacpy.cutoff) {
+		memset(dst, c, len);
+		return 0;
+	}
+	memset(&job, 0, sizeof(job));
+	job.seg = &seg;
+	job.nseg = 1;
+	job.op = DMA_COPY_OP_FILL;
+	job.fill = c;
+	return dma_copy_sync(&job);
+}
+
+void dma_copy_set_cutoff(uint32_t bytes)
+{
+	g_dmacpy.cutoff = bytes;
+}
+
+uint32_t dma_copy_get_cutoff(void)
+{
+	return g_dmacpy.cutoff;
+}
+
+void dma_copy_get_stats(struct dma_copy_stats *stats)
+{
+	unsigned long flags;
+
+	flags = arch_irq_save();
+	*stats = g_dmacpy.stats;
+	arch_irq_restore(flags);
+}
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef __CONFIG_TIMELINE
+
+#include <stdio.h>
+#include "compiler.h"
+#include "sys/interrupt.h"
+#include "util/timeline.h"
+
+typedef char timeline_retain_size_check[
+	(sizeof(struct timeline_retain) <= TIMELINE_RETAIN_SIZE) ? 1 : -1];
+
+static struct timeline_span tl_span[TIMELINE_SPAN_MAX];
+static char tl_boot_name[TIMELINE_RETAIN_SPANS][TIMELINE_RETAIN_NAME_LEN + 1];
+static uint16_t tl_count;
+static uint16_t tl_boot_count;
+static uint16_t tl_lost;
+static uint8_t tl_depth;
+
+void timeline_init(void)
+{
+	struct timeline_retain *r = (struct timeline_retain *)TIMELINE_RETAIN_ADDR;
+	struct timeline_span *s;
+	unsigned long flags;
+	int i, n;
+
+	if (r->magic != TIMELINE_RETAIN_MAGIC)
+		return;
+
+	n = r->count < TIMELINE_RETAIN_SPANS ? r->count : TIMELINE_RETAIN_SPANS;
+	r->magic = 0; /* import once, a warm reboot may skip the bootloader */
+
+	flags = arch_irq_save();
+	if (tl_boot_count != 0 || n + tl_count > TIMELINE_SPAN_MAX) {
+		arch_irq_restore(flags);
+		return;
+	}
+	/* the bootloader ran first, keep its spans at the front */
+	memmove(&tl_span[n], &tl_span[0], tl_count * sizeof(tl_span[0]));
+	for (i = 0; i < n; i++) {
+		memcpy(tl_boot_name[i], r->span[i].name, TIMELINE_RETAIN_NAME_LEN);
+		tl_boot_name[i][TIMELINE_RETAIN_NAME_LEN] = '\0';
+		s = &tl_span[i];
+		s->name = tl_boot_name[i];
+		s->start = r->span[i].start;
+		s->end = r->span[i].end;
+		s->depth = r->span[i].depth;
+		s->flags = TIMELINE_F_BOOT;
+		if (s->start == s->end)
+			s->flags |= TIMELINE_F_MARK;
+	}
+	tl_count += n;
+	tl_boot_count = n;
+	arch_irq_restore(flags);
+}
+
+/* may run from IRQs */
+static struct timeline_span *timeline_add(const char *name, uint8_t flags)
+{
+	struct timeline_span *s = NULL;
+	unsigned long irq;
+
+	irq = arch_irq_save();
+	if (tl_count < TIMELINE_SPAN_MAX) {
+		s = &tl_span[tl_count++];
+		s->name = name;
+		s->depth = tl_depth;
+		s->flags = flags;
+		s->start = timeline_now();
+		s->end = (flags & TIMELINE_F_MARK) ? s->start : 0;
+		if (!(flags & TIMELINE_F_MARK))
+			tl_depth++;
+	} else {
+		tl_lost++;
+	}
+	arch_irq_restore(irq);
+	return s;
+}
+
+void timeline_begin(const char *name)
+{
+	timeline_add(name, 0);
+}
+
+void timeline_end(const char *name)
+{
+	struct timeline_span *s;
+	unsigned long flags;
+	uint32_t now;
+	int i;
+
+	now = timeline_now();
+	flags = arch_irq_save();
+	for (i = tl_count - 1; i >= tl_boot_count; i--) {
+		s = &tl_span[i];
+		if (s->end == 0 && (s->name == name || strcmp(s->name, name) == 0)) {
+			s->end = now;
+			tl_depth--;
+			break;
+		}
+	}
+	arch_irq_restore(flags);
+}
+
+void timeline_mark(const char *name)
+{
+	timeline_add(name, TIMELINE_F_MARK);
+}
+
+void timeline_reset(void)
+{
+	unsigned long flags;
+
+	flags = arch_irq_save();
+	tl_count = tl_boot_count;
+	tl_depth = 0;
+	tl_lost = 0;
+	arch_irq_restore(flags);
+}
+
+int timeline_get(struct timeline_span *span, int max)
+{
+	unsigned long flags;
+	int n;
+
+	flags = arch_irq_save();
+	n = tl_count < max ? tl_count : max;
+	memcpy(span, tl_span, n * sizeof(tl_span[0]));
+	arch_irq_restore(flags);
+	return n;
+}
+
+void timeline_show(void)
+{
+	struct timeline_span *s;
+	uint32_t now, first, end;
+	int i;
+
+	now = timeline_now();
+	first = tl_count ? tl_span[0].start : now;
+	printf("%10s %10s  %s\n", "start(us)", "dur(us)", "span");
+	for (i = 0; i < tl_count; i++) {
+		s = &tl_span[i];
+		if (s->flags & TIMELINE_F_MARK) {
+			printf("%10u %10s  %*s* %s\n", s->start, "",
+			       s->depth * 2, "", s->name);
+			continue;
+		}
+		end = s->end ? s->end : now;
+		printf("%10u %10u  %*s%s%s%s\n", s->start, end - s->start,
+		       s->depth * 2, "", s->name,
+		       (s->flags & TIMELINE_F_BOOT) ? " [boot]" : "",
+		       s->end ? "" : " [open]");
+	}
+	printf("%u us since power on, %u us since the first span", now, now - first);
+	if (tl_lost)
+		printf(", %u spans lost", tl_lost);
+	printf("\n");
+}
+
+static void timeline_print_name(const char *name)
+{
+	for (; *name; name++) {
+		if (*name == '"' || *name == '\\')
+			putchar('\\');
+		if ((unsigned char)*name >= ' ')
+			putchar(*name);
+	}
+}
+
+void timeline_export(void)
+{
+	struct timeline_span *s;
+	uint32_t now;
+	int i;
+
+	now = timeline_now();
+	printf("timeline json begin\n{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,"
+	       "\"args\":{\"name\":\"bootloader\"}},\n");
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,"
+	       "\"args\":{\"name\":\"app\"}}");
+	for (i = 0; i < tl_count; i++) {
+		s = &tl_span[i];
+		printf(",\n{\"name\":\"");
+		timeline_print_name(s->name);
+		if (s->flags & TIMELINE_F_MARK) {
+			printf("\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%u", s->start);
+		} else {
+			printf("\",\"ph\":\"X\",\"ts\":%u,\"dur\":%u", s->start,
+			       (s->end ? s->end : now) - s->start);
+		}
+		printf(",\"pid\":0,\"tid\":%d,\"args\":{\"depth\":%u%s}}",
+		       (s->flags & TIMELINE_F_BOOT) ? 0 : 1, s->depth,
+		       s->end ? "" : ",\"open\":1");
+	}
+	printf("\n]}\ntimeline json end\n");
+}
+
+#endif /* __CONFIG_TIMELINE */
@@ -0,0 +1,150 @@
+/*
+ * at_queue: byte-wise get/peek and the span API (get_span, consume, read)
+ * return the source stream unchanged whatever chunk sizes the source
+ * delivers and whatever mix of calls the reader uses.
+ */
+
+#include <string.h>
+#include "test.h"
+#include "atcmd_test.h"
+#include "atcmd/at_command.h"
+#include "at_private.h"
+
+#define STREAM_LEN	(256 * 1024)
+
+static u8 stream[STREAM_LEN];
+static s32 stream_pos;
+static uint32_t src_seed;
+static s32 src_max;		/* largest chunk the source hands over */
+
+/* returns 1..src_max bytes, or nothing now and then like an idle UART */
+static s32 src_read(u8 *buf, s32 size)
+{
+	s32 n = test_rand(&src_seed) % (src_max + 1);
+
+	if (n > size)
+		n = size;
+	if (n > STREAM_LEN - stream_pos)
+		n = STREAM_LEN - stream_pos;
+	memcpy(buf, stream + stream_pos, n);
+	stream_pos += n;
+	return n;
+}
+
+static void at_queue_test_mixed(void)
+{
+	static u8 qbuf[1024], out[STREAM_LEN];
+	uint32_t seed = 7;
+	s32 pos, n, len, max;
+	u8 *span, c;
+	int i;
+
+	for (i = 0; i < STREAM_LEN; i++)
+		stream[i] = test_rand(&seed);
+
+	for (max = 1; max <= 2 * sizeof(qbuf); max *= 4) {
+		stream_pos = 0;
+		src_seed = max;
+		src_max = max;
+		TEST_ASSERT_EQ(at_queue_init(qbuf, sizeof(qbuf), src_read), 0);
+
+		pos = 0;
+		while (pos < STREAM_LEN) {
+			switch (test_rand(&seed) % 4) {
+			case 0:
+				if (at_queue_peek(&c) == AQEC_OK) {
+					TEST_ASSERT_EQ(c, stream[pos]);
+					TEST_ASSERT_EQ(at_queue_get(&c), AQEC_OK);
+					out[pos++] = c;
+				}
+				break;
+			case 1:
+				len = at_queue_get_span(&span);
+				TEST_ASSERT(len >= 0 && len <= sizeof(qbuf));
+				n = len ? test_rand(&seed) % len + 1 : 0;
+				memcpy(out + pos, span, n);
+				at_queue_consume(n);
+				pos += n;
+				break;
+			default:
+				n = test_rand(&seed) % 3000;
+				if (n > STREAM_LEN - pos)
+					n = STREAM_LEN - pos;
+				len = at_queue_read(out + pos, n);
+				TEST_ASSERT(len >= 0 && len <= n);
+				pos += len;
+				break;
+			}
+		}
+		TEST_ASSERT(memcmp(out, stream, STREAM_LEN) == 0);
+
+		/* drained: everything reports empty */
+		TEST_ASSERT_EQ(at_queue_get(&c), AQEC_EMPTY);
+		TEST_ASSERT_EQ(at_queue_get_span(&span), 0);
+		TEST_ASSERT_EQ(at_queue_read(out, 16), 0);
+	}
+}
+
+/* consuming more than is queued only drops what is there */
+static void at_queue_test_consume(void)
+{
+	static u8 qbuf[64];
+	s32 start = STREAM_LEN - 100;
+	u8 *span, c;
+	s32 len;
+
+	stream_pos = start;
+	src_seed = 1;
+	src_max = 1000;
+	at_queue_init(qbuf, sizeof(qbuf), src_read);
+
+	while ((len = at_queue_get_span(&span)) == 0)
+		;
+	TEST_ASSERT(len <= sizeof(qbuf));
+	at_queue_consume(len + 50);
+	while (at_queue_get(&c) != AQEC_OK)
+		;
+	TEST_ASSERT_EQ(c, stream[start + len]);
+
+	TEST_ASSERT_EQ(at_queue_init(NULL, 16, src_read), -1);
+	TEST_ASSERT_EQ(at_queue_init(qbuf, 16, NULL), -1);
+}
+
+static void at_queue_bench(void)
+{
+	static u8 qbuf[2048], out[4096];
+	uint64_t t[2];
+	s32 total;
+	u8 c;
+
+	src_max = sizeof(qbuf);
+
+	stream_pos = 0;
+	src_seed = 3;
+	at_queue_init(qbuf, sizeof(qbuf), src_read);
+	t[0] = test_now_ns();
+	for (total = 0; total < STREAM_LEN; ) {
+		if (at_queue_get(&c) == AQEC_OK)
+			total++;
+	}
+	t[0] = test_now_ns() - t[0];
+
+	stream_pos = 0;
+	src_seed = 3;
+	at_queue_init(qbuf, sizeof(qbuf), src_read);
+	t[1] = test_now_ns();
+	for (total = 0; total < STREAM_LEN; )
+		total += at_queue_read(out, sizeof(out));
+	t[1] = test_now_ns() - t[1];
+
+	printf("\nat_queue drain, %d KB\n", STREAM_LEN / 1024);
+	printf("  at_queue_get   %8.1f MB/s\n", STREAM_LEN * 1e3 / t[0]);
+	printf("  at_queue_read  %8.1f MB/s\n", STREAM_LEN * 1e3 / t[1]);
+}
+
+void at_queue_test(void)
+{
+	TEST_RUN(at_queue_test_mixed);
+	TEST_RUN(at_queue_test_consume);
+	at_queue_bench();
+}
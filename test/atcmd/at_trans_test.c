@@ -0,0 +1,244 @@
+/*
+ * at_trans data mode fed by a simulated 921600 baud UART on a virtual
+ * clock: the stream arrives byte exact, packets are cut by size and by
+ * idle time, the escape sequence only counts between two idle gaps, and
+ * the sustained rate is measured against the line rate.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "atcmd_test.h"
+#include "atcmd/at_command.h"
+#include "at_private.h"
+#include "kernel/os/os.h"
+
+#define LINE_BPS	(921600 / 10)	/* 8N1 */
+#define STREAM_LEN	(4 << 20)
+
+/* what at_trans.c needs from the rest of the AT layer and the OS */
+at_callback_t at_callback;
+at_config_t at_cfg;
+u8 at_socket_buf[AT_SOCKET_BUFFER_SIZE];
+uint32_t OS_TickRateHz = 1000;
+
+static double vt_us;		/* virtual time */
+
+OS_Time_t OS_GetTicks(void)
+{
+	return (OS_Time_t)(vt_us / 1000);
+}
+
+static long nr_sleep;
+
+void OS_MSleep(OS_Time_t msec)
+{
+	vt_us += msec * 1000.0;
+	nr_sleep++;
+}
+
+static u8 *stream;
+static double *arrive;		/* arrival time of each byte */
+static long stream_len, stream_pos;
+
+/* like serial_read(): return what has arrived, else wait up to 10 ms */
+static s32 uart_read(u8 *buf, s32 size)
+{
+	s32 n = 0;
+
+	while (stream_pos < stream_len && arrive[stream_pos] <= vt_us && n < size)
+		buf[n++] = stream[stream_pos++];
+	if (n == 0) {
+		if (stream_pos < stream_len && arrive[stream_pos] - vt_us < 10000)
+			vt_us = arrive[stream_pos];
+		else
+			vt_us += 10000;
+	}
+	return n;
+}
+
+static u8 *sink;
+static long sink_len, nr_packets, nr_idle, max_packet;
+
+static AT_ERROR_CODE sink_cb(AT_CALLBACK_CMD cmd, at_callback_para_t *para,
+                             at_callback_rsp_t *rsp)
+{
+	s32 len = para->u.mode.len;
+
+	if (cmd != ACC_MODE)
+		return AEC_UNDEFINED;
+	if (len == 0) {
+		nr_idle++;
+		return AEC_OK;
+	}
+	memcpy(sink + sink_len, para->u.mode.buf, len);
+	sink_len += len;
+	nr_packets++;
+	if (len > max_packet)
+		max_packet = len;
+	return AEC_OK;
+}
+
+static void trans_start(void)
+{
+	static u8 qbuf[2048];
+
+	stream_pos = 0;
+	vt_us = 0;
+	sink_len = 0;
+	nr_packets = 0;
+	nr_idle = 0;
+	max_packet = 0;
+	at_callback.handle_cb = sink_cb;
+	at_queue_init(qbuf, sizeof(qbuf), uart_read);
+}
+
+/* escape inside data, or incomplete before a gap, is passed through */
+static void at_trans_test_escape(void)
+{
+	static const char *data[] = { "ab+++cd", "+++x", "++", "+", "", "x+++" };
+	long len, i;
+	int k;
+
+	for (k = 0; k < sizeof(data) / sizeof(data[0]); k++) {
+		len = strlen(data[k]);
+		memcpy(stream, data[k], len);
+		for (i = 0; i < len; i++)
+			arrive[i] = 30000 + i * 100;
+		memcpy(stream + len, "+++", 3);
+		for (i = 0; i < 3; i++)
+			arrive[len + i] = 200000 + i * 100;
+		stream_len = len + 3;
+
+		trans_start();
+		TEST_ASSERT_EQ(at_trans("+++"), AEC_OK);
+		TEST_ASSERT_EQ(sink_len, len);
+		TEST_ASSERT(memcmp(sink, data[k], len) == 0);
+		TEST_ASSERT_EQ(stream_pos, stream_len);
+	}
+
+	/* "+++" followed by data without a gap is data too */
+	memcpy(stream, "+++yz+++", 8);
+	for (i = 0; i < 5; i++)
+		arrive[i] = 30000 + i * 100;
+	for (i = 5; i < 8; i++)
+		arrive[i] = 200000 + i * 100;
+	stream_len = 8;
+	trans_start();
+	TEST_ASSERT_EQ(at_trans("+++"), AEC_OK);
+	TEST_ASSERT_EQ(sink_len, 5);
+	TEST_ASSERT(memcmp(sink, "+++yz", 5) == 0);
+}
+
+/* a short burst goes out after the idle time, not held for a full packet */
+static void at_trans_test_idle(void)
+{
+	long i;
+
+	for (i = 0; i < 10; i++) {
+		stream[i] = 'a' + i;
+		arrive[i] = 1000 + i * 100;
+	}
+	memcpy(stream + 10, "+++", 3);
+	for (i = 10; i < 13; i++)
+		arrive[i] = 500000 + i * 100;
+	stream_len = 13;
+
+	trans_start();
+	TEST_ASSERT_EQ(at_trans("+++"), AEC_OK);
+	TEST_ASSERT_EQ(nr_packets, 1);
+	TEST_ASSERT_EQ(sink_len, 10);
+	TEST_ASSERT(nr_idle > 0);
+}
+
+static long nr_reads;
+
+/* a source that returns at once, "+++" only after 200 ms */
+static s32 nowait_read(u8 *buf, s32 size)
+{
+	nr_reads++;
+	if (stream_pos < stream_len && arrive[stream_pos] <= vt_us) {
+		buf[0] = stream[stream_pos++];
+		return 1;
+	}
+	return 0;
+}
+
+/* the queue sleeps between empty reads, the peer is polled once per idle */
+static void at_trans_test_nowait(void)
+{
+	static u8 qbuf[64];
+	long i;
+
+	memcpy(stream, "+++", 3);
+	for (i = 0; i < 3; i++)
+		arrive[i] = 200000 + i * 100;
+	stream_len = 3;
+
+	trans_start();
+	at_queue_init(qbuf, sizeof(qbuf), nowait_read);
+	nr_reads = 0;
+	nr_sleep = 0;
+	TEST_ASSERT_EQ(at_trans("+++"), AEC_OK);
+	TEST_ASSERT_EQ(sink_len, 0);
+	TEST_ASSERT(vt_us >= 220000 && vt_us < 240000);
+	/* at most two reads per tick, one sleep per tick */
+	TEST_ASSERT(nr_sleep <= vt_us / 1000 + 1);
+	TEST_ASSERT(nr_reads <= 2 * (vt_us / 1000) + 2);
+	TEST_ASSERT(nr_idle >= 200 / AT_TRANS_IDLE_MS - 1);
+	TEST_ASSERT(nr_idle <= 220 / AT_TRANS_IDLE_MS + 1);
+}
+
+/* 4 MB with runs of '+' and an idle gap every 100000 bytes, then "+++" */
+static void at_trans_bench(void)
+{
+	uint32_t seed = 1;
+	uint64_t t;
+	double at = 0;
+	long i;
+
+	for (i = 0; i < STREAM_LEN; i++) {
+		stream[i] = (test_rand(&seed) % 8 == 0) ? '+' : test_rand(&seed);
+		arrive[i] = at;
+		at += 1e6 / LINE_BPS;
+		if (i % 100000 == 99999)
+			at += 30000;
+	}
+	memcpy(stream + STREAM_LEN, "+++", 3);
+	for (i = 0; i < 3; i++)
+		arrive[STREAM_LEN + i] = at + 50000 + i * 10;
+	stream_len = STREAM_LEN + 3;
+
+	trans_start();
+	t = test_now_ns();
+	TEST_ASSERT_EQ(at_trans("+++"), AEC_OK);
+	t = test_now_ns() - t;
+
+	TEST_ASSERT_EQ(sink_len, STREAM_LEN);
+	TEST_ASSERT(memcmp(sink, stream, STREAM_LEN) == 0);
+	TEST_ASSERT_EQ(max_packet, AT_TRANS_PACKET_SIZE);
+	/* one short packet per burst at most, everything else full size */
+	TEST_ASSERT(nr_packets <= STREAM_LEN / AT_TRANS_PACKET_SIZE + STREAM_LEN / 100000 + 1);
+
+	printf("\n%d KB at %d B/s line rate\n", STREAM_LEN / 1024, LINE_BPS);
+	printf("  sustained %.1f KB/s (virtual time), %ld packets\n",
+	       STREAM_LEN / (arrive[STREAM_LEN - 1] / 1e6) / 1e3, nr_packets);
+	printf("  host CPU  %.1f MB/s\n", STREAM_LEN * 1e3 / t);
+}
+
+void at_trans_test(void)
+{
+	stream = malloc(STREAM_LEN + 64);
+	arrive = malloc((STREAM_LEN + 64) * sizeof(double));
+	sink = malloc(STREAM_LEN + 64);
+	TEST_ASSERT(stream && arrive && sink);
+
+	TEST_RUN(at_trans_test_escape);
+	TEST_RUN(at_trans_test_idle);
+	TEST_RUN(at_trans_test_nowait);
+	at_trans_bench();
+
+	free(stream);
+	free(arrive);
+	free(sink);
+}
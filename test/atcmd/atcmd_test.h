@@ -0,0 +1,7 @@
+#ifndef _ATCMD_TEST_H_
+#define _ATCMD_TEST_H_
+
+void at_queue_test(void);
+void at_trans_test(void);
+
+#endif /* _ATCMD_TEST_H_ */
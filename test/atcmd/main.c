@@ -0,0 +1,9 @@
+#include "test.h"
+#include "atcmd_test.h"
+
+int main(int argc, char **argv)
+{
+	at_queue_test();
+	at_trans_test();
+	return 0;
+}
@@ -0,0 +1,308 @@
+/*
+ * cJSON_ParseInSitu(): same tree as cJSON_Parse(), hashed lookups that
+ * agree with the linear walk, the index dropped by every function that
+ * changes an object's members, and a parse + lookup benchmark against the
+ * heap parser.
+ */
+
+#include <string.h>
+#include <ctype.h>
+#include "test.h"
+#include "cjson_test.h"
+#include "cjson/cJSON.h"
+
+static char arena[32768];
+static char text[8192];		/* in-situ input, strings point into it */
+static long nr_alloc;
+
+static void *count_malloc(size_t size)
+{
+	nr_alloc++;
+	return malloc(size);
+}
+
+/* items and strings of in-situ trees live in arena and text, never free them */
+static void arena_free(void *ptr)
+{
+	if ((char *)ptr >= arena && (char *)ptr < arena + sizeof(arena))
+		return;
+	if ((char *)ptr >= text && (char *)ptr < text + sizeof(text))
+		return;
+	free(ptr);
+}
+
+static cJSON_Hooks hooks = { count_malloc, arena_free };
+
+/* ~2.7 KB cloud property payload with a 40-member object */
+static int make_payload(char *js)
+{
+	int i, n = 0;
+
+	n += sprintf(js + n, "{\"id\":\"123\",\"version\":\"1.0\","
+	             "\"method\":\"thing.service.property.set\",\"params\":{");
+	for (i = 0; i < 40; i++)
+		n += sprintf(js + n, "%s\"Prop_%02d\":{\"value\":%d,\"time\":15240%05d,"
+		             "\"str\":\"v\\u00e9\\n\\\"x%d\\\"\"}", i ? "," : "", i, i * 3, i, i);
+	n += sprintf(js + n, "},\"arr\":[1,2.5,-3e2,true,false,null,\"\\ud83d\\ude00\"]}");
+	return n;
+}
+
+static cJSON *linear_get(const cJSON *object, const char *key)
+{
+	cJSON *c;
+
+	for (c = object->child; c; c = c->next) {
+		const char *a = c->string, *b = key;
+
+		while (*a && tolower((unsigned char)*a) == tolower((unsigned char)*b)) {
+			a++;
+			b++;
+		}
+		if (tolower((unsigned char)*a) == tolower((unsigned char)*b))
+			return c;
+	}
+	return NULL;
+}
+
+/* every member, in other cases and with missing keys, as the linear walk */
+static void check_lookups(const cJSON *object)
+{
+	static const char *missing[] = { "", "Prop_40", "prop_0", "Prop_001", "x" };
+	char key[64];
+	cJSON *c;
+	int i;
+
+	for (c = object->child; c; c = c->next) {
+		TEST_ASSERT(cJSON_GetObjectItem(object, c->string) == linear_get(object, c->string));
+		for (i = 0; c->string[i] && i < sizeof(key) - 1; i++)
+			key[i] = (i & 1) ? toupper((unsigned char)c->string[i]) :
+			                   tolower((unsigned char)c->string[i]);
+		key[i] = '\0';
+		TEST_ASSERT(cJSON_GetObjectItem(object, key) == linear_get(object, c->string));
+	}
+	for (i = 0; i < sizeof(missing) / sizeof(missing[0]); i++)
+		TEST_ASSERT(cJSON_GetObjectItem(object, missing[i]) == linear_get(object, missing[i]));
+}
+
+static void cjson_test_parse(void)
+{
+	static char js[8192];
+	char *pa, *pb;
+	cJSON *a, *b;
+	size_t used;
+	int len;
+
+	len = make_payload(js);
+	a = cJSON_Parse(js);
+	memcpy(text, js, len + 1);
+	b = cJSON_ParseInSitu(text, arena, sizeof(arena), &used);
+	TEST_ASSERT(a != NULL && b != NULL);
+	TEST_ASSERT(used > 0 && used <= sizeof(arena));
+
+	pa = cJSON_PrintUnformatted(a);
+	pb = cJSON_PrintUnformatted(b);
+	TEST_ASSERT(strcmp(pa, pb) == 0);
+	free(pa);
+	free(pb);
+
+	TEST_ASSERT(cJSON_GetObjectItem(b, "params")->index != NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(b, "params")->child->index == NULL);
+	TEST_ASSERT(a->index == NULL && cJSON_GetObjectItem(a, "params")->index == NULL);
+	check_lookups(cJSON_GetObjectItem(b, "params"));
+	check_lookups(b);
+	cJSON_Delete(a);
+
+	/* no room for the tree */
+	memcpy(text, js, len + 1);
+	TEST_ASSERT(cJSON_ParseInSitu(text, arena, 1000, NULL) == NULL);
+	/* an arena with room for the tree but not for the index */
+	do {
+		memcpy(text, js, len + 1);
+		b = cJSON_ParseInSitu(text, arena, --used, NULL);
+	} while (used > 1000 && (b == NULL || cJSON_GetObjectItem(b, "params")->index));
+	TEST_ASSERT(b != NULL);
+	check_lookups(cJSON_GetObjectItem(b, "params"));
+	/* syntax error */
+	strcpy(text, "{\"a\":[1,2,}");
+	TEST_ASSERT(cJSON_ParseInSitu(text, arena, sizeof(arena), NULL) == NULL);
+}
+
+static void cjson_test_duplicate_keys(void)
+{
+	char js[] = "{\"a\":1,\"b\":2,\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"A\":8,\"h\":9}";
+	cJSON *o, *dup;
+
+	o = cJSON_ParseInSitu(js, arena, sizeof(arena), NULL);
+	TEST_ASSERT(o != NULL && o->index != NULL);
+	TEST_ASSERT_EQ(cJSON_GetObjectItem(o, "A")->valueint, 1);
+	TEST_ASSERT_EQ(cJSON_GetObjectItem(o, "h")->valueint, 9);
+	TEST_ASSERT(cJSON_GetObjectItem(o, "zz") == NULL);
+
+	/* a heap copy has no index and gives the same answers */
+	dup = cJSON_Duplicate(o, 1);
+	TEST_ASSERT(dup != NULL && dup->index == NULL);
+	TEST_ASSERT_EQ(cJSON_GetObjectItem(dup, "A")->valueint, 1);
+	cJSON_Delete(dup);
+
+	/* valueint of an object is the caller's, it must not matter */
+	o->valueint = 64;
+	check_lookups(o);
+	o->valueint = -1000000;
+	check_lookups(o);
+}
+
+static cJSON *parse_params(const char *js)
+{
+	cJSON *p;
+
+	strcpy(text, js);
+	p = cJSON_GetObjectItem(cJSON_ParseInSitu(text, arena, sizeof(arena), NULL), "params");
+	TEST_ASSERT(p != NULL && p->index != NULL);
+	return p;
+}
+
+/* every member list change drops the index, lookups stay right */
+static void cjson_test_mutators(void)
+{
+	static char js[8192];
+	cJSON *p, *item, *ref;
+
+	make_payload(js);
+
+	p = parse_params(js);
+	cJSON_AddNumberToObject(p, "Added", 7);
+	TEST_ASSERT(p->index == NULL);
+	TEST_ASSERT_EQ(cJSON_GetObjectItem(p, "added")->valueint, 7);
+	check_lookups(p);
+
+	p = parse_params(js);
+	cJSON_AddItemToObjectCS(p, "Const", cJSON_CreateTrue());
+	TEST_ASSERT(p->index == NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(p, "const") != NULL);
+
+	p = parse_params(js);
+	ref = cJSON_CreateObject();
+	cJSON_AddItemReferenceToObject(p, "Ref", ref);
+	TEST_ASSERT(p->index == NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(p, "ref") != NULL);
+	cJSON_Delete(ref);
+
+	p = parse_params(js);
+	cJSON_AddItemToArray(p, cJSON_CreateNull());
+	TEST_ASSERT(p->index == NULL);
+
+	p = parse_params(js);
+	item = cJSON_DetachItemFromObject(p, "Prop_05");
+	TEST_ASSERT(item != NULL && p->index == NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(p, "Prop_05") == NULL);
+	check_lookups(p);
+
+	p = parse_params(js);
+	cJSON_DeleteItemFromObject(p, "Prop_06");
+	TEST_ASSERT(p->index == NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(p, "Prop_06") == NULL);
+	check_lookups(p);
+
+	p = parse_params(js);
+	cJSON_DeleteItemFromArray(p, 0);
+	TEST_ASSERT(p->index == NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(p, "Prop_00") == NULL);
+
+	p = parse_params(js);
+	item = cJSON_CreateNumber(99);
+	item->string = strdup("Prop_07");
+	cJSON_InsertItemInArray(p, 3, item);
+	TEST_ASSERT(p->index == NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(p, "Prop_07") == item);
+
+	p = parse_params(js);
+	cJSON_ReplaceItemInObject(p, "Prop_08", cJSON_CreateString("new"));
+	TEST_ASSERT(p->index == NULL);
+	TEST_ASSERT(strcmp(cJSON_GetObjectItem(p, "prop_08")->valuestring, "new") == 0);
+	check_lookups(p);
+
+	p = parse_params(js);
+	item = cJSON_CreateNumber(1);
+	item->string = strdup("Prop_09");
+	cJSON_ReplaceItemInArray(p, 9, item);
+	TEST_ASSERT(p->index == NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(p, "Prop_09") == item);
+
+	/* a reference to an indexed object does not share its index */
+	p = parse_params(js);
+	ref = cJSON_CreateArray();
+	cJSON_AddItemReferenceToArray(ref, p);
+	TEST_ASSERT(ref->child->index == NULL);
+	TEST_ASSERT(cJSON_GetObjectItem(ref->child, "Prop_10") == cJSON_GetObjectItem(p, "Prop_10"));
+	cJSON_Delete(ref);
+}
+
+static void cjson_bench(void)
+{
+	static const char *keys[] = { "Prop_00", "prop_17", "PROP_39", "Prop_99" };
+	static char js[8192];
+	const int loops = 20000;
+	cJSON *r, *p, *x;
+	long sum[2] = { 0, 0 }, alloc[2];
+	uint64_t t[2], tl[2];
+	int len, k, j;
+
+	len = make_payload(js);
+
+	nr_alloc = 0;
+	t[0] = test_now_ns();
+	for (k = 0; k < loops; k++) {
+		r = cJSON_Parse(js);
+		p = cJSON_GetObjectItem(r, "params");
+		for (j = 0; j < 4; j++)
+			if ((x = cJSON_GetObjectItem(p, keys[j])) != NULL)
+				sum[0] += cJSON_GetObjectItem(x, "value")->valueint;
+		cJSON_Delete(r);
+	}
+	t[0] = test_now_ns() - t[0];
+	alloc[0] = nr_alloc / loops;
+
+	nr_alloc = 0;
+	t[1] = test_now_ns();
+	for (k = 0; k < loops; k++) {
+		memcpy(text, js, len + 1);
+		r = cJSON_ParseInSitu(text, arena, sizeof(arena), NULL);
+		p = cJSON_GetObjectItem(r, "params");
+		for (j = 0; j < 4; j++)
+			if ((x = cJSON_GetObjectItem(p, keys[j])) != NULL)
+				sum[1] += cJSON_GetObjectItem(x, "value")->valueint;
+	}
+	t[1] = test_now_ns() - t[1];
+	alloc[1] = nr_alloc / loops;
+	TEST_ASSERT_EQ(sum[0], sum[1]);
+
+	/* lookups alone: the same object with and without its index */
+	memcpy(text, js, len + 1);
+	p = cJSON_GetObjectItem(cJSON_ParseInSitu(text, arena, sizeof(arena), NULL), "params");
+	for (j = 0; j < 2; j++) {
+		tl[j] = test_now_ns();
+		for (k = 0; k < loops * 10; k++)
+			sum[j] += cJSON_GetObjectItem(p, keys[k & 3]) != NULL;
+		tl[j] = test_now_ns() - tl[j];
+		cJSON_AddItemToArray(p, cJSON_CreateNull());	/* drops the index */
+	}
+
+	printf("\n%d bytes, 40 member object, 4 lookups per parse\n", len);
+	printf("  cJSON_Parse       %4ld allocs %7.2f us per parse+lookups\n",
+	       alloc[0], t[0] / 1e3 / loops);
+	printf("  cJSON_ParseInSitu %4ld allocs %7.2f us per parse+lookups (incl. copy)\n",
+	       alloc[1], t[1] / 1e3 / loops);
+	printf("  lookup %6.1f ns indexed, %6.1f ns linear\n",
+	       (double)tl[0] / (loops * 10), (double)tl[1] / (loops * 10));
+	TEST_ASSERT_EQ(alloc[1], 0);
+}
+
+void cjson_insitu_test(void)
+{
+	cJSON_InitHooks(&hooks);
+	TEST_RUN(cjson_test_parse);
+	TEST_RUN(cjson_test_duplicate_keys);
+	TEST_RUN(cjson_test_mutators);
+	cjson_bench();
+	cJSON_InitHooks(NULL);
+}
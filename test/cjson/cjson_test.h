@@ -0,0 +1,7 @@
+#ifndef _CJSON_TEST_H_
+#define _CJSON_TEST_H_
+
+void cjson_insitu_test(void);
+void json_extract_test(void);
+
+#endif /* _CJSON_TEST_H_ */
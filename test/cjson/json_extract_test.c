@@ -0,0 +1,302 @@
+/*
+ * Streaming JSON field extractor: values against cJSON for one-shot and
+ * chunked input, buffers NUL terminated whatever the document does,
+ * truncation, syntax errors and limits, and throughput against
+ * cJSON_Parse() + cJSON_GetObjectItem().
+ */
+
+#include <string.h>
+#include "test.h"
+#include "cjson_test.h"
+#include "cjson/cJSON.h"
+#include "cjson/json_extract.h"
+
+#define NR_FIELDS	8
+#define FIELD_SIZE	256
+
+static char out[NR_FIELDS][FIELD_SIZE];
+static json_extract_field fields[NR_FIELDS];
+
+/*
+ * Extract @paths from @doc, in one call (@chunk 0), in pieces of @chunk
+ * bytes, or in random pieces of 1..7 bytes (@chunk < 0).
+ * Returns the number of fields found or JSON_EXTRACT_ERROR.
+ */
+static int extract(const char *doc, size_t len, const char **paths, int n, int chunk)
+{
+	json_extract_t ctx;
+	uint32_t seed = 9;
+	size_t ofs = 0, k;
+	int i, ret = JSON_EXTRACT_MORE, found = 0;
+
+	for (i = 0; i < n; i++) {
+		fields[i].path = paths[i];
+		fields[i].buf = out[i];
+		fields[i].size = FIELD_SIZE;
+		memset(out[i], 'x', FIELD_SIZE);	/* catch missing terminators */
+	}
+	if (chunk == 0)
+		return json_extract(doc, len, fields, n);
+
+	json_extract_init(&ctx, fields, n);
+	while (ofs < len && ret == JSON_EXTRACT_MORE) {
+		k = (chunk > 0) ? chunk : test_rand(&seed) % 7 + 1;
+		if (k > len - ofs)
+			k = len - ofs;
+		ret = json_extract_feed(&ctx, doc + ofs, k);
+		ofs += k;
+	}
+	if (ret == JSON_EXTRACT_ERROR)
+		return ret;
+	for (i = 0; i < n; i++)
+		found += !!(fields[i].flags & JSON_EXTRACT_FOUND);
+	return found;
+}
+
+/* every buffer is a C string whatever happened */
+static void check_terminated(int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		TEST_ASSERT(memchr(out[i], '\0', FIELD_SIZE) != NULL);
+		TEST_ASSERT_EQ(strlen(out[i]), fields[i].len);
+	}
+}
+
+static cJSON *nav(cJSON *r, const char *path)
+{
+	char p[128], *s;
+	cJSON *c;
+
+	strcpy(p, path);
+	for (s = strtok(p, ".[]"); s && r; s = strtok(NULL, ".[]")) {
+		if (r->type == cJSON_Array) {
+			r = cJSON_GetArrayItem(r, atoi(s));
+		} else {
+			for (c = r->child; c && strcmp(c->string, s); c = c->next)
+				;
+			r = c;
+		}
+	}
+	return r;
+}
+
+static const char doc[] =
+	"{\"id\":\"1\",\"data\":{\"iotId\":\"abc\\\"\\\\\\/\\b\\f\\n\\r\\t\\u00e9\\u4e2d\\ud83d\\ude00\","
+	"\"iotToken\":\"tok\",\"resources\":{\"mqtt\":{\"host\":\"a.b.com\",\"port\":1883}}},"
+	"\"params\":{\"powerstate\":1,\"list\":[10,[20,21,{\"x\":-3.5e+2}],{\"k\":true},null,false],"
+	"\"obj\":{ \"a\" : [ 1 , 2 ] , \"b\":\"}]\" }},\"Params\":{\"powerstate\":7}}";
+
+static const char *doc_paths[NR_FIELDS] = {
+	"data.iotId", "data.resources.mqtt.port", "params.powerstate",
+	"params.list[1][2].x", "params.list.2.k", "params.obj",
+	"params.list[3]", "params.list[4]",
+};
+
+/* all value types, one shot and chunked, against cJSON */
+static void json_extract_test_values(void)
+{
+	cJSON *root = cJSON_Parse(doc), *e, *x;
+	char *a, *b;
+	int chunk, i;
+
+	TEST_ASSERT(root != NULL);
+	for (chunk = -1; chunk <= 3; chunk++) {
+		TEST_ASSERT_EQ(extract(doc, strlen(doc), doc_paths, NR_FIELDS, chunk), NR_FIELDS);
+		check_terminated(NR_FIELDS);
+		for (i = 0; i < NR_FIELDS; i++) {
+			e = nav(root, doc_paths[i]);
+			TEST_ASSERT(e != NULL);
+			switch (e->type) {
+			case cJSON_String:
+				TEST_ASSERT_EQ(fields[i].type, JSON_EXTRACT_STRING);
+				TEST_ASSERT(strcmp(out[i], e->valuestring) == 0);
+				break;
+			case cJSON_Number:
+				TEST_ASSERT_EQ(fields[i].type, JSON_EXTRACT_NUMBER);
+				TEST_ASSERT(atof(out[i]) == e->valuedouble);
+				break;
+			case cJSON_Object:
+			case cJSON_Array:
+				x = cJSON_Parse(out[i]);
+				TEST_ASSERT(x != NULL);
+				a = cJSON_PrintUnformatted(x);
+				b = cJSON_PrintUnformatted(e);
+				TEST_ASSERT(strcmp(a, b) == 0);
+				free(a);
+				free(b);
+				cJSON_Delete(x);
+				break;
+			case cJSON_NULL:
+				TEST_ASSERT_EQ(fields[i].type, JSON_EXTRACT_NULL);
+				TEST_ASSERT(strcmp(out[i], "null") == 0);
+				break;
+			case cJSON_False:
+				TEST_ASSERT_EQ(fields[i].type, JSON_EXTRACT_FALSE);
+				break;
+			}
+		}
+	}
+	cJSON_Delete(root);
+
+	/* keys are case sensitive, missing paths are not found */
+	{
+		const char *p[] = { "Params.powerstate", "params.missing", "params.list[9]" };
+
+		TEST_ASSERT_EQ(extract(doc, strlen(doc), p, 3, 0), 1);
+		TEST_ASSERT(strcmp(out[0], "7") == 0);
+		TEST_ASSERT(fields[1].flags == 0 && out[1][0] == '\0');
+		check_terminated(3);
+	}
+
+	/* NOCASE takes the first key equal ignoring case, as cJSON does */
+	{
+		const char *p[] = { "PARAMS.PowerState", "Params.powerstate" };
+		int i;
+
+		for (i = 0; i < 2; i++) {
+			memset(&fields[i], 0, sizeof(fields[i]));
+			fields[i].flags = JSON_EXTRACT_NOCASE;
+		}
+		TEST_ASSERT_EQ(extract(doc, strlen(doc), p, 2, -1), 2);
+		TEST_ASSERT(strcmp(out[0], "1") == 0 && strcmp(out[1], "1") == 0);
+		TEST_ASSERT(fields[0].flags & JSON_EXTRACT_NOCASE);
+		memset(fields, 0, sizeof(fields));
+	}
+
+	/* the root value itself */
+	{
+		const char *p[] = { "" };
+
+		TEST_ASSERT_EQ(extract("  42 ", 5, p, 1, 0), 1);
+		TEST_ASSERT(strcmp(out[0], "42") == 0);
+	}
+}
+
+/* a document that stops anywhere leaves every buffer NUL terminated */
+static void json_extract_test_cut(void)
+{
+	const char *p[] = { "data.iotToken", "params.powerstate" };
+	size_t cut, len = strlen(doc);
+	int chunk, i, ret;
+
+	for (cut = 0; cut < len; cut++) {
+		for (chunk = -1; chunk <= 1; chunk++) {
+			ret = extract(doc, cut, doc_paths, NR_FIELDS, chunk);
+			TEST_ASSERT(ret >= 0 && ret <= NR_FIELDS);
+			check_terminated(NR_FIELDS);
+			for (i = 0; i < NR_FIELDS; i++)
+				TEST_ASSERT(fields[i].len < FIELD_SIZE);
+		}
+	}
+
+	/* fields completed before the cut are found, the cut one is not */
+	cut = strstr(doc, "\"powerstate\"") - doc + 14;
+	TEST_ASSERT_EQ(extract(doc, cut, p, 2, 0), 1);
+	TEST_ASSERT(strcmp(out[0], "tok") == 0);
+	TEST_ASSERT(!(fields[1].flags & JSON_EXTRACT_FOUND));
+	check_terminated(2);
+
+	/* cut inside a string and inside a raw object value */
+	{
+		const char *q[] = { "data.iotId", "params.obj" };
+
+		cut = strstr(doc, "\\u4e2d") - doc;
+		TEST_ASSERT_EQ(extract(doc, cut, q, 2, 0), 0);
+		check_terminated(2);
+		TEST_ASSERT(strncmp(out[0], "abc\"", 4) == 0);
+
+		cut = strstr(doc, "\"b\":") - doc;
+		TEST_ASSERT_EQ(extract(doc, cut, q, 2, -1), 1);
+		check_terminated(2);
+		TEST_ASSERT(strncmp(out[1], "{ \"a\"", 5) == 0);
+	}
+}
+
+static void json_extract_test_limits(void)
+{
+	static const char *bad[] = {
+		"{\"a\":1,}", "{\"a\" 1}", "{\"a\":\"\\x\"}", "{\"a\":tru}",
+		"{\"a\":\"\\ud800x\"}", "{\"a\":\"\x01\"}",
+	};
+	const char *p[] = { "zz" };
+	json_extract_field f = { "a", out[0], 4 };
+	char deep[64];
+	int i;
+
+	/* values longer than the buffer are cut and flagged */
+	TEST_ASSERT_EQ(json_extract("{\"a\":\"abcdef\"}", 14, &f, 1), 1);
+	TEST_ASSERT(f.flags & JSON_EXTRACT_TRUNCATED);
+	TEST_ASSERT(strcmp(out[0], "abc") == 0);
+
+	for (i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+		TEST_ASSERT_EQ(extract(bad[i], strlen(bad[i]), p, 1, 0), JSON_EXTRACT_ERROR);
+
+	memset(deep, '[', 40);
+	p[0] = "0";
+	TEST_ASSERT_EQ(extract(deep, 40, p, 1, 0), JSON_EXTRACT_ERROR);
+}
+
+static void json_extract_bench(void)
+{
+	static char big[4096];
+	const int loops = 50000;
+	json_extract_field f;
+	uint64_t t[3];
+	long sum = 0;
+	int len, k;
+	cJSON *r;
+
+	memset(&f, 0, sizeof(f));
+
+	len = sprintf(big, "{\"method\":\"thing.service.property.set\",\"params\":{");
+	for (k = 0; k < 40; k++)
+		len += sprintf(big + len, "%s\"Prop_%02d\":{\"value\":%d,\"time\":1524000%03d,\"s\":\"v\\n%d\"}",
+		               k ? "," : "", k, k, k, k);
+	len += sprintf(big + len, ",\"powerstate\":1},\"id\":\"9\",\"version\":\"1.0\"}");
+
+	t[0] = test_now_ns();
+	for (k = 0; k < loops; k++) {
+		r = cJSON_Parse(big);
+		sum += cJSON_GetObjectItem(cJSON_GetObjectItem(r, "params"), "powerstate")->valueint;
+		cJSON_Delete(r);
+	}
+	t[0] = test_now_ns() - t[0];
+
+	t[1] = test_now_ns();
+	for (k = 0; k < loops; k++) {
+		f.path = "params.powerstate";
+		f.buf = out[0];
+		f.size = 32;
+		json_extract(big, len, &f, 1);
+		sum += atoi(out[0]);
+	}
+	t[1] = test_now_ns() - t[1];
+
+	t[2] = test_now_ns();
+	for (k = 0; k < loops; k++) {
+		f.path = "version";
+		f.buf = out[0];
+		f.size = 32;
+		json_extract(big, len, &f, 1);
+		sum += out[0][0];
+	}
+	t[2] = test_now_ns() - t[2];
+	TEST_ASSERT(sum > 0);
+
+	printf("\n%d bytes, one value\n", len);
+	printf("  cJSON parse + get       %6.2f us %6.0f MB/s\n",
+	       t[0] / 1e3 / loops, (double)len * loops * 1e3 / t[0]);
+	printf("  json_extract            %6.2f us %6.0f MB/s\n",
+	       t[1] / 1e3 / loops, (double)len * loops * 1e3 / t[1]);
+	printf("  json_extract, last key  %6.2f us\n", t[2] / 1e3 / loops);
+}
+
+void json_extract_test(void)
+{
+	TEST_RUN(json_extract_test_values);
+	TEST_RUN(json_extract_test_cut);
+	TEST_RUN(json_extract_test_limits);
+	json_extract_bench();
+}
@@ -0,0 +1,13 @@
+/*
+ * cJSON host tests
+ */
+
+#include "test.h"
+#include "cjson_test.h"
+
+int main(int argc, char **argv)
+{
+	cjson_insitu_test();
+	json_extract_test();
+	return 0;
+}
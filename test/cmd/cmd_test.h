@@ -0,0 +1,6 @@
+#ifndef _CMD_TEST_H_
+#define _CMD_TEST_H_
+
+void cmd_util_test(void);
+
+#endif /* _CMD_TEST_H_ */
@@ -0,0 +1,236 @@
+/*
+ * Command table lookup: cmd_exec() and cmd2_exec() pick the same entry as
+ * the plain first-match scan for exact names, arguments, prefixes, near
+ * misses and duplicates, an index built for one entry count is not reused
+ * for another, and the lookup time against the linear scan.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "cmd_test.h"
+#include "cmd_util.h"
+
+/* console glue cmd_util.c links against, unused by these tests */
+int console_write(uint8_t *buf, int32_t len) { return len; }
+UART_ID console_get_uart_id(void) { return UART_NUM; }
+int32_t HAL_UART_Receive_Poll(UART_ID id, uint8_t *buf, int32_t size, uint32_t msec) { return 0; }
+int32_t HAL_UART_Transmit_Poll(UART_ID id, const uint8_t *buf, int32_t size) { return size; }
+
+/*
+ * cmd_exec() reports every unknown command through printf(), the misses
+ * looked up on purpose are kept off the output.
+ */
+static int quiet;
+
+int printf(const char *fmt, ...)
+{
+	va_list ap;
+	int ret;
+
+	if (quiet)
+		return 0;
+	va_start(ap, fmt);
+	ret = vprintf(fmt, ap);
+	va_end(ap);
+	return ret;
+}
+
+#define NR_ENTRIES	40
+
+static int hit;			/* entry number of the last exec called */
+static char *hit_args;
+
+#define EXEC(n)								\
+	static enum cmd_status exec_##n(char *args)			\
+	{								\
+		hit = n;						\
+		hit_args = args;					\
+		return CMD_STATUS_OK;					\
+	}
+#define EXEC8(n) EXEC(n##0) EXEC(n##1) EXEC(n##2) EXEC(n##3)		\
+		 EXEC(n##4) EXEC(n##5) EXEC(n##6) EXEC(n##7)
+EXEC8(1) EXEC8(2) EXEC8(3) EXEC8(4) EXEC8(5)
+#define REF8(n) exec_##n##0, exec_##n##1, exec_##n##2, exec_##n##3,	\
+		exec_##n##4, exec_##n##5, exec_##n##6, exec_##n##7
+static enum cmd_status (*const execs[NR_ENTRIES])(char *) = {
+	REF8(1), REF8(2), REF8(3), REF8(4), REF8(5)
+};
+#define EXEC_ID(i)	((i) / 8 * 10 + 10 + (i) % 8)
+
+/* names with shared prefixes, a duplicate and a name that is a prefix of another */
+static const char *names[NR_ENTRIES] = {
+	"help", "ifconfig", "iperf", "wlan", "wlan_ap", "wps", "wps pin", "wps pin ",
+	"sysinfo", "reboot", "heap", "mem", "mem", "upgrade", "ota", "efpg",
+	"pm", "pm_test", "rtc", "gpio", "uart", "spi", "i2c", "adc",
+	"pwm", "ir", "ce", "crypto", "fs", "fs_test", "audio", "cedarx",
+	"a", "b", "ab", "ba", "zz", "z", "HELP", "Help",
+};
+
+static struct cmd_data cdata[NR_ENTRIES];
+static struct cmd2_data cdata2[NR_ENTRIES];
+
+static int linear(const char *cmd, int count)
+{
+	int i;
+
+	for (i = 0; i < count; ++i) {
+		if (strcmp(cmd, cdata[i].name) == 0)
+			return i;
+	}
+	return -1;
+}
+
+static int linear2(const char *cmd, int count)
+{
+	int i;
+
+	for (i = 0; i < count; ++i) {
+		if (strncmp(cmd, cdata2[i].name, cdata2[i].name_len) == 0)
+			return i;
+	}
+	return -1;
+}
+
+static int lookup(const char *cmd, int count)
+{
+	char buf[64];
+	enum cmd_status status;
+
+	strcpy(buf, cmd);
+	hit = -1;
+	quiet = 1;
+	status = cmd_exec(buf, cdata, count);
+	quiet = 0;
+	TEST_ASSERT((status == CMD_STATUS_UNKNOWN_CMD) == (hit == -1));
+	return hit;
+}
+
+static int lookup2(const char *cmd, int count)
+{
+	char buf[64];
+
+	strcpy(buf, cmd);
+	hit = -1;
+	quiet = 1;
+	cmd2_exec(buf, cdata2, count);
+	quiet = 0;
+	return hit;
+}
+
+static int exec_index(int id)
+{
+	return id < 0 ? -1 : (id / 10 - 1) * 8 + id % 10;
+}
+
+static void check(const char *q, int count)
+{
+	char name[64];
+	int want;
+
+	/* cmd_exec() matches the name before the first space */
+	strcpy(name, q);
+	if (strchr(name, ' '))
+		*strchr(name, ' ') = '\0';
+	want = linear(name, count);
+	TEST_ASSERT_EQ(exec_index(lookup(q, count)), want);
+	if (want >= 0 && strchr(q, ' '))
+		TEST_ASSERT(strcmp(hit_args, strchr(q, ' ') + 1) == 0);
+
+	TEST_ASSERT_EQ(exec_index(lookup2(q, count)), linear2(q, count));
+}
+
+static void cmd_util_test_match(void)
+{
+	static const int counts[] = { NR_ENTRIES, 7, 8, 20, NR_ENTRIES };
+	uint32_t seed = 5;
+	char q[64];
+	int c, i, k, len;
+
+	for (c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+		for (i = 0; i < NR_ENTRIES; i++) {
+			len = strlen(names[i]);
+			check(names[i], counts[c]);
+			snprintf(q, sizeof(q), "%s 1 2", names[i]);
+			check(q, counts[c]);
+			snprintf(q, sizeof(q), "%sx", names[i]);
+			check(q, counts[c]);
+			for (k = 0; k < len; k++) {
+				snprintf(q, sizeof(q), "%.*s", k, names[i]);
+				check(q, counts[c]);
+			}
+			strcpy(q, names[i]);
+			q[test_rand(&seed) % len] ^= 1;
+			check(q, counts[c]);
+		}
+		for (i = 0; i < 200; i++) {
+			len = test_rand(&seed) % 6;
+			for (k = 0; k < len; k++)
+				q[k] = 'a' + test_rand(&seed) % 26;
+			q[len] = '\0';
+			check(q, counts[c]);
+		}
+	}
+
+	/* duplicates resolve to the first one in table order */
+	TEST_ASSERT_EQ(exec_index(lookup("mem", NR_ENTRIES)), 11);
+}
+
+/* the same table passed with a smaller count only sees those entries */
+static void cmd_util_test_count(void)
+{
+	TEST_ASSERT_EQ(exec_index(lookup("cedarx", NR_ENTRIES)), 31);
+	TEST_ASSERT_EQ(lookup("cedarx", 20), -1);
+	TEST_ASSERT_EQ(exec_index(lookup("rtc", 20)), 18);
+	TEST_ASSERT_EQ(lookup("rtc", 10), -1);
+	TEST_ASSERT_EQ(exec_index(lookup("cedarx", NR_ENTRIES)), 31);
+
+	TEST_ASSERT_EQ(exec_index(lookup2("Help", NR_ENTRIES)), 39);
+	TEST_ASSERT_EQ(lookup2("Help", 30), -1);
+	TEST_ASSERT_EQ(exec_index(lookup2("Help", NR_ENTRIES)), 39);
+}
+
+static void cmd_util_bench(void)
+{
+	const int loops = 1000000;
+	const char *last = names[NR_ENTRIES - 9];	/* "cedarx" */
+	uint64_t t[2];
+	char buf[64];
+	int i;
+
+	t[0] = test_now_ns();
+	for (i = 0; i < loops; i++) {
+		strcpy(buf, last);
+		hit += linear(buf, NR_ENTRIES);
+	}
+	t[0] = test_now_ns() - t[0];
+
+	t[1] = test_now_ns();
+	for (i = 0; i < loops; i++) {
+		strcpy(buf, last);
+		cmd_exec(buf, cdata, NR_ENTRIES);
+	}
+	t[1] = test_now_ns() - t[1];
+
+	printf("\n%d entry table, lookup of entry %d\n", NR_ENTRIES, NR_ENTRIES - 9);
+	printf("  linear scan  %6.1f ns\n", (double)t[0] / loops);
+	printf("  cmd_exec     %6.1f ns\n", (double)t[1] / loops);
+}
+
+void cmd_util_test(void)
+{
+	int i;
+
+	for (i = 0; i < NR_ENTRIES; i++) {
+		cdata[i].name = (char *)names[i];
+		cdata[i].exec = execs[i];
+		cdata2[i].name = (char *)names[i];
+		cdata2[i].name_len = strlen(names[i]);
+		cdata2[i].exec = execs[i];
+	}
+
+	TEST_RUN(cmd_util_test_match);
+	TEST_RUN(cmd_util_test_count);
+	cmd_util_bench();
+}
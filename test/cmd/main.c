@@ -0,0 +1,8 @@
+#include "test.h"
+#include "cmd_test.h"
+
+int main(int argc, char **argv)
+{
+	cmd_util_test();
+	return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * Minimal helpers shared by the host tests in test/
+ */
+
+#ifndef _TEST_H_
+#define _TEST_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#define TEST_ASSERT(cond)						\
+	do {								\
+		if (!(cond)) {						\
+			printf("%s:%d: assertion failed: %s\n",		\
+			       __FILE__, __LINE__, #cond);		\
+			exit(1);					\
+		}							\
+	} while (0)
+
+#define TEST_ASSERT_EQ(a, b)						\
+	do {								\
+		long long _a = (long long)(a), _b = (long long)(b);	\
+		if (_a != _b) {						\
+			printf("%s:%d: %s == %lld, expected %s == %lld\n",\
+			       __FILE__, __LINE__, #a, _a, #b, _b);	\
+			exit(1);					\
+		}							\
+	} while (0)
+
+#define TEST_RUN(fn)							\
+	do {								\
+		printf("%-40s", #fn);					\
+		fflush(stdout);						\
+		fn();							\
+		printf(" ok\n");					\
+	} while (0)
+
+static inline uint64_t test_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Deterministic xorshift32, tests must not depend on libc rand() */
+static inline uint32_t test_rand(uint32_t *state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+#endif /* _TEST_H_ */
@@ -0,0 +1,280 @@
+/*
+ * DMA copy service on the software engine: random scatter copy/fill jobs
+ * land byte exact and complete in order (fences on several channels), the
+ * CPU cutoff, cancel of queued and running jobs, the blocking helpers
+ * with their timeout recovery, and block loads the way the PSRAM loader
+ * issues them.
+ */
+
+#include <string.h>
+#include "test.h"
+#include "dma_copy_test.h"
+#include "sys/dma_copy.h"
+
+/*
+ * Simulated OS: a semaphore wait runs the software engine until the
+ * semaphore is released, like a thread sleeping while the DMA interrupt
+ * completes the transfers. test_stall keeps the engine from progressing.
+ */
+int test_irq_depth;
+uint32_t OS_TickRateHz = 1000;
+
+static int sems[8], nr_sems;
+static int test_stall;
+
+OS_Status OS_MutexCreate(OS_Mutex_t *mutex)
+{
+	mutex->handle = (void *)1;
+	return OS_OK;
+}
+
+OS_Status OS_MutexDelete(OS_Mutex_t *mutex)
+{
+	mutex->handle = NULL;
+	return OS_OK;
+}
+
+OS_Status OS_MutexLock(OS_Mutex_t *mutex, OS_Time_t waitMS)
+{
+	return OS_OK;
+}
+
+OS_Status OS_MutexUnlock(OS_Mutex_t *mutex)
+{
+	return OS_OK;
+}
+
+OS_Status OS_SemaphoreCreateBinary(OS_Semaphore_t *sem)
+{
+	TEST_ASSERT(nr_sems < sizeof(sems) / sizeof(sems[0]));
+	sems[nr_sems] = 0;
+	sem->handle = &sems[nr_sems++];
+	return OS_OK;
+}
+
+OS_Status OS_SemaphoreDelete(OS_Semaphore_t *sem)
+{
+	sem->handle = NULL;
+	return OS_OK;
+}
+
+OS_Status OS_SemaphoreRelease(OS_Semaphore_t *sem)
+{
+	*(int *)sem->handle = 1;
+	return OS_OK;
+}
+
+OS_Status OS_SemaphoreWait(OS_Semaphore_t *sem, OS_Time_t waitMS)
+{
+	int *count = sem->handle;
+
+	TEST_ASSERT_EQ(test_irq_depth, 0);
+	while (!*count) {
+		if (test_stall || waitMS == 0 || !dma_copy_sw_run())
+			return OS_E_TIMEOUT;
+	}
+	*count = 0;
+	return OS_OK;
+}
+
+#define BUF_SIZE	(600 * 1024)
+#define NR_JOBS		16
+#define NR_SEGS		8
+
+static uint8_t *src, *dst, *ref;
+static int done_order[NR_JOBS], nr_done;
+
+static void job_cb(struct dma_copy_job *job, void *arg)
+{
+	TEST_ASSERT_EQ(test_irq_depth, 0);
+	TEST_ASSERT(job->status != DMA_COPY_ST_PENDING);
+	done_order[nr_done++] = (int)(long)arg;
+}
+
+/* rounds of up to 16 random scatter jobs, the engine run at random points */
+static void dma_copy_test_random(void)
+{
+	static struct dma_copy_job jobs[NR_JOBS];
+	static struct dma_copy_seg segs[NR_JOBS][NR_SEGS];
+	struct dma_copy_job *job;
+	struct dma_copy_stats st;
+	uint32_t seed = 1, pos, len, so;
+	int round, nr_jobs, i, j, k;
+
+	for (round = 0; round < 300; round++) {
+		nr_jobs = 1 + test_rand(&seed) % NR_JOBS;
+		dma_copy_set_cutoff(test_rand(&seed) % 3 ? 1 + test_rand(&seed) % 4096 : 0);
+		memset(dst, 0, BUF_SIZE);
+		memset(ref, 0, BUF_SIZE);
+		nr_done = 0;
+
+		pos = 0;
+		for (j = 0; j < nr_jobs; j++) {
+			job = &jobs[j];
+			memset(job, 0, sizeof(*job));
+			job->seg = segs[j];
+			job->nseg = test_rand(&seed) % NR_SEGS;
+			job->op = test_rand(&seed) % 4 ? DMA_COPY_OP_COPY : DMA_COPY_OP_FILL;
+			job->fill = test_rand(&seed);
+			job->flags = test_rand(&seed) % 5 ? 0 : DMA_COPY_F_FENCE;
+			job->cb = job_cb;
+			job->arg = (void *)(long)j;
+			for (k = 0; k < job->nseg; k++) {
+				/* a few segments longer than one DMA transfer */
+				len = test_rand(&seed) % 10 ? test_rand(&seed) % 5000
+				                            : test_rand(&seed) % (300 * 1024);
+				if (pos + len > BUF_SIZE)
+					len = 0;
+				so = test_rand(&seed) % (BUF_SIZE - len + 1);
+				segs[j][k].dst = dst + pos;
+				segs[j][k].src = src + so;
+				segs[j][k].len = len;
+				if (job->op == DMA_COPY_OP_FILL)
+					memset(ref + pos, job->fill, len);
+				else
+					memcpy(ref + pos, src + so, len);
+				pos += len;
+			}
+			TEST_ASSERT_EQ(dma_copy_submit(job), 0);
+			if (test_rand(&seed) % 3 == 0)
+				dma_copy_sw_run();
+		}
+		while (dma_copy_sw_run())
+			;
+
+		TEST_ASSERT_EQ(nr_done, nr_jobs);
+		for (j = 0; j < nr_jobs; j++)
+			TEST_ASSERT_EQ(jobs[j].status, DMA_COPY_ST_DONE);
+		for (i = 0; i < nr_done; i++) {
+#if DMA_COPY_CHAN_NUM == 1
+			TEST_ASSERT_EQ(done_order[i], i);
+#else
+			/* a fence completes after every job submitted before it */
+			if (jobs[done_order[i]].flags & DMA_COPY_F_FENCE) {
+				for (k = 0; k < nr_done; k++) {
+					if (done_order[k] < done_order[i])
+						TEST_ASSERT(k < i);
+				}
+			}
+#endif
+		}
+		TEST_ASSERT(memcmp(dst, ref, BUF_SIZE) == 0);
+	}
+
+	dma_copy_get_stats(&st);
+	TEST_ASSERT(st.dma_bytes > 0 && st.cpu_bytes > 0);
+	TEST_ASSERT(st.max_queued <= NR_JOBS);
+}
+
+static void dma_copy_test_cutoff_cancel(void)
+{
+	struct dma_copy_seg small = { dst, src, 100 };
+	struct dma_copy_seg big = { dst + 4096, src, 1000 };
+	struct dma_copy_job js, jb;
+
+	dma_copy_set_cutoff(256);
+	TEST_ASSERT_EQ(dma_copy_get_cutoff(), 256);
+
+	/* a small job on an idle service is done before submit returns */
+	memset(&js, 0, sizeof(js));
+	js.seg = &small;
+	js.nseg = 1;
+	TEST_ASSERT_EQ(dma_copy_submit(&js), 0);
+	TEST_ASSERT_EQ(js.status, DMA_COPY_ST_DONE);
+	TEST_ASSERT(memcmp(dst, src, 100) == 0);
+
+	memset(&jb, 0, sizeof(jb));
+	jb.seg = &big;
+	jb.nseg = 1;
+	TEST_ASSERT_EQ(dma_copy_submit(&jb), 0);
+	TEST_ASSERT_EQ(jb.status, DMA_COPY_ST_PENDING);
+
+	/* behind a DMA job a small one waits for its turn */
+	js.flags = DMA_COPY_F_FENCE;
+	TEST_ASSERT_EQ(dma_copy_submit(&js), 0);
+	TEST_ASSERT_EQ(js.status, DMA_COPY_ST_PENDING);
+
+	/* cancel the queued one, then the running one */
+	TEST_ASSERT_EQ(dma_copy_cancel(&js), 0);
+	TEST_ASSERT_EQ(js.status, DMA_COPY_ST_CANCELED);
+	TEST_ASSERT_EQ(dma_copy_cancel(&jb), 0);
+	TEST_ASSERT_EQ(jb.status, DMA_COPY_ST_CANCELED);
+	TEST_ASSERT_EQ(dma_copy_cancel(&jb), -1);
+	TEST_ASSERT_EQ(dma_copy_sw_run(), 0);
+
+	/* invalid jobs */
+	big.dst = NULL;
+	TEST_ASSERT_EQ(dma_copy_submit(&jb), -1);
+	jb.seg = NULL;
+	TEST_ASSERT_EQ(dma_copy_submit(&jb), -1);
+}
+
+static void dma_copy_test_sync(void)
+{
+	memset(dst, 0, BUF_SIZE);
+	TEST_ASSERT_EQ(dma_copy(dst + 3, src + 5, 200000), 0);
+	TEST_ASSERT(memcmp(dst + 3, src + 5, 200000) == 0);
+
+	TEST_ASSERT_EQ(dma_fill(dst + 1, 0x5a, 70001), 0);
+	TEST_ASSERT_EQ(dst[0], 0);
+	TEST_ASSERT_EQ(dst[1], 0x5a);
+	TEST_ASSERT_EQ(dst[70001], 0x5a);
+	TEST_ASSERT_EQ(dst[70002], src[5 + 70002 - 3]);
+
+	/* an engine that never completes: timeout, and the job is canceled */
+	test_stall = 1;
+	TEST_ASSERT_EQ(dma_copy(dst, src, 4096), -1);
+	test_stall = 0;
+	TEST_ASSERT_EQ(dma_copy_sw_run(), 0);
+	TEST_ASSERT_EQ(dma_copy(dst, src, 4096), 0);
+	TEST_ASSERT(memcmp(dst, src, 4096) == 0);
+}
+
+/*
+ * The PSRAM loader's DBUS DMA path: the image goes out in LOAD_SIZE blocks
+ * through dma_copy() and is read back the same way.
+ */
+static void dma_copy_test_psram_load(void)
+{
+	const uint32_t load_size = 1024, image = 256 * 1024;
+	uint8_t *psram = dst, *back = ref;
+	uint32_t ofs, len;
+
+	memset(psram, 0, image);
+	memset(back, 0, image);
+	for (ofs = 0; ofs < image; ofs += len) {
+		len = image - ofs < load_size ? image - ofs : load_size;
+		TEST_ASSERT_EQ(dma_copy(psram + ofs, src + ofs, len), 0);
+	}
+	for (ofs = 0; ofs < image; ofs += len) {
+		len = image - ofs < load_size ? image - ofs : load_size;
+		TEST_ASSERT_EQ(dma_copy(back + ofs, psram + ofs, len), 0);
+	}
+	TEST_ASSERT(memcmp(psram, src, image) == 0);
+	TEST_ASSERT(memcmp(back, src, image) == 0);
+}
+
+void dma_copy_test(void)
+{
+	uint32_t seed = 3;
+	int i;
+
+	src = malloc(BUF_SIZE);
+	dst = malloc(BUF_SIZE);
+	ref = malloc(BUF_SIZE);
+	TEST_ASSERT(src && dst && ref);
+	for (i = 0; i < BUF_SIZE; i++)
+		src[i] = test_rand(&seed);
+
+	printf("%d channel(s)\n", DMA_COPY_CHAN_NUM);
+	TEST_RUN(dma_copy_test_random);
+	TEST_RUN(dma_copy_test_cutoff_cancel);
+	TEST_RUN(dma_copy_test_sync);
+	dma_copy_set_cutoff(DMA_COPY_CPU_CUTOFF);
+	TEST_RUN(dma_copy_test_psram_load);
+	TEST_ASSERT_EQ(dma_copy_deinit(), 0);
+
+	free(src);
+	free(dst);
+	free(ref);
+}
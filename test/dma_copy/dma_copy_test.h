@@ -0,0 +1,6 @@
+#ifndef _DMA_COPY_TEST_H_
+#define _DMA_COPY_TEST_H_
+
+void dma_copy_test(void);
+
+#endif /* _DMA_COPY_TEST_H_ */
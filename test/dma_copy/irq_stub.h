@@ -0,0 +1,22 @@
+/*
+ * Host replacement of sys/interrupt.h: the "interrupt" is the software DMA
+ * engine run from the test thread, so masking only has to be counted, to
+ * check that no callback is called with interrupts masked.
+ */
+
+#ifndef _SYS_INTERRUPT_H_
+#define _SYS_INTERRUPT_H_
+
+extern int test_irq_depth;
+
+static inline unsigned long arch_irq_save(void)
+{
+	return test_irq_depth++;
+}
+
+static inline void arch_irq_restore(unsigned long flags)
+{
+	test_irq_depth = flags;
+}
+
+#endif /* _SYS_INTERRUPT_H_ */
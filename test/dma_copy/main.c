@@ -0,0 +1,8 @@
+#include "test.h"
+#include "dma_copy_test.h"
+
+int main(int argc, char **argv)
+{
+	dma_copy_test();
+	return 0;
+}
@@ -0,0 +1,455 @@
+/*
+ * Fixed-point biquad EQ against golden vectors.
+ *
+ * The golden coefficients and outputs below were computed offline in double
+ * precision from the RBJ audio EQ cookbook formulas (normalized by a0, a1/a2
+ * negated as eq_biquad.h stores them), quantized as eq_biq_set_coef() does
+ * and filtered in Direct Form I with the output rounded to int16. They do
+ * not come from this implementation, so they catch design errors as well as
+ * arithmetic ones. They are not libeq output either: matching the prebuilt
+ * library is still to be checked on target, which is why the fixed-point
+ * EQ is not the default.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "test.h"
+#include "audio/eq/eq.h"
+#include "eq_biquad.h"
+
+#define EQ_GOLD_LEN	96
+
+/* largest deviation from the double reference, in LSB */
+#define EQ_GOLD_TOL	2
+
+struct eq_gold {
+	eq_core_prms_t prm;
+	int fs;
+	double coef[5];		/* b0, b1, b2, -a1, -a2, normalized */
+	int32_t fix[5];		/* quantized coefficients */
+	int16_t out[EQ_GOLD_LEN];
+	eq_biq_kind_t kind;
+	int shift;
+};
+
+static const int16_t eq_gold_in[EQ_GOLD_LEN] = {
+	12000, 3465, 5640, 5853, 4374, 2272, 890, 1183, 3248, 6272, 8924, 9999,
+	9007, 6404, 3378, 1267, 912, 2252, 4356, 5885, 5748, 3642, 204, -3287,
+	-5528, -5817, -4390, -2293, -870, -1101, -3119, -6139, -8838, -9995, -9085, -6533,
+	-3507, -1351, -935, -2231, -4337, -5915, -5854, -3816, -408, 3106, 5413, 5779,
+	4404, 2313, 851, 1020, 2989, 6003, 8748, 9986, 9161, 6661, 3636, 1437,
+	959, 2211, 4316, 5941, 5956, 3988, 612, -2924, -5294, -5738, -4417, -2334,
+	-833, -941, -2860, -5866, -8654, -9973, -9232, -6786, -3765, -1524, -985, -2191,
+	-4293, -5965, -6055, -4158, -815, 2740, 5173, 5693, 4428, 2354, 816, 863,
+};
+
+static const struct eq_gold eq_gold[] = {
+	{ { 6.0f, 1000, 1.0f, BANDPASS_PEAK }, 48000,
+	  { 1.043953086990, -1.895320723937, 0.867722284760, 1.895320723937, -0.911675371750 },
+	  { 1120936092, -2035085131, 931709709, 2035085131, -978903977 },
+	  {
+		12527, 4617, 7063, 7605, 6341, 4246, 2685, 2737, 4661, 7757, 10700, 12175,
+		11515, 9016, 5795, 3241, 2341, 3204, 5010, 6415, 6218, 3951, 118, -4037,
+		-7123, -8267, -7530, -5855, -4604, -4879, -6974, -10222, -13314, -14925, -14360, -11883,
+		-8593, -5886, -4780, -5423, -7031, -8273, -7933, -5515, -1493, 2902, 6272, 7711,
+		7237, 5770, 4663, 5037, 7222, 10582, 13820, 15600, 15196, 12835, 9592, 6868,
+		5705, 6288, 7865, 9114, 8806, 6412, 2373, -2101, -5598, -7189, -6851, -5475,
+		-4410, -4795, -6993, -10402, -13738, -15654, -15390, -13138, -9949, -7223, -6027, -6580,
+		-8161, -9460, -9230, -6911, -2907, 1588, 5159, 6848, 6596, 5264, 4195, 4550,
+	  }, EQ_BIQ_Q31, 0 },
+	{ { -4.0f, 250, 2.0f, BANDPASS_PEAK }, 44100,
+	  { 0.995909602493, -1.976577870499, 0.981922783840, 1.976577870499, -0.977832386332 },
+	  { 1069349793, -2122334328, 1054331561, 2122334328, -1049939530 },
+	  {
+		11951, 3354, 5494, 5664, 4148, 2025, 636, 928, 2982, 5976, 8574, 9583,
+		8526, 5875, 2825, 713, 367, 1713, 3810, 5317, 5154, 3033, -397, -3851,
+		-6032, -6250, -4759, -2613, -1156, -1358, -3339, -6301, -8920, -9983, -8980, -6351,
+		-3274, -1088, -655, -1930, -4002, -5533, -5420, -3340, 87, 3589, 5861, 6181,
+		4765, 2647, 1173, 1335, 3288, 6266, 8951, 10115, 9215, 6655, 3594, 1382,
+		902, 2149, 4235, 5826, 5802, 3804, 420, -3095, -5419, -5808, -4436, -2317,
+		-795, -889, -2786, -5750, -8473, -9713, -8892, -6382, -3320, -1062, -518, -1717,
+		-3799, -5437, -5487, -3559, -208, 3326, 5713, 6176, 4857, 2743, 1181, 1210,
+	  }, EQ_BIQ_Q31, 0 },
+	{ { 9.0f, 3000, 4.0f, BANDPASS_PEAK }, 44100,
+	  { 1.054444089064, -1.765575614189, 0.885674036632, 1.765575614189, -0.940118125695 },
+	  { 1132200719, -1895772380, 950985256, 1895772380, -1009444151 },
+	  {
+		12653, 4807, 7049, 7209, 5375, 2569, 284, -226, 1459, 4715, 8166, 10327,
+		10303, 8189, 5004, 2180, 862, 1358, 3012, 4551, 4732, 2980, -312, -3952,
+		-6530, -7098, -5648, -3118, -952, -406, -1936, -4979, -8213, -10192, -10034, -7835,
+		-4609, -1791, -536, -1161, -3007, -4774, -5173, -3571, -320, 3409, 6181, 6996,
+		5776, 3402, 1291, 702, 2131, 5058, 8200, 10123, 9941, 7728, 4486, 1651,
+		391, 1049, 2982, 4880, 5427, 3945, 743, -3030, -5925, -6906, -5838, -3559,
+		-1466, -830, -2180, -5038, -8146, -10079, -9928, -7741, -4500, -1637, -342, -986,
+		-2950, -4932, -5590, -4210, -1058, 2735, 5719, 6822, 5868, 3653, 1559, 872,
+	  }, EQ_BIQ_Q31, 0 },
+	{ { 3.0f, 8000, 1.0f, BANDPASS_PEAK }, 48000,
+	  { 1.110164879520, -0.732957930846, 0.355750982172, 0.732957930846, -0.465915861692 },
+	  { 18189, -12009, 5829, 12009, -7634 },
+	  {
+		13322, 4816, 5313, 5247, 3943, 1844, 393, 898, 3531, 7172, 10078, 10836,
+		9092, 5680, 2188, 166, 388, 2489, 5154, 6759, 6171, 3297, -856, -4667,
+		-6677, -6295, -4080, -1455, -12, -732, -3496, -7142, -10028, -10824, -9166, -5824,
+		-2335, -252, -392, -2442, -5120, -6796, -6302, -3503, 630, 4484, 6580, 6287,
+		4121, 1487, -14, 628, 3340, 6992, 9944, 10840, 9276, 5981, 2475, 328,
+		392, 2397, 5087, 6830, 6429, 3705, -404, -4299, -6479, -6276, -4163, -1522,
+		39, -527, -3186, -6840, -9855, -10851, -9380, -6134, -2616, -406, -394, -2353,
+		-5051, -6861, -6553, -3906, 179, 4111, 6375, 6260, 4202, 1556, -61, 427,
+	  }, EQ_BIQ_Q15, 0 },
+	{ { 12.0f, 8000, 0.7f, HIHPASS_SHELVING }, 48000,
+	  { 2.463040651221, -2.343345153249, 0.820314646523, 0.236676553604, -0.176686698098 },
+	  { 20177, -19197, 6720, 1939, -1447 },
+	  {
+		29556, -12590, 7414, 8021, 2273, -732, -119, 2793, 6640, 9885, 11114, 9745,
+		6417, 2666, 199, 34, 2021, 4921, 7008, 6924, 4341, 132, -4052, -6569,
+		-6584, -4468, -1610, 276, -21, -2608, -6429, -9776, -11119, -9848, -6571, -2816,
+		-287, -39, -1972, -4872, -7026, -7038, -4540, -364, 3851, 6452, 6566, 4511,
+		1653, -288, -72, 2449, 6262, 9667, 11113, 9943, 6729, 2966, 375, 48,
+		1922, 4824, 7038, 7146, 4736, 597, -3648, -6333, -6540, -4555, -1698, 298,
+		165, -2294, -6095, -9555, -11100, -10035, -6882, -3117, -466, -57, -1874, -4772,
+		-7046, -7254, -4929, -831, 3444, 6209, 6513, 4592, 1745, -307, -255, 2138,
+	  }, EQ_BIQ_Q15, 1 },
+	{ { 6.0f, 60, 1.0f, LOWPASS_SHELVING }, 44100,
+	  { 1.001491131117, -1.992755911715, 0.991367635659, 1.992781564423, -0.992833114067 },
+	  { 1075342914, -2139705367, 1064472893, 2139732912, -1066046439 },
+	  {
+		12018, 3506, 5695, 5926, 4463, 2371, 995, 1292, 3365, 6404, 9080, 10184,
+		9222, 6644, 3635, 1533, 1184, 2531, 4647, 6193, 6076, 3987, 557, -2936,
+		-5187, -5490, -4076, -1987, -567, -799, -2822, -5854, -8573, -9757, -8875, -6345,
+		-3334, -1185, -772, -2072, -4188, -5781, -5738, -3715, -313, 3204, 5523, 5906,
+		4546, 2464, 1007, 1179, 3154, 6182, 8949, 10215, 9420, 6944, 3936, 1746,
+		1273, 2531, 4647, 6289, 6323, 4372, 1004, -2533, -4913, -5372, -4065, -1991,
+		-493, -603, -2526, -5544, -8353, -9699, -8987, -6565, -3560, -1327, -792, -2003,
+		-4116, -5804, -5912, -4032, -697, 2859, 5303, 5838, 4587, 2522, 988, 1037,
+	  }, EQ_BIQ_Q31, 0 },
+	{ { 5.0f, 6000, 0.7f, HIHPASS_SHELVING }, 44100,
+	  { 1.507313259501, -1.480748949314, 0.519142266297, 0.713269717882, -0.258976294366 },
+	  { 24696, -24261, 8506, 11686, -4243 },
+	  {
+		18088, 355, 5169, 5865, 3699, 1106, 79, 1415, 4595, 8169, 10487, 10478,
+		8161, 4614, 1462, 81, 931, 3345, 5849, 6895, 5615, 2252, -1949, -5339,
+		-6663, -5659, -3184, -781, 72, -1308, -4474, -8059, -10440, -10525, -8286, -4768,
+		-1584, -130, -912, -3297, -5834, -6960, -5770, -2467, 1731, 5178, 6593, 5670,
+		3228, 799, -122, 1184, 4313, 7922, 10382, 10569, 8413, 4923, 1706, 182,
+		893, 3249, 5815, 7018, 5921, 2682, -1511, -5016, -6518, -5678, -3272, -819,
+		170, -1063, -4152, -7782, -10318, -10608, -8535, -5076, -1830, -236, -877, -3200,
+		-5793, -7075, -6069, -2895, 1292, 4850, 6441, 5682, 3315, 840, -216, 943,
+	  }, EQ_BIQ_Q15, 0 },
+	{ { 0.0f, 16000, 0.707f, LOWPASS }, 44100,
+	  { 0.537110479523, 1.074220959045, 0.537110479523, -0.847094496043, -0.301347422048 },
+	  { 8800, 17600, 8800, -13879, -4937 },
+	  {
+		6445, 9292, 3383, 5397, 6074, 2291, 1497, 853, 2319, 5271, 8111, 9866,
+		9570, 7406, 4374, 1812, 812, 1636, 3618, 5492, 6006, 4549, 1446, -2186,
+		-4975, -5955, -5032, -3015, -1218, -817, -2266, -5073, -8036, -9823, -9620, -7527,
+		-4506, -1917, -856, -1626, -3593, -5501, -6085, -4703, -1645, 1991, 4834, 5892,
+		5033, 3038, 1217, 758, 2149, 4934, 7926, 9785, 9669, 7643, 4641, 2021,
+		901, 1617, 3567, 5506, 6160, 4854, 1844, -1796, -4690, -5825, -5032, -3062,
+		-1216, -701, -2034, -4794, -7812, -9742, -9714, -7755, -4774, -2127, -948, -1609,
+		-3539, -5509, -6232, -5002, -2041, 1599, 4544, 5755, 5028, 3085, 1217, 644,
+	  }, EQ_BIQ_Q15, 0 },
+	{ { 0.0f, 40, 0.707f, HIGHPASS }, 44100,
+	  { 0.995977679268, -1.991955358536, 0.995977679268, 1.991939184273, -0.991971532799 },
+	  { 1069422890, -2138845780, 1069422890, 2138828413, -1065121323 },
+	  {
+		11952, 3355, 5494, 5661, 4142, 2014, 620, 906, 2954, 5941, 8533, 9534,
+		8467, 5805, 2742, 615, 254, 1584, 3664, 5155, 4974, 2833, -617, -4092,
+		-6294, -6534, -5063, -2936, -1498, -1718, -3716, -6696, -9333, -10412, -9423, -6806,
+		-3739, -1562, -1136, -2418, -4496, -6032, -5923, -3846, -420, 3083, 5356, 5678,
+		4263, 2145, 672, 834, 2788, 5767, 8454, 9618, 8718, 6156, 3092, 875,
+		390, 1632, 3714, 5300, 5270, 3265, -126, -3649, -5983, -6379, -5014, -2901,
+		-1385, -1483, -3384, -6353, -9080, -10322, -9502, -6990, -3925, -1661, -1111, -2304,
+		-4379, -6008, -6049, -4111, -748, 2800, 5201, 5678, 4373, 2272, 722, 763,
+	  }, EQ_BIQ_Q31, 0 },
+};
+
+#define EQ_GOLD_NUM	(sizeof(eq_gold) / sizeof(eq_gold[0]))
+
+static double eq_gain_db(const double c[5], double f, int fs)
+{
+	double w = 2 * M_PI * f / fs;
+	double nr = c[0] + c[1] * cos(w) + c[2] * cos(2 * w);
+	double ni = -c[1] * sin(w) - c[2] * sin(2 * w);
+	double dr = 1 - c[3] * cos(w) - c[4] * cos(2 * w);
+	double di = c[3] * sin(w) + c[4] * sin(2 * w);
+
+	return 10 * log10((nr * nr + ni * ni) / (dr * dr + di * di));
+}
+
+/* The golden coefficients meet the specification of each filter type */
+static void eq_test_gold_response(void)
+{
+	const struct eq_gold *g;
+	double db;
+	int i;
+
+	for (i = 0; i < EQ_GOLD_NUM; i++) {
+		g = &eq_gold[i];
+		switch (g->prm.type) {
+		case BANDPASS_PEAK:
+			db = eq_gain_db(g->coef, g->prm.fc, g->fs);
+			TEST_ASSERT(fabs(db - g->prm.G) < 1e-6);
+			break;
+		case LOWPASS_SHELVING:
+			db = eq_gain_db(g->coef, 0, g->fs);
+			TEST_ASSERT(fabs(db - g->prm.G) < 1e-6);
+			break;
+		case HIHPASS_SHELVING:
+			db = eq_gain_db(g->coef, g->fs / 2, g->fs);
+			TEST_ASSERT(fabs(db - g->prm.G) < 1e-6);
+			break;
+		default:
+			/* Butterworth: -3 dB at the cutoff */
+			db = eq_gain_db(g->coef, g->prm.fc, g->fs);
+			TEST_ASSERT(fabs(db + 3.0103) < 0.01);
+			break;
+		}
+	}
+}
+
+/* Coefficient format, shift and rounding */
+static void eq_test_gold_coef(void)
+{
+	const struct eq_gold *g;
+	double b[3], a[3];
+	eq_biq_t biq;
+	int i;
+
+	for (i = 0; i < EQ_GOLD_NUM; i++) {
+		g = &eq_gold[i];
+		b[0] = g->coef[0];
+		b[1] = g->coef[1];
+		b[2] = g->coef[2];
+		a[0] = 1.0;
+		a[1] = -g->coef[3];
+		a[2] = -g->coef[4];
+		memset(&biq, 0, sizeof(biq));
+		eq_biq_set_coef(&biq, g->kind, b, a);
+		TEST_ASSERT_EQ(biq.kind, g->kind);
+		TEST_ASSERT_EQ(biq.shift, g->shift);
+		if (g->kind == EQ_BIQ_Q15) {
+			TEST_ASSERT_EQ((int16_t)biq.c.q15.b01, g->fix[0]);
+			TEST_ASSERT_EQ((int16_t)(biq.c.q15.b01 >> 16), g->fix[1]);
+			TEST_ASSERT_EQ((int16_t)biq.c.q15.b2a1, g->fix[2]);
+			TEST_ASSERT_EQ((int16_t)(biq.c.q15.b2a1 >> 16), g->fix[3]);
+			TEST_ASSERT_EQ(biq.c.q15.a2, g->fix[4]);
+		} else {
+			TEST_ASSERT_EQ(biq.c.q31.b0, g->fix[0]);
+			TEST_ASSERT_EQ(biq.c.q31.b1, g->fix[1]);
+			TEST_ASSERT_EQ(biq.c.q31.b2, g->fix[2]);
+			TEST_ASSERT_EQ(biq.c.q31.a1, g->fix[3]);
+			TEST_ASSERT_EQ(biq.c.q31.a2, g->fix[4]);
+		}
+	}
+}
+
+/*
+ * Design + filtering through the public API: mono output against the
+ * golden vector, stereo channels identical to mono, and the result
+ * independent of how the input is split into blocks.
+ */
+static void eq_test_gold_output(void)
+{
+	int16_t mono[EQ_GOLD_LEN], stereo[EQ_GOLD_LEN * 2];
+	const struct eq_gold *g;
+	eq_core_prms_t prm;
+	eq_prms_t prms;
+	void *eq;
+	int i, n, err, max_err = 0;
+
+	for (i = 0; i < EQ_GOLD_NUM; i++) {
+		g = &eq_gold[i];
+		prm = g->prm;
+		prms.biq_num = 1;
+		prms.sampling_rate = g->fs;
+		prms.core_prms = &prm;
+
+		prms.chan = 1;
+		eq = eq_create(&prms);
+		TEST_ASSERT(eq != NULL);
+		memcpy(mono, eq_gold_in, sizeof(mono));
+		eq_process(eq, mono, EQ_GOLD_LEN);
+		eq_destroy(eq);
+		for (n = 0; n < EQ_GOLD_LEN; n++) {
+			err = abs(mono[n] - g->out[n]);
+			if (err > max_err)
+				max_err = err;
+			if (err > EQ_GOLD_TOL) {
+				printf("case %d sample %d: %d, expected %d\n",
+				       i, n, mono[n], g->out[n]);
+				TEST_ASSERT(err <= EQ_GOLD_TOL);
+			}
+		}
+
+		prms.chan = 2;
+		eq = eq_create(&prms);
+		TEST_ASSERT(eq != NULL);
+		for (n = 0; n < EQ_GOLD_LEN; n++) {
+			stereo[n * 2] = eq_gold_in[n];
+			stereo[n * 2 + 1] = eq_gold_in[n];
+		}
+		for (n = 0; n < EQ_GOLD_LEN; n += 7)
+			eq_process(eq, stereo + n * 2, n + 7 <= EQ_GOLD_LEN ? 7 : EQ_GOLD_LEN - n);
+		eq_destroy(eq);
+		for (n = 0; n < EQ_GOLD_LEN; n++) {
+			TEST_ASSERT_EQ(stereo[n * 2], mono[n]);
+			TEST_ASSERT_EQ(stereo[n * 2 + 1], mono[n]);
+		}
+	}
+	printf(" (max %d LSB)", max_err);
+}
+
+/* Bypassed sections leave the signal untouched */
+static void eq_test_bypass(void)
+{
+	eq_core_prms_t prm[2] = {
+		{ 0.0f, 1000, 1.0f, BANDPASS_PEAK },
+		{ 0.0f, 100, 1.0f, LOWPASS_SHELVING },
+	};
+	eq_prms_t prms = { 2, 44100, 1, prm };
+	int16_t x[EQ_GOLD_LEN];
+	void *eq;
+
+	eq = eq_create(&prms);
+	TEST_ASSERT(eq != NULL);
+	memcpy(x, eq_gold_in, sizeof(x));
+	eq_process(eq, x, EQ_GOLD_LEN);
+	eq_destroy(eq);
+	TEST_ASSERT(memcmp(x, eq_gold_in, sizeof(x)) == 0);
+}
+
+/* G sets the pass band gain of the low and high pass filters */
+static void eq_test_pass_gain(void)
+{
+	eq_core_prms_t lp = { -6.0206f, 1000, 0.707f, LOWPASS };
+	eq_core_prms_t hp = { 6.0206f, 1000, 0.707f, HIGHPASS };
+	eq_prms_t prms = { 1, 44100, 1, &lp };
+	int16_t x[2000];
+	void *eq;
+	int i;
+
+	/* DC through the low pass, halved */
+	for (i = 0; i < 2000; i++)
+		x[i] = 8000;
+	eq = eq_create(&prms);
+	TEST_ASSERT(eq != NULL);
+	eq_process(eq, x, 2000);
+	eq_destroy(eq);
+	TEST_ASSERT(abs(x[1999] - 4000) <= 2);
+
+	/* fs/2 through the high pass, doubled */
+	for (i = 0; i < 2000; i++)
+		x[i] = (i & 1) ? -4000 : 4000;
+	prms.core_prms = &hp;
+	eq = eq_create(&prms);
+	TEST_ASSERT(eq != NULL);
+	eq_process(eq, x, 2000);
+	eq_destroy(eq);
+	TEST_ASSERT(abs(x[1998] - 8000) <= 2 && abs(x[1999] + 8000) <= 2);
+}
+
+/* Six section cascade on one second of stereo against a double reference */
+static void eq_test_cascade_snr(void)
+{
+	eq_core_prms_t prm[] = {
+		{ 6.0f, 60, 1.0f, LOWPASS_SHELVING },
+		{ -4.0f, 250, 2.0f, BANDPASS_PEAK },
+		{ 3.0f, 1000, 1.2f, BANDPASS_PEAK },
+		{ 5.0f, 6000, 0.7f, HIHPASS_SHELVING },
+		{ 0.0f, 40, 0.707f, HIGHPASS },
+		{ -2.0f, 16000, 0.707f, LOWPASS },
+	};
+	const int fs = 44100, chan = 2, frames = 44100, nr = 6;
+	eq_prms_t prms = { nr, fs, chan, prm };
+	int16_t *x = malloc(frames * chan * sizeof(int16_t));
+	double *ref = malloc(frames * chan * sizeof(double));
+	double b[3], a[3], c[5], x1, x2, y1, y2, y, sig = 0, err = 0;
+	uint32_t seed = 1;
+	void *eq;
+	int i, s, ch, n;
+
+	TEST_ASSERT(x != NULL && ref != NULL);
+	for (i = 0; i < frames * chan; i++) {
+		x[i] = (int16_t)((int)(test_rand(&seed) % 20000) / 2 - 5000 +
+		                 4000 * sin(i * 0.003));
+		ref[i] = x[i];
+	}
+
+	for (s = 0; s < nr; s++) {
+		double A = pow(10, prm[s].G / 40.0), w = 2 * M_PI * prm[s].fc / fs;
+		double cw = cos(w), al = sin(w) / (2 * prm[s].Q), sa = 2 * sqrt(A) * al;
+
+		switch (prm[s].type) {
+		case BANDPASS_PEAK:
+			b[0] = 1 + al * A; b[1] = -2 * cw; b[2] = 1 - al * A;
+			a[0] = 1 + al / A; a[1] = -2 * cw; a[2] = 1 - al / A;
+			break;
+		case LOWPASS_SHELVING:
+			b[0] = A * ((A + 1) - (A - 1) * cw + sa);
+			b[1] = 2 * A * ((A - 1) - (A + 1) * cw);
+			b[2] = A * ((A + 1) - (A - 1) * cw - sa);
+			a[0] = (A + 1) + (A - 1) * cw + sa;
+			a[1] = -2 * ((A - 1) + (A + 1) * cw);
+			a[2] = (A + 1) + (A - 1) * cw - sa;
+			break;
+		case HIHPASS_SHELVING:
+			b[0] = A * ((A + 1) + (A - 1) * cw + sa);
+			b[1] = -2 * A * ((A - 1) + (A + 1) * cw);
+			b[2] = A * ((A + 1) + (A - 1) * cw - sa);
+			a[0] = (A + 1) - (A - 1) * cw + sa;
+			a[1] = 2 * ((A - 1) - (A + 1) * cw);
+			a[2] = (A + 1) - (A - 1) * cw - sa;
+			break;
+		case LOWPASS:
+			b[0] = (1 - cw) / 2; b[1] = 1 - cw; b[2] = b[0];
+			a[0] = 1 + al; a[1] = -2 * cw; a[2] = 1 - al;
+			break;
+		default:
+			b[0] = (1 + cw) / 2; b[1] = -(1 + cw); b[2] = b[0];
+			a[0] = 1 + al; a[1] = -2 * cw; a[2] = 1 - al;
+			break;
+		}
+		if (prm[s].type == LOWPASS || prm[s].type == HIGHPASS) {
+			A = pow(10, prm[s].G / 20.0);
+			b[0] *= A; b[1] *= A; b[2] *= A;
+		}
+		c[0] = b[0] / a[0]; c[1] = b[1] / a[0]; c[2] = b[2] / a[0];
+		c[3] = -a[1] / a[0]; c[4] = -a[2] / a[0];
+		for (ch = 0; ch < chan; ch++) {
+			x1 = x2 = y1 = y2 = 0;
+			for (n = 0; n < frames; n++) {
+				double in = ref[n * chan + ch];
+				y = c[0] * in + c[1] * x1 + c[2] * x2 + c[3] * y1 + c[4] * y2;
+				x2 = x1; x1 = in; y2 = y1; y1 = y;
+				ref[n * chan + ch] = y;
+			}
+		}
+	}
+
+	eq = eq_create(&prms);
+	TEST_ASSERT(eq != NULL);
+	for (n = 0; n < frames; n += 1000)
+		eq_process(eq, x + n * chan, frames - n < 1000 ? frames - n : 1000);
+	eq_destroy(eq);
+
+	for (i = 0; i < frames * chan; i++) {
+		sig += ref[i] * ref[i];
+		err += (x[i] - ref[i]) * (x[i] - ref[i]);
+	}
+	printf(" (SNR %.1f dB)", 10 * log10(sig / err));
+	TEST_ASSERT(10 * log10(sig / err) > 70.0);
+
+	free(x);
+	free(ref);
+}
+
+int main(int argc, char **argv)
+{
+	TEST_RUN(eq_test_gold_response);
+	TEST_RUN(eq_test_gold_coef);
+	TEST_RUN(eq_test_gold_output);
+	TEST_RUN(eq_test_bypass);
+	TEST_RUN(eq_test_pass_gain);
+	TEST_RUN(eq_test_cascade_snr);
+	return 0;
+}
@@ -0,0 +1,237 @@
+/*
+ * Fast reconnect record: which records read back from flash are trusted,
+ * which cached leases are worth an INIT-REBOOT, and when a new record is
+ * written instead of keeping the one in flash.
+ */
+
+#include <string.h>
+#include "test.h"
+#include "fast_conn.h"
+
+#define FC_NOW		1000000
+#define FC_LEASE	7200
+
+static struct sysinfo_wlan_sta_param fc_sta = { "home", 4, "password1" };
+
+static void fc_rec_make(struct fast_conn_rec *rec,
+			const struct sysinfo_wlan_sta_param *sta)
+{
+	static const uint8_t bssid[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+	memset(rec, 0, sizeof(*rec));
+	rec->cfg_sum = fast_conn_cfg_sum(sta);
+	rec->flags = FAST_CONN_F_PMK | FAST_CONN_F_BSS | FAST_CONN_F_LEASE;
+	memset(rec->pmk, 0x5a, sizeof(rec->pmk));
+	memcpy(rec->bssid, bssid, sizeof(bssid));
+	rec->channel = 6;
+	rec->bss_size = 300;
+	memset(rec->bss, 0xa5, rec->bss_size);
+	rec->lease.ip_addr = 0x0a00a8c0;
+	rec->lease.net_mask = 0x00ffffff;
+	rec->lease.gateway = 0x0100a8c0;
+	rec->lease.lease_time = FC_LEASE;
+	rec->lease.bound_time = FC_NOW;
+	fast_conn_rec_seal(rec);
+}
+
+static void fc_test_cfg_sum(void)
+{
+	struct sysinfo_wlan_sta_param sta;
+	uint32_t sum = fast_conn_cfg_sum(&fc_sta);
+
+	sta = fc_sta;
+	strcpy((char *)sta.psk, "password2");
+	TEST_ASSERT(fast_conn_cfg_sum(&sta) != sum);
+
+	sta = fc_sta;
+	sta.ssid_len = 3;
+	TEST_ASSERT(fast_conn_cfg_sum(&sta) != sum);
+
+	sta = fc_sta;
+	sta.ssid[3] = 'x';
+	TEST_ASSERT(fast_conn_cfg_sum(&sta) != sum);
+
+	/* bytes past the SSID length and the end of the passphrase don't count */
+	sta = fc_sta;
+	sta.ssid[10] = 'x';
+	sta.psk[12] = 'x';
+	TEST_ASSERT_EQ(fast_conn_cfg_sum(&sta), sum);
+
+	/* nor does a length beyond the SSID field */
+	sta = fc_sta;
+	memset(sta.ssid, 'a', sizeof(sta.ssid));
+	sta.ssid_len = SYSINFO_SSID_LEN_MAX;
+	sum = fast_conn_cfg_sum(&sta);
+	sta.ssid_len = 200;
+	TEST_ASSERT_EQ(fast_conn_cfg_sum(&sta), sum);
+}
+
+static void fc_test_rec_check(void)
+{
+	static struct fast_conn_rec rec, bad;
+	struct sysinfo_wlan_sta_param sta = fc_sta;
+	uint32_t sum = fast_conn_cfg_sum(&fc_sta);
+	size_t i;
+
+	fc_rec_make(&rec, &fc_sta);
+	TEST_ASSERT_EQ(fast_conn_rec_check(&rec, sum), 0);
+
+	/* the passphrase was changed in sysinfo since */
+	strcpy((char *)sta.psk, "password2");
+	TEST_ASSERT_EQ(fast_conn_rec_check(&rec, fast_conn_cfg_sum(&sta)), -1);
+
+	/* any flipped bit is caught */
+	for (i = 0; i < sizeof(rec); i++) {
+		bad = rec;
+		((uint8_t *)&bad)[i] ^= 1 << (i % 8);
+		TEST_ASSERT_EQ(fast_conn_rec_check(&bad, sum), -1);
+	}
+
+	/* a record cut off by a power loss, and an erased slot */
+	bad = rec;
+	memset((uint8_t *)&bad + 400, 0xff, sizeof(bad) - 400);
+	TEST_ASSERT_EQ(fast_conn_rec_check(&bad, sum), -1);
+	memset(&bad, 0xff, sizeof(bad));
+	TEST_ASSERT_EQ(fast_conn_rec_check(&bad, sum), -1);
+	memset(&bad, 0, sizeof(bad));
+	TEST_ASSERT_EQ(fast_conn_rec_check(&bad, 0), -1);
+
+	/* a record of an older layout is not trusted, sealing makes it current */
+	bad = rec;
+	bad.version = FAST_CONN_VERSION + 1;
+	bad.sum = 0;
+	TEST_ASSERT_EQ(fast_conn_rec_check(&bad, sum), -1);
+	fast_conn_rec_seal(&bad);
+	TEST_ASSERT_EQ(bad.version, FAST_CONN_VERSION);
+	TEST_ASSERT_EQ(fast_conn_rec_check(&bad, sum), 0);
+
+	/* a BSS blob too large for the record is dropped, the BSS flag without
+	 * one is refused */
+	bad = rec;
+	bad.bss_size = FAST_CONN_BSS_MAX + 1;
+	fast_conn_rec_seal(&bad);
+	TEST_ASSERT_EQ(bad.bss_size, 0);
+	TEST_ASSERT_EQ(fast_conn_rec_check(&bad, sum), -1);
+
+	bad = rec;
+	bad.flags &= ~FAST_CONN_F_BSS;
+	fast_conn_rec_seal(&bad);
+	TEST_ASSERT_EQ(bad.bss_size, 0);
+	TEST_ASSERT_EQ(fast_conn_rec_check(&bad, sum), 0);
+}
+
+static void fc_test_lease(void)
+{
+	struct fast_conn_rec rec;
+	struct fast_conn_lease l;
+
+	fc_rec_make(&rec, &fc_sta);
+	l = rec.lease;
+	TEST_ASSERT_EQ(fast_conn_lease_usable(&l, FC_NOW), 1);
+	TEST_ASSERT_EQ(fast_conn_lease_usable(&l, FC_NOW + 3600), 1);
+
+	/* not requested within the margin before it expires */
+	TEST_ASSERT_EQ(fast_conn_lease_usable(&l, FC_NOW + FC_LEASE - FAST_CONN_LEASE_MARGIN - 1), 1);
+	TEST_ASSERT_EQ(fast_conn_lease_usable(&l, FC_NOW + FC_LEASE - FAST_CONN_LEASE_MARGIN), 0);
+	TEST_ASSERT_EQ(fast_conn_lease_usable(&l, FC_NOW + FC_LEASE), 0);
+	TEST_ASSERT_EQ(fast_conn_lease_usable(&l, 0xfffffff0), 0);
+
+	/* the clock went back, eg. a cold boot without RTC time */
+	TEST_ASSERT_EQ(fast_conn_lease_usable(&l, FC_NOW - 1), 1);
+	TEST_ASSERT_EQ(fast_conn_lease_usable(&l, 10), 1);
+
+	l.lease_time = FAST_CONN_LEASE_INFINITE;
+	TEST_ASSERT_EQ(fast_conn_lease_usable(&l, 0xfffffff0), 1);
+
+	/* leases no longer than the margin are never reused */
+	l.lease_time = FAST_CONN_LEASE_MARGIN;
+	TEST_ASSERT_EQ(fast_conn_lease_usable(&l, FC_NOW), 0);
+	l.lease_time = FAST_CONN_LEASE_MARGIN + 1;
+	TEST_ASSERT_EQ(fast_conn_lease_usable(&l, FC_NOW), 1);
+	l.lease_time = 0;
+	TEST_ASSERT_EQ(fast_conn_lease_usable(&l, FC_NOW), 0);
+
+	l = rec.lease;
+	l.ip_addr = 0;
+	TEST_ASSERT_EQ(fast_conn_lease_usable(&l, FC_NOW), 0);
+}
+
+static void fc_test_need_save(void)
+{
+	static struct fast_conn_rec old, rec;
+	struct sysinfo_wlan_sta_param sta = fc_sta;
+
+	fc_rec_make(&old, &fc_sta);
+	fc_rec_make(&rec, &fc_sta);
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(NULL, &rec, FC_NOW), 1);
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, FC_NOW), 0);
+
+	/* new beacon data and a renewed lease alone don't wear the flash ... */
+	rec.bss[5] = 1;
+	rec.lease.bound_time = FC_NOW + 100;
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, FC_NOW + 100), 0);
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, FC_NOW + FC_LEASE / 2 - 1), 0);
+
+	/* ... until half of the lease saved has passed */
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, FC_NOW + FC_LEASE / 2), 1);
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, FC_NOW + FC_LEASE * 10), 1);
+
+	/* the clock went back, the age of the record in flash is unknown */
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, 500), 0);
+
+	fc_rec_make(&rec, &fc_sta);
+	rec.channel = 11;
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, FC_NOW), 1);
+
+	fc_rec_make(&rec, &fc_sta);
+	rec.bssid[5] ^= 1;
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, FC_NOW), 1);
+
+	fc_rec_make(&rec, &fc_sta);
+	rec.pmk[0] ^= 1;
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, FC_NOW), 1);
+
+	fc_rec_make(&rec, &fc_sta);
+	rec.lease.ip_addr ^= 1 << 24;
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, FC_NOW), 1);
+
+	fc_rec_make(&rec, &fc_sta);
+	rec.lease.gateway ^= 1 << 24;
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, FC_NOW), 1);
+
+	fc_rec_make(&rec, &fc_sta);
+	rec.lease.lease_time = FC_LEASE / 2;
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, FC_NOW), 1);
+
+	/* the DHCP lease was lost, or the record belongs to another network */
+	fc_rec_make(&rec, &fc_sta);
+	rec.flags &= ~FAST_CONN_F_LEASE;
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, FC_NOW), 1);
+
+	strcpy((char *)sta.psk, "password2");
+	fc_rec_make(&rec, &sta);
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, FC_NOW), 1);
+
+	/* fields the flags mark invalid are not compared */
+	fc_rec_make(&old, &fc_sta);
+	fc_rec_make(&rec, &fc_sta);
+	old.flags = rec.flags = FAST_CONN_F_LEASE;
+	rec.pmk[0] ^= 1;
+	rec.channel = 11;
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, FC_NOW), 0);
+
+	/* an infinite lease is never refreshed */
+	fc_rec_make(&old, &fc_sta);
+	fc_rec_make(&rec, &fc_sta);
+	old.lease.lease_time = rec.lease.lease_time = FAST_CONN_LEASE_INFINITE;
+	TEST_ASSERT_EQ(fast_conn_rec_need_save(&old, &rec, 0xfffffff0), 0);
+}
+
+int main(int argc, char **argv)
+{
+	TEST_RUN(fc_test_cfg_sum);
+	TEST_RUN(fc_test_rec_check);
+	TEST_RUN(fc_test_lease);
+	TEST_RUN(fc_test_need_save);
+	return 0;
+}
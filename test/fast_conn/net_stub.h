@@ -0,0 +1,29 @@
+/*
+ * The lwIP and wlan types the fast reconnect record checks are declared
+ * with, the rest of the network stack is not built for the host.
+ */
+
+#ifndef _NET_STUB_H_
+#define _NET_STUB_H_
+
+#include <stdint.h>
+
+/* lwip/netif.h, net/wlan/wlan.h and net_ctrl.h */
+#define LWIP_HDR_NETIF_H
+#define _NET_WLAN_WLAN_H_
+#define _NET_CTRL_H_
+#define _IMAGE_FDCM_H_
+
+#define __CONFIG_LWIP_V1
+
+typedef struct ip_addr {
+	uint32_t addr;
+} ip_addr_t, ip4_addr_t;
+
+struct netif;
+
+enum wlan_mode {
+	WLAN_MODE_STA = 0,
+};
+
+#endif /* _NET_STUB_H_ */
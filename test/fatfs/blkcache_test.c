@@ -0,0 +1,344 @@
+/*
+ * Sector cache: correctness against a plain memory device, dirty data
+ * surviving re-init, and a RAM disk benchmark of device commands issued
+ * with and without the cache.
+ *
+ * The simulated device charges a fixed cost per command plus a cost per
+ * sector, roughly an SD card in 4-bit mode, so the benchmark reports the
+ * time the device would be busy rather than host memcpy speed.
+ */
+
+#include <string.h>
+#include "test.h"
+#include "fatfs_test.h"
+#include "blkcache.h"
+#include "ram_diskio.h"
+
+#define SIM_SECTORS		8192		/* 4 MB */
+#define SIM_CMD_US		250
+#define SIM_SECTOR_US		20
+
+static struct {
+	BYTE *mem;
+	uint32_t cmds;
+	uint32_t sectors;
+	int fail;
+} sim;
+
+static DRESULT sim_read(BYTE *buff, DWORD sector, UINT count)
+{
+	if (sector + count > SIM_SECTORS)
+		return RES_PARERR;
+	memcpy(buff, sim.mem + sector * BLKCACHE_SECTOR_SIZE, count * BLKCACHE_SECTOR_SIZE);
+	sim.cmds++;
+	sim.sectors += count;
+	return RES_OK;
+}
+
+static DRESULT sim_write(const BYTE *buff, DWORD sector, UINT count)
+{
+	if (sim.fail)
+		return RES_ERROR;
+	if (sector + count > SIM_SECTORS)
+		return RES_PARERR;
+	memcpy(sim.mem + sector * BLKCACHE_SECTOR_SIZE, buff, count * BLKCACHE_SECTOR_SIZE);
+	sim.cmds++;
+	sim.sectors += count;
+	return RES_OK;
+}
+
+static const struct blkcache_dev_ops sim_ops = {
+	.read  = sim_read,
+	.write = sim_write,
+};
+
+static void sim_reset(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < SIM_SECTORS * BLKCACHE_SECTOR_SIZE / 4; i++)
+		((uint32_t *)sim.mem)[i] = i * 2654435761u;
+	sim.cmds = 0;
+	sim.sectors = 0;
+	sim.fail = 0;
+}
+
+static void fill(BYTE *buf, DWORD sector, UINT count, uint32_t tag)
+{
+	UINT i;
+
+	for (i = 0; i < count * BLKCACHE_SECTOR_SIZE; i += 4)
+		*(uint32_t *)(buf + i) = (sector * BLKCACHE_SECTOR_SIZE + i) ^ tag;
+}
+
+/*
+ * Random mix of reads and writes of 1..40 sectors; every read must return
+ * what the shadow copy says, through the cache and after a flush on the
+ * device itself.
+ */
+static void blkcache_test_shadow(void)
+{
+	static BYTE shadow[SIM_SECTORS * BLKCACHE_SECTOR_SIZE];
+	static BYTE buf[40 * BLKCACHE_SECTOR_SIZE];
+	struct blkcache *bc;
+	uint32_t seed = 1;
+	DWORD sector;
+	UINT count;
+	int n;
+
+	sim_reset();
+	memcpy(shadow, sim.mem, sizeof(shadow));
+	bc = blkcache_create(&sim_ops, 32, 8, SIM_SECTORS);
+	TEST_ASSERT(bc != NULL);
+
+	for (n = 0; n < 20000; n++) {
+		count = 1 + test_rand(&seed) % 40;
+		if (test_rand(&seed) & 1)
+			count = 1 + (count & 3);
+		sector = test_rand(&seed) % (SIM_SECTORS - count);
+		if (test_rand(&seed) & 1) {
+			/* keep most traffic in a small area so lines get reused */
+			sector &= 255;
+		}
+		if (test_rand(&seed) % 3 == 0) {
+			fill(buf, sector, count, n);
+			TEST_ASSERT_EQ(blkcache_write(bc, buf, sector, count), RES_OK);
+			memcpy(shadow + sector * BLKCACHE_SECTOR_SIZE, buf,
+			       count * BLKCACHE_SECTOR_SIZE);
+		} else {
+			TEST_ASSERT_EQ(blkcache_read(bc, buf, sector, count), RES_OK);
+			TEST_ASSERT(memcmp(buf, shadow + sector * BLKCACHE_SECTOR_SIZE,
+			                   count * BLKCACHE_SECTOR_SIZE) == 0);
+		}
+	}
+
+	TEST_ASSERT_EQ(blkcache_flush(bc), RES_OK);
+	TEST_ASSERT(memcmp(sim.mem, shadow, sizeof(shadow)) == 0);
+	blkcache_destroy(bc);
+}
+
+/*
+ * Re-init with unwritten data: invalidate drops it (another medium may be in
+ * the slot now), a flush before it keeps it, and a failed flush leaves it
+ * in the cache.
+ */
+static void blkcache_test_invalidate(void)
+{
+	BYTE buf[4 * BLKCACHE_SECTOR_SIZE];
+	BYTE chk[4 * BLKCACHE_SECTOR_SIZE];
+	struct blkcache *bc;
+
+	sim_reset();
+	bc = blkcache_create(&sim_ops, 16, 4, SIM_SECTORS);
+	TEST_ASSERT(bc != NULL);
+
+	fill(buf, 100, 2, 0x5a5a5a5a);
+	TEST_ASSERT_EQ(blkcache_write(bc, buf, 100, 2), RES_OK);
+	TEST_ASSERT_EQ(sim.cmds, 0);
+
+	/* device refuses the write back, the dirty lines must stay */
+	sim.fail = 1;
+	TEST_ASSERT(blkcache_flush(bc) != RES_OK);
+	TEST_ASSERT(memcmp(sim.mem + 100 * BLKCACHE_SECTOR_SIZE, buf,
+	                   2 * BLKCACHE_SECTOR_SIZE) != 0);
+	TEST_ASSERT_EQ(blkcache_read(bc, chk, 100, 2), RES_OK);
+	TEST_ASSERT(memcmp(chk, buf, 2 * BLKCACHE_SECTOR_SIZE) == 0);
+
+	/* device back, flushed then dropped */
+	sim.fail = 0;
+	TEST_ASSERT_EQ(blkcache_flush(bc), RES_OK);
+	TEST_ASSERT_EQ(blkcache_invalidate(bc, SIM_SECTORS), 0);
+	TEST_ASSERT(memcmp(sim.mem + 100 * BLKCACHE_SECTOR_SIZE, buf,
+	                   2 * BLKCACHE_SECTOR_SIZE) == 0);
+
+	/* dropped without a flush, nothing reaches the device */
+	fill(buf, 200, 3, 0xa5a5a5a5);
+	TEST_ASSERT_EQ(blkcache_write(bc, buf, 200, 3), RES_OK);
+	sim.cmds = 0;
+	TEST_ASSERT_EQ(blkcache_invalidate(bc, SIM_SECTORS), 3);
+	TEST_ASSERT_EQ(sim.cmds, 0);
+	TEST_ASSERT_EQ(blkcache_flush(bc), RES_OK);
+	TEST_ASSERT_EQ(sim.cmds, 0);
+	TEST_ASSERT_EQ(blkcache_read(bc, chk, 200, 3), RES_OK);
+	TEST_ASSERT(memcmp(chk, sim.mem + 200 * BLKCACHE_SECTOR_SIZE,
+	                   3 * BLKCACHE_SECTOR_SIZE) == 0);
+	TEST_ASSERT(memcmp(chk, buf, 3 * BLKCACHE_SECTOR_SIZE) != 0);
+	blkcache_destroy(bc);
+
+	/* same through the RAM disk: a second initialize must not lose data */
+	TEST_ASSERT_EQ(RAM_disk_setup(NULL, 256), 0);
+	TEST_ASSERT_EQ(RAM_disk_initialize(), 0);
+	fill(buf, 7, 4, 0x12345678);
+	TEST_ASSERT_EQ(RAM_disk_write(buf, 7, 4), RES_OK);
+	TEST_ASSERT_EQ(RAM_disk_initialize(), 0);
+	memset(chk, 0, sizeof(chk));
+	TEST_ASSERT_EQ(RAM_disk_read(chk, 7, 4), RES_OK);
+	TEST_ASSERT(memcmp(chk, buf, sizeof(buf)) == 0);
+	RAM_disk_release();
+}
+
+/* ------------------------------------------------------------------------ */
+
+typedef DRESULT (*bench_read_t)(void *ctx, BYTE *buff, DWORD sector, UINT count);
+typedef DRESULT (*bench_write_t)(void *ctx, const BYTE *buff, DWORD sector, UINT count);
+
+static DRESULT direct_read(void *ctx, BYTE *buff, DWORD sector, UINT count)
+{
+	return sim_read(buff, sector, count);
+}
+
+static DRESULT direct_write(void *ctx, const BYTE *buff, DWORD sector, UINT count)
+{
+	return sim_write(buff, sector, count);
+}
+
+static DRESULT cached_read(void *ctx, BYTE *buff, DWORD sector, UINT count)
+{
+	return blkcache_read(ctx, buff, sector, count);
+}
+
+static DRESULT cached_write(void *ctx, const BYTE *buff, DWORD sector, UINT count)
+{
+	return blkcache_write(ctx, buff, sector, count);
+}
+
+/*
+ * Access patterns as FatFS produces them with the SD card: single sector
+ * reads/writes of the FAT and directory areas and of file data that is not
+ * sector aligned.
+ */
+enum {
+	BENCH_SEQ_READ,		/* file read in 1-sector steps */
+	BENCH_SEQ_WRITE,	/* file append: data sector + FAT sector */
+	BENCH_DIR_SCAN,		/* repeated scans of a 16-sector directory */
+	BENCH_RANDOM,		/* random 1-sector reads/writes in 1 MB */
+	BENCH_NUM
+};
+
+static const char *bench_name[BENCH_NUM] = {
+	"seq read", "seq write + FAT", "dir scan", "random 1 MB",
+};
+
+static void bench_run(int type, void *ctx, bench_read_t rd, bench_write_t wr)
+{
+	BYTE buf[BLKCACHE_SECTOR_SIZE];
+	uint32_t seed = 7;
+	DWORD s;
+	int i, n;
+
+	switch (type) {
+	case BENCH_SEQ_READ:
+		for (s = 1024; s < 1024 + 4096; s++)
+			TEST_ASSERT_EQ(rd(ctx, buf, s, 1), RES_OK);
+		break;
+	case BENCH_SEQ_WRITE:
+		for (s = 1024; s < 1024 + 2048; s++) {
+			fill(buf, s, 1, 0);
+			TEST_ASSERT_EQ(wr(ctx, buf, s, 1), RES_OK);
+			TEST_ASSERT_EQ(rd(ctx, buf, 32 + (s >> 7), 1), RES_OK);
+			TEST_ASSERT_EQ(wr(ctx, buf, 32 + (s >> 7), 1), RES_OK);
+		}
+		break;
+	case BENCH_DIR_SCAN:
+		for (n = 0; n < 256; n++)
+			for (s = 64; s < 80; s++)
+				TEST_ASSERT_EQ(rd(ctx, buf, s, 1), RES_OK);
+		break;
+	case BENCH_RANDOM:
+		for (i = 0; i < 8192; i++) {
+			s = test_rand(&seed) % 2048;
+			if (test_rand(&seed) % 4 == 0) {
+				fill(buf, s, 1, i);
+				TEST_ASSERT_EQ(wr(ctx, buf, s, 1), RES_OK);
+			} else {
+				TEST_ASSERT_EQ(rd(ctx, buf, s, 1), RES_OK);
+			}
+		}
+		break;
+	}
+}
+
+static void blkcache_bench(void)
+{
+	struct blkcache_stats st;
+	struct blkcache *bc;
+	uint32_t cmds[2], secs[2];
+	uint64_t us[2];
+	int type;
+
+	printf("\n%-16s %10s %10s %10s %10s %8s\n", "pattern",
+	       "cmds", "cmds", "dev ms", "dev ms", "speedup");
+	printf("%-16s %10s %10s %10s %10s\n", "",
+	       "direct", "cached", "direct", "cached");
+
+	for (type = 0; type < BENCH_NUM; type++) {
+		sim_reset();
+		bench_run(type, NULL, direct_read, direct_write);
+		cmds[0] = sim.cmds;
+		secs[0] = sim.sectors;
+
+		sim_reset();
+		bc = blkcache_create(&sim_ops, 0, 0, SIM_SECTORS);
+		TEST_ASSERT(bc != NULL);
+		bench_run(type, bc, cached_read, cached_write);
+		TEST_ASSERT_EQ(blkcache_flush(bc), RES_OK);
+		blkcache_get_stats(bc, &st);
+		blkcache_destroy(bc);
+		cmds[1] = sim.cmds;
+		secs[1] = sim.sectors;
+
+		us[0] = (uint64_t)cmds[0] * SIM_CMD_US + (uint64_t)secs[0] * SIM_SECTOR_US;
+		us[1] = (uint64_t)cmds[1] * SIM_CMD_US + (uint64_t)secs[1] * SIM_SECTOR_US;
+		printf("%-16s %10u %10u %10u %10u %7.1fx\n", bench_name[type],
+		       cmds[0], cmds[1], (unsigned)(us[0] / 1000),
+		       (unsigned)(us[1] / 1000), (double)us[0] / us[1]);
+
+		/* the cache must never cost more device commands */
+		TEST_ASSERT(cmds[1] <= cmds[0]);
+	}
+	printf("\n");
+}
+
+/* Host throughput of the cache itself over the RAM disk */
+static void ramdisk_bench(void)
+{
+	static BYTE buf[8 * BLKCACHE_SECTOR_SIZE];
+	uint64_t t;
+	DWORD s;
+	int pass;
+
+	TEST_ASSERT_EQ(RAM_disk_setup(NULL, 16384), 0);
+	TEST_ASSERT_EQ(RAM_disk_initialize(), 0);
+
+	t = test_now_ns();
+	for (pass = 0; pass < 8; pass++)
+		for (s = 0; s < 16384; s++)
+			TEST_ASSERT_EQ(RAM_disk_read(buf, s, 1), RES_OK);
+	t = test_now_ns() - t;
+	printf("ramdisk 1-sector read  %8.1f MB/s\n",
+	       8.0 * 16384 * BLKCACHE_SECTOR_SIZE * 1000 / t);
+
+	t = test_now_ns();
+	for (pass = 0; pass < 8; pass++)
+		for (s = 0; s < 16384; s++)
+			TEST_ASSERT_EQ(RAM_disk_write(buf, s, 1), RES_OK);
+	TEST_ASSERT_EQ(RAM_disk_ioctl(CTRL_SYNC, NULL), RES_OK);
+	t = test_now_ns() - t;
+	printf("ramdisk 1-sector write %8.1f MB/s\n",
+	       8.0 * 16384 * BLKCACHE_SECTOR_SIZE * 1000 / t);
+
+	RAM_disk_release();
+}
+
+void blkcache_test(void)
+{
+	sim.mem = malloc(SIM_SECTORS * BLKCACHE_SECTOR_SIZE);
+	TEST_ASSERT(sim.mem != NULL);
+
+	TEST_RUN(blkcache_test_shadow);
+	TEST_RUN(blkcache_test_invalidate);
+	blkcache_bench();
+	ramdisk_bench();
+
+	free(sim.mem);
+}
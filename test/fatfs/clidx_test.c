@@ -0,0 +1,213 @@
+/*
+ * f_lseek() through fragmented files on a sparse multi-GB RAM disk.
+ *
+ * The image is formatted here as FAT32 (_USE_MKFS is off in the SDK) and
+ * backed by an anonymous MAP_NORESERVE mapping, so only the sectors FatFS
+ * touches take host memory. Two files are written in alternating clusters,
+ * which makes every cluster of both files a fragment of its own; random
+ * seeks are then checked against the written pattern and the number of
+ * disk_read() calls they need is reported.
+ *
+ * Built twice by the Makefile, with and without _USE_CLIDX, so the two
+ * runs can be compared directly.
+ */
+
+#include <string.h>
+#include <sys/mman.h>
+#include "test.h"
+#include "fatfs_test.h"
+#include "fs/fatfs/ff.h"
+#include "fs/fatfs/diskio.h"
+#include "ram_diskio.h"
+
+#define IMG_SECTORS		(6ull * 1024 * 1024 * 2)	/* 6 GB */
+#define CLUST_SECTORS		8				/* 4 KB */
+#define RSVD_SECTORS		32
+#define FILE_SIZE		(64u << 20)
+#define NR_SEEKS		2000
+
+static uint32_t disk_reads;
+
+/* FatFS glue, volume 0 is the RAM disk */
+DSTATUS disk_initialize(BYTE pdrv)
+{
+	return RAM_disk_initialize();
+}
+
+DSTATUS disk_status(BYTE pdrv)
+{
+	return RAM_disk_status();
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+	disk_reads++;
+	return RAM_disk_read(buff, sector, count);
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+	return RAM_disk_write(buff, sector, count);
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+	return RAM_disk_ioctl(cmd, buff);
+}
+
+static void st16(BYTE *p, uint16_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static void st32(BYTE *p, uint32_t v)
+{
+	st16(p, v);
+	st16(p + 2, v >> 16);
+}
+
+/* Minimal FAT32 format: boot sector, FSInfo, two FATs, root at cluster 2 */
+static void mkfat32(BYTE *img, uint32_t nsec)
+{
+	BYTE *bs = img, *fsi = img + 512, *fat;
+	uint32_t fatsz, nclst;
+	int i;
+
+	fatsz = 1;
+	do {
+		nclst = (nsec - RSVD_SECTORS - 2 * fatsz) / CLUST_SECTORS;
+		if ((nclst + 2) * 4 <= fatsz * 512)
+			break;
+		fatsz = ((nclst + 2) * 4 + 511) / 512;
+	} while (1);
+
+	memcpy(bs, "\xEB\x58\x90" "MSWIN4.1", 11);
+	st16(bs + 11, 512);			/* BPB_BytsPerSec */
+	bs[13] = CLUST_SECTORS;			/* BPB_SecPerClus */
+	st16(bs + 14, RSVD_SECTORS);		/* BPB_RsvdSecCnt */
+	bs[16] = 2;				/* BPB_NumFATs */
+	bs[21] = 0xF8;				/* BPB_Media */
+	st16(bs + 24, 63);
+	st16(bs + 26, 255);
+	st32(bs + 32, nsec);			/* BPB_TotSec32 */
+	st32(bs + 36, fatsz);			/* BPB_FATSz32 */
+	st32(bs + 44, 2);			/* BPB_RootClus32 */
+	st16(bs + 48, 1);			/* BPB_FSInfo32 */
+	st16(bs + 50, 6);			/* BPB_BkBootSec32 */
+	bs[64] = 0x80;
+	bs[66] = 0x29;
+	st32(bs + 67, 0x20171019);
+	memcpy(bs + 71, "NO NAME    FAT32   ", 19);
+	st16(bs + 510, 0xAA55);
+
+	st32(fsi, 0x41615252);
+	st32(fsi + 484, 0x61417272);
+	st32(fsi + 488, 0xFFFFFFFF);		/* free count unknown */
+	st32(fsi + 492, 0xFFFFFFFF);
+	st16(fsi + 510, 0xAA55);
+
+	for (i = 0; i < 2; i++) {
+		fat = img + (RSVD_SECTORS + i * fatsz) * 512ull;
+		st32(fat, 0x0FFFFFF8);
+		st32(fat + 4, 0x0FFFFFFF);
+		st32(fat + 8, 0x0FFFFFFF);	/* root directory */
+	}
+}
+
+static void pattern(BYTE *buf, uint32_t id, uint32_t ofs, UINT len)
+{
+	UINT i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (BYTE)(((ofs + i) * 2654435761u ^ id) >> 11);
+}
+
+#define CHECK_FR(x)	TEST_ASSERT_EQ((x), FR_OK)
+
+static void seek_verify(FIL *fp, uint32_t *seed, uint32_t size,
+                        uint32_t split, uint32_t id_lo, uint32_t id_hi)
+{
+	BYTE buf[100], ref[100];
+	uint32_t ofs;
+	UINT br;
+	int n;
+
+	for (n = 0; n < NR_SEEKS; n++) {
+		ofs = test_rand(seed) % (size - sizeof(buf));
+		if (ofs < split && ofs + sizeof(buf) > split)
+			ofs = split;
+		CHECK_FR(f_lseek(fp, ofs));
+		CHECK_FR(f_read(fp, buf, sizeof(buf), &br));
+		TEST_ASSERT_EQ(br, sizeof(buf));
+		pattern(ref, ofs < split ? id_lo : id_hi, ofs, sizeof(ref));
+		TEST_ASSERT(memcmp(buf, ref, sizeof(buf)) == 0);
+	}
+}
+
+static void clidx_test_seek(void)
+{
+	static FATFS fs;
+	static BYTE buf[4096];
+	FIL a, b;
+	BYTE *img;
+	uint32_t ofs, seed = 3, reads;
+	uint64_t t;
+	UINT bw;
+
+	img = mmap(NULL, IMG_SECTORS * 512, PROT_READ | PROT_WRITE,
+	           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	TEST_ASSERT(img != MAP_FAILED);
+	mkfat32(img, IMG_SECTORS);
+	TEST_ASSERT_EQ(RAM_disk_setup(img, IMG_SECTORS), 0);
+	CHECK_FR(f_mount(&fs, "", 1));
+	TEST_ASSERT_EQ(fs.fs_type, FS_FAT32);
+
+	/* alternate clusters between the two files */
+	CHECK_FR(f_open(&a, "a.bin", FA_READ | FA_WRITE | FA_CREATE_ALWAYS));
+	CHECK_FR(f_open(&b, "b.bin", FA_WRITE | FA_CREATE_ALWAYS));
+	for (ofs = 0; ofs < FILE_SIZE; ofs += sizeof(buf)) {
+		pattern(buf, 1, ofs, sizeof(buf));
+		CHECK_FR(f_write(&a, buf, sizeof(buf), &bw));
+		pattern(buf, 2, ofs, sizeof(buf));
+		CHECK_FR(f_write(&b, buf, sizeof(buf), &bw));
+	}
+	CHECK_FR(f_close(&b));
+	CHECK_FR(f_sync(&a));
+
+	/* the index is built by the first seeks and used by the later ones */
+	reads = disk_reads;
+	t = test_now_ns();
+	seek_verify(&a, &seed, FILE_SIZE, FILE_SIZE, 1, 1);
+	t = test_now_ns() - t;
+	printf("\n  _USE_CLIDX=%d: %d seeks in %u clusters, %.1f ms, %u disk reads\n",
+	       _USE_CLIDX, NR_SEEKS, FILE_SIZE / 4096, t / 1e6, disk_reads - reads);
+
+	/* truncate and regrow interleaved with another file */
+	CHECK_FR(f_lseek(&a, FILE_SIZE / 2));
+	CHECK_FR(f_truncate(&a));
+	CHECK_FR(f_open(&b, "c.bin", FA_WRITE | FA_CREATE_ALWAYS));
+	for (ofs = FILE_SIZE / 2; ofs < FILE_SIZE; ofs += sizeof(buf)) {
+		pattern(buf, 3, ofs, sizeof(buf));
+		CHECK_FR(f_write(&a, buf, sizeof(buf), &bw));
+		pattern(buf, 4, ofs, sizeof(buf));
+		CHECK_FR(f_write(&b, buf, sizeof(buf), &bw));
+	}
+	CHECK_FR(f_close(&b));
+	seek_verify(&a, &seed, FILE_SIZE, FILE_SIZE / 2, 1, 3);
+	CHECK_FR(f_close(&a));
+
+	/* reopen: a stale index must not be reused */
+	CHECK_FR(f_open(&a, "b.bin", FA_READ));
+	seek_verify(&a, &seed, FILE_SIZE, FILE_SIZE, 2, 2);
+	CHECK_FR(f_close(&a));
+
+	CHECK_FR(f_mount(NULL, "", 0));
+	RAM_disk_release();
+	munmap(img, IMG_SECTORS * 512);
+}
+
+void clidx_test(void)
+{
+	TEST_RUN(clidx_test_seek);
+}
@@ -0,0 +1,7 @@
+#ifndef _FATFS_TEST_H_
+#define _FATFS_TEST_H_
+
+void blkcache_test(void);
+void clidx_test(void);
+
+#endif /* _FATFS_TEST_H_ */
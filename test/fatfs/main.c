@@ -0,0 +1,15 @@
+/*
+ * FatFS host tests, "clidx" as argument runs the cluster index test only
+ */
+
+#include <string.h>
+#include "test.h"
+#include "fatfs_test.h"
+
+int main(int argc, char **argv)
+{
+	if (argc < 2 || strcmp(argv[1], "clidx") != 0)
+		blkcache_test();
+	clidx_test();
+	return 0;
+}
@@ -0,0 +1,277 @@
+/*
+ * Fixed-point FFT: every size of the complex and real Q15/Q31 transforms
+ * against a direct double precision DFT, full-scale input, the power, dB
+ * and magnitude helpers, and the time (and cycles on x86) per transform.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "test.h"
+#include "fft_test.h"
+#include "audio/fft/audio_fft.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC	1
+#else
+#define HAVE_TSC	0
+#endif
+
+#define MAX_REAL	(2 * AUDIO_FFT_MAX_POINTS)
+
+static double xr[MAX_REAL], xi[MAX_REAL];	/* input, |x| < 1 */
+static double Xr[MAX_REAL], Xi[MAX_REAL];	/* reference X[k] / N */
+static double cs[MAX_REAL], sn[MAX_REAL];
+static int16_t d15[2 * MAX_REAL];
+static int32_t d31[2 * MAX_REAL];
+static double snr[2][14][2];		/* [real][log2 N][Q15, Q31] */
+
+/* direct DFT, scaled by 1/N like the fixed-point transforms */
+static void ref_dft(int n, int bins)
+{
+	double re, im;
+	int i, k, m;
+
+	for (i = 0; i < n; i++) {
+		cs[i] = cos(2 * M_PI * i / n);
+		sn[i] = sin(2 * M_PI * i / n);
+	}
+	for (k = 0; k < bins; k++) {
+		re = 0;
+		im = 0;
+		for (i = 0, m = 0; i < n; i++, m = (m + k) & (n - 1)) {
+			re += xr[i] * cs[m] + xi[i] * sn[m];
+			im += xi[i] * cs[m] - xr[i] * sn[m];
+		}
+		Xr[k] = re / n;
+		Xi[k] = im / n;
+	}
+}
+
+/* two tones and some noise */
+static void make_input(int n, int real, uint32_t seed)
+{
+	double t;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		t = (double)i / n;
+		xr[i] = 0.4 * cos(2 * M_PI * 7 * t + 0.3) + 0.2 * sin(2 * M_PI * (n / 5) * t)
+		        + 0.05 * ((int32_t)test_rand(&seed) / 2147483648.0);
+		xi[i] = real ? 0 : 0.4 * sin(2 * M_PI * 3 * t) - 0.2 * cos(2 * M_PI * (n / 3) * t)
+		                   + 0.05 * ((int32_t)test_rand(&seed) / 2147483648.0);
+	}
+}
+
+/* bin @k of the output, real plans pack X[N/2].re in place of X[0].im */
+static void get_bin(int n, int real, int q, int k, double *re, double *im)
+{
+	double sc = q == 15 ? 32768.0 : 2147483648.0;
+	int ir, ii;
+
+	if (real && k == 0) {
+		ir = 0;
+		ii = -1;
+	} else if (real && k == n / 2) {
+		ir = 1;
+		ii = -1;
+	} else {
+		ir = 2 * k;
+		ii = 2 * k + 1;
+	}
+	*re = (q == 15 ? d15[ir] : d31[ir]) / sc;
+	*im = ii < 0 ? 0 : (q == 15 ? d15[ii] : d31[ii]) / sc;
+}
+
+static double run_snr(audio_fft_t *f, int n, int real, int q)
+{
+	double sc = q == 15 ? 32768.0 : 2147483648.0;
+	double s = 0, e = 0, re, im;
+	int bins = real ? n / 2 + 1 : n;
+	int i, k;
+
+	for (i = 0; i < n; i++) {
+		if (real) {
+			if (q == 15)
+				d15[i] = lrint(xr[i] * sc);
+			else
+				d31[i] = lrint(xr[i] * sc);
+		} else if (q == 15) {
+			d15[2 * i] = lrint(xr[i] * sc);
+			d15[2 * i + 1] = lrint(xi[i] * sc);
+		} else {
+			d31[2 * i] = lrint(xr[i] * sc);
+			d31[2 * i + 1] = lrint(xi[i] * sc);
+		}
+	}
+	if (q == 15)
+		audio_fft_q15(f, d15);
+	else
+		audio_fft_q31(f, d31);
+
+	for (k = 0; k < bins; k++) {
+		get_bin(n, real, q, k, &re, &im);
+		s += Xr[k] * Xr[k] + Xi[k] * Xi[k];
+		e += (re - Xr[k]) * (re - Xr[k]) + (im - Xi[k]) * (im - Xi[k]);
+	}
+	return 10 * log10(s / (e + 1e-300));
+}
+
+static void audio_fft_test_accuracy(void)
+{
+	audio_fft_t *f;
+	double snr15, snr31;
+	int real, n;
+
+	for (real = 0; real < 2; real++) {
+		for (n = real ? 8 : 4; n <= (real ? MAX_REAL : AUDIO_FFT_MAX_POINTS); n *= 2) {
+			f = audio_fft_create(n, (real ? AUDIO_FFT_REAL : 0) |
+			                        AUDIO_FFT_Q15 | AUDIO_FFT_Q31);
+			TEST_ASSERT(f != NULL);
+			TEST_ASSERT_EQ(audio_fft_bins(f), real ? n / 2 + 1 : n);
+
+			make_input(n, real, n + real);
+			ref_dft(n, real ? n / 2 + 1 : n);
+			snr15 = run_snr(f, n, real, 15);
+			snr31 = run_snr(f, n, real, 31);
+			/* the 1/N scaling costs about 3 dB per doubling */
+			TEST_ASSERT(snr15 >= 78 - 3.5 * log2(n));
+			TEST_ASSERT(snr31 >= 170 - 3.5 * log2(n));
+			snr[real][(int)log2(n)][0] = snr15;
+			snr[real][(int)log2(n)][1] = snr31;
+			audio_fft_destroy(f);
+		}
+	}
+
+	/* sizes out of range or not a power of 2 */
+	TEST_ASSERT(audio_fft_create(2, AUDIO_FFT_Q15) == NULL);
+	TEST_ASSERT(audio_fft_create(96, AUDIO_FFT_Q15) == NULL);
+	TEST_ASSERT(audio_fft_create(2 * AUDIO_FFT_MAX_POINTS, AUDIO_FFT_Q15) == NULL);
+}
+
+/* real input may use the full range without wrapping */
+static void audio_fft_test_full_scale(void)
+{
+	audio_fft_t *f = audio_fft_create(1024, AUDIO_FFT_REAL | AUDIO_FFT_Q15 | AUDIO_FFT_Q31);
+	int i;
+
+	TEST_ASSERT(f != NULL);
+	for (i = 0; i < 1024; i++) {
+		d15[i] = i & 1 ? -32768 : 32767;
+		d31[i] = i & 1 ? INT32_MIN : INT32_MAX;
+	}
+	audio_fft_q15(f, d15);
+	audio_fft_q31(f, d31);
+	TEST_ASSERT(d15[1] >= 32766);		/* X[N/2] ~ 1.0 */
+	TEST_ASSERT(d31[1] >= INT32_MAX - 4096);
+	TEST_ASSERT(abs(d15[0]) <= 1 && abs(d31[0]) <= 4096);
+
+	for (i = 0; i < 1024; i++)
+		d15[i] = 32767;
+	audio_fft_q15(f, d15);
+	TEST_ASSERT(d15[0] >= 32766);
+	audio_fft_destroy(f);
+}
+
+static void audio_fft_test_helpers(void)
+{
+	uint32_t seed = 5, bins, k, r;
+	audio_fft_t *f;
+	uint64_t v, *p64;
+	uint32_t *p32;
+	double ref, err, max_err = 0, re, im;
+	int i, fb;
+
+	/* dB within 0.01 dB over the whole range */
+	for (i = 0; i < 200000; i++) {
+		v = ((uint64_t)test_rand(&seed) << 32 | test_rand(&seed)) >> (test_rand(&seed) % 64);
+		if (v == 0)
+			continue;
+		fb = test_rand(&seed) % 63;
+		ref = 10 * log10((double)v) - 10 * log10(2) * fb;
+		err = fabs(audio_fft_db(v, fb) / 256.0 - ref);
+		if (err > max_err)
+			max_err = err;
+	}
+	TEST_ASSERT(max_err < 0.01);
+	TEST_ASSERT_EQ(audio_fft_db(0, 0), AUDIO_FFT_DB_FLOOR);
+
+	/* magnitude is floor(sqrt()) */
+	for (i = 0; i < 100000; i++) {
+		v = ((uint64_t)test_rand(&seed) << 32 | test_rand(&seed)) >> (test_rand(&seed) % 64);
+		r = audio_fft_mag(v);
+		TEST_ASSERT((uint64_t)r * r <= v);
+		TEST_ASSERT((uint64_t)(r + 1) * (r + 1) > v);
+	}
+	TEST_ASSERT_EQ(audio_fft_mag(~0ULL), 0xFFFFFFFFu);
+
+	/* power of each bin matches the spectrum */
+	f = audio_fft_create(256, AUDIO_FFT_REAL | AUDIO_FFT_Q15 | AUDIO_FFT_Q31);
+	bins = audio_fft_bins(f);
+	p32 = malloc(bins * sizeof(*p32));
+	p64 = malloc(bins * sizeof(*p64));
+	make_input(256, 1, 1);
+	ref_dft(256, bins);
+	run_snr(f, 256, 1, 15);
+	audio_fft_power_q15(f, d15, p32);
+	run_snr(f, 256, 1, 31);
+	audio_fft_power_q31(f, d31, p64);
+	for (k = 0; k < bins; k++) {
+		get_bin(256, 1, 31, k, &re, &im);
+		TEST_ASSERT(fabs(p64[k] / 4611686018427387904.0 - (re * re + im * im)) < 1e-12);
+		TEST_ASSERT(fabs(p32[k] / 1073741824.0 - (re * re + im * im)) < 1e-4);
+	}
+	free(p32);
+	free(p64);
+	audio_fft_destroy(f);
+}
+
+static void audio_fft_bench(void)
+{
+	audio_fft_t *f;
+	uint64_t t, c = 0;
+	int real, n, q, reps, r;
+
+	printf("\n%-6s %-5s %-4s %8s %10s%s\n", "N", "type", "Q", "SNR dB", "us/fft",
+	       HAVE_TSC ? "  cycles/fft" : "");
+	for (real = 0; real < 2; real++) {
+		for (n = real ? 8 : 4; n <= (real ? MAX_REAL : AUDIO_FFT_MAX_POINTS); n *= 2) {
+			f = audio_fft_create(n, (real ? AUDIO_FFT_REAL : 0) |
+			                        AUDIO_FFT_Q15 | AUDIO_FFT_Q31);
+			make_input(n, real, 1);
+			for (q = 15; q <= 31; q += 16) {
+				memset(d15, 0, sizeof(d15));
+				memset(d31, 0, sizeof(d31));
+				reps = 1000000 / n + 10;
+				t = test_now_ns();
+#if HAVE_TSC
+				c = __rdtsc();
+#endif
+				for (r = 0; r < reps; r++) {
+					if (q == 15)
+						audio_fft_q15(f, d15);
+					else
+						audio_fft_q31(f, d31);
+				}
+#if HAVE_TSC
+				c = (__rdtsc() - c) / reps;
+#endif
+				t = test_now_ns() - t;
+				printf("%-6d %-5s Q%-3d %8.1f %10.2f", n, real ? "real" : "cplx", q,
+				       snr[real][(int)log2(n)][q == 31], t / 1e3 / reps);
+				if (HAVE_TSC)
+					printf("  %10llu", (unsigned long long)c);
+				printf("\n");
+			}
+			audio_fft_destroy(f);
+		}
+	}
+}
+
+void audio_fft_test(void)
+{
+	TEST_RUN(audio_fft_test_accuracy);
+	TEST_RUN(audio_fft_test_full_scale);
+	TEST_RUN(audio_fft_test_helpers);
+	audio_fft_bench();
+}
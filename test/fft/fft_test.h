@@ -0,0 +1,6 @@
+#ifndef _FFT_TEST_H_
+#define _FFT_TEST_H_
+
+void audio_fft_test(void);
+
+#endif /* _FFT_TEST_H_ */
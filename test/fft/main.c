@@ -0,0 +1,8 @@
+#include "test.h"
+#include "fft_test.h"
+
+int main(int argc, char **argv)
+{
+	audio_fft_test();
+	return 0;
+}
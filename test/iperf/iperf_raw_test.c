@@ -0,0 +1,231 @@
+/*
+ * iperf raw API engine: a client and a server task talk over the lwIP
+ * loopback netif. TCP by time and by amount, paced and unpaced UDP, the
+ * UDP FIN retries without a server, stopping a waiting server and a
+ * refused connection all end their tasks, and the bytes counted on both
+ * sides agree. Loopback throughput is printed for each mode.
+ */
+
+#include <stdarg.h>
+
+#include "iperf.h"
+#include "lwip/tcpip.h"
+#include "test.h"
+#include "iperf_test.h"
+
+#define NR_HANDLES	2
+
+/* the engine logs every start, report and exit, kept off the output */
+static int quiet;
+
+int printf(const char *fmt, ...)
+{
+	va_list ap;
+	int ret;
+
+	if (quiet)
+		return 0;
+	va_start(ap, fmt);
+	ret = vprintf(fmt, ap);
+	va_end(ap);
+	return ret;
+}
+
+int puts(const char *s)
+{
+	return quiet ? 0 : fputs(s, stdout) < 0 ? EOF : putchar('\n');
+}
+
+/* what iperf_raw.c needs from iperf.c and the RTC driver */
+static OS_Semaphore_t task_done;
+static uint64_t end_bytes[NR_HANDLES];
+static uint32_t end_ms[NR_HANDLES];
+
+uint64_t HAL_RTC_GetFreeRunTime(void)
+{
+	return test_now_ns() / 1000;
+}
+
+void iperf_speed_log(iperf_arg *arg, uint64_t bytes, uint32_t time, int8_t is_end)
+{
+	if (is_end) {
+		end_bytes[arg->handle] = bytes;
+		end_ms[arg->handle] = time ? time : 1;
+	}
+}
+
+int iperf_handle_free(int handle)
+{
+	OS_SemaphoreRelease(&task_done);
+	return 0;
+}
+
+static iperf_arg args[NR_HANDLES];
+
+static void iperf_arg_init(int handle, enum IPERF_MODE mode, uint32_t port)
+{
+	iperf_arg *arg = &args[handle];
+
+	memset(arg, 0, sizeof(*arg));
+	arg->mode = mode;
+	arg->port = port;
+	arg->interval = 1;
+	arg->handle = handle;
+	arg->flags = IPERF_FLAG_RAW;
+	if (mode == IPERF_MODE_UDP_SEND || mode == IPERF_MODE_TCP_SEND)
+		strcpy(arg->remote_ip, "127.0.0.1");
+	end_bytes[handle] = 0;
+	end_ms[handle] = 0;
+	quiet = 1;
+}
+
+static void iperf_run(int handle)
+{
+	TEST_ASSERT_EQ(OS_ThreadCreate(&args[handle].iperf_thread, "iperf",
+	                               iperf_raw_task, &args[handle],
+	                               OS_THREAD_PRIO_APP, 16 * 1024), OS_OK);
+}
+
+/* wait for @n tasks to end, setting the stop flag of @stop after @stop_ms */
+static void iperf_wait(int n, iperf_arg *stop, uint32_t stop_ms)
+{
+	if (stop) {
+		TEST_ASSERT(OS_SemaphoreWait(&task_done, stop_ms) == OS_E_TIMEOUT);
+		stop->flags |= IPERF_FLAG_STOP;
+	}
+	while (n--)
+		TEST_ASSERT_EQ(OS_SemaphoreWait(&task_done, 20000), OS_OK);
+	quiet = 0;
+}
+
+static double mbps(int handle)
+{
+	return end_bytes[handle] * 8.0 / 1000 / end_ms[handle];
+}
+
+static void iperf_raw_test_tcp(void)
+{
+	/* by time */
+	iperf_arg_init(0, IPERF_MODE_TCP_RECV, 5001);
+	iperf_arg_init(1, IPERF_MODE_TCP_SEND, 5001);
+	args[1].mode_time = 1;
+	args[1].run_time = 1;
+	iperf_run(0);
+	OS_MSleep(50);
+	iperf_run(1);
+	iperf_wait(2, NULL, 0);
+	TEST_ASSERT(end_bytes[1] > 0);
+	TEST_ASSERT_EQ(end_bytes[0], end_bytes[1]);
+	TEST_ASSERT(end_ms[1] >= 900 && end_ms[1] < 3000);
+
+	/* by amount */
+	iperf_arg_init(0, IPERF_MODE_TCP_RECV, 5002);
+	iperf_arg_init(1, IPERF_MODE_TCP_SEND, 5002);
+	args[1].amount = 10 * 1024 * 1024;
+	iperf_run(0);
+	OS_MSleep(50);
+	iperf_run(1);
+	iperf_wait(2, NULL, 0);
+	TEST_ASSERT_EQ(end_bytes[1], 10 * 1024 * 1024);
+	TEST_ASSERT_EQ(end_bytes[0], 10 * 1024 * 1024);
+}
+
+static void iperf_raw_test_udp(void)
+{
+	/* paced to 20 Mb/s */
+	iperf_arg_init(0, IPERF_MODE_UDP_RECV, 5003);
+	iperf_arg_init(1, IPERF_MODE_UDP_SEND, 5003);
+	args[1].mode_time = 1;
+	args[1].run_time = 1;
+	args[1].bandwidth = 20000000;
+	iperf_run(0);
+	OS_MSleep(50);
+	iperf_run(1);
+	iperf_wait(2, NULL, 0);
+	TEST_ASSERT(mbps(1) > 15 && mbps(1) < 25);
+	TEST_ASSERT_EQ(end_bytes[0], end_bytes[1]);
+
+	/* unpaced, 2000 datagrams */
+	iperf_arg_init(0, IPERF_MODE_UDP_RECV, 5004);
+	iperf_arg_init(1, IPERF_MODE_UDP_SEND, 5004);
+	args[1].amount = 2000 * IPERF_UDP_SEND_DATA_LEN;
+	iperf_run(0);
+	OS_MSleep(50);
+	iperf_run(1);
+	iperf_wait(2, NULL, 0);
+	TEST_ASSERT_EQ(end_bytes[1], 2000 * IPERF_UDP_SEND_DATA_LEN);
+	TEST_ASSERT(end_bytes[0] > 0 && end_bytes[0] <= end_bytes[1]);
+}
+
+/* tasks that never get a peer still end */
+static void iperf_raw_test_no_peer(void)
+{
+	/* UDP client without a server: FIN retries, stopped */
+	iperf_arg_init(1, IPERF_MODE_UDP_SEND, 5999);
+	args[1].mode_time = 1;
+	args[1].bandwidth = 1000000;
+	iperf_run(1);
+	iperf_wait(1, &args[1], 500);
+	TEST_ASSERT(end_bytes[1] > 0);
+
+	/* TCP server stopped while waiting for a connection */
+	iperf_arg_init(0, IPERF_MODE_TCP_RECV, 5005);
+	iperf_run(0);
+	iperf_wait(1, &args[0], 300);
+	TEST_ASSERT_EQ(end_bytes[0], 0);
+
+	/* TCP connection refused */
+	iperf_arg_init(1, IPERF_MODE_TCP_SEND, 5998);
+	args[1].mode_time = 1;
+	args[1].run_time = 2;
+	iperf_run(1);
+	iperf_wait(1, NULL, 0);
+	TEST_ASSERT_EQ(end_bytes[1], 0);
+}
+
+static void iperf_raw_bench(void)
+{
+	printf("\nloopback, 1 s each\n");
+
+	iperf_arg_init(0, IPERF_MODE_TCP_RECV, 5011);
+	iperf_arg_init(1, IPERF_MODE_TCP_SEND, 5011);
+	args[1].mode_time = 1;
+	args[1].run_time = 1;
+	iperf_run(0);
+	OS_MSleep(50);
+	iperf_run(1);
+	iperf_wait(2, NULL, 0);
+	printf("  TCP send    %8.1f Mb/s\n", mbps(1));
+
+	iperf_arg_init(0, IPERF_MODE_UDP_RECV, 5012);
+	iperf_arg_init(1, IPERF_MODE_UDP_SEND, 5012);
+	args[1].mode_time = 1;
+	args[1].run_time = 1;
+	iperf_run(0);
+	OS_MSleep(50);
+	iperf_run(1);
+	iperf_wait(2, NULL, 0);
+	printf("  UDP send    %8.1f Mb/s, received %.1f%%\n", mbps(1),
+	       end_bytes[0] * 100.0 / end_bytes[1]);
+}
+
+static void tcpip_init_done(void *arg)
+{
+	OS_SemaphoreRelease(arg);
+}
+
+void iperf_raw_test(void)
+{
+	OS_Semaphore_t init_done;
+
+	TEST_ASSERT_EQ(OS_SemaphoreCreate(&init_done, 0, 1), OS_OK);
+	TEST_ASSERT_EQ(OS_SemaphoreCreate(&task_done, 0, NR_HANDLES), OS_OK);
+	tcpip_init(tcpip_init_done, &init_done);
+	TEST_ASSERT_EQ(OS_SemaphoreWait(&init_done, 5000), OS_OK);
+	OS_SemaphoreDelete(&init_done);
+
+	TEST_RUN(iperf_raw_test_tcp);
+	TEST_RUN(iperf_raw_test_udp);
+	TEST_RUN(iperf_raw_test_no_peer);
+	iperf_raw_bench();
+}
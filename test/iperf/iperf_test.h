@@ -0,0 +1,6 @@
+#ifndef _IPERF_TEST_H_
+#define _IPERF_TEST_H_
+
+void iperf_raw_test(void);
+
+#endif /* _IPERF_TEST_H_ */
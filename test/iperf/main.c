@@ -0,0 +1,8 @@
+#include "test.h"
+#include "iperf_test.h"
+
+int main(int argc, char **argv)
+{
+	iperf_raw_test();
+	return 0;
+}
@@ -0,0 +1,40 @@
+/*
+ * lwIP options of the host tests: threaded stack on the loopback netif
+ * only, large enough buffers for a few MB/s of TCP and UDP.
+ */
+
+#ifndef __LWIPOPTS_H__
+#define __LWIPOPTS_H__
+
+#define NO_SYS				0
+#define SYS_LIGHTWEIGHT_PROT		1
+#define LWIP_SOCKET			0
+#define LWIP_NETCONN			0
+
+#define LWIP_HAVE_LOOPIF		1
+#define LWIP_NETIF_LOOPBACK		1
+#define LWIP_NETIF_LOOPBACK_MULTITHREADING 1
+#define LWIP_DHCP			0
+#define LWIP_DNS			0
+#define IP_REASSEMBLY			0
+#define IP_FRAG				0
+
+#define MEM_ALIGNMENT			4
+#define MEM_SIZE			(256 * 1024)
+#define MEMP_NUM_PBUF			6
+#define MEMP_NUM_TCP_SEG		32
+#define MEMP_NUM_TCPIP_MSG_API		64
+#define PBUF_POOL_SIZE			32
+
+#define TCP_MSS				1460
+#define TCP_SND_BUF			(6 * TCP_MSS)
+#define TCP_WND				(6 * TCP_MSS)
+#define TCP_SND_QUEUELEN		24
+
+#define TCPIP_MBOX_SIZE			128
+#define TCPIP_THREAD_STACKSIZE		(64 * 1024)
+#define DEFAULT_THREAD_STACKSIZE	(64 * 1024)
+
+#define LWIP_STATS			0
+
+#endif /* __LWIPOPTS_H__ */
@@ -0,0 +1,332 @@
+/*
+ * JPEG rate controller fed with fixed frame traces.
+ *
+ * A trace gives the complexity of every frame, the size it encodes to at
+ * quantiser scale 100 (quality 50). The encoder is modelled as
+ * size = complexity * (100 / scale)^b: b = 1 is the model the controller
+ * assumes, real encoders are closer to b = 0.7, the size growing slower than
+ * the quantiser step shrinks. The traces are generated from a fixed seed so
+ * every run sees the same frames: a static scene, hard scene cuts and a slow
+ * pan, with frame to frame noise on top.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "jpeg/jpeg_rc.h"
+#include "test.h"
+
+#define RC_FRAMES	600
+#define RC_SCENE	120	/* frames between the cuts of the cut trace */
+#define RC_FPS		15
+
+enum rc_trace {
+	RC_TRACE_STATIC,
+	RC_TRACE_CUTS,
+	RC_TRACE_PAN,
+	RC_TRACE_NUM,
+};
+
+static const char *rc_trace_name[RC_TRACE_NUM] = { "static", "cuts", "pan" };
+
+/* complexity of the scenes of the cut trace */
+static const uint32_t rc_cuts[RC_FRAMES / RC_SCENE] = {
+	12000, 40000, 20000, 70000, 8000
+};
+
+static uint32_t rc_cplx[RC_FRAMES];
+static uint32_t rc_size[RC_FRAMES];
+static uint8_t rc_quality[RC_FRAMES];
+
+static void rc_trace_gen(enum rc_trace trace)
+{
+	uint32_t seed = 0x1f2e3d4c;
+	double c, noise;
+	int i;
+
+	for (i = 0; i < RC_FRAMES; i++) {
+		switch (trace) {
+		case RC_TRACE_STATIC:
+			c = 20000;
+			break;
+		case RC_TRACE_CUTS:
+			c = rc_cuts[i / RC_SCENE];
+			break;
+		default:
+			c = 25000 + 12000 * sin(i / 12.0);
+			break;
+		}
+		/* +-5% from frame to frame */
+		noise = (double)(test_rand(&seed) % 1001) / 1000 - 0.5;
+		rc_cplx[i] = c * (1 + noise / 10);
+	}
+}
+
+static uint32_t rc_encode(uint32_t cplx, int quality, double b)
+{
+	return cplx * pow(100.0 / JpegQualityToScale(quality), b);
+}
+
+/*
+ * Encode the current trace under the controller, the output buffer truncates
+ * frames at max_size. With link set, the frames go through a link of that
+ * many bit/s and the bytes not sent yet are reported as the backlog.
+ * Returns the largest backlog seen.
+ */
+static uint32_t rc_run(JpegRc *rc, const JpegRcParam *param, double b,
+		       uint32_t link, int backlog)
+{
+	double queued = 0, worst = 0;
+	uint32_t size;
+	int i, q;
+
+	JpegRcInit(rc, param);
+	q = rc->quality;
+	for (i = 0; i < RC_FRAMES; i++) {
+		size = rc_encode(rc_cplx[i], q, b);
+		if (param->max_size && size > param->max_size)
+			size = param->max_size;
+		rc_size[i] = size;
+		rc_quality[i] = q;
+		if (link) {
+			queued += size;
+			queued -= link / 8.0 / RC_FPS;
+			if (queued < 0)
+				queued = 0;
+			if (queued > worst)
+				worst = queued;
+			if (backlog)
+				JpegRcSetBacklog(rc, queued);
+		}
+		q = JpegRcUpdate(rc, size);
+		TEST_ASSERT(q >= rc->param.min_quality && q <= rc->param.max_quality);
+	}
+	return worst;
+}
+
+/* frames after frame "from" until all of them up to "to" are within tol of
+ * the target */
+static int rc_settle(int from, int to, uint32_t target, double tol)
+{
+	int i, settled = to;
+
+	for (i = to - 1; i >= from; i--) {
+		if (fabs((double)rc_size[i] - target) > target * tol)
+			break;
+		settled = i;
+	}
+	return settled - from;
+}
+
+static double rc_avg(int from, int to)
+{
+	double sum = 0;
+	int i;
+
+	for (i = from; i < to; i++)
+		sum += rc_size[i];
+	return sum / (to - from);
+}
+
+static int rc_changes(int from, int to)
+{
+	int i, n = 0;
+
+	for (i = from + 1; i < to; i++)
+		n += rc_quality[i] != rc_quality[i - 1];
+	return n;
+}
+
+static const JpegRcParam rc_frame_param = {
+	.mode = JPEG_RC_FRAME_SIZE,
+	.target = 20000,
+	.fps = RC_FPS,
+	.max_size = 45 * 1024,
+	.quality = 64,
+	.min_quality = 5,
+	.max_quality = 95,
+	.max_step = 5,
+};
+
+static const JpegRcParam rc_rate_param = {
+	.mode = JPEG_RC_BITRATE,
+	.target = 2000000,
+	.fps = RC_FPS,
+	.max_size = 45 * 1024,
+	.quality = 64,
+	.min_quality = 5,
+	.max_quality = 95,
+	.max_step = 5,
+};
+
+static const double rc_b[] = { 0.7, 1.0 };
+
+#define RC_NR_B		(sizeof(rc_b) / sizeof(rc_b[0]))
+
+static void rc_test_static(void)
+{
+	JpegRc rc;
+	int i;
+
+	rc_trace_gen(RC_TRACE_STATIC);
+	for (i = 0; i < RC_NR_B; i++) {
+		rc_run(&rc, &rc_frame_param, rc_b[i], 0, 0);
+		TEST_ASSERT(rc_settle(0, RC_FRAMES, 20000, 0.15) <= 2);
+		TEST_ASSERT(fabs(rc_avg(10, RC_FRAMES) - 20000) < 20000 * 0.03);
+		/* the deadband keeps the noise from moving the quality around */
+		TEST_ASSERT(rc_changes(10, RC_FRAMES) < RC_FRAMES / 10);
+	}
+}
+
+static void rc_test_cuts(void)
+{
+	JpegRcParam p = rc_frame_param;
+	JpegRc rc;
+	int i, s, from, to, limit;
+
+	rc_trace_gen(RC_TRACE_CUTS);
+	for (i = 0; i < RC_NR_B; i++) {
+		rc_run(&rc, &p, rc_b[i], 0, 0);
+		for (s = 0; s < RC_FRAMES / RC_SCENE; s++) {
+			from = s * RC_SCENE;
+			to = from + RC_SCENE;
+			/* a busier scene is corrected at once, a lighter one
+			 * at max_step quality per frame */
+			limit = s == 0 || rc_cuts[s] > rc_cuts[s - 1] ? 4 : 20;
+			TEST_ASSERT(rc_settle(from, to, 20000, 0.15) <= limit);
+			TEST_ASSERT(fabs(rc_avg(from + limit, to) - 20000) < 20000 * 0.05);
+		}
+	}
+
+	/* without the step limit the lighter scenes are caught up at once */
+	p.max_step = 0;
+	for (i = 0; i < RC_NR_B; i++) {
+		rc_run(&rc, &p, rc_b[i], 0, 0);
+		for (s = 0; s < RC_FRAMES / RC_SCENE; s++)
+			TEST_ASSERT(rc_settle(s * RC_SCENE, (s + 1) * RC_SCENE, 20000, 0.15) <= 4);
+	}
+}
+
+static void rc_test_max_step(void)
+{
+	JpegRc rc;
+	int i, fell = 0;
+
+	rc_trace_gen(RC_TRACE_CUTS);
+	rc_run(&rc, &rc_frame_param, 1.0, 0, 0);
+	for (i = 1; i < RC_FRAMES; i++) {
+		TEST_ASSERT(rc_quality[i] <= rc_quality[i - 1] + rc_frame_param.max_step);
+		if (rc_quality[i] + rc_frame_param.max_step < rc_quality[i - 1])
+			fell = 1;
+	}
+	/* only raises are limited */
+	TEST_ASSERT(fell);
+}
+
+static void rc_test_bitrate(void)
+{
+	uint32_t budget = rc_rate_param.target / 8 / RC_FPS;
+	JpegRc rc;
+	int i, t, s;
+
+	for (t = 0; t < RC_TRACE_NUM; t++) {
+		rc_trace_gen(t);
+		for (i = 0; i < RC_NR_B; i++) {
+			rc_run(&rc, &rc_rate_param, rc_b[i], 0, 0);
+			TEST_ASSERT(fabs(rc_avg(0, RC_FRAMES) - budget) < budget * 0.03);
+			for (s = 0; s < RC_FRAMES / RC_SCENE; s++)
+				TEST_ASSERT(fabs(rc_avg(s * RC_SCENE + 20, (s + 1) * RC_SCENE) -
+						 budget) < budget * 0.05);
+		}
+	}
+}
+
+static void rc_test_oversize(void)
+{
+	JpegRcParam p = rc_frame_param;
+	JpegRc rc;
+	int i, s;
+
+	/* the cuts to a busier scene overflow a 30K buffer once */
+	p.max_size = 30000;
+	rc_trace_gen(RC_TRACE_CUTS);
+	rc_run(&rc, &p, 1.0, 0, 0);
+	TEST_ASSERT_EQ(rc.oversize, 2);
+	for (s = 1; s < RC_FRAMES / RC_SCENE; s++) {
+		if (rc_cuts[s] > rc_cuts[s - 1]) {
+			TEST_ASSERT_EQ(rc_size[s * RC_SCENE], p.max_size);
+			TEST_ASSERT(rc_size[s * RC_SCENE + 1] < p.max_size);
+		}
+	}
+
+	/* a target the buffer can't hold keeps a quarter of it free */
+	p.target = 40000;
+	rc_run(&rc, &p, 1.0, 0, 0);
+	for (i = 10; i < RC_FRAMES; i++) {
+		if (i % RC_SCENE < 4)
+			continue;
+		TEST_ASSERT(rc_size[i] < p.max_size - p.max_size / 8);
+	}
+}
+
+static void rc_test_backlog(void)
+{
+	JpegRcParam p = rc_rate_param;
+	uint32_t link = 2000000, budget = link / 8 / RC_FPS;
+	uint32_t worst;
+	JpegRc rc;
+
+	/* a 3 Mbit/s stream over a 2 Mbit/s link */
+	p.target = 3000000;
+	rc_trace_gen(RC_TRACE_CUTS);
+	worst = rc_run(&rc, &p, 1.0, link, 0);
+	TEST_ASSERT(worst > 100 * budget);
+	worst = rc_run(&rc, &p, 1.0, link, 1);
+	TEST_ASSERT(worst < 4 * budget);
+	TEST_ASSERT(fabs(rc_avg(20, RC_FRAMES) - budget) < budget * 0.05);
+}
+
+/* mean distance from the target once the first frames have passed */
+static double rc_dev(uint32_t target)
+{
+	double sum = 0;
+	int i;
+
+	for (i = 10; i < RC_FRAMES; i++)
+		sum += fabs((double)rc_size[i] - target);
+	return sum / (RC_FRAMES - 10) * 100 / target;
+}
+
+static void rc_bench(void)
+{
+	static const JpegRcParam *param[] = { &rc_frame_param, &rc_rate_param };
+	JpegRc rc;
+	int i, m, t;
+
+	printf("\n%-8s %-10s %4s %10s %8s %8s %9s\n", "trace", "mode", "b",
+	       "kbit/s", "dev%", "changes", "oversize");
+	for (t = 0; t < RC_TRACE_NUM; t++) {
+		rc_trace_gen(t);
+		for (m = 0; m < 2; m++) {
+			for (i = 0; i < RC_NR_B; i++) {
+				rc_run(&rc, param[m], rc_b[i], 0, 0);
+				printf("%-8s %-10s %4.1f %10.0f %8.1f %8d %9u\n",
+				       rc_trace_name[t], m ? "bitrate" : "frame size",
+				       rc_b[i], rc_avg(0, RC_FRAMES) * 8 * RC_FPS / 1000,
+				       rc_dev(m ? param[m]->target / 8 / RC_FPS : param[m]->target),
+				       rc_changes(0, RC_FRAMES), rc.oversize);
+			}
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	TEST_RUN(rc_test_static);
+	TEST_RUN(rc_test_cuts);
+	TEST_RUN(rc_test_max_step);
+	TEST_RUN(rc_test_bitrate);
+	TEST_RUN(rc_test_oversize);
+	TEST_RUN(rc_test_backlog);
+	rc_bench();
+	return 0;
+}
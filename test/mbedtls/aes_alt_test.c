@@ -0,0 +1,267 @@
+/*
+ * AES ALT on the simulated engine: the aes.c self test (FIPS-197 and
+ * SP 800-38A vectors) passes, the software key schedule stays within the
+ * context, and random ECB/CBC/CTR jobs match the stock software AES for
+ * every key size, split into random pieces, in place, across a DMA
+ * transfer and across a counter wrap. Long jobs take one engine run per
+ * DMA transfer, short ones none.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include MBEDTLS_CONFIG_FILE
+#include "mbedtls/aes.h"
+#include "driver/chip/hal_dma.h"
+#include "test.h"
+#include "ce_sim.h"
+#include "mbedtls_test.h"
+
+#define BUF_MAX		(DMA_DATA_MAX_LEN + 4096)
+
+static uint8_t *src, *dst, *ref;
+
+static void fill(uint8_t *buf, size_t len, uint32_t *seed)
+{
+	while (len--)
+		*buf++ = test_rand(seed);
+}
+
+static size_t rand_len(uint32_t *seed, size_t unit)
+{
+	/* mostly short, sometimes past one DMA transfer */
+	switch (test_rand(seed) % 8) {
+	case 0:
+		return (DMA_DATA_MAX_LEN + unit * (1 + test_rand(seed) % 64)) / unit * unit;
+	case 1:
+	case 2:
+		return test_rand(seed) % 3 * unit;
+	default:
+		return (test_rand(seed) % 4096) / unit * unit;
+	}
+}
+
+/* input and output in the same buffer half of the time */
+static uint8_t *rand_out(uint32_t *seed)
+{
+	return test_rand(seed) % 2 ? src : dst;
+}
+
+static void aes_alt_test_self(void)
+{
+	TEST_ASSERT_EQ(mbedtls_aes_self_test(0), 0);
+}
+
+/* the key schedule stays within the context for every key size */
+static void aes_alt_test_setkey(void)
+{
+	struct {
+		mbedtls_aes_context ctx;
+		uint32_t guard[16];
+	} s;
+	uint8_t key[32];
+	uint32_t seed = 8;
+	int i, keybits;
+
+	fill(key, sizeof(key), &seed);
+	for (keybits = 128; keybits <= 256; keybits += 64) {
+		memset(s.guard, 0xa5, sizeof(s.guard));
+		mbedtls_aes_init(&s.ctx);
+		TEST_ASSERT_EQ(mbedtls_aes_setkey_enc(&s.ctx, key, keybits), 0);
+		TEST_ASSERT_EQ(mbedtls_aes_setkey_dec(&s.ctx, key, keybits), 0);
+		mbedtls_aes_free(&s.ctx);
+		for (i = 0; i < 16; i++)
+			TEST_ASSERT_EQ(s.guard[i], 0xa5a5a5a5);
+	}
+}
+
+static void aes_alt_test_ecb(void)
+{
+	mbedtls_aes_context ctx;
+	uint8_t key[32], in[16], out[16], exp[16];
+	uint32_t seed = 1;
+	int i, keybits, mode;
+
+	for (i = 0; i < 3000; i++) {
+		keybits = 128 + 64 * (i % 3);
+		mode = test_rand(&seed) % 2 ? MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT;
+		fill(key, sizeof(key), &seed);
+		fill(in, sizeof(in), &seed);
+
+		mbedtls_aes_init(&ctx);
+		if (mode == MBEDTLS_AES_ENCRYPT)
+			TEST_ASSERT_EQ(mbedtls_aes_setkey_enc(&ctx, key, keybits), 0);
+		else
+			TEST_ASSERT_EQ(mbedtls_aes_setkey_dec(&ctx, key, keybits), 0);
+		TEST_ASSERT_EQ(mbedtls_aes_crypt_ecb(&ctx, mode, in, out), 0);
+		mbedtls_aes_free(&ctx);
+
+		ce_sim_ref_ecb(key, keybits, mode, in, exp);
+		TEST_ASSERT(!memcmp(out, exp, 16));
+	}
+}
+
+static void aes_alt_test_cbc(void)
+{
+	mbedtls_aes_context ctx;
+	uint8_t key[32], iv[16], iv_ref[16], *out;
+	uint32_t seed = 2;
+	size_t len, off, n;
+	int i, keybits, mode;
+
+	for (i = 0; i < 300; i++) {
+		keybits = 128 + 64 * (i % 3);
+		mode = test_rand(&seed) % 2 ? MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT;
+		len = rand_len(&seed, 16);
+		fill(key, sizeof(key), &seed);
+		fill(iv, sizeof(iv), &seed);
+		fill(src, len, &seed);
+		memcpy(iv_ref, iv, 16);
+		ce_sim_ref_cbc(key, keybits, mode, len, iv_ref, src, ref);
+
+		mbedtls_aes_init(&ctx);
+		if (mode == MBEDTLS_AES_ENCRYPT)
+			TEST_ASSERT_EQ(mbedtls_aes_setkey_enc(&ctx, key, keybits), 0);
+		else
+			TEST_ASSERT_EQ(mbedtls_aes_setkey_dec(&ctx, key, keybits), 0);
+		out = rand_out(&seed);
+		for (off = 0; off < len; off += n) {
+			n = test_rand(&seed) % 2 ? len - off : rand_len(&seed, 16);
+			n = n < len - off ? n : len - off;
+			TEST_ASSERT_EQ(mbedtls_aes_crypt_cbc(&ctx, mode, n, iv,
+			                                     src + off, out + off), 0);
+		}
+		mbedtls_aes_free(&ctx);
+
+		TEST_ASSERT(!memcmp(out, ref, len));
+		TEST_ASSERT(!memcmp(iv, iv_ref, 16));
+	}
+}
+
+static void aes_alt_test_ctr(void)
+{
+	mbedtls_aes_context ctx;
+	uint8_t key[32], nonce[16], nonce_ref[16], stream[16], *out;
+	uint32_t seed = 4;
+	size_t len, off, n, nc_off;
+	int i, keybits;
+
+	for (i = 0; i < 300; i++) {
+		keybits = 128 + 64 * (i % 3);
+		len = rand_len(&seed, 1) + test_rand(&seed) % 16;
+		len = len < BUF_MAX ? len : BUF_MAX;
+		fill(key, sizeof(key), &seed);
+		fill(nonce, sizeof(nonce), &seed);
+		/* a carry through all 128 bits within the job */
+		if (i % 5 == 0)
+			memset(nonce, 0xff, 16);
+		fill(src, len, &seed);
+		memcpy(nonce_ref, nonce, 16);
+		ce_sim_ref_ctr(key, keybits, len, nonce_ref, src, ref);
+
+		mbedtls_aes_init(&ctx);
+		TEST_ASSERT_EQ(mbedtls_aes_setkey_enc(&ctx, key, keybits), 0);
+		out = rand_out(&seed);
+		nc_off = 0;
+		for (off = 0; off < len; off += n) {
+			n = test_rand(&seed) % 2 ? len - off : 1 + test_rand(&seed) % 300;
+			n = n < len - off ? n : len - off;
+			TEST_ASSERT_EQ(mbedtls_aes_crypt_ctr(&ctx, n, &nc_off, nonce, stream,
+			                                     src + off, out + off), 0);
+		}
+		mbedtls_aes_free(&ctx);
+
+		TEST_ASSERT(!memcmp(out, ref, len));
+		TEST_ASSERT(!memcmp(nonce, nonce_ref, 16));
+	}
+
+	/* output overlapping the input one block behind, as in a record shift */
+	fill(key, sizeof(key), &seed);
+	fill(nonce, sizeof(nonce), &seed);
+	fill(src + 16, 8192, &seed);
+	memcpy(nonce_ref, nonce, 16);
+	ce_sim_ref_ctr(key, 256, 8192, nonce_ref, src + 16, ref);
+	mbedtls_aes_init(&ctx);
+	TEST_ASSERT_EQ(mbedtls_aes_setkey_enc(&ctx, key, 256), 0);
+	nc_off = 0;
+	TEST_ASSERT_EQ(mbedtls_aes_crypt_ctr(&ctx, 8192, &nc_off, nonce, stream,
+	                                     src + 16, src), 0);
+	mbedtls_aes_free(&ctx);
+	TEST_ASSERT(!memcmp(src, ref, 8192));
+}
+
+/* engine runs taken by one job of @len bytes */
+static unsigned long ctr_jobs(size_t len, int in_place)
+{
+	mbedtls_aes_context ctx;
+	uint8_t key[16] = { 0 }, nonce[16] = { 0 }, stream[16];
+	size_t nc_off = 0;
+
+	mbedtls_aes_init(&ctx);
+	TEST_ASSERT_EQ(mbedtls_aes_setkey_enc(&ctx, key, 128), 0);
+	ce_sim_jobs = 0;
+	TEST_ASSERT_EQ(mbedtls_aes_crypt_ctr(&ctx, len, &nc_off, nonce, stream,
+	                                     src, in_place ? src : dst), 0);
+	mbedtls_aes_free(&ctx);
+	return ce_sim_jobs;
+}
+
+static unsigned long cbc_jobs(size_t len, int mode)
+{
+	mbedtls_aes_context ctx;
+	uint8_t key[16] = { 0 }, iv[16] = { 0 };
+
+	mbedtls_aes_init(&ctx);
+	if (mode == MBEDTLS_AES_ENCRYPT)
+		TEST_ASSERT_EQ(mbedtls_aes_setkey_enc(&ctx, key, 128), 0);
+	else
+		TEST_ASSERT_EQ(mbedtls_aes_setkey_dec(&ctx, key, 128), 0);
+	ce_sim_jobs = 0;
+	TEST_ASSERT_EQ(mbedtls_aes_crypt_cbc(&ctx, mode, len, iv, src, dst), 0);
+	mbedtls_aes_free(&ctx);
+	return ce_sim_jobs;
+}
+
+static void aes_alt_test_jobs(void)
+{
+	/* up to MBEDTLS_AES_ALT_SW_MAX_LEN in software, decryption excepted */
+	TEST_ASSERT_EQ(cbc_jobs(32, MBEDTLS_AES_ENCRYPT), 0);
+	TEST_ASSERT_EQ(cbc_jobs(32, MBEDTLS_AES_DECRYPT), 1);
+	TEST_ASSERT_EQ(cbc_jobs(48, MBEDTLS_AES_ENCRYPT), 1);
+	TEST_ASSERT_EQ(cbc_jobs(DMA_DATA_MAX_LEN + 16, MBEDTLS_AES_ENCRYPT), 2);
+	TEST_ASSERT_EQ(ctr_jobs(16, 0), 0);
+	TEST_ASSERT_EQ(ctr_jobs(16384, 0), 1);
+	TEST_ASSERT(ctr_jobs(16384, 1) <= 4);
+}
+
+static void aes_alt_bench(void)
+{
+	static const size_t lens[] = { 64, 1024, 4096, 16384 };
+	int i;
+
+	printf("\nengine runs per AES-CTR job\n");
+	printf("  bytes   separate  in place  one per block\n");
+	for (i = 0; i < (int)(sizeof(lens) / sizeof(lens[0])); i++)
+		printf("  %5zu   %8lu  %8lu  %13zu\n", lens[i], ctr_jobs(lens[i], 0),
+		       ctr_jobs(lens[i], 1), lens[i] / 16);
+}
+
+void aes_alt_test(void)
+{
+	src = malloc(BUF_MAX + 16);
+	dst = malloc(BUF_MAX);
+	ref = malloc(BUF_MAX);
+	TEST_ASSERT(src != NULL && dst != NULL && ref != NULL);
+
+	TEST_RUN(aes_alt_test_self);
+	TEST_RUN(aes_alt_test_setkey);
+	TEST_RUN(aes_alt_test_ecb);
+	TEST_RUN(aes_alt_test_cbc);
+	TEST_RUN(aes_alt_test_ctr);
+	TEST_RUN(aes_alt_test_jobs);
+	aes_alt_bench();
+
+	free(src);
+	free(dst);
+	free(ref);
+}
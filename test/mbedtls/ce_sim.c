@@ -0,0 +1,117 @@
+/*
+ * Simulated crypto engine: HAL_AES_Encrypt()/HAL_AES_Decrypt() in ECB and
+ * CBC mode on top of the stock software AES of aes.c, built here a second
+ * time without MBEDTLS_AES_ALT and with its symbols renamed. Every run is
+ * counted and checked against the engine limits (whole blocks, one DMA
+ * transfer at most).
+ */
+
+#include MBEDTLS_CONFIG_FILE
+
+#undef MBEDTLS_AES_ALT
+#undef MBEDTLS_SELF_TEST
+
+#define mbedtls_aes_init		ref_aes_init
+#define mbedtls_aes_free		ref_aes_free
+#define mbedtls_aes_xts_init		ref_aes_xts_init
+#define mbedtls_aes_xts_free		ref_aes_xts_free
+#define mbedtls_aes_setkey_enc		ref_aes_setkey_enc
+#define mbedtls_aes_setkey_dec		ref_aes_setkey_dec
+#define mbedtls_aes_xts_setkey_enc	ref_aes_xts_setkey_enc
+#define mbedtls_aes_xts_setkey_dec	ref_aes_xts_setkey_dec
+#define mbedtls_internal_aes_encrypt	ref_internal_aes_encrypt
+#define mbedtls_internal_aes_decrypt	ref_internal_aes_decrypt
+#define mbedtls_aes_encrypt		ref_aes_encrypt
+#define mbedtls_aes_decrypt		ref_aes_decrypt
+#define mbedtls_aes_crypt_ecb		ref_aes_crypt_ecb
+#define mbedtls_aes_crypt_cbc		ref_aes_crypt_cbc
+#define mbedtls_aes_crypt_xts		ref_aes_crypt_xts
+#define mbedtls_aes_crypt_cfb128	ref_aes_crypt_cfb128
+#define mbedtls_aes_crypt_cfb8		ref_aes_crypt_cfb8
+#define mbedtls_aes_crypt_ofb		ref_aes_crypt_ofb
+#define mbedtls_aes_crypt_ctr		ref_aes_crypt_ctr
+
+#include "../../src/net/mbedtls-2.16.0/library/aes.c"
+
+#include "driver/chip/hal_crypto.h"
+#include "driver/chip/hal_dma.h"
+#include "test.h"
+#include "ce_sim.h"
+
+unsigned long ce_sim_jobs;
+unsigned long ce_sim_bytes;
+
+static void ref_setkey(mbedtls_aes_context *ctx, const uint8_t *key, int keybits, int mode)
+{
+	mbedtls_aes_init(ctx);
+	if (mode == MBEDTLS_AES_ENCRYPT)
+		TEST_ASSERT_EQ(mbedtls_aes_setkey_enc(ctx, key, keybits), 0);
+	else
+		TEST_ASSERT_EQ(mbedtls_aes_setkey_dec(ctx, key, keybits), 0);
+}
+
+static HAL_Status ce_sim_run(CE_AES_Config *aes, int mode, const uint8_t *in,
+                             uint8_t *out, uint32_t size)
+{
+	mbedtls_aes_context ctx;
+	int keybits = 128 + 64 * (aes->keysize >> CE_CTL_AES_KEY_SIZE_SHIFT);
+
+	TEST_ASSERT(size > 0 && size % 16 == 0 && size <= DMA_DATA_MAX_LEN);
+	TEST_ASSERT_EQ(aes->src, CE_CTL_KEYSOURCE_INPUT);
+	ce_sim_jobs++;
+	ce_sim_bytes += size;
+
+	ref_setkey(&ctx, aes->key, keybits, mode);
+	if ((int)aes->mode == (int)CE_CTL_CRYPT_MODE_ECB) {
+		for (; size > 0; size -= 16, in += 16, out += 16)
+			mbedtls_aes_crypt_ecb(&ctx, mode, in, out);
+	} else {
+		TEST_ASSERT_EQ((int)aes->mode, (int)CE_CTL_CRYPT_MODE_CBC);
+		/* the engine leaves the chaining value in the IV */
+		mbedtls_aes_crypt_cbc(&ctx, mode, size, aes->iv, in, out);
+	}
+	mbedtls_aes_free(&ctx);
+	return HAL_OK;
+}
+
+HAL_Status HAL_AES_Encrypt(CE_AES_Config *aes, uint8_t *plain, uint8_t *cipher, uint32_t size)
+{
+	return ce_sim_run(aes, MBEDTLS_AES_ENCRYPT, plain, cipher, size);
+}
+
+HAL_Status HAL_AES_Decrypt(CE_AES_Config *aes, uint8_t *cipher, uint8_t *plain, uint32_t size)
+{
+	return ce_sim_run(aes, MBEDTLS_AES_DECRYPT, cipher, plain, size);
+}
+
+void ce_sim_ref_ecb(const uint8_t *key, int keybits, int mode,
+                    const uint8_t in[16], uint8_t out[16])
+{
+	mbedtls_aes_context ctx;
+
+	ref_setkey(&ctx, key, keybits, mode);
+	mbedtls_aes_crypt_ecb(&ctx, mode, in, out);
+	mbedtls_aes_free(&ctx);
+}
+
+void ce_sim_ref_cbc(const uint8_t *key, int keybits, int mode, size_t len,
+                    uint8_t iv[16], const uint8_t *in, uint8_t *out)
+{
+	mbedtls_aes_context ctx;
+
+	ref_setkey(&ctx, key, keybits, mode);
+	TEST_ASSERT_EQ(mbedtls_aes_crypt_cbc(&ctx, mode, len, iv, in, out), 0);
+	mbedtls_aes_free(&ctx);
+}
+
+void ce_sim_ref_ctr(const uint8_t *key, int keybits, size_t len,
+                    uint8_t nonce[16], const uint8_t *in, uint8_t *out)
+{
+	mbedtls_aes_context ctx;
+	uint8_t stream[16];
+	size_t nc_off = 0;
+
+	ref_setkey(&ctx, key, keybits, MBEDTLS_AES_ENCRYPT);
+	TEST_ASSERT_EQ(mbedtls_aes_crypt_ctr(&ctx, len, &nc_off, nonce, stream, in, out), 0);
+	mbedtls_aes_free(&ctx);
+}
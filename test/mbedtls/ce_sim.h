@@ -0,0 +1,19 @@
+#ifndef _CE_SIM_H_
+#define _CE_SIM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* engine runs and bytes since the last reset */
+extern unsigned long ce_sim_jobs;
+extern unsigned long ce_sim_bytes;
+
+/* stock software AES, for reference */
+void ce_sim_ref_ecb(const uint8_t *key, int keybits, int mode,
+                    const uint8_t in[16], uint8_t out[16]);
+void ce_sim_ref_cbc(const uint8_t *key, int keybits, int mode, size_t len,
+                    uint8_t iv[16], const uint8_t *in, uint8_t *out);
+void ce_sim_ref_ctr(const uint8_t *key, int keybits, size_t len,
+                    uint8_t nonce[16], const uint8_t *in, uint8_t *out);
+
+#endif /* _CE_SIM_H_ */
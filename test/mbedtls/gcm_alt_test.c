@@ -0,0 +1,249 @@
+/*
+ * GCM ALT on the simulated engine: the gcm.c self test (the GCM spec test
+ * cases) passes, and random messages match a reference built from single
+ * block encryptions and a bitwise GF(2^128) GHASH, for every key size, IV
+ * length, AAD length and update split, in place or not. A tampered tag is
+ * rejected. A 16 KB record takes one engine run.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include MBEDTLS_CONFIG_FILE
+#include "mbedtls/gcm.h"
+#include "test.h"
+#include "ce_sim.h"
+#include "mbedtls_test.h"
+
+#define MSG_MAX		(140 * 1024)
+
+static uint8_t *src, *dst, *ref;
+
+static void fill(uint8_t *buf, size_t len, uint32_t *seed)
+{
+	while (len--)
+		*buf++ = test_rand(seed);
+}
+
+/* x = x * h in GF(2^128), bit by bit as in SP 800-38D 6.3 */
+static void gf_mul(uint8_t x[16], const uint8_t h[16])
+{
+	uint8_t z[16] = { 0 }, v[16];
+	int i, j, lsb;
+
+	memcpy(v, h, 16);
+	for (i = 0; i < 128; i++) {
+		if (x[i / 8] & (0x80 >> (i % 8)))
+			for (j = 0; j < 16; j++)
+				z[j] ^= v[j];
+		lsb = v[15] & 1;
+		for (j = 15; j > 0; j--)
+			v[j] = (v[j] >> 1) | (v[j - 1] << 7);
+		v[0] >>= 1;
+		if (lsb)
+			v[0] ^= 0xe1;
+	}
+	memcpy(x, z, 16);
+}
+
+static void ghash(uint8_t y[16], const uint8_t h[16], const uint8_t *data, size_t len)
+{
+	size_t i, n;
+
+	for (; len > 0; data += n, len -= n) {
+		n = len < 16 ? len : 16;
+		for (i = 0; i < n; i++)
+			y[i] ^= data[i];
+		gf_mul(y, h);
+	}
+}
+
+static void ghash_lens(uint8_t y[16], const uint8_t h[16], uint64_t a_len, uint64_t c_len)
+{
+	uint8_t block[16];
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		block[i] = (a_len * 8) >> (56 - 8 * i);
+		block[8 + i] = (c_len * 8) >> (56 - 8 * i);
+	}
+	ghash(y, h, block, 16);
+}
+
+static void inc32(uint8_t cb[16])
+{
+	int i;
+
+	for (i = 15; i >= 12; i--)
+		if (++cb[i] != 0)
+			break;
+}
+
+static void ref_gcm(const uint8_t *key, int keybits, const uint8_t *iv, size_t iv_len,
+                    const uint8_t *aad, size_t aad_len, const uint8_t *in, size_t len,
+                    uint8_t *out, uint8_t tag[16])
+{
+	uint8_t h[16] = { 0 }, j0[16] = { 0 }, cb[16], ks[16], s[16] = { 0 };
+	size_t i, j;
+
+	ce_sim_ref_ecb(key, keybits, MBEDTLS_AES_ENCRYPT, h, h);
+	if (iv_len == 12) {
+		memcpy(j0, iv, 12);
+		j0[15] = 1;
+	} else {
+		ghash(j0, h, iv, iv_len);
+		ghash_lens(j0, h, 0, iv_len);
+	}
+
+	memcpy(cb, j0, 16);
+	for (i = 0; i < len; i += 16) {
+		inc32(cb);
+		ce_sim_ref_ecb(key, keybits, MBEDTLS_AES_ENCRYPT, cb, ks);
+		for (j = 0; j < 16 && i + j < len; j++)
+			out[i + j] = in[i + j] ^ ks[j];
+	}
+
+	ghash(s, h, aad, aad_len);
+	ghash(s, h, out, len);
+	ghash_lens(s, h, aad_len, len);
+	ce_sim_ref_ecb(key, keybits, MBEDTLS_AES_ENCRYPT, j0, ks);
+	for (i = 0; i < 16; i++)
+		tag[i] = s[i] ^ ks[i];
+}
+
+static void gcm_alt_test_self(void)
+{
+	TEST_ASSERT_EQ(mbedtls_gcm_self_test(0), 0);
+}
+
+static void gcm_alt_test_random(void)
+{
+	static const size_t iv_lens[] = { 12, 12, 1, 8, 16, 20, 32 };
+	mbedtls_gcm_context ctx;
+	uint8_t key[32], iv[32], aad[40], tag[16], tag_ref[16], *out;
+	uint32_t seed = 6;
+	size_t len, aad_len, iv_len, off, n;
+	int i, keybits;
+
+	for (i = 0; i < 400; i++) {
+		keybits = 128 + 64 * (i % 3);
+		iv_len = iv_lens[test_rand(&seed) % 7];
+		aad_len = test_rand(&seed) % sizeof(aad);
+		if (i % 50 == 0)
+			len = MSG_MAX - test_rand(&seed) % 64;
+		else
+			len = test_rand(&seed) % 5000;
+		fill(key, sizeof(key), &seed);
+		fill(iv, iv_len, &seed);
+		fill(aad, aad_len, &seed);
+		fill(src, len, &seed);
+		ref_gcm(key, keybits, iv, iv_len, aad, aad_len, src, len, ref, tag_ref);
+
+		/* streamed in multiples of 16 bytes, the last piece excepted */
+		mbedtls_gcm_init(&ctx);
+		TEST_ASSERT_EQ(mbedtls_gcm_setkey(&ctx, MBEDTLS_CIPHER_ID_AES, key, keybits), 0);
+		TEST_ASSERT_EQ(mbedtls_gcm_starts(&ctx, MBEDTLS_GCM_ENCRYPT, iv, iv_len,
+		                                  aad, aad_len), 0);
+		out = test_rand(&seed) % 2 ? src : dst;
+		for (off = 0; off < len; off += n) {
+			n = test_rand(&seed) % 2 ? len - off : 16 * (test_rand(&seed) % 40);
+			n = n < len - off ? n : len - off;
+			TEST_ASSERT_EQ(mbedtls_gcm_update(&ctx, n, src + off, out + off), 0);
+		}
+		TEST_ASSERT_EQ(mbedtls_gcm_finish(&ctx, tag, 16), 0);
+		TEST_ASSERT(!memcmp(out, ref, len));
+		TEST_ASSERT(!memcmp(tag, tag_ref, 16));
+
+		/* and back, in one call */
+		TEST_ASSERT_EQ(mbedtls_gcm_auth_decrypt(&ctx, len, iv, iv_len, aad, aad_len,
+		                                        tag, 16, out, dst), 0);
+		tag[i % 16] ^= 1 << (i % 8);
+		TEST_ASSERT_EQ(mbedtls_gcm_auth_decrypt(&ctx, len, iv, iv_len, aad, aad_len,
+		                                        tag, 16, out, dst),
+		               MBEDTLS_ERR_GCM_AUTH_FAILED);
+		mbedtls_gcm_free(&ctx);
+	}
+}
+
+/* inc32 wraps inside the record, the upper 96 bits stay */
+static void gcm_alt_test_inc32_wrap(void)
+{
+	mbedtls_gcm_context ctx;
+	uint8_t key[16], iv[16], tag[16], tag_ref[16];
+	uint32_t seed = 7;
+	size_t len = 4096;
+
+	/* pick a 16-byte IV whose J0 ends near 0xffffffff */
+	fill(key, sizeof(key), &seed);
+	fill(src, len, &seed);
+	for (;;) {
+		uint8_t h[16] = { 0 }, j0[16] = { 0 };
+
+		fill(iv, sizeof(iv), &seed);
+		ce_sim_ref_ecb(key, 128, MBEDTLS_AES_ENCRYPT, h, h);
+		ghash(j0, h, iv, sizeof(iv));
+		ghash_lens(j0, h, 0, sizeof(iv));
+		if (j0[12] == 0xff && j0[13] == 0xff)
+			break;
+	}
+	ref_gcm(key, 128, iv, sizeof(iv), NULL, 0, src, len, ref, tag_ref);
+
+	mbedtls_gcm_init(&ctx);
+	TEST_ASSERT_EQ(mbedtls_gcm_setkey(&ctx, MBEDTLS_CIPHER_ID_AES, key, 128), 0);
+	TEST_ASSERT_EQ(mbedtls_gcm_crypt_and_tag(&ctx, MBEDTLS_GCM_ENCRYPT, len, iv, sizeof(iv),
+	                                         NULL, 0, src, dst, 16, tag), 0);
+	mbedtls_gcm_free(&ctx);
+	TEST_ASSERT(!memcmp(dst, ref, len));
+	TEST_ASSERT(!memcmp(tag, tag_ref, 16));
+}
+
+static unsigned long gcm_jobs(size_t len, int in_place)
+{
+	mbedtls_gcm_context ctx;
+	uint8_t key[16] = { 0 }, iv[12] = { 0 }, tag[16];
+
+	mbedtls_gcm_init(&ctx);
+	TEST_ASSERT_EQ(mbedtls_gcm_setkey(&ctx, MBEDTLS_CIPHER_ID_AES, key, 128), 0);
+	ce_sim_jobs = 0;
+	TEST_ASSERT_EQ(mbedtls_gcm_crypt_and_tag(&ctx, MBEDTLS_GCM_ENCRYPT, len, iv, sizeof(iv),
+	                                         NULL, 0, src, in_place ? src : dst,
+	                                         16, tag), 0);
+	mbedtls_gcm_free(&ctx);
+	return ce_sim_jobs;
+}
+
+static void gcm_alt_test_jobs(void)
+{
+	TEST_ASSERT_EQ(gcm_jobs(16384, 0), 1);
+	TEST_ASSERT(gcm_jobs(16384, 1) <= 4);
+}
+
+static void gcm_alt_bench(void)
+{
+	static const size_t lens[] = { 64, 1024, 4096, 16384 };
+	int i;
+
+	printf("\nengine runs per GCM record\n");
+	printf("  bytes   separate  in place  one per block\n");
+	for (i = 0; i < (int)(sizeof(lens) / sizeof(lens[0])); i++)
+		printf("  %5zu   %8lu  %8lu  %13zu\n", lens[i], gcm_jobs(lens[i], 0),
+		       gcm_jobs(lens[i], 1), lens[i] / 16);
+}
+
+void gcm_alt_test(void)
+{
+	src = malloc(MSG_MAX);
+	dst = malloc(MSG_MAX);
+	ref = malloc(MSG_MAX);
+	TEST_ASSERT(src != NULL && dst != NULL && ref != NULL);
+
+	TEST_RUN(gcm_alt_test_self);
+	TEST_RUN(gcm_alt_test_random);
+	TEST_RUN(gcm_alt_test_inc32_wrap);
+	TEST_RUN(gcm_alt_test_jobs);
+	gcm_alt_bench();
+
+	free(src);
+	free(dst);
+	free(ref);
+}
@@ -0,0 +1,9 @@
+#include "test.h"
+#include "mbedtls_test.h"
+
+int main(int argc, char **argv)
+{
+	aes_alt_test();
+	gcm_alt_test();
+	return 0;
+}
@@ -0,0 +1,7 @@
+#ifndef _MBEDTLS_TEST_H_
+#define _MBEDTLS_TEST_H_
+
+void aes_alt_test(void);
+void gcm_alt_test(void);
+
+#endif /* _MBEDTLS_TEST_H_ */
@@ -0,0 +1,207 @@
+#include <string.h>
+#include <pthread.h>
+
+#include "test.h"
+#include "kernel/os/os.h"
+#include "driver/chip/sdmmc/sdmmc.h"
+#include "_sdhost.h"
+#include "_core.h"
+#include "card_sim.h"
+
+struct card_sim card_sim;
+uint8_t card_sim_disk[CARD_SIM_BLOCKS * 512];
+
+static struct mmc_host sim_host;
+static pthread_mutex_t sim_claim = PTHREAD_MUTEX_INITIALIZER;
+static int sim_claimed;
+static uint64_t sim_busy_until;
+static uint32_t sim_sbc;	/* CMD23 argument waiting for its command */
+static uint32_t sim_pre_erase;	/* ACMD23 argument */
+static int sim_app;		/* CMD55 seen */
+
+static void sim_violation(const char *what, uint32_t a, uint32_t b)
+{
+	if (card_sim.violations++ < 8)
+		printf("\ncard: %s (%u, %u)\n", what, a, b);
+}
+
+static int sim_busy(void)
+{
+	return card_sim_now_us() < sim_busy_until;
+}
+
+uint64_t card_sim_now_us(void)
+{
+	return test_now_ns() / 1000;
+}
+
+void card_sim_init(struct mmc_card *card, int sbc)
+{
+	memset(&card_sim, 0, sizeof(card_sim));
+	memset(card, 0, sizeof(*card));
+	card->host = &sim_host;
+	card->type = MMC_TYPE_SD;
+	card->state = MMC_STATE_BLOCKADDR;
+	card->scr.cmds = sbc ? SD_SCR_CMD23_SUPPORT : 0;
+	sim_busy_until = 0;
+	sim_sbc = 0;
+	sim_pre_erase = 0;
+	sim_app = 0;
+}
+
+void card_sim_hold(void)
+{
+	pthread_mutex_lock(&sim_claim);
+}
+
+void card_sim_release(void)
+{
+	pthread_mutex_unlock(&sim_claim);
+}
+
+/* HAL and ROM core calls used by mmc_queue.c */
+
+uint64_t HAL_RTC_GetFreeRunTime(void)
+{
+	return card_sim_now_us();
+}
+
+void HAL_UDelay(uint32_t us)
+{
+	uint64_t end = card_sim_now_us() + us;
+
+	while (card_sim_now_us() < end)
+		;
+}
+
+int32_t HAL_SDC_Claim_Host(struct mmc_host *host)
+{
+	pthread_mutex_lock(&sim_claim);
+	sim_claimed = 1;
+	return 0;
+}
+
+void HAL_SDC_Release_Host(struct mmc_host *host)
+{
+	/* another user of the host would find the card busy */
+	if (sim_busy())
+		sim_violation("released while busy", 0, 0);
+	sim_claimed = 0;
+	pthread_mutex_unlock(&sim_claim);
+}
+
+uint32_t HAL_SDC_Is_Busy(struct mmc_host *host)
+{
+	return sim_busy();
+}
+
+int mmc_set_blocklen(struct mmc_card *card, unsigned int blocklen)
+{
+	if (blocklen != 512)
+		sim_violation("block length", blocklen, 0);
+	return 0;
+}
+
+int32_t mmc_app_cmd(struct mmc_host *host, struct mmc_card *card)
+{
+	if (sim_busy())
+		sim_violation("CMD55 while busy", 0, 0);
+	sim_app = 1;
+	return 0;
+}
+
+int32_t mmc_wait_for_cmd(struct mmc_host *host, struct mmc_command *cmd)
+{
+	if (!sim_claimed)
+		sim_violation("command without the host", cmd->opcode, 0);
+	if (sim_busy())
+		sim_violation("command while busy", cmd->opcode, 0);
+
+	if (cmd->opcode == MMC_SET_BLOCK_COUNT && sim_app) {
+		sim_pre_erase = cmd->arg;
+		card_sim.acmd23++;
+	} else if (cmd->opcode == MMC_SET_BLOCK_COUNT) {
+		sim_sbc = cmd->arg;
+		card_sim.sbc++;
+	} else {
+		sim_violation("unexpected command", cmd->opcode, 0);
+	}
+	sim_app = 0;
+	return 0;
+}
+
+int32_t mmc_send_status(struct mmc_card *card, uint32_t *status)
+{
+	if (sim_busy())
+		*status = R1_STATE_PRG << 9;
+	else
+		*status = R1_READY_FOR_DATA | (R1_STATE_TRAN << 9);
+	return 0;
+}
+
+int32_t mmc_wait_for_req(struct mmc_host *host, struct mmc_request *mrq)
+{
+	struct mmc_command *cmd = mrq->cmd;
+	struct mmc_data *data = mrq->data;
+	uint32_t i, len = 0, desc = 0, off;
+	int multi, write;
+
+	if (!sim_claimed)
+		sim_violation("request without the host", cmd->opcode, 0);
+	if (sim_busy())
+		sim_violation("request while busy", cmd->opcode, 0);
+
+	for (i = 0; i < data->sg_len; i++) {
+		len += data->sg[i].len;
+		desc += (data->sg[i].len + SDXC_DES_BUFFER_MAX_LEN - 1) >>
+			SDXC_DES_NUM_SHIFT;
+	}
+	if (len != data->blocks * 512 || len > SDXC_MAX_TRANS_LEN)
+		sim_violation("transfer length", len, data->blocks);
+	if (desc > SDXC_MAX_DES_NUM)
+		sim_violation("descriptors", desc, data->sg_len);
+
+	write = (data->flags & MMC_DATA_WRITE) != 0;
+	multi = cmd->opcode == MMC_READ_MULTIPLE_BLOCK ||
+		cmd->opcode == MMC_WRITE_MULTIPLE_BLOCK;
+	if (multi != (data->blocks > 1))
+		sim_violation("single/multiple block", cmd->opcode, data->blocks);
+	if (write != (cmd->opcode == MMC_WRITE_SINGLE_BLOCK ||
+		      cmd->opcode == MMC_WRITE_MULTIPLE_BLOCK))
+		sim_violation("direction", cmd->opcode, data->flags);
+
+	/* the block count comes with CMD23, or the command ends with CMD12 */
+	if (multi && sim_sbc && (sim_sbc != data->blocks || cmd->stop))
+		sim_violation("CMD23 count", sim_sbc, data->blocks);
+	if (multi && !sim_sbc && !cmd->stop)
+		sim_violation("no stop", cmd->opcode, data->blocks);
+	if (!multi && sim_sbc)
+		sim_violation("CMD23 before a single block", sim_sbc, 0);
+	if (sim_pre_erase && (!write || !multi || sim_pre_erase != data->blocks))
+		sim_violation("ACMD23 count", sim_pre_erase, data->blocks);
+	sim_sbc = 0;
+	sim_pre_erase = 0;
+
+	if (cmd->arg + data->blocks > CARD_SIM_BLOCKS) {
+		sim_violation("out of range", cmd->arg, data->blocks);
+		return -1;
+	}
+	card_sim.cmd++;
+	if (data->blocks > card_sim.max_blocks)
+		card_sim.max_blocks = data->blocks;
+	if (card_sim.fail_blk && card_sim.fail_blk >= cmd->arg &&
+	    card_sim.fail_blk < cmd->arg + data->blocks)
+		return -1;
+
+	off = cmd->arg * 512;
+	for (i = 0; i < data->sg_len; i++) {
+		if (write)
+			memcpy(card_sim_disk + off, data->sg[i].buffer, data->sg[i].len);
+		else
+			memcpy(data->sg[i].buffer, card_sim_disk + off, data->sg[i].len);
+		off += data->sg[i].len;
+	}
+	if (write)
+		sim_busy_until = card_sim_now_us() + card_sim.busy_us;
+	return 0;
+}
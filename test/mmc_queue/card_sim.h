@@ -0,0 +1,39 @@
+/*
+ * Simulated SD card behind the ROM core calls mmc_queue.c uses. It checks
+ * the command sequence the way a card would, and counts any violation
+ * instead of failing, so that a test can assert there were none.
+ */
+
+#ifndef _CARD_SIM_H_
+#define _CARD_SIM_H_
+
+#include <stdint.h>
+#include "driver/chip/sdmmc/card.h"
+
+#define CARD_SIM_BLOCKS		8192
+
+struct card_sim {
+	uint32_t busy_us;	/* programming time after each write */
+	uint32_t fail_blk;	/* data commands covering it fail, 0 if none */
+
+	/* seen on the bus */
+	uint32_t cmd;		/* data commands */
+	uint32_t sbc;		/* CMD23 */
+	uint32_t acmd23;	/* ACMD23 */
+	uint32_t max_blocks;	/* longest data command */
+	uint32_t violations;
+};
+
+extern struct card_sim card_sim;
+extern uint8_t card_sim_disk[CARD_SIM_BLOCKS * 512];
+
+/* @sbc: the card supports CMD23 */
+void card_sim_init(struct mmc_card *card, int sbc);
+
+/* keep the worker off the bus, as another user of the host would */
+void card_sim_hold(void);
+void card_sim_release(void);
+
+uint64_t card_sim_now_us(void);
+
+#endif /* _CARD_SIM_H_ */
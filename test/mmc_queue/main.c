@@ -0,0 +1,9 @@
+#include "test.h"
+#include "mmc_queue_test.h"
+
+int main(int argc, char **argv)
+{
+	mmc_queue_test();
+	mmc_queue_bench();
+	return 0;
+}
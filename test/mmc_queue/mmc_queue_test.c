@@ -0,0 +1,427 @@
+/*
+ * SD block request queue against a simulated card.
+ *
+ * The card checks every command the way the real one would: the host is
+ * claimed, nothing is sent while it programs a write, the CMD23/ACMD23
+ * counts match the data command, the scatter list fits the IDMA descriptor
+ * chain. On top of that the tests check the data read back, how requests
+ * are merged and split, and which requests and barriers see an error.
+ *
+ * The benchmark writes a recorder-like stream of small writes through the
+ * queue and one synchronous write at a time, with the card busy for a
+ * fixed time after each write.
+ */
+
+#include <stdarg.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "test.h"
+#include "kernel/os/os.h"
+#include "driver/chip/sdmmc/sdmmc.h"
+#include "driver/chip/sdmmc/mmc_queue.h"
+#include "_sdhost.h"
+#include "card_sim.h"
+#include "mmc_queue_test.h"
+
+#define MQ_BUSY_US	800
+
+/* the queue logs every failed command, the ones made to fail are kept quiet */
+static int quiet;
+
+int printf(const char *fmt, ...)
+{
+	va_list ap;
+	int ret;
+
+	if (quiet)
+		return 0;
+	va_start(ap, fmt);
+	ret = vprintf(fmt, ap);
+	va_end(ap);
+	return ret;
+}
+
+static struct mmc_card mq_card;
+static uint8_t mq_src[CARD_SIM_BLOCKS * 512];
+static uint8_t mq_chk[CARD_SIM_BLOCKS * 512];
+
+static pthread_mutex_t mq_done_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t mq_seq;		/* completions so far */
+
+/* req->arg points to one of these */
+struct mq_done {
+	uint32_t calls;
+	uint32_t seq;		/* completion order */
+	int32_t err;
+};
+
+static void mq_done(struct mmc_queue_req *req, int32_t err)
+{
+	struct mq_done *d = req->arg;
+
+	pthread_mutex_lock(&mq_done_lock);
+	d->calls++;
+	d->seq = mq_seq++;
+	d->err = err;
+	pthread_mutex_unlock(&mq_done_lock);
+}
+
+static struct mmc_queue *mq_open(int sbc, uint32_t flags)
+{
+	struct mmc_queue *q;
+	uint32_t seed = 1, i;
+
+	card_sim_init(&mq_card, sbc);
+	card_sim.busy_us = MQ_BUSY_US;
+	for (i = 0; i < sizeof(mq_src); i++)
+		mq_src[i] = test_rand(&seed);
+	memset(card_sim_disk, 0, sizeof(card_sim_disk));
+	mq_seq = 0;
+
+	q = mmc_queue_create(&mq_card, flags, OS_PRIORITY_NORMAL);
+	TEST_ASSERT(q != NULL);
+	return q;
+}
+
+static void mq_close(struct mmc_queue *q)
+{
+	mmc_queue_destroy(q);
+	TEST_ASSERT_EQ(card_sim.violations, 0);
+}
+
+/* a write of @nblk from mq_src, cut in @seg_cnt segments */
+static void mq_req_init(struct mmc_queue_req *req, struct mmc_queue_seg *seg,
+			struct mq_done *d, uint32_t sblk, uint32_t nblk,
+			int write, int seg_cnt)
+{
+	uint8_t *buf = write ? mq_src : mq_chk;
+	uint32_t left = nblk, b = sblk, n;
+	int i;
+
+	memset(req, 0, sizeof(*req));
+	memset(d, 0, sizeof(*d));
+	req->sblk = sblk;
+	req->nblk = nblk;
+	req->write = write;
+	req->seg_cnt = seg_cnt;
+	req->seg = seg;
+	req->done = mq_done;
+	req->arg = d;
+	for (i = 0; i < seg_cnt; i++) {
+		n = (i == seg_cnt - 1) ? left : 1;
+		seg[i].buf = buf + b * 512;
+		seg[i].len = n * 512;
+		b += n;
+		left -= n;
+	}
+}
+
+static void mq_test_seq_writes(void)
+{
+	enum { N = 400 };
+	static struct mmc_queue_req req[N];
+	static struct mmc_queue_seg seg[N][4];
+	static struct mq_done d[N];
+	struct mmc_queue_stats st;
+	struct mmc_queue *q;
+	uint32_t seed = 7, blk = 0, nblk, sbc_cmds = 0;
+	int i, ns;
+
+	q = mq_open(1, MMC_QUEUE_F_DEFAULT);
+	for (i = 0; i < N; i++) {
+		nblk = 1 + test_rand(&seed) % 12;
+		ns = 1 + test_rand(&seed) % (nblk < 4 ? nblk : 4);
+		mq_req_init(&req[i], seg[i], &d[i], blk, nblk, 1, ns);
+		TEST_ASSERT(mmc_queue_submit(q, &req[i]) == 0);
+		blk += nblk;
+		if (i % 50 == 0)
+			OS_MSleep(1);
+	}
+	TEST_ASSERT(mmc_queue_flush(q) == 0);
+
+	for (i = 0; i < N; i++) {
+		TEST_ASSERT_EQ(d[i].calls, 1);
+		TEST_ASSERT_EQ(d[i].err, 0);
+		TEST_ASSERT_EQ(d[i].seq, i);
+	}
+	TEST_ASSERT(memcmp(card_sim_disk, mq_src, blk * 512) == 0);
+
+	mmc_queue_get_stats(q, &st);
+	TEST_ASSERT_EQ(st.req, N);
+	TEST_ASSERT_EQ(st.blocks, blk);
+	TEST_ASSERT_EQ(st.cmd, card_sim.cmd);
+	TEST_ASSERT_EQ(st.merged + st.cmd, N);
+	/* the requests pile up while the card programs */
+	TEST_ASSERT(st.cmd < N / 4);
+	TEST_ASSERT(st.busy_max >= MQ_BUSY_US);
+	sbc_cmds = card_sim.sbc;
+	TEST_ASSERT_EQ(st.sbc, sbc_cmds);
+	TEST_ASSERT_EQ(card_sim.acmd23, 0);
+	mq_close(q);
+}
+
+static void mq_test_merge(void)
+{
+	static struct mmc_queue_req req[6];
+	static struct mmc_queue_seg seg[6][1];
+	static struct mq_done d[6];
+	struct mmc_queue_stats st;
+	struct mmc_queue *q;
+	int i;
+
+	q = mq_open(1, MMC_QUEUE_F_DEFAULT);
+
+	/*
+	 * With the host held, at most the first request goes into a command
+	 * before the rest are queued: adjacent writes then make one command,
+	 * a gap or a change of direction starts a new one.
+	 */
+	card_sim_hold();
+	mq_req_init(&req[0], seg[0], &d[0], 0, 4, 1, 1);
+	mq_req_init(&req[1], seg[1], &d[1], 4, 4, 1, 1);
+	mq_req_init(&req[2], seg[2], &d[2], 8, 4, 1, 1);
+	mq_req_init(&req[3], seg[3], &d[3], 20, 4, 1, 1);	/* gap */
+	mq_req_init(&req[4], seg[4], &d[4], 0, 12, 0, 1);	/* read */
+	for (i = 0; i < 5; i++)
+		TEST_ASSERT(mmc_queue_submit(q, &req[i]) == 0);
+	card_sim_release();
+	TEST_ASSERT(mmc_queue_flush(q) == 0);
+
+	mmc_queue_get_stats(q, &st);
+	TEST_ASSERT(st.cmd == 3 || st.cmd == 4);
+	TEST_ASSERT_EQ(st.merged + st.cmd, 5);
+	TEST_ASSERT(memcmp(mq_chk, mq_src, 12 * 512) == 0);
+	for (i = 0; i < 5; i++)
+		TEST_ASSERT_EQ(d[i].seq, i);
+	mq_close(q);
+
+	/* without MMC_QUEUE_F_MERGE every request is a command */
+	q = mq_open(1, MMC_QUEUE_F_DEFAULT & ~MMC_QUEUE_F_MERGE);
+	card_sim_hold();
+	for (i = 0; i < 3; i++) {
+		mq_req_init(&req[i], seg[i], &d[i], i * 4, 4, 1, 1);
+		TEST_ASSERT(mmc_queue_submit(q, &req[i]) == 0);
+	}
+	card_sim_release();
+	TEST_ASSERT(mmc_queue_flush(q) == 0);
+	mmc_queue_get_stats(q, &st);
+	TEST_ASSERT_EQ(st.cmd, 3);
+	TEST_ASSERT_EQ(st.merged, 0);
+	mq_close(q);
+}
+
+static void mq_test_split(void)
+{
+	static struct mmc_queue_seg seg[MMC_QUEUE_SEG_MAX];
+	struct mmc_queue_req req;
+	struct mq_done d;
+	struct mmc_queue_stats st;
+	struct mmc_queue *q;
+	uint32_t n = 2000, i;
+
+	/* longer than one transfer */
+	q = mq_open(1, MMC_QUEUE_F_DEFAULT);
+	TEST_ASSERT(mmc_queue_write(q, mq_src, 100, n) == 0);
+	TEST_ASSERT(mmc_queue_read(q, mq_chk, 100, n) == 0);
+	TEST_ASSERT(memcmp(mq_chk, mq_src, n * 512) == 0);
+	TEST_ASSERT(memcmp(card_sim_disk + 100 * 512, mq_src, n * 512) == 0);
+	mmc_queue_get_stats(q, &st);
+	TEST_ASSERT_EQ(card_sim.max_blocks, SDXC_MAX_TRANS_LEN / 512);
+	TEST_ASSERT_EQ(st.cmd, 2 * ((n * 512 + SDXC_MAX_TRANS_LEN - 1) /
+				    SDXC_MAX_TRANS_LEN));
+	mq_close(q);
+
+	/*
+	 * Segments of 10K, two descriptors each: the scatter list is cut at
+	 * SDXC_MAX_DES_NUM descriptors before the transfer length is reached.
+	 */
+	q = mq_open(1, MMC_QUEUE_F_DEFAULT);
+	mq_req_init(&req, seg, &d, 0, MMC_QUEUE_SEG_MAX * 20, 1, 1);
+	for (i = 0; i < MMC_QUEUE_SEG_MAX; i++) {
+		seg[i].buf = mq_src + i * 20 * 512;
+		seg[i].len = 20 * 512;
+	}
+	req.seg_cnt = MMC_QUEUE_SEG_MAX;
+	TEST_ASSERT(mmc_queue_submit(q, &req) == 0);
+	TEST_ASSERT(mmc_queue_flush(q) == 0);
+	TEST_ASSERT_EQ(d.calls, 1);
+	TEST_ASSERT_EQ(card_sim.max_blocks, SDXC_MAX_DES_NUM / 2 * 20);
+	TEST_ASSERT(memcmp(card_sim_disk, mq_src, MMC_QUEUE_SEG_MAX * 20 * 512) == 0);
+	mq_close(q);
+}
+
+static void mq_test_errors(void)
+{
+	static struct mmc_queue_req req[6];
+	static struct mmc_queue_seg seg[6][1];
+	static struct mq_done d[6];
+	struct mmc_queue_req barrier;
+	struct mq_done bd;
+	struct mmc_queue_stats st;
+	struct mmc_queue *q;
+	int i;
+
+	q = mq_open(1, MMC_QUEUE_F_DEFAULT);
+	card_sim.fail_blk = 1000;
+	quiet = 1;
+
+	card_sim_hold();
+	mq_req_init(&req[0], seg[0], &d[0], 0, 8, 1, 1);
+	mq_req_init(&req[1], seg[1], &d[1], 996, 8, 0, 1);	/* fails */
+	mq_req_init(&req[2], seg[2], &d[2], 16, 8, 1, 1);
+	memset(&barrier, 0, sizeof(barrier));
+	memset(&bd, 0, sizeof(bd));
+	barrier.done = mq_done;
+	barrier.arg = &bd;
+	mq_req_init(&req[3], seg[3], &d[3], 32, 8, 1, 1);
+	for (i = 0; i < 3; i++)
+		TEST_ASSERT(mmc_queue_submit(q, &req[i]) == 0);
+	TEST_ASSERT(mmc_queue_submit(q, &barrier) == 0);
+	TEST_ASSERT(mmc_queue_submit(q, &req[3]) == 0);
+	card_sim_release();
+
+	/* the barrier reports the error, the next one starts clean */
+	TEST_ASSERT(mmc_queue_flush(q) == 0);
+	TEST_ASSERT_EQ(d[0].err, 0);
+	TEST_ASSERT(d[1].err != 0);
+	TEST_ASSERT_EQ(d[2].err, 0);
+	TEST_ASSERT(bd.err != 0);
+	TEST_ASSERT_EQ(bd.seq, 3);
+	TEST_ASSERT_EQ(d[3].err, 0);
+	TEST_ASSERT(memcmp(card_sim_disk + 32 * 512, mq_src + 32 * 512, 8 * 512) == 0);
+
+	/* a request split over several commands is done once, with the error */
+	mq_req_init(&req[4], seg[4], &d[4], 0, 3000, 1, 1);
+	TEST_ASSERT(mmc_queue_submit(q, &req[4]) == 0);
+	TEST_ASSERT(mmc_queue_flush(q) != 0);
+	TEST_ASSERT_EQ(d[4].calls, 1);
+	TEST_ASSERT(d[4].err != 0);
+	TEST_ASSERT(mmc_queue_flush(q) == 0);
+
+	TEST_ASSERT(mmc_queue_read(q, mq_chk, 999, 2) != 0);
+	card_sim.fail_blk = 0;
+	TEST_ASSERT(mmc_queue_read(q, mq_chk, 999, 2) == 0);
+
+	quiet = 0;
+	mmc_queue_get_stats(q, &st);
+	TEST_ASSERT_EQ(st.err, 3);
+	mq_close(q);
+}
+
+static void mq_test_pre_erase(void)
+{
+	struct mmc_queue_stats st;
+	struct mmc_queue *q;
+
+	/* no CMD23 support: long writes get the ACMD23 hint, short ones not */
+	q = mq_open(0, MMC_QUEUE_F_DEFAULT);
+	TEST_ASSERT(mmc_queue_write(q, mq_src, 10, 64) == 0);
+	TEST_ASSERT(mmc_queue_write(q, mq_src, 100, MMC_QUEUE_PRE_ERASE_MIN - 1) == 0);
+	TEST_ASSERT(mmc_queue_read(q, mq_chk, 10, 64) == 0);
+	TEST_ASSERT(memcmp(mq_chk, mq_src, 64 * 512) == 0);
+	mmc_queue_get_stats(q, &st);
+	TEST_ASSERT_EQ(st.pre_erase, 1);
+	TEST_ASSERT_EQ(card_sim.acmd23, 1);
+	TEST_ASSERT_EQ(st.sbc, 0);
+	TEST_ASSERT_EQ(card_sim.sbc, 0);
+	mq_close(q);
+
+	/* CMD23 supported but not enabled: CMD12 ends the commands */
+	q = mq_open(1, MMC_QUEUE_F_MERGE);
+	TEST_ASSERT(mmc_queue_write(q, mq_src, 10, 64) == 0);
+	mmc_queue_get_stats(q, &st);
+	TEST_ASSERT_EQ(st.sbc + st.pre_erase, 0);
+	TEST_ASSERT_EQ(card_sim.sbc + card_sim.acmd23, 0);
+	mq_close(q);
+}
+
+static void mq_test_invalid(void)
+{
+	struct mmc_queue_seg seg[MMC_QUEUE_SEG_MAX + 1];
+	struct mmc_queue_req req;
+	struct mq_done d;
+	struct mmc_queue *q;
+	int i;
+
+	q = mq_open(1, MMC_QUEUE_F_DEFAULT);
+	quiet = 1;
+	mq_req_init(&req, seg, &d, 0, 1, 1, 1);
+	seg[0].len = 100;
+	TEST_ASSERT(mmc_queue_submit(q, &req) != 0);
+
+	/* segments not adding up to the blocks */
+	mq_req_init(&req, seg, &d, 0, 4, 1, 2);
+	seg[1].len -= 512;
+	TEST_ASSERT(mmc_queue_submit(q, &req) != 0);
+
+	mq_req_init(&req, seg, &d, 0, MMC_QUEUE_SEG_MAX + 1, 1, 1);
+	for (i = 0; i <= MMC_QUEUE_SEG_MAX; i++) {
+		seg[i].buf = mq_src + i * 512;
+		seg[i].len = 512;
+	}
+	req.seg_cnt = MMC_QUEUE_SEG_MAX + 1;
+	TEST_ASSERT(mmc_queue_submit(q, &req) != 0);
+
+	TEST_ASSERT(mmc_queue_submit(q, NULL) != 0);
+	quiet = 0;
+	TEST_ASSERT(mmc_queue_flush(q) == 0);
+	TEST_ASSERT_EQ(d.calls, 0);
+	TEST_ASSERT_EQ(card_sim.cmd, 0);
+	mq_close(q);
+}
+
+void mmc_queue_test(void)
+{
+	TEST_RUN(mq_test_seq_writes);
+	TEST_RUN(mq_test_merge);
+	TEST_RUN(mq_test_split);
+	TEST_RUN(mq_test_errors);
+	TEST_RUN(mq_test_pre_erase);
+	TEST_RUN(mq_test_invalid);
+}
+
+/* a recorder stream: writes of 4 to 16 blocks, one after the other */
+static double mq_bench_run(int queued, uint32_t *cmds)
+{
+	enum { N = 300 };
+	static struct mmc_queue_req req[N];
+	static struct mmc_queue_seg seg[N][1];
+	static struct mq_done d[N];
+	struct mmc_queue *q;
+	uint32_t seed = 3, blk = 0, nblk;
+	uint64_t t;
+	int i;
+
+	q = mq_open(1, MMC_QUEUE_F_DEFAULT);
+	t = test_now_ns();
+	for (i = 0; i < N; i++) {
+		nblk = 4 + test_rand(&seed) % 13;
+		if (queued) {
+			mq_req_init(&req[i], seg[i], &d[i], blk, nblk, 1, 1);
+			TEST_ASSERT(mmc_queue_submit(q, &req[i]) == 0);
+		} else {
+			TEST_ASSERT(mmc_queue_write(q, mq_src + blk * 512, blk, nblk) == 0);
+		}
+		blk += nblk;
+	}
+	TEST_ASSERT(mmc_queue_flush(q) == 0);
+	t = test_now_ns() - t;
+	TEST_ASSERT(memcmp(card_sim_disk, mq_src, blk * 512) == 0);
+	*cmds = card_sim.cmd;
+	mq_close(q);
+	return blk * 512.0 / 1024 / 1024 / (t / 1e9);
+}
+
+void mmc_queue_bench(void)
+{
+	uint32_t cmds[2];
+	double mbs[2];
+
+	mbs[0] = mq_bench_run(0, &cmds[0]);
+	mbs[1] = mq_bench_run(1, &cmds[1]);
+	printf("\n%-12s %8s %8s   (card busy %u us per write)\n", "writes", "MB/s",
+	       "cmds", MQ_BUSY_US);
+	printf("%-12s %8.2f %8u\n", "synchronous", mbs[0], cmds[0]);
+	printf("%-12s %8.2f %8u\n", "queued", mbs[1], cmds[1]);
+}
@@ -0,0 +1,7 @@
+#ifndef _MMC_QUEUE_TEST_H_
+#define _MMC_QUEUE_TEST_H_
+
+void mmc_queue_test(void);
+void mmc_queue_bench(void);
+
+#endif /* _MMC_QUEUE_TEST_H_ */
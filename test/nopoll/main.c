@@ -0,0 +1,8 @@
+#include "test.h"
+#include "nopoll_test.h"
+
+int main(int argc, char **argv)
+{
+	nopoll_conn_test();
+	return 0;
+}
@@ -0,0 +1,22 @@
+/*
+ * Replaces include/net/nopoll/nopoll_config.h (same guard) to build the
+ * library over host sockets. The mbedTLS flavour is kept, the OpenSSL one
+ * is not maintained in this tree.
+ */
+
+#ifndef __NOPOLL_CONFIG_H__
+#define __NOPOLL_CONFIG_H__
+
+#include <stdint.h>
+
+#define INT_TO_PTR(integer)	((noPollPtr) (intptr_t) (integer))
+#define PTR_TO_INT(ptr)		((int) (intptr_t) (ptr))
+
+#define NOPOLL_OS_UNIX (1)
+#define NOPOLL_NO_IPV6 (1)
+#define NOPOLL_MBEDTLS (1)
+
+/* as configure sets it on Linux, the vsnprintf fallback reuses its va_list */
+#define NOPOLL_HAVE_VASPRINTF (1)
+
+#endif
@@ -0,0 +1,396 @@
+/*
+ * nopoll framing and masking, RFC 6455 section 5. The mask helper gives
+ * the 5.7 "Hello" bytes and matches a byte loop for any size, alignment
+ * and fragment offset. A raw socket peer then checks the exact frames an
+ * echo listener sends back for the 5.7 examples (single, fragmented,
+ * 256 bytes and 64 KiB binary), small ones in a single write, and a
+ * nopoll client round trips masked messages across the 7/16/64-bit
+ * length encodings. Masking and echo throughput are printed in MB/s.
+ */
+
+#include <pthread.h>
+#include <poll.h>
+#include <netinet/tcp.h>
+
+#include "nopoll.h"
+#include "test.h"
+#include "nopoll_test.h"
+
+#define TEST_PORT	"18601"
+#define MSG_MAX		(300 * 1024)
+
+/* send() calls made by the library, see --wrap in the Makefile */
+static volatile int nr_sends;
+
+ssize_t __real_send(int fd, const void *buf, size_t len, int flags);
+
+ssize_t __wrap_send(int fd, const void *buf, size_t len, int flags)
+{
+	__sync_fetch_and_add(&nr_sends, 1);
+	return __real_send(fd, buf, len, flags);
+}
+
+static const char rfc_mask[4] = { 0x37, (char)0xfa, 0x21, 0x3d };
+static const unsigned char rfc_masked_hello[5] = { 0x7f, 0x9f, 0x4d, 0x51, 0x58 };
+
+static void mask_ref(char *buf, int size, const char *mask, int desp)
+{
+	int i;
+
+	for (i = 0; i < size; i++)
+		buf[i] ^= mask[(i + desp) % 4];
+}
+
+static void nopoll_conn_test_mask_rfc(void)
+{
+	char buf[5];
+
+	memcpy(buf, "Hello", 5);
+	nopoll_conn_mask_content(NULL, buf, 5, (char *)rfc_mask, 0);
+	TEST_ASSERT(!memcmp(buf, rfc_masked_hello, 5));
+	nopoll_conn_mask_content(NULL, buf, 5, (char *)rfc_mask, 0);
+	TEST_ASSERT(!memcmp(buf, "Hello", 5));
+
+	/* unmasked in two reads, the second one at payload offset 2 */
+	memcpy(buf, rfc_masked_hello, 5);
+	nopoll_conn_mask_content(NULL, buf, 2, (char *)rfc_mask, 0);
+	nopoll_conn_mask_content(NULL, buf + 2, 3, (char *)rfc_mask, 2);
+	TEST_ASSERT(!memcmp(buf, "Hello", 5));
+}
+
+static void nopoll_conn_test_mask_random(void)
+{
+	static char buf[512 + 8], ref[512 + 8];
+	char mask[4];
+	uint32_t seed = 5;
+	int i, j, size, align, desp;
+
+	for (i = 0; i < 200000; i++) {
+		size = test_rand(&seed) % 512;
+		align = test_rand(&seed) % 8;
+		desp = test_rand(&seed) % 8;
+		for (j = 0; j < 4; j++)
+			mask[j] = test_rand(&seed);
+		for (j = 0; j < size + 8; j++)
+			buf[j] = ref[j] = test_rand(&seed);
+
+		nopoll_conn_mask_content(NULL, buf + align, size, mask, desp);
+		mask_ref(ref + align, size, mask, desp);
+		TEST_ASSERT(!memcmp(buf, ref, sizeof(buf)));
+	}
+}
+
+/*
+ * Echo listener: every complete message goes back as one unmasked frame
+ * of the same type, fragments are joined first.
+ */
+static noPollCtx *srv_ctx;
+static pthread_t srv_thread;
+static char *srv_buf;
+static int srv_len;
+static noPollOpCode srv_op;
+
+static void srv_on_msg(noPollCtx *ctx, noPollConn *conn, noPollMsg *msg, noPollPtr user_data)
+{
+	int size = nopoll_msg_get_payload_size(msg);
+
+	if (srv_len == 0)
+		srv_op = nopoll_msg_opcode(msg);
+	TEST_ASSERT(srv_len + size <= MSG_MAX);
+	memcpy(srv_buf + srv_len, nopoll_msg_get_payload(msg), size);
+	srv_len += size;
+	if (!nopoll_msg_is_final(msg))
+		return;
+
+	TEST_ASSERT_EQ(nopoll_conn_send_frame(conn, nopoll_true, nopoll_false, srv_op,
+	                                      srv_len, srv_buf, 0), srv_len);
+	TEST_ASSERT(nopoll_conn_flush_writes(conn, 2000000, 0) >= 0);
+	srv_len = 0;
+}
+
+static void *srv_loop(void *arg)
+{
+	nopoll_loop_wait(srv_ctx, 0);
+	return NULL;
+}
+
+static void srv_start(void)
+{
+	noPollConn *listener;
+
+	srv_buf = malloc(MSG_MAX);
+	TEST_ASSERT(srv_buf != NULL);
+	srv_ctx = nopoll_ctx_new();
+	listener = nopoll_listener_new(srv_ctx, "127.0.0.1", TEST_PORT);
+	TEST_ASSERT(nopoll_conn_is_ok(listener));
+	nopoll_ctx_set_on_msg(srv_ctx, srv_on_msg, NULL);
+	TEST_ASSERT_EQ(pthread_create(&srv_thread, NULL, srv_loop, NULL), 0);
+}
+
+static void srv_stop(void)
+{
+	nopoll_loop_stop(srv_ctx);
+	pthread_join(srv_thread, NULL);
+	nopoll_ctx_unref(srv_ctx);
+	free(srv_buf);
+}
+
+/* raw socket peer */
+static int raw_connect(void)
+{
+	static const char req[] =
+		"GET / HTTP/1.1\r\n"
+		"Host: 127.0.0.1\r\n"
+		"Upgrade: websocket\r\n"
+		"Connection: Upgrade\r\n"
+		"Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+		"Origin: http://127.0.0.1\r\n"
+		"Sec-WebSocket-Version: 13\r\n\r\n";
+	struct sockaddr_in addr;
+	char resp[512];
+	int fd, len = 0, n;
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(atoi(TEST_PORT));
+	addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+	TEST_ASSERT_EQ(connect(fd, (struct sockaddr *)&addr, sizeof(addr)), 0);
+	TEST_ASSERT_EQ(write(fd, req, sizeof(req) - 1), sizeof(req) - 1);
+
+	while (len < (int)sizeof(resp) - 1) {
+		n = read(fd, resp + len, sizeof(resp) - 1 - len);
+		TEST_ASSERT(n > 0);
+		len += n;
+		resp[len] = '\0';
+		if (strstr(resp, "\r\n\r\n"))
+			break;
+	}
+	TEST_ASSERT(strstr(resp, "HTTP/1.1 101") == resp);
+	/* the RFC 6455 section 1.3 key and accept pair */
+	TEST_ASSERT(strstr(resp, "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"));
+	return fd;
+}
+
+static void raw_read(int fd, unsigned char *buf, int len)
+{
+	int n;
+
+	while (len > 0) {
+		n = read(fd, buf, len);
+		TEST_ASSERT(n > 0);
+		buf += n;
+		len -= n;
+	}
+}
+
+/* one masked frame with payload @data of @len bytes */
+static void raw_send_frame(int fd, int fin, int op, const void *data, int len)
+{
+	unsigned char *frame = malloc(len + 14);
+	int hlen = 2, i;
+
+	TEST_ASSERT(frame != NULL);
+	frame[0] = (fin ? 0x80 : 0) | op;
+	if (len < 126) {
+		frame[1] = 0x80 | len;
+	} else if (len < 65536) {
+		frame[1] = 0x80 | 126;
+		frame[2] = len >> 8;
+		frame[3] = len;
+		hlen = 4;
+	} else {
+		frame[1] = 0x80 | 127;
+		for (i = 0; i < 8; i++)
+			frame[2 + i] = i < 4 ? 0 : (uint32_t)len >> (8 * (7 - i));
+		hlen = 10;
+	}
+	memcpy(frame + hlen, rfc_mask, 4);
+	memcpy(frame + hlen + 4, data, len);
+	mask_ref((char *)frame + hlen + 4, len, rfc_mask, 0);
+	TEST_ASSERT_EQ(write(fd, frame, hlen + 4 + len), hlen + 4 + len);
+	free(frame);
+}
+
+/* the echo must be exactly @head followed by the unmasked payload */
+static void raw_expect(int fd, const unsigned char *head, int hlen, const void *data, int len)
+{
+	unsigned char *buf = malloc(hlen + len);
+
+	TEST_ASSERT(buf != NULL);
+	raw_read(fd, buf, hlen + len);
+	TEST_ASSERT(!memcmp(buf, head, hlen));
+	TEST_ASSERT(!memcmp(buf + hlen, data, len));
+	free(buf);
+}
+
+static void nopoll_conn_test_rfc_frames(void)
+{
+	static const unsigned char hello_masked[] = {
+		0x81, 0x85, 0x37, 0xfa, 0x21, 0x3d, 0x7f, 0x9f, 0x4d, 0x51, 0x58
+	};
+	static const unsigned char hello[] = { 0x81, 0x05 };
+	static const unsigned char bin256[] = { 0x82, 0x7e, 0x01, 0x00 };
+	static const unsigned char bin64k[] = {
+		0x82, 0x7f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00
+	};
+	unsigned char *data;
+	uint32_t seed = 7;
+	int fd, i;
+
+	data = malloc(65536);
+	TEST_ASSERT(data != NULL);
+	for (i = 0; i < 65536; i++)
+		data[i] = test_rand(&seed);
+
+	fd = raw_connect();
+
+	/* 5.7 single-frame masked text message, echoed unmasked */
+	nr_sends = 0;
+	TEST_ASSERT_EQ(write(fd, hello_masked, sizeof(hello_masked)), sizeof(hello_masked));
+	raw_expect(fd, hello, sizeof(hello), "Hello", 5);
+	TEST_ASSERT_EQ(nr_sends, 1);
+
+	/* 5.7 fragmented text message */
+	raw_send_frame(fd, 0, NOPOLL_TEXT_FRAME, "Hel", 3);
+	raw_send_frame(fd, 1, NOPOLL_CONTINUATION_FRAME, "lo", 2);
+	raw_expect(fd, hello, sizeof(hello), "Hello", 5);
+
+	/* 5.7 256 bytes and 64 KiB binary messages */
+	nr_sends = 0;
+	raw_send_frame(fd, 1, NOPOLL_BINARY_FRAME, data, 256);
+	raw_expect(fd, bin256, sizeof(bin256), data, 256);
+	TEST_ASSERT_EQ(nr_sends, 1);
+	raw_send_frame(fd, 1, NOPOLL_BINARY_FRAME, data, 65536);
+	raw_expect(fd, bin64k, sizeof(bin64k), data, 65536);
+
+	close(fd);
+	free(data);
+}
+
+/* nopoll client */
+static noPollConn *cli_connect(noPollCtx *ctx)
+{
+	noPollConn *conn;
+	int one = 1;
+
+	conn = nopoll_conn_new(ctx, "127.0.0.1", TEST_PORT, NULL, NULL, NULL, NULL);
+	TEST_ASSERT(nopoll_conn_is_ok(conn));
+	TEST_ASSERT(nopoll_conn_wait_until_connection_ready(conn, 5));
+	setsockopt(nopoll_conn_socket(conn), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	return conn;
+}
+
+/* the echo of a @len bytes message, joined from however many reads */
+static void cli_recv(noPollConn *conn, char *buf, int len)
+{
+	struct pollfd pfd = { .fd = nopoll_conn_socket(conn), .events = POLLIN };
+	noPollMsg *msg;
+	int got = 0, final = 0, size;
+
+	while (!final) {
+		msg = nopoll_conn_get_msg(conn);
+		if (msg == NULL) {
+			TEST_ASSERT(nopoll_conn_is_ok(conn));
+			TEST_ASSERT(poll(&pfd, 1, 5000) == 1);
+			continue;
+		}
+		size = nopoll_msg_get_payload_size(msg);
+		TEST_ASSERT(got + size <= len);
+		memcpy(buf + got, nopoll_msg_get_payload(msg), size);
+		got += size;
+		final = nopoll_msg_is_final(msg);
+		nopoll_msg_unref(msg);
+	}
+	TEST_ASSERT_EQ(got, len);
+}
+
+static void cli_echo(noPollConn *conn, const char *data, char *buf, int len)
+{
+	TEST_ASSERT_EQ(nopoll_conn_send_binary(conn, data, len), len);
+	TEST_ASSERT(nopoll_conn_flush_writes(conn, 2000000, 0) >= 0);
+	cli_recv(conn, buf, len);
+	TEST_ASSERT(!memcmp(buf, data, len));
+}
+
+static void nopoll_conn_test_client(void)
+{
+	static const int sizes[] = {
+		1, 5, 125, 126, 127, 1000, 65535, 65536, 65537, MSG_MAX
+	};
+	noPollCtx *ctx;
+	noPollConn *conn;
+	char *data, *buf;
+	uint32_t seed = 9;
+	int i;
+
+	data = malloc(MSG_MAX);
+	buf = malloc(MSG_MAX);
+	TEST_ASSERT(data != NULL && buf != NULL);
+	for (i = 0; i < MSG_MAX; i++)
+		data[i] = test_rand(&seed);
+
+	ctx = nopoll_ctx_new();
+	conn = cli_connect(ctx);
+	for (i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+		/* the payload at every alignment */
+		cli_echo(conn, data, buf, sizes[i]);
+		cli_echo(conn, data + 1 + i % 3, buf, sizes[i] - 1 - i % 3);
+	}
+	nopoll_conn_close(conn);
+	nopoll_ctx_unref(ctx);
+	free(data);
+	free(buf);
+}
+
+static void nopoll_conn_bench(void)
+{
+	noPollCtx *ctx;
+	noPollConn *conn;
+	char *data, *buf;
+	char mask[4] = { 1, 2, 3, 4 };
+	uint64_t t;
+	int i, loops = 20000;
+
+	data = malloc(4096 + 1);
+	buf = malloc(4096);
+	TEST_ASSERT(data != NULL && buf != NULL);
+	memset(data, 0x5a, 4096 + 1);
+
+	printf("\n4 KB payloads\n");
+	t = test_now_ns();
+	for (i = 0; i < loops; i++)
+		mask_ref(data + 1, 4096, mask, i);
+	t = test_now_ns() - t;
+	printf("  byte loop mask    %8.1f MB/s\n", 4096.0 * loops * 1000 / t);
+	t = test_now_ns();
+	for (i = 0; i < loops; i++)
+		nopoll_conn_mask_content(NULL, data + 1, 4096, mask, i);
+	t = test_now_ns() - t;
+	printf("  mask_content      %8.1f MB/s\n", 4096.0 * loops * 1000 / t);
+
+	ctx = nopoll_ctx_new();
+	conn = cli_connect(ctx);
+	loops = 5000;
+	t = test_now_ns();
+	for (i = 0; i < loops; i++)
+		cli_echo(conn, data, buf, 4096);
+	t = test_now_ns() - t;
+	printf("  loopback echo     %8.1f MB/s each way\n", 4096.0 * loops * 1000 / t);
+	nopoll_conn_close(conn);
+	nopoll_ctx_unref(ctx);
+	free(data);
+	free(buf);
+}
+
+void nopoll_conn_test(void)
+{
+	TEST_RUN(nopoll_conn_test_mask_rfc);
+	TEST_RUN(nopoll_conn_test_mask_random);
+
+	srv_start();
+	TEST_RUN(nopoll_conn_test_rfc_frames);
+	TEST_RUN(nopoll_conn_test_client);
+	nopoll_conn_bench();
+	srv_stop();
+}
@@ -0,0 +1,6 @@
+#ifndef _NOPOLL_TEST_H_
+#define _NOPOLL_TEST_H_
+
+void nopoll_conn_test(void);
+
+#endif /* _NOPOLL_TEST_H_ */
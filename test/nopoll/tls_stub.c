@@ -0,0 +1,129 @@
+/*
+ * mbedTLS entry points nopoll links against. The tests run plain
+ * connections only: contexts can be set up and released, every TLS
+ * operation fails as unavailable.
+ */
+
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/debug.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/net.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/x509_crt.h"
+
+#define TLS_UNAVAILABLE	MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE
+
+void mbedtls_ctr_drbg_init(mbedtls_ctr_drbg_context *ctx) { }
+void mbedtls_ctr_drbg_free(mbedtls_ctr_drbg_context *ctx) { }
+void mbedtls_entropy_init(mbedtls_entropy_context *ctx) { }
+void mbedtls_entropy_free(mbedtls_entropy_context *ctx) { }
+void mbedtls_pk_init(mbedtls_pk_context *ctx) { }
+void mbedtls_pk_free(mbedtls_pk_context *ctx) { }
+void mbedtls_x509_crt_init(mbedtls_x509_crt *crt) { }
+void mbedtls_x509_crt_free(mbedtls_x509_crt *crt) { }
+void mbedtls_ssl_init(mbedtls_ssl_context *ssl) { }
+void mbedtls_ssl_free(mbedtls_ssl_context *ssl) { }
+void mbedtls_ssl_config_init(mbedtls_ssl_config *conf) { }
+void mbedtls_ssl_config_free(mbedtls_ssl_config *conf) { }
+void mbedtls_debug_set_threshold(int threshold) { }
+
+void mbedtls_ssl_conf_authmode(mbedtls_ssl_config *conf, int authmode) { }
+
+void mbedtls_ssl_conf_ca_chain(mbedtls_ssl_config *conf, mbedtls_x509_crt *ca_chain,
+                               mbedtls_x509_crl *ca_crl) { }
+
+void mbedtls_ssl_conf_dbg(mbedtls_ssl_config *conf,
+                          void (*f_dbg)(void *, int, const char *, int, const char *),
+                          void *p_dbg) { }
+
+void mbedtls_ssl_conf_rng(mbedtls_ssl_config *conf,
+                          int (*f_rng)(void *, unsigned char *, size_t),
+                          void *p_rng) { }
+
+void mbedtls_ssl_set_bio(mbedtls_ssl_context *ssl, void *p_bio, mbedtls_ssl_send_t *f_send,
+                         mbedtls_ssl_recv_t *f_recv, mbedtls_ssl_recv_timeout_t *f_recv_timeout) { }
+
+int mbedtls_ctr_drbg_seed(mbedtls_ctr_drbg_context *ctx,
+                          int (*f_entropy)(void *, unsigned char *, size_t),
+                          void *p_entropy, const unsigned char *custom, size_t len)
+{
+	return TLS_UNAVAILABLE;
+}
+
+int mbedtls_ctr_drbg_random(void *p_rng, unsigned char *output, size_t output_len)
+{
+	return TLS_UNAVAILABLE;
+}
+
+int mbedtls_entropy_func(void *data, unsigned char *output, size_t len)
+{
+	return TLS_UNAVAILABLE;
+}
+
+int mbedtls_net_recv(void *ctx, unsigned char *buf, size_t len)
+{
+	return TLS_UNAVAILABLE;
+}
+
+int mbedtls_net_send(void *ctx, const unsigned char *buf, size_t len)
+{
+	return TLS_UNAVAILABLE;
+}
+
+int mbedtls_pk_parse_key(mbedtls_pk_context *ctx, const unsigned char *key, size_t keylen,
+                         const unsigned char *pwd, size_t pwdlen)
+{
+	return TLS_UNAVAILABLE;
+}
+
+int mbedtls_x509_crt_parse(mbedtls_x509_crt *chain, const unsigned char *buf, size_t buflen)
+{
+	return TLS_UNAVAILABLE;
+}
+
+int mbedtls_x509_crt_verify_info(char *buf, size_t size, const char *prefix, uint32_t flags)
+{
+	return TLS_UNAVAILABLE;
+}
+
+int mbedtls_ssl_conf_own_cert(mbedtls_ssl_config *conf, mbedtls_x509_crt *own_cert,
+                              mbedtls_pk_context *pk_key)
+{
+	return TLS_UNAVAILABLE;
+}
+
+int mbedtls_ssl_config_defaults(mbedtls_ssl_config *conf, int endpoint, int transport, int preset)
+{
+	return TLS_UNAVAILABLE;
+}
+
+int mbedtls_ssl_setup(mbedtls_ssl_context *ssl, const mbedtls_ssl_config *conf)
+{
+	return TLS_UNAVAILABLE;
+}
+
+int mbedtls_ssl_session_reset(mbedtls_ssl_context *ssl)
+{
+	return TLS_UNAVAILABLE;
+}
+
+int mbedtls_ssl_handshake(mbedtls_ssl_context *ssl)
+{
+	return TLS_UNAVAILABLE;
+}
+
+uint32_t mbedtls_ssl_get_verify_result(const mbedtls_ssl_context *ssl)
+{
+	return (uint32_t)-1;
+}
+
+int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
+{
+	return TLS_UNAVAILABLE;
+}
+
+int mbedtls_ssl_write(mbedtls_ssl_context *ssl, const unsigned char *buf, size_t len)
+{
+	return TLS_UNAVAILABLE;
+}
@@ -0,0 +1,10 @@
+#include "test.h"
+#include "os_trace_test.h"
+
+int main(int argc, char **argv)
+{
+	os_trace_ring_test();
+	os_trace_decode_test();
+	os_trace_ring_bench();
+	return 0;
+}
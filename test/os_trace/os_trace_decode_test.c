@@ -0,0 +1,319 @@
+/*
+ * Round trip through tools/os_trace_decode.py.
+ *
+ * A known schedule is written into a ring that has wrapped several times,
+ * with time stamps crossing 2^32 and a record left half written. It is saved
+ * both as the raw buffer and as the console dump OS_TraceDump() prints, with
+ * other output interleaved. The decoder must print the same events from
+ * both, in order, skip the half written one, and its per-task and interrupt
+ * summary must match what is computed here from the records kept.
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "os_trace_ring.h"
+#include "os_trace_test.h"
+
+#define DEC_PYTHON	"python3"
+#define DEC_BUF_SIZE	(16 * 1024)
+#define DEC_OUT_SIZE	(256 * 1024)
+
+/* records the ring gets from DEC_BUF_SIZE */
+#define DEC_REC_COUNT	1024
+
+/* as os_trace.c dumps it */
+#define DEC_DUMP_LINE	32
+
+#define TASK_IDLE	1
+#define TASK_MAIN	2
+#define TASK_NET	3
+#define TASK_NR		4
+#define EXC_SYSTICK	15
+
+static uint32_t dec_buf[DEC_BUF_SIZE / 4];
+static char dec_dir[] = "/tmp/os_trace_XXXXXX";
+static char dec_out[2][DEC_OUT_SIZE];
+
+static const char *dec_ev_name[] = {
+	[OS_TRACE_EV_SWITCH_IN] = "switch",
+	[OS_TRACE_EV_READY] = "ready",
+	[OS_TRACE_EV_ISR_ENTER] = "isr+",
+	[OS_TRACE_EV_ISR_EXIT] = "isr-",
+	[OS_TRACE_EV_MARK] = "mark",
+};
+
+/* one period: net woken and run, a tick, main, back to idle */
+static const struct {
+	uint32_t dt;
+	uint8_t type;
+	uint8_t prio;
+	uint16_t arg;
+} dec_period[] = {
+	{ 100, OS_TRACE_EV_READY,     4, TASK_NET },
+	{ 7,   OS_TRACE_EV_SWITCH_IN, 4, TASK_NET },
+	{ 50,  OS_TRACE_EV_ISR_ENTER, 0, EXC_SYSTICK },
+	{ 3,   OS_TRACE_EV_ISR_EXIT,  0, EXC_SYSTICK },
+	{ 20,  OS_TRACE_EV_SWITCH_IN, 3, TASK_MAIN },
+	{ 10,  OS_TRACE_EV_SWITCH_IN, 0, TASK_IDLE },
+	{ 40,  OS_TRACE_EV_MARK,      0, 77 },
+};
+
+#define DEC_PERIOD	(sizeof(dec_period) / sizeof(dec_period[0]))
+
+static int dec_has_python(void)
+{
+	return system(DEC_PYTHON " -c 'import json' >/dev/null 2>&1") == 0;
+}
+
+static void dec_run(const char *opt, const char *file, char *out)
+{
+	char cmd[512];
+	FILE *p;
+	size_t n;
+
+	snprintf(cmd, sizeof(cmd), DEC_PYTHON " %s %s %s/%s 2>&1",
+		 OS_TRACE_DECODE, opt, dec_dir, file);
+	p = popen(cmd, "r");
+	TEST_ASSERT(p != NULL);
+	n = fread(out, 1, DEC_OUT_SIZE - 1, p);
+	out[n] = '\0';
+	if (pclose(p) != 0) {
+		printf("\n%s\n%s", cmd, out);
+		TEST_ASSERT(0);
+	}
+}
+
+static void dec_save(OS_TraceRing_t *r)
+{
+	const uint8_t *b = (const uint8_t *)r->hdr;
+	uint32_t size = OS_TraceRingSize(r), i, j;
+	char path[64];
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s/trace.bin", dec_dir);
+	f = fopen(path, "wb");
+	TEST_ASSERT(f != NULL);
+	TEST_ASSERT(fwrite(b, 1, size, f) == size);
+	fclose(f);
+
+	snprintf(path, sizeof(path), "%s/trace.log", dec_dir);
+	f = fopen(path, "w");
+	TEST_ASSERT(f != NULL);
+	fprintf(f, "$ thread trace dump\n");
+	fprintf(f, "ostrace begin %u\n", size);
+	for (i = 0; i < size; i += DEC_DUMP_LINE) {
+		if (i % (DEC_DUMP_LINE * 16) == 0)
+			fprintf(f, "[wlan] some other output\n");
+		fprintf(f, "[12.345] ostrace %08x ", i);
+		for (j = i; j < i + DEC_DUMP_LINE && j < size; j++)
+			fprintf(f, "%02x", b[j]);
+		fprintf(f, "\n");
+	}
+	fprintf(f, "ostrace end\n$ \n");
+	fclose(f);
+}
+
+/*
+ * Write the schedule from @head on, return the records the ring keeps. The
+ * time stamps cross 2^32 in the middle of them. With @torn, a writer is
+ * interrupted between claiming a slot and storing the type.
+ */
+static uint32_t dec_fill(OS_TraceRing_t *r, uint32_t head, uint32_t n,
+			 int torn, OS_TraceRec_t *kept)
+{
+	uint32_t ts = 0, i, idx, cnt;
+
+	TEST_ASSERT(OS_TraceRingInit(r, dec_buf, sizeof(dec_buf),
+				     OS_TRACE_F_SCHED | OS_TRACE_F_ISR,
+				     1000000) == 0);
+	TEST_ASSERT_EQ(r->hdr->recCount, DEC_REC_COUNT);
+	cnt = n < DEC_REC_COUNT ? n : DEC_REC_COUNT;
+	for (i = 0; i < n - cnt / 2; i++)
+		ts -= dec_period[i % DEC_PERIOD].dt;
+	OS_TraceRingTaskSet(r, TASK_IDLE, 0, "IDLE");
+	OS_TraceRingTaskSet(r, TASK_MAIN, 3, "main");
+	OS_TraceRingTaskSet(r, TASK_NET, 4, "net");
+
+	r->hdr->head = head;
+	for (i = 0; i < n; i++) {
+		ts += dec_period[i % DEC_PERIOD].dt;
+		OS_TraceRingPut(r, ts, dec_period[i % DEC_PERIOD].type,
+				dec_period[i % DEC_PERIOD].prio,
+				dec_period[i % DEC_PERIOD].arg);
+	}
+	if (torn)
+		r->rec[(head + n - 10) & r->mask].type = OS_TRACE_EV_NONE;
+
+	for (idx = head + n - cnt, cnt = 0; idx != head + n; idx++) {
+		if (r->rec[idx & r->mask].type != OS_TRACE_EV_NONE)
+			kept[cnt++] = r->rec[idx & r->mask];
+	}
+	return cnt;
+}
+
+/* check the decoder output against the records kept */
+static void dec_check(const char *out, const OS_TraceRec_t *kept,
+		      uint32_t cnt, uint32_t lost)
+{
+	static const char *name[TASK_NR] = { NULL, "IDLE", "main", "net" };
+	uint32_t switches[TASK_NR] = { 0 }, run[TASK_NR] = { 0 };
+	uint32_t isr = 0, cur = 0, cur_at = 0, t, i;
+	const char *p = out;
+	char what[16], task[32];
+	double us, f1, f2;
+	unsigned int n1, n2, n3;
+	int k;
+
+	for (i = 0; i < cnt; i++) {
+		t = kept[i].ts - kept[0].ts;
+		TEST_ASSERT(sscanf(p, "%lf %15s", &us, what) == 2);
+		TEST_ASSERT_EQ((uint32_t)us, t);
+		TEST_ASSERT(strcmp(what, dec_ev_name[kept[i].type]) == 0);
+		switch (kept[i].type) {
+		case OS_TRACE_EV_SWITCH_IN:
+			if (cur)
+				run[cur] += t - cur_at;
+			cur = kept[i].arg;
+			cur_at = t;
+			switches[cur]++;
+			/* fall through */
+		case OS_TRACE_EV_READY:
+			TEST_ASSERT(sscanf(p, "%*f %*s %31s prio %u", task, &n1) == 2);
+			TEST_ASSERT(strcmp(task, name[kept[i].arg]) == 0);
+			TEST_ASSERT_EQ(n1, kept[i].prio);
+			break;
+		case OS_TRACE_EV_ISR_EXIT:
+			isr++;
+			/* fall through */
+		case OS_TRACE_EV_ISR_ENTER:
+			TEST_ASSERT(sscanf(p, "%*f %*s exc %u", &n1) == 1);
+			TEST_ASSERT_EQ(n1, kept[i].arg);
+			break;
+		default:
+			TEST_ASSERT(sscanf(p, "%*f %*s id %u", &n1) == 1);
+			TEST_ASSERT_EQ(n1, kept[i].arg);
+			break;
+		}
+		p = strchr(p, '\n') + 1;
+	}
+	t = kept[cnt - 1].ts - kept[0].ts;
+	run[cur] += t - cur_at;
+
+	p = strstr(p, "window");
+	TEST_ASSERT(p != NULL);
+	TEST_ASSERT(sscanf(p, "window %lf ms, %u events, %u lost to wrap",
+			   &us, &n1, &n2) == 3);
+	TEST_ASSERT_EQ(n1, cnt);
+	TEST_ASSERT_EQ(n2, lost);
+
+	for (k = TASK_IDLE; k < TASK_NR; k++) {
+		snprintf(task, sizeof(task), "\n%-16s", name[k]);
+		p = strstr(out, task);
+		TEST_ASSERT(p != NULL);
+		TEST_ASSERT(sscanf(p + 17, "%u %u %lf %lf", &n1, &n2, &f1, &f2) == 4);
+		TEST_ASSERT_EQ(n2, switches[k]);
+		TEST_ASSERT_EQ((uint32_t)(f2 + 0.5), run[k]);
+		TEST_ASSERT(f1 > 100.0 * run[k] / t - 0.1 &&
+			    f1 < 100.0 * run[k] / t + 0.1);
+	}
+
+	p = strstr(out, "\n15 ");
+	TEST_ASSERT(p != NULL);
+	TEST_ASSERT(sscanf(p, "%u %u %lf %lf", &n1, &n3, &f1, &f2) == 4);
+	TEST_ASSERT_EQ(n3, isr);
+	TEST_ASSERT(f1 == 3.0 && f2 == 3.0);
+}
+
+static OS_TraceRec_t dec_kept[DEC_BUF_SIZE / sizeof(OS_TraceRec_t)];
+
+static void dec_round_trip(uint32_t head, uint32_t n, int torn)
+{
+	OS_TraceRing_t r;
+	uint32_t cnt, lost;
+
+	cnt = dec_fill(&r, head, n, torn, dec_kept);
+	/* records written before the ones kept, the head counts from @head */
+	lost = 0;
+	if (head != 0 || n > DEC_REC_COUNT)
+		lost = head + n - DEC_REC_COUNT;
+	dec_save(&r);
+
+	dec_run("-e", "trace.bin", dec_out[0]);
+	dec_run("-e", "trace.log", dec_out[1]);
+	TEST_ASSERT(strcmp(dec_out[0], dec_out[1]) == 0);
+	dec_check(dec_out[0], dec_kept, cnt, lost);
+}
+
+static void decode_test_partial(void)
+{
+	/* not wrapped yet */
+	dec_round_trip(0, 100, 0);
+}
+
+static void decode_test_wrap(void)
+{
+	/* the ring and the time stamps wrap */
+	dec_round_trip(0, 3 * DEC_BUF_SIZE / sizeof(OS_TraceRec_t) + 5, 1);
+}
+
+static void decode_test_head_wrap(void)
+{
+	/* the head counter wraps past 2^32 and ends below recCount */
+	dec_round_trip(0u - DEC_REC_COUNT / 2, DEC_REC_COUNT, 1);
+}
+
+static void decode_test_chrome(void)
+{
+	OS_TraceRing_t r;
+	uint32_t cnt, i, switches = 0, isr = 0;
+	char cmd[512];
+	unsigned int n1, n2;
+	FILE *p;
+
+	cnt = dec_fill(&r, 0, 1000, 0, dec_kept);
+	for (i = 0; i < cnt; i++) {
+		switches += dec_kept[i].type == OS_TRACE_EV_SWITCH_IN;
+		isr += dec_kept[i].type == OS_TRACE_EV_ISR_ENTER;
+	}
+	dec_save(&r);
+
+	snprintf(cmd, sizeof(cmd), "-c %s/trace.json", dec_dir);
+	dec_run(cmd, "trace.bin", dec_out[0]);
+
+	/* the file must load, with one slice per switch and per interrupt */
+	snprintf(cmd, sizeof(cmd), DEC_PYTHON " -c 'import json, sys\n"
+		 "e = json.load(open(sys.argv[1]))[\"traceEvents\"]\n"
+		 "print(len([x for x in e if x[\"ph\"] == \"B\" and x[\"tid\"] == 0]),"
+		 " len([x for x in e if x[\"ph\"] == \"B\" and x[\"tid\"] == 1]))'"
+		 " %s/trace.json", dec_dir);
+	p = popen(cmd, "r");
+	TEST_ASSERT(p != NULL);
+	TEST_ASSERT(fscanf(p, "%u %u", &n1, &n2) == 2);
+	TEST_ASSERT(pclose(p) == 0);
+	TEST_ASSERT_EQ(n1, switches);
+	TEST_ASSERT_EQ(n2, isr);
+}
+
+static void dec_cleanup(void)
+{
+	char cmd[64];
+
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", dec_dir);
+	system(cmd);
+}
+
+void os_trace_decode_test(void)
+{
+	if (!dec_has_python()) {
+		printf("%-40s skipped, no " DEC_PYTHON "\n", "os_trace_decode_test");
+		return;
+	}
+	TEST_ASSERT(mkdtemp(dec_dir) != NULL);
+	TEST_RUN(decode_test_partial);
+	TEST_RUN(decode_test_wrap);
+	TEST_RUN(decode_test_head_wrap);
+	TEST_RUN(decode_test_chrome);
+	dec_cleanup();
+}
@@ -0,0 +1,197 @@
+/*
+ * Scheduler trace ring: layout, wrap of the ring and of the head counter,
+ * the task table, and lock free writers racing for slots.
+ */
+
+#include <string.h>
+#include <pthread.h>
+
+#include "test.h"
+#include "os_trace_ring.h"
+#include "os_trace_test.h"
+
+#define RING_BUF_SIZE	(64 * 1024)
+
+static uint32_t ring_buf[RING_BUF_SIZE / 4];
+
+static void ring_test_init(void)
+{
+	OS_TraceRing_t r;
+	uint32_t off, avail;
+
+	off = sizeof(OS_TraceHdr_t) + OS_TRACE_TASK_MAX * sizeof(OS_TraceTask_t);
+
+	TEST_ASSERT(OS_TraceRingInit(&r, NULL, sizeof(ring_buf), 0, 1) != 0);
+	TEST_ASSERT(OS_TraceRingInit(&r, (uint8_t *)ring_buf + 1,
+				     sizeof(ring_buf) - 4, 0, 1) != 0);
+	TEST_ASSERT(OS_TraceRingInit(&r, ring_buf,
+				     off + (OS_TRACE_REC_MIN - 1) * sizeof(OS_TraceRec_t),
+				     0, 1) != 0);
+	TEST_ASSERT(OS_TraceRingInit(&r, ring_buf,
+				     off + OS_TRACE_REC_MIN * sizeof(OS_TraceRec_t),
+				     0, 1) == 0);
+	TEST_ASSERT_EQ(r.hdr->recCount, OS_TRACE_REC_MIN);
+
+	/* the rest of the buffer is rounded down to a power of 2 of records */
+	memset(ring_buf, 0xa5, sizeof(ring_buf));
+	TEST_ASSERT(OS_TraceRingInit(&r, ring_buf, sizeof(ring_buf),
+				     OS_TRACE_F_SCHED, 1000000) == 0);
+	avail = (sizeof(ring_buf) - off) / sizeof(OS_TraceRec_t);
+	TEST_ASSERT((r.hdr->recCount & (r.hdr->recCount - 1)) == 0);
+	TEST_ASSERT(r.hdr->recCount <= avail && r.hdr->recCount * 2 > avail);
+	TEST_ASSERT_EQ(r.mask, r.hdr->recCount - 1);
+	TEST_ASSERT(OS_TraceRingSize(&r) <= sizeof(ring_buf));
+
+	TEST_ASSERT_EQ(r.hdr->magic, OS_TRACE_MAGIC);
+	TEST_ASSERT_EQ(r.hdr->version, OS_TRACE_VERSION);
+	TEST_ASSERT_EQ(r.hdr->flags, OS_TRACE_F_SCHED);
+	TEST_ASSERT_EQ(r.hdr->clockHz, 1000000);
+	TEST_ASSERT_EQ(r.hdr->head, 0);
+	TEST_ASSERT_EQ(r.hdr->recOffset, off);
+	TEST_ASSERT_EQ(r.hdr->taskOffset, sizeof(OS_TraceHdr_t));
+	TEST_ASSERT_EQ(r.hdr->taskCount, OS_TRACE_TASK_MAX);
+	TEST_ASSERT_EQ(r.hdr->taskSize, sizeof(OS_TraceTask_t));
+	TEST_ASSERT_EQ(r.task[0].num, 0);
+	TEST_ASSERT_EQ(r.rec[r.mask].type, OS_TRACE_EV_NONE);
+
+	/* the decoder relies on these sizes */
+	TEST_ASSERT_EQ(sizeof(OS_TraceHdr_t), 32);
+	TEST_ASSERT_EQ(sizeof(OS_TraceRec_t), 8);
+	TEST_ASSERT_EQ(sizeof(OS_TraceTask_t), 20);
+}
+
+/* every slot holds the last record written to it */
+static void ring_check(OS_TraceRing_t *r, uint32_t start, uint32_t n)
+{
+	uint32_t idx, cnt = r->hdr->recCount;
+
+	TEST_ASSERT_EQ(r->hdr->head, (uint32_t)(start + n));
+	for (idx = start + n - (n < cnt ? n : cnt); idx != start + n; idx++) {
+		OS_TraceRec_t *rec = &r->rec[idx & r->mask];
+
+		TEST_ASSERT_EQ(rec->ts, idx * 3);
+		TEST_ASSERT_EQ(rec->type, OS_TRACE_EV_MARK);
+		TEST_ASSERT_EQ(rec->arg, (uint16_t)idx);
+	}
+}
+
+static void ring_test_wrap(void)
+{
+	OS_TraceRing_t r;
+	uint32_t i, n;
+
+	TEST_ASSERT(OS_TraceRingInit(&r, ring_buf, sizeof(ring_buf), 0, 1) == 0);
+	n = r.hdr->recCount * 3 + 5;
+	for (i = 0; i < n; i++)
+		OS_TraceRingPut(&r, i * 3, OS_TRACE_EV_MARK, 0, i);
+	ring_check(&r, 0, n);
+
+	/* the head counter itself wraps after 2^32 records */
+	TEST_ASSERT(OS_TraceRingInit(&r, ring_buf, sizeof(ring_buf), 0, 1) == 0);
+	r.hdr->head = 0xffffffffu - r.hdr->recCount / 2;
+	n = r.hdr->recCount;
+	for (i = 0; i < n; i++) {
+		uint32_t idx = 0xffffffffu - r.hdr->recCount / 2 + i;
+		OS_TraceRingPut(&r, idx * 3, OS_TRACE_EV_MARK, 0, idx);
+	}
+	ring_check(&r, 0xffffffffu - r.hdr->recCount / 2, n);
+	TEST_ASSERT(r.hdr->head < r.hdr->recCount);
+}
+
+static void ring_test_task(void)
+{
+	OS_TraceRing_t r;
+	char name[32];
+	int i;
+
+	TEST_ASSERT(OS_TraceRingInit(&r, ring_buf, sizeof(ring_buf), 0, 1) == 0);
+	for (i = 1; i <= OS_TRACE_TASK_MAX; i++) {
+		snprintf(name, sizeof(name), "task%d", i);
+		TEST_ASSERT(OS_TraceRingTaskSet(&r, i, i % 8, name) == 0);
+	}
+	TEST_ASSERT(OS_TraceRingTaskSet(&r, OS_TRACE_TASK_MAX + 1, 0, "x") == -1);
+
+	/* an existing task is updated in place */
+	TEST_ASSERT(OS_TraceRingTaskSet(&r, 7, 5, "a_name_longer_than_the_field") == 0);
+	TEST_ASSERT_EQ(r.task[6].num, 7);
+	TEST_ASSERT_EQ(r.task[6].prio, 5);
+	TEST_ASSERT_EQ(strlen(r.task[6].name), OS_TRACE_NAME_LEN - 1);
+	TEST_ASSERT(strncmp(r.task[6].name, "a_name_longer_than_the_field",
+			    OS_TRACE_NAME_LEN - 1) == 0);
+
+	/* a freed entry is reused */
+	r.task[3].num = 0;
+	TEST_ASSERT(OS_TraceRingTaskSet(&r, 100, 1, "new") == 0);
+	TEST_ASSERT_EQ(r.task[3].num, 100);
+	TEST_ASSERT(strcmp(r.task[3].name, "new") == 0);
+}
+
+#define RING_WRITERS	4
+#define RING_PUTS	200000
+
+static OS_TraceRing_t ring_mt;
+
+static void *ring_writer(void *arg)
+{
+	uint16_t id = (uintptr_t)arg;
+	uint32_t i;
+
+	for (i = 0; i < RING_PUTS; i++)
+		OS_TraceRingPut(&ring_mt, i, OS_TRACE_EV_MARK, 0, id);
+	return NULL;
+}
+
+static void ring_test_writers(void)
+{
+	pthread_t th[RING_WRITERS];
+	uint8_t *seen[RING_WRITERS];
+	uint32_t i;
+
+	TEST_ASSERT(OS_TraceRingInit(&ring_mt, ring_buf, sizeof(ring_buf), 0, 1) == 0);
+	for (i = 0; i < RING_WRITERS; i++)
+		pthread_create(&th[i], NULL, ring_writer, (void *)(uintptr_t)i);
+	for (i = 0; i < RING_WRITERS; i++)
+		pthread_join(th[i], NULL);
+
+	/* no record lost or claimed twice, no slot left half written */
+	TEST_ASSERT_EQ(ring_mt.hdr->head, RING_WRITERS * RING_PUTS);
+	for (i = 0; i < RING_WRITERS; i++)
+		seen[i] = calloc(RING_PUTS, 1);
+	for (i = 0; i <= ring_mt.mask; i++) {
+		OS_TraceRec_t *rec = &ring_mt.rec[i];
+
+		TEST_ASSERT_EQ(rec->type, OS_TRACE_EV_MARK);
+		TEST_ASSERT(rec->arg < RING_WRITERS && rec->ts < RING_PUTS);
+		TEST_ASSERT_EQ(seen[rec->arg][rec->ts], 0);
+		seen[rec->arg][rec->ts] = 1;
+	}
+	for (i = 0; i < RING_WRITERS; i++)
+		free(seen[i]);
+}
+
+static void ring_bench(void)
+{
+	OS_TraceRing_t r;
+	uint64_t t;
+	uint32_t i, n = 20 * 1000 * 1000;
+
+	OS_TraceRingInit(&r, ring_buf, sizeof(ring_buf), 0, 1);
+	t = test_now_ns();
+	for (i = 0; i < n; i++)
+		OS_TraceRingPut(&r, i, OS_TRACE_EV_SWITCH_IN, 3, i);
+	t = test_now_ns() - t;
+	printf("\nring put %.1f ns/record\n", (double)t / n);
+}
+
+void os_trace_ring_test(void)
+{
+	TEST_RUN(ring_test_init);
+	TEST_RUN(ring_test_wrap);
+	TEST_RUN(ring_test_task);
+	TEST_RUN(ring_test_writers);
+}
+
+void os_trace_ring_bench(void)
+{
+	ring_bench();
+}
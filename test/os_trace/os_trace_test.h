@@ -0,0 +1,8 @@
+#ifndef _OS_TRACE_TEST_H_
+#define _OS_TRACE_TEST_H_
+
+void os_trace_ring_test(void);
+void os_trace_ring_bench(void);
+void os_trace_decode_test(void);
+
+#endif /* _OS_TRACE_TEST_H_ */
@@ -0,0 +1,193 @@
+/*
+ * snd_pcm_read()/snd_pcm_write() over a simulated sound card: random sized
+ * calls must see a byte-exact stream on both paths, across partial reads,
+ * half buffers that are not a power of two, capture underruns and flush.
+ */
+
+#include <string.h>
+#include "test.h"
+#include "pcm_test.h"
+#include "audio/pcm/audio_pcm.h"
+
+/* playback pattern has no zero byte, so padding and silence stand out */
+#define PLAY_BYTE(seq)	((uint8_t)((seq) % 251 + 1))
+
+/* simulated card, transfers whole half buffers like the I2S driver */
+static struct {
+	uint32_t half;
+	uint32_t rd_seq;	/* next capture byte */
+	uint32_t wr_seq;	/* next playback byte expected */
+	uint32_t underrun;	/* capture calls left to fail */
+	uint32_t silence;	/* zero bytes played, only while flushing */
+	int flushing;
+} card;
+
+int HAL_SndCard_PcmRead(Snd_Card_Num card_num, uint8_t *buf, uint32_t size)
+{
+	uint32_t i;
+
+	TEST_ASSERT(size % card.half == 0);
+	if (card.underrun) {
+		card.underrun--;
+		return 0;
+	}
+	for (i = 0; i < size; i++)
+		buf[i] = (uint8_t)(card.rd_seq++ * 7);
+	return size;
+}
+
+int HAL_SndCard_PcmWrite(Snd_Card_Num card_num, uint8_t *buf, uint32_t size)
+{
+	uint32_t n = size / card.half * card.half, i;
+
+	for (i = 0; i < n; i++) {
+		if (buf[i] == 0) {
+			TEST_ASSERT(card.flushing);
+			card.silence++;
+			continue;
+		}
+		TEST_ASSERT(card.silence == 0);
+		TEST_ASSERT_EQ(buf[i], PLAY_BYTE(card.wr_seq));
+		card.wr_seq++;
+	}
+	return n;
+}
+
+HAL_Status HAL_SndCard_Open(Snd_Card_Num card_num, Audio_Stream_Dir dir,
+                            struct pcm_config *config)
+{
+	return HAL_OK;
+}
+
+HAL_Status HAL_SndCard_Close(Snd_Card_Num card_num, Audio_Stream_Dir dir)
+{
+	return HAL_OK;
+}
+
+uint8_t HAL_SndCard_GetCardNums(void)
+{
+	return 1;
+}
+
+void HAL_SndCard_GetAllCardNum(uint8_t *card_num)
+{
+	card_num[0] = SND_CARD_0;
+}
+
+uint32_t pcm_config_to_frames(struct pcm_config *config)
+{
+	return config->period_size * config->period_count;
+}
+
+uint32_t pcm_frames_to_bytes(struct pcm_config *config, unsigned int frames)
+{
+	return frames * config->channels * 2;
+}
+
+static void pcm_open(uint32_t period_size, uint32_t channels)
+{
+	struct pcm_config cfg;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.rate = 16000;
+	cfg.channels = channels;
+	cfg.period_size = period_size;
+	cfg.period_count = 2;
+	memset(&card, 0, sizeof(card));
+	card.half = period_size * channels * 2;
+	TEST_ASSERT_EQ(snd_pcm_open(SND_CARD_0, PCM_IN, &cfg), 0);
+	TEST_ASSERT_EQ(snd_pcm_open(SND_CARD_0, PCM_OUT, &cfg), 0);
+}
+
+static void pcm_close(void)
+{
+	snd_pcm_close(SND_CARD_0, PCM_IN);
+	snd_pcm_close(SND_CARD_0, PCM_OUT);
+}
+
+static const uint32_t pcm_periods[] = { 160, 320, 512, 1024 };
+
+/* random sized reads, including ones larger than a half buffer */
+static void audio_pcm_test_read(void)
+{
+	static uint8_t buf[10000];
+	uint32_t seed = 11, got, n, i;
+	int k, it;
+
+	for (k = 0; k < sizeof(pcm_periods) / sizeof(pcm_periods[0]); k++) {
+		pcm_open(pcm_periods[k], 1);
+		for (got = 0, it = 0; it < 20000; it++) {
+			n = test_rand(&seed) % 5000 + 1;
+			if (test_rand(&seed) & 1)
+				n = n % card.half + 1;	/* partial */
+			TEST_ASSERT_EQ(snd_pcm_read(SND_CARD_0, buf, n), n);
+			for (i = 0; i < n; i++, got++)
+				TEST_ASSERT_EQ(buf[i], (uint8_t)(got * 7));
+		}
+		pcm_close();
+	}
+}
+
+/* capture underruns return what was delivered, the stream stays intact */
+static void audio_pcm_test_underrun(void)
+{
+	static uint8_t buf[4000];
+	uint32_t seed = 3, got = 0, n, i;
+	int ret, it, short_reads = 0;
+
+	pcm_open(320, 1);
+	for (it = 0; it < 2000; it++) {
+		n = test_rand(&seed) % 3000 + 1;
+		if (test_rand(&seed) % 128 == 0)
+			card.underrun = 1;
+		ret = snd_pcm_read(SND_CARD_0, buf, n);
+		TEST_ASSERT(ret >= 0 && ret <= n);
+		if (ret < n) {
+			short_reads++;
+			card.underrun = 0;
+		}
+		for (i = 0; i < ret; i++, got++)
+			TEST_ASSERT_EQ(buf[i], (uint8_t)(got * 7));
+	}
+	pcm_close();
+	TEST_ASSERT(short_reads > 0);
+}
+
+/* random sized writes, then flush pads the tail and plays silence */
+static void audio_pcm_test_write(void)
+{
+	static uint8_t buf[10000];
+	uint32_t seed = 17, sent, n, i, tail;
+	int k, it;
+
+	for (k = 0; k < sizeof(pcm_periods) / sizeof(pcm_periods[0]); k++) {
+		pcm_open(pcm_periods[k], 2);
+		for (sent = 0, it = 0; it < 20000; it++) {
+			n = test_rand(&seed) % 5000 + 1;
+			if (test_rand(&seed) & 1)
+				n = n % card.half + 1;
+			for (i = 0; i < n; i++)
+				buf[i] = PLAY_BYTE(sent + i);
+			TEST_ASSERT_EQ(snd_pcm_write(SND_CARD_0, buf, n), n);
+			sent += n;
+			/* less than one half buffer is ever held back */
+			TEST_ASSERT(sent - card.wr_seq < card.half);
+		}
+
+		tail = sent - card.wr_seq;
+		card.flushing = 1;
+		TEST_ASSERT_EQ(snd_pcm_flush(SND_CARD_0), 0);
+		TEST_ASSERT_EQ(card.wr_seq, sent);
+		TEST_ASSERT_EQ(card.silence, (tail ? card.half - tail : 0) + 2 * card.half);
+		pcm_close();
+	}
+}
+
+void audio_pcm_test(void)
+{
+	TEST_ASSERT_EQ(snd_pcm_init(), 0);
+	TEST_RUN(audio_pcm_test_read);
+	TEST_RUN(audio_pcm_test_underrun);
+	TEST_RUN(audio_pcm_test_write);
+	snd_pcm_deinit();
+}
@@ -0,0 +1,13 @@
+/*
+ * PCM host tests
+ */
+
+#include "test.h"
+#include "pcm_test.h"
+
+int main(int argc, char **argv)
+{
+	pcm_ring_test();
+	audio_pcm_test();
+	return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * pcm_ring.h: byte continuity across the end of the buffer and across the
+ * 32-bit wrap of the free-running counters, span bounds, and one producer
+ * and one consumer thread without a lock.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include "test.h"
+#include "pcm_test.h"
+#include "pcm_ring.h"
+
+#define RING_SIZE	1024
+
+static uint8_t ring_buf[RING_SIZE];
+
+static void ring_check_spans(struct pcm_ring *r)
+{
+	uint8_t *p;
+	uint32_t n;
+
+	TEST_ASSERT(pcm_ring_avail(r) <= pcm_ring_size(r));
+	TEST_ASSERT_EQ(pcm_ring_avail(r) + pcm_ring_space(r), pcm_ring_size(r));
+	n = pcm_ring_read_span(r, &p);
+	TEST_ASSERT(n <= pcm_ring_avail(r));
+	TEST_ASSERT(p >= r->buf && p + n <= r->buf + pcm_ring_size(r));
+	n = pcm_ring_write_span(r, &p);
+	TEST_ASSERT(n <= pcm_ring_space(r));
+	TEST_ASSERT(p >= r->buf && p + n <= r->buf + pcm_ring_size(r));
+}
+
+/* random sized copy in/out and in-place span use, starting near 2^32 */
+static void pcm_ring_test_wrap(void)
+{
+	struct pcm_ring r;
+	uint8_t tmp[RING_SIZE * 2], *p;
+	uint32_t wr_seq = 0, rd_seq = 0, seed = 5, n, len, i;
+	int it;
+
+	TEST_ASSERT_EQ(pcm_ring_roundup(640), 1024);
+	TEST_ASSERT_EQ(pcm_ring_roundup(1024), 1024);
+
+	pcm_ring_init(&r, ring_buf, RING_SIZE);
+	r.head = r.tail = 0xFFFFFFFFu - 3000;
+
+	for (it = 0; it < 200000; it++) {
+		len = test_rand(&seed) % (RING_SIZE + 200);
+		if (test_rand(&seed) & 1) {
+			if (test_rand(&seed) & 1) {
+				for (i = 0; i < len; i++)
+					tmp[i] = (uint8_t)((wr_seq + i) * 7);
+				n = pcm_ring_write(&r, tmp, len);
+				TEST_ASSERT(n == len || pcm_ring_space(&r) == 0);
+			} else {
+				n = pcm_ring_write_span(&r, &p);
+				if (n > len)
+					n = len;
+				for (i = 0; i < n; i++)
+					p[i] = (uint8_t)((wr_seq + i) * 7);
+				pcm_ring_write_commit(&r, n);
+			}
+			wr_seq += n;
+		} else {
+			if (test_rand(&seed) & 1) {
+				n = pcm_ring_read(&r, tmp, len);
+				TEST_ASSERT(n == len || pcm_ring_avail(&r) == 0);
+				p = tmp;
+			} else {
+				n = pcm_ring_read_span(&r, &p);
+				if (n > len)
+					n = len;
+			}
+			for (i = 0; i < n; i++)
+				TEST_ASSERT_EQ(p[i], (uint8_t)((rd_seq + i) * 7));
+			if (p != tmp)
+				pcm_ring_read_commit(&r, n);
+			rd_seq += n;
+		}
+		TEST_ASSERT_EQ(pcm_ring_avail(&r), wr_seq - rd_seq);
+		ring_check_spans(&r);
+	}
+	/* the counters went through 2^32 */
+	TEST_ASSERT(r.tail < 0xFFFFFFFFu - 3000);
+}
+
+/* full ring: no space, one span of the whole buffer after a reset */
+static void pcm_ring_test_full(void)
+{
+	struct pcm_ring r;
+	uint8_t tmp[RING_SIZE], *p;
+
+	pcm_ring_init(&r, ring_buf, RING_SIZE);
+	memset(tmp, 0x5a, sizeof(tmp));
+	TEST_ASSERT_EQ(pcm_ring_write(&r, tmp, 100), 100);
+	TEST_ASSERT_EQ(pcm_ring_read(&r, tmp, 100), 100);
+	TEST_ASSERT_EQ(pcm_ring_write(&r, tmp, RING_SIZE), RING_SIZE);
+	TEST_ASSERT_EQ(pcm_ring_space(&r), 0);
+	TEST_ASSERT_EQ(pcm_ring_write(&r, tmp, 1), 0);
+	TEST_ASSERT_EQ(pcm_ring_write_span(&r, &p), 0);
+	TEST_ASSERT_EQ(pcm_ring_read(&r, tmp, RING_SIZE), RING_SIZE);
+	TEST_ASSERT_EQ(pcm_ring_read_span(&r, &p), 0);
+
+	pcm_ring_reset(&r);
+	TEST_ASSERT_EQ(pcm_ring_write_span(&r, &p), RING_SIZE);
+	TEST_ASSERT(p == ring_buf);
+}
+
+#define SPSC_BYTES	(64u << 20)
+
+static struct pcm_ring spsc_ring;
+
+static void *spsc_producer(void *arg)
+{
+	uint32_t seq = 0, n, i;
+	uint8_t *p;
+
+	while (seq < SPSC_BYTES) {
+		n = pcm_ring_write_span(&spsc_ring, &p);
+		if (n == 0) {
+			sched_yield();
+			continue;
+		}
+		if (n > SPSC_BYTES - seq)
+			n = SPSC_BYTES - seq;
+		if (n > 300)
+			n = 300;
+		for (i = 0; i < n; i++)
+			p[i] = (uint8_t)((seq + i) * 13);
+		pcm_ring_write_commit(&spsc_ring, n);
+		seq += n;
+	}
+	return NULL;
+}
+
+/* one writer thread and one reader, lock free */
+static void pcm_ring_test_spsc(void)
+{
+	uint32_t seq = 0, n, i;
+	pthread_t th;
+	uint8_t *p;
+
+	pcm_ring_init(&spsc_ring, ring_buf, RING_SIZE);
+	TEST_ASSERT_EQ(pthread_create(&th, NULL, spsc_producer, NULL), 0);
+	while (seq < SPSC_BYTES) {
+		n = pcm_ring_read_span(&spsc_ring, &p);
+		if (n == 0) {
+			sched_yield();
+			continue;
+		}
+		for (i = 0; i < n; i++) {
+			if (p[i] != (uint8_t)((seq + i) * 13)) {
+				printf("byte %u: %u\n", seq + i, p[i]);
+				TEST_ASSERT(0);
+			}
+		}
+		pcm_ring_read_commit(&spsc_ring, n);
+		seq += n;
+	}
+	pthread_join(th, NULL);
+	TEST_ASSERT_EQ(pcm_ring_avail(&spsc_ring), 0);
+}
+
+void pcm_ring_test(void)
+{
+	TEST_RUN(pcm_ring_test_wrap);
+	TEST_RUN(pcm_ring_test_full);
+	TEST_RUN(pcm_ring_test_spsc);
+}
@@ -0,0 +1,7 @@
+#ifndef _PCM_TEST_H_
+#define _PCM_TEST_H_
+
+void pcm_ring_test(void);
+void audio_pcm_test(void);
+
+#endif /* _PCM_TEST_H_ */
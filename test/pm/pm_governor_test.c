@@ -0,0 +1,270 @@
+/*
+ * Idle and cpufreq governor decisions on synthetic idle traces.
+ *
+ * pm_governor.c depends on nothing but its arguments, so the traces are fed
+ * straight into it: the expected idle time the timer list would report and
+ * the idle time actually measured when the cpu woke up. The summary at the
+ * end compares the states picked with the ones a timer-only selection would
+ * have picked, counting the periods spent in a state deeper than the idle
+ * time paid for (too deep) or shallower than it allowed (too shallow).
+ */
+
+#include "pm/pm_idle.h"
+#include <string.h>
+#include "test.h"
+
+#define NR_STATES	3
+
+static const struct pm_idle_state gov_states_init[NR_STATES] = {
+	{ "wfi",  0,   0    },
+	{ "hosc", 10,  1000 },
+	{ "deep", 400, 5000 },
+};
+
+static struct pm_idle_state gov_states[NR_STATES];
+
+static const uint32_t gov_freq[] = {
+	48000, 64000, 96000, 120000, 160000, 240000
+};
+
+#define NR_FREQ	(sizeof(gov_freq) / sizeof(gov_freq[0]))
+
+static void gov_reset_states(void)
+{
+	memcpy(gov_states, gov_states_init, sizeof(gov_states));
+}
+
+/* the deepest state the measured idle time would have paid for */
+static int gov_ideal(uint32_t measured_us)
+{
+	return pm_idle_select(gov_states, NR_STATES, measured_us, UINT32_MAX);
+}
+
+static void gov_test_periodic_irq(void)
+{
+	struct pm_idle_predictor p;
+	uint32_t seed = 0x1234, pred = 0;
+	int i, s, sel[NR_STATES] = { 0 };
+
+	gov_reset_states();
+	pm_idle_predictor_init(&p);
+
+	/* the timer list says 100 ms, but an irq arrives every ~3 ms */
+	for (i = 0; i < 200; i++) {
+		pred = pm_idle_predict(&p, 100000);
+		TEST_ASSERT(pred <= 100000);
+		s = pm_idle_select(gov_states, NR_STATES, pred, UINT32_MAX);
+		if (i >= 20)
+			sel[s]++;
+		pm_idle_reflect(&p, 3000 + test_rand(&seed) % 100);
+	}
+	TEST_ASSERT(pred >= 2900 && pred <= 3100);
+	TEST_ASSERT_EQ(sel[2], 0);
+	TEST_ASSERT_EQ(sel[1], 180);
+}
+
+static void gov_test_honest_timer(void)
+{
+	struct pm_idle_predictor p;
+	int i, s;
+
+	gov_reset_states();
+	pm_idle_predictor_init(&p);
+
+	for (i = 0; i < 100; i++) {
+		s = pm_idle_select(gov_states, NR_STATES,
+				   pm_idle_predict(&p, 50000), UINT32_MAX);
+		TEST_ASSERT_EQ(s, 2);
+		pm_idle_reflect(&p, 50000);
+	}
+	TEST_ASSERT_EQ(pm_idle_predict(&p, 50000), 50000);
+}
+
+static void gov_test_irregular(void)
+{
+	struct pm_idle_predictor p;
+	uint32_t seed = 0x5678, m;
+	uint64_t corr = 0, pred = 0;
+	int i;
+
+	pm_idle_predictor_init(&p);
+
+	/* half of the 20 ms periods end early at a random point */
+	for (i = 0; i < 300; i++) {
+		m = pm_idle_predict(&p, 20000);
+		if (i >= 100) {
+			pred += m;
+			corr += p.correction[p.bucket];
+		}
+		m = (test_rand(&seed) & 1) ? 20000 :
+		    2000 + test_rand(&seed) % 8000;
+		pm_idle_reflect(&p, m);
+	}
+	/*
+	 * No steady pattern, the correction factor follows the average ratio,
+	 * about (20 + 6) / 2 / 20.
+	 */
+	corr /= 200;
+	pred /= 200;
+	TEST_ASSERT(corr > PM_IDLE_RESOLUTION * 55 / 100);
+	TEST_ASSERT(corr < PM_IDLE_RESOLUTION * 75 / 100);
+	TEST_ASSERT(pred > 11000 && pred < 15000);
+
+	/* other magnitudes keep their own factor */
+	TEST_ASSERT_EQ(p.correction[0], PM_IDLE_RESOLUTION);
+}
+
+static void gov_test_select(void)
+{
+	gov_reset_states();
+
+	TEST_ASSERT_EQ(pm_idle_select(gov_states, NR_STATES, 500, UINT32_MAX), 0);
+	TEST_ASSERT_EQ(pm_idle_select(gov_states, NR_STATES, 1000, UINT32_MAX), 1);
+	TEST_ASSERT_EQ(pm_idle_select(gov_states, NR_STATES, 4999, UINT32_MAX), 1);
+	TEST_ASSERT_EQ(pm_idle_select(gov_states, NR_STATES, 5000, UINT32_MAX), 2);
+
+	/* latency constraint */
+	TEST_ASSERT_EQ(pm_idle_select(gov_states, NR_STATES, 50000, 400), 2);
+	TEST_ASSERT_EQ(pm_idle_select(gov_states, NR_STATES, 50000, 100), 1);
+	TEST_ASSERT_EQ(pm_idle_select(gov_states, NR_STATES, 50000, 5), 0);
+
+	/* a disabled state is skipped, deeper ones still count */
+	gov_states[1].disable = 1;
+	TEST_ASSERT_EQ(pm_idle_select(gov_states, NR_STATES, 50000, UINT32_MAX), 2);
+	TEST_ASSERT_EQ(pm_idle_select(gov_states, NR_STATES, 3000, UINT32_MAX), 0);
+	gov_states[2].disable = 1;
+	TEST_ASSERT_EQ(pm_idle_select(gov_states, NR_STATES, 50000, UINT32_MAX), 0);
+}
+
+static void gov_test_latency(void)
+{
+	struct pm_idle_state s = { "x", 10, 0 };
+	uint32_t last;
+	int i;
+
+	/* rises quickly */
+	pm_idle_update_latency(&s, 40);
+	TEST_ASSERT(s.exit_latency >= 25);
+	for (i = 0; i < 4; i++)
+		pm_idle_update_latency(&s, 40);
+	TEST_ASSERT(s.exit_latency >= 38 && s.exit_latency <= 40);
+
+	/* decays slowly, never below the measured cost */
+	pm_idle_update_latency(&s, 12);
+	TEST_ASSERT(s.exit_latency >= 34);
+	for (i = 0; i < 100; i++) {
+		last = s.exit_latency;
+		pm_idle_update_latency(&s, 12);
+		TEST_ASSERT(s.exit_latency <= last);
+		TEST_ASSERT(s.exit_latency >= 12);
+	}
+	TEST_ASSERT(s.exit_latency <= 20);
+}
+
+static void gov_test_cpufreq(void)
+{
+	struct pm_cpufreq_policy pol = { gov_freq, NR_FREQ, NR_FREQ - 1, 80, 20 };
+	static const struct {
+		uint8_t load;
+		uint8_t idx;
+	} trace[] = {
+		{ 95, 5 },	/* busy, stay at the top */
+		{ 10, 0 },	/* mostly idle, lowest clock keeping 60% load */
+		{ 70, 0 },	/* between the thresholds, keep */
+		{ 85, 5 },	/* above up_threshold, jump to the top */
+		{ 30, 3 },	/* 240 MHz * 30% needs 120 MHz at 60% */
+		{ 0,  0 },
+		{ 100, 5 },
+	};
+	int i, idx;
+
+	for (i = 0; i < sizeof(trace) / sizeof(trace[0]); i++) {
+		idx = pm_cpufreq_target(&pol, trace[i].load * 500, 50000, 0);
+		TEST_ASSERT_EQ(idx, trace[i].idx);
+		pol.cur = idx;
+	}
+
+	/* QoS floor */
+	pol.cur = 0;
+	TEST_ASSERT_EQ(gov_freq[pm_cpufreq_target(&pol, 0, 50000, 100000)], 120000);
+	TEST_ASSERT_EQ(gov_freq[pm_cpufreq_target(&pol, 0, 50000, 120000)], 120000);
+	TEST_ASSERT_EQ(pm_cpufreq_target(&pol, 0, 50000, 1000000), NR_FREQ - 1);
+}
+
+struct gov_trace {
+	const char *name;
+	uint32_t expected;
+	uint32_t (*measured)(int i, uint32_t *seed);
+};
+
+static uint32_t gov_irq_3ms(int i, uint32_t *seed)
+{
+	return 3000 + test_rand(seed) % 100;
+}
+
+static uint32_t gov_timer_50ms(int i, uint32_t *seed)
+{
+	return 50000;
+}
+
+static uint32_t gov_mixed(int i, uint32_t *seed)
+{
+	return (test_rand(seed) & 1) ? 20000 : 2000 + test_rand(seed) % 8000;
+}
+
+static uint32_t gov_burst(int i, uint32_t *seed)
+{
+	/* irq bursts of 0.5 ms wakeups, then quiet until the timer */
+	return (i % 50) < 40 ? 500 : 30000;
+}
+
+static const struct gov_trace gov_traces[] = {
+	{ "irq every 3ms",  100000, gov_irq_3ms },
+	{ "timer 50ms",     50000,  gov_timer_50ms },
+	{ "mixed 20ms",     20000,  gov_mixed },
+	{ "irq bursts",     30000,  gov_burst },
+};
+
+static void gov_bench(void)
+{
+	struct pm_idle_predictor p;
+	uint32_t seed, m, pred;
+	int i, t, s, ideal, naive;
+	int deep[2], shallow[2];
+
+	gov_reset_states();
+	printf("\n%-14s %18s %18s\n", "trace", "governor deep/shal",
+	       "timer deep/shal");
+	for (t = 0; t < sizeof(gov_traces) / sizeof(gov_traces[0]); t++) {
+		pm_idle_predictor_init(&p);
+		seed = 0x9abc;
+		deep[0] = deep[1] = shallow[0] = shallow[1] = 0;
+		for (i = 0; i < 1000; i++) {
+			pred = pm_idle_predict(&p, gov_traces[t].expected);
+			s = pm_idle_select(gov_states, NR_STATES, pred, UINT32_MAX);
+			naive = pm_idle_select(gov_states, NR_STATES,
+					       gov_traces[t].expected, UINT32_MAX);
+			m = gov_traces[t].measured(i, &seed);
+			pm_idle_reflect(&p, m);
+			ideal = gov_ideal(m);
+			deep[0] += s > ideal;
+			shallow[0] += s < ideal;
+			deep[1] += naive > ideal;
+			shallow[1] += naive < ideal;
+		}
+		printf("%-14s %8d/%-9d %8d/%-9d\n", gov_traces[t].name,
+		       deep[0], shallow[0], deep[1], shallow[1]);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	TEST_RUN(gov_test_periodic_irq);
+	TEST_RUN(gov_test_honest_timer);
+	TEST_RUN(gov_test_irregular);
+	TEST_RUN(gov_test_select);
+	TEST_RUN(gov_test_latency);
+	TEST_RUN(gov_test_cpufreq);
+	gov_bench();
+	return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * Polyphase resampler: tone quality, output length and stream state across
+ * random block sizes, then a samples/sec benchmark for the rates used by
+ * the card stream.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "test.h"
+#include "audio/resample/audio_resample.h"
+
+#ifndef M_PI
+#define M_PI		3.14159265358979323846
+#endif
+
+struct rs_result {
+	uint32_t out_frames;
+	double snr;		/* dB, tone against the best fitting sine */
+	double gain;		/* dB */
+	double msps;		/* input Msamples/s */
+};
+
+static void rs_run(uint32_t fi, uint32_t fo, int ch, double f, int secs,
+                   struct rs_result *r)
+{
+	uint32_t nin = fi * secs, done = 0, len, seed = 1;
+	double sxx = 0, sxy = 0, syy = 0, sxo = 0, syo = 0, e = 0;
+	double X, Y, O, det, A, B, amp;
+	audio_resample_t *rs;
+	int16_t *in, *out;
+	uint64_t t;
+	uint32_t k, k0, k1;
+	int c;
+
+	in = malloc(nin * ch * sizeof(int16_t));
+	TEST_ASSERT(in != NULL);
+	for (k = 0; k < nin; k++)
+		for (c = 0; c < ch; c++)
+			in[k * ch + c] = (int16_t)lrint(20000 * sin(2 * M_PI * f * k / fi + c));
+
+	rs = audio_resample_create(fi, fo, ch);
+	TEST_ASSERT(rs != NULL);
+	out = malloc((audio_resample_out_frames(rs, nin) + 1024) * ch * sizeof(int16_t));
+	TEST_ASSERT(out != NULL);
+
+	r->out_frames = 0;
+	t = test_now_ns();
+	while (done < nin) {
+		len = test_rand(&seed) % 700 + 1;
+		if (len > nin - done)
+			len = nin - done;
+		TEST_ASSERT(audio_resample_out_frames(rs, len) + 1 >= len * (double)fo / fi);
+		r->out_frames += audio_resample_process(rs, in + done * ch, len,
+		                                        out + r->out_frames * ch);
+		done += len;
+	}
+	t = test_now_ns() - t;
+	r->msps = (double)nin * ch * 1000 / t;
+
+	/* least squares fit of a sine at f, skipping the filter delay */
+	k0 = fo / 4;
+	k1 = r->out_frames - fo / 8;
+	for (k = k0; k < k1; k++) {
+		X = sin(2 * M_PI * f * k / fo);
+		Y = cos(2 * M_PI * f * k / fo);
+		O = out[k * ch];
+		sxx += X * X;
+		sxy += X * Y;
+		syy += Y * Y;
+		sxo += X * O;
+		syo += Y * O;
+	}
+	det = sxx * syy - sxy * sxy;
+	A = (sxo * syy - syo * sxy) / det;
+	B = (syo * sxx - sxo * sxy) / det;
+	for (k = k0; k < k1; k++) {
+		O = out[k * ch] - A * sin(2 * M_PI * f * k / fo) - B * cos(2 * M_PI * f * k / fo);
+		e += O * O;
+	}
+	amp = sqrt(A * A + B * B);
+	r->snr = 10 * log10(amp * amp / 2 * (k1 - k0) / e);
+	r->gain = 20 * log10(amp / 20000);
+
+	audio_resample_destroy(rs);
+	free(in);
+	free(out);
+}
+
+static const uint32_t rs_rates[][2] = {
+	{ 44100, 16000 }, { 16000, 44100 }, { 48000, 44100 }, { 44100, 48000 },
+	{ 48000, 16000 }, { 16000, 48000 }, { 8000, 48000 }, { 22050, 44100 },
+};
+
+/* 1 kHz stereo tone through every ratio */
+static void rs_test_quality(void)
+{
+	struct rs_result r;
+	double exp_frames;
+	int i;
+
+	for (i = 0; i < sizeof(rs_rates) / sizeof(rs_rates[0]); i++) {
+		rs_run(rs_rates[i][0], rs_rates[i][1], 2, 1000, 2, &r);
+		exp_frames = 2.0 * rs_rates[i][1];
+		TEST_ASSERT(fabs(r.out_frames - exp_frames) <= 2);
+		TEST_ASSERT(fabs(r.gain) < 0.1);
+		if (r.snr < 70) {
+			printf("%u->%u: SNR %.1f dB\n", rs_rates[i][0], rs_rates[i][1], r.snr);
+			TEST_ASSERT(r.snr >= 70);
+		}
+	}
+}
+
+/* History must be gone after a reset: same input, same output */
+static void rs_test_reset(void)
+{
+	int16_t in[2 * 400], out1[2 * 1200], out2[2 * 1200];
+	audio_resample_t *rs;
+	uint32_t n1, n2;
+	int i;
+
+	for (i = 0; i < 400; i++)
+		in[2 * i] = in[2 * i + 1] = (int16_t)(i * 81);
+
+	rs = audio_resample_create(16000, 44100, 2);
+	TEST_ASSERT(rs != NULL);
+	n1 = audio_resample_process(rs, in, 400, out1);
+	audio_resample_reset(rs);
+	n2 = audio_resample_process(rs, in, 400, out2);
+	audio_resample_destroy(rs);
+	TEST_ASSERT_EQ(n1, n2);
+	TEST_ASSERT(memcmp(out1, out2, n1 * 2 * sizeof(int16_t)) == 0);
+
+	/* ratios with too many phases are refused */
+	TEST_ASSERT(audio_resample_create(44100, 44101, 2) == NULL);
+}
+
+static void rs_bench(void)
+{
+	struct rs_result r;
+	int i, ch;
+
+	printf("\n%-14s %4s %10s %10s %9s\n", "ratio", "ch", "Msample/s",
+	       "x realtime", "SNR dB");
+	for (i = 0; i < sizeof(rs_rates) / sizeof(rs_rates[0]); i++) {
+		for (ch = 1; ch <= 2; ch++) {
+			rs_run(rs_rates[i][0], rs_rates[i][1], ch, 1000, 10, &r);
+			printf("%6u->%-6u %4d %10.1f %10.0f %9.1f\n",
+			       rs_rates[i][0], rs_rates[i][1], ch, r.msps,
+			       r.msps * 1e6 / (rs_rates[i][0] * ch), r.snr);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	TEST_RUN(rs_test_quality);
+	TEST_RUN(rs_test_reset);
+	rs_bench();
+	return 0;
+}
@@ -0,0 +1,21 @@
+/*
+ * lwIP sockets API names on top of the host sockets, the server talks to
+ * the test over the host loopback interface.
+ */
+
+#ifndef LWIP_HDR_SOCKETS_H
+#define LWIP_HDR_SOCKETS_H
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#define closesocket	close
+#define ioctlsocket	ioctl
+
+#endif /* LWIP_HDR_SOCKETS_H */
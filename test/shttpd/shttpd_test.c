@@ -0,0 +1,430 @@
+/*
+ * shttpd serving in-memory files to a client over the host loopback.
+ *
+ * The server runs shttpd_poll() in its own thread, the client checks what
+ * goes over the wire: responses on a kept-alive connection, requests
+ * pipelined in one write, conditional and gzip requests, the connection
+ * close rules of HTTP/1.0 and 1.1, and the single connection build giving
+ * way to a new client. The benchmark after the tests measures requests per
+ * second and latency with and without keep-alive and pipelining.
+ */
+
+#include <string.h>
+#include <pthread.h>
+#include "defs.h"
+#include "test.h"
+
+static char index_html[] = "<html><body>hello</body></html>\n";
+static char big_bin[200000];
+static char app_js[] = "function f() { return 1; }\n";
+static char app_js_gz[64];
+static char root_dir[] = "";
+
+static const struct usr_file http_files[] = {
+	{ "./index.html", index_html, 0 },
+	{ "./big.bin", big_bin, sizeof(big_bin) },
+	{ "./app.js", app_js, 0 },
+	{ "./app.js.gz", app_js_gz, sizeof(app_js_gz) },
+	{ "./", root_dir, 0 },
+};
+
+#define HTTP_NR_FILES	(sizeof(http_files) / sizeof(http_files[0]))
+
+static struct shttpd_ctx *http_ctx;
+static volatile int http_stop;
+static uint16_t http_port;
+
+static void *http_server(void *arg)
+{
+	while (!http_stop)
+		shttpd_poll(http_ctx, 100);
+	return NULL;
+}
+
+/* a port nobody listens on, handed to shttpd by number */
+static uint16_t http_free_port(void)
+{
+	struct sockaddr_in sa;
+	socklen_t len = sizeof(sa);
+	int s = socket(AF_INET, SOCK_STREAM, 0);
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	TEST_ASSERT(bind(s, (struct sockaddr *)&sa, sizeof(sa)) == 0);
+	TEST_ASSERT(getsockname(s, (struct sockaddr *)&sa, &len) == 0);
+	close(s);
+	return ntohs(sa.sin_port);
+}
+
+/* client side of a connection, responses are parsed from rx */
+struct http_conn {
+	int sock;
+	size_t len;
+	char rx[1 << 20];
+};
+
+static struct http_conn http_a, http_b;
+
+static char http_hdr[2048];
+static char http_body[1 << 20];
+static size_t http_body_len;
+
+static void http_connect(struct http_conn *c)
+{
+	struct sockaddr_in sa;
+	struct timeval tv = { 3, 0 };
+	int on = 1;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_port = htons(http_port);
+	sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	c->sock = socket(AF_INET, SOCK_STREAM, 0);
+	c->len = 0;
+	TEST_ASSERT(connect(c->sock, (struct sockaddr *)&sa, sizeof(sa)) == 0);
+	setsockopt(c->sock, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+	/* a response that never comes fails the test instead of hanging it */
+	setsockopt(c->sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+static void http_send(struct http_conn *c, const char *req)
+{
+	size_t len = strlen(req);
+	ssize_t n;
+
+	while (len) {
+		n = send(c->sock, req, len, 0);
+		TEST_ASSERT(n > 0);
+		req += n;
+		len -= n;
+	}
+}
+
+static int http_recv(struct http_conn *c)
+{
+	ssize_t n;
+
+	TEST_ASSERT(c->len < sizeof(c->rx));
+	n = recv(c->sock, c->rx + c->len, sizeof(c->rx) - c->len, 0);
+	if (n <= 0)
+		return -1;
+	c->len += n;
+	return 0;
+}
+
+/*
+ * Read one response into http_hdr and http_body, returns the status code.
+ * A HEAD response has no body whatever its Content-Length says.
+ */
+static int http_response(struct http_conn *c, int head)
+{
+	size_t hdr_len, body_len = 0;
+	char *end, *p;
+	int status;
+
+	while ((end = memmem(c->rx, c->len, "\r\n\r\n", 4)) == NULL)
+		TEST_ASSERT(http_recv(c) == 0);
+	hdr_len = end - c->rx + 4;
+	TEST_ASSERT(hdr_len < sizeof(http_hdr));
+	memcpy(http_hdr, c->rx, hdr_len);
+	http_hdr[hdr_len] = '\0';
+
+	TEST_ASSERT(strncmp(http_hdr, "HTTP/1.", 7) == 0);
+	status = atoi(http_hdr + 9);
+	p = strstr(http_hdr, "Content-Length: ");
+	if (p && !head && status != 304)
+		body_len = strtoul(p + 16, NULL, 10);
+
+	while (c->len < hdr_len + body_len)
+		TEST_ASSERT(http_recv(c) == 0);
+	memcpy(http_body, c->rx + hdr_len, body_len);
+	http_body_len = body_len;
+	c->len -= hdr_len + body_len;
+	memmove(c->rx, c->rx + hdr_len + body_len, c->len);
+	return status;
+}
+
+static int http_get(struct http_conn *c, const char *req)
+{
+	http_send(c, req);
+	return http_response(c, 0);
+}
+
+/* the server closed the connection, nothing else was sent */
+static int http_closed(struct http_conn *c)
+{
+	return c->len == 0 && http_recv(c) < 0 && c->len == 0;
+}
+
+static void http_close(struct http_conn *c)
+{
+	close(c->sock);
+	c->sock = -1;
+}
+
+static void http_check_body(const char *data, size_t len)
+{
+	TEST_ASSERT_EQ(http_body_len, len);
+	TEST_ASSERT(memcmp(http_body, data, len) == 0);
+}
+
+#define GET(path)	"GET " path " HTTP/1.1\r\n\r\n"
+
+static void http_test_keep_alive(void)
+{
+	int i;
+
+	http_connect(&http_a);
+	for (i = 0; i < 5; i++) {
+		TEST_ASSERT_EQ(http_get(&http_a, "GET /index.html HTTP/1.1\r\n"
+					"Host: test\r\n\r\n"), 200);
+		http_check_body(index_html, strlen(index_html));
+		TEST_ASSERT(strstr(http_hdr, "Content-Type: text/html"));
+	}
+
+	/* sent from the file body as it is, byte exact */
+	TEST_ASSERT_EQ(http_get(&http_a, GET("/big.bin")), 200);
+	http_check_body(big_bin, sizeof(big_bin));
+
+	/* errors keep the connection */
+	TEST_ASSERT_EQ(http_get(&http_a, GET("/nope")), 404);
+	TEST_ASSERT_EQ(http_get(&http_a, GET("/index.html")), 200);
+
+	/* a HEAD response has headers only, the next one follows at once */
+	http_send(&http_a, "HEAD /index.html HTTP/1.1\r\n\r\n");
+	TEST_ASSERT_EQ(http_response(&http_a, 1), 200);
+	TEST_ASSERT_EQ(http_get(&http_a, GET("/index.html")), 200);
+	http_check_body(index_html, strlen(index_html));
+	http_close(&http_a);
+}
+
+static void http_test_pipeline(void)
+{
+	char req[4096] = "";
+	int i;
+
+	/* mixed small and large files in a single write */
+	for (i = 0; i < 20; i++)
+		strcat(req, i % 5 == 4 ? GET("/big.bin") : GET("/index.html"));
+	strcat(req, GET("/nope"));
+	strcat(req, GET("/index.html"));
+
+	http_connect(&http_a);
+	http_send(&http_a, req);
+	for (i = 0; i < 20; i++) {
+		TEST_ASSERT_EQ(http_response(&http_a, 0), 200);
+		if (i % 5 == 4)
+			http_check_body(big_bin, sizeof(big_bin));
+		else
+			http_check_body(index_html, strlen(index_html));
+	}
+	TEST_ASSERT_EQ(http_response(&http_a, 0), 404);
+	TEST_ASSERT_EQ(http_response(&http_a, 0), 200);
+	http_check_body(index_html, strlen(index_html));
+
+	/* a request split over several writes */
+	http_send(&http_a, "GET /index.h");
+	usleep(20000);
+	http_send(&http_a, "tml HTTP/1.1\r\n");
+	usleep(20000);
+	http_send(&http_a, "\r\n");
+	TEST_ASSERT_EQ(http_response(&http_a, 0), 200);
+	http_check_body(index_html, strlen(index_html));
+	http_close(&http_a);
+}
+
+static void http_test_etag(void)
+{
+	char etag[64], req[256];
+	char *p;
+
+	http_connect(&http_a);
+	TEST_ASSERT_EQ(http_get(&http_a, GET("/index.html")), 200);
+	p = strstr(http_hdr, "Etag: ");
+	TEST_ASSERT(p);
+	TEST_ASSERT(sscanf(p, "Etag: %63[^\r]", etag) == 1);
+
+	/* a match anywhere in the list, no body and the connection is kept */
+	snprintf(req, sizeof(req), "GET /index.html HTTP/1.1\r\n"
+		 "If-None-Match: W/\"x\", %s\r\n\r\n", etag);
+	TEST_ASSERT_EQ(http_get(&http_a, req), 304);
+	TEST_ASSERT(strstr(http_hdr, "Content-Length") == NULL);
+	TEST_ASSERT_EQ(http_body_len, 0);
+
+	TEST_ASSERT_EQ(http_get(&http_a, "GET /index.html HTTP/1.1\r\n"
+				"If-None-Match: \"nope\"\r\n\r\n"), 200);
+	http_check_body(index_html, strlen(index_html));
+	http_close(&http_a);
+}
+
+static void http_test_gzip(void)
+{
+	http_connect(&http_a);
+	TEST_ASSERT_EQ(http_get(&http_a, "GET /app.js HTTP/1.1\r\n"
+				"Accept-Encoding: deflate, gzip\r\n\r\n"), 200);
+	http_check_body(app_js_gz, sizeof(app_js_gz));
+	TEST_ASSERT(strstr(http_hdr, "Content-Encoding: gzip"));
+	TEST_ASSERT(strstr(http_hdr, "Vary: Accept-Encoding"));
+
+	/* refused with q=0 */
+	TEST_ASSERT_EQ(http_get(&http_a, "GET /app.js HTTP/1.1\r\n"
+				"Accept-Encoding: gzip;q=0\r\n\r\n"), 200);
+	http_check_body(app_js, strlen(app_js));
+	TEST_ASSERT(strstr(http_hdr, "Content-Encoding") == NULL);
+
+	TEST_ASSERT_EQ(http_get(&http_a, GET("/app.js")), 200);
+	http_check_body(app_js, strlen(app_js));
+	http_close(&http_a);
+}
+
+static void http_test_close(void)
+{
+	/* HTTP/1.1 closes on request only */
+	http_connect(&http_a);
+	TEST_ASSERT_EQ(http_get(&http_a, "GET /index.html HTTP/1.1\r\n"
+				"Connection: close\r\n\r\n"), 200);
+	http_check_body(index_html, strlen(index_html));
+	TEST_ASSERT(http_closed(&http_a));
+	http_close(&http_a);
+
+	/* HTTP/1.0 keeps the connection on request only */
+	http_connect(&http_a);
+	TEST_ASSERT_EQ(http_get(&http_a, "GET /index.html HTTP/1.0\r\n"
+				"Connection: Keep-Alive\r\n\r\n"), 200);
+	TEST_ASSERT(strstr(http_hdr, "Connection: keep-alive"));
+	TEST_ASSERT_EQ(http_get(&http_a, "GET /index.html HTTP/1.0\r\n\r\n"), 200);
+	http_check_body(index_html, strlen(index_html));
+	TEST_ASSERT(http_closed(&http_a));
+	http_close(&http_a);
+}
+
+static void http_test_single_conn(void)
+{
+	/* a client idle in keep-alive doesn't lock the next one out */
+	http_connect(&http_a);
+	TEST_ASSERT_EQ(http_get(&http_a, GET("/index.html")), 200);
+	http_connect(&http_b);
+	TEST_ASSERT_EQ(http_get(&http_b, GET("/index.html")), 200);
+	TEST_ASSERT(http_closed(&http_a));
+	http_close(&http_a);
+
+	TEST_ASSERT_EQ(http_get(&http_b, GET("/index.html")), 200);
+	http_close(&http_b);
+}
+
+#define BENCH_PIPELINE	16
+
+struct http_lat {
+	uint64_t start;
+	uint64_t total;
+	uint64_t worst;
+	int n;
+};
+
+static void http_lat_start(struct http_lat *lat)
+{
+	lat->start = test_now_ns();
+}
+
+static void http_lat_stop(struct http_lat *lat, int n)
+{
+	uint64_t t = test_now_ns() - lat->start;
+
+	lat->total += t;
+	if (t > lat->worst)
+		lat->worst = t;
+	lat->n += n;
+}
+
+static void http_lat_print(const char *name, struct http_lat *lat)
+{
+	printf("%-20s %8.0f %10.1f %10.1f\n", name,
+	       lat->n * 1e9 / lat->total, lat->total / 1e3 / lat->n,
+	       lat->worst / 1e3);
+}
+
+static void http_bench(void)
+{
+	struct http_lat lat;
+	char req[BENCH_PIPELINE * sizeof(GET("/index.html"))] = "";
+	uint64_t t;
+	int i, j;
+
+	printf("\n%-20s %8s %10s %10s\n", "index.html", "req/s", "avg(us)",
+	       "worst(us)");
+
+	memset(&lat, 0, sizeof(lat));
+	for (i = 0; i < 300; i++) {
+		http_lat_start(&lat);
+		http_connect(&http_a);
+		TEST_ASSERT_EQ(http_get(&http_a, "GET /index.html HTTP/1.1\r\n"
+					"Connection: close\r\n\r\n"), 200);
+		http_close(&http_a);
+		http_lat_stop(&lat, 1);
+	}
+	http_lat_print("connection/request", &lat);
+
+	memset(&lat, 0, sizeof(lat));
+	http_connect(&http_a);
+	for (i = 0; i < 2000; i++) {
+		http_lat_start(&lat);
+		TEST_ASSERT_EQ(http_get(&http_a, GET("/index.html")), 200);
+		http_lat_stop(&lat, 1);
+	}
+	http_lat_print("keep-alive", &lat);
+
+	/* latency of a whole batch, from the write to its last response */
+	for (i = 0; i < BENCH_PIPELINE; i++)
+		strcat(req, GET("/index.html"));
+	memset(&lat, 0, sizeof(lat));
+	for (i = 0; i < 200; i++) {
+		http_lat_start(&lat);
+		http_send(&http_a, req);
+		for (j = 0; j < BENCH_PIPELINE; j++)
+			TEST_ASSERT_EQ(http_response(&http_a, 0), 200);
+		http_lat_stop(&lat, BENCH_PIPELINE);
+	}
+	http_lat_print("pipelined x16", &lat);
+
+	t = test_now_ns();
+	for (i = 0; i < 50; i++)
+		TEST_ASSERT_EQ(http_get(&http_a, GET("/big.bin")), 200);
+	t = test_now_ns() - t;
+	http_close(&http_a);
+	printf("\nbig.bin keep-alive %.1f MB/s\n", 50.0 * sizeof(big_bin) * 1e3 / t);
+}
+
+int main(int argc, char **argv)
+{
+	pthread_t th;
+	char port[8];
+	int i;
+
+	for (i = 0; i < sizeof(big_bin); i++)
+		big_bin[i] = i * 7 + (i >> 9);
+	/* binary, with a NUL early on */
+	for (i = 0; i < sizeof(app_js_gz); i++)
+		app_js_gz[i] = i == 3 ? 0 : 0x1f + i;
+
+	_shttpd_init_local_file(http_files, HTTP_NR_FILES);
+	http_ctx = shttpd_init(0, NULL);
+	TEST_ASSERT(http_ctx);
+	http_port = http_free_port();
+	snprintf(port, sizeof(port), "%u", http_port);
+	TEST_ASSERT(shttpd_set_option(http_ctx, "ports", port) == 1);
+	pthread_create(&th, NULL, http_server, NULL);
+
+	TEST_RUN(http_test_keep_alive);
+	TEST_RUN(http_test_pipeline);
+	TEST_RUN(http_test_etag);
+	TEST_RUN(http_test_gzip);
+	TEST_RUN(http_test_close);
+	TEST_RUN(http_test_single_conn);
+	http_bench();
+
+	http_stop = 1;
+	pthread_join(th, NULL);
+	shttpd_fini(http_ctx);
+	return 0;
+}
@@ -0,0 +1,45 @@
+#
+# Common rules for the host tests, included by test/<name>/Makefile
+#
+# A test Makefile sets ROOT_PATH, TEST_SRCS (relative to ROOT_PATH), optionally
+# TEST_CFLAGS, TEST_LIBS and TEST_ARGS, then includes this file.
+#
+
+ROOT_PATH ?= ../..
+OS_PATH := $(ROOT_PATH)/src/kernel/os/POSIX
+
+CC ?= cc
+
+CFLAGS ?= -O2 -g
+CFLAGS += -Wall -pthread -D_GNU_SOURCE
+CFLAGS += -I$(ROOT_PATH)/include -I$(ROOT_PATH)/test/common
+CFLAGS += $(TEST_CFLAGS)
+
+TEST := test_$(notdir $(CURDIR))
+
+SRCS := $(wildcard *.c) $(addprefix $(ROOT_PATH)/,$(TEST_SRCS))
+
+ifeq ($(TEST_USE_OS), y)
+  CFLAGS += -D__CONFIG_OS_POSIX
+  LIBS += $(OS_PATH)/libos.a
+endif
+LIBS += $(TEST_LIBS) -lm
+
+# ----------------------------------------------------------------------------
+# rules
+# ----------------------------------------------------------------------------
+all: $(TEST)
+
+$(OS_PATH)/libos.a: FORCE
+	$(MAKE) -C $(OS_PATH) CC="$(CC)"
+
+$(TEST): $(SRCS) $(wildcard *.h) $(filter %.a,$(LIBS))
+	$(CC) $(CFLAGS) -o $@ $(SRCS) $(LIBS)
+
+run: $(TEST)
+	./$(TEST) $(TEST_ARGS)
+
+clean:
+	-rm -f $(TEST)
+
+.PHONY: all run clean FORCE
@@ -0,0 +1,40 @@
+/*
+ * The bootloader side of the hand over, the header inline functions write
+ * the spans straight to the retention area.
+ */
+
+#define __CONFIG_BOOTLOADER
+
+#include "test.h"
+#include "util/timeline.h"
+#include "timeline_test.h"
+
+void boot_sim_run(void)
+{
+	tl_test_now = 2000;
+	TIMELINE_INIT();
+	TIMELINE_BEGIN("boot");
+	tl_test_now = 2100;
+	TIMELINE_BEGIN("load");
+	tl_test_now = 2200;
+	TIMELINE_BEGIN("read");
+	tl_test_now = 9000;
+	TIMELINE_END("read");
+	TIMELINE_BEGIN("check-image");		/* cut to 7 characters */
+	tl_test_now = 9500;
+	TIMELINE_END("check-image");
+	TIMELINE_MARK("jump");
+	tl_test_now = 9600;
+	TIMELINE_END("load");
+	TIMELINE_BEGIN("a");
+	tl_test_now = 9610;
+	TIMELINE_BEGIN("b");			/* the 7th span, area full */
+	TIMELINE_BEGIN("c");			/* dropped */
+	tl_test_now = 9620;
+	TIMELINE_END("c");
+	TIMELINE_END("b");
+	tl_test_now = 9630;
+	TIMELINE_END("a");
+	tl_test_now = 9700;
+	TIMELINE_END("boot");
+}
@@ -0,0 +1,24 @@
+/*
+ * arch_irq_save()/arch_irq_restore() for the host: one global lock, so that
+ * threads standing in for IRQs and tasks serialize like on the device.
+ */
+
+#ifndef _SYS_INTERRUPT_H_
+#define _SYS_INTERRUPT_H_
+
+#include <pthread.h>
+
+extern pthread_mutex_t test_irq_lock;
+
+static inline unsigned long arch_irq_save(void)
+{
+	pthread_mutex_lock(&test_irq_lock);
+	return 0;
+}
+
+static inline void arch_irq_restore(unsigned long flags)
+{
+	pthread_mutex_unlock(&test_irq_lock);
+}
+
+#endif /* _SYS_INTERRUPT_H_ */
@@ -0,0 +1,31 @@
+#include <sys/mman.h>
+
+#include "test.h"
+#include "util/timeline.h"
+#include "timeline_test.h"
+
+pthread_mutex_t test_irq_lock = PTHREAD_MUTEX_INITIALIZER;
+uint64_t tl_test_now;
+
+uint64_t HAL_RTC_GetFreeRunTime(void)
+{
+	return tl_test_now;
+}
+
+int main(int argc, char **argv)
+{
+	void *page = (void *)(TIMELINE_RETAIN_ADDR & ~0xfffUL);
+
+	/* the retention area both images use, at its device address */
+	if (mmap(page, 4096, PROT_READ | PROT_WRITE,
+		 MAP_FIXED_NOREPLACE | MAP_PRIVATE | MAP_ANONYMOUS,
+		 -1, 0) != page) {
+		printf("can not map the retention area at %#x\n",
+		       TIMELINE_RETAIN_ADDR);
+		return 1;
+	}
+
+	timeline_test();
+	timeline_bench();
+	return 0;
+}
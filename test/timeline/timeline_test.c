@@ -0,0 +1,344 @@
+/*
+ * Timeline profiler on the host: the retention area layout shared by the
+ * bootloader and the application, the import of the bootloader spans, span
+ * nesting and end matching, overflow, and the table and Chrome trace JSON
+ * exporters. The JSON is checked here and, when python3 is available, also
+ * loaded by a real JSON parser.
+ */
+
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "util/timeline.h"
+#include "timeline_test.h"
+
+#define TL_OUT_SIZE	(64 * 1024)
+
+static char tl_out[TL_OUT_SIZE];
+
+/* run @fn with stdout going to tl_out */
+static void tl_capture(void (*fn)(void))
+{
+	FILE *f;
+	size_t n;
+	int fd;
+
+	fflush(stdout);
+	fd = dup(1);
+	f = tmpfile();
+	TEST_ASSERT(fd >= 0 && f != NULL);
+	dup2(fileno(f), 1);
+	fn();
+	fflush(stdout);
+	dup2(fd, 1);
+	close(fd);
+
+	rewind(f);
+	n = fread(tl_out, 1, TL_OUT_SIZE - 1, f);
+	tl_out[n] = '\0';
+	fclose(f);
+}
+
+static void tl_test_retain_layout(void)
+{
+	/* both images are built separately, the layout must not move */
+	TEST_ASSERT(sizeof(struct timeline_retain) <= TIMELINE_RETAIN_SIZE);
+	TEST_ASSERT_EQ(sizeof(struct timeline_retain_span), 16);
+	TEST_ASSERT_EQ(offsetof(struct timeline_retain, count), 4);
+	TEST_ASSERT_EQ(offsetof(struct timeline_retain, depth), 5);
+	TEST_ASSERT_EQ(offsetof(struct timeline_retain, span), 8);
+	TEST_ASSERT_EQ(offsetof(struct timeline_retain_span, depth), 7);
+	TEST_ASSERT_EQ(offsetof(struct timeline_retain_span, start), 8);
+	TEST_ASSERT_EQ(offsetof(struct timeline_retain_span, end), 12);
+	TEST_ASSERT(TIMELINE_RETAIN_ADDR % 4 == 0);
+}
+
+static void tl_test_boot_import(void)
+{
+	struct timeline_retain *r = (struct timeline_retain *)TIMELINE_RETAIN_ADDR;
+	struct timeline_span s[TIMELINE_SPAN_MAX];
+	static const struct {
+		const char *name;
+		uint32_t start, end;
+		uint8_t depth, flags;
+	} expect[] = {
+		{ "platform init", 20000, 40000, 0, 0 },
+		{ "boot",    2000, 9700, 0, TIMELINE_F_BOOT },
+		{ "load",    2100, 9600, 1, TIMELINE_F_BOOT },
+		{ "read",    2200, 9000, 2, TIMELINE_F_BOOT },
+		{ "check-i", 9000, 9500, 2, TIMELINE_F_BOOT },
+		{ "jump",    9500, 9500, 2, TIMELINE_F_BOOT | TIMELINE_F_MARK },
+		{ "a",       9600, 9630, 1, TIMELINE_F_BOOT },
+		{ "b",       9610, 9620, 2, TIMELINE_F_BOOT },
+	};
+	int i, n;
+
+	boot_sim_run();
+	TEST_ASSERT_EQ(r->magic, TIMELINE_RETAIN_MAGIC);
+	TEST_ASSERT_EQ(r->count, TIMELINE_RETAIN_SPANS);
+	TEST_ASSERT_EQ(r->depth, 0);
+
+	/* a span begun before the import goes after the bootloader ones */
+	tl_test_now = 20000;
+	TIMELINE_BEGIN("platform init");
+	TIMELINE_INIT();
+	TEST_ASSERT_EQ(r->magic, 0);
+	tl_test_now = 40000;
+	TIMELINE_END("platform init");
+
+	n = timeline_get(s, TIMELINE_SPAN_MAX);
+	TEST_ASSERT_EQ(n, TIMELINE_RETAIN_SPANS + 1);
+	for (i = 0; i < n; i++) {
+		int k = (i + 1) % n;
+
+		TEST_ASSERT(strcmp(s[i].name, expect[k].name) == 0);
+		TEST_ASSERT_EQ(s[i].start, expect[k].start);
+		TEST_ASSERT_EQ(s[i].end, expect[k].end);
+		TEST_ASSERT_EQ(s[i].depth, expect[k].depth);
+		TEST_ASSERT_EQ(s[i].flags, expect[k].flags);
+	}
+
+	/* imported once, a warm reboot may skip the bootloader */
+	boot_sim_run();
+	TIMELINE_INIT();
+	TEST_ASSERT_EQ(timeline_get(s, TIMELINE_SPAN_MAX), n);
+
+	/* the application can not end a bootloader span */
+	TIMELINE_END("boot");
+	timeline_get(s, TIMELINE_SPAN_MAX);
+	TEST_ASSERT_EQ(s[0].end, 9700);
+
+	/* reset keeps the bootloader spans */
+	timeline_reset();
+	TEST_ASSERT_EQ(timeline_get(s, TIMELINE_SPAN_MAX), TIMELINE_RETAIN_SPANS);
+	TEST_ASSERT_EQ(timeline_get(s, 3), 3);
+}
+
+static void tl_test_nesting(void)
+{
+	struct timeline_span s[TIMELINE_SPAN_MAX];
+	char name[8];
+	int n, b = TIMELINE_RETAIN_SPANS;
+
+	timeline_reset();
+	tl_test_now = 100000;
+	TIMELINE_BEGIN("net");
+	tl_test_now = 100100;
+	TIMELINE_BEGIN("dhcp");
+	tl_test_now = 100200;
+	TIMELINE_MARK("link up");
+	TIMELINE_BEGIN("dhcp");		/* retry, nested in the first one */
+	tl_test_now = 100300;
+
+	/* matched by content, not by pointer, to the last open span */
+	strcpy(name, "dhcp");
+	TIMELINE_END(name);
+	TIMELINE_END("unknown");
+	tl_test_now = 100400;
+	TIMELINE_END("dhcp");
+	TIMELINE_BEGIN("sntp");		/* left open */
+	tl_test_now = 0;		/* the counter reads 0, not an open end */
+	TIMELINE_END("net");
+
+	n = timeline_get(s, TIMELINE_SPAN_MAX) - b;
+	TEST_ASSERT_EQ(n, 5);
+	TEST_ASSERT(strcmp(s[b].name, "net") == 0);
+	TEST_ASSERT_EQ(s[b].depth, 0);
+	TEST_ASSERT_EQ(s[b].end, 1);
+	TEST_ASSERT_EQ(s[b + 1].depth, 1);
+	TEST_ASSERT_EQ(s[b + 1].end, 100400);
+	TEST_ASSERT_EQ(s[b + 2].flags, TIMELINE_F_MARK);
+	TEST_ASSERT_EQ(s[b + 2].depth, 2);
+	TEST_ASSERT_EQ(s[b + 2].start, s[b + 2].end);
+	TEST_ASSERT_EQ(s[b + 3].depth, 2);
+	TEST_ASSERT_EQ(s[b + 3].end, 100300);
+	TEST_ASSERT_EQ(s[b + 4].depth, 1);
+	TEST_ASSERT_EQ(s[b + 4].end, 0);
+
+	/* the open span still counts, the next one nests under it */
+	TIMELINE_MARK("after");
+	timeline_get(s, TIMELINE_SPAN_MAX);
+	TEST_ASSERT_EQ(s[b + 5].depth, 1);
+}
+
+static void tl_test_overflow(void)
+{
+	struct timeline_span s[TIMELINE_SPAN_MAX];
+	int i;
+
+	timeline_reset();
+	tl_test_now = 200000;
+	for (i = 0; i < TIMELINE_SPAN_MAX + 10; i++)
+		TIMELINE_MARK("m");
+	TEST_ASSERT_EQ(timeline_get(s, TIMELINE_SPAN_MAX), TIMELINE_SPAN_MAX);
+
+	tl_capture(timeline_show);
+	TEST_ASSERT(strstr(tl_out, ", 17 spans lost\n") != NULL);
+
+	timeline_reset();
+	tl_capture(timeline_show);
+	TEST_ASSERT(strstr(tl_out, "lost") == NULL);
+}
+
+static void tl_record(void)
+{
+	timeline_reset();
+	tl_test_now = 20000;
+	TIMELINE_BEGIN("platform init");
+	tl_test_now = 21000;
+	TIMELINE_BEGIN("level1");
+	tl_test_now = 30000;
+	TIMELINE_BEGIN("dhcp");
+	tl_test_now = 31000;
+	TIMELINE_END("level1");
+	TIMELINE_MARK("wlan \"ap\\1\"\tconnected");
+	tl_test_now = 40000;
+	TIMELINE_END("platform init");
+	tl_test_now = 50000;
+}
+
+static void tl_test_show(void)
+{
+	static const char *expect =
+		" start(us)    dur(us)  span\n"
+		"      2000       7700  boot [boot]\n"
+		"      2100       7500    load [boot]\n"
+		"      2200       6800      read [boot]\n"
+		"      9000        500      check-i [boot]\n"
+		"      9500                 * jump\n"
+		"      9600         30    a [boot]\n"
+		"      9610         10      b [boot]\n"
+		"     20000      20000  platform init\n"
+		"     21000      10000    level1\n"
+		"     30000      20000      dhcp [open]\n"
+		"     31000                 * wlan \"ap\\1\"\tconnected\n"
+		"50000 us since power on, 48000 us since the first span\n";
+
+	tl_record();
+	tl_capture(timeline_show);
+	if (strcmp(tl_out, expect) != 0) {
+		printf("\n%s", tl_out);
+		TEST_ASSERT(0);
+	}
+}
+
+static void tl_test_export(void)
+{
+	static const char *expect =
+		"timeline json begin\n"
+		"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+		"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"bootloader\"}},\n"
+		"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"app\"}},\n"
+		"{\"name\":\"boot\",\"ph\":\"X\",\"ts\":2000,\"dur\":7700,\"pid\":0,\"tid\":0,\"args\":{\"depth\":0}},\n"
+		"{\"name\":\"load\",\"ph\":\"X\",\"ts\":2100,\"dur\":7500,\"pid\":0,\"tid\":0,\"args\":{\"depth\":1}},\n"
+		"{\"name\":\"read\",\"ph\":\"X\",\"ts\":2200,\"dur\":6800,\"pid\":0,\"tid\":0,\"args\":{\"depth\":2}},\n"
+		"{\"name\":\"check-i\",\"ph\":\"X\",\"ts\":9000,\"dur\":500,\"pid\":0,\"tid\":0,\"args\":{\"depth\":2}},\n"
+		"{\"name\":\"jump\",\"ph\":\"i\",\"s\":\"g\",\"ts\":9500,\"pid\":0,\"tid\":0,\"args\":{\"depth\":2}},\n"
+		"{\"name\":\"a\",\"ph\":\"X\",\"ts\":9600,\"dur\":30,\"pid\":0,\"tid\":0,\"args\":{\"depth\":1}},\n"
+		"{\"name\":\"b\",\"ph\":\"X\",\"ts\":9610,\"dur\":10,\"pid\":0,\"tid\":0,\"args\":{\"depth\":2}},\n"
+		"{\"name\":\"platform init\",\"ph\":\"X\",\"ts\":20000,\"dur\":20000,\"pid\":0,\"tid\":1,\"args\":{\"depth\":0}},\n"
+		"{\"name\":\"level1\",\"ph\":\"X\",\"ts\":21000,\"dur\":10000,\"pid\":0,\"tid\":1,\"args\":{\"depth\":1}},\n"
+		"{\"name\":\"dhcp\",\"ph\":\"X\",\"ts\":30000,\"dur\":20000,\"pid\":0,\"tid\":1,\"args\":{\"depth\":2,\"open\":1}},\n"
+		"{\"name\":\"wlan \\\"ap\\\\1\\\"connected\",\"ph\":\"i\",\"s\":\"g\",\"ts\":31000,\"pid\":0,\"tid\":1,\"args\":{\"depth\":2}}\n"
+		"]}\n"
+		"timeline json end\n";
+	char path[] = "/tmp/timeline_XXXXXX", cmd[256];
+	char *json, *end;
+	FILE *f;
+	int fd;
+
+	tl_record();
+	tl_capture(timeline_export);
+	if (strcmp(tl_out, expect) != 0) {
+		printf("\n%s", tl_out);
+		TEST_ASSERT(0);
+	}
+
+	/* the text between the begin/end lines must load as is */
+	if (system("python3 -c 'import json' >/dev/null 2>&1") != 0)
+		return;
+	json = strchr(tl_out, '\n') + 1;
+	end = strstr(json, "timeline json end");
+	fd = mkstemp(path);
+	TEST_ASSERT(fd >= 0);
+	f = fdopen(fd, "w");
+	fwrite(json, 1, end - json, f);
+	fclose(f);
+	snprintf(cmd, sizeof(cmd), "python3 -c 'import json, sys\n"
+		 "e = json.load(open(sys.argv[1]))[\"traceEvents\"]\n"
+		 "assert len(e) == 13 and e[-1][\"name\"] == sys.argv[2]'"
+		 " %s 'wlan \"ap\\1\"connected'", path);
+	TEST_ASSERT(system(cmd) == 0);
+	unlink(path);
+}
+
+#define TL_THREADS	4
+/* room left after the bootloader spans, and one more for a mark */
+#define TL_PER_THREAD	((TIMELINE_SPAN_MAX - TIMELINE_RETAIN_SPANS - 1) / TL_THREADS)
+
+static void *tl_thread(void *arg)
+{
+	static const char *names[TL_THREADS] = { "t0", "t1", "t2", "t3" };
+	const char *name = names[(uintptr_t)arg];
+	int i;
+
+	for (i = 0; i < TL_PER_THREAD; i++) {
+		TIMELINE_BEGIN(name);
+		TIMELINE_END(name);
+	}
+	return NULL;
+}
+
+static void tl_test_threads(void)
+{
+	struct timeline_span s[TIMELINE_SPAN_MAX];
+	pthread_t th[TL_THREADS];
+	uintptr_t i;
+	int n;
+
+	/* spans from several threads, every one ended, the depth back to 0 */
+	timeline_reset();
+	tl_test_now = 300000;
+	for (i = 0; i < TL_THREADS; i++)
+		pthread_create(&th[i], NULL, tl_thread, (void *)i);
+	for (i = 0; i < TL_THREADS; i++)
+		pthread_join(th[i], NULL);
+	TIMELINE_MARK("done");
+
+	n = timeline_get(s, TIMELINE_SPAN_MAX);
+	TEST_ASSERT_EQ(n, TIMELINE_RETAIN_SPANS + TL_PER_THREAD * TL_THREADS + 1);
+	for (i = TIMELINE_RETAIN_SPANS; i < n; i++)
+		TEST_ASSERT(s[i].end != 0 && s[i].depth < TL_THREADS);
+	TEST_ASSERT_EQ(s[n - 1].depth, 0);
+}
+
+void timeline_test(void)
+{
+	TEST_RUN(tl_test_retain_layout);
+	TEST_RUN(tl_test_boot_import);
+	TEST_RUN(tl_test_nesting);
+	TEST_RUN(tl_test_overflow);
+	TEST_RUN(tl_test_show);
+	TEST_RUN(tl_test_export);
+	TEST_RUN(tl_test_threads);
+}
+
+void timeline_bench(void)
+{
+	uint64_t t;
+	int i, n = 0;
+
+	t = test_now_ns();
+	while (n < 1000000) {
+		timeline_reset();
+		for (i = 0; i < (TIMELINE_SPAN_MAX - TIMELINE_RETAIN_SPANS); i++) {
+			TIMELINE_BEGIN("bench");
+			TIMELINE_END("bench");
+		}
+		n += i;
+	}
+	t = test_now_ns() - t;
+	printf("\nbegin + end %.1f ns/span\n", (double)t / n);
+}
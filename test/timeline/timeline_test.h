@@ -0,0 +1,15 @@
+#ifndef _TIMELINE_TEST_H_
+#define _TIMELINE_TEST_H_
+
+#include <stdint.h>
+
+/* what HAL_RTC_GetFreeRunTime() returns */
+extern uint64_t tl_test_now;
+
+/* the bootloader side, built with __CONFIG_BOOTLOADER */
+void boot_sim_run(void);
+
+void timeline_test(void);
+void timeline_bench(void);
+
+#endif /* _TIMELINE_TEST_H_ */
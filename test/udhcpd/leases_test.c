@@ -0,0 +1,112 @@
+/*
+ * Lease indexes: after every random add_lease(), clear_lease() and
+ * lease_drop*() the chaddr and yiaddr lookups and find_address() agree
+ * with a plain scan of leases[], over a range wider than the table and
+ * with addresses ending in .0/.255 that are never handed out.
+ */
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "test.h"
+#include "dhcpd.h"
+#include "leases.h"
+#include "udhcpd_test.h"
+
+#define NR_LEASES	24
+#define NR_ADDRS	160	/* crosses 192.168.52.0 */
+#define NR_MACS		40
+
+static struct dhcpOfferedAddr *scan_chaddr(const u_int8_t *chaddr)
+{
+	int i;
+
+	for (i = 0; i < NR_LEASES; i++)
+		if (!memcmp(leases[i].chaddr, chaddr, 16))
+			return &leases[i];
+	return NULL;
+}
+
+static struct dhcpOfferedAddr *scan_yiaddr(u_int32_t yiaddr)
+{
+	int i;
+
+	for (i = 0; i < NR_LEASES; i++)
+		if (leases[i].yiaddr == yiaddr)
+			return &leases[i];
+	return NULL;
+}
+
+/* first usable address nobody holds, or (check_expired) whose lease ended */
+static u_int32_t scan_address(int check_expired)
+{
+	struct dhcpOfferedAddr *l;
+	u_int32_t x;
+
+	for (x = ntohl(server_config.start); x <= ntohl(server_config.end); x++) {
+		if ((x & 0xff) == 0 || (x & 0xff) == 0xff)
+			continue;
+		l = scan_yiaddr(htonl(x));
+		if (!l || (check_expired && lease_expired(l)))
+			return htonl(x);
+	}
+	return 0;
+}
+
+static void leases_test_index(void)
+{
+	struct dhcpOfferedAddr *l;
+	u_int8_t chaddr[16];
+	u_int32_t seed = 1, addr, got;
+	int i, op;
+
+	udhcpd_test_config(NR_LEASES, NR_ADDRS);
+	TEST_ASSERT_EQ(leases_init(), 0);
+
+	for (i = 0; i < 100000; i++) {
+		memset(chaddr, 0, sizeof(chaddr));
+		chaddr[0] = 0x02;
+		chaddr[5] = test_rand(&seed) % NR_MACS;
+		/* one below and a few above the range too */
+		addr = htonl(ntohl(server_config.start) - 1 +
+		             test_rand(&seed) % (NR_ADDRS + 4));
+
+		op = test_rand(&seed) % 6;
+		switch (op) {
+		case 0:
+		case 1:
+			add_lease(chaddr, addr, test_rand(&seed) % 3 ? 100 : 0);
+			break;
+		case 2:
+			add_lease(blank_chaddr, addr, 50);
+			break;
+		case 3:
+			if ((l = find_lease_by_chaddr(chaddr)) != NULL)
+				lease_drop(l);
+			break;
+		case 4:
+			if ((l = find_lease_by_yiaddr(addr)) != NULL)
+				lease_drop_chaddr(l);
+			break;
+		default:
+			clear_lease(chaddr, addr);
+			break;
+		}
+
+		TEST_ASSERT(find_lease_by_chaddr(chaddr) == scan_chaddr(chaddr));
+		TEST_ASSERT(find_lease_by_yiaddr(addr) == scan_yiaddr(addr));
+		TEST_ASSERT_EQ(find_address(0), scan_address(0));
+		/* may pick a free address over an expired one below it */
+		got = find_address(1);
+		TEST_ASSERT_EQ(!!got, !!scan_address(1));
+		if (got)
+			TEST_ASSERT(!scan_yiaddr(got) || lease_expired(scan_yiaddr(got)));
+	}
+
+	leases_deinit();
+}
+
+void leases_test(void)
+{
+	TEST_RUN(leases_test_index);
+}
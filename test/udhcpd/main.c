@@ -0,0 +1,42 @@
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "test.h"
+#include "dhcpd.h"
+#include "leases.h"
+#include "udhcpd_test.h"
+
+/* what usr_dhcpd.c and lwIP provide on the device */
+struct dhcpOfferedAddr *leases;
+struct server_config_t server_config;
+static struct netif test_netif;
+
+struct netif *netif_find(const char *name)
+{
+	return &test_netif;
+}
+
+void udhcpd_test_config(int max_leases, int nr_addrs)
+{
+	memset(&server_config, 0, sizeof(server_config));
+	server_config.start = inet_addr(TEST_POOL_START);
+	server_config.end = htonl(ntohl(server_config.start) + nr_addrs - 1);
+	server_config.server = inet_addr("192.168.51.1");
+	server_config.max_leases = max_leases;
+	server_config.lease = 86400;
+	server_config.min_lease = 60;
+	server_config.offer_time = 60;
+	server_config.conflict_time = 3600;
+	server_config.decline_time = 3600;
+
+	test_netif.ip_addr.addr = server_config.server;
+	test_netif.netmask.addr = inet_addr("255.255.255.0");
+	test_netif.gw.addr = server_config.server;
+}
+
+int main(int argc, char **argv)
+{
+	leases_test();
+	probe_test();
+	return 0;
+}
@@ -0,0 +1,28 @@
+/*
+ * The lwIP netif fields serverpacket.c reads, the server is built against
+ * the host sockets API otherwise (no DHCPD_LWIP).
+ */
+
+#ifndef _NETIF_STUB_H_
+#define _NETIF_STUB_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#define __CONFIG_LWIP_V1
+
+struct ip4_addr {
+	uint32_t addr;
+};
+
+struct netif {
+	struct ip4_addr ip_addr;
+	struct ip4_addr netmask;
+	struct ip4_addr gw;
+};
+
+#define ip4_addr_get_u32(p)	((p)->addr)
+
+struct netif *netif_find(const char *name);
+
+#endif /* _NETIF_STUB_H_ */
@@ -0,0 +1,222 @@
+/*
+ * Conflict probes: DISCOVERs from 1, 8 and 32 stations arriving together
+ * are all answered about PROBE_TIME_MS later, not one after the other.
+ * The simulated netif has two occupied addresses in the pool that answer
+ * probes after 3 ms; they are never offered and no address is offered
+ * twice. The benchmark compares against probes serialized like the old
+ * blocking arpping().
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/select.h>
+#include <arpa/inet.h>
+
+#include "test.h"
+#include "packet.h"
+#include "dhcpd.h"
+#include "leases.h"
+#include "options.h"
+#include "arpping.h"
+#include "serverpacket.h"
+#include "probe.h"
+#include "udhcpd_test.h"
+
+#define NR_STATIONS_MAX	32
+#define NR_OCCUPIED	2
+
+static int to_net[2], from_net[2];
+static u_int32_t occupied[NR_OCCUPIED];
+
+/* occupied hosts answer a probe after 3 ms */
+static void *net_thread(void *arg)
+{
+	u_int32_t addr;
+	int i;
+
+	while (read(to_net[0], &addr, sizeof(addr)) == sizeof(addr)) {
+		for (i = 0; i < NR_OCCUPIED; i++) {
+			if (addr == occupied[i]) {
+				usleep(3000);
+				if (write(from_net[1], &addr, sizeof(addr)) < 0)
+					return NULL;
+			}
+		}
+	}
+	return NULL;
+}
+
+int arpping_open(void)
+{
+	return from_net[0];
+}
+
+void arpping_close(int s)
+{
+}
+
+int arpping_send(int s, u_int32_t yiaddr, u_int32_t ip, unsigned char *mac, u_int16_t seq)
+{
+	return write(to_net[1], &yiaddr, sizeof(yiaddr)) == sizeof(yiaddr) ? 0 : -1;
+}
+
+u_int32_t arpping_recv(int s, unsigned char *mac)
+{
+	u_int32_t addr;
+
+	return read(s, &addr, sizeof(addr)) == sizeof(addr) ? addr : 0;
+}
+
+/* OFFERs are broadcast through raw_packet() */
+static uint64_t start_ns;
+static uint64_t offer_ns[NR_STATIONS_MAX];
+static u_int32_t offer_ip[NR_STATIONS_MAX];
+static int nr_offers;
+
+int raw_packet(struct dhcpMessage *payload, u_int32_t source_ip, int source_port,
+               u_int32_t dest_ip, int dest_port, unsigned char *dest_arp, int ifindex)
+{
+	unsigned char *type = get_option(payload, DHCP_MESSAGE_TYPE);
+	int sta = payload->chaddr[5];
+
+	if (type && type[0] == DHCPOFFER && sta < NR_STATIONS_MAX) {
+		offer_ns[sta] = test_now_ns() - start_ns;
+		offer_ip[sta] = payload->yiaddr;
+		nr_offers++;
+	}
+	return 0;
+}
+
+int kernel_packet(struct dhcpMessage *payload, u_int32_t source_ip, int source_port,
+                  u_int32_t dest_ip, int dest_port)
+{
+	return 0;
+}
+
+void init_header(struct dhcpMessage *packet, char type)
+{
+	memset(packet, 0, sizeof(*packet));
+	packet->op = BOOTREPLY;
+	packet->htype = ETH_10MB;
+	packet->hlen = ETH_10MB_LEN;
+	packet->cookie = htonl(DHCP_MAGIC);
+	packet->options[0] = DHCP_END;
+	add_simple_option(packet->options, DHCP_MESSAGE_TYPE, type);
+}
+
+static void discover(struct dhcpMessage *packet, int sta)
+{
+	memset(packet, 0, sizeof(*packet));
+	packet->op = BOOTREQUEST;
+	packet->xid = sta;
+	packet->cookie = htonl(DHCP_MAGIC);
+	packet->chaddr[0] = 0x02;
+	packet->chaddr[5] = sta;
+	packet->options[0] = DHCP_END;
+	add_simple_option(packet->options, DHCP_MESSAGE_TYPE, DHCPDISCOVER);
+}
+
+/*
+ * The server loop of usr_dhcpd.c with the DISCOVERs of @n stations
+ * queued at once. @serial takes the next DISCOVER only when no probe is
+ * pending, as when arpping() blocked the loop.
+ */
+static void offer_run(int n, int serial, uint64_t *avg_ns, uint64_t *max_ns)
+{
+	struct dhcpMessage packet;
+	struct timeval tv;
+	fd_set rfds;
+	long timeout;
+	int next = 0, i, j;
+
+	udhcpd_test_config(64, 64);
+	TEST_ASSERT_EQ(leases_init(), 0);
+	TEST_ASSERT_EQ(probe_init(), 0);
+	memset(offer_ns, 0, sizeof(offer_ns));
+	nr_offers = 0;
+	start_ns = test_now_ns();
+
+	while (nr_offers < n) {
+		if (next < n && (!serial || probe_timeout() < 0)) {
+			discover(&packet, next++);
+			sendOffer(&packet);
+			continue;
+		}
+		FD_ZERO(&rfds);
+		FD_SET(probe_fd(), &rfds);
+		timeout = probe_timeout();
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		if (select(probe_fd() + 1, &rfds, NULL, NULL, timeout < 0 ? NULL : &tv) > 0)
+			probe_input();
+		probe_expire();
+	}
+	TEST_ASSERT_EQ(nr_offers, n);
+
+	*avg_ns = *max_ns = 0;
+	for (i = 0; i < n; i++) {
+		TEST_ASSERT(offer_ns[i] != 0);
+		for (j = 0; j < NR_OCCUPIED; j++)
+			TEST_ASSERT(offer_ip[i] != occupied[j]);
+		for (j = 0; j < i; j++)
+			TEST_ASSERT(offer_ip[i] != offer_ip[j]);
+		*avg_ns += offer_ns[i];
+		if (offer_ns[i] > *max_ns)
+			*max_ns = offer_ns[i];
+	}
+	*avg_ns /= n;
+
+	probe_deinit();
+	leases_deinit();
+}
+
+static const int nr_stations[] = { 1, 8, NR_STATIONS_MAX };
+#define NR_RUNS	(int)(sizeof(nr_stations) / sizeof(nr_stations[0]))
+
+static void probe_test_offer_latency(void)
+{
+	uint64_t avg, max;
+	int i;
+
+	for (i = 0; i < NR_RUNS; i++) {
+		offer_run(nr_stations[i], 0, &avg, &max);
+		/* one probe round, even for stations that got an occupied address first */
+		TEST_ASSERT(avg >= PROBE_TIME_MS * 1000000ULL);
+		TEST_ASSERT(max < 2 * PROBE_TIME_MS * 1000000ULL);
+	}
+}
+
+static void probe_bench(void)
+{
+	uint64_t avg, max;
+	int i;
+
+	printf("\nOFFER latency, %d occupied addresses\n", NR_OCCUPIED);
+	printf("  stations   overlapped avg/max     serialized avg/max\n");
+	for (i = 0; i < NR_RUNS; i++) {
+		printf("  %8d", nr_stations[i]);
+		offer_run(nr_stations[i], 0, &avg, &max);
+		printf("   %7.1f/%7.1f ms", avg / 1e6, max / 1e6);
+		/* 32 serialized stations take 16 s */
+		if (nr_stations[i] < NR_STATIONS_MAX) {
+			offer_run(nr_stations[i], 1, &avg, &max);
+			printf("   %7.1f/%7.1f ms", avg / 1e6, max / 1e6);
+		}
+		printf("\n");
+	}
+}
+
+void probe_test(void)
+{
+	pthread_t thread;
+
+	TEST_ASSERT_EQ(pipe(to_net), 0);
+	TEST_ASSERT_EQ(pipe(from_net), 0);
+	TEST_ASSERT_EQ(pthread_create(&thread, NULL, net_thread, NULL), 0);
+	occupied[0] = htonl(ntohl(inet_addr(TEST_POOL_START)) + 1);
+	occupied[1] = htonl(ntohl(inet_addr(TEST_POOL_START)) + 4);
+
+	TEST_RUN(probe_test_offer_latency);
+	probe_bench();
+}
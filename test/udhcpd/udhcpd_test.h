@@ -0,0 +1,11 @@
+#ifndef _UDHCPD_TEST_H_
+#define _UDHCPD_TEST_H_
+
+#define TEST_POOL_START	"192.168.51.100"
+
+void udhcpd_test_config(int max_leases, int nr_addrs);
+
+void leases_test(void);
+void probe_test(void);
+
+#endif /* _UDHCPD_TEST_H_ */
@@ -0,0 +1,267 @@
+#!/usr/bin/python
+#
+# Decode a scheduler trace taken by OS_TraceStart()/OS_TraceDump().
+#
+# Input is either the raw trace buffer saved from memory, or a console log
+# containing the "ostrace" lines printed by "thread trace dump".
+#
+#   os_trace_decode.py [-e] [-c trace.json] <log or bin>
+#     -e  print every event
+#     -c  write a Chrome trace (chrome://tracing, ui.perfetto.dev)
+
+import sys
+import struct
+import json
+import getopt
+
+decode_version = "1.0.0"
+
+TRACE_MAGIC = 0x5254534f
+TRACE_VERSION = 1
+
+HDR_FMT = "<IHHIIIIIHH"
+HDR_SIZE = struct.calcsize(HDR_FMT)
+REC_FMT = "<IBBH"
+REC_SIZE = struct.calcsize(REC_FMT)
+TASK_FMT = "<HBB16s"
+
+EV_SWITCH_IN = 1
+EV_READY = 2
+EV_ISR_ENTER = 3
+EV_ISR_EXIT = 4
+EV_MARK = 5
+EV_NAME = {EV_SWITCH_IN: "switch", EV_READY: "ready",
+           EV_ISR_ENTER: "isr+", EV_ISR_EXIT: "isr-", EV_MARK: "mark"}
+
+F_SCHED = 1 << 0
+F_ISR = 1 << 1
+
+
+def usage():
+    print("os_trace_decode.py " + decode_version)
+    print("usage: os_trace_decode.py [-e] [-c trace.json] <log or bin>")
+    sys.exit(1)
+
+
+def load(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) >= 4 and struct.unpack("<I", data[:4])[0] == TRACE_MAGIC:
+        return data
+
+    # console log, other output interleaved with the dump is skipped
+    buf = bytearray()
+    size = None
+    for line in data.decode("latin-1").splitlines():
+        pos = line.find("ostrace ")
+        if pos < 0:
+            continue
+        words = line[pos:].split()
+        if len(words) < 3:
+            continue
+        if words[1] == "begin":
+            buf = bytearray()
+            size = int(words[2])
+        elif words[1] == "end":
+            break
+        elif size is not None:
+            off = int(words[1], 16)
+            if off != len(buf):
+                sys.exit("ostrace: line at 0x%x missing" % len(buf))
+            buf += bytearray.fromhex(words[2])
+    if size is None or len(buf) != size:
+        sys.exit("%s: no complete trace found" % path)
+    return bytes(buf)
+
+
+def parse(data):
+    if len(data) < HDR_SIZE:
+        sys.exit("trace too short")
+    (magic, version, flags, clock_hz, rec_off, rec_cnt, head,
+     task_off, task_cnt, task_size) = struct.unpack(HDR_FMT, data[:HDR_SIZE])
+    if magic != TRACE_MAGIC or version != TRACE_VERSION:
+        sys.exit("bad trace header, magic 0x%08x version %d" % (magic, version))
+    if rec_off + rec_cnt * REC_SIZE > len(data):
+        sys.exit("trace truncated")
+
+    tasks = {}
+    for i in range(task_cnt):
+        off = task_off + i * task_size
+        num, prio, _, name = struct.unpack(TASK_FMT, data[off:off + 20])
+        if num:
+            name = name.split(b"\0")[0].decode("latin-1")
+            tasks[num] = (name, prio)
+
+    # The head counts records modulo 2^32, so after it wraps it can be below
+    # rec_cnt with the ring full. The ring starts zeroed: any record after
+    # the head means it has been filled once already.
+    count = rec_cnt
+    if head < rec_cnt:
+        count = head
+        for idx in range(head, rec_cnt):
+            if data[rec_off + idx * REC_SIZE + 4] != 0:
+                count = rec_cnt
+                break
+
+    # oldest record first, records claimed but not completed have type 0
+    recs = []
+    for idx in range(head - count, head):
+        off = rec_off + (idx % rec_cnt) * REC_SIZE
+        ts, typ, prio, arg = struct.unpack(REC_FMT, data[off:off + REC_SIZE])
+        if typ:
+            recs.append((ts, typ, prio, arg))
+
+    # the time stamp wraps, unwrap it relative to the first record
+    events = []
+    base = 0
+    last = None
+    for ts, typ, prio, arg in recs:
+        if last is not None and ts < last and last - ts > 0x80000000:
+            base += 1 << 32
+        last = ts
+        events.append((base + ts, typ, prio, arg))
+    # writers may be interrupted between the time stamp and the slot
+    events.sort(key=lambda e: e[0])
+
+    hdr = {"flags": flags, "clock_hz": clock_hz, "rec_cnt": rec_cnt,
+           "head": head, "lost": (head - count) % (1 << 32)}
+    return hdr, tasks, events
+
+
+def task_name(tasks, num):
+    if num in tasks:
+        return tasks[num][0]
+    return "task%d" % num
+
+
+def us(hdr, ticks):
+    return ticks * 1000000.0 / hdr["clock_hz"]
+
+
+def print_events(hdr, tasks, events):
+    t0 = events[0][0]
+    for ts, typ, prio, arg in events:
+        if typ in (EV_SWITCH_IN, EV_READY):
+            what = "%-16s prio %d" % (task_name(tasks, arg), prio)
+        elif typ in (EV_ISR_ENTER, EV_ISR_EXIT):
+            what = "exc %d" % arg
+        else:
+            what = "id %d" % arg
+        print("%12.1f  %-6s %s" % (us(hdr, ts - t0), EV_NAME.get(typ, "?"), what))
+
+
+def summary(hdr, tasks, events):
+    t0 = events[0][0]
+    t1 = events[-1][0]
+    run = {}
+    switches = {}
+    lat = {}
+    ready = {}
+    isr = {}
+    isr_at = {}
+    cur = None
+    cur_at = t0
+
+    for ts, typ, prio, arg in events:
+        if typ == EV_SWITCH_IN:
+            if cur is not None:
+                run[cur] = run.get(cur, 0) + ts - cur_at
+            cur = arg
+            cur_at = ts
+            switches[arg] = switches.get(arg, 0) + 1
+            if arg in ready:
+                lat.setdefault(arg, []).append(ts - ready.pop(arg))
+        elif typ == EV_READY:
+            if arg not in ready:
+                ready[arg] = ts
+        elif typ == EV_ISR_ENTER:
+            isr_at[arg] = ts
+        elif typ == EV_ISR_EXIT and arg in isr_at:
+            n, total, worst = isr.get(arg, (0, 0, 0))
+            d = ts - isr_at.pop(arg)
+            isr[arg] = (n + 1, total + d, max(worst, d))
+    if cur is not None:
+        run[cur] = run.get(cur, 0) + t1 - cur_at
+
+    span = max(t1 - t0, 1)
+    print("window %.1f ms, %d events, %d lost to wrap" %
+          (us(hdr, span) / 1000, len(events), hdr["lost"]))
+
+    if hdr["flags"] & F_SCHED:
+        print("\n%-16s %4s %8s %6s %10s %10s %10s" %
+              ("task", "prio", "switches", "cpu%", "run(us)", "lat avg", "lat max"))
+        for num in sorted(run, key=lambda n: run[n], reverse=True):
+            l = lat.get(num, [])
+            lat_avg = us(hdr, sum(l) / float(len(l))) if l else 0
+            lat_max = us(hdr, max(l)) if l else 0
+            prio = tasks[num][1] if num in tasks else 0
+            print("%-16s %4d %8d %6.1f %10.0f %10.1f %10.1f" %
+                  (task_name(tasks, num), prio, switches.get(num, 0),
+                   run[num] * 100.0 / span, us(hdr, run[num]), lat_avg, lat_max))
+
+    if isr:
+        print("\n%-6s %8s %10s %10s" % ("exc", "count", "avg(us)", "max(us)"))
+        for exc in sorted(isr):
+            n, total, worst = isr[exc]
+            print("%-6d %8d %10.1f %10.1f" %
+                  (exc, n, us(hdr, total / float(n)), us(hdr, worst)))
+
+
+def chrome(hdr, tasks, events, path):
+    t0 = events[0][0]
+    out = []
+    cur = None
+    for ts, typ, prio, arg in events:
+        t = us(hdr, ts - t0)
+        if typ == EV_SWITCH_IN:
+            if cur is not None:
+                out.append({"name": task_name(tasks, cur), "ph": "E",
+                            "pid": 0, "tid": 0, "ts": t})
+            out.append({"name": task_name(tasks, arg), "ph": "B",
+                        "pid": 0, "tid": 0, "ts": t, "args": {"prio": prio}})
+            cur = arg
+        elif typ == EV_READY:
+            out.append({"name": "ready " + task_name(tasks, arg), "ph": "i",
+                        "s": "t", "pid": 0, "tid": 0, "ts": t})
+        elif typ == EV_ISR_ENTER:
+            out.append({"name": "exc %d" % arg, "ph": "B",
+                        "pid": 0, "tid": 1, "ts": t})
+        elif typ == EV_ISR_EXIT:
+            out.append({"name": "exc %d" % arg, "ph": "E",
+                        "pid": 0, "tid": 1, "ts": t})
+        elif typ == EV_MARK:
+            out.append({"name": "mark %d" % arg, "ph": "i", "s": "g",
+                        "pid": 0, "tid": 0, "ts": t})
+    out.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": 0,
+                "args": {"name": "threads"}})
+    out.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": 1,
+                "args": {"name": "interrupts"}})
+    with open(path, "w") as f:
+        json.dump({"traceEvents": out, "displayTimeUnit": "ms"}, f)
+
+
+def main():
+    try:
+        opts, args = getopt.getopt(sys.argv[1:], "ec:")
+    except getopt.GetoptError:
+        usage()
+    if len(args) != 1:
+        usage()
+
+    hdr, tasks, events = parse(load(args[0]))
+    if not events:
+        sys.exit("trace is empty")
+
+    for opt, val in opts:
+        if opt == "-e":
+            print_events(hdr, tasks, events)
+            print("")
+    summary(hdr, tasks, events)
+    for opt, val in opts:
+        if opt == "-c":
+            chrome(hdr, tasks, events, val)
+            print("\nchrome trace written to " + val)
+
+
+if __name__ == "__main__":
+    main()